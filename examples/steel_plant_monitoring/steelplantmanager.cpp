@@ -11,33 +11,35 @@ HYSteelPlantManager::HYSteelPlantManager(QObject *parent) : QObject(parent)
     m_tagManager = new HYTagManager(this);
     m_chartDataModel = new HYChartDataModel(this);
     m_simulatedDataSource = new HYSimulatedDataSource(this);
+    m_alarmManager = new HYAlarmManager(m_tagManager, this);
     m_updateTimer = new QTimer(this);
-    m_alarmCheckTimer = new QTimer(this);
     
     m_emergencyAlarmCount = 0;
     m_normalAlarmCount = 0;
     
     // 连接信号和槽
     connect(m_updateTimer, &QTimer::timeout, this, &HYSteelPlantManager::updatePlantStatus);
-    connect(m_alarmCheckTimer, &QTimer::timeout, this, &HYSteelPlantManager::checkAlarms);
+    // 告警在点位变化时由告警管理器判断，不再定时轮询
+    connect(m_alarmManager, &HYAlarmManager::alarmActivated, this, &HYSteelPlantManager::onAlarmActivated);
 }
 
 HYSteelPlantManager::~HYSteelPlantManager()
 {
-    // 清理资源
+    // 清理资源，告警管理器先于点位管理器删除
+    delete m_alarmManager;
     delete m_tagManager;
     delete m_chartDataModel;
     delete m_simulatedDataSource;
     delete m_updateTimer;
-    delete m_alarmCheckTimer;
 }
 
 void HYSteelPlantManager::initialize()
 {
     qDebug() << "初始化华颜钢铁厂监控平台...";
     
-    // 初始化标签
+    // 初始化标签和告警
     initializeTags();
+    initializeAlarms();
     
     // 初始化模拟数据源
     m_simulatedDataSource->initialize();
@@ -67,7 +69,6 @@ void HYSteelPlantManager::startSimulation()
     
     // 启动定时器
     m_updateTimer->start(1000); // 1秒更新一次
-    m_alarmCheckTimer->start(2000); // 2秒检查一次告警
     
     qDebug() << "模拟已开始";
 }
@@ -78,7 +79,6 @@ void HYSteelPlantManager::stopSimulation()
     
     // 停止定时器
     m_updateTimer->stop();
-    m_alarmCheckTimer->stop();
     
     qDebug() << "模拟已停止";
 }
@@ -99,8 +99,9 @@ void HYSteelPlantManager::toggleDevice(const QString &deviceId, bool status)
         emit rollingMillStatusChanged();
     }
     
-    // 更新标签值
-    m_tagManager->updateTagValue(deviceId + ".status", status);
+    // 更新标签值，停机的设备不报告警
+    m_tagManager->setTagValue(deviceId + ".status", status);
+    setDeviceAlarmsEnabled(deviceId, status);
     
     qDebug() << "设备状态已切换";
 }
@@ -144,7 +145,8 @@ void HYSteelPlantManager::acknowledgeAlarm(const QString &alarmId)
 {
     qDebug() << "确认告警:" << alarmId;
     
-    // 从告警历史中移除
+    // 在告警表中确认，并从告警历史中移除
+    m_alarmManager->acknowledge(alarmId);
     if (m_alarmHistory.contains(alarmId)) {
         m_alarmHistory.remove(alarmId);
         
@@ -230,17 +232,17 @@ void HYSteelPlantManager::updatePlantStatus()
     }
     
     // 更新标签值
-    m_tagManager->updateTagValue("blastFurnace.temperature", m_blastFurnaceStatus["temperature"]);
-    m_tagManager->updateTagValue("blastFurnace.pressure", m_blastFurnaceStatus["pressure"]);
-    m_tagManager->updateTagValue("blastFurnace.level", m_blastFurnaceStatus["level"]);
+    m_tagManager->setTagValue("blastFurnace.temperature", m_blastFurnaceStatus["temperature"]);
+    m_tagManager->setTagValue("blastFurnace.pressure", m_blastFurnaceStatus["pressure"]);
+    m_tagManager->setTagValue("blastFurnace.level", m_blastFurnaceStatus["level"]);
     
-    m_tagManager->updateTagValue("converter.temperature", m_converterStatus["temperature"]);
-    m_tagManager->updateTagValue("converter.oxygenFlow", m_converterStatus["oxygenFlow"]);
-    m_tagManager->updateTagValue("converter.steelLevel", m_converterStatus["steelLevel"]);
+    m_tagManager->setTagValue("converter.temperature", m_converterStatus["temperature"]);
+    m_tagManager->setTagValue("converter.oxygenFlow", m_converterStatus["oxygenFlow"]);
+    m_tagManager->setTagValue("converter.steelLevel", m_converterStatus["steelLevel"]);
     
-    m_tagManager->updateTagValue("rollingMill.speed", m_rollingMillStatus["speed"]);
-    m_tagManager->updateTagValue("rollingMill.temperature", m_rollingMillStatus["temperature"]);
-    m_tagManager->updateTagValue("rollingMill.coolingWaterFlow", m_rollingMillStatus["coolingWaterFlow"]);
+    m_tagManager->setTagValue("rollingMill.speed", m_rollingMillStatus["speed"]);
+    m_tagManager->setTagValue("rollingMill.temperature", m_rollingMillStatus["temperature"]);
+    m_tagManager->setTagValue("rollingMill.coolingWaterFlow", m_rollingMillStatus["coolingWaterFlow"]);
     
     // 添加图表数据
     QDateTime now = QDateTime::currentDateTime();
@@ -262,36 +264,9 @@ void HYSteelPlantManager::updatePlantStatus()
     emit flowDataChanged();
 }
 
-void HYSteelPlantManager::checkAlarms()
+void HYSteelPlantManager::onAlarmActivated(const QString &alarmId, const QString &message, int severity)
 {
-    // 检查高炉告警
-    if (m_blastFurnaceStatus["status"].toBool()) {
-        if (m_blastFurnaceStatus["temperature"].toDouble() > 1600.0) {
-            triggerAlarm("emergency.blastFurnace.temperature", "高炉温度过高！", true);
-        } else if (m_blastFurnaceStatus["pressure"].toDouble() > 3.0) {
-            triggerAlarm("emergency.blastFurnace.pressure", "高炉压力过高！", true);
-        } else if (m_blastFurnaceStatus["level"].toDouble() < 30.0) {
-            triggerAlarm("normal.blastFurnace.level", "高炉料位过低", false);
-        }
-    }
-    
-    // 检查转炉告警
-    if (m_converterStatus["status"].toBool()) {
-        if (m_converterStatus["temperature"].toDouble() > 1700.0) {
-            triggerAlarm("emergency.converter.temperature", "转炉温度过高！", true);
-        } else if (m_converterStatus["oxygenFlow"].toDouble() < 50.0) {
-            triggerAlarm("normal.converter.oxygenFlow", "转炉氧气流量过低", false);
-        }
-    }
-    
-    // 检查轧钢告警
-    if (m_rollingMillStatus["status"].toBool()) {
-        if (m_rollingMillStatus["temperature"].toDouble() > 1500.0) {
-            triggerAlarm("emergency.rollingMill.temperature", "轧钢温度过高！", true);
-        } else if (m_rollingMillStatus["coolingWaterFlow"].toDouble() < 60.0) {
-            triggerAlarm("normal.rollingMill.coolingWaterFlow", "轧钢冷却水流量过低", false);
-        }
-    }
+    triggerAlarm(alarmId, message, severity >= EmergencySeverity);
 }
 
 void HYSteelPlantManager::initializeTags()
@@ -319,6 +294,51 @@ void HYSteelPlantManager::initializeTags()
     qDebug() << "标签初始化完成";
 }
 
+void HYSteelPlantManager::initializeAlarms()
+{
+    qDebug() << "初始化告警...";
+    
+    struct AlarmLimit {
+        const char *alarmId;
+        const char *tagName;
+        HYAlarmDefinition::Type type;
+        double limit;
+        double deadband;
+        const char *message;
+    };
+    
+    // 告警编号沿用原来的命名，emergency开头的为紧急告警
+    const AlarmLimit limits[] = {
+        {"emergency.blastFurnace.temperature", "blastFurnace.temperature", HYAlarmDefinition::HighHigh, 1600.0, 10.0, "高炉温度过高！"},
+        {"emergency.blastFurnace.pressure", "blastFurnace.pressure", HYAlarmDefinition::HighHigh, 3.0, 0.05, "高炉压力过高！"},
+        {"normal.blastFurnace.level", "blastFurnace.level", HYAlarmDefinition::Low, 30.0, 1.0, "高炉料位过低"},
+        {"emergency.converter.temperature", "converter.temperature", HYAlarmDefinition::HighHigh, 1700.0, 10.0, "转炉温度过高！"},
+        {"normal.converter.oxygenFlow", "converter.oxygenFlow", HYAlarmDefinition::Low, 50.0, 1.0, "转炉氧气流量过低"},
+        {"emergency.rollingMill.temperature", "rollingMill.temperature", HYAlarmDefinition::HighHigh, 1500.0, 10.0, "轧钢温度过高！"},
+        {"normal.rollingMill.coolingWaterFlow", "rollingMill.coolingWaterFlow", HYAlarmDefinition::Low, 60.0, 1.0, "轧钢冷却水流量过低"}
+    };
+    
+    for (const AlarmLimit &limit : limits) {
+        HYAlarmDefinition definition;
+        definition.name = limit.alarmId;
+        definition.tagName = limit.tagName;
+        definition.type = limit.type;
+        definition.limit = limit.limit;
+        definition.deadband = limit.deadband;
+        definition.severity = QString(limit.alarmId).startsWith("emergency") ? EmergencySeverity : 500;
+        definition.message = QString::fromUtf8(limit.message);
+        
+        QString error;
+        if (!m_alarmManager->addAlarm(definition, &error)) {
+            qDebug() << "添加告警失败:" << error;
+            continue;
+        }
+        m_deviceAlarms.insert(definition.tagName.section('.', 0, 0), definition.name);
+    }
+    
+    qDebug() << "告警初始化完成";
+}
+
 void HYSteelPlantManager::updateChartData()
 {
     // 更新图表数据
@@ -332,6 +352,18 @@ void HYSteelPlantManager::updateChartData()
     emit flowDataChanged();
 }
 
+void HYSteelPlantManager::setDeviceAlarmsEnabled(const QString &deviceId, bool enabled)
+{
+    // Shelved alarms keep being evaluated; one still active is announced again when the device restarts
+    for (auto it = m_deviceAlarms.constFind(deviceId); it != m_deviceAlarms.cend() && it.key() == deviceId; ++it) {
+        if (enabled) {
+            m_alarmManager->unshelve(it.value());
+        } else {
+            m_alarmManager->shelve(it.value());
+        }
+    }
+}
+
 void HYSteelPlantManager::triggerAlarm(const QString &alarmId, const QString &message, bool isEmergency)
 {
     // 检查告警是否已经存在
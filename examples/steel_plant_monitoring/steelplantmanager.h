@@ -5,11 +5,13 @@
 #include <QTimer>
 #include <QDateTime>
 #include <QMap>
+#include <QHash>
 #include <QVector>
 
 // 包含Huayan核心头文件
 #include "core/hy_tagmanager.h"
 #include "core/hy_chartdatamodel.h"
+#include "core/alarmmanager.h"
 
 // 前置声明
 class HYSimulatedDataSource;
@@ -35,6 +37,8 @@ class HYSteelPlantManager : public QObject
     Q_PROPERTY(int normalAlarmCount READ normalAlarmCount NOTIFY normalAlarmCountChanged)
 
 public:
+    static constexpr int EmergencySeverity = 800; ///< 紧急告警的严重程度
+
     explicit HYSteelPlantManager(QObject *parent = nullptr);
     ~HYSteelPlantManager();
 
@@ -71,15 +75,15 @@ signals:
 private slots:
     // 槽函数
     void updatePlantStatus();
-    void checkAlarms();
+    void onAlarmActivated(const QString &alarmId, const QString &message, int severity);
 
 private:
     // 私有成员
     HYTagManager *m_tagManager;
     HYChartDataModel *m_chartDataModel;
     HYSimulatedDataSource *m_simulatedDataSource;
+    HYAlarmManager *m_alarmManager;
     QTimer *m_updateTimer;
-    QTimer *m_alarmCheckTimer;
     
     // 设备状态
     QMap<QString, QVariant> m_blastFurnaceStatus;
@@ -98,10 +102,15 @@ private:
     // 告警历史
     QMap<QString, QDateTime> m_alarmHistory;
     
+    // 各设备的告警，设备停机时搁置
+    QMultiHash<QString, QString> m_deviceAlarms;
+    
     // 方法
     void initializeTags();
+    void initializeAlarms();
     void updateChartData();
     void triggerAlarm(const QString &alarmId, const QString &message, bool isEmergency);
+    void setDeviceAlarmsEnabled(const QString &deviceId, bool enabled);
 };
 
 #endif // HYSTEELPLANTMANAGER_H
@@ -11,7 +11,9 @@ QMap<QString, std::function<DataSource*(HYTagManager*, QObject*)>> DataSourceFac
  */
 DataSource::DataSource(HYTagManager *tagManager, QObject *parent)
     : QObject(parent),
-      m_tagManager(tagManager)
+      m_tagManager(tagManager),
+      m_ingestQueue(nullptr),
+      m_ingestSource(-1)
 {
 }
 
@@ -22,6 +24,20 @@ DataSource::~DataSource()
 {
 }
 
+/**
+ * @brief 设置点位采集队列
+ * @param queue 采集队列，为空时恢复直接写入点位管理器
+ */
+void DataSource::setIngestQueue(HYTagIngestQueue *queue)
+{
+    m_ingestQueue = queue;
+    m_ingestSource = queue ? queue->registerSource(name()) : -1;
+    if (queue && m_ingestSource < 0) {
+        qWarning() << "采集队列数据源已满，改为直接写入:" << name();
+        m_ingestQueue = nullptr;
+    }
+}
+
 /**
  * @brief 创建数据源实例
  * @param type 数据源类型
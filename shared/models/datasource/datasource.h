@@ -7,6 +7,7 @@
 #include <QMap>
 
 #include "../core/tagmanager.h"
+#include "../core/tagingestqueue.h"
 
 /**
  * @class DataSource
@@ -97,6 +98,15 @@ public:
      */
     virtual QString name() const = 0;
 
+    // 点位采集
+    /**
+     * @brief 设置点位采集队列
+     *
+     * 设置后点位更新推入队列，由队列的应用线程批量写入点位管理器，回调不再等待点位管理器的锁
+     * @param queue 采集队列，为空时恢复直接写入点位管理器
+     */
+    void setIngestQueue(HYTagIngestQueue *queue);
+
 signals:
     /**
      * @brief 连接状态变化信号
@@ -113,6 +123,8 @@ signals:
 
 protected:
     HYTagManager *m_tagManager; ///< 点位管理器指针
+    HYTagIngestQueue *m_ingestQueue; ///< 点位采集队列，为空时直接写入点位管理器
+    int m_ingestSource; ///< 在采集队列中的数据源编号
 };
 
 /**
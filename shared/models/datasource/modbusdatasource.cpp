@@ -263,6 +263,7 @@ bool ModbusDataSource::bindRegisterToTag(QModbusDataUnit::RegisterType registerT
     QPair<QModbusDataUnit::RegisterType, quint16> key(registerType, address);
     RegisterBinding binding;
     binding.tagName = tagName;
+    binding.tagId = m_tagManager->resolveTag(tagName);
     binding.samplingInterval = samplingInterval;
     m_registerBindings[key] = binding;
 
@@ -397,6 +398,11 @@ void ModbusDataSource::onConnectionStateChanged(QModbusDevice::State state)
         m_syncTimer->start();
     } else {
         m_syncTimer->stop();
+
+        // 断开期间点位保留最后的值，但标记为未连接
+        for (const RegisterBinding &binding : std::as_const(m_registerBindings)) {
+            m_tagManager->setQuality(binding.tagId, HYTagValueStore::QualityNotConnected);
+        }
     }
 }
 
@@ -414,7 +420,11 @@ void ModbusDataSource::onReadFinished(QModbusReply *reply)
         // 检查是否有绑定
         QPair<QModbusDataUnit::RegisterType, quint16> key(registerType, address);
         if (m_registerBindings.contains(key)) {
-            const RegisterBinding &binding = m_registerBindings[key];
+            RegisterBinding &binding = m_registerBindings[key];
+            if (binding.tagId == HYTagManager::InvalidTagId) {
+                // The tag may have been defined after the register was bound
+                binding.tagId = m_tagManager->resolveTag(binding.tagName);
+            }
             
             // 获取值
             QVariant value;
@@ -424,12 +434,24 @@ void ModbusDataSource::onReadFinished(QModbusReply *reply)
                 value = unit.value(0);
             }
             
-            // 更新Huayan点位值
-            m_tagManager->setTagValue(binding.tagName, value);
+            // 更新Huayan点位值，设置了采集队列时只入队，不等待点位管理器的锁
+            if (m_ingestQueue) {
+                m_ingestQueue->publish(m_ingestSource, binding.tagId, value);
+            } else {
+                m_tagManager->setTagValue(binding.tagName, value);
+            }
             
             // 发出数据更新信号
             emit dataUpdated(binding.tagName, value);
         }
+    } else {
+        // 读取失败时保留最后的值，标记为通信故障
+        const QModbusDataUnit unit = reply->result();
+        QPair<QModbusDataUnit::RegisterType, quint16> key(unit.registerType(), quint16(unit.startAddress()));
+        auto it = m_registerBindings.constFind(key);
+        if (it != m_registerBindings.constEnd()) {
+            m_tagManager->setQuality(it->tagId, HYTagValueStore::QualityCommFailure);
+        }
     }
 
     delete reply;
@@ -202,6 +202,7 @@ private:
     // 寄存器绑定映射
     struct RegisterBinding {
         QString tagName; ///< 点位名称
+        HYTagManager::TagId tagId; ///< 点位句柄，绑定时解析，点位尚未定义时在收到值时重新解析
         int samplingInterval; ///< 采样间隔
     };
     QMap<QPair<QModbusDataUnit::RegisterType, quint16>, RegisterBinding> m_registerBindings; ///< 寄存器绑定映射表
@@ -17,6 +17,8 @@
 MqttDataSource::MqttDataSource(HYTagManager *tagManager, QObject *parent) 
     : QObject(parent),
       m_tagManager(tagManager),
+      m_ingestQueue(nullptr),
+      m_ingestSource(-1),
       m_client(nullptr),
       m_syncTimer(new QTimer(this))
 {
@@ -148,6 +150,7 @@ bool MqttDataSource::bindTopicToTag(const QString &topic, const QString &tagName
     // 添加到绑定映射
     TopicBinding binding;
     binding.tagName = tagName;
+    binding.tagId = m_tagManager->resolveTag(tagName);
     binding.qos = qos;
     m_topicBindings[topic] = binding;
 
@@ -184,6 +187,17 @@ bool MqttDataSource::unbindTopicFromTag(const QString &topic)
 #endif
 }
 
+void MqttDataSource::setIngestQueue(HYTagIngestQueue *queue)
+{
+    QMutexLocker locker(&m_mutex);
+
+    m_ingestQueue = queue;
+    m_ingestSource = queue ? queue->registerSource("MQTT") : -1;
+    if (m_ingestSource < 0) {
+        m_ingestQueue = nullptr;
+    }
+}
+
 bool MqttDataSource::publishMessage(const QString &topic, const QByteArray &payload, quint8 qos, bool retain)
 {
 #ifdef HAVE_MQTT
@@ -222,6 +236,11 @@ void MqttDataSource::onConnectionStateChanged(int state)
         m_syncTimer->start();
     } else {
         m_syncTimer->stop();
+
+        // 断开期间点位保留最后的值，但标记为未连接
+        for (const TopicBinding &binding : std::as_const(m_topicBindings)) {
+            m_tagManager->setQuality(binding.tagId, HYTagValueStore::QualityNotConnected);
+        }
     }
 #else
     Q_UNUSED(state)
@@ -235,7 +254,11 @@ void MqttDataSource::onMessageReceived(const QByteArray &message, const QString
 
     // 检查是否有绑定
     if (m_topicBindings.contains(topic)) {
-        const TopicBinding &binding = m_topicBindings[topic];
+        TopicBinding &binding = m_topicBindings[topic];
+        if (binding.tagId == HYTagManager::InvalidTagId) {
+            // The tag may have been defined after the topic was bound
+            binding.tagId = m_tagManager->resolveTag(binding.tagName);
+        }
         
         // 解析负载为QVariant
         QVariant value;
@@ -255,8 +278,12 @@ void MqttDataSource::onMessageReceived(const QByteArray &message, const QString
             }
         }
         
-        // 更新Huayan点位值
-        m_tagManager->setTagValue(binding.tagName, value);
+        // 更新Huayan点位值，设置了采集队列时只入队，不等待点位管理器的锁
+        if (m_ingestQueue) {
+            m_ingestQueue->publish(m_ingestSource, binding.tagId, value);
+        } else {
+            m_tagManager->setTagValue(binding.tagName, value);
+        }
         
         // 发出数据更新信号
         emit dataUpdated(binding.tagName, value);
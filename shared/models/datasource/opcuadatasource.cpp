@@ -14,11 +14,14 @@
 #include <QOpcUaValue>
 #include <QOpcUaMonitoringParameters>
 #include <QThread>
+#include <QDateTime>
 #endif
 
 OpcUaDataSource::OpcUaDataSource(HYTagManager *tagManager, QObject *parent) 
     : QObject(parent),
       m_tagManager(tagManager),
+      m_ingestQueue(nullptr),
+      m_ingestSource(-1),
       m_client(nullptr),
       m_syncTimer(new QTimer(this))
 {
@@ -153,6 +156,7 @@ bool OpcUaDataSource::bindNodeToTag(const QString &nodeId, const QString &tagNam
     // 添加到绑定映射
     NodeBinding binding;
     binding.tagName = tagName;
+    binding.tagId = m_tagManager->resolveTag(tagName);
     binding.samplingInterval = samplingInterval;
     binding.node = node;
     m_nodeBindings[nodeId] = binding;
@@ -192,6 +196,17 @@ bool OpcUaDataSource::unbindNodeFromTag(const QString &nodeId)
 #endif
 }
 
+void OpcUaDataSource::setIngestQueue(HYTagIngestQueue *queue)
+{
+    QMutexLocker locker(&m_mutex);
+
+    m_ingestQueue = queue;
+    m_ingestSource = queue ? queue->registerSource("OPC UA") : -1;
+    if (m_ingestSource < 0) {
+        m_ingestQueue = nullptr;
+    }
+}
+
 QVariant OpcUaDataSource::readNodeValue(const QString &nodeId)
 {
 #ifdef HAVE_OPCUA
@@ -255,6 +270,11 @@ void OpcUaDataSource::onConnectionStateChanged(int state)
         m_syncTimer->start();
     } else {
         m_syncTimer->stop();
+
+        // 断开期间点位保留最后的值，但标记为未连接
+        for (const NodeBinding &binding : std::as_const(m_nodeBindings)) {
+            m_tagManager->setQuality(binding.tagId, HYTagValueStore::QualityNotConnected);
+        }
     }
 #else
     Q_UNUSED(state)
@@ -272,10 +292,27 @@ void OpcUaDataSource::onAttributeChanged(const QString &nodeId, int attribute, c
 
     // 检查是否有绑定
     if (m_nodeBindings.contains(nodeId)) {
-        const NodeBinding &binding = m_nodeBindings[nodeId];
-        
-        // 更新Huayan点位值
-        m_tagManager->setTagValue(binding.tagName, value);
+        NodeBinding &binding = m_nodeBindings[nodeId];
+        QOpcUaNode *node = static_cast<QOpcUaNode*>(binding.node);
+        if (binding.tagId == HYTagManager::InvalidTagId) {
+            // The tag may have been defined after the node was bound
+            binding.tagId = m_tagManager->resolveTag(binding.tagName);
+        }
+
+        // 服务器给出的状态码和源时间戳随值一起保存
+        const quint8 quality = node ? HYTagValueStore::qualityFromStatusCode(
+                                          quint32(node->attributeError(QOpcUa::NodeAttribute::Value)))
+                                    : quint8(HYTagValueStore::QualityGood);
+        const QDateTime sourceTime = node ? node->sourceTimestamp(QOpcUa::NodeAttribute::Value) : QDateTime();
+        const qint64 sourceTimestamp = sourceTime.isValid() ? sourceTime.toMSecsSinceEpoch()
+                                                            : QDateTime::currentMSecsSinceEpoch();
+
+        // 更新Huayan点位值，设置了采集队列时只入队，不等待点位管理器的锁
+        if (m_ingestQueue) {
+            m_ingestQueue->publish(m_ingestSource, binding.tagId, value, quality, sourceTimestamp);
+        } else {
+            m_tagManager->setValue(binding.tagId, value, sourceTimestamp, quality);
+        }
         
         // 发出数据更新信号
         emit dataUpdated(binding.tagName, value);
@@ -298,14 +335,29 @@ void OpcUaDataSource::syncData()
 
     // 同步所有绑定的节点数据
     for (const QString &nodeId : m_nodeBindings.keys()) {
-        const NodeBinding &binding = m_nodeBindings[nodeId];
+        NodeBinding &binding = m_nodeBindings[nodeId];
+        if (binding.tagId == HYTagManager::InvalidTagId) {
+            // The tag may have been defined after the node was bound
+            binding.tagId = m_tagManager->resolveTag(binding.tagName);
+        }
         
         if (binding.node) {
             // 读取节点值
-            QOpcUaValue value = static_cast<QOpcUaNode*>(binding.node)->attribute(QOpcUa::NodeAttribute::Value);
+            QOpcUaNode *node = static_cast<QOpcUaNode*>(binding.node);
+            QOpcUaValue value = node->attribute(QOpcUa::NodeAttribute::Value);
             if (value.isValid()) {
+                const quint8 quality = HYTagValueStore::qualityFromStatusCode(
+                    quint32(node->attributeError(QOpcUa::NodeAttribute::Value)));
+                const QDateTime sourceTime = node->sourceTimestamp(QOpcUa::NodeAttribute::Value);
+                const qint64 sourceTimestamp = sourceTime.isValid() ? sourceTime.toMSecsSinceEpoch()
+                                                                    : QDateTime::currentMSecsSinceEpoch();
+
                 // 更新Huayan点位值
-                m_tagManager->setTagValue(binding.tagName, value.value());
+                if (m_ingestQueue) {
+                    m_ingestQueue->publish(m_ingestSource, binding.tagId, value.value(), quality, sourceTimestamp);
+                } else {
+                    m_tagManager->setValue(binding.tagId, value.value(), sourceTimestamp, quality);
+                }
                 
                 // 发出数据更新信号
                 emit dataUpdated(binding.tagName, value.value());
@@ -5,6 +5,7 @@
 #include <QTimer>
 #include <QMutex>
 #include "../core/tagmanager.h"
+#include "../core/tagingestqueue.h"
 
 // Conditionally include OpcUa headers if available
 #ifdef HAVE_OPCUA
@@ -76,6 +77,15 @@ public:
      */
     bool unbindNodeFromTag(const QString &nodeId);
 
+    // 点位采集
+    /**
+     * @brief 设置点位采集队列
+     *
+     * 设置后点位更新推入队列，由队列的应用线程批量写入点位管理器，回调不再等待点位管理器的锁
+     * @param queue 采集队列，为空时恢复直接写入点位管理器
+     */
+    void setIngestQueue(HYTagIngestQueue *queue);
+
     // 数据操作
     /**
      * @brief 读取OPC UA节点值
@@ -128,6 +138,8 @@ private slots:
 
 private:
     HYTagManager *m_tagManager; ///< 点位管理器指针
+    HYTagIngestQueue *m_ingestQueue; ///< 点位采集队列，为空时直接写入点位管理器
+    int m_ingestSource; ///< 在采集队列中的数据源编号
     void *m_client; ///< OPC UA客户端
     QTimer *m_syncTimer; ///< 同步定时器
     QMutex m_mutex; ///< 互斥锁
@@ -135,6 +147,7 @@ private:
     // 节点绑定映射
     struct NodeBinding {
         QString tagName; ///< 点位名称
+        HYTagManager::TagId tagId; ///< 点位句柄，绑定时解析，点位尚未定义时在收到值时重新解析
         int samplingInterval; ///< 采样间隔
         void *node; ///< OPC UA节点
     };
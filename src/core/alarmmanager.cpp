@@ -0,0 +1,493 @@
+#include "alarmmanager.h"
+#include <QDateTime>
+#include <QThread>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+/**
+ * @file alarmmanager.cpp
+ * @brief 告警管理器实现
+ */
+
+HYAlarmManager::HYAlarmManager(HYTagManager *tagManager, QObject *parent) : QObject(parent),
+    m_tagManager(tagManager),
+    m_subscriber(-1),
+    m_timerDue(0),
+    m_timer(nullptr)
+{
+    m_timer = new QTimer(this);
+    m_timer->setSingleShot(true);
+    connect(m_timer, &QTimer::timeout, this, &HYAlarmManager::onTimer);
+
+    if (tagManager) {
+        // An empty id list subscribes to every tag; each batch carries only the tags that changed
+        m_subscriber = tagManager->subscribe(QVector<HYTagManager::TagId>(), this,
+                                             [this](const QVector<HYTagUpdate> &updates) { evaluate(updates); },
+                                             NotifyLatency);
+        connect(tagManager, &HYTagManager::tagRemoved, this, &HYAlarmManager::onTagRemoved);
+    }
+}
+
+HYAlarmManager::~HYAlarmManager()
+{
+    if (m_tagManager && m_subscriber >= 0) {
+        m_tagManager->unsubscribe(m_subscriber);
+    }
+}
+
+bool HYAlarmManager::addAlarm(const HYAlarmDefinition &definition, QString *error)
+{
+    auto fail = [error](const QString &message) {
+        if (error) {
+            *error = message;
+        }
+        return false;
+    };
+
+    if (definition.name.isEmpty()) {
+        return fail(QStringLiteral("alarm name is empty"));
+    }
+    if (!std::isfinite(definition.limit) || !std::isfinite(definition.setpoint)) {
+        return fail(QString("alarm '%1' has a non-finite limit").arg(definition.name));
+    }
+    if (definition.deadband < 0.0 || definition.onDelay < 0 || definition.offDelay < 0) {
+        return fail(QString("alarm '%1' has a negative deadband or delay").arg(definition.name));
+    }
+    const HYTagManager::TagId tag = m_tagManager ? m_tagManager->resolveTag(definition.tagName)
+                                                 : HYTagManager::InvalidTagId;
+    if (tag == HYTagManager::InvalidTagId) {
+        return fail(QString("unknown tag '%1'").arg(definition.tagName));
+    }
+    const HYTagRecord record = m_tagManager->record(tag);
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+
+    QVector<Notice> notices;
+    QMutexLocker locker(&m_mutex);
+    if (m_names.contains(definition.name)) {
+        return fail(QString("alarm '%1' already exists").arg(definition.name));
+    }
+
+    int index;
+    if (!m_freeSlots.isEmpty()) {
+        index = m_freeSlots.takeLast();
+    } else {
+        index = m_alarms.size();
+        m_alarms.append(Alarm());
+    }
+    Alarm &alarm = m_alarms[index];
+    alarm.definition = definition;
+    alarm.tag = tag;
+    alarm.used = true;
+    alarm.state.name = definition.name;
+    alarm.state.tagName = definition.tagName;
+    alarm.state.type = definition.type;
+    alarm.state.severity = qBound(1, definition.severity, 1000);
+    alarm.state.message = definition.message;
+    m_names.insert(definition.name, index);
+    m_byTag[tag].append(index);
+    m_tagIds.insert(definition.tagName, tag);
+
+    // Judge the value the tag already has instead of waiting for its next change
+    if (record.value.isNumeric() && (record.quality & HYTagValueStore::QualityStatusMask) != HYTagValueStore::QualityBad
+        && std::isfinite(record.value.toDouble())) {
+        evaluateLocked(index, record.value.toDouble(), record.sourceTimestamp, now, &notices);
+    }
+    locker.unlock();
+
+    finish(notices);
+    return true;
+}
+
+bool HYAlarmManager::removeAlarm(const QString &name)
+{
+    QMutexLocker locker(&m_mutex);
+    const int index = m_names.value(name, -1);
+    if (index < 0) {
+        return false;
+    }
+    removeLocked(index);
+    return true;
+}
+
+int HYAlarmManager::alarmCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_names.size();
+}
+
+HYAlarmState HYAlarmManager::alarmState(const QString &name) const
+{
+    QMutexLocker locker(&m_mutex);
+    const int index = m_names.value(name, -1);
+    return index >= 0 ? m_alarms[index].state : HYAlarmState();
+}
+
+QVector<HYAlarmState> HYAlarmManager::activeAlarms() const
+{
+    QVector<HYAlarmState> alarms;
+    {
+        QMutexLocker locker(&m_mutex);
+        alarms.reserve(m_table.size());
+        for (int index : m_table) {
+            if (!m_alarms[index].state.shelved) {
+                alarms.append(m_alarms[index].state);
+            }
+        }
+    }
+
+    std::sort(alarms.begin(), alarms.end(), [](const HYAlarmState &a, const HYAlarmState &b) {
+        if (a.severity != b.severity) {
+            return a.severity > b.severity;
+        }
+        if (a.activeTime != b.activeTime) {
+            return a.activeTime > b.activeTime;
+        }
+        return a.name < b.name;
+    });
+    return alarms;
+}
+
+bool HYAlarmManager::acknowledge(const QString &name)
+{
+    QVector<Notice> notices;
+    QMutexLocker locker(&m_mutex);
+    const int index = m_names.value(name, -1);
+    if (index < 0 || m_alarms[index].state.acknowledged) {
+        return false;
+    }
+
+    HYAlarmState &state = m_alarms[index].state;
+    state.acknowledged = true;
+    state.acknowledgeTime = QDateTime::currentMSecsSinceEpoch();
+    updateTableLocked(index);
+    notices.append(Notice{Notice::Acknowledged, state.name, QString(), state.severity});
+    locker.unlock();
+
+    finish(notices);
+    return true;
+}
+
+int HYAlarmManager::acknowledgeAll()
+{
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    QVector<Notice> notices;
+    QMutexLocker locker(&m_mutex);
+    const QList<int> table = m_table.values();
+    for (int index : table) {
+        HYAlarmState &state = m_alarms[index].state;
+        if (state.acknowledged || state.shelved) {
+            continue;
+        }
+        state.acknowledged = true;
+        state.acknowledgeTime = now;
+        updateTableLocked(index);
+        notices.append(Notice{Notice::Acknowledged, state.name, QString(), state.severity});
+    }
+    locker.unlock();
+
+    finish(notices);
+    return notices.size();
+}
+
+bool HYAlarmManager::shelve(const QString &name, int duration)
+{
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    QVector<Notice> notices;
+    QMutexLocker locker(&m_mutex);
+    const int index = m_names.value(name, -1);
+    if (index < 0) {
+        return false;
+    }
+
+    HYAlarmState &state = m_alarms[index].state;
+    if (!state.shelved) {
+        state.shelved = true;
+        notices.append(Notice{Notice::Shelved, state.name, QString(), state.severity});
+    }
+    if (duration > 0) {
+        state.shelvedUntil = now + duration;
+        scheduleLocked(index, state.shelvedUntil);
+    } else {
+        state.shelvedUntil = std::numeric_limits<qint64>::max();
+    }
+    locker.unlock();
+
+    finish(notices);
+    return true;
+}
+
+bool HYAlarmManager::unshelve(const QString &name)
+{
+    QVector<Notice> notices;
+    QMutexLocker locker(&m_mutex);
+    const int index = m_names.value(name, -1);
+    if (index < 0 || !m_alarms[index].state.shelved) {
+        return false;
+    }
+    unshelveLocked(index, &notices);
+    locker.unlock();
+
+    finish(notices);
+    return true;
+}
+
+int HYAlarmManager::evaluate(const QVector<HYTagUpdate> &updates)
+{
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    QVector<Notice> notices;
+    int changed = 0;
+
+    QMutexLocker locker(&m_mutex);
+    for (const HYTagUpdate &update : updates) {
+        auto alarms = m_byTag.constFind(update.id);
+        if (alarms == m_byTag.constEnd()) {
+            continue;
+        }
+
+        // Bad or non-numeric values neither raise nor clear an alarm
+        if ((update.quality & HYTagValueStore::QualityStatusMask) == HYTagValueStore::QualityBad
+            || !update.value.isNumeric()) {
+            continue;
+        }
+        const double value = update.value.toDouble();
+        if (!std::isfinite(value)) {
+            continue;
+        }
+        for (int index : *alarms) {
+            if (evaluateLocked(index, value, update.timestamp, now, &notices)) {
+                ++changed;
+            }
+        }
+    }
+    locker.unlock();
+
+    finish(notices);
+    return changed;
+}
+
+void HYAlarmManager::onTimer()
+{
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    QVector<Notice> notices;
+
+    QMutexLocker locker(&m_mutex);
+    m_timerDue = 0;
+    while (!m_schedule.isEmpty() && m_schedule.firstKey() <= now) {
+        const int index = m_schedule.first();
+        m_schedule.erase(m_schedule.begin());
+        if (!m_alarms[index].used) {
+            continue;
+        }
+        Alarm &alarm = m_alarms[index];
+
+        if (alarm.state.shelved && alarm.state.shelvedUntil <= now) {
+            unshelveLocked(index, &notices);
+        }
+
+        // A rate alarm that has received no new value for a while falls back as if the rate were zero
+        bool condition = alarm.condition;
+        if (alarm.rateDue != 0 && alarm.rateDue <= now) {
+            if (now - alarm.rateReceived >= RateHoldInterval) {
+                alarm.rateDue = 0;
+                condition = testLocked(alarm, 0.0);
+            } else {
+                alarm.rateDue = alarm.rateReceived + RateHoldInterval;
+                scheduleLocked(index, alarm.rateDue);
+            }
+        }
+
+        // Entries left behind by a condition that has since changed are harmless: the delay is recomputed here
+        applyLocked(index, condition, now, &notices);
+    }
+    locker.unlock();
+
+    finish(notices);
+}
+
+void HYAlarmManager::onTagRemoved(const QString &tagName)
+{
+    QMutexLocker locker(&m_mutex);
+    const HYTagManager::TagId tag = m_tagIds.value(tagName, HYTagManager::InvalidTagId);
+    if (tag == HYTagManager::InvalidTagId) {
+        return;
+    }
+    const QVector<int> alarms = m_byTag.value(tag);
+    for (int index : alarms) {
+        removeLocked(index);
+    }
+}
+
+bool HYAlarmManager::evaluateLocked(int index, double value, qint64 timestamp, qint64 now, QVector<Notice> *notices)
+{
+    Alarm &alarm = m_alarms[index];
+    alarm.state.value = value;
+    if (alarm.definition.type != HYAlarmDefinition::RateOfChange) {
+        return applyLocked(index, testLocked(alarm, value), now, notices);
+    }
+
+    // The rate is taken between consecutive delivered values; a value that is not newer keeps the condition
+    bool condition = alarm.condition;
+    if (!alarm.rateSample || timestamp > alarm.rateTime) {
+        if (alarm.rateSample) {
+            condition = testLocked(alarm, std::abs(value - alarm.rateValue) * 1000.0 / double(timestamp - alarm.rateTime));
+        }
+        alarm.rateSample = true;
+        alarm.rateValue = value;
+        alarm.rateTime = timestamp;
+        alarm.rateReceived = now;
+    }
+    if (condition && alarm.rateDue == 0) {
+        alarm.rateDue = now + RateHoldInterval;
+        scheduleLocked(index, alarm.rateDue);
+    }
+    return applyLocked(index, condition, now, notices);
+}
+
+bool HYAlarmManager::testLocked(const Alarm &alarm, double value) const
+{
+    const HYAlarmDefinition &definition = alarm.definition;
+
+    // Once tripped, the value has to come back past the limit by the deadband before the condition clears
+    const double deadband = alarm.condition ? definition.deadband : 0.0;
+    switch (definition.type) {
+    case HYAlarmDefinition::High:
+    case HYAlarmDefinition::HighHigh:
+    case HYAlarmDefinition::RateOfChange:
+        return value >= definition.limit - deadband;
+    case HYAlarmDefinition::Low:
+    case HYAlarmDefinition::LowLow:
+        return value <= definition.limit + deadband;
+    case HYAlarmDefinition::Deviation:
+        return std::abs(value - definition.setpoint) >= definition.limit - deadband;
+    case HYAlarmDefinition::Discrete:
+        return value == definition.limit;
+    }
+    return false;
+}
+
+bool HYAlarmManager::applyLocked(int index, bool condition, qint64 now, QVector<Notice> *notices)
+{
+    Alarm &alarm = m_alarms[index];
+    if (condition != alarm.condition) {
+        alarm.condition = condition;
+        alarm.conditionSince = now;
+    }
+    if (condition == alarm.state.active) {
+        alarm.delayDue = 0;
+        return false;
+    }
+
+    // The condition has to hold for the whole delay; a flip back in between restarts it
+    const qint64 due = alarm.conditionSince + (condition ? alarm.definition.onDelay : alarm.definition.offDelay);
+    if (due > now) {
+        if (alarm.delayDue != due) {
+            alarm.delayDue = due;
+            scheduleLocked(index, due);
+        }
+        return false;
+    }
+
+    alarm.delayDue = 0;
+    HYAlarmState &state = alarm.state;
+    state.active = condition;
+    if (condition) {
+        state.acknowledged = false;
+        state.activeTime = now;
+        state.clearTime = 0;
+    } else {
+        state.clearTime = now;
+    }
+    updateTableLocked(index);
+    if (!state.shelved) {
+        notices->append(Notice{condition ? Notice::Activated : Notice::Cleared, state.name, state.message, state.severity});
+    }
+    return true;
+}
+
+void HYAlarmManager::scheduleLocked(int index, qint64 due)
+{
+    m_schedule.insert(due, index);
+}
+
+void HYAlarmManager::updateTableLocked(int index)
+{
+    const HYAlarmState &state = m_alarms[index].state;
+    if (state.active || !state.acknowledged) {
+        m_table.insert(index);
+    } else {
+        m_table.remove(index);
+    }
+}
+
+void HYAlarmManager::unshelveLocked(int index, QVector<Notice> *notices)
+{
+    HYAlarmState &state = m_alarms[index].state;
+    state.shelved = false;
+    state.shelvedUntil = 0;
+    notices->append(Notice{Notice::Unshelved, state.name, QString(), state.severity});
+    if (state.active) {
+        notices->append(Notice{Notice::Activated, state.name, state.message, state.severity});
+    }
+}
+
+void HYAlarmManager::removeLocked(int index)
+{
+    Alarm &alarm = m_alarms[index];
+    m_names.remove(alarm.definition.name);
+    auto alarms = m_byTag.find(alarm.tag);
+    if (alarms != m_byTag.end()) {
+        alarms->removeOne(index);
+        if (alarms->isEmpty()) {
+            m_byTag.erase(alarms);
+            m_tagIds.remove(alarm.definition.tagName);
+        }
+    }
+    m_table.remove(index);
+
+    // Schedule entries that still point at the slot are skipped while it is free and are harmless once reused
+    alarm = Alarm();
+    m_freeSlots.append(index);
+}
+
+void HYAlarmManager::finish(const QVector<Notice> &notices)
+{
+    for (const Notice &notice : notices) {
+        switch (notice.kind) {
+        case Notice::Activated:
+            emit alarmActivated(notice.name, notice.message, notice.severity);
+            break;
+        case Notice::Cleared:
+            emit alarmCleared(notice.name);
+            break;
+        case Notice::Acknowledged:
+            emit alarmAcknowledged(notice.name);
+            break;
+        case Notice::Shelved:
+            emit alarmShelved(notice.name, true);
+            break;
+        case Notice::Unshelved:
+            emit alarmShelved(notice.name, false);
+            break;
+        }
+    }
+
+    // Restart the timer only when the earliest due time has moved; the timer belongs to this object's thread
+    QMutexLocker locker(&m_mutex);
+    const qint64 due = m_schedule.isEmpty() ? 0 : m_schedule.firstKey();
+    if (due == m_timerDue) {
+        return;
+    }
+    if (QThread::currentThread() != thread()) {
+        locker.unlock();
+        QMetaObject::invokeMethod(this, [this]() { finish(QVector<Notice>()); }, Qt::QueuedConnection);
+        return;
+    }
+    m_timerDue = due;
+    if (due == 0) {
+        m_timer->stop();
+    } else {
+        const qint64 delay = due - QDateTime::currentMSecsSinceEpoch();
+        m_timer->start(int(qBound<qint64>(0, delay, std::numeric_limits<int>::max())));
+    }
+}
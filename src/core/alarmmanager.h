@@ -0,0 +1,310 @@
+#ifndef HYALARMMANAGER_H
+#define HYALARMMANAGER_H
+
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include <QHash>
+#include <QMultiMap>
+#include <QSet>
+#include <QMutex>
+#include <QPointer>
+#include <QTimer>
+#include "tagmanager.h"
+
+/**
+ * @file alarmmanager.h
+ * @brief 告警管理器头文件
+ */
+
+/**
+ * @struct HYAlarmDefinition
+ * @brief 告警定义
+ */
+struct HYAlarmDefinition
+{
+    /**
+     * @enum Type
+     * @brief 告警类型
+     */
+    enum Type {
+        High,         ///< 高限：值不小于limit时触发
+        HighHigh,     ///< 高高限，判断方式与High相同
+        Low,          ///< 低限：值不大于limit时触发
+        LowLow,       ///< 低低限，判断方式与Low相同
+        Deviation,    ///< 偏差：值与setpoint之差的绝对值不小于limit时触发
+        RateOfChange, ///< 变化率：相邻两次值按源时间戳计算的每秒变化量绝对值不小于limit时触发
+        Discrete      ///< 开关量：值等于limit时触发，布尔值按0和1比较
+    };
+
+    QString name; ///< 告警名称，唯一
+    QString tagName; ///< 监视的点位名称
+    Type type = High; ///< 告警类型
+    double limit = 0.0; ///< 限值
+    double setpoint = 0.0; ///< 设定值，只用于偏差告警
+    double deadband = 0.0; ///< 死区：触发后要回到限值内侧超过死区才恢复，开关量告警不使用
+    int onDelay = 0; ///< 触发延时（毫秒）：条件持续满足这么久才触发
+    int offDelay = 0; ///< 恢复延时（毫秒）：条件持续不满足这么久才恢复
+    int severity = 500; ///< 严重程度，1~1000，越大越严重
+    QString message; ///< 告警信息
+};
+
+/**
+ * @struct HYAlarmState
+ * @brief 告警的当前状态
+ */
+struct HYAlarmState
+{
+    QString name; ///< 告警名称
+    QString tagName; ///< 监视的点位名称
+    HYAlarmDefinition::Type type = HYAlarmDefinition::High; ///< 告警类型
+    int severity = 0; ///< 严重程度
+    QString message; ///< 告警信息
+    bool active = false; ///< 是否处于告警状态
+    bool acknowledged = true; ///< 是否已确认
+    bool shelved = false; ///< 是否已搁置
+    double value = 0.0; ///< 最近一次判断时的值
+    qint64 activeTime = 0; ///< 最近一次触发的时间（毫秒），从未触发时为0
+    qint64 clearTime = 0; ///< 最近一次恢复的时间（毫秒），仍在告警时为0
+    qint64 acknowledgeTime = 0; ///< 最近一次确认的时间（毫秒）
+    qint64 shelvedUntil = 0; ///< 搁置结束的时间（毫秒），未搁置时为0
+};
+
+/**
+ * @class HYAlarmManager
+ * @brief 告警管理器
+ *
+ * 按事件判断告警：通过点位管理器的订阅接收变化的点位，每批只判断这些点位上的告警，
+ * 开销与变化的点位数成正比，与告警定义的总数无关；不变化的点位不做任何判断
+ * 触发延时、恢复延时、变化率告警的回落和定时搁置的到期由同一个按到期时间排序的定时器处理，
+ * 只涉及正在等待的告警
+ * 质量码为坏值或值不是数值的更新不改变告警状态
+ *
+ * 告警表包含处于告警状态或尚未确认的告警：触发时进入告警表并等待确认，恢复且已确认后移出
+ * 搁置的告警照常判断状态，但不发出触发和恢复信号，也不出现在activeAlarms()中
+ *
+ * 告警管理器必须位于有事件循环的线程中；公有方法可以在任意线程调用
+ */
+class HYAlarmManager : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int NotifyLatency = 20; ///< 订阅点位变化的最大通知延迟（毫秒）
+    static constexpr int RateHoldInterval = 1000; ///< 变化率告警在此时间（毫秒）内没有新值时按变化率为0判断
+
+    /**
+     * @brief 构造函数
+     *
+     * 订阅点位管理器的全部点位变化；点位被删除时其上的告警一并删除
+     * @param tagManager 点位管理器
+     * @param parent 父对象
+     */
+    explicit HYAlarmManager(HYTagManager *tagManager, QObject *parent = nullptr);
+
+    /**
+     * @brief 析构函数
+     */
+    ~HYAlarmManager();
+
+    /**
+     * @brief 添加告警
+     *
+     * 点位已有值时立即按当前值判断一次
+     * @param definition 告警定义
+     * @param error 输出错误信息，可为空
+     * @return 是否成功
+     */
+    bool addAlarm(const HYAlarmDefinition &definition, QString *error = nullptr);
+
+    /**
+     * @brief 删除告警，告警表中的记录一并删除，不发出信号
+     * @param name 告警名称
+     * @return 告警是否存在
+     */
+    bool removeAlarm(const QString &name);
+
+    /**
+     * @brief 获取告警定义数
+     * @return 告警定义数
+     */
+    int alarmCount() const;
+
+    /**
+     * @brief 获取告警的当前状态
+     * @param name 告警名称
+     * @return 状态，告警不存在时名称为空
+     */
+    HYAlarmState alarmState(const QString &name) const;
+
+    /**
+     * @brief 获取告警表
+     * @return 未搁置的告警表记录，按严重程度从高到低、触发时间从新到旧排序
+     */
+    QVector<HYAlarmState> activeAlarms() const;
+
+    /**
+     * @brief 确认告警，已恢复的告警确认后移出告警表
+     * @param name 告警名称
+     * @return 是否确认了未确认的告警
+     */
+    bool acknowledge(const QString &name);
+
+    /**
+     * @brief 确认告警表中全部未确认且未搁置的告警
+     * @return 确认的告警数
+     */
+    int acknowledgeAll();
+
+    /**
+     * @brief 搁置告警
+     * @param name 告警名称
+     * @param duration 搁置时长（毫秒），0表示直到调用unshelve()
+     * @return 告警是否存在
+     */
+    bool shelve(const QString &name, int duration = 0);
+
+    /**
+     * @brief 取消搁置，告警仍处于告警状态时重新发出触发信号
+     * @param name 告警名称
+     * @return 是否取消了搁置
+     */
+    bool unshelve(const QString &name);
+
+    /**
+     * @brief 按一批点位更新判断告警
+     *
+     * 订阅回调调用此方法；也可由调用方直接传入更新
+     * @param updates 点位更新，时间戳为源时间戳
+     * @return 状态变化（触发或恢复）的告警数
+     */
+    int evaluate(const QVector<HYTagUpdate> &updates);
+
+signals:
+    /**
+     * @brief 告警触发信号
+     * @param name 告警名称
+     * @param message 告警信息
+     * @param severity 严重程度
+     */
+    void alarmActivated(const QString &name, const QString &message, int severity);
+
+    /**
+     * @brief 告警恢复信号
+     * @param name 告警名称
+     */
+    void alarmCleared(const QString &name);
+
+    /**
+     * @brief 告警确认信号
+     * @param name 告警名称
+     */
+    void alarmAcknowledged(const QString &name);
+
+    /**
+     * @brief 告警搁置状态变化信号
+     * @param name 告警名称
+     * @param shelved 是否搁置
+     */
+    void alarmShelved(const QString &name, bool shelved);
+
+private slots:
+    /**
+     * @brief 定时器槽函数，处理到期的延时、变化率回落和搁置
+     */
+    void onTimer();
+
+    /**
+     * @brief 点位删除槽函数，删除其上的告警
+     * @param tagName 点位名称
+     */
+    void onTagRemoved(const QString &tagName);
+
+private:
+    /**
+     * @struct Alarm
+     * @brief 告警定义和判断状态
+     */
+    struct Alarm {
+        HYAlarmDefinition definition; ///< 告警定义
+        HYTagManager::TagId tag = HYTagManager::InvalidTagId; ///< 监视的点位句柄
+        bool used = false; ///< 槽位是否在用
+        bool condition = false; ///< 经过死区判断的条件
+        qint64 conditionSince = 0; ///< 条件最近一次变化的时间（毫秒）
+        qint64 delayDue = 0; ///< 正在等待的延时到期时间（毫秒），0表示没有
+        bool rateSample = false; ///< 是否已有变化率的上一个值
+        double rateValue = 0.0; ///< 变化率的上一个值
+        qint64 rateTime = 0; ///< 上一个值的源时间戳（毫秒）
+        qint64 rateReceived = 0; ///< 收到上一个值的时间（毫秒）
+        qint64 rateDue = 0; ///< 变化率回落检查的到期时间（毫秒），0表示没有
+        HYAlarmState state; ///< 对外的状态
+    };
+
+    /**
+     * @struct Notice
+     * @brief 解锁后发出的信号
+     */
+    struct Notice {
+        enum Kind { Activated, Cleared, Acknowledged, Shelved, Unshelved } kind; ///< 信号类型
+        QString name; ///< 告警名称
+        QString message; ///< 告警信息
+        int severity; ///< 严重程度
+    };
+
+    /**
+     * @brief 按新值判断告警
+     * @return 状态是否变化
+     */
+    bool evaluateLocked(int index, double value, qint64 timestamp, qint64 now, QVector<Notice> *notices);
+
+    /**
+     * @brief 按死区判断条件
+     */
+    bool testLocked(const Alarm &alarm, double value) const;
+
+    /**
+     * @brief 按条件和延时更新告警状态
+     * @return 状态是否变化
+     */
+    bool applyLocked(int index, bool condition, qint64 now, QVector<Notice> *notices);
+
+    /**
+     * @brief 安排定时检查
+     */
+    void scheduleLocked(int index, qint64 due);
+
+    /**
+     * @brief 按是否处于告警状态和是否已确认更新告警表成员
+     */
+    void updateTableLocked(int index);
+
+    /**
+     * @brief 取消搁置
+     */
+    void unshelveLocked(int index, QVector<Notice> *notices);
+
+    /**
+     * @brief 删除告警
+     */
+    void removeLocked(int index);
+
+    /**
+     * @brief 发出信号并按最早的到期时间重启定时器
+     */
+    void finish(const QVector<Notice> &notices);
+
+    QPointer<HYTagManager> m_tagManager; ///< 点位管理器
+    int m_subscriber; ///< 订阅者编号
+    mutable QMutex m_mutex; ///< 保护以下成员
+    QVector<Alarm> m_alarms; ///< 告警槽位
+    QVector<int> m_freeSlots; ///< 空闲槽位
+    QHash<QString, int> m_names; ///< 告警名称到槽位
+    QHash<HYTagManager::TagId, QVector<int>> m_byTag; ///< 点位句柄到其上的告警槽位
+    QHash<QString, HYTagManager::TagId> m_tagIds; ///< 有告警的点位名称到句柄
+    QMultiMap<qint64, int> m_schedule; ///< 到期时间到告警槽位，过期的条目在到期时忽略
+    QSet<int> m_table; ///< 告警表中的告警槽位
+    qint64 m_timerDue; ///< 定时器当前的到期时间（毫秒），0表示未启动
+    QTimer *m_timer; ///< 到期检查定时器
+};
+
+#endif // HYALARMMANAGER_H
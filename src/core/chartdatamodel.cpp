@@ -1,4 +1,5 @@
 #include "chartdatamodel.h"
+#include "timeseriesdatabase.h"
 #include <QFile>
 #include <QTextStream>
 #include <QDateTime>
@@ -15,6 +16,8 @@
 ChartDataModel::ChartDataModel(HYTagManager *tagManager, QObject *parent) 
     : QAbstractTableModel(parent),
       m_tagManager(tagManager),
+      m_database(nullptr),
+      m_trendPoints(DefaultTrendPoints),
       m_dataPoints(),
       m_seriesInfo(),
       m_startTime(QDateTime::currentDateTime().addDays(-1)),
@@ -215,6 +218,18 @@ bool ChartDataModel::setPresetTimeRange(const QString &preset)
     return setTimeRange(startTime, endTime);
 }
 
+void ChartDataModel::setTimeSeriesDatabase(HYTimeSeriesDatabase *database)
+{
+    QMutexLocker locker(&m_mutex);
+    m_database = database;
+}
+
+void ChartDataModel::setTrendPointCount(int points)
+{
+    QMutexLocker locker(&m_mutex);
+    m_trendPoints = points;
+}
+
 bool ChartDataModel::loadHistoricalData(const QString &tagName, const QDateTime &startTime, const QDateTime &endTime)
 {
     QMutexLocker locker(&m_mutex);
@@ -224,23 +239,35 @@ bool ChartDataModel::loadHistoricalData(const QString &tagName, const QDateTime
         return false;
     }
 
-    // 这里应该从数据库加载历史数据
-    // 为了演示，我们生成一些模拟数据
     QVector<DataPoint> newDataPoints;
-    
-    QDateTime currentTime = startTime;
-    while (currentTime <= endTime) {
-        DataPoint point;
-        point.timestamp = currentTime;
-        
-        // 生成模拟数据
-        double value = 50.0 + 20.0 * sin(currentTime.toMSecsSinceEpoch() / 10000.0);
-        point.values[tagName] = value;
-        
-        newDataPoints.append(point);
-        
-        // 每10秒一个数据点
-        currentTime = currentTime.addSecs(10);
+
+    if (m_database && m_database->isConnected()) {
+        // 长时间范围取仍能填满图表的最粗汇总，不读取全部原始样本
+        const QVector<HYTimeSeriesDatabase::TrendPoint> trend =
+            m_database->queryTagTrend(tagName, startTime, endTime, m_trendPoints);
+        newDataPoints.reserve(trend.size());
+        for (const HYTimeSeriesDatabase::TrendPoint &trendPoint : trend) {
+            DataPoint point;
+            point.timestamp = QDateTime::fromMSecsSinceEpoch(trendPoint.timestamp);
+            point.values[tagName] = trendPoint.avg;
+            newDataPoints.append(point);
+        }
+    } else {
+        // 没有数据库时生成模拟数据
+        QDateTime currentTime = startTime;
+        while (currentTime <= endTime) {
+            DataPoint point;
+            point.timestamp = currentTime;
+            
+            // 生成模拟数据
+            double value = 50.0 + 20.0 * sin(currentTime.toMSecsSinceEpoch() / 10000.0);
+            point.values[tagName] = value;
+            
+            newDataPoints.append(point);
+            
+            // 每10秒一个数据点
+            currentTime = currentTime.addSecs(10);
+        }
     }
 
     // 合并数据点
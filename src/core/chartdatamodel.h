@@ -9,6 +9,8 @@
 #include <QMutex>
 #include "tagmanager.h"
 
+class HYTimeSeriesDatabase;
+
 /**
  * @file chartdatamodel.h
  * @brief 图表数据模型类
@@ -23,6 +25,8 @@ class ChartDataModel : public QAbstractTableModel
     Q_OBJECT
 
 public:
+    static constexpr int DefaultTrendPoints = 1000; ///< 默认每条曲线加载的最少趋势点数
+
     /**
      * @brief 构造函数
      * @param tagManager 点位管理器指针
@@ -87,8 +91,24 @@ public:
      */
     bool setPresetTimeRange(const QString &preset);
     
+    /**
+     * @brief 设置历史数据来源
+     * @param database 时间序列数据库，为空时加载模拟数据
+     */
+    void setTimeSeriesDatabase(HYTimeSeriesDatabase *database);
+
+    /**
+     * @brief 设置每条曲线加载的最少趋势点数
+     * 
+     * 数据库按此选取汇总区间，时间范围越长使用的汇总越粗
+     * @param points 点数
+     */
+    void setTrendPointCount(int points);
+
     /**
      * @brief 加载历史数据
+     * 
+     * 设置了数据库时通过queryTagTrend()加载，每个点取区间平均值
      * @param tagName 点位名称
      * @param startTime 开始时间
      * @param endTime 结束时间
@@ -167,6 +187,8 @@ private:
     };
 
     HYTagManager *m_tagManager; ///< 点位管理器指针
+    HYTimeSeriesDatabase *m_database; ///< 历史数据来源
+    int m_trendPoints; ///< 每条曲线加载的最少趋势点数
     QVector<DataPoint> m_dataPoints; ///< 数据点列表
     QMap<QString, SeriesInfo> m_seriesInfo; ///< 指标信息
     QDateTime m_startTime; ///< 开始时间
@@ -0,0 +1,743 @@
+#include "columnstore.h"
+#include <QMap>
+#include <QMutexLocker>
+#include <bit>
+#include <cstring>
+#include <limits>
+
+/**
+ * @file columnstore.cpp
+ * @brief 内置列式时间序列存储实现
+ *
+ * 记录：32字节定长头（类型、值编码、负载CRC16、序列编号、最早和最晚时间戳、样本数、负载字节数），负载跟在头之后
+ * 块负载是位流，高位在前：
+ * 第一个样本的时间戳64位；之后每个样本的时间戳差值的差值按范围编码为
+ * '0'、'10'+7位、'110'+9位、'1110'+12位或'1111'+64位
+ * 浮点块：第一个值64位；之后与前一个值异或，为0时'0'，有效位落在上一个窗口内时'10'+窗口内的位，
+ * 否则'11'+5位前导零数+6位有效位数（0表示64）+有效位
+ * 字符串块：每个值32位UTF-8长度加字节
+ */
+
+namespace {
+
+/**
+ * @struct RecordHeader
+ * @brief 记录头
+ */
+struct RecordHeader {
+    quint8 kind; ///< 记录类型
+    quint8 encoding; ///< 值编码
+    quint16 checksum; ///< 负载的CRC16
+    quint32 series; ///< 序列编号
+    qint64 first; ///< 最早的时间戳
+    qint64 last; ///< 最晚的时间戳
+    quint32 count; ///< 样本数
+    quint32 size; ///< 负载字节数
+};
+static_assert(sizeof(RecordHeader) == 32, "column store record header must stay 32 bytes");
+
+/**
+ * @brief 计算负载校验值
+ */
+quint16 checksum(const char *data, qint64 size)
+{
+    return qChecksum(QByteArrayView(data, size));
+}
+
+/**
+ * @class BitReader
+ * @brief 按位读取块负载，高位在前
+ */
+class BitReader
+{
+public:
+    BitReader(const char *data, qint64 size)
+        : m_data(reinterpret_cast<const uchar *>(data)), m_bits(size * 8), m_position(0)
+    {
+    }
+
+    /**
+     * @brief 读取若干位
+     * @param count 位数，不超过64
+     * @param bits 输出读取的位
+     * @return 数据是否足够
+     */
+    bool read(int count, quint64 *bits)
+    {
+        if (m_position + count > m_bits) {
+            return false;
+        }
+        quint64 result = 0;
+        while (count > 0) {
+            const int available = 8 - int(m_position & 7);
+            const int take = qMin(count, available);
+            const quint64 byte = m_data[m_position >> 3];
+            result = (result << take) | ((byte >> (available - take)) & ((1u << take) - 1));
+            m_position += take;
+            count -= take;
+        }
+        *bits = result;
+        return true;
+    }
+
+    /**
+     * @brief 读取一位
+     * @param bit 输出读取的位
+     * @return 数据是否足够
+     */
+    bool readBit(bool *bit)
+    {
+        if (m_position >= m_bits) {
+            return false;
+        }
+        *bit = (m_data[m_position >> 3] >> (7 - (m_position & 7))) & 1;
+        ++m_position;
+        return true;
+    }
+
+private:
+    const uchar *m_data; ///< 数据
+    qint64 m_bits; ///< 总位数
+    qint64 m_position; ///< 下一位的位置
+};
+
+/**
+ * @brief 把低count位作为有符号数扩展到64位
+ */
+qint64 signExtend(quint64 bits, int count)
+{
+    if (count < 64 && (bits >> (count - 1)) & 1) {
+        bits |= ~quint64(0) << count;
+    }
+    return qint64(bits);
+}
+
+/**
+ * @brief 读取时间戳差值的差值
+ * @param reader 读取器
+ * @param dod 输出差值的差值
+ * @return 数据是否足够
+ */
+bool readDeltaOfDelta(BitReader &reader, qint64 *dod)
+{
+    static constexpr int Widths[] = {7, 9, 12, 64};
+    bool bit;
+    if (!reader.readBit(&bit)) {
+        return false;
+    }
+    if (!bit) {
+        *dod = 0;
+        return true;
+    }
+    for (int i = 0; i < 4; ++i) {
+        // The last bucket has no terminating zero bit
+        if (i < 3) {
+            if (!reader.readBit(&bit)) {
+                return false;
+            }
+            if (bit) {
+                continue;
+            }
+        }
+        quint64 bits;
+        if (!reader.read(Widths[i], &bits)) {
+            return false;
+        }
+        *dod = signExtend(bits, Widths[i]);
+        return true;
+    }
+    return false;
+}
+
+} // namespace
+
+void HYColumnStore::Encoder::writeBits(quint64 bits, int count)
+{
+    while (count > 0) {
+        if (freeBits == 0) {
+            data.append('\0');
+            freeBits = 8;
+        }
+        const int take = qMin(count, freeBits);
+        const quint8 part = quint8((bits >> (count - take)) & ((1u << take) - 1));
+        data.data()[data.size() - 1] |= char(part << (freeBits - take));
+        freeBits -= take;
+        count -= take;
+    }
+}
+
+void HYColumnStore::Encoder::append(qint64 timestamp, const QVariant &sample)
+{
+    const quint64 bits = encoding == EncodingFloat ? std::bit_cast<quint64>(sample.toDouble()) : 0;
+
+    if (count == 0) {
+        writeBits(quint64(timestamp), 64);
+        first = timestamp;
+        if (encoding == EncodingFloat) {
+            writeBits(bits, 64);
+        }
+    } else {
+        const qint64 current = timestamp - last;
+        const qint64 dod = current - delta;
+        if (dod == 0) {
+            writeBits(0, 1);
+        } else if (dod >= -64 && dod <= 63) {
+            writeBits(0b10, 2);
+            writeBits(quint64(dod), 7);
+        } else if (dod >= -256 && dod <= 255) {
+            writeBits(0b110, 3);
+            writeBits(quint64(dod), 9);
+        } else if (dod >= -2048 && dod <= 2047) {
+            writeBits(0b1110, 4);
+            writeBits(quint64(dod), 12);
+        } else {
+            writeBits(0b1111, 4);
+            writeBits(quint64(dod), 64);
+        }
+        delta = current;
+
+        if (encoding == EncodingFloat) {
+            const quint64 difference = bits ^ value;
+            if (difference == 0) {
+                writeBits(0, 1);
+            } else {
+                // Five bits hold the leading zero count, so longer runs are stored as 31
+                const int leadingZeros = qMin(std::countl_zero(difference), 31);
+                const int trailingZeros = std::countr_zero(difference);
+                if (leading >= 0 && leadingZeros >= leading && trailingZeros >= trailing) {
+                    writeBits(0b10, 2);
+                    writeBits(difference >> trailing, 64 - leading - trailing);
+                } else {
+                    const int significant = 64 - leadingZeros - trailingZeros;
+                    writeBits(0b11, 2);
+                    writeBits(quint64(leadingZeros), 5);
+                    writeBits(quint64(significant & 63), 6);
+                    writeBits(difference >> trailingZeros, significant);
+                    leading = leadingZeros;
+                    trailing = trailingZeros;
+                }
+            }
+        }
+    }
+
+    if (encoding == EncodingText) {
+        const QByteArray utf8 = sample.toString().toUtf8();
+        writeBits(quint64(utf8.size()), 32);
+        for (char byte : utf8) {
+            writeBits(quint8(byte), 8);
+        }
+    }
+
+    value = bits;
+    last = timestamp;
+    ++count;
+}
+
+void HYColumnStore::Encoder::reset()
+{
+    data.clear();
+    freeBits = 0;
+    count = 0;
+    first = 0;
+    last = 0;
+    delta = 0;
+    value = 0;
+    leading = -1;
+    trailing = 0;
+}
+
+HYColumnStore::HYColumnStore()
+    : m_size(0), m_chunks(0), m_decoded(0)
+{
+}
+
+HYColumnStore::~HYColumnStore()
+{
+    close();
+}
+
+bool HYColumnStore::open(const QString &path, QString *error)
+{
+    close();
+
+    QMutexLocker locker(&m_mutex);
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadWrite | QIODevice::Unbuffered)) {
+        if (error) {
+            *error = QString("cannot open '%1': %2").arg(path, m_file.errorString());
+        }
+        return false;
+    }
+    m_path = path;
+    if (!loadLocked(error)) {
+        m_file.close();
+        m_series.clear();
+        m_seriesIds.clear();
+        m_path.clear();
+        return false;
+    }
+    return true;
+}
+
+void HYColumnStore::close()
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_file.isOpen()) {
+        return;
+    }
+    for (int i = 0; i < m_series.size(); ++i) {
+        sealLocked(i);
+    }
+    m_file.close();
+    m_series.clear();
+    m_seriesIds.clear();
+    m_path.clear();
+    m_size = 0;
+    m_chunks = 0;
+}
+
+bool HYColumnStore::isOpen() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_file.isOpen();
+}
+
+QString HYColumnStore::path() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_path;
+}
+
+bool HYColumnStore::append(const QString &series, const QVector<Sample> &samples)
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_file.isOpen()) {
+        return false;
+    }
+    if (samples.isEmpty()) {
+        return true;
+    }
+    const int index = seriesLocked(series);
+    if (index < 0) {
+        return false;
+    }
+
+    // In-order samples go straight into the open chunk; the rest are merged once per batch
+    QVector<const Sample *> late;
+    for (const Sample &sample : samples) {
+        const Encoder &head = m_series[index].head;
+        if (late.isEmpty() && (head.count == 0 || sample.timestamp > head.last)) {
+            if (!appendSortedLocked(index, sample.timestamp, sample.value)) {
+                return false;
+            }
+        } else {
+            late.append(&sample);
+        }
+    }
+    if (late.isEmpty()) {
+        return true;
+    }
+
+    Encoder &head = m_series[index].head;
+    QVector<Sample> current;
+    if (head.count > 0) {
+        decode(head.data.constData(), head.data.size(), head.count, head.encoding,
+               std::numeric_limits<qint64>::min(), std::numeric_limits<qint64>::max(), &current);
+    }
+    QMap<qint64, QVariant> merged;
+    for (const Sample &sample : std::as_const(current)) {
+        merged.insert(sample.timestamp, sample.value);
+    }
+    for (const Sample *sample : std::as_const(late)) {
+        merged.insert(sample->timestamp, sample->value);
+    }
+    head.reset();
+    for (auto it = merged.cbegin(); it != merged.cend(); ++it) {
+        if (!appendSortedLocked(index, it.key(), it.value())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+QVector<HYColumnStore::Sample> HYColumnStore::query(const QString &series, qint64 start, qint64 end, int limit) const
+{
+    QMutexLocker locker(&m_mutex);
+    const auto it = m_seriesIds.constFind(series);
+    if (!m_file.isOpen() || it == m_seriesIds.cend() || start > end) {
+        return {};
+    }
+    QVector<Sample> result = collectLocked(m_series[*it], start, end);
+    if (limit > 0 && result.size() > limit) {
+        result.remove(0, result.size() - limit);
+    }
+    return result;
+}
+
+QVector<HYColumnStore::Sample> HYColumnStore::collectLocked(const Series &series, qint64 start, qint64 end) const
+{
+    QVector<QVector<Sample>> parts;
+    bool ordered = true;
+    qint64 latest = std::numeric_limits<qint64>::min();
+    auto add = [&](qint64 first, qint64 last, QVector<Sample> &&part) {
+        if (part.isEmpty()) {
+            return;
+        }
+        if (!parts.isEmpty() && first <= latest) {
+            ordered = false;
+        }
+        latest = qMax(latest, last);
+        parts.append(std::move(part));
+    };
+
+    QByteArray payload;
+    for (const ChunkRef &chunk : series.chunks) {
+        if (chunk.last < start || chunk.first > end) {
+            continue;
+        }
+        payload.resize(chunk.size);
+        if (!m_file.seek(chunk.offset) || m_file.read(payload.data(), chunk.size) != qint64(chunk.size)
+            || checksum(payload.constData(), payload.size()) != chunk.checksum) {
+            continue;
+        }
+        ++m_decoded;
+        QVector<Sample> part;
+        part.reserve(chunk.count);
+        decode(payload.constData(), payload.size(), chunk.count, chunk.encoding, start, end, &part);
+        add(chunk.first, chunk.last, std::move(part));
+    }
+    const Encoder &head = series.head;
+    if (head.count > 0 && head.last >= start && head.first <= end) {
+        QVector<Sample> part;
+        decode(head.data.constData(), head.data.size(), head.count, head.encoding, start, end, &part);
+        add(head.first, head.last, std::move(part));
+    }
+
+    QVector<Sample> result;
+    if (ordered) {
+        qsizetype total = 0;
+        for (const QVector<Sample> &part : std::as_const(parts)) {
+            total += part.size();
+        }
+        result.reserve(total);
+        for (const QVector<Sample> &part : std::as_const(parts)) {
+            result.append(part);
+        }
+        return result;
+    }
+
+    // Chunks rewritten out of order overlap; later chunks win for equal timestamps
+    QMap<qint64, QVariant> merged;
+    for (const QVector<Sample> &part : std::as_const(parts)) {
+        for (const Sample &sample : part) {
+            merged.insert(sample.timestamp, sample.value);
+        }
+    }
+    result.reserve(merged.size());
+    for (auto it = merged.cbegin(); it != merged.cend(); ++it) {
+        result.append(Sample{it.key(), it.value()});
+    }
+    return result;
+}
+
+bool HYColumnStore::flush()
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_file.isOpen()) {
+        return false;
+    }
+    bool success = true;
+    for (int i = 0; i < m_series.size(); ++i) {
+        success = sealLocked(i) && success;
+    }
+    return m_file.flush() && success;
+}
+
+bool HYColumnStore::clear(const QString &series)
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_file.isOpen()) {
+        return false;
+    }
+    if (series.isEmpty()) {
+        m_series.clear();
+        m_seriesIds.clear();
+        m_size = 0;
+        m_chunks = 0;
+        return m_file.resize(0);
+    }
+
+    const auto it = m_seriesIds.constFind(series);
+    if (it == m_seriesIds.cend()) {
+        return true;
+    }
+    Series &target = m_series[*it];
+    if (writeRecordLocked(RecordClear, 0, quint32(*it), 0, 0, 0, QByteArray()) < 0) {
+        return false;
+    }
+    m_chunks -= target.chunks.size();
+    target.chunks.clear();
+    target.head.reset();
+    return true;
+}
+
+QStringList HYColumnStore::seriesNames() const
+{
+    QMutexLocker locker(&m_mutex);
+    QStringList names;
+    for (const Series &series : m_series) {
+        if (!series.chunks.isEmpty() || series.head.count > 0) {
+            names.append(series.name);
+        }
+    }
+    return names;
+}
+
+int HYColumnStore::chunkCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_chunks;
+}
+
+qint64 HYColumnStore::fileSize() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_size;
+}
+
+quint64 HYColumnStore::decodedChunks() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_decoded;
+}
+
+HYColumnStore::Encoding HYColumnStore::encodingOf(const QVariant &value)
+{
+    switch (value.typeId()) {
+    case QMetaType::Bool:
+    case QMetaType::Int:
+    case QMetaType::UInt:
+    case QMetaType::LongLong:
+    case QMetaType::ULongLong:
+    case QMetaType::Double:
+    case QMetaType::Float:
+        return EncodingFloat;
+    default:
+        return EncodingText;
+    }
+}
+
+bool HYColumnStore::decode(const char *data, qint64 size, quint32 count, Encoding encoding, qint64 start, qint64 end,
+                           QVector<Sample> *samples)
+{
+    BitReader reader(data, size);
+    quint64 bits;
+    qint64 timestamp = 0;
+    qint64 delta = 0;
+    quint64 value = 0;
+    int leading = 0;
+    int trailing = 0;
+
+    for (quint32 i = 0; i < count; ++i) {
+        if (i == 0) {
+            if (!reader.read(64, &bits)) {
+                return false;
+            }
+            timestamp = qint64(bits);
+        } else {
+            qint64 dod;
+            if (!readDeltaOfDelta(reader, &dod)) {
+                return false;
+            }
+            delta += dod;
+            timestamp += delta;
+        }
+
+        QVariant sample;
+        if (encoding == EncodingFloat) {
+            if (i == 0) {
+                if (!reader.read(64, &value)) {
+                    return false;
+                }
+            } else {
+                bool bit;
+                if (!reader.readBit(&bit)) {
+                    return false;
+                }
+                if (bit) {
+                    if (!reader.readBit(&bit)) {
+                        return false;
+                    }
+                    if (bit) {
+                        quint64 leadingBits;
+                        quint64 significant;
+                        if (!reader.read(5, &leadingBits) || !reader.read(6, &significant)) {
+                            return false;
+                        }
+                        leading = int(leadingBits);
+                        trailing = 64 - leading - (significant == 0 ? 64 : int(significant));
+                        if (trailing < 0) {
+                            return false;
+                        }
+                    }
+                    if (!reader.read(64 - leading - trailing, &bits)) {
+                        return false;
+                    }
+                    value ^= bits << trailing;
+                }
+            }
+            sample = std::bit_cast<double>(value);
+        } else {
+            quint64 length;
+            if (!reader.read(32, &length)) {
+                return false;
+            }
+            QByteArray utf8(qsizetype(qMin(length, quint64(size))), Qt::Uninitialized);
+            for (quint64 j = 0; j < length; ++j) {
+                if (!reader.read(8, &bits)) {
+                    return false;
+                }
+                utf8[qsizetype(j)] = char(bits);
+            }
+            sample = QString::fromUtf8(utf8);
+        }
+
+        // Samples inside a chunk are strictly increasing
+        if (timestamp > end) {
+            break;
+        }
+        if (timestamp >= start) {
+            samples->append(Sample{timestamp, sample});
+        }
+    }
+    return true;
+}
+
+int HYColumnStore::seriesLocked(const QString &name)
+{
+    const auto it = m_seriesIds.constFind(name);
+    if (it != m_seriesIds.cend()) {
+        return *it;
+    }
+    const int index = m_series.size();
+    if (writeRecordLocked(RecordSeries, 0, quint32(index), 0, 0, 0, name.toUtf8()) < 0) {
+        return -1;
+    }
+    m_series.append(Series{name, {}, {}});
+    m_seriesIds.insert(name, index);
+    return index;
+}
+
+bool HYColumnStore::appendSortedLocked(int index, qint64 timestamp, const QVariant &value)
+{
+    const Encoding encoding = encodingOf(value);
+    Encoder &head = m_series[index].head;
+    if (head.count > 0 && head.encoding != encoding && !sealLocked(index)) {
+        return false;
+    }
+    head.encoding = encoding;
+    head.append(timestamp, value);
+    return head.count < quint32(ChunkSamples) || sealLocked(index);
+}
+
+bool HYColumnStore::sealLocked(int index)
+{
+    Series &series = m_series[index];
+    Encoder &head = series.head;
+    if (head.count == 0) {
+        return true;
+    }
+    const qint64 offset = writeRecordLocked(RecordChunk, head.encoding, quint32(index), head.first, head.last,
+                                            head.count, head.data);
+    if (offset < 0) {
+        return false;
+    }
+    series.chunks.append(ChunkRef{head.first, head.last, offset, quint32(head.data.size()), head.count,
+                                  checksum(head.data.constData(), head.data.size()), head.encoding});
+    ++m_chunks;
+    head.reset();
+    return true;
+}
+
+qint64 HYColumnStore::writeRecordLocked(RecordKind kind, quint8 encoding, quint32 series, qint64 first, qint64 last,
+                                        quint32 count, const QByteArray &payload)
+{
+    const RecordHeader header = {quint8(kind), encoding, checksum(payload.constData(), payload.size()), series,
+                                 first, last, count, quint32(payload.size())};
+    QByteArray record(reinterpret_cast<const char *>(&header), sizeof(header));
+    record.append(payload);
+    if (!m_file.seek(m_size) || m_file.write(record) != record.size()) {
+        // Drop whatever part of the record made it out so the next write starts on a record boundary
+        m_file.resize(m_size);
+        return -1;
+    }
+    const qint64 offset = m_size + qint64(sizeof(header));
+    m_size += record.size();
+    return offset;
+}
+
+bool HYColumnStore::loadLocked(QString *error)
+{
+    m_series.clear();
+    m_seriesIds.clear();
+    m_size = 0;
+    m_chunks = 0;
+
+    const qint64 fileSize = m_file.size();
+    qint64 position = 0;
+    while (fileSize - position >= qint64(sizeof(RecordHeader))) {
+        RecordHeader header;
+        if (!m_file.seek(position)
+            || m_file.read(reinterpret_cast<char *>(&header), sizeof(header)) != qint64(sizeof(header))) {
+            break;
+        }
+        const qint64 offset = position + qint64(sizeof(header));
+        if (header.kind < RecordSeries || header.kind > RecordClear || header.size > quint64(fileSize - offset)) {
+            break;
+        }
+
+        // Chunk payloads are checked when queried; only the tail record can be torn by a crash
+        const bool tail = offset + header.size == fileSize;
+        QByteArray payload;
+        if (header.kind != RecordChunk || tail) {
+            payload = m_file.read(header.size);
+            if (payload.size() != qsizetype(header.size)
+                || checksum(payload.constData(), payload.size()) != header.checksum) {
+                break;
+            }
+        }
+
+        if (header.kind == RecordSeries) {
+            if (header.series != quint32(m_series.size())) {
+                break;
+            }
+            const QString name = QString::fromUtf8(payload);
+            m_seriesIds.insert(name, m_series.size());
+            m_series.append(Series{name, {}, {}});
+        } else if (header.series >= quint32(m_series.size())) {
+            break;
+        } else if (header.kind == RecordChunk) {
+            if (header.encoding > EncodingText || header.count == 0) {
+                break;
+            }
+            m_series[header.series].chunks.append(ChunkRef{header.first, header.last, offset, header.size,
+                                                           header.count, header.checksum,
+                                                           Encoding(header.encoding)});
+            ++m_chunks;
+        } else {
+            QVector<ChunkRef> &chunks = m_series[header.series].chunks;
+            m_chunks -= chunks.size();
+            chunks.clear();
+        }
+        position = offset + header.size;
+    }
+
+    m_size = position;
+    if (position < fileSize && !m_file.resize(position)) {
+        if (error) {
+            *error = QString("cannot truncate '%1': %2").arg(m_path, m_file.errorString());
+        }
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,276 @@
+#ifndef HYCOLUMNSTORE_H
+#define HYCOLUMNSTORE_H
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QVariant>
+#include <QVector>
+#include <QHash>
+#include <QFile>
+#include <QMutex>
+#include <QtGlobal>
+
+/**
+ * @file columnstore.h
+ * @brief 内置列式时间序列存储头文件
+ */
+
+/**
+ * @class HYColumnStore
+ * @brief 内置列式时间序列存储
+ *
+ * 每个序列的样本按时间顺序分块，块内时间戳和值分列压缩：
+ * 时间戳按差值的差值编码，等间隔采样每个样本只占1位；浮点值与前一个值异或后只保存有效位，
+ * 不变的值只占1位（Gorilla编码）；字符串值单独成块，按长度加UTF-8保存
+ * 每个序列有一个在内存中追加的开放块，满ChunkSamples个样本后作为一条记录追加到文件末尾
+ *
+ * 文件只追加，由若干记录组成：序列定义（编号和名称）、数据块（时间范围、样本数和压缩数据）、序列清空
+ * 打开时只读取记录头建立块索引，范围查询只解码时间范围与之重叠的块
+ * 同一序列同一时间戳的值以最后写入的为准；早于开放块最新样本的乱序数据合并到开放块后重新编码
+ * 每条记录带负载的CRC16，打开时丢弃末尾不完整的记录，查询时跳过校验失败的块
+ *
+ * 开放块在flush()或close()时写入文件，此前进程崩溃会丢失最多ChunkSamples个样本/序列
+ * 数值（包括布尔值，按0和1）读出为double，其他值读出为QString
+ * 线程安全
+ */
+class HYColumnStore
+{
+public:
+    static constexpr int ChunkSamples = 1024; ///< 每块样本数
+
+    /**
+     * @struct Sample
+     * @brief 样本
+     */
+    struct Sample {
+        qint64 timestamp = 0; ///< 时间戳（毫秒）
+        QVariant value; ///< 值
+    };
+
+    /**
+     * @brief 构造函数
+     */
+    HYColumnStore();
+
+    /**
+     * @brief 析构函数，写入开放块并关闭文件
+     */
+    ~HYColumnStore();
+
+    HYColumnStore(const HYColumnStore &) = delete;
+    HYColumnStore &operator=(const HYColumnStore &) = delete;
+
+    /**
+     * @brief 打开存储文件，不存在时创建
+     * @param path 文件路径
+     * @param error 输出错误信息，可为空
+     * @return 是否成功
+     */
+    bool open(const QString &path, QString *error = nullptr);
+
+    /**
+     * @brief 写入开放块并关闭文件
+     */
+    void close();
+
+    /**
+     * @brief 检查是否已打开
+     * @return 是否已打开
+     */
+    bool isOpen() const;
+
+    /**
+     * @brief 获取文件路径
+     * @return 文件路径
+     */
+    QString path() const;
+
+    /**
+     * @brief 追加一个序列的样本
+     *
+     * 样本不必有序；一批中同一时间戳出现多次时以后面的为准
+     * @param series 序列名称
+     * @param samples 样本
+     * @return 是否成功
+     */
+    bool append(const QString &series, const QVector<Sample> &samples);
+
+    /**
+     * @brief 查询时间范围内的样本
+     * @param series 序列名称
+     * @param start 开始时间（毫秒，含）
+     * @param end 结束时间（毫秒，含）
+     * @param limit 最多返回的样本数，超出时返回最新的limit个；不大于0表示不限
+     * @return 按时间升序排列的样本
+     */
+    QVector<Sample> query(const QString &series, qint64 start, qint64 end, int limit = 0) const;
+
+    /**
+     * @brief 把所有开放块写入文件并刷新
+     * @return 是否成功
+     */
+    bool flush();
+
+    /**
+     * @brief 清空数据
+     * @param series 序列名称，为空时清空全部数据并截断文件
+     * @return 是否成功
+     */
+    bool clear(const QString &series = QString());
+
+    /**
+     * @brief 获取所有序列名称
+     * @return 序列名称
+     */
+    QStringList seriesNames() const;
+
+    /**
+     * @brief 获取已写入文件的块数
+     * @return 块数
+     */
+    int chunkCount() const;
+
+    /**
+     * @brief 获取文件大小
+     * @return 字节数
+     */
+    qint64 fileSize() const;
+
+    /**
+     * @brief 获取查询累计解码的已落盘块数
+     * @return 块数
+     */
+    quint64 decodedChunks() const;
+
+private:
+    /**
+     * @enum RecordKind
+     * @brief 记录类型
+     */
+    enum RecordKind : quint8 {
+        RecordSeries = 1, ///< 序列定义，负载为UTF-8名称
+        RecordChunk,      ///< 数据块，负载为压缩数据
+        RecordClear       ///< 序列清空，之前的块作废
+    };
+
+    /**
+     * @enum Encoding
+     * @brief 块的值编码
+     */
+    enum Encoding : quint8 {
+        EncodingFloat = 0, ///< 异或压缩的double
+        EncodingText       ///< 长度加UTF-8的字符串
+    };
+
+    /**
+     * @struct ChunkRef
+     * @brief 已落盘块的索引
+     */
+    struct ChunkRef {
+        qint64 first = 0; ///< 最早的时间戳
+        qint64 last = 0; ///< 最晚的时间戳
+        qint64 offset = 0; ///< 负载在文件中的偏移
+        quint32 size = 0; ///< 负载字节数
+        quint32 count = 0; ///< 样本数
+        quint16 checksum = 0; ///< 负载的CRC16
+        Encoding encoding = EncodingFloat; ///< 值编码
+    };
+
+    /**
+     * @struct Encoder
+     * @brief 开放块的增量编码器
+     */
+    struct Encoder {
+        QByteArray data; ///< 已编码的位流
+        int freeBits = 0; ///< 最后一个字节中未用的位数
+        quint32 count = 0; ///< 样本数
+        Encoding encoding = EncodingFloat; ///< 值编码
+        qint64 first = 0; ///< 最早的时间戳
+        qint64 last = 0; ///< 最晚的时间戳
+        qint64 delta = 0; ///< 上一个时间戳差值
+        quint64 value = 0; ///< 上一个值的二进制表示
+        int leading = -1; ///< 上一个异或值的前导零位数，-1表示尚未确定
+        int trailing = 0; ///< 上一个异或值的末尾零位数
+
+        /**
+         * @brief 追加一个样本，时间戳必须晚于last
+         */
+        void append(qint64 timestamp, const QVariant &sample);
+
+        /**
+         * @brief 追加若干位，高位在前
+         */
+        void writeBits(quint64 bits, int count);
+
+        /**
+         * @brief 清空
+         */
+        void reset();
+    };
+
+    /**
+     * @struct Series
+     * @brief 序列
+     */
+    struct Series {
+        QString name; ///< 名称
+        QVector<ChunkRef> chunks; ///< 已落盘的块，按写入顺序
+        Encoder head; ///< 开放块
+    };
+
+    /**
+     * @brief 判断值按哪种编码存储
+     */
+    static Encoding encodingOf(const QVariant &value);
+
+    /**
+     * @brief 解码一个块中时间范围内的样本
+     * @return 数据是否完整
+     */
+    static bool decode(const char *data, qint64 size, quint32 count, Encoding encoding, qint64 start, qint64 end,
+                       QVector<Sample> *samples);
+
+    /**
+     * @brief 获取或创建序列，新序列写入定义记录
+     */
+    int seriesLocked(const QString &name);
+
+    /**
+     * @brief 向开放块追加一个晚于其最新样本的样本，满或编码变化时先写入文件
+     */
+    bool appendSortedLocked(int index, qint64 timestamp, const QVariant &value);
+
+    /**
+     * @brief 把开放块作为数据块写入文件
+     */
+    bool sealLocked(int index);
+
+    /**
+     * @brief 追加一条记录
+     * @return 负载在文件中的偏移，失败时为-1
+     */
+    qint64 writeRecordLocked(RecordKind kind, quint8 encoding, quint32 series, qint64 first, qint64 last,
+                             quint32 count, const QByteArray &payload);
+
+    /**
+     * @brief 解码开放块和与时间范围重叠的已落盘块，同一时间戳以后写入的为准
+     */
+    QVector<Sample> collectLocked(const Series &series, qint64 start, qint64 end) const;
+
+    /**
+     * @brief 读取文件中的记录，重建索引
+     */
+    bool loadLocked(QString *error);
+
+    QString m_path; ///< 文件路径
+    mutable QFile m_file; ///< 存储文件
+    mutable QMutex m_mutex; ///< 保护以下成员
+    QVector<Series> m_series; ///< 按编号索引的序列
+    QHash<QString, int> m_seriesIds; ///< 序列名称到编号
+    qint64 m_size; ///< 文件中有效数据的大小
+    int m_chunks; ///< 已落盘的块数
+    mutable quint64 m_decoded; ///< 查询累计解码的块数
+};
+
+#endif // HYCOLUMNSTORE_H
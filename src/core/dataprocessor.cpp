@@ -2,12 +2,14 @@
 #include "../communication/hymodbustcpdriver.h"
 #include "tagmanager.h"
 #include "timeseriesdatabase.h"
+#include "historianwriter.h"
 
 
 HYDataProcessor::HYDataProcessor(QObject *parent) : QObject(parent),
     m_hyModbusDriver(nullptr),
     m_hyTagManager(nullptr),
     m_hyTimeSeriesDatabase(nullptr),
+    m_hyHistorianWriter(nullptr),
     m_hyCollectionTimer(nullptr),
     m_hyCollectionInterval(1000),
     m_hyVisibleUpdateInterval(100), // 可见标签更新间隔（毫秒）
@@ -125,6 +127,11 @@ void HYDataProcessor::setTimeSeriesDatabase(HYTimeSeriesDatabase *db)
 
 bool HYDataProcessor::storeHistoricalData(const QString &tagName, const QVariant &value, const QDateTime &timestamp)
 {
+    // The writer only queues the value, so the collection timer never waits on the database
+    if (m_hyHistorianWriter) {
+        return m_hyHistorianWriter->enqueue(tagName, value, timestamp.toMSecsSinceEpoch());
+    }
+
     if (!m_hyTimeSeriesDatabase) {
         return false;
     }
@@ -173,6 +180,9 @@ void HYDataProcessor::collectDataIntelligently()
                     storeHistoricalData(tagName, value, timestamp);
                     // Update last update time
                     mapping.lastUpdateTime = timestamp;
+                } else {
+                    // Keep the last value but flag it as stale
+                    m_hyTagManager->setQuality(m_hyTagManager->resolveTag(tagName), HYTagValueStore::QualityCommFailure);
                 }
             } else {
                 // Read coil
@@ -183,6 +193,9 @@ void HYDataProcessor::collectDataIntelligently()
                     storeHistoricalData(tagName, value, timestamp);
                     // Update last update time
                     mapping.lastUpdateTime = timestamp;
+                } else {
+                    // Keep the last value but flag it as stale
+                    m_hyTagManager->setQuality(m_hyTagManager->resolveTag(tagName), HYTagValueStore::QualityCommFailure);
                 }
             }
         }
@@ -227,4 +240,10 @@ void HYDataProcessor::setVisibleUpdateInterval(int interval)
 void HYDataProcessor::setHiddenUpdateInterval(int interval)
 {
     m_hyHiddenUpdateInterval = interval;
+}
+
+void HYDataProcessor::setHistorianWriter(HYHistorianWriter *writer)
+{
+    QMutexLocker locker(&m_hyMutex);
+    m_hyHistorianWriter = writer;
 }
\ No newline at end of file
@@ -14,6 +14,7 @@
 class HYModbusTcpDriver;
 class HYTagManager;
 class HYTimeSeriesDatabase;
+class HYHistorianWriter;
 
 /**
  * @file dataprocessor.h
@@ -129,6 +130,14 @@ public:
      */
     void setHiddenUpdateInterval(int interval);
 
+    /**
+     * @brief 设置异步历史写入器
+     *
+     * 设置后采集到的历史数据只放入写入器的队列，由写入线程成批写入，采集定时器不再等待数据库
+     * @param writer 已启动的写入器，为空时恢复同步写入时间序列数据库
+     */
+    void setHistorianWriter(HYHistorianWriter *writer);
+
 signals:
     /**
      * @brief 数据采集开始信号
@@ -204,6 +213,7 @@ private:
     HYModbusTcpDriver *m_hyModbusDriver; ///< Modbus TCP驱动
     HYTagManager *m_hyTagManager; ///< 标签管理器
     HYTimeSeriesDatabase *m_hyTimeSeriesDatabase; ///< 时间序列数据库
+    HYHistorianWriter *m_hyHistorianWriter; ///< 异步历史写入器
     QTimer *m_hyCollectionTimer; ///< 采集定时器
     int m_hyCollectionInterval; ///< 采集间隔
     int m_hyVisibleUpdateInterval; ///< 可见标签更新间隔
@@ -0,0 +1,404 @@
+#include "historianwriter.h"
+#include "offlinebuffer.h"
+#include "tagjournal.h"
+#include "tagvaluestore.h"
+#include <QDeadlineTimer>
+#include <QHash>
+#include <QMutexLocker>
+#include <climits>
+
+HYHistorianWriter::HYHistorianWriter()
+    : m_inFlight(0),
+      m_flushTarget(0),
+      m_running(false),
+      m_stopping(false),
+      m_startState(0),
+      m_capacity(DefaultCapacity),
+      m_batchSize(DefaultBatchSize),
+      m_flushInterval(DefaultFlushInterval),
+      m_policy(OverflowBlock),
+      m_totalFlushUs(0)
+{
+    m_clock.start();
+}
+
+HYHistorianWriter::~HYHistorianWriter()
+{
+    stop();
+}
+
+void HYHistorianWriter::setCapacity(int capacity)
+{
+    QMutexLocker locker(&m_mutex);
+    m_capacity = qMax(1, capacity);
+    m_notFull.wakeAll();
+}
+
+int HYHistorianWriter::capacity() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_capacity;
+}
+
+void HYHistorianWriter::setBatchSize(int batchSize)
+{
+    QMutexLocker locker(&m_mutex);
+    m_batchSize = qMax(1, batchSize);
+    m_wake.wakeOne();
+}
+
+int HYHistorianWriter::batchSize() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_batchSize;
+}
+
+void HYHistorianWriter::setFlushInterval(int milliseconds)
+{
+    QMutexLocker locker(&m_mutex);
+    m_flushInterval = qMax(0, milliseconds);
+    m_wake.wakeOne();
+}
+
+int HYHistorianWriter::flushInterval() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_flushInterval;
+}
+
+void HYHistorianWriter::setOverflowPolicy(OverflowPolicy policy)
+{
+    QMutexLocker locker(&m_mutex);
+    m_policy = policy;
+    m_notFull.wakeAll();
+}
+
+HYHistorianWriter::OverflowPolicy HYHistorianWriter::overflowPolicy() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_policy;
+}
+
+void HYHistorianWriter::setSpillDirectory(const QString &directory)
+{
+    QMutexLocker locker(&m_mutex);
+    m_spillDirectory = directory;
+}
+
+QString HYHistorianWriter::spillDirectory() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_spillDirectory;
+}
+
+bool HYHistorianWriter::start(const HYTimeSeriesDatabase::DatabaseConfig &config, QString *error)
+{
+    stop();
+
+    QMutexLocker locker(&m_mutex);
+    if (m_policy == OverflowSpill && m_spillDirectory.isEmpty()) {
+        if (error) {
+            *error = QString("spill directory is not set");
+        }
+        return false;
+    }
+
+    m_spill.reset(m_spillDirectory.isEmpty() ? nullptr : new HYOfflineBuffer(m_spillDirectory));
+    m_queue.clear();
+    m_enqueuedAt.clear();
+    m_inFlight = 0;
+    m_flushTarget = 0;
+    m_metrics = Metrics();
+    m_totalFlushUs = 0;
+    m_startState = 0;
+    m_stopping = false;
+
+    // The database connection belongs to the writer thread, so it is opened there
+    HYTimeSeriesDatabase::DatabaseConfig writerConfig = config;
+    writerConfig.batchSize = m_batchSize;
+    m_thread.reset(QThread::create([this, writerConfig] { run(writerConfig); }));
+    m_thread->setObjectName("HYHistorianWriter");
+    m_thread->start();
+    while (m_startState == 0) {
+        m_progress.wait(&m_mutex);
+    }
+
+    if (m_startState < 0) {
+        if (error) {
+            *error = m_startError;
+        }
+        locker.unlock();
+        m_thread->wait();
+        locker.relock();
+        m_thread.reset();
+        m_spill.reset();
+        return false;
+    }
+
+    m_running = true;
+    return true;
+}
+
+void HYHistorianWriter::stop()
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_thread) {
+        return;
+    }
+    m_running = false;
+    m_stopping = true;
+    m_wake.wakeAll();
+    m_notFull.wakeAll();
+    locker.unlock();
+
+    m_thread->wait();
+
+    locker.relock();
+    m_thread.reset();
+    m_spill.reset();
+    m_stopping = false;
+}
+
+bool HYHistorianWriter::isRunning() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_running;
+}
+
+bool HYHistorianWriter::enqueue(const QString &tagName, const QVariant &value, qint64 timestamp)
+{
+    return enqueue(QVector<HYTimeSeriesDatabase::TagSample>{{tagName, value, timestamp}});
+}
+
+bool HYHistorianWriter::enqueue(const QVector<HYTimeSeriesDatabase::TagSample> &samples)
+{
+    QMutexLocker locker(&m_mutex);
+    for (const HYTimeSeriesDatabase::TagSample &sample : samples) {
+        if (!m_running) {
+            return false;
+        }
+        if (m_queue.size() >= m_capacity) {
+            switch (m_policy) {
+            case OverflowBlock:
+                while (m_running && m_policy == OverflowBlock && m_queue.size() >= m_capacity) {
+                    m_notFull.wait(&m_mutex);
+                }
+                if (!m_running) {
+                    return false;
+                }
+                break;
+            case OverflowSpill:
+                // Half the queue goes out as one segment so spills stay large and rare
+                if (m_spill && spillLocked(qMax(1, int(m_queue.size() / 2)))) {
+                    break;
+                }
+                Q_FALLTHROUGH();
+            case OverflowDropOldest:
+                m_queue.removeFirst();
+                m_enqueuedAt.removeFirst();
+                ++m_metrics.dropped;
+                break;
+            }
+        }
+
+        m_queue.append(sample);
+        m_enqueuedAt.append(m_clock.elapsed());
+        ++m_metrics.enqueued;
+        // The writer sleeps while the queue is empty and wakes on its own once the oldest value is due
+        if (m_queue.size() == 1 || m_queue.size() == m_batchSize) {
+            m_wake.wakeOne();
+        }
+    }
+    return true;
+}
+
+bool HYHistorianWriter::flush(int timeout)
+{
+    QMutexLocker locker(&m_mutex);
+    const quint64 target = m_metrics.enqueued;
+    auto left = [this] { return m_metrics.enqueued - quint64(m_queue.size()) - quint64(m_inFlight); };
+    if (!m_thread) {
+        return left() >= target;
+    }
+
+    m_flushTarget = qMax(m_flushTarget, target);
+    m_wake.wakeOne();
+    QDeadlineTimer deadline(timeout < 0 ? QDeadlineTimer(QDeadlineTimer::Forever) : QDeadlineTimer(timeout));
+    while (left() < target) {
+        if (!m_progress.wait(&m_mutex, deadline)) {
+            return left() >= target;
+        }
+    }
+    return true;
+}
+
+HYHistorianWriter::Metrics HYHistorianWriter::metrics() const
+{
+    QMutexLocker locker(&m_mutex);
+    Metrics result = m_metrics;
+    result.queueDepth = int(m_queue.size());
+    result.inFlight = m_inFlight;
+    result.oldestAge = m_enqueuedAt.isEmpty() ? 0 : m_clock.elapsed() - m_enqueuedAt.first();
+    result.spillBacklogBytes = m_spill ? m_spill->backlogBytes() : 0;
+    return result;
+}
+
+void HYHistorianWriter::run(HYTimeSeriesDatabase::DatabaseConfig config)
+{
+    HYTimeSeriesDatabase database;
+    const bool connected = database.initialize(config);
+
+    QMutexLocker locker(&m_mutex);
+    m_startState = connected ? 1 : -1;
+    m_startError = database.connectionStatus();
+    m_progress.wakeAll();
+    if (!connected) {
+        return;
+    }
+
+    qint64 retryAt = 0;
+    bool failedWhileStopping = false;
+    for (;;) {
+        const qint64 now = m_clock.elapsed();
+        const int depth = int(m_queue.size());
+        const quint64 left = m_metrics.enqueued - quint64(depth);
+
+        if (m_stopping) {
+            // Stopping writes what it can; one failure ends the attempt and the rest is spilled or dropped
+            if (depth == 0 || failedWhileStopping) {
+                break;
+            }
+        } else if (now < retryAt) {
+            m_wake.wait(&m_mutex, ulong(retryAt - now));
+            continue;
+        } else if (depth == 0 || (depth < m_batchSize && now - m_enqueuedAt.first() < m_flushInterval
+                                  && m_flushTarget <= left)) {
+            // Spilled values go back only while the live queue is empty, so they never delay live data
+            if (depth == 0 && m_spill && m_spill->backlogBytes() > 0) {
+                const int batchSize = m_batchSize;
+                locker.unlock();
+                const int restored = restore(&database, batchSize);
+                locker.relock();
+                if (restored < 0) {
+                    retryAt = m_clock.elapsed() + RetryInterval;
+                }
+                if (restored != 0) {
+                    continue;
+                }
+            }
+            m_wake.wait(&m_mutex, depth == 0 ? ULONG_MAX : ulong(m_enqueuedAt.first() + m_flushInterval - now));
+            continue;
+        }
+
+        const int count = qMin(depth, m_batchSize);
+        const QVector<HYTimeSeriesDatabase::TagSample> batch = m_queue.mid(0, count);
+        const QVector<qint64> enqueuedAt = m_enqueuedAt.mid(0, count);
+        m_queue.remove(0, count);
+        m_enqueuedAt.remove(0, count);
+        m_inFlight = count;
+        m_notFull.wakeAll();
+        locker.unlock();
+
+        QElapsedTimer timer;
+        timer.start();
+        const bool success = database.storeTagSamples(batch);
+        const qint64 elapsedUs = timer.nsecsElapsed() / 1000;
+
+        locker.relock();
+        m_inFlight = 0;
+        recordFlushLocked(success, count, elapsedUs);
+        if (!success) {
+            // The batch goes back in front so values keep their order; the database overwrites on retry
+            m_queue = batch + m_queue;
+            m_enqueuedAt = enqueuedAt + m_enqueuedAt;
+            if (m_stopping) {
+                failedWhileStopping = true;
+            } else {
+                retryAt = m_clock.elapsed() + RetryInterval;
+            }
+        }
+        m_progress.wakeAll();
+    }
+
+    if (!m_queue.isEmpty() && !(m_spill && spillLocked(int(m_queue.size())))) {
+        m_metrics.dropped += m_queue.size();
+        m_queue.clear();
+        m_enqueuedAt.clear();
+    }
+    m_progress.wakeAll();
+}
+
+bool HYHistorianWriter::spillLocked(int count)
+{
+    // Each segment defines the names it uses, so it decodes on its own after a restart
+    QByteArray entries;
+    QHash<QString, quint32> ids;
+    for (int i = 0; i < count; ++i) {
+        const HYTimeSeriesDatabase::TagSample &sample = m_queue[i];
+        auto it = ids.constFind(sample.tagName);
+        if (it == ids.cend()) {
+            it = ids.insert(sample.tagName, quint32(ids.size()));
+            HYTagJournal::appendDefine(&entries, *it, sample.tagName, QString(), QString(), QString());
+        }
+        HYTagValue value;
+        if (HYTagValue::fromVariant(sample.value, &value)) {
+            HYTagJournal::appendValue(&entries, *it, value, sample.timestamp, HYTagValueStore::QualityGood);
+        } else {
+            HYTagJournal::appendComplex(&entries, *it, sample.value, sample.timestamp, HYTagValueStore::QualityGood);
+        }
+    }
+    if (!m_spill->spill(entries)) {
+        return false;
+    }
+    m_spill->seal();
+
+    m_queue.remove(0, count);
+    m_enqueuedAt.remove(0, count);
+    m_metrics.spilled += count;
+    return true;
+}
+
+int HYHistorianWriter::restore(HYTimeSeriesDatabase *database, int batchSize)
+{
+    QVector<HYTimeSeriesDatabase::TagSample> samples;
+    m_spill->read(batchSize, [&samples](const HYOfflineBuffer::Sample &sample) {
+        samples.append({sample.name, sample.value, sample.timestamp});
+    });
+    if (samples.isEmpty()) {
+        return 0;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    const bool success = database->storeTagSamples(samples);
+    const qint64 elapsedUs = timer.nsecsElapsed() / 1000;
+
+    // Committing deletes fully written segments; a failed batch is read again on the next attempt
+    if (success) {
+        m_spill->commit();
+    } else {
+        m_spill->rewind();
+    }
+
+    QMutexLocker locker(&m_mutex);
+    recordFlushLocked(success, int(samples.size()), elapsedUs);
+    if (!success) {
+        return -1;
+    }
+    m_metrics.restored += samples.size();
+    return int(samples.size());
+}
+
+void HYHistorianWriter::recordFlushLocked(bool success, int count, qint64 elapsedUs)
+{
+    m_metrics.lastFlushUs = elapsedUs;
+    m_metrics.maxFlushUs = qMax(m_metrics.maxFlushUs, elapsedUs);
+    if (!success) {
+        ++m_metrics.failedFlushes;
+        return;
+    }
+    ++m_metrics.flushes;
+    m_metrics.written += count;
+    m_totalFlushUs += elapsedUs;
+    m_metrics.averageFlushUs = m_totalFlushUs / qint64(m_metrics.flushes);
+}
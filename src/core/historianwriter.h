@@ -0,0 +1,247 @@
+#ifndef HYHISTORIANWRITER_H
+#define HYHISTORIANWRITER_H
+
+#include <QString>
+#include <QVariant>
+#include <QVector>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QtGlobal>
+#include <memory>
+#include "timeseriesdatabase.h"
+
+class HYOfflineBuffer;
+
+/**
+ * @file historianwriter.h
+ * @brief 异步历史写入器头文件
+ */
+
+/**
+ * @class HYHistorianWriter
+ * @brief 异步历史写入器
+ *
+ * enqueue()只把值放入有界队列后立即返回，专用的写入线程用自己的HYTimeSeriesDatabase连接成批写入：
+ * 队列达到batchSize个值，或最早的值已等待flushInterval毫秒时，取出最多batchSize个值调用storeTagSamples
+ * 写入失败时整批放回队列头，RetryInterval毫秒后重试；数据库按标签和时间戳覆盖，重试不会产生重复记录
+ *
+ * 队列满时按溢出策略处理：阻塞调用方直到写入线程腾出空间、丢弃最旧的值，
+ * 或把队列中较旧的一半作为一个段写入磁盘；磁盘上的积压在队列为空时按时间顺序成批写回数据库，
+ * 停止时未能写入的值同样写入磁盘，下次启动后继续写回
+ * 队列容量不含写入线程正在写入的一批
+ * 线程安全
+ */
+class HYHistorianWriter
+{
+public:
+    /**
+     * @enum OverflowPolicy
+     * @brief 队列满时的处理方式
+     */
+    enum OverflowPolicy {
+        OverflowBlock,      ///< 阻塞调用方直到有空间
+        OverflowDropOldest, ///< 丢弃最旧的值
+        OverflowSpill       ///< 把较旧的一半写入磁盘
+    };
+
+    static constexpr int DefaultCapacity = 100000; ///< 默认队列容量
+    static constexpr int DefaultBatchSize = 5000; ///< 默认每批最多值数
+    static constexpr int DefaultFlushInterval = 200; ///< 默认最长等待时间（毫秒）
+    static constexpr int RetryInterval = 1000; ///< 写入失败后的重试间隔（毫秒）
+
+    /**
+     * @struct Metrics
+     * @brief 运行指标
+     */
+    struct Metrics {
+        int queueDepth = 0; ///< 队列中等待的值数
+        int inFlight = 0; ///< 正在写入的值数
+        qint64 oldestAge = 0; ///< 队列中最早的值已等待的毫秒数
+        quint64 enqueued = 0; ///< 累计入队的值数
+        quint64 written = 0; ///< 累计写入数据库的值数，包括从磁盘写回的
+        quint64 dropped = 0; ///< 累计丢弃的值数
+        quint64 spilled = 0; ///< 累计写入磁盘的值数
+        quint64 restored = 0; ///< 累计从磁盘写回数据库的值数
+        qint64 spillBacklogBytes = 0; ///< 磁盘上尚未写回的字节数
+        quint64 flushes = 0; ///< 成功的写入次数
+        quint64 failedFlushes = 0; ///< 失败的写入次数
+        qint64 lastFlushUs = 0; ///< 最近一次写入的耗时（微秒）
+        qint64 maxFlushUs = 0; ///< 最长一次写入的耗时（微秒）
+        qint64 averageFlushUs = 0; ///< 成功写入的平均耗时（微秒）
+    };
+
+    /**
+     * @brief 构造函数
+     */
+    HYHistorianWriter();
+
+    /**
+     * @brief 析构函数，停止写入线程
+     */
+    ~HYHistorianWriter();
+
+    HYHistorianWriter(const HYHistorianWriter &) = delete;
+    HYHistorianWriter &operator=(const HYHistorianWriter &) = delete;
+
+    /**
+     * @brief 设置队列容量
+     * @param capacity 最多等待的值数
+     */
+    void setCapacity(int capacity);
+
+    /**
+     * @brief 获取队列容量
+     * @return 值数
+     */
+    int capacity() const;
+
+    /**
+     * @brief 设置每批最多值数
+     * @param batchSize 值数，同时作为数据库的batchSize
+     */
+    void setBatchSize(int batchSize);
+
+    /**
+     * @brief 获取每批最多值数
+     * @return 值数
+     */
+    int batchSize() const;
+
+    /**
+     * @brief 设置最长等待时间
+     * @param milliseconds 不满一批的值最多等待的毫秒数
+     */
+    void setFlushInterval(int milliseconds);
+
+    /**
+     * @brief 获取最长等待时间
+     * @return 毫秒数
+     */
+    int flushInterval() const;
+
+    /**
+     * @brief 设置溢出策略
+     * @param policy 溢出策略
+     */
+    void setOverflowPolicy(OverflowPolicy policy);
+
+    /**
+     * @brief 获取溢出策略
+     * @return 溢出策略
+     */
+    OverflowPolicy overflowPolicy() const;
+
+    /**
+     * @brief 设置溢出段目录，下次启动时生效
+     * @param directory 目录，为空时不写入磁盘，OverflowSpill不可用，停止时未写入的值被丢弃
+     */
+    void setSpillDirectory(const QString &directory);
+
+    /**
+     * @brief 获取溢出段目录
+     * @return 目录
+     */
+    QString spillDirectory() const;
+
+    /**
+     * @brief 启动写入线程
+     *
+     * 等待写入线程用config打开自己的数据库连接；config.batchSize被batchSize()代替
+     * @param config 数据库配置，SQLite的:memory:数据库只对写入线程可见
+     * @param error 输出错误信息，可为空
+     * @return 是否成功
+     */
+    bool start(const HYTimeSeriesDatabase::DatabaseConfig &config, QString *error = nullptr);
+
+    /**
+     * @brief 停止写入线程
+     *
+     * 先写入队列中的全部值；写入失败时剩余的值写入磁盘，没有溢出段目录时丢弃
+     */
+    void stop();
+
+    /**
+     * @brief 检查写入线程是否在运行
+     * @return 是否在运行
+     */
+    bool isRunning() const;
+
+    /**
+     * @brief 把一个值放入队列
+     * @param tagName 标签名称
+     * @param value 标签值
+     * @param timestamp 时间戳（毫秒）
+     * @return 是否入队，未运行或阻塞期间停止时为false
+     */
+    bool enqueue(const QString &tagName, const QVariant &value, qint64 timestamp);
+
+    /**
+     * @brief 把一批值放入队列
+     * @param samples 标签值
+     * @return 是否全部入队
+     */
+    bool enqueue(const QVector<HYTimeSeriesDatabase::TagSample> &samples);
+
+    /**
+     * @brief 立即写入队列中的全部值并等待完成
+     * @param timeout 最长等待毫秒数，负数表示一直等待
+     * @return 调用时队列中的值是否都已离开队列（写入、丢弃或写入磁盘）
+     */
+    bool flush(int timeout = -1);
+
+    /**
+     * @brief 获取运行指标
+     * @return 指标
+     */
+    Metrics metrics() const;
+
+private:
+    /**
+     * @brief 写入线程主循环
+     */
+    void run(HYTimeSeriesDatabase::DatabaseConfig config);
+
+    /**
+     * @brief 把队列最前面的count个值写入磁盘
+     * @return 是否成功
+     */
+    bool spillLocked(int count);
+
+    /**
+     * @brief 从磁盘读出一批积压写回数据库
+     * @return 写回的值数，没有积压时为0，写入失败时为-1
+     */
+    int restore(HYTimeSeriesDatabase *database, int batchSize);
+
+    /**
+     * @brief 记录一次写入的结果
+     */
+    void recordFlushLocked(bool success, int count, qint64 elapsedUs);
+
+    mutable QMutex m_mutex; ///< 保护以下成员
+    QWaitCondition m_wake; ///< 唤醒写入线程
+    QWaitCondition m_notFull; ///< 队列有空间
+    QWaitCondition m_progress; ///< 启动完成或一批写入完成
+    QVector<HYTimeSeriesDatabase::TagSample> m_queue; ///< 等待写入的值
+    QElapsedTimer m_clock; ///< 单调时钟
+    QVector<qint64> m_enqueuedAt; ///< 每个值入队的时刻（m_clock毫秒）
+    int m_inFlight; ///< 正在写入的值数
+    quint64 m_flushTarget; ///< 需要立即写入的入队序号上限
+    std::unique_ptr<QThread> m_thread; ///< 写入线程
+    std::unique_ptr<HYOfflineBuffer> m_spill; ///< 溢出段
+    bool m_running; ///< 是否接受入队
+    bool m_stopping; ///< 是否正在停止
+    int m_startState; ///< 启动结果：0等待，1成功，-1失败
+    QString m_startError; ///< 启动失败的原因
+    int m_capacity; ///< 队列容量
+    int m_batchSize; ///< 每批最多值数
+    int m_flushInterval; ///< 最长等待时间
+    OverflowPolicy m_policy; ///< 溢出策略
+    QString m_spillDirectory; ///< 溢出段目录
+    Metrics m_metrics; ///< 累计指标
+    qint64 m_totalFlushUs; ///< 成功写入的累计耗时
+};
+
+#endif // HYHISTORIANWRITER_H
@@ -0,0 +1,242 @@
+#include "jsonstreamreader.h"
+#include <cstring>
+
+HYJsonStreamReader::HYJsonStreamReader()
+    : m_position(0),
+      m_token(Incomplete),
+      m_bool(false),
+      m_finished(false),
+      m_done(false)
+{
+}
+
+void HYJsonStreamReader::addData(const QByteArray &data)
+{
+    // Consumed bytes are dropped here rather than per token, so a large chunk is not shifted once per token
+    if (m_position > 0) {
+        m_buffer.remove(0, m_position);
+        m_position = 0;
+    }
+    m_buffer.append(data);
+}
+
+void HYJsonStreamReader::finish()
+{
+    m_finished = true;
+}
+
+void HYJsonStreamReader::clear()
+{
+    m_buffer.clear();
+    m_position = 0;
+    m_stack.clear();
+    m_expectName.clear();
+    m_token = Incomplete;
+    m_text.clear();
+    m_number.clear();
+    m_bool = false;
+    m_finished = false;
+    m_done = false;
+    m_error.clear();
+}
+
+HYJsonStreamReader::TokenType HYJsonStreamReader::readNext()
+{
+    if (m_token == Invalid) {
+        return Invalid;
+    }
+
+    // Separators only matter for telling keys from values, which the object state already tracks
+    const qsizetype size = m_buffer.size();
+    while (m_position < size) {
+        const char c = m_buffer.at(m_position);
+        if (c == ',') {
+            if (!m_stack.isEmpty() && m_stack.last() == '{') {
+                m_expectName.last() = true;
+            }
+        } else if (c != ':' && c != ' ' && c != '\t' && c != '\n' && c != '\r') {
+            break;
+        }
+        ++m_position;
+    }
+    if (m_position == size) {
+        return m_token = Incomplete;
+    }
+    if (m_done) {
+        return fail(QString("unexpected data after the document"));
+    }
+
+    const char c = m_buffer.at(m_position);
+    switch (c) {
+    case '{':
+    case '[':
+        m_stack.append(c);
+        m_expectName.append(c == '{');
+        ++m_position;
+        return m_token = (c == '{' ? StartObject : StartArray);
+    case '}':
+    case ']':
+        if (m_stack.isEmpty() || m_stack.last() != (c == '}' ? '{' : '[')) {
+            return fail(QString("mismatched '%1' at offset %2").arg(QLatin1Char(c)).arg(m_position));
+        }
+        m_stack.removeLast();
+        m_expectName.removeLast();
+        ++m_position;
+        m_done = m_stack.isEmpty();
+        return m_token = (c == '}' ? EndObject : EndArray);
+    case '"': {
+        if (!readString()) {
+            return m_token == Invalid ? Invalid : (m_token = Incomplete);
+        }
+        m_done = m_stack.isEmpty();
+        if (!m_stack.isEmpty() && m_stack.last() == '{' && m_expectName.last()) {
+            m_expectName.last() = false;
+            return m_token = Name;
+        }
+        return m_token = String;
+    }
+    case 't':
+    case 'f':
+    case 'n': {
+        const char *word = c == 't' ? "true" : (c == 'f' ? "false" : "null");
+        const qsizetype length = qsizetype(std::strlen(word));
+        const qsizetype available = qMin(length, size - m_position);
+        if (std::memcmp(m_buffer.constData() + m_position, word, size_t(available)) != 0) {
+            return fail(QString("invalid literal at offset %1").arg(m_position));
+        }
+        if (available < length) {
+            return m_finished ? fail(QString("truncated literal at offset %1").arg(m_position)) : (m_token = Incomplete);
+        }
+        m_position += length;
+        m_done = m_stack.isEmpty();
+        m_bool = c == 't';
+        return m_token = (c == 'n' ? Null : Bool);
+    }
+    default:
+        break;
+    }
+
+    if (c == '-' || (c >= '0' && c <= '9')) {
+        // A number running to the end of the buffer may continue in the next chunk
+        qsizetype end = m_position;
+        auto isNumberChar = [](char ch) {
+            return (ch >= '0' && ch <= '9') || ch == '-' || ch == '+' || ch == '.' || ch == 'e' || ch == 'E';
+        };
+        while (end < size && isNumberChar(m_buffer.at(end))) {
+            ++end;
+        }
+        if (end == size && !m_finished) {
+            return m_token = Incomplete;
+        }
+        m_number = m_buffer.mid(m_position, end - m_position);
+        bool ok = false;
+        m_number.toDouble(&ok);
+        if (!ok) {
+            return fail(QString("invalid number at offset %1").arg(m_position));
+        }
+        m_position = end;
+        m_done = m_stack.isEmpty();
+        return m_token = Number;
+    }
+
+    return fail(QString("unexpected character at offset %1").arg(m_position));
+}
+
+QVariant HYJsonStreamReader::value() const
+{
+    switch (m_token) {
+    case Name:
+    case String:
+        return m_text;
+    case Number: {
+        // Integers keep full precision, which matters for nanosecond timestamps
+        if (!m_number.contains('.') && !m_number.contains('e') && !m_number.contains('E')) {
+            bool ok = false;
+            const qint64 integer = m_number.toLongLong(&ok);
+            if (ok) {
+                return integer;
+            }
+        }
+        return m_number.toDouble();
+    }
+    case Bool:
+        return m_bool;
+    default:
+        return QVariant();
+    }
+}
+
+bool HYJsonStreamReader::atEnd() const
+{
+    return m_done;
+}
+
+bool HYJsonStreamReader::readString()
+{
+    // Find the closing quote first so an incomplete string leaves the position untouched
+    const qsizetype size = m_buffer.size();
+    qsizetype end = m_position + 1;
+    while (end < size && m_buffer.at(end) != '"') {
+        end += m_buffer.at(end) == '\\' ? 2 : 1;
+    }
+    if (end >= size) {
+        if (m_finished) {
+            fail(QString("unterminated string at offset %1").arg(m_position));
+        }
+        return false;
+    }
+
+    m_text.clear();
+    const char *data = m_buffer.constData();
+    qsizetype run = m_position + 1;
+    for (qsizetype i = run; i < end; ++i) {
+        if (data[i] != '\\') {
+            continue;
+        }
+        m_text.append(QString::fromUtf8(data + run, i - run));
+        const char escape = data[i + 1];
+        switch (escape) {
+        case 'b':
+            m_text.append(QLatin1Char('\b'));
+            break;
+        case 'f':
+            m_text.append(QLatin1Char('\f'));
+            break;
+        case 'n':
+            m_text.append(QLatin1Char('\n'));
+            break;
+        case 'r':
+            m_text.append(QLatin1Char('\r'));
+            break;
+        case 't':
+            m_text.append(QLatin1Char('\t'));
+            break;
+        case 'u': {
+            // Surrogate pairs arrive as two escapes and combine in the UTF-16 string
+            bool ok = false;
+            const ushort unit = i + 6 <= end ? QByteArray(data + i + 2, 4).toUShort(&ok, 16) : 0;
+            if (!ok) {
+                fail(QString("invalid escape at offset %1").arg(i));
+                return false;
+            }
+            m_text.append(QChar(unit));
+            i += 4;
+            break;
+        }
+        default:
+            m_text.append(QLatin1Char(escape));
+            break;
+        }
+        ++i;
+        run = i + 1;
+    }
+    m_text.append(QString::fromUtf8(data + run, end - run));
+    m_position = end + 1;
+    return true;
+}
+
+HYJsonStreamReader::TokenType HYJsonStreamReader::fail(const QString &error)
+{
+    m_error = error;
+    return m_token = Invalid;
+}
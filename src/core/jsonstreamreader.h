@@ -0,0 +1,141 @@
+#ifndef HYJSONSTREAMREADER_H
+#define HYJSONSTREAMREADER_H
+
+#include <QString>
+#include <QByteArray>
+#include <QVariant>
+#include <QVector>
+#include <QtGlobal>
+
+/**
+ * @file jsonstreamreader.h
+ * @brief 流式JSON读取器头文件
+ */
+
+/**
+ * @class HYJsonStreamReader
+ * @brief 流式JSON读取器
+ *
+ * 与QXmlStreamReader用法相同：数据分块通过addData()追加，readNext()逐个返回记号，
+ * 缓冲区中的记号不完整时返回Incomplete，追加数据后继续读取；已读取的数据在追加时丢弃，
+ * 内存占用与单个记号的大小成正比，与文档大小无关
+ *
+ * 对象中的键作为Name记号返回，紧随其后的是它的值；不检查逗号和冒号的位置，
+ * 只检查括号是否匹配，括号不匹配或遇到无法识别的字符时返回Invalid并停止
+ * 非线程安全
+ */
+class HYJsonStreamReader
+{
+public:
+    /**
+     * @enum TokenType
+     * @brief 记号类型
+     */
+    enum TokenType {
+        Incomplete,  ///< 需要更多数据
+        Invalid,     ///< 格式错误
+        StartObject, ///< 对象开始
+        EndObject,   ///< 对象结束
+        StartArray,  ///< 数组开始
+        EndArray,    ///< 数组结束
+        Name,        ///< 对象的键
+        String,      ///< 字符串
+        Number,      ///< 数值
+        Bool,        ///< 布尔值
+        Null         ///< null
+    };
+
+    /**
+     * @brief 构造函数
+     */
+    HYJsonStreamReader();
+
+    /**
+     * @brief 追加数据
+     * @param data 文档的下一段，可在任意字节处截断
+     */
+    void addData(const QByteArray &data);
+
+    /**
+     * @brief 声明没有更多数据，此后文档末尾的数值不再等待后续数字
+     */
+    void finish();
+
+    /**
+     * @brief 清空状态，开始读取新文档
+     */
+    void clear();
+
+    /**
+     * @brief 读取下一个记号
+     * @return 记号类型
+     */
+    TokenType readNext();
+
+    /**
+     * @brief 获取当前记号类型
+     * @return 记号类型
+     */
+    TokenType tokenType() const { return m_token; }
+
+    /**
+     * @brief 获取当前记号所在的嵌套深度
+     * @return 深度，顶层为0，StartObject/StartArray之后加1，EndObject/EndArray之后减1
+     */
+    int depth() const { return int(m_stack.size()); }
+
+    /**
+     * @brief 获取Name或String记号的文本
+     * @return 文本
+     */
+    const QString &text() const { return m_text; }
+
+    /**
+     * @brief 获取标量记号的值
+     * @return 整数在qint64范围内时为qint64，其他数值为double，字符串为QString，布尔值为bool，null为空值
+     */
+    QVariant value() const;
+
+    /**
+     * @brief 检查文档是否已完整读取
+     * @return 顶层值是否已结束
+     */
+    bool atEnd() const;
+
+    /**
+     * @brief 检查是否有格式错误
+     * @return 是否有错误
+     */
+    bool hasError() const { return m_token == Invalid; }
+
+    /**
+     * @brief 获取错误信息
+     * @return 错误信息
+     */
+    QString errorString() const { return m_error; }
+
+private:
+    /**
+     * @brief 读取从m_position开始的字符串，不完整时返回false且不移动位置
+     */
+    bool readString();
+
+    /**
+     * @brief 设置错误并返回Invalid
+     */
+    TokenType fail(const QString &error);
+
+    QByteArray m_buffer; ///< 未读取的数据
+    qsizetype m_position; ///< 下一个记号在缓冲区中的位置
+    QVector<char> m_stack; ///< 未结束的对象和数组，'{'或'['
+    QVector<bool> m_expectName; ///< 每层对象的下一个字符串是否为键
+    TokenType m_token; ///< 当前记号
+    QString m_text; ///< 当前Name或String的文本
+    QByteArray m_number; ///< 当前数值的文本
+    bool m_bool; ///< 当前布尔值
+    bool m_finished; ///< 是否没有更多数据
+    bool m_done; ///< 顶层值是否已结束
+    QString m_error; ///< 错误信息
+};
+
+#endif // HYJSONSTREAMREADER_H
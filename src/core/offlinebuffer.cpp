@@ -0,0 +1,529 @@
+#include "offlinebuffer.h"
+#include "tagjournal.h"
+#include <QDir>
+#include <QSaveFile>
+#include <QHash>
+#include <QSet>
+#include <cstring>
+
+/**
+ * @file offlinebuffer.cpp
+ * @brief 离线数据缓冲区实现
+ *
+ * 段文件：16字节的文件头（标识、版本、降采样级数、保留），随后是HYTagJournal格式的块
+ * 每个进程只追加自己创建的段，因此段内的点位句柄含义一致
+ * 检查点文件：4字节标识、32位版本号、64位段序号、64位段内偏移
+ */
+
+namespace {
+
+const char SegmentMagic[] = "HYOB"; ///< 段文件标识
+const char CheckpointMagic[] = "HYOC"; ///< 检查点文件标识
+constexpr quint32 SegmentVersion = 1; ///< 文件格式版本
+constexpr int SegmentHeaderSize = 16; ///< 文件头字节数
+constexpr qint64 MinSegmentBytes = qint64(64) << 10; ///< 段大小下限
+constexpr qint64 MaxSegmentBytes = qint64(64) << 20; ///< 段大小上限
+constexpr int BlockHeaderSize = 8; ///< 块头字节数
+constexpr qint64 DrainBatch = 65536; ///< drain()每次读出的条数
+
+/**
+ * @brief 生成段文件头
+ * @param level 降采样级数
+ * @return 文件头
+ */
+QByteArray segmentHeader(int level)
+{
+    const quint32 fields[3] = {SegmentVersion, quint32(level), 0};
+    QByteArray header(SegmentMagic, 4);
+    header.append(reinterpret_cast<const char *>(fields), sizeof(fields));
+    return header;
+}
+
+/**
+ * @brief 读取段文件头
+ * @param data 文件内容，至少包含文件头
+ * @param level 输出降采样级数
+ * @return 文件头是否有效
+ */
+bool readSegmentHeader(const QByteArray &data, int *level)
+{
+    if (data.size() < SegmentHeaderSize || std::memcmp(data.constData(), SegmentMagic, 4) != 0) {
+        return false;
+    }
+    quint32 fields[3];
+    std::memcpy(fields, data.constData() + 4, sizeof(fields));
+    if (fields[0] != SegmentVersion) {
+        return false;
+    }
+    *level = int(fields[1]);
+    return true;
+}
+
+} // namespace
+
+HYOfflineBuffer::HYOfflineBuffer(const QString &directory) :
+    m_directory(directory),
+    m_diskLimit(DefaultDiskBytes),
+    m_policy(EvictOldest),
+    m_opened(false),
+    m_nextSequence(1),
+    m_diskSize(0),
+    m_evictedBytes(0)
+{
+}
+
+HYOfflineBuffer::~HYOfflineBuffer()
+{
+    m_file.close();
+}
+
+void HYOfflineBuffer::setDirectory(const QString &directory)
+{
+    QMutexLocker locker(&m_mutex);
+    if (directory == m_directory) {
+        return;
+    }
+    m_file.close();
+    m_reader.close();
+    m_segments.clear();
+    m_readPosition = Position();
+    m_committed = Position();
+    m_diskSize = 0;
+    m_opened = false;
+    m_nextSequence = 1;
+    m_directory = directory;
+}
+
+QString HYOfflineBuffer::directory() const
+{
+    QMutexLocker locker(const_cast<QMutex *>(&m_mutex));
+    return m_directory;
+}
+
+void HYOfflineBuffer::setDiskLimit(qint64 bytes)
+{
+    QMutexLocker locker(&m_mutex);
+    m_diskLimit = qMax<qint64>(bytes, 0);
+    while (m_diskSize > m_diskLimit && evictLocked()) {
+    }
+}
+
+qint64 HYOfflineBuffer::diskLimit() const
+{
+    QMutexLocker locker(const_cast<QMutex *>(&m_mutex));
+    return m_diskLimit;
+}
+
+void HYOfflineBuffer::setEvictionPolicy(EvictionPolicy policy)
+{
+    QMutexLocker locker(&m_mutex);
+    m_policy = policy;
+}
+
+HYOfflineBuffer::EvictionPolicy HYOfflineBuffer::evictionPolicy() const
+{
+    QMutexLocker locker(const_cast<QMutex *>(&m_mutex));
+    return m_policy;
+}
+
+bool HYOfflineBuffer::spill(const QByteArray &entries)
+{
+    if (entries.isEmpty()) {
+        return true;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    openLocked();
+
+    // Segments stay small relative to the limit so that eviction frees space in modest steps
+    const qint64 segmentBytes = qBound(MinSegmentBytes, m_diskLimit / 8, MaxSegmentBytes);
+    if ((!m_file.isOpen() || m_segments.last().size >= segmentBytes) && !startSegmentLocked()) {
+        return false;
+    }
+
+    const QByteArray header = HYTagJournal::blockHeader(entries);
+    if (m_file.write(header) != header.size() || m_file.write(entries) != entries.size() || !m_file.flush()) {
+        return false;
+    }
+    const qint64 written = header.size() + entries.size();
+    m_segments.last().size += written;
+    m_diskSize += written;
+
+    while (m_diskSize > m_diskLimit && evictLocked()) {
+    }
+    return true;
+}
+
+void HYOfflineBuffer::seal()
+{
+    QMutexLocker locker(&m_mutex);
+    openLocked();
+    m_file.close();
+}
+
+qint64 HYOfflineBuffer::read(qint64 maxSamples, const std::function<void(const Sample &)> &visitor)
+{
+    QMutexLocker locker(&m_mutex);
+    openLocked();
+
+    qint64 count = 0;
+    while (count < maxSamples) {
+        // The segment still being written is left alone until it is sealed
+        auto it = m_segments.lowerBound(m_readPosition.sequence);
+        if (it == m_segments.end() || (m_file.isOpen() && it.key() == m_segments.lastKey())) {
+            break;
+        }
+        if (it.key() != m_readPosition.sequence) {
+            m_readPosition = Position{it.key(), SegmentHeaderSize};
+        }
+
+        const QString path = segmentPath(it.key());
+        if (!m_reader.isOpen() || m_reader.fileName() != path) {
+            m_reader.close();
+            m_reader.setFileName(path);
+            m_reader.open(QIODevice::ReadOnly);
+        }
+        QByteArray block;
+        if (m_reader.isOpen() && m_reader.seek(m_readPosition.offset)) {
+            block = m_reader.read(BlockHeaderSize);
+            quint32 length = 0;
+            if (block.size() == BlockHeaderSize) {
+                std::memcpy(&length, block.constData(), sizeof(length));
+            }
+            if (length > 0 && length <= MaxSegmentBytes) {
+                block.append(m_reader.read(length));
+            }
+            if (block.size() != BlockHeaderSize + qint64(length) || length == 0) {
+                block.clear();
+            }
+        }
+
+        // The end of a segment, or a block torn by a crash, moves the position on to the next segment
+        qint64 end = 0;
+        const qint64 decoded = block.isEmpty() ? 0 : decodeSegment(segmentHeader(0) + block, visitor, &end);
+        if (block.isEmpty() || end != SegmentHeaderSize + block.size()) {
+            m_readPosition = Position{it.key() + 1, SegmentHeaderSize};
+            continue;
+        }
+        count += decoded;
+        m_readPosition.offset += block.size();
+    }
+    return count;
+}
+
+bool HYOfflineBuffer::commit()
+{
+    QMutexLocker locker(&m_mutex);
+    openLocked();
+    m_committed = m_readPosition;
+
+    // Consumed segments are removed only after the position that skips them is on disk
+    const quint32 version = SegmentVersion;
+    QDir().mkpath(m_directory);
+    QSaveFile file(checkpointPath());
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    file.write(CheckpointMagic, 4);
+    file.write(reinterpret_cast<const char *>(&version), sizeof(version));
+    file.write(reinterpret_cast<const char *>(&m_committed.sequence), sizeof(m_committed.sequence));
+    file.write(reinterpret_cast<const char *>(&m_committed.offset), sizeof(m_committed.offset));
+    if (!file.commit()) {
+        return false;
+    }
+
+    for (auto it = m_segments.begin(); it != m_segments.end() && it.key() < m_committed.sequence;) {
+        if (m_reader.fileName() == segmentPath(it.key())) {
+            m_reader.close();
+        }
+        QFile::remove(segmentPath(it.key()));
+        m_diskSize -= it->size;
+        it = m_segments.erase(it);
+    }
+    return true;
+}
+
+void HYOfflineBuffer::rewind()
+{
+    QMutexLocker locker(&m_mutex);
+    m_readPosition = m_committed;
+}
+
+qint64 HYOfflineBuffer::drain(const std::function<void(const Sample &)> &visitor)
+{
+    seal();
+    qint64 count = 0;
+    for (qint64 batch = read(DrainBatch, visitor); batch > 0; batch = read(DrainBatch, visitor)) {
+        count += batch;
+    }
+    commit();
+    return count;
+}
+
+qint64 HYOfflineBuffer::decode(const QByteArray &entries, const std::function<void(const Sample &)> &visitor)
+{
+    return decodeSegment(segmentHeader(0) + HYTagJournal::blockHeader(entries) + entries, visitor);
+}
+
+qint64 HYOfflineBuffer::diskSize() const
+{
+    QMutexLocker locker(const_cast<QMutex *>(&m_mutex));
+    return m_diskSize;
+}
+
+qint64 HYOfflineBuffer::backlogBytes() const
+{
+    QMutexLocker locker(const_cast<QMutex *>(&m_mutex));
+    qint64 bytes = 0;
+    for (auto it = m_segments.constBegin(); it != m_segments.constEnd(); ++it) {
+        if (it.key() > m_readPosition.sequence) {
+            bytes += it->size;
+        } else if (it.key() == m_readPosition.sequence) {
+            bytes += qMax<qint64>(it->size - m_readPosition.offset, 0);
+        }
+    }
+    return bytes;
+}
+
+int HYOfflineBuffer::segmentCount() const
+{
+    QMutexLocker locker(const_cast<QMutex *>(&m_mutex));
+    return int(m_segments.size());
+}
+
+qint64 HYOfflineBuffer::evictedBytes() const
+{
+    QMutexLocker locker(const_cast<QMutex *>(&m_mutex));
+    return m_evictedBytes;
+}
+
+void HYOfflineBuffer::openLocked()
+{
+    if (m_opened) {
+        return;
+    }
+    m_opened = true;
+
+    // Segments left by an earlier run are kept for the next drain; this run never appends to them
+    const QDir dir(m_directory);
+    const QStringList files = dir.entryList(QStringList() << QStringLiteral("offline.*.seg"), QDir::Files);
+    for (const QString &fileName : files) {
+        bool ok = false;
+        const quint64 sequence = fileName.section(QLatin1Char('.'), 1, 1).toULongLong(&ok);
+        QFile file(dir.filePath(fileName));
+        int level = 0;
+        if (!ok || !file.open(QIODevice::ReadOnly) || !readSegmentHeader(file.read(SegmentHeaderSize), &level)) {
+            continue;
+        }
+        m_segments.insert(sequence, Segment{file.size(), level});
+        m_diskSize += file.size();
+        m_nextSequence = qMax(m_nextSequence, sequence + 1);
+    }
+
+    // Resume from the committed position; segments before it were consumed but not yet removed
+    QFile checkpoint(checkpointPath());
+    if (checkpoint.open(QIODevice::ReadOnly)) {
+        const QByteArray data = checkpoint.read(24);
+        quint32 version = 0;
+        if (data.size() == 24 && std::memcmp(data.constData(), CheckpointMagic, 4) == 0) {
+            std::memcpy(&version, data.constData() + 4, sizeof(version));
+        }
+        if (version == SegmentVersion) {
+            std::memcpy(&m_committed.sequence, data.constData() + 8, sizeof(m_committed.sequence));
+            std::memcpy(&m_committed.offset, data.constData() + 16, sizeof(m_committed.offset));
+            m_readPosition = m_committed;
+
+            // A new segment must not reuse the sequence the position points into
+            m_nextSequence = qMax(m_nextSequence, m_committed.sequence + 1);
+            for (auto it = m_segments.begin(); it != m_segments.end() && it.key() < m_committed.sequence;) {
+                QFile::remove(segmentPath(it.key()));
+                m_diskSize -= it->size;
+                it = m_segments.erase(it);
+            }
+        }
+    }
+}
+
+bool HYOfflineBuffer::startSegmentLocked()
+{
+    m_file.close();
+    QDir().mkpath(m_directory);
+
+    const quint64 sequence = m_nextSequence++;
+    m_file.setFileName(segmentPath(sequence));
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+    const QByteArray header = segmentHeader(0);
+    if (m_file.write(header) != header.size()) {
+        m_file.close();
+        QFile::remove(segmentPath(sequence));
+        return false;
+    }
+    m_segments.insert(sequence, Segment{header.size(), 0});
+    m_diskSize += header.size();
+    return true;
+}
+
+bool HYOfflineBuffer::evictLocked()
+{
+    if (m_segments.isEmpty()) {
+        return false;
+    }
+
+    // The segment being written is closed once it is the only one left; the next spill starts another
+    auto end = m_file.isOpen() ? std::prev(m_segments.end()) : m_segments.end();
+    if (end == m_segments.begin()) {
+        m_file.close();
+        end = m_segments.end();
+    }
+
+    // Downsampling works oldest first and falls back to dropping once a segment cannot shrink further
+    if (m_policy == EvictDownsample) {
+        for (auto it = m_segments.begin(); it != end; ++it) {
+            if (it->level >= MaxDownsampleLevel) {
+                continue;
+            }
+            if (downsampleLocked(it.key())) {
+                return true;
+            }
+            it->level = MaxDownsampleLevel;
+        }
+    }
+
+    auto oldest = m_segments.begin();
+    if (m_reader.fileName() == segmentPath(oldest.key())) {
+        m_reader.close();
+    }
+    QFile::remove(segmentPath(oldest.key()));
+    m_diskSize -= oldest->size;
+    m_evictedBytes += oldest->size;
+    m_segments.erase(oldest);
+    return true;
+}
+
+bool HYOfflineBuffer::downsampleLocked(quint64 sequence)
+{
+    QFile file(segmentPath(sequence));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    const QByteArray data = file.readAll();
+    file.close();
+    int level = 0;
+    if (!readSegmentHeader(data, &level)) {
+        return false;
+    }
+
+    // Keep every definition once and every other value of each tag
+    QByteArray entries;
+    QSet<quint32> defined;
+    QHash<quint32, quint32> seen;
+    HYTagJournal::decodeBlocks(data, SegmentHeaderSize, [&](const HYTagJournal::Entry &entry) {
+        switch (entry.kind) {
+        case HYTagJournal::EntryDefine:
+            if (!defined.contains(entry.id)) {
+                defined.insert(entry.id);
+                HYTagJournal::appendDefine(&entries, entry.id, entry.name, QString(), QString(), QString());
+            }
+            break;
+        case HYTagJournal::EntryValue:
+            if ((seen[entry.id]++ & 1) == 0) {
+                HYTagJournal::appendValue(&entries, entry.id, entry.value, entry.timestamp, entry.quality);
+            }
+            break;
+        case HYTagJournal::EntryComplex:
+            if ((seen[entry.id]++ & 1) == 0) {
+                HYTagJournal::appendComplex(&entries, entry.id, entry.complex, entry.timestamp, entry.quality);
+            }
+            break;
+        default:
+            break;
+        }
+    });
+
+    const qint64 size = SegmentHeaderSize + HYTagJournal::blockHeader(entries).size() + entries.size();
+    Segment &segment = m_segments[sequence];
+    if (size >= segment.size) {
+        return false;
+    }
+
+    QSaveFile output(segmentPath(sequence));
+    if (!output.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    output.write(segmentHeader(level + 1));
+    output.write(HYTagJournal::blockHeader(entries));
+    output.write(entries);
+    if (!output.commit()) {
+        return false;
+    }
+
+    m_diskSize -= segment.size - size;
+    m_evictedBytes += segment.size - size;
+    segment.size = size;
+    segment.level = level + 1;
+
+    // Offsets into the old file are meaningless now; a reader inside it starts the segment over
+    if (m_reader.fileName() == segmentPath(sequence)) {
+        m_reader.close();
+    }
+    for (Position *position : {&m_readPosition, &m_committed}) {
+        if (position->sequence == sequence) {
+            position->offset = SegmentHeaderSize;
+        }
+    }
+    return true;
+}
+
+QString HYOfflineBuffer::segmentPath(quint64 sequence) const
+{
+    return QDir(m_directory).filePath(QStringLiteral("offline.%1.seg").arg(sequence));
+}
+
+QString HYOfflineBuffer::checkpointPath() const
+{
+    return QDir(m_directory).filePath(QStringLiteral("offline.checkpoint"));
+}
+
+qint64 HYOfflineBuffer::decodeSegment(const QByteArray &data, const std::function<void(const Sample &)> &visitor,
+                                      qint64 *end)
+{
+    int level = 0;
+    if (!readSegmentHeader(data, &level)) {
+        return 0;
+    }
+
+    // Handles are resolved through the definitions written with them
+    qint64 count = 0;
+    QHash<quint32, QString> names;
+    Sample sample;
+    const qint64 decoded = HYTagJournal::decodeBlocks(data, SegmentHeaderSize, [&](const HYTagJournal::Entry &entry) {
+        switch (entry.kind) {
+        case HYTagJournal::EntryDefine:
+            names.insert(entry.id, entry.name);
+            return;
+        case HYTagJournal::EntryValue:
+            sample.value = entry.value.toVariant();
+            break;
+        case HYTagJournal::EntryComplex:
+            sample.value = entry.complex;
+            break;
+        default:
+            return;
+        }
+        auto name = names.constFind(entry.id);
+        if (name == names.constEnd()) {
+            return;
+        }
+        sample.name = name.value();
+        sample.timestamp = entry.timestamp;
+        sample.quality = entry.quality;
+        visitor(sample);
+        ++count;
+    });
+    if (end) {
+        *end = decoded;
+    }
+    return count;
+}
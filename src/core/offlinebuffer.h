@@ -0,0 +1,272 @@
+#ifndef HYOFFLINEBUFFER_H
+#define HYOFFLINEBUFFER_H
+
+#include <QString>
+#include <QByteArray>
+#include <QVariant>
+#include <QMap>
+#include <QMutex>
+#include <QFile>
+#include <QtGlobal>
+#include <functional>
+
+/**
+ * @file offlinebuffer.h
+ * @brief 离线数据缓冲区头文件
+ */
+
+/**
+ * @class HYOfflineBuffer
+ * @brief 离线数据缓冲区
+ *
+ * 离线期间的点位值变化先在各分片的内存缓冲区中按HYTagJournal的记录格式编码，
+ * 缓冲区满时整块写入磁盘上的段文件，内存占用不随离线时长增长
+ * 段文件总大小超过上限时按淘汰策略释放空间：丢弃最旧的段，或把最旧的段隔一取一地降采样
+ * 段按时间顺序逐块读出，读取位置提交后保存在检查点文件中，已读完的段随之删除；
+ * 重启后从上次提交的位置继续，提交之后读出的数据会再读一次
+ * 线程安全
+ */
+class HYOfflineBuffer
+{
+public:
+    /**
+     * @enum EvictionPolicy
+     * @brief 超过磁盘上限时的淘汰策略
+     */
+    enum EvictionPolicy {
+        EvictOldest,    ///< 丢弃最旧的段
+        EvictDownsample ///< 把最旧的段降采样，降到MaxDownsampleLevel级后再丢弃
+    };
+
+    static constexpr qint64 DefaultMemoryBytes = qint64(4) << 20; ///< 默认内存缓冲区总大小
+    static constexpr qint64 DefaultDiskBytes = qint64(1) << 30; ///< 默认磁盘上限
+    static constexpr int MaxDownsampleLevel = 4; ///< 最大降采样级数，每级保留一半的值
+
+    /**
+     * @struct Sample
+     * @brief 取出的离线数据
+     */
+    struct Sample {
+        QString name; ///< 点位名称
+        QVariant value; ///< 点位值
+        qint64 timestamp = 0; ///< 源时间戳（毫秒）
+        quint8 quality = 0; ///< 质量码
+    };
+
+    /**
+     * @brief 构造函数
+     *
+     * 不访问磁盘，首次写入或取出时才打开目录
+     * @param directory 段文件目录
+     */
+    explicit HYOfflineBuffer(const QString &directory);
+
+    /**
+     * @brief 析构函数，关闭当前段
+     */
+    ~HYOfflineBuffer();
+
+    HYOfflineBuffer(const HYOfflineBuffer &) = delete;
+    HYOfflineBuffer &operator=(const HYOfflineBuffer &) = delete;
+
+    /**
+     * @brief 设置段文件目录
+     *
+     * 已打开的目录中的段保留在原处，下次打开该目录时仍可取出
+     * @param directory 段文件目录
+     */
+    void setDirectory(const QString &directory);
+
+    /**
+     * @brief 获取段文件目录
+     * @return 段文件目录
+     */
+    QString directory() const;
+
+    /**
+     * @brief 设置磁盘上限
+     * @param bytes 段文件总字节数上限
+     */
+    void setDiskLimit(qint64 bytes);
+
+    /**
+     * @brief 获取磁盘上限
+     * @return 字节数
+     */
+    qint64 diskLimit() const;
+
+    /**
+     * @brief 设置淘汰策略
+     * @param policy 淘汰策略
+     */
+    void setEvictionPolicy(EvictionPolicy policy);
+
+    /**
+     * @brief 获取淘汰策略
+     * @return 淘汰策略
+     */
+    EvictionPolicy evictionPolicy() const;
+
+    /**
+     * @brief 把一段记录作为一个块写入当前段
+     *
+     * 记录中引用的点位句柄须在同一段记录中有定义记录；写入后超过磁盘上限时立即淘汰
+     * @param entries HYTagJournal格式的记录
+     * @return 是否成功
+     */
+    bool spill(const QByteArray &entries);
+
+    /**
+     * @brief 结束当前段，使其可被读取
+     *
+     * 之后的写入进入新的段
+     */
+    void seal();
+
+    /**
+     * @brief 从读取位置起按时间顺序读出若干块
+     *
+     * 按整块读取，读出的条数达到maxSamples或没有更多已结束的段时停止；正在写入的段不读取
+     * 读取位置只在内存中前进，commit()后才保存
+     * @param maxSamples 期望读出的条数，最后一块可能使实际条数超出
+     * @param visitor 每条数据的回调
+     * @return 读出的条数，0表示没有积压数据
+     */
+    qint64 read(qint64 maxSamples, const std::function<void(const Sample &)> &visitor);
+
+    /**
+     * @brief 提交读取位置
+     *
+     * 保存检查点并删除已读完的段
+     * @return 检查点是否保存成功
+     */
+    bool commit();
+
+    /**
+     * @brief 把读取位置退回到上次提交的位置
+     */
+    void rewind();
+
+    /**
+     * @brief 按时间顺序取出并删除磁盘上的全部离线数据
+     *
+     * 先结束当前段，再读出全部块并提交
+     * @param visitor 每条数据的回调
+     * @return 取出的数据条数
+     */
+    qint64 drain(const std::function<void(const Sample &)> &visitor);
+
+    /**
+     * @brief 解码尚未写入磁盘的一段记录
+     * @param entries HYTagJournal格式的记录
+     * @param visitor 每条数据的回调
+     * @return 解码的数据条数
+     */
+    static qint64 decode(const QByteArray &entries, const std::function<void(const Sample &)> &visitor);
+
+    /**
+     * @brief 获取段文件总大小
+     * @return 字节数
+     */
+    qint64 diskSize() const;
+
+    /**
+     * @brief 获取读取位置之后尚未读出的字节数
+     * @return 字节数
+     */
+    qint64 backlogBytes() const;
+
+    /**
+     * @brief 获取段数
+     * @return 段数
+     */
+    int segmentCount() const;
+
+    /**
+     * @brief 获取因超过磁盘上限而释放的字节数
+     * @return 累计字节数
+     */
+    qint64 evictedBytes() const;
+
+private:
+    /**
+     * @struct Segment
+     * @brief 段的状态
+     */
+    struct Segment {
+        qint64 size = 0; ///< 文件大小
+        int level = 0; ///< 已降采样的级数
+    };
+
+    /**
+     * @struct Position
+     * @brief 读取位置
+     */
+    struct Position {
+        quint64 sequence = 0; ///< 段序号
+        qint64 offset = 0; ///< 段内下一块的偏移
+    };
+
+    /**
+     * @brief 在已持有锁的情况下扫描目录中已有的段
+     */
+    void openLocked();
+
+    /**
+     * @brief 在已持有锁的情况下开始新的当前段
+     * @return 是否成功
+     */
+    bool startSegmentLocked();
+
+    /**
+     * @brief 在已持有锁的情况下淘汰一次
+     * @return 是否释放了空间
+     */
+    bool evictLocked();
+
+    /**
+     * @brief 在已持有锁的情况下把一段降采样一级
+     * @param sequence 段序号
+     * @return 是否成功
+     */
+    bool downsampleLocked(quint64 sequence);
+
+    /**
+     * @brief 获取段文件路径
+     * @param sequence 段序号
+     * @return 文件路径
+     */
+    QString segmentPath(quint64 sequence) const;
+
+    /**
+     * @brief 获取检查点文件路径
+     * @return 文件路径
+     */
+    QString checkpointPath() const;
+
+    /**
+     * @brief 解码段文件内容
+     * @param data 文件内容
+     * @param visitor 每条数据的回调
+     * @param end 输出最后一个完整有效的块之后的偏移，可为空
+     * @return 解码的数据条数
+     */
+    static qint64 decodeSegment(const QByteArray &data, const std::function<void(const Sample &)> &visitor,
+                                qint64 *end = nullptr);
+
+    QMutex m_mutex; ///< 保护以下成员
+    QString m_directory; ///< 段文件目录
+    qint64 m_diskLimit; ///< 磁盘上限
+    EvictionPolicy m_policy; ///< 淘汰策略
+    bool m_opened; ///< 是否已扫描目录
+    QMap<quint64, Segment> m_segments; ///< 按序号排列的段，最后一个是当前段
+    QFile m_file; ///< 当前段文件
+    QFile m_reader; ///< 正在读取的段文件
+    Position m_readPosition; ///< 读取位置
+    Position m_committed; ///< 已提交的读取位置
+    quint64 m_nextSequence; ///< 下一个段序号
+    qint64 m_diskSize; ///< 段文件总大小
+    qint64 m_evictedBytes; ///< 累计释放的字节数
+};
+
+#endif // HYOFFLINEBUFFER_H
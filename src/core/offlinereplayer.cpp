@@ -0,0 +1,148 @@
+#include "offlinereplayer.h"
+
+/**
+ * @file offlinereplayer.cpp
+ * @brief 离线数据回放器实现
+ */
+
+HYOfflineReplayer::HYOfflineReplayer(HYOfflineBuffer *buffer, QObject *parent) : QObject(parent),
+    m_buffer(buffer),
+    m_timer(nullptr),
+    m_batchSize(DefaultBatchSize),
+    m_maxRate(DefaultMaxRate),
+    m_budget(0),
+    m_lastTick(0),
+    m_liveWrites(0),
+    m_yielded(0),
+    m_replayed(0)
+{
+    m_timer = new QTimer(this);
+    m_timer->setInterval(TickInterval);
+    connect(m_timer, &QTimer::timeout, this, &HYOfflineReplayer::onTick);
+}
+
+void HYOfflineReplayer::setDatabase(HYTimeSeriesDatabase *database)
+{
+    m_database = database;
+}
+
+HYTimeSeriesDatabase *HYOfflineReplayer::database() const
+{
+    return m_database;
+}
+
+void HYOfflineReplayer::setBatchSize(int batchSize)
+{
+    m_batchSize = qMax(batchSize, 1);
+}
+
+int HYOfflineReplayer::batchSize() const
+{
+    return m_batchSize;
+}
+
+void HYOfflineReplayer::setMaxRate(int samplesPerSecond)
+{
+    m_maxRate = qMax(samplesPerSecond, 1);
+}
+
+int HYOfflineReplayer::maxRate() const
+{
+    return m_maxRate;
+}
+
+void HYOfflineReplayer::start()
+{
+    if (m_timer->isActive()) {
+        return;
+    }
+    if (!m_database) {
+        emit finished(false, 0);
+        return;
+    }
+
+    // Samples read but not written by an earlier run are read again
+    m_buffer->rewind();
+    m_clock.start();
+    m_lastTick = 0;
+    m_budget = qMin(double(m_batchSize), m_maxRate * (TickInterval / 1000.0));
+    m_liveWrites = m_database->liveWriteCount();
+    m_yielded = 0;
+    m_replayed = 0;
+    m_timer->start();
+}
+
+void HYOfflineReplayer::stop()
+{
+    m_timer->stop();
+    m_buffer->rewind();
+}
+
+bool HYOfflineReplayer::isRunning() const
+{
+    return m_timer->isActive();
+}
+
+qint64 HYOfflineReplayer::replayedCount() const
+{
+    return m_replayed;
+}
+
+double HYOfflineReplayer::replayRate() const
+{
+    const qint64 elapsed = m_clock.isValid() ? m_clock.elapsed() : 0;
+    return elapsed > 0 ? m_replayed * 1000.0 / elapsed : 0.0;
+}
+
+qint64 HYOfflineReplayer::backlogBytes() const
+{
+    return m_buffer->backlogBytes();
+}
+
+void HYOfflineReplayer::onTick()
+{
+    // Wait for the historian to come back rather than dropping the backlog
+    if (!m_database || !m_database->isConnected()) {
+        return;
+    }
+
+    // Refill the token bucket; it never holds more than one batch, so a stall does not turn into a burst
+    const qint64 now = m_clock.elapsed();
+    m_budget = qMin(m_budget + (now - m_lastTick) * m_maxRate / 1000.0, double(m_batchSize));
+    m_lastTick = now;
+
+    // Live writes since the last tick take precedence
+    const quint64 liveWrites = m_database->liveWriteCount();
+    const bool live = liveWrites != m_liveWrites;
+    m_liveWrites = liveWrites;
+    if (live && m_yielded < MaxYieldTicks) {
+        ++m_yielded;
+        return;
+    }
+    m_yielded = 0;
+    if (m_budget < 1.0) {
+        return;
+    }
+
+    QVector<HYTimeSeriesDatabase::TagSample> batch;
+    batch.reserve(int(m_budget));
+    m_buffer->read(qint64(m_budget), [&batch](const HYOfflineBuffer::Sample &sample) {
+        batch.append(HYTimeSeriesDatabase::TagSample{sample.name, sample.value, sample.timestamp});
+    });
+    if (batch.isEmpty()) {
+        m_buffer->commit();
+        m_timer->stop();
+        emit finished(true, m_replayed);
+        return;
+    }
+
+    // A failed batch is read again next tick; rows it already wrote are overwritten, not duplicated
+    if (!m_database->storeTagSamples(batch)) {
+        m_buffer->rewind();
+        return;
+    }
+    m_buffer->commit();
+    m_budget -= batch.size();
+    m_replayed += batch.size();
+    emit progress(m_replayed, replayRate(), m_buffer->backlogBytes());
+}
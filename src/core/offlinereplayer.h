@@ -0,0 +1,151 @@
+#ifndef HYOFFLINEREPLAYER_H
+#define HYOFFLINEREPLAYER_H
+
+#include <QObject>
+#include <QPointer>
+#include <QTimer>
+#include <QElapsedTimer>
+#include "offlinebuffer.h"
+#include "timeseriesdatabase.h"
+
+/**
+ * @file offlinereplayer.h
+ * @brief 离线数据回放器头文件
+ */
+
+/**
+ * @class HYOfflineReplayer
+ * @brief 离线数据回放器
+ *
+ * 重新上线后把离线缓冲区中的积压数据按时间顺序成批写入时间序列数据库：
+ * 每批写入成功后提交读取位置，崩溃或重启后从最后提交的位置继续；写入失败时退回该位置，下个周期重试
+ * 数据按各自的源时间戳写入，数据库按标签和时间戳覆盖，重复回放同一批不会产生重复记录
+ * 回放速率受令牌桶限制；数据库在上个周期有实时写入时回放让出本周期，
+ * 连续让出MaxYieldTicks个周期后回放一批，保证积压数据在持续的实时写入下仍能排空
+ */
+class HYOfflineReplayer : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int DefaultBatchSize = 5000; ///< 默认每批条数
+    static constexpr int DefaultMaxRate = 20000; ///< 默认最大回放速率（条/秒）
+    static constexpr int TickInterval = 50; ///< 回放周期（毫秒）
+    static constexpr int MaxYieldTicks = 10; ///< 连续让出实时写入的最大周期数
+
+    /**
+     * @brief 构造函数
+     * @param buffer 离线缓冲区，生命周期不短于回放器
+     * @param parent 父对象
+     */
+    explicit HYOfflineReplayer(HYOfflineBuffer *buffer, QObject *parent = nullptr);
+
+    /**
+     * @brief 设置回放目标
+     * @param database 时间序列数据库，为空时不回放
+     */
+    void setDatabase(HYTimeSeriesDatabase *database);
+
+    /**
+     * @brief 获取回放目标
+     * @return 时间序列数据库
+     */
+    HYTimeSeriesDatabase *database() const;
+
+    /**
+     * @brief 设置每批条数
+     * @param batchSize 每批最多条数，缓冲区按整块读取，一批可能略多
+     */
+    void setBatchSize(int batchSize);
+
+    /**
+     * @brief 获取每批条数
+     * @return 每批条数
+     */
+    int batchSize() const;
+
+    /**
+     * @brief 设置最大回放速率
+     * @param samplesPerSecond 每秒最多回放条数
+     */
+    void setMaxRate(int samplesPerSecond);
+
+    /**
+     * @brief 获取最大回放速率
+     * @return 每秒条数
+     */
+    int maxRate() const;
+
+    /**
+     * @brief 开始回放
+     *
+     * 已在回放时无操作；没有回放目标时立即发出finished(false, 0)
+     */
+    void start();
+
+    /**
+     * @brief 停止回放，已读出但未写入的数据在下次开始时重新读出
+     */
+    void stop();
+
+    /**
+     * @brief 检查是否正在回放
+     * @return 是否正在回放
+     */
+    bool isRunning() const;
+
+    /**
+     * @brief 获取本次回放已写入的条数
+     * @return 条数
+     */
+    qint64 replayedCount() const;
+
+    /**
+     * @brief 获取本次回放的平均速率
+     * @return 每秒条数
+     */
+    double replayRate() const;
+
+    /**
+     * @brief 获取剩余积压数据的字节数
+     * @return 字节数
+     */
+    qint64 backlogBytes() const;
+
+signals:
+    /**
+     * @brief 回放进度信号，每写入一批发出一次
+     * @param replayed 本次回放已写入的条数
+     * @param rate 平均速率（条/秒）
+     * @param backlogBytes 剩余积压数据的字节数
+     */
+    void progress(qint64 replayed, double rate, qint64 backlogBytes);
+
+    /**
+     * @brief 回放结束信号
+     * @param success 积压数据是否已全部写入
+     * @param replayed 本次回放写入的条数
+     */
+    void finished(bool success, qint64 replayed);
+
+private slots:
+    /**
+     * @brief 回放周期
+     */
+    void onTick();
+
+private:
+    HYOfflineBuffer *m_buffer; ///< 离线缓冲区
+    QPointer<HYTimeSeriesDatabase> m_database; ///< 时间序列数据库
+    QTimer *m_timer; ///< 回放定时器
+    QElapsedTimer m_clock; ///< 本次回放开始后的时钟
+    int m_batchSize; ///< 每批条数
+    int m_maxRate; ///< 最大回放速率
+    double m_budget; ///< 令牌桶中可回放的条数
+    qint64 m_lastTick; ///< 上个周期的时钟毫秒数
+    quint64 m_liveWrites; ///< 上个周期时数据库的实时写入次数
+    int m_yielded; ///< 已连续让出的周期数
+    qint64 m_replayed; ///< 本次回放已写入的条数
+};
+
+#endif // HYOFFLINEREPLAYER_H
@@ -0,0 +1,196 @@
+#include "tagbitset.h"
+
+/**
+ * @file tagbitset.cpp
+ * @brief 点位位集实现
+ *
+ * 置位与取出都使用顺序一致的原子操作，调用方可以据此与其他标志构成先写后查的同步协议
+ */
+
+HYTagBitset::HYTagBitset() :
+    m_pages(new std::atomic<std::atomic<quint64> *>[MaxPages]),
+    m_pageCount(0)
+{
+    for (int i = 0; i < MaxPages; ++i) {
+        m_pages[i].store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+HYTagBitset::~HYTagBitset()
+{
+    const int pages = m_pageCount.load(std::memory_order_relaxed);
+    for (int i = 0; i < pages; ++i) {
+        delete[] m_pages[i].load(std::memory_order_relaxed);
+    }
+}
+
+std::atomic<quint64> *HYTagBitset::word(HYTagId id, bool create) const
+{
+    if (id < 0 || (id >> PageShift) >= MaxPages) {
+        return nullptr;
+    }
+
+    const int pageIndex = id >> PageShift;
+    std::atomic<quint64> *page = m_pages[pageIndex].load(std::memory_order_acquire);
+    if (!page) {
+        if (!create) {
+            return nullptr;
+        }
+
+        // Racing allocators agree on one page; the loser frees its copy
+        std::atomic<quint64> *fresh = new std::atomic<quint64>[PageWords];
+        for (int i = 0; i < PageWords; ++i) {
+            fresh[i].store(0, std::memory_order_relaxed);
+        }
+        if (m_pages[pageIndex].compare_exchange_strong(page, fresh, std::memory_order_acq_rel)) {
+            page = fresh;
+            int count = m_pageCount.load(std::memory_order_relaxed);
+            while (count < pageIndex + 1
+                   && !m_pageCount.compare_exchange_weak(count, pageIndex + 1, std::memory_order_seq_cst)) {
+            }
+        } else {
+            delete[] fresh;
+        }
+    }
+    return &page[(id >> WordShift) & (PageWords - 1)];
+}
+
+bool HYTagBitset::set(HYTagId id)
+{
+    std::atomic<quint64> *w = word(id, true);
+    if (!w) {
+        return false;
+    }
+    const quint64 bit = quint64(1) << (id & 63);
+    return !(w->fetch_or(bit, std::memory_order_seq_cst) & bit);
+}
+
+void HYTagBitset::reset(HYTagId id)
+{
+    if (std::atomic<quint64> *w = word(id, false)) {
+        w->fetch_and(~(quint64(1) << (id & 63)), std::memory_order_seq_cst);
+    }
+}
+
+bool HYTagBitset::test(HYTagId id) const
+{
+    const std::atomic<quint64> *w = word(id, false);
+    return w && (w->load(std::memory_order_acquire) & (quint64(1) << (id & 63)));
+}
+
+void HYTagBitset::clear()
+{
+    const int pages = m_pageCount.load(std::memory_order_acquire);
+    for (int i = 0; i < pages; ++i) {
+        std::atomic<quint64> *page = m_pages[i].load(std::memory_order_acquire);
+        if (!page) {
+            continue;
+        }
+        for (int j = 0; j < PageWords; ++j) {
+            page[j].store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+int HYTagBitset::takeAll(QVector<HYTagId> *ids)
+{
+    ids->resize(0);
+
+    const int pages = m_pageCount.load(std::memory_order_seq_cst);
+    for (int i = 0; i < pages; ++i) {
+        std::atomic<quint64> *page = m_pages[i].load(std::memory_order_acquire);
+        if (!page) {
+            continue;
+        }
+        for (int j = 0; j < PageWords; ++j) {
+            // Skip clean words without writing to them
+            if (!page[j].load(std::memory_order_relaxed)) {
+                continue;
+            }
+            quint64 bits = page[j].exchange(0, std::memory_order_seq_cst);
+            const HYTagId base = HYTagId((i << PageShift) | (j << WordShift));
+            while (bits) {
+                ids->append(base + qCountTrailingZeroBits(bits));
+                bits &= bits - 1;
+            }
+        }
+    }
+    return int(ids->size());
+}
+
+HYTagMaskTable::HYTagMaskTable() :
+    m_pages(new std::atomic<std::atomic<quint64> *>[MaxPages]),
+    m_pageCount(0)
+{
+    for (int i = 0; i < MaxPages; ++i) {
+        m_pages[i].store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+HYTagMaskTable::~HYTagMaskTable()
+{
+    const int pages = m_pageCount.load(std::memory_order_relaxed);
+    for (int i = 0; i < pages; ++i) {
+        delete[] m_pages[i].load(std::memory_order_relaxed);
+    }
+}
+
+std::atomic<quint64> *HYTagMaskTable::entry(HYTagId id, bool create) const
+{
+    if (id < 0 || (id >> PageShift) >= MaxPages) {
+        return nullptr;
+    }
+
+    const int pageIndex = id >> PageShift;
+    std::atomic<quint64> *page = m_pages[pageIndex].load(std::memory_order_acquire);
+    if (!page) {
+        if (!create) {
+            return nullptr;
+        }
+
+        // Racing allocators agree on one page; the loser frees its copy
+        std::atomic<quint64> *fresh = new std::atomic<quint64>[PageSize];
+        for (int i = 0; i < PageSize; ++i) {
+            fresh[i].store(0, std::memory_order_relaxed);
+        }
+        if (m_pages[pageIndex].compare_exchange_strong(page, fresh, std::memory_order_acq_rel)) {
+            page = fresh;
+            int count = m_pageCount.load(std::memory_order_relaxed);
+            while (count < pageIndex + 1
+                   && !m_pageCount.compare_exchange_weak(count, pageIndex + 1, std::memory_order_seq_cst)) {
+            }
+        } else {
+            delete[] fresh;
+        }
+    }
+    return &page[id & (PageSize - 1)];
+}
+
+void HYTagMaskTable::set(HYTagId id, quint64 bits)
+{
+    if (std::atomic<quint64> *e = entry(id, true)) {
+        e->fetch_or(bits, std::memory_order_release);
+    }
+}
+
+quint64 HYTagMaskTable::mask(HYTagId id) const
+{
+    const std::atomic<quint64> *e = entry(id, false);
+    return e ? e->load(std::memory_order_acquire) : 0;
+}
+
+void HYTagMaskTable::resetAll(quint64 bits)
+{
+    const int pages = m_pageCount.load(std::memory_order_acquire);
+    for (int i = 0; i < pages; ++i) {
+        std::atomic<quint64> *page = m_pages[i].load(std::memory_order_acquire);
+        if (!page) {
+            continue;
+        }
+        for (int j = 0; j < PageSize; ++j) {
+            if (page[j].load(std::memory_order_relaxed) & bits) {
+                page[j].fetch_and(~bits, std::memory_order_release);
+            }
+        }
+    }
+}
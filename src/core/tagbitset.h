@@ -0,0 +1,150 @@
+#ifndef HYTAGBITSET_H
+#define HYTAGBITSET_H
+
+#include <QVector>
+#include <QtGlobal>
+#include <atomic>
+#include <memory>
+#include "tagvaluestore.h"
+
+/**
+ * @file tagbitset.h
+ * @brief 点位位集头文件
+ *
+ * 以点位句柄为下标的并发位集和位掩码表，用于记录待通知的脏点位和关注每个点位的订阅者
+ */
+
+/**
+ * @class HYTagBitset
+ * @brief 点位位集
+ *
+ * 按页惰性分配，页一经分配不再释放，置位、清位和测试都无锁，可由任意线程并发调用
+ * 取出操作按字原子交换，与并发置位之间不会丢失位
+ */
+class HYTagBitset
+{
+public:
+    /**
+     * @brief 构造函数
+     */
+    HYTagBitset();
+
+    /**
+     * @brief 析构函数
+     */
+    ~HYTagBitset();
+
+    HYTagBitset(const HYTagBitset &) = delete;
+    HYTagBitset &operator=(const HYTagBitset &) = delete;
+
+    /**
+     * @brief 置位
+     * @param id 点位句柄
+     * @return 该位之前是否未置位
+     */
+    bool set(HYTagId id);
+
+    /**
+     * @brief 清位
+     * @param id 点位句柄
+     */
+    void reset(HYTagId id);
+
+    /**
+     * @brief 测试位
+     * @param id 点位句柄
+     * @return 是否置位
+     */
+    bool test(HYTagId id) const;
+
+    /**
+     * @brief 清空所有位
+     */
+    void clear();
+
+    /**
+     * @brief 取出并清空所有已置位的句柄
+     * @param ids 输出按升序排列的句柄，原有内容被清空
+     * @return 取出的句柄数
+     */
+    int takeAll(QVector<HYTagId> *ids);
+
+private:
+    static constexpr int WordShift = 6; ///< 每字位数的位数
+    static constexpr int PageShift = 12; ///< 每页位数的位数
+    static constexpr int PageWords = 1 << (PageShift - WordShift); ///< 每页字数
+    static constexpr int MaxPages = (1 << 24) >> PageShift; ///< 最大页数，与点位句柄上限一致
+
+    /**
+     * @brief 获取句柄所在的字，必要时分配页
+     * @param id 点位句柄
+     * @param create 页不存在时是否分配
+     * @return 字，页不存在且不分配时为nullptr
+     */
+    std::atomic<quint64> *word(HYTagId id, bool create) const;
+
+    std::unique_ptr<std::atomic<std::atomic<quint64> *>[]> m_pages; ///< 页目录
+    mutable std::atomic<int> m_pageCount; ///< 已分配页的最大下标加一
+};
+
+/**
+ * @class HYTagMaskTable
+ * @brief 点位位掩码表
+ *
+ * 为每个点位保存一个64位掩码，每位对应一个订阅者，写入方据此只访问关注该点位的订阅者
+ * 与HYTagBitset一样按页惰性分配，读写都无锁
+ */
+class HYTagMaskTable
+{
+public:
+    /**
+     * @brief 构造函数
+     */
+    HYTagMaskTable();
+
+    /**
+     * @brief 析构函数
+     */
+    ~HYTagMaskTable();
+
+    HYTagMaskTable(const HYTagMaskTable &) = delete;
+    HYTagMaskTable &operator=(const HYTagMaskTable &) = delete;
+
+    /**
+     * @brief 置位
+     * @param id 点位句柄
+     * @param bits 要置位的位
+     */
+    void set(HYTagId id, quint64 bits);
+
+    /**
+     * @brief 获取点位的掩码
+     * @param id 点位句柄
+     * @return 掩码，未置位过的点位为0
+     */
+    quint64 mask(HYTagId id) const;
+
+    /**
+     * @brief 在所有点位上清位
+     * @param bits 要清除的位
+     */
+    void resetAll(quint64 bits);
+
+private:
+    static constexpr int PageShift = 10; ///< 每页点位数的位数
+    static constexpr int PageSize = 1 << PageShift; ///< 每页点位数
+    static constexpr int MaxPages = (1 << 24) >> PageShift; ///< 最大页数，与点位句柄上限一致
+
+    /**
+     * @brief 获取点位的掩码字，必要时分配页
+     * @param id 点位句柄
+     * @param create 页不存在时是否分配
+     * @return 掩码字，页不存在且不分配时为nullptr
+     */
+    std::atomic<quint64> *entry(HYTagId id, bool create) const;
+
+    std::unique_ptr<std::atomic<std::atomic<quint64> *>[]> m_pages; ///< 页目录
+    mutable std::atomic<int> m_pageCount; ///< 已分配页的最大下标加一
+};
+
+#endif // HYTAGBITSET_H
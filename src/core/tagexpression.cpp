@@ -0,0 +1,411 @@
+#include "tagexpression.h"
+#include <QVarLengthArray>
+#include <cmath>
+#include <limits>
+#include <numbers>
+
+/**
+ * @file tagexpression.cpp
+ * @brief 计算点位表达式实现
+ */
+
+/**
+ * @class HYTagExpression::Parser
+ * @brief 递归下降解析器，边解析边生成字节码
+ */
+class HYTagExpression::Parser
+{
+public:
+    Parser(const QString &source, HYTagExpression *expression) :
+        m_text(source),
+        m_position(0),
+        m_depth(0),
+        m_expression(expression)
+    {
+    }
+
+    bool parse(QString *error) {
+        skipSpace();
+        bool ok = parseTernary();
+        if (ok && m_position < m_text.size()) {
+            ok = fail(QStringLiteral("unexpected '%1'").arg(m_text.at(m_position)));
+        }
+        if (!ok && error) {
+            *error = m_error;
+        }
+        return ok;
+    }
+
+private:
+    bool fail(const QString &message) {
+        if (m_error.isEmpty()) {
+            m_error = QStringLiteral("%1 at position %2").arg(message).arg(m_position);
+        }
+        return false;
+    }
+
+    void skipSpace() {
+        while (m_position < m_text.size() && m_text.at(m_position).isSpace()) {
+            ++m_position;
+        }
+    }
+
+    bool accept(const char *token) {
+        const QLatin1String view(token);
+        if (!QStringView(m_text).mid(m_position).startsWith(view)) {
+            return false;
+        }
+        m_position += view.size();
+        skipSpace();
+        return true;
+    }
+
+    // Tracks the stack depth each instruction leaves behind, so evaluation can size its stack once
+    void generate(Op op, int operand = 0) {
+        m_expression->m_code.append(Instruction{op, operand});
+        switch (op) {
+        case PushConstant:
+        case PushInput:
+            ++m_depth;
+            m_expression->m_depth = qMax(m_expression->m_depth, m_depth);
+            break;
+        case Negate: case Not: case Abs: case Sqrt: case Exp: case Log: case Log10: case Floor: case Ceil: case Round:
+            break;
+        case Select: case Clamp:
+            m_depth -= 2;
+            break;
+        default:
+            --m_depth;
+            break;
+        }
+    }
+
+    void generateConstant(double value) {
+        m_expression->m_constants.append(value);
+        generate(PushConstant, m_expression->m_constants.size() - 1);
+    }
+
+    void generateInput(const QString &name) {
+        int index = m_expression->m_variables.indexOf(name);
+        if (index < 0) {
+            m_expression->m_variables.append(name);
+            index = m_expression->m_variables.size() - 1;
+        }
+        generate(PushInput, index);
+    }
+
+    bool parseTernary() {
+        if (!parseBinary(0)) {
+            return false;
+        }
+        if (!accept("?")) {
+            return true;
+        }
+        if (!parseTernary()) {
+            return false;
+        }
+        if (!accept(":")) {
+            return fail(QStringLiteral("expected ':'"));
+        }
+        if (!parseTernary()) {
+            return false;
+        }
+        generate(Select);
+        return true;
+    }
+
+    // Binary operators by precedence level, lowest first; longer tokens are tried before their prefixes
+    bool parseBinary(int level) {
+        struct Operator { const char *token; Op op; };
+        static const QVector<QVector<Operator>> levels = {
+            {{"||", Or}},
+            {{"&&", And}},
+            {{"==", Equal}, {"!=", NotEqual}},
+            {{"<=", LessEqual}, {">=", GreaterEqual}, {"<", Less}, {">", Greater}},
+            {{"+", Add}, {"-", Sub}},
+            {{"*", Mul}, {"/", Div}, {"%", Mod}},
+        };
+        if (level == levels.size()) {
+            return parseUnary();
+        }
+
+        if (!parseBinary(level + 1)) {
+            return false;
+        }
+        for (;;) {
+            const Operator *matched = nullptr;
+            for (const Operator &candidate : levels.at(level)) {
+                if (accept(candidate.token)) {
+                    matched = &candidate;
+                    break;
+                }
+            }
+            if (!matched) {
+                return true;
+            }
+            if (!parseBinary(level + 1)) {
+                return false;
+            }
+            generate(matched->op);
+        }
+    }
+
+    bool parseUnary() {
+        if (accept("-")) {
+            if (!parseUnary()) {
+                return false;
+            }
+            generate(Negate);
+            return true;
+        }
+        if (accept("+")) {
+            return parseUnary();
+        }
+        // "!=" is a binary operator and never starts an operand
+        if (m_position + 1 >= m_text.size() || m_text.at(m_position + 1) != QLatin1Char('=')) {
+            if (accept("!")) {
+                if (!parseUnary()) {
+                    return false;
+                }
+                generate(Not);
+                return true;
+            }
+        }
+        return parsePower();
+    }
+
+    bool parsePower() {
+        if (!parsePrimary()) {
+            return false;
+        }
+        if (accept("^")) {
+            // Right associative, and the exponent may carry its own sign: 2^-1
+            if (!parseUnary()) {
+                return false;
+            }
+            generate(Pow);
+        }
+        return true;
+    }
+
+    bool parsePrimary() {
+        if (m_position >= m_text.size()) {
+            return fail(QStringLiteral("unexpected end of expression"));
+        }
+
+        const QChar c = m_text.at(m_position);
+        if (accept("(")) {
+            if (!parseTernary()) {
+                return false;
+            }
+            return accept(")") || fail(QStringLiteral("expected ')'"));
+        }
+        if (c == QLatin1Char('{')) {
+            const int end = m_text.indexOf(QLatin1Char('}'), m_position + 1);
+            if (end < 0) {
+                return fail(QStringLiteral("unterminated '{'"));
+            }
+            const QString name = m_text.mid(m_position + 1, end - m_position - 1).trimmed();
+            if (name.isEmpty()) {
+                return fail(QStringLiteral("empty tag name"));
+            }
+            m_position = end + 1;
+            skipSpace();
+            generateInput(name);
+            return true;
+        }
+        if (c.isDigit() || c == QLatin1Char('.')) {
+            return parseNumber();
+        }
+        if (c.isLetter() || c == QLatin1Char('_')) {
+            const int start = m_position;
+            while (m_position < m_text.size()
+                   && (m_text.at(m_position).isLetterOrNumber() || m_text.at(m_position) == QLatin1Char('_')
+                       || m_text.at(m_position) == QLatin1Char('.'))) {
+                ++m_position;
+            }
+            const QString name = m_text.mid(start, m_position - start);
+            skipSpace();
+            if (accept("(")) {
+                return parseCall(name);
+            }
+            if (name == QLatin1String("pi")) {
+                generateConstant(std::numbers::pi);
+            } else if (name == QLatin1String("true")) {
+                generateConstant(1.0);
+            } else if (name == QLatin1String("false")) {
+                generateConstant(0.0);
+            } else {
+                generateInput(name);
+            }
+            return true;
+        }
+        return fail(QStringLiteral("unexpected '%1'").arg(c));
+    }
+
+    bool parseNumber() {
+        const int start = m_position;
+        while (m_position < m_text.size() && (m_text.at(m_position).isDigit() || m_text.at(m_position) == QLatin1Char('.'))) {
+            ++m_position;
+        }
+        if (m_position < m_text.size() && (m_text.at(m_position) == QLatin1Char('e') || m_text.at(m_position) == QLatin1Char('E'))) {
+            int exponent = m_position + 1;
+            if (exponent < m_text.size() && (m_text.at(exponent) == QLatin1Char('+') || m_text.at(exponent) == QLatin1Char('-'))) {
+                ++exponent;
+            }
+            if (exponent < m_text.size() && m_text.at(exponent).isDigit()) {
+                m_position = exponent;
+                while (m_position < m_text.size() && m_text.at(m_position).isDigit()) {
+                    ++m_position;
+                }
+            }
+        }
+
+        bool ok = false;
+        const double value = QStringView(m_text).mid(start, m_position - start).toDouble(&ok);
+        if (!ok) {
+            m_position = start;
+            return fail(QStringLiteral("invalid number"));
+        }
+        skipSpace();
+        generateConstant(value);
+        return true;
+    }
+
+    bool parseCall(const QString &name) {
+        struct Function { const char *name; Op op; int arity; };
+        static const Function functions[] = {
+            {"abs", Abs, 1}, {"sqrt", Sqrt, 1}, {"exp", Exp, 1}, {"log", Log, 1}, {"log10", Log10, 1},
+            {"floor", Floor, 1}, {"ceil", Ceil, 1}, {"round", Round, 1}, {"pow", Pow, 2}, {"clamp", Clamp, 3},
+            {"min", Min, -2}, {"max", Max, -2},
+        };
+        const Function *function = nullptr;
+        for (const Function &candidate : functions) {
+            if (name == QLatin1String(candidate.name)) {
+                function = &candidate;
+                break;
+            }
+        }
+        if (!function) {
+            return fail(QStringLiteral("unknown function '%1'").arg(name));
+        }
+
+        // A negative arity means "at least that many"; min and max fold pairwise
+        int count = 0;
+        if (!accept(")")) {
+            do {
+                if (!parseTernary()) {
+                    return false;
+                }
+                if (++count > 1 && function->arity < 0) {
+                    generate(function->op);
+                }
+            } while (accept(","));
+            if (!accept(")")) {
+                return fail(QStringLiteral("expected ')'"));
+            }
+        }
+        if (function->arity >= 0 ? count != function->arity : count < -function->arity) {
+            return fail(QStringLiteral("wrong number of arguments to '%1'").arg(name));
+        }
+        if (function->arity >= 0) {
+            generate(function->op);
+        }
+        return true;
+    }
+
+    const QString &m_text; ///< 表达式文本
+    int m_position; ///< 当前位置
+    int m_depth; ///< 当前栈深度
+    QString m_error; ///< 第一个错误
+    HYTagExpression *m_expression; ///< 生成的表达式
+};
+
+HYTagExpression::HYTagExpression() :
+    m_depth(0)
+{
+}
+
+bool HYTagExpression::compile(const QString &source, QString *error)
+{
+    m_source = source;
+    m_variables.clear();
+    m_constants.clear();
+    m_code.clear();
+    m_depth = 0;
+
+    Parser parser(source, this);
+    if (!parser.parse(error)) {
+        m_variables.clear();
+        m_constants.clear();
+        m_code.clear();
+        m_depth = 0;
+        return false;
+    }
+    return true;
+}
+
+bool HYTagExpression::isValid() const
+{
+    return !m_code.isEmpty();
+}
+
+QString HYTagExpression::source() const
+{
+    return m_source;
+}
+
+QStringList HYTagExpression::variables() const
+{
+    return m_variables;
+}
+
+int HYTagExpression::size() const
+{
+    return m_code.size();
+}
+
+double HYTagExpression::evaluate(const double *inputs) const
+{
+    if (m_code.isEmpty()) {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+
+    QVarLengthArray<double, 32> stack(m_depth);
+    double *top = stack.data() - 1;
+    for (const Instruction &instruction : m_code) {
+        switch (instruction.op) {
+        case PushConstant: *++top = m_constants[instruction.operand]; break;
+        case PushInput: *++top = inputs[instruction.operand]; break;
+        case Add: top[-1] += top[0]; --top; break;
+        case Sub: top[-1] -= top[0]; --top; break;
+        case Mul: top[-1] *= top[0]; --top; break;
+        case Div: top[-1] /= top[0]; --top; break;
+        case Mod: top[-1] = std::fmod(top[-1], top[0]); --top; break;
+        case Pow: top[-1] = std::pow(top[-1], top[0]); --top; break;
+        case Less: top[-1] = top[-1] < top[0]; --top; break;
+        case LessEqual: top[-1] = top[-1] <= top[0]; --top; break;
+        case Greater: top[-1] = top[-1] > top[0]; --top; break;
+        case GreaterEqual: top[-1] = top[-1] >= top[0]; --top; break;
+        case Equal: top[-1] = top[-1] == top[0]; --top; break;
+        case NotEqual: top[-1] = top[-1] != top[0]; --top; break;
+        case And: top[-1] = top[-1] != 0.0 && top[0] != 0.0; --top; break;
+        case Or: top[-1] = top[-1] != 0.0 || top[0] != 0.0; --top; break;
+        case Negate: top[0] = -top[0]; break;
+        case Not: top[0] = top[0] == 0.0; break;
+        case Select: top[-2] = top[-2] != 0.0 ? top[-1] : top[0]; top -= 2; break;
+        case Abs: top[0] = std::fabs(top[0]); break;
+        case Sqrt: top[0] = std::sqrt(top[0]); break;
+        case Exp: top[0] = std::exp(top[0]); break;
+        case Log: top[0] = std::log(top[0]); break;
+        case Log10: top[0] = std::log10(top[0]); break;
+        case Floor: top[0] = std::floor(top[0]); break;
+        case Ceil: top[0] = std::ceil(top[0]); break;
+        case Round: top[0] = std::round(top[0]); break;
+        case Min: top[-1] = std::fmin(top[-1], top[0]); --top; break;
+        case Max: top[-1] = std::fmax(top[-1], top[0]); --top; break;
+        case Clamp: top[-2] = std::fmin(std::fmax(top[-2], top[-1]), top[0]); top -= 2; break;
+        }
+    }
+    return *top;
+}
@@ -0,0 +1,105 @@
+#ifndef HYTAGEXPRESSION_H
+#define HYTAGEXPRESSION_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QtGlobal>
+
+/**
+ * @file tagexpression.h
+ * @brief 计算点位表达式头文件
+ */
+
+/**
+ * @class HYTagExpression
+ * @brief 编译后的计算点位表达式
+ *
+ * 表达式在编译时转换为后缀形式的字节码，求值时在固定深度的栈上顺序执行，不再解析文本
+ * 支持的语法：
+ * - 数字常量、pi、true、false
+ * - 点位名称：字母或下划线开头，可含字母、数字、下划线和'.'，如plant.bf1.flow；其他名称用花括号括起，如{BF-1 温度}
+ * - 运算符（优先级从低到高）：?:、||、&&、== !=、< <= > >=、+ -、* / %、一元- + !、^（右结合）
+ * - 函数：abs sqrt exp log log10 floor ceil round、pow(x, y)、clamp(x, lo, hi)、min/max（两个及以上参数）
+ * 比较和逻辑运算的结果为1或0，非0视为真；所有运算按双精度浮点执行
+ */
+class HYTagExpression
+{
+public:
+    /**
+     * @brief 构造空表达式
+     */
+    HYTagExpression();
+
+    /**
+     * @brief 编译表达式
+     * @param source 表达式文本
+     * @param error 输出错误信息，可为空
+     * @return 是否成功，失败时表达式为空
+     */
+    bool compile(const QString &source, QString *error = nullptr);
+
+    /**
+     * @brief 检查表达式是否已成功编译
+     * @return 是否有效
+     */
+    bool isValid() const;
+
+    /**
+     * @brief 获取表达式文本
+     * @return 表达式文本
+     */
+    QString source() const;
+
+    /**
+     * @brief 获取表达式引用的点位名称，按首次出现的顺序，不重复
+     * @return 点位名称，evaluate()的输入按此顺序排列
+     */
+    QStringList variables() const;
+
+    /**
+     * @brief 获取字节码指令数
+     * @return 指令数
+     */
+    int size() const;
+
+    /**
+     * @brief 求值
+     * @param inputs 与variables()逐个对应的输入值
+     * @return 结果，表达式无效时为NaN
+     */
+    double evaluate(const double *inputs) const;
+
+private:
+    /**
+     * @enum Op
+     * @brief 字节码操作
+     */
+    enum Op : quint8 {
+        PushConstant, ///< 压入常量，操作数为常量下标
+        PushInput, ///< 压入输入，操作数为输入下标
+        Add, Sub, Mul, Div, Mod, Pow,
+        Less, LessEqual, Greater, GreaterEqual, Equal, NotEqual,
+        And, Or, Negate, Not, Select,
+        Abs, Sqrt, Exp, Log, Log10, Floor, Ceil, Round, Min, Max, Clamp
+    };
+
+    /**
+     * @struct Instruction
+     * @brief 单条指令
+     */
+    struct Instruction {
+        Op op; ///< 操作
+        qint32 operand; ///< 操作数，只用于压栈指令
+    };
+
+    class Parser;
+
+    QString m_source; ///< 表达式文本
+    QStringList m_variables; ///< 引用的点位名称
+    QVector<double> m_constants; ///< 常量表
+    QVector<Instruction> m_code; ///< 字节码
+    int m_depth; ///< 求值所需的栈深度
+};
+
+#endif // HYTAGEXPRESSION_H
@@ -0,0 +1,545 @@
+#include "taghistory.h"
+#include <QSqlQuery>
+#include <QSqlRecord>
+#include <QTimeZone>
+#include <iterator>
+
+/**
+ * @file taghistory.cpp
+ * @brief 点位历史库实现
+ */
+
+HYTagHistory::HYTagHistory() :
+    m_legacy(false),
+    m_written(0),
+    m_partitioning(PartitionByDay),
+    m_retentionThread(nullptr),
+    m_retentionStopping(false),
+    m_retention(0),
+    m_retentionInterval(DefaultRetentionInterval)
+{
+}
+
+HYTagHistory::~HYTagHistory()
+{
+    close();
+}
+
+bool HYTagHistory::open(const QString &path)
+{
+    close();
+
+    m_path = path;
+    m_connectionName = QStringLiteral("huayan.history.%1").arg(quintptr(this), 0, 16);
+    m_database = QSqlDatabase::addDatabase("QSQLITE", m_connectionName);
+    m_database.setDatabaseName(path);
+    if (!m_database.open()) {
+        close();
+        return false;
+    }
+
+    QSqlQuery query(m_database);
+    // Pages freed by dropped partitions go back to the file system; only takes effect on a new file
+    query.exec("PRAGMA auto_vacuum=INCREMENTAL");
+    // WAL lets each batch commit with one sequential append instead of rewriting pages in place
+    query.exec("PRAGMA journal_mode=WAL");
+    query.exec("PRAGMA synchronous=NORMAL");
+    // The retention thread writes through its own connection
+    query.exec("PRAGMA busy_timeout=5000");
+
+    // Tag names are stored once; samples refer to them by series number
+    const bool created = query.exec("CREATE TABLE IF NOT EXISTS history_series ("
+                                    "id INTEGER PRIMARY KEY, tag_name TEXT NOT NULL UNIQUE)")
+        && query.exec("CREATE TABLE IF NOT EXISTS history_partitions ("
+                      "table_name TEXT PRIMARY KEY, start_time INTEGER NOT NULL, end_time INTEGER NOT NULL)");
+    if (!created || !loadPartitions(m_database)) {
+        close();
+        return false;
+    }
+
+    // Rows written by earlier versions stay readable until retention removes them
+    m_legacy = m_database.tables().contains("history");
+    if (m_legacy && !m_database.record("history").contains("quality")) {
+        query.exec("ALTER TABLE history ADD COLUMN quality INTEGER DEFAULT 192");
+    }
+
+    m_mutex.lock();
+    const bool retention = m_retention > 0;
+    m_mutex.unlock();
+    if (retention) {
+        startRetention();
+    }
+    return true;
+}
+
+void HYTagHistory::close()
+{
+    stopRetention();
+    if (m_connectionName.isEmpty()) {
+        return;
+    }
+    m_database.close();
+    m_database = QSqlDatabase();
+    QSqlDatabase::removeDatabase(m_connectionName);
+    m_connectionName.clear();
+    m_path.clear();
+    m_series.clear();
+    m_legacy = false;
+    m_written = 0;
+
+    QMutexLocker locker(&m_mutex);
+    m_partitions.clear();
+}
+
+bool HYTagHistory::isOpen() const
+{
+    return m_database.isOpen();
+}
+
+QString HYTagHistory::path() const
+{
+    return m_path;
+}
+
+void HYTagHistory::setPartitioning(Partitioning partitioning)
+{
+    m_partitioning = partitioning;
+}
+
+HYTagHistory::Partitioning HYTagHistory::partitioning() const
+{
+    return m_partitioning;
+}
+
+void HYTagHistory::setRetention(qint64 retention, int interval)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_retention = qMax<qint64>(0, retention);
+        m_retentionInterval = qMax(1, interval);
+    }
+    if (retention > 0 && isOpen()) {
+        startRetention();
+    } else {
+        stopRetention();
+    }
+}
+
+QStringList HYTagHistory::partitions() const
+{
+    QMutexLocker locker(&m_mutex);
+    QStringList tables;
+    for (const Partition &partition : m_partitions) {
+        tables.append(partition.table);
+    }
+    return tables;
+}
+
+QVector<qint64> HYTagHistory::seriesIds(const QStringList &names)
+{
+    QVector<qint64> ids(names.size(), 0);
+    QVector<int> missing;
+    for (int i = 0; i < names.size(); ++i) {
+        ids[i] = m_series.value(names.at(i), 0);
+        if (!ids[i]) {
+            missing.append(i);
+        }
+    }
+    if (missing.isEmpty() || !isOpen() || !m_database.transaction()) {
+        return ids;
+    }
+
+    QSqlQuery insert(m_database);
+    QSqlQuery select(m_database);
+    insert.prepare("INSERT OR IGNORE INTO history_series (tag_name) VALUES (?)");
+    select.prepare("SELECT id FROM history_series WHERE tag_name = ?");
+    for (int i : std::as_const(missing)) {
+        const QString &name = names.at(i);
+        insert.bindValue(0, name);
+        select.bindValue(0, name);
+        if (insert.exec() && select.exec() && select.next()) {
+            ids[i] = select.value(0).toLongLong();
+        }
+        select.finish();
+    }
+
+    // Cache only what was committed; a failed commit leaves the names to be allocated next time
+    if (!m_database.commit()) {
+        m_database.rollback();
+        return QVector<qint64>(names.size(), 0);
+    }
+    for (int i : std::as_const(missing)) {
+        if (ids[i]) {
+            m_series.insert(names.at(i), ids[i]);
+        }
+    }
+    return ids;
+}
+
+bool HYTagHistory::write(const QVector<Sample> &samples)
+{
+    if (!isOpen()) {
+        return false;
+    }
+    if (samples.isEmpty()) {
+        return true;
+    }
+    if (!m_database.transaction()) {
+        return false;
+    }
+
+    // One statement is prepared per partition touched by the batch and rebound for every sample
+    QHash<QString, QSqlQuery> statements;
+    qint64 start = 0;
+    Partition partition;
+    bool failed = false;
+
+    const QVariant nullInt(QMetaType::fromType<qlonglong>());
+    const QVariant nullReal(QMetaType::fromType<double>());
+    const QVariant nullText(QMetaType::fromType<QString>());
+    for (const Sample &sample : samples) {
+        // Batches are mostly one partition, so the catalog is only consulted when a sample leaves it
+        if (partition.table.isEmpty() || sample.timestamp < start || sample.timestamp >= partition.end) {
+            partition = partitionFor(sample.timestamp, &start);
+            if (partition.table.isEmpty()) {
+                failed = true;
+                break;
+            }
+        }
+        auto statement = statements.find(partition.table);
+        if (statement == statements.end()) {
+            statement = statements.insert(partition.table, QSqlQuery(m_database));
+            if (!statement->prepare(QStringLiteral("INSERT OR REPLACE INTO %1 "
+                                                   "(series, timestamp, value_int, value_real, value_text, quality) "
+                                                   "VALUES (?, ?, ?, ?, ?, ?)").arg(partition.table))) {
+                failed = true;
+                break;
+            }
+        }
+
+        QVariant valueInt = nullInt;
+        QVariant valueReal = nullReal;
+        QVariant valueText = nullText;
+        if (sample.complex.isValid()) {
+            valueText = sample.complex.toString();
+        } else {
+            switch (sample.value.type()) {
+            case HYTagValue::Bool:
+            case HYTagValue::Int64:
+                valueInt = sample.value.toInt64();
+                break;
+            case HYTagValue::Double:
+                valueReal = sample.value.toDouble();
+                break;
+            case HYTagValue::String:
+                valueText = sample.value.toString();
+                break;
+            case HYTagValue::Null:
+                break;
+            }
+        }
+
+        statement->bindValue(0, sample.series);
+        statement->bindValue(1, sample.timestamp);
+        statement->bindValue(2, valueInt);
+        statement->bindValue(3, valueReal);
+        statement->bindValue(4, valueText);
+        statement->bindValue(5, int(sample.quality));
+        if (!statement->exec()) {
+            failed = true;
+            break;
+        }
+    }
+
+    statements.clear();
+    if (failed || !m_database.commit()) {
+        // Partitions created in the rolled back transaction no longer exist
+        m_database.rollback();
+        loadPartitions(m_database);
+        return false;
+    }
+    m_written += samples.size();
+    return true;
+}
+
+QVector<QPair<QDateTime, QVariant>> HYTagHistory::query(const QString &name, qint64 startTime, qint64 endTime,
+                                                        QVector<quint8> *qualities)
+{
+    QVector<QPair<QDateTime, QVariant>> data;
+    if (qualities) {
+        qualities->clear();
+    }
+    if (!isOpen()) {
+        return data;
+    }
+
+    // Legacy rows predate every partition, so they come first; the lock keeps retention from dropping the table mid-read
+    QMutexLocker legacyLocker(&m_mutex);
+    if (m_legacy) {
+        QSqlQuery legacy(m_database);
+        legacy.prepare("SELECT timestamp, value, quality FROM history "
+                       "WHERE tag_name = ? AND timestamp >= ? AND timestamp <= ? ORDER BY timestamp");
+        legacy.addBindValue(name);
+        legacy.addBindValue(QDateTime::fromMSecsSinceEpoch(startTime).toString(Qt::ISODate));
+        legacy.addBindValue(QDateTime::fromMSecsSinceEpoch(endTime).toString(Qt::ISODate));
+        if (legacy.exec()) {
+            while (legacy.next()) {
+                data.append(qMakePair(QDateTime::fromString(legacy.value(0).toString(), Qt::ISODate),
+                                      legacy.value(1)));
+                if (qualities) {
+                    qualities->append(quint8(legacy.value(2).toUInt()));
+                }
+            }
+        }
+    }
+    legacyLocker.unlock();
+
+    qint64 series = m_series.value(name, 0);
+    if (!series) {
+        QSqlQuery lookup(m_database);
+        lookup.prepare("SELECT id FROM history_series WHERE tag_name = ?");
+        lookup.addBindValue(name);
+        if (!lookup.exec() || !lookup.next()) {
+            return data;
+        }
+        series = lookup.value(0).toLongLong();
+    }
+
+    // Partitions do not overlap, so reading them in order of start time keeps the result sorted
+    QStringList tables;
+    {
+        QMutexLocker locker(&m_mutex);
+        auto it = m_partitions.upperBound(startTime);
+        if (it != m_partitions.begin()) {
+            --it;
+        }
+        for (; it != m_partitions.end() && it.key() <= endTime; ++it) {
+            if (it.value().end > startTime) {
+                tables.append(it.value().table);
+            }
+        }
+    }
+
+    for (const QString &table : std::as_const(tables)) {
+        QSqlQuery query(m_database);
+        query.setForwardOnly(true);
+        // A partition dropped by retention since the catalog was read simply fails to prepare
+        if (!query.prepare(QStringLiteral("SELECT timestamp, value_int, value_real, value_text, quality FROM %1 "
+                                          "WHERE series = ? AND timestamp >= ? AND timestamp <= ? ORDER BY timestamp")
+                               .arg(table))) {
+            continue;
+        }
+        query.addBindValue(series);
+        query.addBindValue(startTime);
+        query.addBindValue(endTime);
+        if (!query.exec()) {
+            continue;
+        }
+        while (query.next()) {
+            QVariant value;
+            if (!query.isNull(1)) {
+                value = query.value(1).toLongLong();
+            } else if (!query.isNull(2)) {
+                value = query.value(2).toDouble();
+            } else if (!query.isNull(3)) {
+                value = query.value(3).toString();
+            }
+            data.append(qMakePair(QDateTime::fromMSecsSinceEpoch(query.value(0).toLongLong()), value));
+            if (qualities) {
+                qualities->append(quint8(query.value(4).toUInt()));
+            }
+        }
+    }
+    return data;
+}
+
+int HYTagHistory::purge(qint64 cutoff)
+{
+    if (!isOpen()) {
+        return 0;
+    }
+    return dropExpired(m_database, cutoff);
+}
+
+qint64 HYTagHistory::writtenCount() const
+{
+    return m_written;
+}
+
+bool HYTagHistory::loadPartitions(QSqlDatabase &database)
+{
+    QSqlQuery query(database);
+    if (!query.exec("SELECT start_time, end_time, table_name FROM history_partitions")) {
+        return false;
+    }
+
+    QMap<qint64, Partition> partitions;
+    while (query.next()) {
+        Partition partition;
+        partition.end = query.value(1).toLongLong();
+        partition.table = query.value(2).toString();
+        partitions.insert(query.value(0).toLongLong(), partition);
+    }
+
+    QMutexLocker locker(&m_mutex);
+    m_partitions = partitions;
+    return true;
+}
+
+HYTagHistory::Partition HYTagHistory::partitionFor(qint64 timestamp, qint64 *start)
+{
+    const qint64 length = m_partitioning == PartitionByHour ? 3600000 : 86400000;
+    Partition partition;
+    {
+        QMutexLocker locker(&m_mutex);
+        auto next = m_partitions.upperBound(timestamp);
+        if (next != m_partitions.begin()) {
+            auto previous = std::prev(next);
+            if (timestamp < previous.value().end) {
+                *start = previous.key();
+                return previous.value();
+            }
+        }
+
+        // The new partition covers its hour or day, cut short where a partition of another length begins or ends
+        *start = timestamp - ((timestamp % length) + length) % length;
+        partition.end = *start + length;
+        if (next != m_partitions.begin()) {
+            *start = qMax(*start, std::prev(next).value().end);
+        }
+        if (next != m_partitions.end()) {
+            partition.end = qMin(partition.end, next.key());
+        }
+    }
+    const QString table = QStringLiteral("history_%1")
+                              .arg(QDateTime::fromMSecsSinceEpoch(*start, QTimeZone::utc()).toString("yyyyMMddHHmmss"));
+
+    QSqlQuery query(m_database);
+    const bool created = query.exec(QStringLiteral("CREATE TABLE IF NOT EXISTS %1 ("
+                                                   "series INTEGER NOT NULL, timestamp INTEGER NOT NULL, "
+                                                   "value_int INTEGER, value_real REAL, value_text TEXT, "
+                                                   "quality INTEGER NOT NULL, PRIMARY KEY (series, timestamp)) "
+                                                   "WITHOUT ROWID").arg(table))
+        && query.prepare("INSERT OR REPLACE INTO history_partitions (table_name, start_time, end_time) VALUES (?, ?, ?)");
+    if (!created) {
+        return Partition();
+    }
+    query.addBindValue(table);
+    query.addBindValue(*start);
+    query.addBindValue(partition.end);
+    if (!query.exec()) {
+        return Partition();
+    }
+
+    partition.table = table;
+    QMutexLocker locker(&m_mutex);
+    m_partitions.insert(*start, partition);
+    return partition;
+}
+
+int HYTagHistory::dropExpired(QSqlDatabase &database, qint64 cutoff)
+{
+    // Partitions leave the catalog first, so new queries and writes stop using them before they are dropped
+    QStringList tables;
+    {
+        QMutexLocker locker(&m_mutex);
+        while (!m_partitions.isEmpty() && m_partitions.first().end <= cutoff) {
+            tables.append(m_partitions.first().table);
+            m_partitions.erase(m_partitions.begin());
+        }
+    }
+
+    QSqlQuery query(database);
+    if (!tables.isEmpty()) {
+        bool dropped = database.transaction();
+        QSqlQuery remove(database);
+        remove.prepare("DELETE FROM history_partitions WHERE table_name = ?");
+        for (const QString &table : std::as_const(tables)) {
+            remove.bindValue(0, table);
+            dropped = dropped && query.exec(QStringLiteral("DROP TABLE IF EXISTS %1").arg(table)) && remove.exec();
+        }
+        if (!dropped || !database.commit()) {
+            // Whatever could not be dropped is put back and tried again on the next pass
+            database.rollback();
+            loadPartitions(database);
+            return 0;
+        }
+        query.exec("PRAGMA incremental_vacuum");
+    }
+
+    // The legacy table is not partitioned; it is thinned row by row and dropped once empty
+    if (m_legacy) {
+        query.prepare("DELETE FROM history WHERE timestamp < ?");
+        query.addBindValue(QDateTime::fromMSecsSinceEpoch(cutoff).toString(Qt::ISODate));
+        query.exec();
+        if (query.exec("SELECT 1 FROM history LIMIT 1") && !query.next()) {
+            query.finish();
+            // Like partitions, the table leaves the catalog first; taking the lock waits out a query reading it
+            m_mutex.lock();
+            m_legacy = false;
+            m_mutex.unlock();
+            if (!query.exec("DROP TABLE history")) {
+                m_mutex.lock();
+                m_legacy = true;
+                m_mutex.unlock();
+            }
+        }
+    }
+    return tables.size();
+}
+
+void HYTagHistory::runRetention()
+{
+    const QString connectionName = m_connectionName + QStringLiteral(".retention");
+    {
+        QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+        database.setDatabaseName(m_path);
+        if (database.open()) {
+            QSqlQuery(database).exec("PRAGMA busy_timeout=5000");
+
+            QMutexLocker locker(&m_mutex);
+            while (!m_retentionStopping) {
+                const qint64 cutoff = QDateTime::currentMSecsSinceEpoch() - m_retention;
+                locker.unlock();
+                dropExpired(database, cutoff);
+                locker.relock();
+                if (m_retentionStopping) {
+                    break;
+                }
+                m_condition.wait(&m_mutex, m_retentionInterval);
+            }
+        }
+        database.close();
+    }
+    QSqlDatabase::removeDatabase(connectionName);
+}
+
+void HYTagHistory::startRetention()
+{
+    if (m_retentionThread) {
+        // A running thread picks up the new retention at once
+        QMutexLocker locker(&m_mutex);
+        m_condition.wakeAll();
+        return;
+    }
+
+    m_retentionStopping = false;
+    m_retentionThread = QThread::create([this]() { runRetention(); });
+    m_retentionThread->setObjectName(QStringLiteral("HYTagHistoryRetention"));
+    m_retentionThread->start();
+}
+
+void HYTagHistory::stopRetention()
+{
+    if (!m_retentionThread) {
+        return;
+    }
+    {
+        QMutexLocker locker(&m_mutex);
+        m_retentionStopping = true;
+        m_condition.wakeAll();
+    }
+    m_retentionThread->wait();
+    delete m_retentionThread;
+    m_retentionThread = nullptr;
+}
@@ -0,0 +1,235 @@
+#ifndef HYTAGHISTORY_H
+#define HYTAGHISTORY_H
+
+#include <QString>
+#include <QStringList>
+#include <QVariant>
+#include <QVector>
+#include <QPair>
+#include <QDateTime>
+#include <QHash>
+#include <QMap>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QThread>
+#include <QSqlDatabase>
+#include <QtGlobal>
+#include <atomic>
+#include "tagvalue.h"
+
+/**
+ * @file taghistory.h
+ * @brief 点位历史库头文件
+ */
+
+/**
+ * @class HYTagHistory
+ * @brief 点位历史库
+ *
+ * 按点位名称分配整数序列号，样本以（序列号，毫秒时间戳）为主键保存，值按类型分别存入整数、浮点和文本列
+ * 样本按时间分区存放在独立的表中（默认每天一个），分区目录记录每个分区覆盖的时间范围；
+ * 查询只访问与时间范围重叠的分区，清理过期数据时整表删除分区，不逐行删除
+ * 每批样本在一个事务中写入，每个涉及的分区使用一条预编译语句
+ * 旧版本的history表（文本值、ISO 8601时间字符串）保留为只读，查询和清理时一并处理，清空后删除
+ * 写入和查询使用独立的数据库连接，非线程安全，由调用方串行化；保留期清理在后台线程中使用另一个连接执行
+ */
+class HYTagHistory
+{
+public:
+    /**
+     * @enum Partitioning
+     * @brief 分区粒度
+     */
+    enum Partitioning {
+        PartitionByDay, ///< 每天（UTC）一个分区
+        PartitionByHour ///< 每小时一个分区
+    };
+
+    static constexpr int DefaultRetentionInterval = 3600000; ///< 默认保留期清理间隔（毫秒）
+
+    /**
+     * @struct Sample
+     * @brief 待写入的样本
+     */
+    struct Sample {
+        qint64 series = 0; ///< 序列号，由seriesIds()分配
+        qint64 timestamp = 0; ///< 时间戳（毫秒）
+        HYTagValue value; ///< 类型化值
+        QVariant complex; ///< 无法表示为HYTagValue的值，有效时代替value写入文本列
+        quint8 quality = 0; ///< 质量码
+    };
+
+    /**
+     * @brief 构造函数
+     */
+    HYTagHistory();
+
+    /**
+     * @brief 析构函数，停止清理线程并关闭数据库
+     */
+    ~HYTagHistory();
+
+    HYTagHistory(const HYTagHistory &) = delete;
+    HYTagHistory &operator=(const HYTagHistory &) = delete;
+
+    /**
+     * @brief 打开历史库，必要时创建表；设置了保留期时启动清理线程
+     * @param path 数据库文件路径
+     * @return 是否成功
+     */
+    bool open(const QString &path);
+
+    /**
+     * @brief 停止清理线程并关闭历史库，保留期设置保持不变
+     */
+    void close();
+
+    /**
+     * @brief 检查历史库是否已打开
+     * @return 是否已打开
+     */
+    bool isOpen() const;
+
+    /**
+     * @brief 获取数据库文件路径
+     * @return 文件路径
+     */
+    QString path() const;
+
+    /**
+     * @brief 设置分区粒度，只影响之后新建的分区
+     *
+     * 新分区的范围会截断到与已有分区不重叠，因此粒度可以随时切换
+     * @param partitioning 分区粒度
+     */
+    void setPartitioning(Partitioning partitioning);
+
+    /**
+     * @brief 获取分区粒度
+     * @return 分区粒度
+     */
+    Partitioning partitioning() const;
+
+    /**
+     * @brief 设置保留期，在后台线程中定期删除过期分区
+     *
+     * 分区的结束时间早于当前时间减去保留期时整表删除，因此数据最多比保留期多保留一个分区
+     * 清理线程启动后立即执行一次
+     * @param retention 保留期（毫秒），不大于0时停止清理线程
+     * @param interval 清理间隔（毫秒）
+     */
+    void setRetention(qint64 retention, int interval = DefaultRetentionInterval);
+
+    /**
+     * @brief 获取已有分区的表名，按时间排序
+     * @return 表名
+     */
+    QStringList partitions() const;
+
+    /**
+     * @brief 获取点位的序列号，不存在的在一个事务中分配
+     * @param names 点位名称
+     * @return 与名称逐个对应的序列号，失败的为0
+     */
+    QVector<qint64> seriesIds(const QStringList &names);
+
+    /**
+     * @brief 在一个事务中写入一批样本，必要时创建分区
+     *
+     * 同一序列同一时间戳的样本覆盖已有的样本
+     * @param samples 样本
+     * @return 是否成功，失败时整批回滚
+     */
+    bool write(const QVector<Sample> &samples);
+
+    /**
+     * @brief 查询点位在时间范围内的样本，只访问与范围重叠的分区
+     * @param name 点位名称
+     * @param startTime 开始时间（毫秒）
+     * @param endTime 结束时间（毫秒），包含
+     * @param qualities 输出与样本逐条对应的质量码，可为空
+     * @return 按时间排序的样本
+     */
+    QVector<QPair<QDateTime, QVariant>> query(const QString &name, qint64 startTime, qint64 endTime,
+                                              QVector<quint8> *qualities = nullptr);
+
+    /**
+     * @brief 立即删除结束时间不晚于截止时间的分区
+     * @param cutoff 截止时间（毫秒）
+     * @return 删除的分区数
+     */
+    int purge(qint64 cutoff);
+
+    /**
+     * @brief 获取打开后写入的样本数
+     * @return 样本数
+     */
+    qint64 writtenCount() const;
+
+private:
+    /**
+     * @struct Partition
+     * @brief 分区目录项
+     */
+    struct Partition {
+        QString table; ///< 表名
+        qint64 end = 0; ///< 结束时间（毫秒），不包含
+    };
+
+    /**
+     * @brief 从分区目录重新加载分区
+     * @param database 数据库连接
+     * @return 是否成功
+     */
+    bool loadPartitions(QSqlDatabase &database);
+
+    /**
+     * @brief 查找包含时间戳的分区，不存在时在当前事务中创建
+     * @param timestamp 时间戳（毫秒）
+     * @param start 输出分区的开始时间（毫秒）
+     * @return 分区，失败时表名为空
+     */
+    Partition partitionFor(qint64 timestamp, qint64 *start);
+
+    /**
+     * @brief 在指定连接上删除过期分区和旧版本表中的过期行
+     * @param database 数据库连接
+     * @param cutoff 截止时间（毫秒）
+     * @return 删除的分区数
+     */
+    int dropExpired(QSqlDatabase &database, qint64 cutoff);
+
+    /**
+     * @brief 清理线程主循环
+     */
+    void runRetention();
+
+    /**
+     * @brief 启动清理线程
+     */
+    void startRetention();
+
+    /**
+     * @brief 停止清理线程
+     */
+    void stopRetention();
+
+    QSqlDatabase m_database; ///< 写入和查询使用的数据库连接
+    QString m_connectionName; ///< 连接名称
+    QString m_path; ///< 数据库文件路径
+    QHash<QString, qint64> m_series; ///< 点位名称到序列号的缓存
+    std::atomic<bool> m_legacy; ///< 是否存在旧版本的history表（查询读取旧表和清理线程修改时持有m_mutex）
+    qint64 m_written; ///< 打开后写入的样本数
+    Partitioning m_partitioning; ///< 新建分区的粒度
+
+    // 分区目录由写入方和清理线程共享
+    mutable QMutex m_mutex; ///< 保护分区目录和清理线程状态
+    QMap<qint64, Partition> m_partitions; ///< 开始时间到分区的映射
+    QWaitCondition m_condition; ///< 清理线程的等待条件
+    QThread *m_retentionThread; ///< 清理线程
+    bool m_retentionStopping; ///< 是否请求清理线程退出（受m_mutex保护）
+    qint64 m_retention; ///< 保留期（毫秒），0表示不清理
+    int m_retentionInterval; ///< 清理间隔（毫秒）
+};
+
+#endif // HYTAGHISTORY_H
@@ -0,0 +1,310 @@
+#include "tagingestqueue.h"
+#include <QDateTime>
+#include <QtMath>
+
+/**
+ * @file tagingestqueue.cpp
+ * @brief 点位采集队列实现
+ *
+ * 环形缓冲区的每个槽位带有序号，生产者通过CAS竞争写入位置，消费者独占读取位置，
+ * 生产者之间、生产者与消费者之间都不需要加锁
+ */
+
+namespace {
+
+constexpr int MaxCapacity = 1 << 24; ///< 容量上限
+constexpr int IdleWaitMs = 100; ///< 队列为空时应用线程的最长等待时间（毫秒），防止停止请求丢失
+
+/**
+ * @brief 将容量规整为不超过上限的2的幂
+ * @param capacity 期望的容量
+ * @return 容量
+ */
+int normalizeCapacity(int capacity)
+{
+    capacity = qBound(2, capacity, MaxCapacity);
+    return int(qNextPowerOfTwo(quint32(capacity - 1)));
+}
+
+} // namespace
+
+HYTagIngestQueue::HYTagIngestQueue(HYTagManager *manager, int capacity) :
+    m_manager(manager),
+    m_capacity(normalizeCapacity(capacity)),
+    m_mask(quint64(m_capacity) - 1),
+    m_cells(new Cell[m_capacity]),
+    m_tail(0),
+    m_head(0),
+    m_sources(new Source[MaxSources]),
+    m_sourceCount(0),
+    m_applied(0),
+    m_thread(nullptr),
+    m_stopping(false),
+    m_waiting(false)
+{
+    for (int i = 0; i < m_capacity; ++i) {
+        m_cells[i].sequence.store(quint64(i), std::memory_order_relaxed);
+        m_cells[i].source = 0;
+        m_cells[i].complex = false;
+    }
+}
+
+HYTagIngestQueue::~HYTagIngestQueue()
+{
+    stop();
+}
+
+int HYTagIngestQueue::capacity() const
+{
+    return m_capacity;
+}
+
+int HYTagIngestQueue::registerSource(const QString &name, int quota)
+{
+    QMutexLocker locker(&m_sourceMutex);
+
+    const int index = m_sourceCount.load(std::memory_order_relaxed);
+    if (index >= MaxSources) {
+        return -1;
+    }
+
+    Source &source = m_sources[index];
+    source.name = name;
+    source.quota = quota > 0 ? qMin(quota, m_capacity) : qMax(1, m_capacity / 4);
+
+    // Publish the source only after its quota has been set
+    m_sourceCount.store(index + 1, std::memory_order_release);
+    return index;
+}
+
+bool HYTagIngestQueue::tryPush(int source, TagId id, const HYTagValue &value, qint64 timestamp, quint8 quality)
+{
+    return push(source, id, value, timestamp, quality, nullptr);
+}
+
+bool HYTagIngestQueue::push(int source, TagId id, const HYTagValue &value, qint64 timestamp, quint8 quality,
+                            const QVariant *complex)
+{
+    if (source < 0 || source >= m_sourceCount.load(std::memory_order_acquire)) {
+        return false;
+    }
+    Source &counters = m_sources[source];
+
+    // Reserve room in the source's own quota first so that a burst from one source cannot fill the ring
+    if (counters.pending.fetch_add(1, std::memory_order_relaxed) >= counters.quota) {
+        counters.pending.fetch_sub(1, std::memory_order_relaxed);
+        counters.dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    quint64 position = m_tail.load(std::memory_order_relaxed);
+    Cell *cell = nullptr;
+    for (;;) {
+        cell = &m_cells[position & m_mask];
+        const qint64 diff = qint64(cell->sequence.load(std::memory_order_acquire) - position);
+        if (diff == 0) {
+            if (m_tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // The consumer has not released this cell yet: the ring is full
+            counters.pending.fetch_sub(1, std::memory_order_relaxed);
+            counters.dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        } else {
+            position = m_tail.load(std::memory_order_relaxed);
+        }
+    }
+
+    // The side table entry is keyed by position and in place before the cell becomes readable
+    if (complex) {
+        QMutexLocker locker(&m_complexMutex);
+        m_complexValues.insert(position, *complex);
+    }
+    cell->update = HYTagUpdate{id, timestamp, value, quality};
+    cell->source = source;
+    cell->complex = complex != nullptr;
+    cell->sequence.store(position + 1, std::memory_order_release);
+    counters.accepted.fetch_add(1, std::memory_order_relaxed);
+
+    wakeApplier();
+    return true;
+}
+
+bool HYTagIngestQueue::publish(int source, TagId id, const QVariant &value, quint8 quality, qint64 sourceTimestamp)
+{
+    if (id < 0) {
+        // A binding whose tag is not defined yet loses its updates like a full queue does, and is counted
+        if (source >= 0 && source < m_sourceCount.load(std::memory_order_acquire)) {
+            m_sources[source].dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+        return false;
+    }
+
+    const qint64 timestamp = sourceTimestamp ? sourceTimestamp : QDateTime::currentMSecsSinceEpoch();
+    HYTagValue typed;
+    if (HYTagValue::fromVariant(value, &typed)) {
+        return tryPush(source, id, typed, timestamp, quality);
+    }
+
+    // Values without a typed representation wait in the side table, so they still apply in publish order
+    return push(source, id, HYTagValue(), timestamp, quality, &value);
+}
+
+int HYTagIngestQueue::drain(QVector<HYTagUpdate> *updates, int maxCount)
+{
+    updates->resize(0);
+
+    int released[MaxSources] = {};
+    while (updates->size() < maxCount) {
+        Cell &cell = m_cells[m_head & m_mask];
+        if (cell.sequence.load(std::memory_order_acquire) != m_head + 1 || cell.complex) {
+            break;
+        }
+        updates->append(cell.update);
+        ++released[cell.source];
+
+        // Hand the cell back to producers for the next lap
+        cell.sequence.store(m_head + m_capacity, std::memory_order_release);
+        ++m_head;
+    }
+
+    const int sources = m_sourceCount.load(std::memory_order_acquire);
+    for (int i = 0; i < sources; ++i) {
+        if (released[i]) {
+            m_sources[i].pending.fetch_sub(released[i], std::memory_order_relaxed);
+        }
+    }
+    return int(updates->size());
+}
+
+void HYTagIngestQueue::start()
+{
+    if (m_thread) {
+        return;
+    }
+
+    m_stopping.store(false, std::memory_order_relaxed);
+    m_thread = QThread::create([this]() { run(); });
+    m_thread->setObjectName(QStringLiteral("HYTagIngest"));
+    m_thread->start();
+}
+
+void HYTagIngestQueue::stop()
+{
+    if (m_thread) {
+        {
+            QMutexLocker locker(&m_waitMutex);
+            m_stopping.store(true, std::memory_order_release);
+            m_waitCondition.wakeAll();
+        }
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+
+    // The caller is now the only consumer; apply whatever is still queued
+    QVector<HYTagUpdate> updates;
+    while (applyPending(&updates) > 0) {
+    }
+}
+
+bool HYTagIngestQueue::isRunning() const
+{
+    return m_thread != nullptr;
+}
+
+HYTagIngestQueue::SourceStats HYTagIngestQueue::sourceStats(int source) const
+{
+    SourceStats stats;
+    if (source < 0 || source >= m_sourceCount.load(std::memory_order_acquire)) {
+        return stats;
+    }
+
+    const Source &counters = m_sources[source];
+    stats.name = counters.name;
+    stats.accepted = counters.accepted.load(std::memory_order_relaxed);
+    stats.dropped = counters.dropped.load(std::memory_order_relaxed);
+    stats.pending = qMax(0, counters.pending.load(std::memory_order_relaxed));
+    stats.quota = counters.quota;
+    return stats;
+}
+
+qint64 HYTagIngestQueue::droppedCount() const
+{
+    qint64 dropped = 0;
+    const int sources = m_sourceCount.load(std::memory_order_acquire);
+    for (int i = 0; i < sources; ++i) {
+        dropped += m_sources[i].dropped.load(std::memory_order_relaxed);
+    }
+    return dropped;
+}
+
+qint64 HYTagIngestQueue::appliedCount() const
+{
+    return m_applied.load(std::memory_order_relaxed);
+}
+
+int HYTagIngestQueue::applyPending(QVector<HYTagUpdate> *updates)
+{
+    int applied = drain(updates);
+    if (applied > 0) {
+        m_manager->setValues(*updates);
+    }
+
+    // A value from the side table ends the batch, so it is written after everything published before it
+    Cell &cell = m_cells[m_head & m_mask];
+    if (cell.sequence.load(std::memory_order_acquire) == m_head + 1 && cell.complex) {
+        QVariant value;
+        {
+            QMutexLocker locker(&m_complexMutex);
+            value = m_complexValues.take(m_head);
+        }
+        const HYTagUpdate update = cell.update;
+        const int source = cell.source;
+        cell.complex = false;
+        cell.sequence.store(m_head + m_capacity, std::memory_order_release);
+        ++m_head;
+        m_sources[source].pending.fetch_sub(1, std::memory_order_relaxed);
+
+        m_manager->setValue(update.id, value, update.timestamp, update.quality);
+        ++applied;
+    }
+
+    m_applied.fetch_add(applied, std::memory_order_relaxed);
+    return applied;
+}
+
+void HYTagIngestQueue::run()
+{
+    QVector<HYTagUpdate> updates;
+    updates.reserve(BatchSize);
+
+    while (!m_stopping.load(std::memory_order_acquire)) {
+        if (applyPending(&updates) > 0) {
+            continue;
+        }
+
+        // Announce the wait before re-checking the ring; producers check the flag after publishing,
+        // so either this check sees their record or they see the flag and wake us
+        QMutexLocker locker(&m_waitMutex);
+        m_waiting.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const bool empty = m_cells[m_head & m_mask].sequence.load(std::memory_order_acquire) != m_head + 1;
+        if (empty && !m_stopping.load(std::memory_order_acquire)) {
+            m_waitCondition.wait(&m_waitMutex, IdleWaitMs);
+        }
+        m_waiting.store(false, std::memory_order_relaxed);
+    }
+}
+
+void HYTagIngestQueue::wakeApplier()
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    // Only the first producer to see the flag pays for the lock
+    if (m_waiting.load(std::memory_order_relaxed) && m_waiting.exchange(false, std::memory_order_relaxed)) {
+        QMutexLocker locker(&m_waitMutex);
+        m_waitCondition.wakeOne();
+    }
+}
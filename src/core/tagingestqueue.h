@@ -0,0 +1,230 @@
+#ifndef HYTAGINGESTQUEUE_H
+#define HYTAGINGESTQUEUE_H
+
+#include <QString>
+#include <QHash>
+#include <QVariant>
+#include <QVector>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QThread>
+#include <QtGlobal>
+#include <atomic>
+#include <memory>
+
+#include "tagmanager.h"
+
+/**
+ * @file tagingestqueue.h
+ * @brief 点位采集队列头文件
+ *
+ * 数据源在自己的回调线程中把更新推入有界的多生产者单消费者环形缓冲区，
+ * 由一个应用线程批量取出后写入点位管理器，数据源回调不再等待点位管理器的锁
+ */
+
+/**
+ * @class HYTagIngestQueue
+ * @brief 点位采集队列
+ *
+ * 推入操作无锁且从不阻塞：队列满或数据源超出配额时丢弃该更新并计数，由调用方决定是否降频
+ * 每个数据源有独立的在途配额，单个PLC的突发最多占用配额内的槽位，不会挤占其他数据源
+ */
+class HYTagIngestQueue
+{
+public:
+    typedef HYTagManager::TagId TagId; ///< 点位句柄类型
+
+    static constexpr int DefaultCapacity = 65536; ///< 默认容量
+    static constexpr int BatchSize = 1024; ///< 应用线程每批最多取出的更新数
+    static constexpr int MaxSources = 64; ///< 最多注册的数据源数
+
+    /**
+     * @struct SourceStats
+     * @brief 数据源的采集统计
+     */
+    struct SourceStats {
+        QString name; ///< 数据源名称
+        qint64 accepted = 0; ///< 已入队的更新数
+        qint64 dropped = 0; ///< 因队列满或超出配额被丢弃的更新数
+        int pending = 0; ///< 在途（已入队、尚未取出）的更新数
+        int quota = 0; ///< 在途配额
+    };
+
+    /**
+     * @brief 构造函数
+     * @param manager 点位管理器，应用线程把更新写入此管理器
+     * @param capacity 队列容量，向上取整为2的幂
+     */
+    explicit HYTagIngestQueue(HYTagManager *manager, int capacity = DefaultCapacity);
+
+    /**
+     * @brief 析构函数，停止应用线程并应用剩余的更新
+     */
+    ~HYTagIngestQueue();
+
+    /**
+     * @brief 获取队列容量
+     * @return 容量
+     */
+    int capacity() const;
+
+    /**
+     * @brief 注册数据源
+     *
+     * 应在数据源开始推入之前调用
+     * @param name 数据源名称
+     * @param quota 在途配额，0表示容量的1/4
+     * @return 数据源编号，数据源数已满时为-1
+     */
+    int registerSource(const QString &name, int quota = 0);
+
+    /**
+     * @brief 推入一个类型化更新，可由任意线程调用
+     * @param source 数据源编号
+     * @param id 点位句柄
+     * @param value 新值
+     * @param timestamp 源时间戳（毫秒）
+     * @param quality 质量码
+     * @return 是否入队，队列满或超出配额时为false
+     */
+    bool tryPush(int source, TagId id, const HYTagValue &value, qint64 timestamp,
+                 quint8 quality = HYTagValueStore::QualityGood);
+
+    /**
+     * @brief 发布一个点位值，供数据源回调使用
+     *
+     * 可表示为HYTagValue的值放入槽位；其他类型的值保存在旁路表中，槽位只占位，
+     * 两者都按发布顺序连同时间戳和质量码写入点位管理器；句柄无效的更新计为丢弃
+     * @param source 数据源编号
+     * @param id 点位句柄
+     * @param value 新值
+     * @param quality 质量码
+     * @param sourceTimestamp 源时间戳（毫秒），0表示取当前时间
+     * @return 是否入队，被丢弃时为false
+     */
+    bool publish(int source, TagId id, const QVariant &value, quint8 quality = HYTagValueStore::QualityGood,
+                 qint64 sourceTimestamp = 0);
+
+    /**
+     * @brief 取出一批更新
+     *
+     * 单消费者接口：应用线程运行时只能由应用线程调用；遇到旁路表中的值时停止，该值由应用线程或stop()写入
+     * @param updates 输出取出的更新，原有内容被清空
+     * @param maxCount 最多取出的更新数
+     * @return 取出的更新数
+     */
+    int drain(QVector<HYTagUpdate> *updates, int maxCount = BatchSize);
+
+    /**
+     * @brief 启动应用线程
+     */
+    void start();
+
+    /**
+     * @brief 停止应用线程，返回前应用所有已入队的更新
+     */
+    void stop();
+
+    /**
+     * @brief 检查应用线程是否在运行
+     * @return 是否运行
+     */
+    bool isRunning() const;
+
+    /**
+     * @brief 获取数据源统计
+     * @param source 数据源编号
+     * @return 统计信息，编号无效时为默认值
+     */
+    SourceStats sourceStats(int source) const;
+
+    /**
+     * @brief 获取所有数据源的丢弃总数
+     * @return 丢弃的更新数
+     */
+    qint64 droppedCount() const;
+
+    /**
+     * @brief 获取已写入点位管理器的更新总数
+     * @return 已应用的更新数
+     */
+    qint64 appliedCount() const;
+
+private:
+    /**
+     * @struct Cell
+     * @brief 环形缓冲区槽位
+     *
+     * sequence等于槽位下标时可写，等于下标+1时可读，读出后推进一圈
+     */
+    struct Cell {
+        std::atomic<quint64> sequence; ///< 槽位序号
+        HYTagUpdate update; ///< 更新内容
+        int source; ///< 数据源编号
+        bool complex; ///< 值是否保存在旁路表中
+    };
+
+    /**
+     * @struct Source
+     * @brief 数据源计数器
+     */
+    struct alignas(64) Source {
+        std::atomic<qint64> accepted{0}; ///< 已入队的更新数
+        std::atomic<qint64> dropped{0}; ///< 被丢弃的更新数
+        std::atomic<int> pending{0}; ///< 在途的更新数
+        int quota = 0; ///< 在途配额
+        QString name; ///< 数据源名称
+    };
+
+    /**
+     * @brief 占用一个槽位
+     * @param source 数据源编号
+     * @param id 点位句柄
+     * @param value 类型化的新值
+     * @param timestamp 源时间戳（毫秒）
+     * @param quality 质量码
+     * @param complex 无法表示为HYTagValue的新值，为空时使用value
+     * @return 是否入队
+     */
+    bool push(int source, TagId id, const HYTagValue &value, qint64 timestamp, quint8 quality,
+              const QVariant *complex);
+
+    /**
+     * @brief 取出并应用一批更新，批次后紧跟的旁路表中的值也一并写入
+     * @param updates 取出更新使用的缓冲区
+     * @return 应用的更新数
+     */
+    int applyPending(QVector<HYTagUpdate> *updates);
+
+    /**
+     * @brief 应用线程主循环
+     */
+    void run();
+
+    /**
+     * @brief 唤醒等待中的应用线程
+     */
+    void wakeApplier();
+
+    HYTagManager *m_manager; ///< 点位管理器
+    int m_capacity; ///< 队列容量
+    quint64 m_mask; ///< 下标掩码
+    std::unique_ptr<Cell[]> m_cells; ///< 环形缓冲区
+    alignas(64) std::atomic<quint64> m_tail; ///< 生产者写入位置
+    alignas(64) quint64 m_head; ///< 消费者读取位置，只由消费者访问
+    std::unique_ptr<Source[]> m_sources; ///< 数据源计数器
+    std::atomic<int> m_sourceCount; ///< 已注册的数据源数
+    QMutex m_sourceMutex; ///< 串行化数据源注册
+    std::atomic<qint64> m_applied; ///< 已应用的更新数
+    QHash<quint64, QVariant> m_complexValues; ///< 旁路表：按槽位序号保存无法表示为HYTagValue的值
+    QMutex m_complexMutex; ///< 保护旁路表
+
+    // 应用线程
+    QThread *m_thread; ///< 应用线程
+    std::atomic<bool> m_stopping; ///< 是否请求停止
+    std::atomic<bool> m_waiting; ///< 应用线程是否即将等待或正在等待
+    QMutex m_waitMutex; ///< 等待互斥锁
+    QWaitCondition m_waitCondition; ///< 队列为空时应用线程在此等待
+};
+
+#endif // HYTAGINGESTQUEUE_H
@@ -0,0 +1,478 @@
+#include "tagjournal.h"
+#include <QSaveFile>
+#include <QDataStream>
+#include <cstddef>
+#include <cstring>
+
+#ifdef Q_OS_WIN
+#include <io.h>
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+/**
+ * @file tagjournal.cpp
+ * @brief 点位状态日志实现
+ *
+ * 文件头：4字节标识、32位版本号、64位代数
+ * 块：32位负载长度、32位CRC32、负载；负载是若干条记录
+ * 记录：24字节定长头（类型、值类型、质量码、保留、句柄、时间戳、负载），字符串和其他值跟在头之后
+ */
+
+namespace {
+
+const char CheckpointMagic[] = "HYCK"; ///< 检查点文件标识
+const char JournalMagic[] = "HYWL"; ///< 日志文件标识
+constexpr quint32 FormatVersion = 1; ///< 文件格式版本
+constexpr int HeaderSize = 16; ///< 文件头字节数
+constexpr int BlockHeaderSize = 8; ///< 块头字节数
+
+/**
+ * @struct EntryHeader
+ * @brief 记录头
+ */
+struct EntryHeader {
+    quint8 kind; ///< 记录类型
+    quint8 type; ///< 值类型（EntryValue）
+    quint8 quality; ///< 质量码
+    quint8 reserved; ///< 保留
+    quint32 id; ///< 点位句柄
+    qint64 timestamp; ///< 源时间戳（毫秒）
+    quint64 payload; ///< 值的二进制表示，或其后可变长数据的字节数
+};
+static_assert(sizeof(EntryHeader) == 24, "journal entry header must stay 24 bytes");
+
+/**
+ * @struct Crc32Tables
+ * @brief 按8字节切片计算CRC32的查找表
+ */
+struct Crc32Tables {
+    quint32 table[8][256];
+};
+
+constexpr Crc32Tables makeCrc32Tables()
+{
+    Crc32Tables tables{};
+    for (quint32 i = 0; i < 256; ++i) {
+        quint32 crc = i;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc >> 1) ^ ((crc & 1) ? 0xEDB88320u : 0u);
+        }
+        tables.table[0][i] = crc;
+    }
+    for (int k = 1; k < 8; ++k) {
+        for (quint32 i = 0; i < 256; ++i) {
+            const quint32 previous = tables.table[k - 1][i];
+            tables.table[k][i] = (previous >> 8) ^ tables.table[0][previous & 0xFF];
+        }
+    }
+    return tables;
+}
+
+constexpr Crc32Tables Crc32 = makeCrc32Tables();
+
+/**
+ * @brief 计算CRC32（IEEE 802.3多项式）
+ * @param data 数据
+ * @param size 字节数
+ * @return 校验值
+ */
+quint32 crc32(const char *data, qint64 size)
+{
+    const uchar *p = reinterpret_cast<const uchar *>(data);
+    quint32 crc = 0xFFFFFFFFu;
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    // Checkpoints are tens of megabytes; eight bytes per step keeps the checksum off the startup path
+    while (size >= 8) {
+        quint32 one;
+        quint32 two;
+        std::memcpy(&one, p, 4);
+        std::memcpy(&two, p + 4, 4);
+        one ^= crc;
+        crc = Crc32.table[7][one & 0xFF] ^ Crc32.table[6][(one >> 8) & 0xFF]
+            ^ Crc32.table[5][(one >> 16) & 0xFF] ^ Crc32.table[4][one >> 24]
+            ^ Crc32.table[3][two & 0xFF] ^ Crc32.table[2][(two >> 8) & 0xFF]
+            ^ Crc32.table[1][(two >> 16) & 0xFF] ^ Crc32.table[0][two >> 24];
+        p += 8;
+        size -= 8;
+    }
+#endif
+    while (size-- > 0) {
+        crc = Crc32.table[0][(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+/**
+ * @brief 把文件内容刷到磁盘
+ * @param file 已打开的文件
+ * @return 是否成功
+ */
+bool syncFile(QFile &file)
+{
+    if (!file.flush()) {
+        return false;
+    }
+#ifdef Q_OS_WIN
+    return ::FlushFileBuffers(HANDLE(::_get_osfhandle(file.handle()))) != 0;
+#else
+    return ::fsync(file.handle()) == 0;
+#endif
+}
+
+/**
+ * @brief 生成文件头
+ * @param magic 文件标识
+ * @param generation 代数
+ * @return 文件头
+ */
+QByteArray fileHeader(const char *magic, quint64 generation)
+{
+    QByteArray header(magic, 4);
+    header.append(reinterpret_cast<const char *>(&FormatVersion), sizeof(FormatVersion));
+    header.append(reinterpret_cast<const char *>(&generation), sizeof(generation));
+    return header;
+}
+
+void appendHeader(QByteArray *buffer, HYTagJournal::EntryKind kind, quint8 type, quint8 quality, quint32 id,
+                  qint64 timestamp, quint64 payload)
+{
+    const EntryHeader header = {quint8(kind), type, quality, 0, id, timestamp, payload};
+    buffer->append(reinterpret_cast<const char *>(&header), sizeof(header));
+}
+
+void appendString(QByteArray *buffer, const QString &text)
+{
+    const QByteArray utf8 = text.toUtf8();
+    const quint32 size = quint32(utf8.size());
+    buffer->append(reinterpret_cast<const char *>(&size), sizeof(size));
+    buffer->append(utf8);
+}
+
+/**
+ * @brief 读取长度前缀的UTF-8字符串
+ * @param data 数据起始
+ * @param end 数据结束
+ * @param text 输出字符串
+ * @return 字符串之后的位置，越界时为空
+ */
+const char *readString(const char *data, const char *end, QString *text)
+{
+    quint32 size;
+    if (end - data < qint64(sizeof(size))) {
+        return nullptr;
+    }
+    std::memcpy(&size, data, sizeof(size));
+    data += sizeof(size);
+    if (end - data < qint64(size)) {
+        return nullptr;
+    }
+    *text = QString::fromUtf8(data, qsizetype(size));
+    return data + size;
+}
+
+/**
+ * @brief 解码一个块内的全部记录
+ * @param data 块负载起始
+ * @param end 块负载结束
+ * @param visitor 每条记录的回调
+ * @return 负载是否完整
+ */
+bool decodeEntries(const char *data, const char *end, const std::function<void(const HYTagJournal::Entry &)> &visitor)
+{
+    HYTagJournal::Entry entry;
+    while (data < end) {
+        EntryHeader header;
+        if (end - data < qint64(sizeof(header))) {
+            return false;
+        }
+        std::memcpy(&header, data, sizeof(header));
+        data += sizeof(header);
+
+        entry.kind = HYTagJournal::EntryKind(header.kind);
+        entry.id = header.id;
+        entry.timestamp = header.timestamp;
+        entry.quality = header.quality;
+
+        switch (entry.kind) {
+        case HYTagJournal::EntryDefine: {
+            if (header.payload > quint64(end - data)) {
+                return false;
+            }
+            const char *next = data + header.payload;
+            data = readString(data, next, &entry.name);
+            data = data ? readString(data, next, &entry.group) : nullptr;
+            data = data ? readString(data, next, &entry.description) : nullptr;
+            data = data ? readString(data, next, &entry.source) : nullptr;
+            if (data != next) {
+                return false;
+            }
+            break;
+        }
+        case HYTagJournal::EntryValue:
+            if (header.type == HYTagValue::String) {
+                if (header.payload > quint64(end - data)) {
+                    return false;
+                }
+                const QString text = QString::fromUtf8(data, qsizetype(header.payload));
+                entry.value = HYTagValue::fromString(text);
+                if (entry.value.isNull()) {
+                    // Text the string pool does not take is replayed as a complex value
+                    entry.kind = HYTagJournal::EntryComplex;
+                    entry.complex = text;
+                }
+                data += header.payload;
+            } else if (header.type <= HYTagValue::Double) {
+                entry.value = HYTagValue::fromRaw(HYTagValue::Type(header.type), header.payload);
+            } else {
+                return false;
+            }
+            break;
+        case HYTagJournal::EntryComplex: {
+            if (header.payload > quint64(end - data)) {
+                return false;
+            }
+            QDataStream in(QByteArray::fromRawData(data, qsizetype(header.payload)));
+            in.setVersion(QDataStream::Qt_6_0);
+            in >> entry.complex;
+            data += header.payload;
+            break;
+        }
+        case HYTagJournal::EntryRemove:
+            break;
+        default:
+            return false;
+        }
+
+        visitor(entry);
+    }
+    return true;
+}
+
+} // namespace
+
+HYTagJournal::HYTagJournal(const QString &path) :
+    m_path(path),
+    m_baseGeneration(0),
+    m_generation(0)
+{
+    // Pick up where the files on disk left off so that a new generation never overwrites a live journal
+    QFile checkpoint(m_path);
+    if (checkpoint.open(QIODevice::ReadOnly)) {
+        readHeader(checkpoint.read(HeaderSize), CheckpointMagic, &m_baseGeneration);
+    }
+    m_generation = m_baseGeneration;
+    while (QFile::exists(journalPath(m_generation + 1))) {
+        ++m_generation;
+    }
+}
+
+HYTagJournal::~HYTagJournal()
+{
+    close();
+}
+
+void HYTagJournal::appendDefine(QByteArray *buffer, quint32 id, const QString &name, const QString &group,
+                                const QString &description, const QString &source)
+{
+    // Reserve the header, then patch in the length once the strings are written
+    const qsizetype start = buffer->size();
+    appendHeader(buffer, EntryDefine, 0, 0, id, 0, 0);
+    appendString(buffer, name);
+    appendString(buffer, group);
+    appendString(buffer, description);
+    appendString(buffer, source);
+
+    const quint64 payload = quint64(buffer->size() - start - qsizetype(sizeof(EntryHeader)));
+    std::memcpy(buffer->data() + start + offsetof(EntryHeader, payload), &payload, sizeof(payload));
+}
+
+void HYTagJournal::appendValue(QByteArray *buffer, quint32 id, const HYTagValue &value, qint64 timestamp, quint8 quality)
+{
+    if (value.type() != HYTagValue::String) {
+        appendHeader(buffer, EntryValue, value.type(), quality, id, timestamp, value.bits());
+        return;
+    }
+
+    // Interned string ids are only meaningful within one process; store the text
+    const QByteArray utf8 = value.toString().toUtf8();
+    appendHeader(buffer, EntryValue, HYTagValue::String, quality, id, timestamp, quint64(utf8.size()));
+    buffer->append(utf8);
+}
+
+void HYTagJournal::appendComplex(QByteArray *buffer, quint32 id, const QVariant &value, qint64 timestamp, quint8 quality)
+{
+    QByteArray bytes;
+    QDataStream out(&bytes, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_6_0);
+    out << value;
+
+    appendHeader(buffer, EntryComplex, 0, quality, id, timestamp, quint64(bytes.size()));
+    buffer->append(bytes);
+}
+
+void HYTagJournal::appendRemove(QByteArray *buffer, quint32 id)
+{
+    appendHeader(buffer, EntryRemove, 0, 0, id, 0, 0);
+}
+
+QString HYTagJournal::path() const
+{
+    return m_path;
+}
+
+quint64 HYTagJournal::generation() const
+{
+    return m_generation;
+}
+
+bool HYTagJournal::isOpen() const
+{
+    return m_file.isOpen();
+}
+
+qint64 HYTagJournal::size() const
+{
+    return m_file.isOpen() ? m_file.size() : 0;
+}
+
+bool HYTagJournal::replay(const std::function<void(const Entry &)> &visitor, QString *error)
+{
+    quint64 generation = 0;
+    QFile checkpoint(m_path);
+    if (checkpoint.open(QIODevice::ReadOnly)) {
+        const QByteArray data = checkpoint.readAll();
+        checkpoint.close();
+
+        // A checkpoint is committed atomically, so anything short of a complete file is real damage
+        if (!readHeader(data, CheckpointMagic, &generation)
+            || decodeBlocks(data, HeaderSize, visitor) != data.size()) {
+            if (error) {
+                *error = QStringLiteral("corrupt checkpoint %1").arg(m_path);
+            }
+            return false;
+        }
+    }
+
+    // Journal N holds the changes made after checkpoint N; later journals exist only if a
+    // checkpoint was interrupted, and their records still apply in order
+    for (quint64 next = generation; next == generation || QFile::exists(journalPath(next)); ++next) {
+        QFile journal(journalPath(next));
+        if (!journal.open(QIODevice::ReadOnly)) {
+            continue;
+        }
+        const QByteArray data = journal.readAll();
+        quint64 journalGeneration = 0;
+        if (readHeader(data, JournalMagic, &journalGeneration) && journalGeneration == next) {
+            decodeBlocks(data, HeaderSize, visitor);
+        }
+    }
+    return true;
+}
+
+bool HYTagJournal::append(const QByteArray &entries)
+{
+    if (!m_file.isOpen() || entries.isEmpty()) {
+        return m_file.isOpen();
+    }
+    const QByteArray header = blockHeader(entries);
+    return m_file.write(header) == header.size() && m_file.write(entries) == entries.size();
+}
+
+bool HYTagJournal::sync()
+{
+    return !m_file.isOpen() || syncFile(m_file);
+}
+
+bool HYTagJournal::rotate()
+{
+    close();
+
+    // The new journal never reuses a generation that is still on disk
+    const quint64 next = m_generation + 1;
+    m_file.setFileName(journalPath(next));
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+    m_generation = next;
+    const QByteArray header = fileHeader(JournalMagic, m_generation);
+    return m_file.write(header) == header.size() && syncFile(m_file);
+}
+
+bool HYTagJournal::writeCheckpoint(const QByteArray &entries)
+{
+    QSaveFile file(m_path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    file.write(fileHeader(CheckpointMagic, m_generation));
+    file.write(blockHeader(entries));
+    file.write(entries);
+    if (!file.commit()) {
+        return false;
+    }
+
+    // Journals before this generation are fully covered by the checkpoint
+    for (quint64 generation = m_baseGeneration; generation < m_generation; ++generation) {
+        QFile::remove(journalPath(generation));
+    }
+    m_baseGeneration = m_generation;
+    return true;
+}
+
+void HYTagJournal::close()
+{
+    if (m_file.isOpen()) {
+        syncFile(m_file);
+        m_file.close();
+    }
+}
+
+QString HYTagJournal::journalPath(quint64 generation) const
+{
+    return QStringLiteral("%1.%2.wal").arg(m_path).arg(generation);
+}
+
+QByteArray HYTagJournal::blockHeader(const QByteArray &entries)
+{
+    const quint32 header[2] = {quint32(entries.size()), crc32(entries.constData(), entries.size())};
+    return QByteArray(reinterpret_cast<const char *>(header), sizeof(header));
+}
+
+qint64 HYTagJournal::decodeBlocks(const QByteArray &data, qint64 offset, const std::function<void(const Entry &)> &visitor)
+{
+    const char *base = data.constData();
+    const qint64 size = data.size();
+    while (size - offset >= BlockHeaderSize) {
+        quint32 header[2];
+        std::memcpy(header, base + offset, sizeof(header));
+        const qint64 length = header[0];
+
+        // A torn or corrupted block ends the readable part of the file
+        if (size - offset - BlockHeaderSize < length
+            || crc32(base + offset + BlockHeaderSize, length) != header[1]) {
+            break;
+        }
+        const char *entries = base + offset + BlockHeaderSize;
+        if (!decodeEntries(entries, entries + length, visitor)) {
+            break;
+        }
+        offset += BlockHeaderSize + length;
+    }
+    return offset;
+}
+
+bool HYTagJournal::readHeader(const QByteArray &data, const char *magic, quint64 *generation)
+{
+    if (data.size() < HeaderSize || std::memcmp(data.constData(), magic, 4) != 0) {
+        return false;
+    }
+    quint32 version;
+    std::memcpy(&version, data.constData() + 4, sizeof(version));
+    if (version != FormatVersion) {
+        return false;
+    }
+    std::memcpy(generation, data.constData() + 8, sizeof(*generation));
+    return true;
+}
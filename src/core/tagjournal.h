@@ -0,0 +1,227 @@
+#ifndef HYTAGJOURNAL_H
+#define HYTAGJOURNAL_H
+
+#include <QString>
+#include <QByteArray>
+#include <QVariant>
+#include <QFile>
+#include <QtGlobal>
+#include <functional>
+#include "tagvalue.h"
+
+/**
+ * @file tagjournal.h
+ * @brief 点位状态日志头文件
+ *
+ * 点位状态由一个检查点文件和其后的若干日志文件组成：
+ * 检查点保存某一代开始时的全部点位定义和值，日志按顺序追加此后的点位增删和值变化
+ * 每个日志块带长度和CRC32，崩溃时写了一半的块在恢复时被丢弃，之前的块不受影响
+ */
+
+/**
+ * @class HYTagJournal
+ * @brief 点位状态日志
+ *
+ * 记录编码为本机字节序的定长头加可变长负载，由调用方在各自的缓冲区中拼接，再整块追加
+ * 文件布局：检查点为path，第N代日志为path.N.wal；写入新检查点前先切换到下一代日志，
+ * 检查点提交后删除更早的日志，任何时刻崩溃都能由最新的检查点和其后的日志恢复
+ * 非线程安全，由调用方加锁
+ */
+class HYTagJournal
+{
+public:
+    static constexpr int SyncInterval = 50; ///< 日志落盘周期（毫秒），周期内的变化合并为一次fsync
+    static constexpr qint64 CheckpointBytes = qint64(64) << 20; ///< 日志超过此大小时写入新检查点
+
+    /**
+     * @enum EntryKind
+     * @brief 记录类型
+     */
+    enum EntryKind : quint8 {
+        EntryDefine = 1, ///< 点位定义：名称、组、描述、来源
+        EntryValue,      ///< 类型化点位值
+        EntryComplex,    ///< 无法表示为HYTagValue的点位值
+        EntryRemove      ///< 点位删除
+    };
+
+    /**
+     * @struct Entry
+     * @brief 回放时解码出的记录
+     */
+    struct Entry {
+        EntryKind kind = EntryValue; ///< 记录类型
+        quint32 id = 0; ///< 写入时的点位句柄，只在同一检查点及其日志内有意义
+        HYTagValue value; ///< 类型化值（EntryValue）
+        QVariant complex; ///< 其他值（EntryComplex）
+        qint64 timestamp = 0; ///< 源时间戳（毫秒）
+        quint8 quality = 0; ///< 质量码
+        QString name; ///< 点位名称（EntryDefine）
+        QString group; ///< 点位组（EntryDefine）
+        QString description; ///< 点位描述（EntryDefine）
+        QString source; ///< 点位来源（EntryDefine）
+    };
+
+    /**
+     * @brief 构造函数
+     *
+     * 只读取已有文件的代数，不打开日志；首次写入检查点时才开始记录
+     * @param path 检查点文件路径
+     */
+    explicit HYTagJournal(const QString &path);
+
+    /**
+     * @brief 析构函数，落盘并关闭日志
+     */
+    ~HYTagJournal();
+
+    HYTagJournal(const HYTagJournal &) = delete;
+    HYTagJournal &operator=(const HYTagJournal &) = delete;
+
+    /**
+     * @brief 追加点位定义记录
+     * @param buffer 记录缓冲区
+     * @param id 点位句柄
+     * @param name 点位名称
+     * @param group 点位组
+     * @param description 点位描述
+     * @param source 点位来源
+     */
+    static void appendDefine(QByteArray *buffer, quint32 id, const QString &name, const QString &group,
+                             const QString &description, const QString &source);
+
+    /**
+     * @brief 追加类型化值记录
+     * @param buffer 记录缓冲区
+     * @param id 点位句柄
+     * @param value 点位值
+     * @param timestamp 源时间戳（毫秒）
+     * @param quality 质量码
+     */
+    static void appendValue(QByteArray *buffer, quint32 id, const HYTagValue &value, qint64 timestamp, quint8 quality);
+
+    /**
+     * @brief 追加其他值记录
+     * @param buffer 记录缓冲区
+     * @param id 点位句柄
+     * @param value 点位值
+     * @param timestamp 源时间戳（毫秒）
+     * @param quality 质量码
+     */
+    static void appendComplex(QByteArray *buffer, quint32 id, const QVariant &value, qint64 timestamp, quint8 quality);
+
+    /**
+     * @brief 追加点位删除记录
+     * @param buffer 记录缓冲区
+     * @param id 点位句柄
+     */
+    static void appendRemove(QByteArray *buffer, quint32 id);
+
+    /**
+     * @brief 获取检查点文件路径
+     * @return 文件路径
+     */
+    QString path() const;
+
+    /**
+     * @brief 获取当前代数
+     * @return 当前日志的代数，尚未打开日志时为磁盘上最新的代数
+     */
+    quint64 generation() const;
+
+    /**
+     * @brief 检查日志是否已打开
+     * @return 是否已打开
+     */
+    bool isOpen() const;
+
+    /**
+     * @brief 获取当前日志大小
+     * @return 字节数
+     */
+    qint64 size() const;
+
+    /**
+     * @brief 按顺序回放检查点和其后的日志
+     *
+     * 日志末尾不完整或校验失败的块及其后的内容被忽略
+     * @param visitor 每条记录的回调
+     * @param error 错误信息，可为空
+     * @return 检查点不存在或完整读取时为true，检查点损坏时为false
+     */
+    bool replay(const std::function<void(const Entry &)> &visitor, QString *error = nullptr);
+
+    /**
+     * @brief 把一段记录作为一个校验块追加到日志
+     * @param entries 记录
+     * @return 是否成功
+     */
+    bool append(const QByteArray &entries);
+
+    /**
+     * @brief 把已追加的日志刷到磁盘
+     * @return 是否成功
+     */
+    bool sync();
+
+    /**
+     * @brief 切换到下一代日志
+     *
+     * 当前日志落盘后关闭，之后追加的记录写入新一代日志
+     * @return 是否成功
+     */
+    bool rotate();
+
+    /**
+     * @brief 写入当前代的检查点
+     *
+     * 检查点通过临时文件原子替换，提交后删除更早的日志
+     * @param entries 当前代开始时全部点位的定义和值记录
+     * @return 是否成功
+     */
+    bool writeCheckpoint(const QByteArray &entries);
+
+    /**
+     * @brief 落盘并关闭日志
+     */
+    void close();
+
+    /**
+     * @brief 生成一段记录的块头
+     * @param entries 块负载
+     * @return 负载长度和CRC32
+     */
+    static QByteArray blockHeader(const QByteArray &entries);
+
+    /**
+     * @brief 逐块解码文件内容中的记录
+     * @param data 文件内容
+     * @param offset 第一个块的偏移
+     * @param visitor 每条记录的回调
+     * @return 最后一个完整有效的块之后的偏移
+     */
+    static qint64 decodeBlocks(const QByteArray &data, qint64 offset, const std::function<void(const Entry &)> &visitor);
+
+private:
+    /**
+     * @brief 获取某一代日志的文件路径
+     * @param generation 代数
+     * @return 文件路径
+     */
+    QString journalPath(quint64 generation) const;
+
+    /**
+     * @brief 读取文件头中的代数
+     * @param data 文件内容
+     * @param magic 文件标识
+     * @param generation 输出代数
+     * @return 文件头是否有效
+     */
+    static bool readHeader(const QByteArray &data, const char *magic, quint64 *generation);
+
+    QString m_path; ///< 检查点文件路径
+    quint64 m_baseGeneration; ///< 最新检查点的代数
+    quint64 m_generation; ///< 当前日志的代数
+    QFile m_file; ///< 当前日志文件
+};
+
+#endif // HYTAGJOURNAL_H
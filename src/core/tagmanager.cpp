@@ -1,8 +1,19 @@
 #include "tagmanager.h"
-#include <QJsonObject>
+#include "offlinereplayer.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QDataStream>
 #include <QJsonArray>
-#include <QJsonValue>
 #include <QJsonDocument>
+#include <QJsonObject>
+#include <QStringList>
+#include <QtMath>
+#include <QtAlgorithms>
+#include <QVarLengthArray>
+#include <bit>
+#include <cmath>
+#include <limits>
 
 /**
  * @file tagmanager.cpp
@@ -16,7 +27,9 @@
 // HYTag class implementation
 
 HYTag::HYTag(QObject *parent) : QObject(parent),
-    m_hySignalEnabled(true)
+    m_hySignalEnabled(true),
+    m_hyManager(nullptr),
+    m_hyTagId(HYInvalidTagId)
 {
 }
 
@@ -28,7 +41,9 @@ HYTag::HYTag(const QString &name, const QString &group, const QVariant &value,
       m_hyValue(value),
       m_hyDescription(description),
       m_hySource(source),
-      m_hySignalEnabled(true)
+      m_hySignalEnabled(true),
+      m_hyManager(nullptr),
+      m_hyTagId(HYInvalidTagId)
 {
 }
 
@@ -44,6 +59,9 @@ QString HYTag::group() const
 
 QVariant HYTag::value() const
 {
+    if (m_hyManager) {
+        return m_hyManager->value(m_hyTagId);
+    }
     return m_hyValue;
 }
 
@@ -57,8 +75,29 @@ QString HYTag::source() const
     return m_hySource;
 }
 
+qint64 HYTag::timestamp() const
+{
+    return m_hyManager ? m_hyManager->timestamp(m_hyTagId) : 0;
+}
+
+qint64 HYTag::serverTimestamp() const
+{
+    return m_hyManager ? m_hyManager->serverTimestamp(m_hyTagId) : 0;
+}
+
+int HYTag::quality() const
+{
+    return m_hyManager ? m_hyManager->quality(m_hyTagId) : int(HYTagValueStore::QualityGood);
+}
+
 void HYTag::setValue(const QVariant &value)
 {
+    // Tags owned by a manager keep their value in the manager's store
+    if (m_hyManager) {
+        m_hyManager->setValue(m_hyTagId, value);
+        return;
+    }
+
     if (m_hyValue != value) {
         m_hyValue = value;
         if (m_hySignalEnabled) {
@@ -77,25 +116,461 @@ void HYTag::setSignalEnabled(bool enabled)
     m_hySignalEnabled = enabled;
 }
 
+HYTagId HYTag::tagId() const
+{
+    return m_hyTagId;
+}
+
 // HYTagManager class implementation
 
-HYTagManager::HYTagManager(QObject *parent) : QObject(parent),
+namespace {
+
+/**
+ * @brief 将分片数规整为不超过上限的2的幂
+ * @param shardCount 期望的分片数
+ * @return 分片数
+ */
+int normalizeShardCount(int shardCount)
+{
+    shardCount = qBound(1, shardCount, HYTagValueStore::MaxShards);
+    return int(qNextPowerOfTwo(quint32(shardCount - 1)));
+}
+
+const char TagFileMagic[] = "HYTG"; ///< 二进制点位定义文件标识
+constexpr quint16 TagFileVersion = 1; ///< 二进制点位定义文件版本
+
+/**
+ * @brief 从CSV文本中读取一条记录
+ *
+ * 支持双引号包围的字段（字段内的双引号写作两个双引号），空行被跳过
+ * @param text CSV文本
+ * @param position 输入输出读取位置
+ * @param record 输出字段列表
+ * @return 是否读到记录，到达末尾时为false
+ */
+bool readCsvRecord(const QString &text, qsizetype *position, QStringList *record)
+{
+    record->clear();
+    const qsizetype length = text.size();
+    qsizetype i = *position;
+    while (i < length && (text.at(i) == u'\n' || text.at(i) == u'\r')) {
+        ++i;
+    }
+    if (i >= length) {
+        *position = i;
+        return false;
+    }
+
+    for (;;) {
+        QString field;
+        if (i < length && text.at(i) == u'"') {
+            ++i;
+            for (;;) {
+                const qsizetype quote = text.indexOf(u'"', i);
+                if (quote < 0) {
+                    field += QStringView(text).mid(i);
+                    i = length;
+                    break;
+                }
+                field += QStringView(text).mid(i, quote - i);
+                i = quote + 1;
+                if (i < length && text.at(i) == u'"') {
+                    field += u'"';
+                    ++i;
+                } else {
+                    break;
+                }
+            }
+        }
+
+        // Unquoted fields are taken as one slice rather than character by character
+        const qsizetype start = i;
+        while (i < length && text.at(i) != u',' && text.at(i) != u'\n' && text.at(i) != u'\r') {
+            ++i;
+        }
+        field += QStringView(text).mid(start, i - start);
+        record->append(field);
+
+        if (i < length && text.at(i) == u',') {
+            ++i;
+            continue;
+        }
+        break;
+    }
+
+    *position = i;
+    return true;
+}
+
+/**
+ * @brief 解析CSV中的点位值
+ * @param text 字段文本
+ * @return 空、布尔、整数、浮点数或字符串值
+ */
+QVariant parseCsvValue(const QString &text)
+{
+    if (text.isEmpty()) {
+        return QVariant();
+    }
+    if (text == QLatin1String("true")) {
+        return true;
+    }
+    if (text == QLatin1String("false")) {
+        return false;
+    }
+
+    bool ok = false;
+    const qlonglong integer = text.toLongLong(&ok);
+    if (ok) {
+        return integer;
+    }
+    const double number = text.toDouble(&ok);
+    if (ok) {
+        return number;
+    }
+    return text;
+}
+
+/**
+ * @brief 把文本转为CSV字段，必要时加引号
+ * @param text 文本
+ * @return CSV字段
+ */
+QString csvField(const QString &text)
+{
+    if (!text.contains(u',') && !text.contains(u'"') && !text.contains(u'\n') && !text.contains(u'\r')) {
+        return text;
+    }
+    QString quoted = text;
+    quoted.replace(QLatin1String("\""), QLatin1String("\"\""));
+    return QLatin1Char('"') + quoted + QLatin1Char('"');
+}
+
+/**
+ * @brief 把点位值转为CSV字段
+ * @param value 点位值
+ * @return CSV字段
+ */
+QString csvValue(const QVariant &value)
+{
+    if (!value.isValid() || value.isNull()) {
+        return QString();
+    }
+    switch (value.metaType().id()) {
+    case QMetaType::Bool:
+        return value.toBool() ? QStringLiteral("true") : QStringLiteral("false");
+    case QMetaType::Double:
+    case QMetaType::Float:
+        return QString::number(value.toDouble(), 'g', 17);
+    default:
+        return csvField(value.toString());
+    }
+}
+
+/**
+ * @brief 解析CSV点位定义
+ * @param data 文件内容
+ * @param definitions 输出点位定义
+ * @param error 输出错误信息
+ * @return 是否成功
+ */
+bool readCsvDefinitions(const QByteArray &data, QVector<HYTagDefinition> *definitions, QString *error)
+{
+    const QString text = QString::fromUtf8(data);
+    qsizetype position = 0;
+    QStringList record;
+    if (!readCsvRecord(text, &position, &record)) {
+        *error = QStringLiteral("empty tag file");
+        return false;
+    }
+
+    // Columns are located by header name so that files may omit or reorder them
+    int nameColumn = -1, groupColumn = -1, valueColumn = -1, descriptionColumn = -1, sourceColumn = -1;
+    for (int i = 0; i < record.size(); ++i) {
+        const QString column = record[i].trimmed().toLower();
+        if (column == QLatin1String("name")) {
+            nameColumn = i;
+        } else if (column == QLatin1String("group")) {
+            groupColumn = i;
+        } else if (column == QLatin1String("value")) {
+            valueColumn = i;
+        } else if (column == QLatin1String("description")) {
+            descriptionColumn = i;
+        } else if (column == QLatin1String("source")) {
+            sourceColumn = i;
+        }
+    }
+    if (nameColumn < 0) {
+        *error = QStringLiteral("missing name column");
+        return false;
+    }
+
+    // Groups and sources repeat across many tags; share one string per distinct value
+    QHash<QString, QString> interned;
+    auto intern = [&interned](const QString &text) -> QString {
+        auto it = interned.constFind(text);
+        if (it == interned.constEnd()) {
+            it = interned.insert(text, text);
+        }
+        return it.value();
+    };
+    auto field = [&record](int column) -> QString {
+        return column >= 0 && column < record.size() ? record[column] : QString();
+    };
+
+    definitions->reserve(qsizetype(text.count(u'\n')));
+    int line = 1;
+    while (readCsvRecord(text, &position, &record)) {
+        ++line;
+        HYTagDefinition definition;
+        definition.name = field(nameColumn).trimmed();
+        if (definition.name.isEmpty()) {
+            *error = QStringLiteral("empty tag name at record %1").arg(line);
+            return false;
+        }
+        definition.group = intern(field(groupColumn));
+        definition.value = parseCsvValue(field(valueColumn));
+        definition.description = field(descriptionColumn);
+        definition.source = intern(field(sourceColumn));
+        definitions->append(definition);
+    }
+    return true;
+}
+
+/**
+ * @brief 解析二进制点位定义
+ * @param data 文件内容
+ * @param definitions 输出点位定义
+ * @param error 输出错误信息
+ * @return 是否成功
+ */
+bool readBinaryDefinitions(const QByteArray &data, QVector<HYTagDefinition> *definitions, QString *error)
+{
+    QDataStream in(data);
+    in.setVersion(QDataStream::Qt_6_0);
+    in.skipRawData(int(sizeof(TagFileMagic)) - 1);
+
+    quint16 version = 0;
+    in >> version;
+    if (version != TagFileVersion) {
+        *error = QStringLiteral("unsupported tag file version %1").arg(version);
+        return false;
+    }
+
+    QStringList groups;
+    QStringList sources;
+    quint32 count = 0;
+    in >> groups >> sources >> count;
+    if (in.status() != QDataStream::Ok) {
+        *error = QStringLiteral("truncated tag file header");
+        return false;
+    }
+
+    // Each record takes at least a few bytes, which bounds a corrupt count
+    definitions->reserve(qMin(qsizetype(count), qsizetype(data.size() / 8)));
+    for (quint32 i = 0; i < count; ++i) {
+        HYTagDefinition definition;
+        quint32 group = 0;
+        quint32 source = 0;
+        in >> definition.name >> group >> source >> definition.description >> definition.value;
+        if (in.status() != QDataStream::Ok || group >= quint32(groups.size()) || source >= quint32(sources.size())) {
+            *error = QStringLiteral("corrupt tag record %1").arg(i);
+            return false;
+        }
+        definition.group = groups.at(group);
+        definition.source = sources.at(source);
+        definitions->append(definition);
+    }
+    return true;
+}
+
+/**
+ * @brief 生成CSV点位定义
+ * @param definitions 点位定义
+ * @return 文件内容
+ */
+QByteArray writeCsvDefinitions(const QVector<HYTagDefinition> &definitions)
+{
+    QString text = QStringLiteral("name,group,value,description,source\n");
+    for (const HYTagDefinition &definition : definitions) {
+        text += csvField(definition.name) + QLatin1Char(',') + csvField(definition.group) + QLatin1Char(',')
+                + csvValue(definition.value) + QLatin1Char(',') + csvField(definition.description)
+                + QLatin1Char(',') + csvField(definition.source) + QLatin1Char('\n');
+    }
+    return text.toUtf8();
+}
+
+/**
+ * @brief 生成二进制点位定义
+ *
+ * 布局：标识、版本、组名表、数据来源表、点位数，随后每个点位依次为名称、组下标、来源下标、描述和值
+ * @param definitions 点位定义
+ * @return 文件内容
+ */
+QByteArray writeBinaryDefinitions(const QVector<HYTagDefinition> &definitions)
+{
+    QStringList groups;
+    QStringList sources;
+    QHash<QString, quint32> groupIndex;
+    QHash<QString, quint32> sourceIndex;
+    for (const HYTagDefinition &definition : definitions) {
+        if (!groupIndex.contains(definition.group)) {
+            groupIndex.insert(definition.group, quint32(groups.size()));
+            groups.append(definition.group);
+        }
+        if (!sourceIndex.contains(definition.source)) {
+            sourceIndex.insert(definition.source, quint32(sources.size()));
+            sources.append(definition.source);
+        }
+    }
+
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_6_0);
+    out.writeRawData(TagFileMagic, int(sizeof(TagFileMagic)) - 1);
+    out << TagFileVersion << groups << sources << quint32(definitions.size());
+    for (const HYTagDefinition &definition : definitions) {
+        out << definition.name << groupIndex.value(definition.group) << sourceIndex.value(definition.source)
+            << definition.description << definition.value;
+    }
+    return data;
+}
+
+/**
+ * @struct JournalTag
+ * @brief 回放日志时按写入时的句柄累积的点位状态
+ */
+struct JournalTag {
+    HYTagDefinition definition; ///< 点位定义，值不使用
+    HYTagValue value; ///< 最后的类型化值
+    QVariant complex; ///< 最后的其他值
+    bool isComplex = false; ///< 最后的值是否为其他值
+    qint64 timestamp = 0; ///< 最后的源时间戳（毫秒）
+    quint8 quality = HYTagValueStore::QualityGood; ///< 最后的质量码
+    bool defined = false; ///< 点位是否存在
+};
+
+/**
+ * @brief 判断文件是否为旧版本保存的JSON状态文件
+ * @param path 文件路径
+ * @return 是否为JSON状态文件
+ */
+bool isLegacyStateFile(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    const QByteArray head = file.read(64).trimmed();
+    return head.startsWith('{');
+}
+
+/**
+ * @brief 获取检查点文件路径
+ *
+ * 传入的路径仍是旧版本的JSON状态文件时，检查点写在它旁边，JSON文件保留原样
+ * @param persistFilePath 持久化文件路径
+ * @return 检查点文件路径
+ */
+QString checkpointPath(const QString &persistFilePath)
+{
+    return isLegacyStateFile(persistFilePath) ? persistFilePath + QStringLiteral(".state") : persistFilePath;
+}
+
+/**
+ * @brief 读取旧版本的JSON状态文件
+ * @param path 文件路径
+ * @param tags 输出点位状态
+ * @return 是否读取成功
+ */
+bool readLegacyState(const QString &path, QVector<JournalTag> *tags)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return false;
+    }
+    const QJsonDocument doc = QJsonDocument::fromJson(file.readAll());
+    if (!doc.isObject()) {
+        return false;
+    }
+
+    // The JSON kept neither quality nor timestamps; values come back as good data read now
+    const qint64 timestamp = QDateTime::currentMSecsSinceEpoch();
+    const QJsonArray entries = doc.object()["tags"].toArray();
+    tags->reserve(entries.size());
+    for (const auto &entry : entries) {
+        const QJsonObject object = entry.toObject();
+        JournalTag tag;
+        tag.definition = HYTagDefinition{object["name"].toString(), object["group"].toString(), QVariant(),
+                                         object["description"].toString(), object["source"].toString()};
+        const QVariant value = object["value"].toVariant();
+        tag.isComplex = !HYTagValue::fromVariant(value, &tag.value);
+        if (tag.isComplex) {
+            tag.complex = value;
+        }
+        tag.timestamp = timestamp;
+        tag.defined = true;
+        tags->append(tag);
+    }
+    return true;
+}
+
+} // namespace
+
+HYTagManager::HYTagManager(QObject *parent) : HYTagManager(DefaultShardCount, parent)
+{
+}
+
+HYTagManager::HYTagManager(int shardCount, QObject *parent) : QObject(parent),
+    m_hyValueStore(normalizeShardCount(shardCount)),
+    m_hyShardBits(qCountTrailingZeroBits(quint32(m_hyValueStore.shardCount()))),
+    m_hyShards(new Shard[m_hyValueStore.shardCount()]),
     m_hyDelayedNotification(false),
     m_hyNotificationInterval(50),
     m_hyNotificationTimer(nullptr),
+    m_hyNotificationTick(0),
+    m_hySubscriberCount(0),
+    m_hyAllTagsSubscribers(0),
+    m_hyFilterTimer(nullptr),
     m_hyHistoryEnabled(false),
     m_hyHistoryInterval(1000),
     m_hyHistoryTimer(nullptr),
     m_hyHistoryRetentionDays(365),
+    m_hyHistoryDeadband(0.0),
+    m_hyHistoryHeartbeat(DefaultHistoryHeartbeat),
+    m_hyHistoryCursor(0),
+    m_hyCalcScheduled(false),
     m_hyPersistEnabled(false),
+    m_hyJournalActive(false),
+    m_hyJournalThread(nullptr),
+    m_hyJournalStopping(false),
     m_hyOfflineMode(false),
+    m_hyOfflineBuffer(QDir::homePath() + "/.huayan/offline"),
+    m_hyOfflineMemoryBytes(HYOfflineBuffer::DefaultMemoryBytes),
+    m_hyOfflineReplayer(nullptr),
     m_hySyncTimer(nullptr),
     m_hySyncInterval(5000)
 {
-    // Initialize notification timer
+    // Initialize notification timer; it runs at a fixed cadence and is never restarted by writers
     m_hyNotificationTimer = new QTimer(this);
-    connect(m_hyNotificationTimer, &QTimer::timeout, this, &HYTagManager::onDelayedNotification);
-    m_hyNotificationTimer->setSingleShot(true);
+    connect(m_hyNotificationTimer, &QTimer::timeout, this, &HYTagManager::onNotificationTick);
+    m_hyNotificationTimer->setTimerType(Qt::PreciseTimer);
+    m_hyNotificationClock.start();
+
+    // Slot 0 is the built-in subscriber that serves delayed notification mode
+    for (int i = 0; i < MaxSubscribers; ++i) {
+        m_hySubscribers[i].store(nullptr, std::memory_order_relaxed);
+    }
+    Subscriber *delayed = new Subscriber;
+    delayed->allTags = true;
+    delayed->maxLatency.store(m_hyNotificationInterval, std::memory_order_relaxed);
+    m_hySubscribers[DelayedSubscriber].store(delayed, std::memory_order_release);
+    m_hySubscriberCount.store(1, std::memory_order_release);
+
+    // Initialize filter flush timer
+    m_hyFilterTimer = new QTimer(this);
+    connect(m_hyFilterTimer, &QTimer::timeout, this, &HYTagManager::onFilterFlush);
+    m_hyFilterTimer->setSingleShot(true);
     
     // Initialize history timer
     m_hyHistoryTimer = new QTimer(this);
@@ -104,6 +579,13 @@ HYTagManager::HYTagManager(QObject *parent) : QObject(parent),
     // Initialize sync timer
     m_hySyncTimer = new QTimer(this);
     connect(m_hySyncTimer, &QTimer::timeout, this, &HYTagManager::onSyncOfflineData);
+
+    // Initialize offline replay; a sync completes when the backlog has been written to the historian
+    m_hyOfflineReplayer = new HYOfflineReplayer(&m_hyOfflineBuffer, this);
+    connect(m_hyOfflineReplayer, &HYOfflineReplayer::progress, this, &HYTagManager::offlineReplayProgress);
+    connect(m_hyOfflineReplayer, &HYOfflineReplayer::finished, this, [this](bool success, qint64 replayed) {
+        emit syncCompleted(success, int(replayed));
+    });
     
     // Initialize database for historical data
     QDir dataDir(QDir::homePath() + "/.huayan/data");
@@ -111,27 +593,30 @@ HYTagManager::HYTagManager(QObject *parent) : QObject(parent),
         dataDir.mkpath(".");
     }
     
-    m_hyDatabase = QSqlDatabase::addDatabase("QSQLITE");
-    m_hyDatabase.setDatabaseName(dataDir.absolutePath() + "/history.db");
-    if (m_hyDatabase.open()) {
-        // Create history table if not exists
-        QSqlQuery query;
-        query.exec("CREATE TABLE IF NOT EXISTS history (id INTEGER PRIMARY KEY AUTOINCREMENT, tag_name TEXT, value TEXT, timestamp TEXT)");
-        query.exec("CREATE INDEX IF NOT EXISTS idx_tag_name_timestamp ON history (tag_name, timestamp)");
-    }
+    m_hyHistory.open(dataDir.absolutePath() + "/history.db");
     
     // Set default persist file path
-    m_hyPersistFilePath = QDir::homePath() + "/.huayan/persist.json";
+    m_hyPersistFilePath = QDir::homePath() + "/.huayan/persist.state";
 }
 
 HYTagManager::~HYTagManager()
 {
+    // Write out buffered journal records; the next start replays them without a fresh checkpoint
+    stopJournal();
+    m_hyJournal.reset();
+
     // Stop and clean up timers
     if (m_hyNotificationTimer) {
         m_hyNotificationTimer->stop();
         delete m_hyNotificationTimer;
         m_hyNotificationTimer = nullptr;
     }
+
+    if (m_hyFilterTimer) {
+        m_hyFilterTimer->stop();
+        delete m_hyFilterTimer;
+        m_hyFilterTimer = nullptr;
+    }
     
     if (m_hyHistoryTimer) {
         m_hyHistoryTimer->stop();
@@ -145,618 +630,2459 @@ HYTagManager::~HYTagManager()
         m_hySyncTimer = nullptr;
     }
 
-    // Close database
-    if (m_hyDatabase.isOpen()) {
-        m_hyDatabase.close();
+    // The replayer uses the offline buffer, which is destroyed before the children are
+    delete m_hyOfflineReplayer;
+    m_hyOfflineReplayer = nullptr;
+
+    // Offline data still in memory goes to disk and is replayed after the next start
+    for (int i = 0; i < shardCount(); ++i) {
+        m_hyOfflineBuffer.spill(m_hyShards[i].offline);
     }
 
+    // Close database
+    m_hyHistory.close();
+
     // Clean up all tags
-    for (auto tag : m_hyTags.values()) {
-        delete tag;
+    for (int i = 0; i < shardCount(); ++i) {
+        for (HYTag *tag : m_hyShards[i].tags) {
+            delete tag;
+        }
     }
-    m_hyTags.clear();
+    m_hyShards.reset();
+    m_hyTagIds.clear();
     m_hyTagsByGroup.clear();
-    m_hyBindings.clear();
-    m_hyPendingValues.clear();
     m_hyImportantTags.clear();
-    m_hyOfflineData.clear();
+    m_hyGroupFilters.clear();
+
+    for (int i = 0; i < MaxSubscribers; ++i) {
+        delete m_hySubscribers[i].load(std::memory_order_relaxed);
+    }
 }
 
 bool HYTagManager::addTag(const QString &name, const QString &group, const QVariant &value, 
                          const QString &description, const QString &source)
 {
-    QMutexLocker locker(&m_hyMutex);
+    {
+        QMutexLocker locker(&m_hyMutex);
+        if (addTagLocked(name, group, value, description, source) == InvalidTagId) {
+            return false;
+        }
+    }
+
+    emit tagAdded(name);
+    return true;
+}
 
+HYTagManager::TagId HYTagManager::addTagLocked(const QString &name, const QString &group, const QVariant &value,
+                                               const QString &description, const QString &source)
+{
     // Check if tag already exists
-    if (m_hyTags.contains(name)) {
-        return false;
+    if (m_hyTagIds.contains(name)) {
+        return InvalidTagId;
+    }
+
+    QWriteLocker indexLocker(&m_hyIndexLock);
+
+    // Allocations are serialised by the index write lock, so the next handle and its shard are known up front
+    QMutexLocker shardLocker(&shardOf(m_hyValueStore.size()).mutex);
+    return insertTagLocked(name, group, value, description, source, QDateTime::currentMSecsSinceEpoch());
+}
+
+HYTagManager::TagId HYTagManager::insertTagLocked(const QString &name, const QString &group, const QVariant &value,
+                                                  const QString &description, const QString &source, qint64 timestamp)
+{
+    if (m_hyTagIds.contains(name)) {
+        return InvalidTagId;
+    }
+
+    // Allocate a slot in the value store; the slot index is the tag handle
+    Shard &shard = shardOf(m_hyValueStore.size());
+    const TagId id = m_hyValueStore.allocate(value, timestamp);
+    if (id == InvalidTagId) {
+        return InvalidTagId;
     }
 
-    // Create new tag
-    HYTag *tag = new HYTag(name, group, value, description, source, this);
-    m_hyTags[name] = tag;
+    // Create new tag; its value lives in the store, not in the HYTag object
+    // The manager deletes tags itself, so they are left parentless: a child list holding every tag
+    // would make each removal a linear search
+    HYTag *tag = new HYTag(name, group, QVariant(), description, source);
+    tag->m_hyManager = this;
+    tag->m_hyTagId = id;
+
+    m_hyTagIds.insert(name, id);
+    m_hyTagTrie.insert(name, id);
+    const int local = id >> m_hyShardBits;
+    if (shard.tags.size() <= local) {
+        shard.tags.resize(local + 1);
+    }
+    shard.tags[local] = tag;
     m_hyTagsByGroup[group].append(tag);
 
-    // Connect tag's valueChanged signal to our slot
-    connect(tag, &HYTag::valueChanged, this, &HYTagManager::onTagValueChanged);
+    // The definition precedes the tag's first value in the shard's journal buffer
+    if (m_hyJournalActive.load(std::memory_order_relaxed)) {
+        HYTagJournal::appendDefine(&shard.journal, quint32(id), name, group, description, source);
+    }
+    if (m_hySnapshot.isOpen()) {
+        restoreLastKnownLocked(id, name);
+    }
+    if (m_hySharedTable.isOpen()) {
+        m_hySharedTable.publish(id, name);
+    }
+    persistValueLocked(shard, id);
+
+    if (m_hyImportantTags.contains(name)) {
+        shard.importantTags.insert(id);
+    }
+
+    // Pattern subscribers whose pattern covers the new name start watching it
+    const quint64 subscribers = m_hyPatternTrie.matchPatterns(name);
+    if (subscribers) {
+        m_hyTagSubscribers.set(id, subscribers);
+    }
 
-    emit tagAdded(name);
-    return true;
+    // Tags joining a filtered group inherit the group filter
+    auto groupFilter = m_hyGroupFilters.constFind(group);
+    if (groupFilter != m_hyGroupFilters.constEnd()) {
+        installFilterLocked(shard, id, groupFilter.value(), false);
+    }
+
+    return id;
 }
 
 bool HYTagManager::removeTag(const QString &name)
 {
     QMutexLocker locker(&m_hyMutex);
+    QWriteLocker indexLocker(&m_hyIndexLock);
 
     // Check if tag exists
-    if (!m_hyTags.contains(name)) {
+    const TagId id = m_hyTagIds.value(name, InvalidTagId);
+    if (id == InvalidTagId) {
         return false;
     }
 
-    HYTag *tag = m_hyTags[name];
-    QString group = tag->group();
+    Shard &shard = shardOf(id);
+    HYTag *tag = nullptr;
+    {
+        QMutexLocker shardLocker(&shard.mutex);
+        tag = tagObject(id);
 
-    // Remove from group map
-    m_hyTagsByGroup[group].removeAll(tag);
-    if (m_hyTagsByGroup[group].isEmpty()) {
-        m_hyTagsByGroup.remove(group);
-    }
+        // Remove bindings, importance and filter state; pending notifications skip removed tags
+        for (const Binding &binding : shard.bindings.value(name)) {
+            disconnect(binding.destroyedConnection);
+        }
+        shard.bindings.remove(name);
+        shard.importantTags.remove(id);
+        shard.filterStates.remove(id);
+        shard.filterPending.remove(id);
 
-    // Remove bindings
-    if (m_hyBindings.contains(name)) {
-        m_hyBindings.remove(name);
-    }
+        if (m_hyJournalActive.load(std::memory_order_relaxed)) {
+            HYTagJournal::appendRemove(&shard.journal, quint32(id));
+        }
+        m_hySnapshot.erase(id);
+        m_hySharedTable.unpublish(id);
 
-    // Remove from pending values
-    if (m_hyPendingValues.contains(name)) {
-        m_hyPendingValues.remove(name);
+        // Release the store slot and drop the handle
+        m_hyValueStore.release(id);
+        shard.tags[id >> m_hyShardBits] = nullptr;
     }
 
     // Remove from important tags
-    if (m_hyImportantTags.contains(name)) {
-        m_hyImportantTags.remove(name);
+    m_hyImportantTags.remove(name);
+
+    // Remove from group map
+    const QString group = tag->group();
+    m_hyTagsByGroup[group].removeAll(tag);
+    if (m_hyTagsByGroup[group].isEmpty()) {
+        m_hyTagsByGroup.remove(group);
     }
+    m_hyTagIds.remove(name);
+    m_hyTagTrie.remove(name);
 
-    // Disconnect signal
-    disconnect(tag, &HYTag::valueChanged, this, &HYTagManager::onTagValueChanged);
+    indexLocker.unlock();
 
     // Delete tag
     delete tag;
-    m_hyTags.remove(name);
 
+    locker.unlock();
+    detachCalculatedTag(id);
     emit tagRemoved(name);
     return true;
 }
 
 HYTag *HYTagManager::getTag(const QString &name) const
 {
-    QMutexLocker locker(const_cast<QMutex *>(&m_hyMutex));
-    return m_hyTags.value(name, nullptr);
+    QReadLocker locker(const_cast<QReadWriteLock *>(&m_hyIndexLock));
+    return tagObject(m_hyTagIds.value(name, InvalidTagId));
 }
 
 QVector<HYTag *> HYTagManager::getTagsByGroup(const QString &group) const
 {
-    QMutexLocker locker(const_cast<QMutex *>(&m_hyMutex));
+    QReadLocker locker(const_cast<QReadWriteLock *>(&m_hyIndexLock));
     return m_hyTagsByGroup.value(group, QVector<HYTag *>());
 }
 
 QVector<HYTag *> HYTagManager::getAllTags() const
 {
-    QMutexLocker locker(const_cast<QMutex *>(&m_hyMutex));
-    return m_hyTags.values().toVector();
+    QReadLocker locker(const_cast<QReadWriteLock *>(&m_hyIndexLock));
+    QVector<HYTag *> tags;
+    tags.reserve(m_hyTagIds.size());
+    for (TagId id = 0; id < m_hyValueStore.size(); ++id) {
+        if (HYTag *tag = tagObject(id)) {
+            tags.append(tag);
+        }
+    }
+    return tags;
 }
 
 QVector<QString> HYTagManager::getGroups() const
 {
-    QMutexLocker locker(const_cast<QMutex *>(&m_hyMutex));
+    QReadLocker locker(const_cast<QReadWriteLock *>(&m_hyIndexLock));
     return m_hyTagsByGroup.keys().toVector();
 }
 
+int HYTagManager::shardCount() const
+{
+    return m_hyValueStore.shardCount();
+}
 
-
-bool HYTagManager::setTagValues(const QMap<QString, QVariant> &values)
+HYTagManager::Shard &HYTagManager::shardOf(TagId id) const
 {
-    QMutexLocker locker(&m_hyMutex);
-    bool success = true;
+    return m_hyShards[m_hyValueStore.shardOf(id)];
+}
 
-    // Disable signals for batch update
-    for (auto it = values.constBegin(); it != values.constEnd(); ++it) {
-        const QString &tagName = it.key();
-        if (m_hyTags.contains(tagName)) {
-            m_hyTags[tagName]->setSignalEnabled(false);
-        }
+HYTag *HYTagManager::tagObject(TagId id) const
+{
+    if (!m_hyValueStore.contains(id)) {
+        return nullptr;
     }
+    const Shard &shard = shardOf(id);
+    const int local = id >> m_hyShardBits;
+    return local < shard.tags.size() ? shard.tags[local] : nullptr;
+}
 
-    // Update values
-    for (auto it = values.constBegin(); it != values.constEnd(); ++it) {
-        const QString &tagName = it.key();
-        const QVariant &value = it.value();
-        if (m_hyTags.contains(tagName)) {
-            m_hyTags[tagName]->setValue(value);
-        } else {
-            success = false;
-        }
-    }
 
-    // Re-enable signals and notify
-    for (auto it = values.constBegin(); it != values.constEnd(); ++it) {
-        const QString &tagName = it.key();
-        if (m_hyTags.contains(tagName)) {
-            m_hyTags[tagName]->setSignalEnabled(true);
-        }
-    }
+
+bool HYTagManager::setTagValues(const QMap<QString, QVariant> &values)
+{
+    // Update values directly in the store; per-tag signals are replaced by the batch signal
+    QMap<QString, QVariant> reported;
+    QVector<QPair<Binding, QVariant>> bindings;
+    const bool success = writeValues(values, false, &reported, &bindings);
 
     // Emit batch signal
-    emit tagValuesChanged(values);
+    emit tagValuesChanged(reported);
 
     // Update bound properties
-    for (auto it = values.constBegin(); it != values.constEnd(); ++it) {
-        const QString &tagName = it.key();
-        const QVariant &value = it.value();
-        if (m_hyBindings.contains(tagName)) {
-            const QVector<Binding> &bindings = m_hyBindings[tagName];
-            for (const Binding &binding : bindings) {
-                binding.object->setProperty(binding.propertyName, value);
-            }
-        }
-    }
+    applyBindings(bindings);
 
     return success;
 }
 
-QVariant HYTagManager::getTagValue(const QString &name) const
+bool HYTagManager::writeValues(const QMap<QString, QVariant> &values, bool queuePending,
+                               QMap<QString, QVariant> *reported, QVector<QPair<Binding, QVariant>> *bindings)
 {
-    QMutexLocker locker(const_cast<QMutex *>(&m_hyMutex));
+    bool success = true;
+    *reported = values;
 
-    if (!m_hyTags.contains(name)) {
-        return QVariant();
+    // Resolve all handles first so that no shard lock is held while reading the directory
+    QVector<BatchEntry> entries;
+    entries.reserve(values.size());
+    quint64 involved = 0;
+    {
+        QReadLocker indexLocker(&m_hyIndexLock);
+        for (auto it = values.constBegin(); it != values.constEnd(); ++it) {
+            const TagId id = m_hyTagIds.value(it.key(), InvalidTagId);
+            if (id == InvalidTagId) {
+                success = false;
+                continue;
+            }
+            entries.append({id, it.key(), it.value()});
+            involved |= quint64(1) << m_hyValueStore.shardOf(id);
+        }
     }
 
-    return m_hyTags[name]->value();
-}
+    // Lock the involved shards in ascending order so that concurrent batches cannot deadlock;
+    // the batch belongs to one generation of every shard it touches
+    const int shards = shardCount();
+    for (int i = 0; i < shards; ++i) {
+        if ((involved >> i) & 1) {
+            m_hyShards[i].mutex.lock();
+            m_hyValueStore.beginWrite(i);
+        }
+    }
 
-void HYTagManager::bindTagToProperty(const QString &tagName, QObject *object, const char *propertyName)
-{
-    QMutexLocker locker(&m_hyMutex);
+    const qint64 timestamp = QDateTime::currentMSecsSinceEpoch();
+    for (const BatchEntry &entry : entries) {
+        Shard &shard = shardOf(entry.id);
 
-    if (!m_hyTags.contains(tagName)) {
+        // The tag may have been removed between resolving and locking
+        if (!m_hyValueStore.contains(entry.id)) {
+            success = false;
+            reported->remove(entry.name);
+            continue;
+        }
+
+        // A fresh value from a plain write is good data, as in writeTypedLocked; a quality transition always passes
+        HYTagValue typed;
+        const bool isTyped = HYTagValue::fromVariant(entry.value, &typed);
+        const bool qualityChanged = m_hyValueStore.quality(entry.id) != HYTagValueStore::QualityGood;
+        FilterResult result = FilterPass;
+        if (!shard.filterStates.isEmpty() && isTyped && !qualityChanged) {
+            result = filterValueLocked(shard, entry.id, typed, timestamp);
+            if (result != FilterPass) {
+                reported->remove(entry.name);
+            }
+            if (result == FilterReject) {
+                continue;
+            }
+        }
+
+        bool changed;
+        if (isTyped) {
+            changed = m_hyValueStore.setValue(entry.id, typed, timestamp, timestamp, HYTagValueStore::QualityGood);
+        } else {
+            changed = m_hyValueStore.setValue(entry.id, entry.value, timestamp);
+            changed = m_hyValueStore.setQuality(entry.id, HYTagValueStore::QualityGood, timestamp) || changed;
+        }
+        if (changed) {
+            persistValueLocked(shard, entry.id);
+
+            // Store in offline data if in offline mode
+            if (m_hyOfflineMode) {
+                bufferOfflineLocked(shard, entry.id, entry.name);
+            }
+        }
+        if (result == FilterDefer) {
+            continue;
+        }
+
+        markChanged(entry.id, queuePending);
+        if (!queuePending) {
+            auto bound = shard.bindings.constFind(entry.name);
+            if (bound != shard.bindings.constEnd()) {
+                for (const Binding &binding : bound.value()) {
+                    bindings->append(qMakePair(binding, entry.value));
+                }
+            }
+        }
+    }
+
+    for (int i = shards - 1; i >= 0; --i) {
+        if ((involved >> i) & 1) {
+            m_hyValueStore.endWrite(i);
+            m_hyShards[i].mutex.unlock();
+        }
+    }
+
+    return success;
+}
+
+void HYTagManager::applyBindings(const QVector<QPair<Binding, QVariant>> &bindings)
+{
+    for (const auto &entry : bindings) {
+        writeBinding(entry.first, entry.second);
+    }
+}
+
+void HYTagManager::writeBinding(const Binding &binding, const QVariant &value)
+{
+    QObject *object = binding.object.data();
+    if (!object) {
+        return;
+    }
+
+    switch (binding.writer) {
+    case WriteDouble:
+        binding.property.write(object, QVariant(value.toDouble()));
+        break;
+    case WriteInt:
+        binding.property.write(object, QVariant(value.toInt()));
+        break;
+    case WriteLongLong:
+        binding.property.write(object, QVariant(value.toLongLong()));
+        break;
+    case WriteBool:
+        binding.property.write(object, QVariant(value.toBool()));
+        break;
+    case WriteString:
+        binding.property.write(object, QVariant(value.toString()));
+        break;
+    case WriteDynamic:
+        object->setProperty(binding.propertyName.constData(), value);
+        break;
+    default:
+        binding.property.write(object, value);
+        break;
+    }
+}
+
+void HYTagManager::writeBinding(const Binding &binding, const HYTagValue &value)
+{
+    QObject *object = binding.object.data();
+    if (!object) {
+        return;
+    }
+
+    // Convert straight from the typed payload to the property's type
+    switch (binding.writer) {
+    case WriteDouble:
+        binding.property.write(object, QVariant(value.toDouble()));
+        break;
+    case WriteInt:
+        binding.property.write(object, QVariant(int(value.toInt64())));
+        break;
+    case WriteLongLong:
+        binding.property.write(object, QVariant(qlonglong(value.toInt64())));
+        break;
+    case WriteBool:
+        binding.property.write(object, QVariant(value.toBool()));
+        break;
+    case WriteString:
+        binding.property.write(object, QVariant(value.toString()));
+        break;
+    case WriteDynamic:
+        object->setProperty(binding.propertyName.constData(), value.toVariant());
+        break;
+    default:
+        binding.property.write(object, value.toVariant());
+        break;
+    }
+}
+
+QVariant HYTagManager::getTagValue(const QString &name) const
+{
+    return value(resolveTag(name));
+}
+
+HYTagManager::TagId HYTagManager::resolveTag(const QString &name) const
+{
+    QReadLocker locker(const_cast<QReadWriteLock *>(&m_hyIndexLock));
+    return m_hyTagIds.value(name, InvalidTagId);
+}
+
+QString HYTagManager::tagName(TagId id) const
+{
+    QReadLocker locker(const_cast<QReadWriteLock *>(&m_hyIndexLock));
+    HYTag *tag = tagObject(id);
+    return tag ? tag->name() : QString();
+}
+
+bool HYTagManager::setValue(TagId id, const QVariant &value)
+{
+    HYTagValue typed;
+    if (HYTagValue::fromVariant(value, &typed)) {
+        return setValue(id, typed);
+    }
+    if (!m_hyValueStore.contains(id)) {
+        return false;
+    }
+
+    // Values that cannot be represented as HYTagValue go through the store's side table
+    HYTag *tag = nullptr;
+    {
+        Shard &shard = shardOf(id);
+        QMutexLocker locker(&shard.mutex);
+        tag = tagObject(id);
+        if (!tag) {
+            return false;
+        }
+
+        if (!m_hyValueStore.setValue(id, value, QDateTime::currentMSecsSinceEpoch())) {
+            return true;
+        }
+        persistValueLocked(shard, id);
+
+        // Store in offline data if in offline mode
+        if (m_hyOfflineMode) {
+            bufferOfflineLocked(shard, id, tag->name());
+        }
+
+        // Deadbands only compare numeric values; forget the last one
+        auto state = shard.filterStates.find(id);
+        if (state != shard.filterStates.end()) {
+            state->lastValue = HYTagValue();
+        }
+    }
+
+    notifyValueChanged(tag, value);
+    return true;
+}
+
+bool HYTagManager::setValue(TagId id, const HYTagValue &value)
+{
+    if (!m_hyValueStore.contains(id)) {
+        return false;
+    }
+
+    // Only the tag's own shard is locked; writers on other shards proceed in parallel
+    HYTag *tag = nullptr;
+    {
+        Shard &shard = shardOf(id);
+        QMutexLocker locker(&shard.mutex);
+        tag = tagObject(id);
+        if (!tag) {
+            return false;
+        }
+        const qint64 now = QDateTime::currentMSecsSinceEpoch();
+        // A fresh value from a plain write is good data; a source reporting otherwise passes its own quality
+        if (!writeTypedLocked(shard, tag, value, now, now, HYTagValueStore::QualityGood)) {
+            return true;
+        }
+    }
+
+    // Convert to QVariant only once the value leaves the store for signals; bindings convert from the typed value
+    notifyValueChanged(tag, value.toVariant(), &value);
+    return true;
+}
+
+int HYTagManager::setValues(const QVector<HYTagUpdate> &updates)
+{
+    // Handles are never reused, so the shard set can be computed without the directory lock
+    quint64 involved = 0;
+    for (const HYTagUpdate &update : updates) {
+        if (m_hyValueStore.contains(update.id)) {
+            involved |= quint64(1) << m_hyValueStore.shardOf(update.id);
+        }
+    }
+
+    const int shards = shardCount();
+    for (int i = 0; i < shards; ++i) {
+        if ((involved >> i) & 1) {
+            m_hyShards[i].mutex.lock();
+            m_hyValueStore.beginWrite(i);
+        }
+    }
+
+    int applied = 0;
+    QVector<QPair<HYTag *, HYTagValue>> changed;
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    for (const HYTagUpdate &update : updates) {
+        if (update.id < 0 || !((involved >> m_hyValueStore.shardOf(update.id)) & 1)) {
+            continue;
+        }
+        Shard &shard = shardOf(update.id);
+
+        // The tag may have been removed after the shard set was computed
+        HYTag *tag = tagObject(update.id);
+        if (!tag) {
+            continue;
+        }
+        ++applied;
+        if (writeTypedLocked(shard, tag, update.value, update.timestamp, now, update.quality)) {
+            changed.append(qMakePair(tag, update.value));
+        }
+    }
+
+    for (int i = shards - 1; i >= 0; --i) {
+        if ((involved >> i) & 1) {
+            m_hyValueStore.endWrite(i);
+            m_hyShards[i].mutex.unlock();
+        }
+    }
+
+    for (const auto &entry : changed) {
+        notifyValueChanged(entry.first, entry.second.toVariant(), &entry.second);
+    }
+    return applied;
+}
+
+bool HYTagManager::writeTypedLocked(Shard &shard, HYTag *tag, const HYTagValue &value, qint64 timestamp, qint64 now,
+                                    int quality)
+{
+    const TagId id = tag->m_hyTagId;
+
+    // Deadband and rate limit run before the value is stored or signalled; a quality transition always passes
+    FilterResult result = FilterPass;
+    const bool qualityChanged = quality != HYTagValueStore::KeepQuality && quint8(quality) != m_hyValueStore.quality(id);
+    if (!shard.filterStates.isEmpty() && !qualityChanged) {
+        result = filterValueLocked(shard, id, value, now);
+        if (result == FilterReject) {
+            return false;
+        }
+    }
+
+    if (!m_hyValueStore.setValue(id, value, timestamp, now, quality)) {
+        return false;
+    }
+    persistValueLocked(shard, id);
+
+    // Store in offline data if in offline mode
+    if (m_hyOfflineMode) {
+        bufferOfflineLocked(shard, id, tag->name());
+    }
+    return result != FilterDefer;
+}
+
+void HYTagManager::persistValueLocked(Shard &shard, TagId id)
+{
+    if (m_hyHistoryEnabled.load(std::memory_order_relaxed)) {
+        m_hyHistoryDirty.set(id);
+    }
+
+    // Calculated tags are recomputed once per burst of source changes, on the manager's thread
+    if (m_hyCalcSources.test(id)) {
+        m_hyCalcDirty.set(id);
+        if (!m_hyCalcScheduled.exchange(true)) {
+            QMetaObject::invokeMethod(this, [this]() { recomputeCalculatedTags(); }, Qt::QueuedConnection);
+        }
+    }
+
+    const bool journal = m_hyJournalActive.load(std::memory_order_relaxed);
+    if (!journal && !m_hySnapshot.isOpen() && !m_hySharedTable.isOpen()) {
+        return;
+    }
+
+    // Runs under the shard lock, so the slot cannot change while it is read back
+    HYTagRecord current;
+    const bool complex = m_hyValueStore.readRecord(id, &current) == HYTagValueStore::ReadComplex;
+    if (journal) {
+        if (complex) {
+            HYTagJournal::appendComplex(&shard.journal, quint32(id), m_hyValueStore.value(id),
+                                        current.sourceTimestamp, current.quality);
+        } else {
+            HYTagJournal::appendValue(&shard.journal, quint32(id), current.value, current.sourceTimestamp,
+                                      current.quality);
+        }
+    }
+    m_hySnapshot.write(id, current, complex);
+    m_hySharedTable.write(id, current, complex);
+}
+
+void HYTagManager::bufferOfflineLocked(Shard &shard, TagId id, const QString &name)
+{
+    // Each chunk carries the definitions it refers to, so it decodes on its own once spilled
+    if (!shard.offlineDefined.contains(id)) {
+        shard.offlineDefined.insert(id);
+        HYTagJournal::appendDefine(&shard.offline, quint32(id), name, QString(), QString(), QString());
+    }
+
+    HYTagRecord current;
+    if (m_hyValueStore.readRecord(id, &current) == HYTagValueStore::ReadComplex) {
+        HYTagJournal::appendComplex(&shard.offline, quint32(id), m_hyValueStore.value(id), current.sourceTimestamp,
+                                    current.quality);
+    } else {
+        HYTagJournal::appendValue(&shard.offline, quint32(id), current.value, current.sourceTimestamp,
+                                  current.quality);
+    }
+
+    // Memory stays bounded for any outage length: a full share goes to disk as one block
+    if (shard.offline.size() >= qMax<qint64>(m_hyOfflineMemoryBytes / shardCount(), 4096)) {
+        m_hyOfflineBuffer.spill(shard.offline);
+        shard.offline.clear();
+        shard.offlineDefined.clear();
+    }
+}
+
+void HYTagManager::restoreLastKnownLocked(TagId id, const QString &name)
+{
+    // A value carried over from the previous run is shown at once, marked uncertain until a source confirms it
+    const quint64 key = HYTagSnapshot::nameKey(name);
+    HYTagRecord lastKnown;
+    if (m_hySnapshot.takeLastKnown(key, &lastKnown)) {
+        m_hyValueStore.setValue(id, lastKnown.value, lastKnown.sourceTimestamp, lastKnown.serverTimestamp,
+                                HYTagValueStore::QualityLastUsable);
+    }
+    m_hySnapshot.assign(id, key);
+}
+
+bool HYTagManager::setValue(TagId id, const HYTagValue &value, qint64 sourceTimestamp, quint8 quality)
+{
+    if (!m_hyValueStore.contains(id)) {
+        return false;
+    }
+
+    HYTag *tag = nullptr;
+    {
+        Shard &shard = shardOf(id);
+        QMutexLocker locker(&shard.mutex);
+        tag = tagObject(id);
+        if (!tag) {
+            return false;
+        }
+        if (!writeTypedLocked(shard, tag, value, sourceTimestamp, QDateTime::currentMSecsSinceEpoch(), quality)) {
+            return true;
+        }
+    }
+
+    notifyValueChanged(tag, value.toVariant(), &value);
+    return true;
+}
+
+bool HYTagManager::setValue(TagId id, const QVariant &value, qint64 sourceTimestamp, quint8 quality)
+{
+    HYTagValue typed;
+    if (HYTagValue::fromVariant(value, &typed)) {
+        return setValue(id, typed, sourceTimestamp, quality);
+    }
+    if (!m_hyValueStore.contains(id)) {
+        return false;
+    }
+
+    HYTag *tag = nullptr;
+    {
+        Shard &shard = shardOf(id);
+        QMutexLocker locker(&shard.mutex);
+        tag = tagObject(id);
+        if (!tag) {
+            return false;
+        }
+
+        if (!m_hyValueStore.setValue(id, value, sourceTimestamp, QDateTime::currentMSecsSinceEpoch(), quality)) {
+            return true;
+        }
+        persistValueLocked(shard, id);
+
+        // Store in offline data if in offline mode
+        if (m_hyOfflineMode) {
+            bufferOfflineLocked(shard, id, tag->name());
+        }
+
+        // Deadbands only compare numeric values; forget the last one
+        auto state = shard.filterStates.find(id);
+        if (state != shard.filterStates.end()) {
+            state->lastValue = HYTagValue();
+        }
+    }
+
+    notifyValueChanged(tag, value);
+    return true;
+}
+
+bool HYTagManager::setQuality(TagId id, quint8 quality)
+{
+    if (!m_hyValueStore.contains(id)) {
+        return false;
+    }
+
+    HYTag *tag = nullptr;
+    {
+        Shard &shard = shardOf(id);
+        QMutexLocker locker(&shard.mutex);
+        tag = tagObject(id);
+        if (!tag) {
+            return false;
+        }
+        if (!m_hyValueStore.setQuality(id, quality, QDateTime::currentMSecsSinceEpoch())) {
+            return true;
+        }
+        persistValueLocked(shard, id);
+    }
+
+    notifyValueChanged(tag, value(id));
+    return true;
+}
+
+HYTagRecord HYTagManager::record(TagId id) const
+{
+    HYTagRecord result;
+    m_hyValueStore.readRecord(id, &result);
+    return result;
+}
+
+QVariant HYTagManager::value(TagId id) const
+{
+    HYTagValue typed;
+    if (m_hyValueStore.read(id, &typed) != HYTagValueStore::ReadComplex) {
+        return typed.toVariant();
+    }
+
+    // Side-table values live outside the seqlock-protected columns
+    QMutexLocker locker(&shardOf(id).mutex);
+    return m_hyValueStore.value(id);
+}
+
+HYTagValue HYTagManager::typedValue(TagId id) const
+{
+    return m_hyValueStore.typedValue(id);
+}
+
+QVector<QVariant> HYTagManager::snapshot(const QVector<TagId> &ids, quint64 *generation) const
+{
+    QVector<QVariant> values(ids.size());
+    QVector<HYTagValue> typed;
+    if (m_hyValueStore.readConsistent(ids, &typed, generation)) {
+        for (int i = 0; i < ids.size(); ++i) {
+            values[i] = typed[i].toVariant();
+        }
+        return values;
+    }
+
+    // Some values live in the side table; lock the involved shards in ascending order to exclude writers
+    quint64 involved = 0;
+    for (TagId id : ids) {
+        if (id >= 0) {
+            involved |= quint64(1) << m_hyValueStore.shardOf(id);
+        }
+    }
+    const int shards = shardCount();
+    for (int i = 0; i < shards; ++i) {
+        if ((involved >> i) & 1) {
+            m_hyShards[i].mutex.lock();
+        }
+    }
+
+    for (int i = 0; i < ids.size(); ++i) {
+        values[i] = m_hyValueStore.value(ids[i]);
+    }
+    if (generation) {
+        *generation = m_hyValueStore.generation();
+    }
+
+    for (int i = shards - 1; i >= 0; --i) {
+        if ((involved >> i) & 1) {
+            m_hyShards[i].mutex.unlock();
+        }
+    }
+    return values;
+}
+
+quint64 HYTagManager::generation() const
+{
+    return m_hyValueStore.generation();
+}
+
+qint64 HYTagManager::timestamp(TagId id) const
+{
+    return m_hyValueStore.timestamp(id);
+}
+
+qint64 HYTagManager::serverTimestamp(TagId id) const
+{
+    return m_hyValueStore.serverTimestamp(id);
+}
+
+quint8 HYTagManager::quality(TagId id) const
+{
+    return m_hyValueStore.quality(id);
+}
+
+void HYTagManager::bindTagToProperty(const QString &tagName, QObject *object, const char *propertyName)
+{
+    const TagId id = resolveTag(tagName);
+    if (id == InvalidTagId || !object || !propertyName) {
         return;
     }
 
-    // Add binding
+    // Resolve the property once; updates write through it without a name lookup
     Binding binding;
     binding.object = object;
     binding.propertyName = propertyName;
-    m_hyBindings[tagName].append(binding);
+    const QMetaObject *metaObject = object->metaObject();
+    const int index = metaObject->indexOfProperty(propertyName);
+    if (index < 0) {
+        binding.writer = WriteDynamic;
+    } else {
+        binding.property = metaObject->property(index);
+        switch (binding.property.metaType().id()) {
+        case QMetaType::Double:
+            binding.writer = WriteDouble;
+            break;
+        case QMetaType::Int:
+            binding.writer = WriteInt;
+            break;
+        case QMetaType::LongLong:
+            binding.writer = WriteLongLong;
+            break;
+        case QMetaType::Bool:
+            binding.writer = WriteBool;
+            break;
+        case QMetaType::QString:
+            binding.writer = WriteString;
+            break;
+        default:
+            binding.writer = WriteVariant;
+            break;
+        }
+    }
+
+    // Drop the binding as soon as the object goes away instead of keeping a dangling pointer
+    binding.destroyedConnection = connect(object, &QObject::destroyed, this, [this, tagName](QObject *destroyed) {
+        pruneBindings(tagName, destroyed);
+    });
+
+    {
+        Shard &shard = shardOf(id);
+        QMutexLocker locker(&shard.mutex);
+        if (!m_hyValueStore.contains(id)) {
+            disconnect(binding.destroyedConnection);
+            return;
+        }
+        shard.bindings[tagName].append(binding);
+    }
 
     // Set initial value
-    HYTag *tag = m_hyTags[tagName];
-    object->setProperty(propertyName, tag->value());
+    writeBinding(binding, value(id));
 }
 
 void HYTagManager::unbindTagFromProperty(const QString &tagName, QObject *object, const char *propertyName)
+{
+    const TagId id = resolveTag(tagName);
+    if (id == InvalidTagId) {
+        return;
+    }
+
+    Shard &shard = shardOf(id);
+    QMutexLocker locker(&shard.mutex);
+    if (!shard.bindings.contains(tagName)) {
+        return;
+    }
+
+    QVector<Binding> &bindings = shard.bindings[tagName];
+    for (int i = bindings.size() - 1; i >= 0; --i) {
+        const Binding &binding = bindings[i];
+        if (binding.object == object && binding.propertyName == propertyName) {
+            disconnect(binding.destroyedConnection);
+            bindings.removeAt(i);
+            break;
+        }
+    }
+
+    if (bindings.isEmpty()) {
+        shard.bindings.remove(tagName);
+    }
+}
+
+void HYTagManager::pruneBindings(const QString &tagName, QObject *object)
+{
+    const TagId id = resolveTag(tagName);
+    if (id == InvalidTagId) {
+        return;
+    }
+
+    Shard &shard = shardOf(id);
+    QMutexLocker locker(&shard.mutex);
+    auto it = shard.bindings.find(tagName);
+    if (it == shard.bindings.end()) {
+        return;
+    }
+
+    // Guards may or may not have been cleared yet when destroyed() is emitted
+    it->removeIf([object](const Binding &binding) {
+        return binding.object.isNull() || binding.object.data() == object;
+    });
+    if (it->isEmpty()) {
+        shard.bindings.erase(it);
+    }
+}
+
+void HYTagManager::setDelayedNotification(bool enabled, int interval)
+{
+    m_hyNotificationInterval = qMax(1, interval);
+    setBatchUpdateMode(enabled);
+}
+
+void HYTagManager::setTagImportant(const QString &tagName, bool important)
+{
+    QMutexLocker locker(&m_hyMutex);
+    if (important) {
+        m_hyImportantTags.insert(tagName);
+    } else {
+        m_hyImportantTags.remove(tagName);
+    }
+
+    // Existing tags carry the flag in their shard so that notification needs no global lock
+    const TagId id = resolveTag(tagName);
+    if (id == InvalidTagId) {
+        return;
+    }
+    Shard &shard = shardOf(id);
+    QMutexLocker shardLocker(&shard.mutex);
+    if (important) {
+        shard.importantTags.insert(id);
+    } else {
+        shard.importantTags.remove(id);
+    }
+}
+
+void HYTagManager::setTagFilter(const QString &tagName, const HYTagFilter &filter)
+{
+    const TagId id = resolveTag(tagName);
+    if (id == InvalidTagId) {
+        return;
+    }
+
+    Shard &shard = shardOf(id);
+    QMutexLocker locker(&shard.mutex);
+    if (m_hyValueStore.contains(id)) {
+        installFilterLocked(shard, id, filter, true);
+    }
+}
+
+void HYTagManager::clearTagFilter(const QString &tagName)
+{
+    QMutexLocker locker(&m_hyMutex);
+    const TagId id = m_hyTagIds.value(tagName, InvalidTagId);
+    if (id == InvalidTagId) {
+        return;
+    }
+
+    Shard &shard = shardOf(id);
+    QMutexLocker shardLocker(&shard.mutex);
+
+    // Fall back to the group filter, if any
+    auto groupFilter = m_hyGroupFilters.constFind(tagObject(id)->group());
+    if (groupFilter != m_hyGroupFilters.constEnd()) {
+        installFilterLocked(shard, id, groupFilter.value(), false);
+    } else {
+        shard.filterStates.remove(id);
+    }
+}
+
+void HYTagManager::setGroupFilter(const QString &group, const HYTagFilter &filter)
+{
+    QMutexLocker locker(&m_hyMutex);
+    m_hyGroupFilters.insert(group, filter);
+
+    // Tags with their own filter keep it
+    for (HYTag *tag : m_hyTagsByGroup.value(group)) {
+        Shard &shard = shardOf(tag->m_hyTagId);
+        QMutexLocker shardLocker(&shard.mutex);
+        auto state = shard.filterStates.constFind(tag->m_hyTagId);
+        if (state == shard.filterStates.constEnd() || !state->explicitFilter) {
+            installFilterLocked(shard, tag->m_hyTagId, filter, false);
+        }
+    }
+}
+
+void HYTagManager::clearGroupFilter(const QString &group)
 {
     QMutexLocker locker(&m_hyMutex);
+    m_hyGroupFilters.remove(group);
+
+    for (HYTag *tag : m_hyTagsByGroup.value(group)) {
+        Shard &shard = shardOf(tag->m_hyTagId);
+        QMutexLocker shardLocker(&shard.mutex);
+        auto state = shard.filterStates.constFind(tag->m_hyTagId);
+        if (state != shard.filterStates.constEnd() && !state->explicitFilter) {
+            shard.filterStates.remove(tag->m_hyTagId);
+        }
+    }
+}
+
+HYTagFilter HYTagManager::tagFilter(const QString &tagName) const
+{
+    const TagId id = resolveTag(tagName);
+    if (id == InvalidTagId) {
+        return HYTagFilter();
+    }
+
+    const Shard &shard = shardOf(id);
+    QMutexLocker locker(const_cast<QMutex *>(&shard.mutex));
+    return shard.filterStates.value(id).filter;
+}
 
-    if (!m_hyBindings.contains(tagName)) {
+void HYTagManager::installFilterLocked(Shard &shard, TagId id, const HYTagFilter &filter, bool explicitFilter)
+{
+    FilterState &state = shard.filterStates[id];
+    state.filter = filter;
+    state.explicitFilter = explicitFilter;
+    state.lastValue = m_hyValueStore.typedValue(id);
+}
+
+HYTagManager::FilterResult HYTagManager::filterValueLocked(Shard &shard, TagId id, const HYTagValue &value, qint64 now)
+{
+    auto it = shard.filterStates.find(id);
+    if (it == shard.filterStates.end()) {
+        return FilterPass;
+    }
+
+    FilterState &state = it.value();
+    const HYTagFilter &filter = state.filter;
+    if (value == state.lastValue) {
+        // Unchanged values only refresh the timestamp and never notify
+        return FilterPass;
+    }
+
+    // Deadbands apply to analog values only; bools and type changes always pass
+    const bool analog = (value.type() == HYTagValue::Int64 || value.type() == HYTagValue::Double)
+        && (state.lastValue.type() == HYTagValue::Int64 || state.lastValue.type() == HYTagValue::Double);
+    if (filter.deadbandType != HYTagFilter::DeadbandNone && analog) {
+        const double last = state.lastValue.toDouble();
+        double threshold = filter.deadband;
+        if (filter.deadbandType == HYTagFilter::DeadbandPercent) {
+            const double span = filter.rangeHigh - filter.rangeLow;
+            threshold = filter.deadband / 100.0 * (span > 0.0 ? span : qAbs(last));
+        }
+        if (qAbs(value.toDouble() - last) <= threshold) {
+            return FilterReject;
+        }
+    }
+
+    state.lastValue = value;
+
+    // Too soon after the last notification: store now, notify once the interval has passed
+    if (filter.minInterval > 0 && now - state.lastReported < filter.minInterval) {
+        if (!shard.filterPending.contains(id)) {
+            shard.filterPending.insert(id);
+            const int delay = int(state.lastReported + filter.minInterval - now);
+            QMetaObject::invokeMethod(this, [this, delay]() {
+                if (!m_hyFilterTimer->isActive() || m_hyFilterTimer->remainingTime() > delay) {
+                    m_hyFilterTimer->start(delay);
+                }
+            });
+        }
+        return FilterDefer;
+    }
+
+    state.lastReported = now;
+    shard.filterPending.remove(id);
+    return FilterPass;
+}
+
+void HYTagManager::onFilterFlush()
+{
+    QVector<QPair<HYTag *, QVariant>> due;
+    qint64 next = -1;
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+
+    // Shards are visited one at a time, never holding more than one shard lock
+    for (int i = 0; i < shardCount(); ++i) {
+        Shard &shard = m_hyShards[i];
+        QMutexLocker locker(&shard.mutex);
+        for (auto it = shard.filterPending.begin(); it != shard.filterPending.end();) {
+            const TagId id = *it;
+            auto state = shard.filterStates.find(id);
+            if (state == shard.filterStates.end()) {
+                it = shard.filterPending.erase(it);
+                continue;
+            }
+
+            const qint64 wait = state->lastReported + state->filter.minInterval - now;
+            if (wait > 0) {
+                next = next < 0 ? wait : qMin(next, wait);
+                ++it;
+                continue;
+            }
+
+            // Report the latest stored value, coalescing everything deferred in between
+            state->lastReported = now;
+            due.append(qMakePair(tagObject(id), m_hyValueStore.value(id)));
+            it = shard.filterPending.erase(it);
+        }
+    }
+
+    if (next >= 0) {
+        m_hyFilterTimer->start(int(next));
+    }
+    for (const auto &entry : due) {
+        notifyValueChanged(entry.first, entry.second);
+    }
+}
+
+void HYTagManager::notifyValueChanged(HYTag *tag, const QVariant &newValue, const HYTagValue *typedValue)
+{
+    if (tag->m_hySignalEnabled) {
+        emit tag->valueChanged(newValue);
+    }
+
+    const QString tagName = tag->name();
+    const TagId id = tag->m_hyTagId;
+    Shard &shard = shardOf(id);
+
+    QVector<Binding> bindings;
+    bool delayed = false;
+    {
+        QMutexLocker locker(&shard.mutex);
+
+        // Important tags are always notified immediately
+        delayed = !shard.importantTags.contains(id) && m_hyDelayedNotification;
+        if (!delayed) {
+            bindings = shard.bindings.value(tagName);
+        }
+    }
+
+    // Delayed tags are only marked dirty; the fixed-cadence tick reports their latest value
+    markChanged(id, delayed);
+    if (delayed) {
         return;
     }
 
-    QVector<Binding> &bindings = m_hyBindings[tagName];
-    for (int i = bindings.size() - 1; i >= 0; --i) {
-        const Binding &binding = bindings[i];
-        if (binding.object == object && strcmp(binding.propertyName, propertyName) == 0) {
-            bindings.removeAt(i);
-            break;
+    emit tagValueChanged(tagName, newValue);
+
+    // Update bound properties
+    for (const Binding &binding : bindings) {
+        if (typedValue) {
+            writeBinding(binding, *typedValue);
+        } else {
+            writeBinding(binding, newValue);
+        }
+    }
+}
+
+// Performance optimization methods
+/**
+ * @brief 批量添加点位
+ * @param tags 点位信息列表
+ * @return 添加是否成功
+ */
+bool HYTagManager::addTags(const QVector<QMap<QString, QVariant>> &tags)
+{
+    QMutexLocker locker(&m_hyMutex);
+    bool success = true;
+    QStringList addedNames;
+
+    for (const auto &tagInfo : tags) {
+        QString name = tagInfo["name"].toString();
+        QString group = tagInfo["group"].toString();
+        QVariant value = tagInfo["value"];
+        QString description = tagInfo["description"].toString();
+        QString source = tagInfo["source"].toString();
+
+        if (addTagLocked(name, group, value, description, source) == InvalidTagId) {
+            success = false;
+            continue;
+        }
+        addedNames.append(name);
+    }
+
+    locker.unlock();
+    for (const QString &name : addedNames) {
+        emit tagAdded(name);
+    }
+
+    return success;
+}
+
+int HYTagManager::addTagDefinitions(const QVector<HYTagDefinition> &definitions)
+{
+    QStringList addedNames;
+    {
+        QMutexLocker locker(&m_hyMutex);
+        QWriteLocker indexLocker(&m_hyIndexLock);
+
+        // Take every shard lock once for the whole load instead of a lock round trip per tag
+        const int shards = shardCount();
+        for (int i = 0; i < shards; ++i) {
+            m_hyShards[i].mutex.lock();
+        }
+
+        const int total = m_hyValueStore.size() + int(definitions.size());
+        m_hyValueStore.reserve(total);
+        m_hyTagIds.reserve(m_hyTagIds.size() + definitions.size());
+        for (int i = 0; i < shards; ++i) {
+            m_hyShards[i].tags.reserve((total >> m_hyShardBits) + 1);
+        }
+        addedNames.reserve(definitions.size());
+
+        const qint64 timestamp = QDateTime::currentMSecsSinceEpoch();
+        for (const HYTagDefinition &definition : definitions) {
+            if (definition.name.isEmpty()) {
+                continue;
+            }
+            if (insertTagLocked(definition.name, definition.group, definition.value, definition.description,
+                                definition.source, timestamp) != InvalidTagId) {
+                addedNames.append(definition.name);
+            }
+        }
+
+        for (int i = shards - 1; i >= 0; --i) {
+            m_hyShards[i].mutex.unlock();
+        }
+    }
+
+    if (!addedNames.isEmpty()) {
+        emit tagsAdded(addedNames);
+    }
+    return int(addedNames.size());
+}
+
+int HYTagManager::importTags(const QString &filePath, QString *error)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (error) {
+            *error = file.errorString();
+        }
+        return -1;
+    }
+    const QByteArray data = file.readAll();
+    file.close();
+
+    QVector<HYTagDefinition> definitions;
+    QString message;
+    const bool binary = data.startsWith(TagFileMagic);
+    if (!(binary ? readBinaryDefinitions(data, &definitions, &message)
+                 : readCsvDefinitions(data, &definitions, &message))) {
+        if (error) {
+            *error = message;
+        }
+        return -1;
+    }
+    return addTagDefinitions(definitions);
+}
+
+bool HYTagManager::exportTags(const QString &filePath, TagFileFormat format) const
+{
+    QVector<HYTagDefinition> definitions;
+    {
+        QReadLocker locker(const_cast<QReadWriteLock *>(&m_hyIndexLock));
+        const int size = m_hyValueStore.size();
+        definitions.reserve(size);
+        for (TagId id = 0; id < size; ++id) {
+            HYTag *tag = tagObject(id);
+            if (!tag) {
+                continue;
+            }
+            definitions.append(HYTagDefinition{tag->name(), tag->group(), value(id), tag->description(), tag->source()});
+        }
+    }
+
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    file.write(format == TagFileCsv ? writeCsvDefinitions(definitions) : writeBinaryDefinitions(definitions));
+    return file.commit();
+}
+
+/**
+ * @brief 启用批量更新模式
+ * @param enabled 是否启用
+ */
+void HYTagManager::setBatchUpdateMode(bool enabled)
+{
+    m_hyDelayedNotification = enabled;
+
+    Subscriber *delayed = m_hySubscribers[DelayedSubscriber].load(std::memory_order_acquire);
+    delayed->maxLatency.store(m_hyNotificationInterval, std::memory_order_relaxed);
+    if (enabled) {
+        delayed->active.store(true, std::memory_order_release);
+    } else {
+        // Flush pending values before the built-in subscriber stops collecting
+        flushNotifications(true);
+        delayed->active.store(false, std::memory_order_release);
+    }
+    updateNotificationCadence();
+}
+
+/**
+ * @brief 设置批量更新间隔
+ * @param interval 间隔（毫秒）
+ */
+void HYTagManager::setBatchUpdateInterval(int interval)
+{
+    m_hyNotificationInterval = qMax(1, interval);
+    m_hySubscribers[DelayedSubscriber].load(std::memory_order_acquire)->maxLatency.store(m_hyNotificationInterval, std::memory_order_relaxed);
+    updateNotificationCadence();
+}
+
+/**
+ * @brief 优化点位值更新，减少信号发射
+ * @param values 点位名称和值的映射
+ * @param immediate 是否立即通知
+ * @return 设置是否成功
+ */
+bool HYTagManager::setTagValuesOptimized(const QMap<QString, QVariant> &values, bool immediate)
+{
+    // 直接写入值存储，不触发单点信号；整批在涉及的每个分片内属于同一代
+    // 被死区丢弃或被限频推迟的点位不参与本次通知
+    const bool delayed = !immediate && m_hyDelayedNotification;
+    QMap<QString, QVariant> reported;
+    QVector<QPair<Binding, QVariant>> bindings;
+    const bool success = writeValues(values, delayed, &reported, &bindings);
+
+    // 通知更新：延迟通知的点位已在写入时标记为脏，由固定周期的通知定时器合并发出
+    if (!delayed) {
+        // 立即通知或正常通知
+        emit tagValuesChanged(reported);
+
+        // 更新绑定属性
+        applyBindings(bindings);
+    }
+
+    return success;
+}
+
+void HYTagManager::onNotificationTick()
+{
+    flushNotifications(false);
+}
+
+void HYTagManager::markChanged(TagId id, bool delayed)
+{
+    // Only subscribers interested in this tag are visited
+    quint64 targets = m_hyTagSubscribers.mask(id) | m_hyAllTagsSubscribers.load(std::memory_order_acquire);
+    if (delayed) {
+        targets |= quint64(1) << DelayedSubscriber;
+    }
+
+    qint64 now = 0;
+    while (targets) {
+        const int i = qCountTrailingZeroBits(targets);
+        targets &= targets - 1;
+        Subscriber *subscriber = m_hySubscribers[i].load(std::memory_order_acquire);
+        if (subscriber && subscriber->active.load(std::memory_order_acquire)) {
+            markDirty(subscriber, id, &now);
+        }
+    }
+}
+
+void HYTagManager::markDirty(Subscriber *subscriber, TagId id, qint64 *now)
+{
+    // Set the bit before checking the deadline so that a concurrent flush either takes the bit
+    // or leaves the deadline for us to arm
+    subscriber->dirty.set(id);
+    if (subscriber->firstDirty.load(std::memory_order_seq_cst) == 0) {
+        if (!*now) {
+            *now = m_hyNotificationClock.elapsed() + 1;
+        }
+        qint64 expected = 0;
+        subscriber->firstDirty.compare_exchange_strong(expected, *now, std::memory_order_seq_cst);
+    }
+}
+
+void HYTagManager::flushNotifications(bool force)
+{
+    const qint64 now = m_hyNotificationClock.elapsed() + 1;
+    const int count = m_hySubscriberCount.load(std::memory_order_acquire);
+    QVector<TagId> ids;
+
+    for (int i = 0; i < count; ++i) {
+        Subscriber *subscriber = m_hySubscribers[i].load(std::memory_order_acquire);
+        if (!subscriber->active.load(std::memory_order_acquire)) {
+            continue;
+        }
+        const qint64 first = subscriber->firstDirty.load(std::memory_order_seq_cst);
+        if (first == 0) {
+            continue;
+        }
+
+        // Leave the batch for a later tick only if that tick still meets the latency bound
+        if (!force && now - first + m_hyNotificationTick <= subscriber->maxLatency.load(std::memory_order_relaxed)) {
+            continue;
+        }
+        subscriber->firstDirty.store(0, std::memory_order_seq_cst);
+        if (!subscriber->dirty.takeAll(&ids)) {
+            continue;
+        }
+
+        int delivered = 0;
+        if (i == DelayedSubscriber) {
+            QMap<QString, QVariant> values;
+            QVector<QPair<Binding, QVariant>> bindings;
+            {
+                QReadLocker indexLocker(&m_hyIndexLock);
+                for (TagId id : ids) {
+                    HYTag *tag = tagObject(id);
+                    if (!tag) {
+                        continue;
+                    }
+
+                    // Coalesced: report the latest stored value
+                    const QVariant current = value(id);
+                    values.insert(tag->name(), current);
+
+                    Shard &shard = shardOf(id);
+                    QMutexLocker shardLocker(&shard.mutex);
+                    auto bound = shard.bindings.constFind(tag->name());
+                    if (bound != shard.bindings.constEnd()) {
+                        for (const Binding &binding : bound.value()) {
+                            bindings.append(qMakePair(binding, current));
+                        }
+                    }
+                }
+            }
+            delivered = values.size();
+            if (!values.isEmpty()) {
+                emit tagValuesChanged(values);
+                applyBindings(bindings);
+            }
+        } else {
+            NotifyCallback callback;
+            QPointer<QObject> context;
+            bool hasContext = false;
+            {
+                QMutexLocker locker(&m_hySubscriberMutex);
+                callback = subscriber->callback;
+                context = subscriber->context;
+                hasContext = subscriber->hasContext;
+            }
+            if (hasContext && !context) {
+                unsubscribe(i);
+                continue;
+            }
+
+            QVector<HYTagUpdate> updates;
+            updates.reserve(ids.size());
+            for (TagId id : ids) {
+                // A reused slot may see a stale bit from its previous subscription
+                if (!m_hyValueStore.contains(id)
+                    || (!subscriber->allTags && !(m_hyTagSubscribers.mask(id) & (quint64(1) << i)))) {
+                    continue;
+                }
+                HYTagRecord current;
+                m_hyValueStore.readRecord(id, &current);
+                updates.append(HYTagUpdate{id, current.sourceTimestamp, current.value, current.quality});
+            }
+            delivered = updates.size();
+            if (updates.isEmpty() || !callback) {
+                continue;
+            }
+            if (hasContext) {
+                QMetaObject::invokeMethod(context.data(), [callback, updates]() { callback(updates); });
+            } else {
+                callback(updates);
+            }
+        }
+
+        if (delivered > 0) {
+            QMutexLocker locker(&m_hySubscriberMutex);
+            HYNotificationMetrics &metrics = subscriber->metrics;
+            ++metrics.flushes;
+            metrics.notifications += delivered;
+            metrics.lastBatchSize = delivered;
+            metrics.maxBatchSize = qMax(metrics.maxBatchSize, delivered);
+            metrics.lastLatency = now - first;
+            metrics.maxLatency = qMax(metrics.maxLatency, metrics.lastLatency);
+        }
+    }
+}
+
+void HYTagManager::updateNotificationCadence()
+{
+    // The tick is the tightest latency bound among active subscribers
+    int tick = 0;
+    const int count = m_hySubscriberCount.load(std::memory_order_acquire);
+    for (int i = 0; i < count; ++i) {
+        Subscriber *subscriber = m_hySubscribers[i].load(std::memory_order_acquire);
+        if (subscriber->active.load(std::memory_order_acquire)) {
+            const int latency = subscriber->maxLatency.load(std::memory_order_relaxed);
+            tick = tick ? qMin(tick, latency) : latency;
+        }
+    }
+
+    // The timer belongs to the manager's thread
+    QMetaObject::invokeMethod(this, [this, tick]() {
+        m_hyNotificationTick = tick;
+        if (tick <= 0) {
+            m_hyNotificationTimer->stop();
+        } else if (!m_hyNotificationTimer->isActive() || m_hyNotificationTimer->interval() != tick) {
+            m_hyNotificationTimer->start(tick);
+        }
+    });
+}
+
+int HYTagManager::subscribe(const QVector<TagId> &ids, QObject *context, const NotifyCallback &callback, int maxLatency)
+{
+    const int index = createSubscriber(ids, ids.isEmpty(), QString(), context, callback, maxLatency);
+    if (index >= 0) {
+        updateNotificationCadence();
+    }
+    return index;
+}
+
+int HYTagManager::subscribe(const QString &pattern, const NotifyCallback &callback, const HYSubscribeOptions &options)
+{
+    if (!HYTagTrie::isValidPattern(pattern)) {
+        return -1;
+    }
+
+    // Hold the configuration lock so that no tag is added between matching and indexing the pattern
+    QMutexLocker locker(&m_hyMutex);
+    QVector<TagId> ids;
+    m_hyTagTrie.match(pattern, &ids);
+
+    const int index = createSubscriber(ids, false, pattern, options.context, callback, options.maxLatency);
+    if (index < 0) {
+        return -1;
+    }
+    m_hyPatternTrie.insertPattern(pattern, quint64(1) << index);
+    locker.unlock();
+
+    if (options.initialValues) {
+        Subscriber *subscriber = m_hySubscribers[index].load(std::memory_order_acquire);
+        qint64 now = 0;
+        for (TagId id : std::as_const(ids)) {
+            markDirty(subscriber, id, &now);
+        }
+    }
+
+    updateNotificationCadence();
+    return index;
+}
+
+int HYTagManager::createSubscriber(const QVector<TagId> &ids, bool allTags, const QString &pattern, QObject *context,
+                                   const NotifyCallback &callback, int maxLatency)
+{
+    QMutexLocker locker(&m_hySubscriberMutex);
+
+    // Reuse a released slot before creating a new one
+    int index = -1;
+    const int count = m_hySubscriberCount.load(std::memory_order_relaxed);
+    for (int i = DelayedSubscriber + 1; i < count; ++i) {
+        if (!m_hySubscribers[i].load(std::memory_order_relaxed)->active.load(std::memory_order_relaxed)) {
+            index = i;
+            break;
+        }
+    }
+    if (index < 0) {
+        if (count >= MaxSubscribers) {
+            return -1;
+        }
+        index = count;
+        m_hySubscribers[index].store(new Subscriber, std::memory_order_release);
+        m_hySubscriberCount.store(count + 1, std::memory_order_release);
+    }
+
+    Subscriber *subscriber = m_hySubscribers[index].load(std::memory_order_relaxed);
+    subscriber->dirty.clear();
+    subscriber->firstDirty.store(0, std::memory_order_relaxed);
+    subscriber->allTags = allTags;
+    subscriber->maxLatency.store(qMax(1, maxLatency), std::memory_order_relaxed);
+    subscriber->context = context;
+    subscriber->hasContext = context != nullptr;
+    subscriber->callback = callback;
+    subscriber->pattern = pattern;
+    subscriber->metrics = HYNotificationMetrics();
+
+    // Index the interest by tag so that writers reach only the subscribers of the tag they wrote
+    const quint64 bit = quint64(1) << index;
+    if (allTags) {
+        m_hyAllTagsSubscribers.fetch_or(bit, std::memory_order_release);
+    } else {
+        for (TagId id : ids) {
+            m_hyTagSubscribers.set(id, bit);
+        }
+    }
+
+    // Publish the configuration to writers
+    subscriber->active.store(true, std::memory_order_release);
+    return index;
+}
+
+void HYTagManager::unsubscribe(int subscriber)
+{
+    if (subscriber <= DelayedSubscriber || subscriber >= MaxSubscribers) {
+        return;
+    }
+
+    QMutexLocker configLocker(&m_hyMutex);
+    QString pattern;
+    {
+        QMutexLocker locker(&m_hySubscriberMutex);
+        Subscriber *entry = m_hySubscribers[subscriber].load(std::memory_order_acquire);
+        if (!entry || !entry->active.load(std::memory_order_relaxed)) {
+            return;
+        }
+        entry->active.store(false, std::memory_order_release);
+        entry->callback = nullptr;
+        entry->context = nullptr;
+        pattern = entry->pattern;
+        entry->pattern.clear();
+
+        // Drop the interest index before the slot can be reused; stale bits seen by racing writers
+        // are filtered out when the batch is delivered
+        const quint64 bit = quint64(1) << subscriber;
+        m_hyAllTagsSubscribers.fetch_and(~bit, std::memory_order_release);
+        m_hyTagSubscribers.resetAll(bit);
+        if (!pattern.isEmpty()) {
+            m_hyPatternTrie.removePattern(pattern, bit);
+        }
+    }
+    configLocker.unlock();
+
+    updateNotificationCadence();
+}
+
+HYNotificationMetrics HYTagManager::notificationMetrics(int subscriber) const
+{
+    if (subscriber < 0 || subscriber >= MaxSubscribers) {
+        return HYNotificationMetrics();
+    }
+
+    QMutexLocker locker(const_cast<QMutex *>(&m_hySubscriberMutex));
+    Subscriber *entry = m_hySubscribers[subscriber].load(std::memory_order_acquire);
+    return entry ? entry->metrics : HYNotificationMetrics();
+}
+
+// Calculated tag methods
+bool HYTagManager::addCalculatedTag(const QString &name, const QString &group, const QString &expression,
+                                    const QString &description, QString *error)
+{
+    CalculatedTag calculated;
+    if (!calculated.expression.compile(expression, error)) {
+        return false;
+    }
+
+    QMutexLocker calcLocker(&m_hyCalcMutex);
+    for (const QString &input : calculated.expression.variables()) {
+        const TagId inputId = resolveTag(input);
+        if (inputId == InvalidTagId) {
+            if (error) {
+                *error = QStringLiteral("unknown tag '%1'").arg(input);
+            }
+            return false;
+        }
+        calculated.inputs.append(inputId);
+    }
+
+    // Inputs exist before the tag is added, so every input has a smaller handle and no cycle can form
+    if (!addTag(name, group, QVariant(0.0), description)) {
+        if (error) {
+            *error = QStringLiteral("tag '%1' already exists").arg(name);
+        }
+        return false;
+    }
+    const TagId id = resolveTag(name);
+    for (TagId input : std::as_const(calculated.inputs)) {
+        m_hyCalcDependents[input].append(id);
+        if (!m_hyCalcTags.contains(input)) {
+            m_hyCalcSources.set(input);
+        }
+    }
+    m_hyCalcTags.insert(id, calculated);
+
+    std::set<TagId> pending{id};
+    QVector<HYTagUpdate> updates;
+    recomputeLocked(&pending, &updates);
+    setValues(updates);
+    return true;
+}
+
+bool HYTagManager::isCalculatedTag(const QString &name) const
+{
+    const TagId id = resolveTag(name);
+    QMutexLocker locker(const_cast<QRecursiveMutex *>(&m_hyCalcMutex));
+    return id != InvalidTagId && m_hyCalcTags.contains(id);
+}
+
+QString HYTagManager::calculatedExpression(const QString &name) const
+{
+    const TagId id = resolveTag(name);
+    QMutexLocker locker(const_cast<QRecursiveMutex *>(&m_hyCalcMutex));
+    auto it = m_hyCalcTags.constFind(id);
+    return it != m_hyCalcTags.constEnd() ? it->expression.source() : QString();
+}
+
+int HYTagManager::recomputeCalculatedTags()
+{
+    // Cleared first, so a change arriving during the pass schedules the next one
+    m_hyCalcScheduled = false;
+    QVector<TagId> changed;
+    m_hyCalcDirty.takeAll(&changed);
+
+    QMutexLocker locker(&m_hyCalcMutex);
+    std::set<TagId> pending;
+    for (TagId id : std::as_const(changed)) {
+        auto dependents = m_hyCalcDependents.constFind(id);
+        if (dependents != m_hyCalcDependents.constEnd()) {
+            pending.insert(dependents->cbegin(), dependents->cend());
+        }
+    }
+
+    // The results go out in one batch, still under the lock so a later pass cannot overtake them
+    QVector<HYTagUpdate> updates;
+    recomputeLocked(&pending, &updates);
+    setValues(updates);
+    return updates.size();
+}
+
+void HYTagManager::recomputeLocked(std::set<TagId> *pending, QVector<HYTagUpdate> *updates)
+{
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    QVarLengthArray<double, 16> inputs;
+    while (!pending->empty()) {
+        const TagId id = *pending->begin();
+        pending->erase(pending->begin());
+        auto node = m_hyCalcTags.find(id);
+        if (node == m_hyCalcTags.end()) {
+            continue;
+        }
+
+        // Calculated inputs were recomputed earlier in this pass and are read from their cache
+        quint8 quality = HYTagValueStore::QualityGood;
+        qint64 timestamp = 0;
+        inputs.resize(node->inputs.size());
+        for (int i = 0; i < node->inputs.size(); ++i) {
+            const TagId input = node->inputs.at(i);
+            double value = std::numeric_limits<double>::quiet_NaN();
+            quint8 inputQuality = HYTagValueStore::QualityConfigError;
+            qint64 inputTimestamp = 0;
+            auto calculated = m_hyCalcTags.constFind(input);
+            if (calculated != m_hyCalcTags.constEnd()) {
+                value = calculated->value;
+                inputQuality = calculated->quality;
+                inputTimestamp = calculated->timestamp;
+            } else if (m_hyValueStore.contains(input)) {
+                HYTagRecord current;
+                if (m_hyValueStore.readRecord(input, &current) != HYTagValueStore::ReadComplex
+                    && current.value.isNumeric()) {
+                    value = current.value.toDouble();
+                    inputQuality = current.quality;
+                }
+                inputTimestamp = current.sourceTimestamp;
+            }
+            inputs[i] = value;
+            if ((inputQuality & HYTagValueStore::QualityStatusMask) < (quality & HYTagValueStore::QualityStatusMask)) {
+                quality = inputQuality;
+            }
+            timestamp = qMax(timestamp, inputTimestamp);
+        }
+
+        const double value = node->expression.evaluate(inputs.constData());
+        if (!std::isfinite(value) && (quality & HYTagValueStore::QualityStatusMask) != HYTagValueStore::QualityBad) {
+            quality = HYTagValueStore::QualityBad;
+        }
+        if (node->evaluated && std::bit_cast<quint64>(value) == std::bit_cast<quint64>(node->value)
+            && quality == node->quality) {
+            continue;
+        }
+
+        node->value = value;
+        node->quality = quality;
+        node->timestamp = timestamp ? timestamp : now;
+        node->evaluated = true;
+        updates->append(HYTagUpdate{id, node->timestamp, HYTagValue::fromDouble(value), quality});
+
+        auto dependents = m_hyCalcDependents.constFind(id);
+        if (dependents != m_hyCalcDependents.constEnd()) {
+            pending->insert(dependents->cbegin(), dependents->cend());
+        }
+    }
+}
+
+void HYTagManager::detachCalculatedTag(TagId id)
+{
+    QMutexLocker locker(&m_hyCalcMutex);
+
+    auto node = m_hyCalcTags.find(id);
+    if (node != m_hyCalcTags.end()) {
+        for (TagId input : std::as_const(node->inputs)) {
+            auto dependents = m_hyCalcDependents.find(input);
+            if (dependents == m_hyCalcDependents.end()) {
+                continue;
+            }
+            dependents->removeAll(id);
+            if (dependents->isEmpty()) {
+                m_hyCalcDependents.erase(dependents);
+                m_hyCalcSources.reset(input);
+            }
+        }
+        m_hyCalcTags.erase(node);
+    }
+
+    // Handles are never reused, so dependents of a removed tag stay on a configuration error until redefined
+    const QVector<TagId> dependents = m_hyCalcDependents.take(id);
+    m_hyCalcSources.reset(id);
+    if (!dependents.isEmpty()) {
+        std::set<TagId> pending(dependents.cbegin(), dependents.cend());
+        QVector<HYTagUpdate> updates;
+        recomputeLocked(&pending, &updates);
+        setValues(updates);
+    }
+}
+
+// Historical data storage methods
+void HYTagManager::enableHistoryStorage(bool enabled, int interval, int retentionDays)
+{
+    const bool started = enabled && !m_hyHistoryEnabled.exchange(enabled);
+    m_hyHistoryEnabled = enabled;
+    m_hyHistoryInterval = interval;
+    m_hyHistoryRetentionDays = retentionDays;
+    m_hyHistory.setRetention(enabled ? qint64(retentionDays) * 86400000 : 0);
+
+    // Writers only mark tags that change from now on, so the current values are archived once
+    if (started) {
+        markHistoryDirty();
+    }
+
+    if (enabled) {
+        m_hyHistoryTimer->start(interval);
+    } else {
+        m_hyHistoryTimer->stop();
+    }
+}
+
+bool HYTagManager::setHistoryDatabasePath(const QString &path)
+{
+    if (!m_hyHistory.open(path)) {
+        return false;
+    }
+
+    // Series numbers belong to the previous database; everything is archived again into the new one
+    m_hyArchiveStates.clear();
+    m_hyHistoryCursor = 0;
+    if (m_hyHistoryEnabled) {
+        markHistoryDirty();
+    }
+    return true;
+}
+
+QString HYTagManager::historyDatabasePath() const
+{
+    return m_hyHistory.path();
+}
+
+void HYTagManager::setHistoryPartitioning(HYTagHistory::Partitioning partitioning)
+{
+    m_hyHistory.setPartitioning(partitioning);
+}
+
+void HYTagManager::setHistoryDeadband(double deadband)
+{
+    m_hyHistoryDeadband = qMax(0.0, deadband);
+}
+
+void HYTagManager::setHistoryDeadband(const QString &tagName, double deadband)
+{
+    if (deadband < 0) {
+        m_hyHistoryDeadbands.remove(tagName);
+    } else {
+        m_hyHistoryDeadbands.insert(tagName, deadband);
+    }
+
+    const TagId id = resolveTag(tagName);
+    if (id != InvalidTagId && id < m_hyArchiveStates.size()) {
+        m_hyArchiveStates[id].deadband = deadband < 0 ? -1.0 : deadband;
+    }
+}
+
+void HYTagManager::setHistoryHeartbeat(int interval)
+{
+    m_hyHistoryHeartbeat = qMax(0, interval);
+}
+
+void HYTagManager::markHistoryDirty()
+{
+    QReadLocker locker(&m_hyIndexLock);
+    for (TagId id = 0; id < m_hyValueStore.size(); ++id) {
+        if (tagObject(id)) {
+            m_hyHistoryDirty.set(id);
+        }
+    }
+}
+
+int HYTagManager::archiveHistory()
+{
+    if (!m_hyHistoryEnabled || !m_hyHistory.isOpen()) {
+        return 0;
+    }
+
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    QVector<TagId> changed;
+    m_hyHistoryDirty.takeAll(&changed);
+
+    QVector<HYTagHistory::Sample> samples;
+    QVector<TagId> ids;
+    QStringList names;
+    QVector<TagId> unnamed;
+    {
+        QReadLocker locker(&m_hyIndexLock);
+        const int size = m_hyValueStore.size();
+        if (m_hyArchiveStates.size() < size) {
+            m_hyArchiveStates.resize(size);
+        }
+
+        auto append = [&samples, &ids](TagId id, const HYTagRecord &current, const QVariant &complex, qint64 timestamp) {
+            HYTagHistory::Sample sample;
+            sample.timestamp = timestamp;
+            sample.value = current.value;
+            sample.complex = complex;
+            sample.quality = current.quality;
+            samples.append(sample);
+            ids.append(id);
+        };
+
+        // Changes are written with the time the source sampled them, unless they moved less than the deadband
+        for (TagId id : std::as_const(changed)) {
+            HYTag *tag = tagObject(id);
+            if (!tag) {
+                continue;
+            }
+            ArchiveState &state = m_hyArchiveStates[id];
+            if (!state.writtenAt && state.deadband < 0) {
+                state.deadband = m_hyHistoryDeadbands.value(tag->name(), -1.0);
+            }
+
+            HYTagRecord current;
+            const bool complex = m_hyValueStore.readRecord(id, &current) == HYTagValueStore::ReadComplex;
+            if (state.writtenAt && !complex && current.quality == state.quality) {
+                const double deadband = state.deadband >= 0 ? state.deadband : m_hyHistoryDeadband;
+                const bool within = current.value == state.value
+                    || (current.value.isNumeric() && state.value.isNumeric()
+                        && qAbs(current.value.toDouble() - state.value.toDouble()) <= deadband);
+                if (within) {
+                    continue;
+                }
+            }
+            append(id, current, complex ? m_hyValueStore.value(id) : QVariant(),
+                   current.sourceTimestamp ? current.sourceTimestamp : now);
+        }
+
+        // The sweep visits every tag once per heartbeat period, a slice of the table on each cycle
+        if (m_hyHistoryHeartbeat > 0 && size > 0) {
+            // A tag archived above as changed already has its sample in this pass
+            const QSet<TagId> archived(ids.cbegin(), ids.cend());
+            const qint64 slice = qint64(size) * qMax(1, m_hyHistoryInterval) / m_hyHistoryHeartbeat + 1;
+            for (qint64 i = 0; i < qMin<qint64>(slice, size); ++i) {
+                const TagId id = m_hyHistoryCursor;
+                m_hyHistoryCursor = (m_hyHistoryCursor + 1) % size;
+                const ArchiveState &state = m_hyArchiveStates.at(id);
+                if (!state.writtenAt || now - state.writtenAt < m_hyHistoryHeartbeat || archived.contains(id)
+                    || !tagObject(id)) {
+                    continue;
+                }
+                HYTagRecord current;
+                const bool complex = m_hyValueStore.readRecord(id, &current) == HYTagValueStore::ReadComplex;
+                append(id, current, complex ? m_hyValueStore.value(id) : QVariant(), now);
+            }
+        }
+
+        // Only tags already written have a series, so the heartbeat never adds a second unnamed entry
+        for (TagId id : std::as_const(ids)) {
+            if (!m_hyArchiveStates.at(id).series) {
+                names.append(tagObject(id)->name());
+                unnamed.append(id);
+            }
+        }
+    }
+
+    // Series numbers for tags archived for the first time are allocated in one transaction
+    if (!names.isEmpty()) {
+        const QVector<qint64> series = m_hyHistory.seriesIds(names);
+        for (int i = 0; i < unnamed.size(); ++i) {
+            m_hyArchiveStates[unnamed.at(i)].series = series.at(i);
+        }
+    }
+
+    // Samples without a series stay dirty and are tried again on the next cycle
+    int kept = 0;
+    for (int i = 0; i < samples.size(); ++i) {
+        const TagId id = ids.at(i);
+        samples[i].series = m_hyArchiveStates.at(id).series;
+        if (!samples.at(i).series) {
+            m_hyHistoryDirty.set(id);
+            continue;
+        }
+        samples[kept] = samples.at(i);
+        ids[kept++] = id;
+    }
+    samples.resize(kept);
+    ids.resize(kept);
+
+    if (!m_hyHistory.write(samples)) {
+        for (TagId id : std::as_const(ids)) {
+            m_hyHistoryDirty.set(id);
+        }
+        return 0;
+    }
+    for (int i = 0; i < samples.size(); ++i) {
+        ArchiveState &state = m_hyArchiveStates[ids.at(i)];
+        state.value = samples.at(i).value;
+        state.quality = samples.at(i).quality;
+        state.writtenAt = now;
+    }
+    return samples.size();
+}
+
+QVector<QPair<QDateTime, QVariant>> HYTagManager::getHistoricalData(const QString &tagName, const QDateTime &startTime, const QDateTime &endTime,
+                                                                    QVector<quint8> *qualities)
+{
+    return m_hyHistory.query(tagName, startTime.toMSecsSinceEpoch(), endTime.toMSecsSinceEpoch(), qualities);
+}
+
+void HYTagManager::cleanHistoricalData(int days)
+{
+    m_hyHistory.purge(QDateTime::currentDateTime().addDays(-days).toMSecsSinceEpoch());
+}
+
+void HYTagManager::onHistoryStorage()
+{
+    if (!m_hyHistoryEnabled) {
+        return;
+    }
+
+    // Retention runs on the history's own thread, so the archive cycle never waits for old data to be dropped
+    archiveHistory();
+}
+
+// Persistence methods
+void HYTagManager::enablePersistence(bool enabled, const QString &persistFilePath)
+{
+    // Finish the current journal before switching persistence off or moving it elsewhere
+    const bool moved = !persistFilePath.isEmpty() && persistFilePath != m_hyPersistFilePath;
+    if (m_hyJournal && (!enabled || moved)) {
+        stopJournal();
+        QMutexLocker locker(&m_hyJournalMutex);
+        m_hyJournal.reset();
+    }
+
+    m_hyPersistEnabled = enabled;
+    if (!persistFilePath.isEmpty()) {
+        m_hyPersistFilePath = persistFilePath;
+    }
+    
+    // Create directory if not exists
+    QDir persistDir(QFileInfo(m_hyPersistFilePath).path());
+    if (!persistDir.exists()) {
+        persistDir.mkpath(".");
+    }
+
+    // The journal starts recording at the first checkpoint, written by loadState() or saveState()
+    if (enabled && !m_hyJournal) {
+        QMutexLocker locker(&m_hyJournalMutex);
+        m_hyJournal = std::make_unique<HYTagJournal>(checkpointPath(m_hyPersistFilePath));
+    }
+
+    const QString snapshotPath = m_hyPersistFilePath + QStringLiteral(".values");
+    if (enabled == m_hySnapshot.isOpen() && !moved) {
+        return;
+    }
+
+    // Writers reach the snapshot under a shard lock; holding all of them keeps it still while it opens or closes
+    QMutexLocker locker(&m_hyMutex);
+    QWriteLocker indexLocker(&m_hyIndexLock);
+    const int shards = shardCount();
+    for (int i = 0; i < shards; ++i) {
+        m_hyShards[i].mutex.lock();
+    }
+
+    m_hySnapshot.close();
+    if (enabled && m_hySnapshot.open(snapshotPath)) {
+        // Tags defined before persistence was enabled pick up their last-known values too
+        for (auto it = m_hyTagIds.constBegin(); it != m_hyTagIds.constEnd(); ++it) {
+            restoreLastKnownLocked(it.value(), it.key());
+            persistValueLocked(shardOf(it.value()), it.value());
         }
     }
 
-    if (bindings.isEmpty()) {
-        m_hyBindings.remove(tagName);
+    for (int i = shards - 1; i >= 0; --i) {
+        m_hyShards[i].mutex.unlock();
     }
 }
 
-void HYTagManager::setDelayedNotification(bool enabled, int interval)
+void HYTagManager::saveState()
 {
-    m_hyDelayedNotification = enabled;
-    m_hyNotificationInterval = interval;
-}
+    if (!m_hyPersistEnabled) {
+        return;
+    }
 
-void HYTagManager::setTagImportant(const QString &tagName, bool important)
-{
-    QMutexLocker locker(&m_hyMutex);
-    if (important) {
-        m_hyImportantTags.insert(tagName);
-    } else {
-        m_hyImportantTags.remove(tagName);
+    QMutexLocker locker(&m_hyJournalMutex);
+    if (checkpointLocked()) {
+        startJournal();
     }
 }
 
-void HYTagManager::onTagValueChanged(const QVariant &newValue)
+void HYTagManager::loadState()
 {
-    // Get the sender tag
-    HYTag *tag = qobject_cast<HYTag *>(sender());
-    if (!tag) {
+    if (!m_hyPersistEnabled) {
+        return;
+    }
+
+    QMutexLocker journalLocker(&m_hyJournalMutex);
+    if (!m_hyJournal) {
         return;
     }
 
-    QString tagName = tag->name();
+    // Records still buffered belong to the current journal; write them before reading the files back
+    if (m_hyJournalActive.load(std::memory_order_relaxed)) {
+        flushJournalLocked();
+        m_hyJournalActive.store(false, std::memory_order_relaxed);
+    }
 
-    // Check if this is an important tag that should be notified immediately
-    if (m_hyImportantTags.contains(tagName)) {
-        // Immediate notification for important tags
-        emit tagValueChanged(tagName, newValue);
+    // Before the first checkpoint, state saved as JSON by earlier versions is imported once;
+    // the checkpoint written below goes next to it and is what later loads read
+    QVector<JournalTag> journalTags;
+    const QString legacyPath = QFile::exists(m_hyJournal->path()) ? QString() : legacyStatePath();
 
-        // Update bound properties
-        QMutexLocker locker(&m_hyMutex);
-        if (m_hyBindings.contains(tagName)) {
-            const QVector<Binding> &bindings = m_hyBindings[tagName];
-            for (const Binding &binding : bindings) {
-                binding.object->setProperty(binding.propertyName, newValue);
+    // Fold the checkpoint and its journals into the last state of each tag, indexed by the handle it was written under
+    const auto fold = [&journalTags](const HYTagJournal::Entry &entry) {
+        if (entry.kind == HYTagJournal::EntryDefine) {
+            if (journalTags.size() <= qsizetype(entry.id)) {
+                journalTags.resize(qsizetype(entry.id) + 1);
             }
+            JournalTag &tag = journalTags[entry.id];
+            tag = JournalTag();
+            tag.definition = HYTagDefinition{entry.name, entry.group, QVariant(), entry.description, entry.source};
+            tag.defined = true;
+            return;
+        }
+        if (qsizetype(entry.id) >= journalTags.size() || !journalTags[entry.id].defined) {
+            return;
         }
-    } else if (m_hyDelayedNotification) {
-        // Add to pending values for delayed notification
-        QMutexLocker locker(&m_hyMutex);
-        m_hyPendingValues[tagName] = newValue;
-
-        // Start or restart the notification timer
-        m_hyNotificationTimer->start(m_hyNotificationInterval);
-    } else {
-        // Normal notification
-        emit tagValueChanged(tagName, newValue);
 
-        // Update bound properties
-        QMutexLocker locker(&m_hyMutex);
-        if (m_hyBindings.contains(tagName)) {
-            const QVector<Binding> &bindings = m_hyBindings[tagName];
-            for (const Binding &binding : bindings) {
-                binding.object->setProperty(binding.propertyName, newValue);
-            }
+        JournalTag &tag = journalTags[entry.id];
+        switch (entry.kind) {
+        case HYTagJournal::EntryValue:
+            tag.value = entry.value;
+            tag.complex = QVariant();
+            tag.isComplex = false;
+            break;
+        case HYTagJournal::EntryComplex:
+            tag.value = HYTagValue();
+            tag.complex = entry.complex;
+            tag.isComplex = true;
+            break;
+        case HYTagJournal::EntryRemove:
+            tag.defined = false;
+            return;
+        default:
+            return;
         }
+        tag.timestamp = entry.timestamp;
+        tag.quality = entry.quality;
+    };
+    const bool replayed = legacyPath.isEmpty() ? m_hyJournal->replay(fold) : readLegacyState(legacyPath, &journalTags);
+    if (!replayed) {
+        return;
     }
-}
 
-// Performance optimization methods
-/**
- * @brief 批量添加点位
- * @param tags 点位信息列表
- * @return 添加是否成功
- */
-bool HYTagManager::addTags(const QVector<QMap<QString, QVariant>> &tags)
-{
-    QMutexLocker locker(&m_hyMutex);
-    bool success = true;
+    QStringList addedNames;
+    {
+        QMutexLocker locker(&m_hyMutex);
+        QWriteLocker indexLocker(&m_hyIndexLock);
 
-    for (const auto &tagInfo : tags) {
-        QString name = tagInfo["name"].toString();
-        QString group = tagInfo["group"].toString();
-        QVariant value = tagInfo["value"];
-        QString description = tagInfo["description"].toString();
-        QString source = tagInfo["source"].toString();
+        // Same bulk path as addTagDefinitions: every shard lock once for the whole load
+        const int shards = shardCount();
+        for (int i = 0; i < shards; ++i) {
+            m_hyShards[i].mutex.lock();
+        }
 
-        // Check if tag already exists
-        if (m_hyTags.contains(name)) {
-            success = false;
-            continue;
+        const int total = m_hyValueStore.size() + int(journalTags.size());
+        m_hyValueStore.reserve(total);
+        m_hyTagIds.reserve(m_hyTagIds.size() + journalTags.size());
+        for (int i = 0; i < shards; ++i) {
+            m_hyShards[i].tags.reserve((total >> m_hyShardBits) + 1);
         }
 
-        // Create new tag
-        HYTag *tag = new HYTag(name, group, value, description, source, this);
-        m_hyTags[name] = tag;
-        m_hyTagsByGroup[group].append(tag);
+        for (const JournalTag &entry : std::as_const(journalTags)) {
+            if (!entry.defined || entry.definition.name.isEmpty()) {
+                continue;
+            }
+
+            // Update existing tag or add new one
+            const HYTagDefinition &definition = entry.definition;
+            TagId id = m_hyTagIds.value(definition.name, InvalidTagId);
+            if (id == InvalidTagId) {
+                id = insertTagLocked(definition.name, definition.group,
+                                     entry.isComplex ? entry.complex : entry.value.toVariant(),
+                                     definition.description, definition.source, entry.timestamp);
+                if (id == InvalidTagId) {
+                    continue;
+                }
+                addedNames.append(definition.name);
+            }
 
-        // Connect tag's valueChanged signal to our slot
-        connect(tag, &HYTag::valueChanged, this, &HYTagManager::onTagValueChanged);
+            // The journaled state wins over a last-known value the snapshot may have restored on insertion
+            if (entry.isComplex) {
+                m_hyValueStore.setValue(id, entry.complex, entry.timestamp);
+                m_hyValueStore.setQuality(id, entry.quality);
+            } else {
+                m_hyValueStore.setValue(id, entry.value, entry.timestamp, entry.timestamp, entry.quality);
+            }
+            persistValueLocked(shardOf(id), id);
+        }
 
-        emit tagAdded(name);
+        for (int i = shards - 1; i >= 0; --i) {
+            m_hyShards[i].mutex.unlock();
+        }
     }
 
-    return success;
-}
+    // Handles differ from the ones in the files just read; start a new checkpoint under the current handles
+    if (checkpointLocked()) {
+        startJournal();
+    }
+    journalLocker.unlock();
 
-/**
- * @brief 启用批量更新模式
- * @param enabled 是否启用
- */
-void HYTagManager::setBatchUpdateMode(bool enabled)
-{
-    m_hyDelayedNotification = enabled;
-    if (!enabled && !m_hyPendingValues.isEmpty()) {
-        // Flush pending values
-        onDelayedNotification();
+    if (!addedNames.isEmpty()) {
+        emit tagsAdded(addedNames);
     }
 }
 
-/**
- * @brief 设置批量更新间隔
- * @param interval 间隔（毫秒）
- */
-void HYTagManager::setBatchUpdateInterval(int interval)
+QString HYTagManager::legacyStatePath() const
 {
-    m_hyNotificationInterval = interval;
+    // An explicit path may still name a JSON file; the default itself moved from persist.json to persist.state
+    if (isLegacyStateFile(m_hyPersistFilePath)) {
+        return m_hyPersistFilePath;
+    }
+    const QFileInfo info(m_hyPersistFilePath);
+    const QString sibling = info.dir().filePath(info.completeBaseName() + QStringLiteral(".json"));
+    return isLegacyStateFile(sibling) ? sibling : QString();
 }
 
-/**
- * @brief 优化点位值更新，减少信号发射
- * @param values 点位名称和值的映射
- * @param immediate 是否立即通知
- * @return 设置是否成功
- */
-bool HYTagManager::setTagValuesOptimized(const QMap<QString, QVariant> &values, bool immediate)
+void HYTagManager::flushJournalLocked()
 {
-    QMutexLocker locker(&m_hyMutex);
-    bool success = true;
+    // Swap each shard's buffer out under its lock; encoding already happened on the writer side
+    QByteArray entries;
+    bool written = false;
+    for (int i = 0; i < shardCount(); ++i) {
+        Shard &shard = m_hyShards[i];
+        {
+            QMutexLocker locker(&shard.mutex);
+            if (shard.journal.isEmpty()) {
+                continue;
+            }
+            entries.swap(shard.journal);
+        }
 
-    // 禁用信号
-    for (auto it = values.constBegin(); it != values.constEnd(); ++it) {
-        const QString &tagName = it.key();
-        if (m_hyTags.contains(tagName)) {
-            m_hyTags[tagName]->setSignalEnabled(false);
+        // One checksummed block per shard; a tag's records all live in its own shard, so they stay in order
+        if (m_hyJournal && m_hyJournal->isOpen()) {
+            m_hyJournal->append(entries);
+            written = true;
         }
+        entries.resize(0);
     }
 
-    // 更新值
-    for (auto it = values.constBegin(); it != values.constEnd(); ++it) {
-        const QString &tagName = it.key();
-        const QVariant &value = it.value();
-        if (m_hyTags.contains(tagName)) {
-            m_hyTags[tagName]->setValue(value);
-        } else {
-            success = false;
-        }
+    // Everything collected in this pass shares one fsync
+    if (written) {
+        m_hyJournal->sync();
     }
+}
 
-    // 启用信号
-    for (auto it = values.constBegin(); it != values.constEnd(); ++it) {
-        const QString &tagName = it.key();
-        if (m_hyTags.contains(tagName)) {
-            m_hyTags[tagName]->setSignalEnabled(true);
-        }
+bool HYTagManager::checkpointLocked()
+{
+    if (!m_hyJournal) {
+        return false;
     }
 
-    // 通知更新
-    if (immediate) {
-        // 立即通知
-        emit tagValuesChanged(values);
+    const bool wasActive = m_hyJournalActive.load(std::memory_order_relaxed);
+    if (wasActive) {
+        flushJournalLocked();
+    }
+    if (!m_hyJournal->rotate()) {
+        m_hyJournalActive.store(false, std::memory_order_relaxed);
+        return false;
+    }
 
-        // 更新绑定属性
-        for (auto it = values.constBegin(); it != values.constEnd(); ++it) {
-            const QString &tagName = it.key();
-            const QVariant &value = it.value();
-            if (m_hyBindings.contains(tagName)) {
-                const QVector<Binding> &bindings = m_hyBindings[tagName];
-                for (const Binding &binding : bindings) {
-                    binding.object->setProperty(binding.propertyName, value);
-                }
-            }
-        }
-    } else if (m_hyDelayedNotification) {
-        // 延迟通知
-        for (auto it = values.constBegin(); it != values.constEnd(); ++it) {
-            m_hyPendingValues[it.key()] = it.value();
+    // Record into the new journal before taking the snapshot, so no change falls between the two; changes that
+    // land in both replay harmlessly because records hold absolute values. Passing through every shard lock makes
+    // writers that missed the flag finish before the snapshot, and leftovers from an inactive period are dropped
+    // because the snapshot supersedes them
+    m_hyJournalActive.store(true, std::memory_order_relaxed);
+    for (int i = 0; i < shardCount(); ++i) {
+        QMutexLocker locker(&m_hyShards[i].mutex);
+        if (!wasActive) {
+            m_hyShards[i].journal.clear();
         }
-        m_hyNotificationTimer->start(m_hyNotificationInterval);
-    } else {
-        // 正常通知
-        emit tagValuesChanged(values);
+    }
 
-        // 更新绑定属性
-        for (auto it = values.constBegin(); it != values.constEnd(); ++it) {
-            const QString &tagName = it.key();
-            const QVariant &value = it.value();
-            if (m_hyBindings.contains(tagName)) {
-                const QVector<Binding> &bindings = m_hyBindings[tagName];
-                for (const Binding &binding : bindings) {
-                    binding.object->setProperty(binding.propertyName, value);
-                }
+    QByteArray entries;
+    {
+        QReadLocker indexLocker(&m_hyIndexLock);
+        entries.reserve(qsizetype(m_hyTagIds.size()) * 128);
+        HYTagRecord current;
+        for (TagId id = 0; id < m_hyValueStore.size(); ++id) {
+            HYTag *tag = tagObject(id);
+            if (!tag) {
+                continue;
+            }
+            HYTagJournal::appendDefine(&entries, quint32(id), tag->name(), tag->group(), tag->description(),
+                                       tag->source());
+            if (m_hyValueStore.readRecord(id, &current) == HYTagValueStore::ReadComplex) {
+                // Side-table values are only stable under the shard lock
+                QMutexLocker shardLocker(&shardOf(id).mutex);
+                HYTagJournal::appendComplex(&entries, quint32(id), m_hyValueStore.value(id), current.sourceTimestamp,
+                                            current.quality);
+            } else {
+                HYTagJournal::appendValue(&entries, quint32(id), current.value, current.sourceTimestamp,
+                                          current.quality);
             }
         }
     }
-
-    return success;
+    return m_hyJournal->writeCheckpoint(entries);
 }
 
-void HYTagManager::onDelayedNotification()
+void HYTagManager::startJournal()
 {
-    QMutexLocker locker(&m_hyMutex);
-    if (m_hyPendingValues.isEmpty()) {
+    if (m_hyJournalThread) {
         return;
     }
 
-    // Copy pending values
-    QMap<QString, QVariant> values = m_hyPendingValues;
-    m_hyPendingValues.clear();
-
-    // Release lock before emitting signals
-    locker.unlock();
-
-    // Emit batch signal
-    emit tagValuesChanged(values);
-
-    // Update bound properties
-    locker.relock();
-    for (auto it = values.constBegin(); it != values.constEnd(); ++it) {
-        const QString &tagName = it.key();
-        const QVariant &value = it.value();
-        if (m_hyBindings.contains(tagName)) {
-            const QVector<Binding> &bindings = m_hyBindings[tagName];
-            for (const Binding &binding : bindings) {
-                binding.object->setProperty(binding.propertyName, value);
-            }
-        }
-    }
+    m_hyJournalStopping = false;
+    m_hyJournalThread = QThread::create([this]() { runJournal(); });
+    m_hyJournalThread->setObjectName(QStringLiteral("HYTagJournal"));
+    m_hyJournalThread->start();
 }
 
-// Historical data storage methods
-void HYTagManager::enableHistoryStorage(bool enabled, int interval, int retentionDays)
+void HYTagManager::stopJournal()
 {
-    m_hyHistoryEnabled = enabled;
-    m_hyHistoryInterval = interval;
-    m_hyHistoryRetentionDays = retentionDays;
-    
-    if (enabled) {
-        m_hyHistoryTimer->start(interval);
-    } else {
-        m_hyHistoryTimer->stop();
+    if (m_hyJournalThread) {
+        {
+            QMutexLocker locker(&m_hyJournalMutex);
+            m_hyJournalStopping = true;
+            m_hyJournalCondition.wakeAll();
+        }
+        m_hyJournalThread->wait();
+        delete m_hyJournalThread;
+        m_hyJournalThread = nullptr;
     }
-}
 
-QVector<QPair<QDateTime, QVariant>> HYTagManager::getHistoricalData(const QString &tagName, const QDateTime &startTime, const QDateTime &endTime)
-{
-    QVector<QPair<QDateTime, QVariant>> data;
-    
-    if (!m_hyDatabase.isOpen()) {
-        return data;
+    QMutexLocker locker(&m_hyJournalMutex);
+    if (m_hyJournalActive.load(std::memory_order_relaxed)) {
+        flushJournalLocked();
+        m_hyJournalActive.store(false, std::memory_order_relaxed);
     }
-    
-    QSqlQuery query;
-    query.prepare("SELECT timestamp, value FROM history WHERE tag_name = :tag AND timestamp >= :start AND timestamp <= :end ORDER BY timestamp");
-    query.bindValue(":tag", tagName);
-    query.bindValue(":start", startTime.toString(Qt::ISODate));
-    query.bindValue(":end", endTime.toString(Qt::ISODate));
-    
-    if (query.exec()) {
-        while (query.next()) {
-            QDateTime timestamp = QDateTime::fromString(query.value(0).toString(), Qt::ISODate);
-            QVariant value = query.value(1);
-            data.append(qMakePair(timestamp, value));
-        }
+    if (m_hyJournal) {
+        m_hyJournal->close();
     }
-    
-    return data;
 }
 
-void HYTagManager::cleanHistoricalData(int days)
+void HYTagManager::runJournal()
 {
-    if (!m_hyDatabase.isOpen()) {
-        return;
+    QMutexLocker locker(&m_hyJournalMutex);
+    while (!m_hyJournalStopping) {
+        m_hyJournalCondition.wait(&m_hyJournalMutex, HYTagJournal::SyncInterval);
+        if (m_hyJournalStopping) {
+            break;
+        }
+
+        // Group commit: whatever accumulated during the interval goes out with a single fsync
+        flushJournalLocked();
+        if (m_hyJournal && m_hyJournal->size() > HYTagJournal::CheckpointBytes) {
+            checkpointLocked();
+        }
     }
-    
-    QDateTime cutoffTime = QDateTime::currentDateTime().addDays(-days);
-    QSqlQuery query;
-    query.prepare("DELETE FROM history WHERE timestamp < :cutoff");
-    query.bindValue(":cutoff", cutoffTime.toString(Qt::ISODate));
-    query.exec();
 }
 
-void HYTagManager::onHistoryStorage()
+// Shared memory methods
+bool HYTagManager::publishSharedMemory(const QString &name, int capacity)
 {
-    if (!m_hyHistoryEnabled || !m_hyDatabase.isOpen()) {
-        return;
-    }
-    
+    // Writers reach the table under a shard lock; holding all of them keeps it still while it opens
     QMutexLocker locker(&m_hyMutex);
-    
-    // 开始事务，提高批量插入性能
-    QSqlQuery beginQuery;
-    beginQuery.exec("BEGIN TRANSACTION");
-    
-    QSqlQuery query;
-    query.prepare("INSERT INTO history (tag_name, value, timestamp) VALUES (:tag, :value, :timestamp)");
-    
-    QString timestamp = QDateTime::currentDateTime().toString(Qt::ISODate);
-    
-    for (const auto &tag : m_hyTags.values()) {
-        query.bindValue(":tag", tag->name());
-        query.bindValue(":value", tag->value().toString());
-        query.bindValue(":timestamp", timestamp);
-        query.exec();
+    QWriteLocker indexLocker(&m_hyIndexLock);
+    const int shards = shardCount();
+    for (int i = 0; i < shards; ++i) {
+        m_hyShards[i].mutex.lock();
     }
-    
-    // 提交事务
-    QSqlQuery commitQuery;
-    commitQuery.exec("COMMIT");
-    
-    // Clean up old data
-    cleanHistoricalData(m_hyHistoryRetentionDays);
-}
 
-// Persistence methods
-void HYTagManager::enablePersistence(bool enabled, const QString &persistFilePath)
-{
-    m_hyPersistEnabled = enabled;
-    if (!persistFilePath.isEmpty()) {
-        m_hyPersistFilePath = persistFilePath;
+    const bool opened = m_hySharedTable.open(name, capacity);
+    if (opened) {
+        for (auto it = m_hyTagIds.constBegin(); it != m_hyTagIds.constEnd(); ++it) {
+            if (!m_hySharedTable.publish(it.value(), it.key())) {
+                continue;
+            }
+            HYTagRecord current;
+            const bool complex = m_hyValueStore.readRecord(it.value(), &current) == HYTagValueStore::ReadComplex;
+            m_hySharedTable.write(it.value(), current, complex);
+        }
     }
-    
-    // Create directory if not exists
-    QDir persistDir(QFileInfo(m_hyPersistFilePath).path());
-    if (!persistDir.exists()) {
-        persistDir.mkpath(".");
+
+    for (int i = shards - 1; i >= 0; --i) {
+        m_hyShards[i].mutex.unlock();
     }
+    return opened;
 }
 
-void HYTagManager::saveState()
+void HYTagManager::unpublishSharedMemory()
 {
-    if (!m_hyPersistEnabled) {
-        return;
-    }
-    
-    QFile file(m_hyPersistFilePath);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        return;
-    }
-    
-    QJsonObject root;
-    QJsonArray tags;
-    
     QMutexLocker locker(&m_hyMutex);
-    for (const auto &tag : m_hyTags.values()) {
-        QJsonObject tagObj;
-        tagObj["name"] = tag->name();
-        tagObj["group"] = tag->group();
-        tagObj["value"] = QJsonValue::fromVariant(tag->value());
-        tagObj["description"] = tag->description();
-        tagObj["source"] = tag->source();
-        tags.append(tagObj);
+    QWriteLocker indexLocker(&m_hyIndexLock);
+    const int shards = shardCount();
+    for (int i = 0; i < shards; ++i) {
+        m_hyShards[i].mutex.lock();
+    }
+
+    m_hySharedTable.close();
+
+    for (int i = shards - 1; i >= 0; --i) {
+        m_hyShards[i].mutex.unlock();
     }
-    
-    root["tags"] = tags;
-    root["timestamp"] = QDateTime::currentDateTime().toString(Qt::ISODate);
-    
-    QJsonDocument doc(root);
-    file.write(doc.toJson(QJsonDocument::Indented));
-    file.close();
 }
 
-void HYTagManager::loadState()
+QString HYTagManager::sharedMemoryName() const
 {
-    if (!m_hyPersistEnabled) {
-        return;
-    }
-    
-    QFile file(m_hyPersistFilePath);
-    if (!file.exists() || !file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        return;
-    }
-    
-    QJsonDocument doc = QJsonDocument::fromJson(file.readAll());
-    file.close();
-    
-    if (!doc.isObject()) {
-        return;
-    }
-    
-    QJsonObject root = doc.object();
-    QJsonArray tags = root["tags"].toArray();
-    
-    QMutexLocker locker(&m_hyMutex);
-    for (const auto &tagValue : tags) {
-        QJsonObject tagObj = tagValue.toObject();
-        QString name = tagObj["name"].toString();
-        QString group = tagObj["group"].toString();
-        QVariant value = tagObj["value"].toVariant();
-        QString description = tagObj["description"].toString();
-        QString source = tagObj["source"].toString();
-        
-        // Update existing tag or add new one
-        if (m_hyTags.contains(name)) {
-            m_hyTags[name]->setValue(value);
-        } else {
-            addTag(name, group, value, description, source);
-        }
-    }
+    QMutexLocker locker(const_cast<QMutex*>(&m_hyMutex));
+    return m_hySharedTable.name();
 }
 
 // Offline capability methods
@@ -768,6 +3094,11 @@ void HYTagManager::setOfflineMode(bool offline)
     
     m_hyOfflineMode = offline;
     emit offlineModeChanged(offline);
+
+    // The historian is presumably unreachable again; the replay resumes from its last committed batch
+    if (offline) {
+        m_hyOfflineReplayer->stop();
+    }
     
     if (!offline) {
         // Sync data when going online
@@ -786,22 +3117,61 @@ void HYTagManager::syncOfflineData()
         return;
     }
     
-    QMutexLocker locker(&m_hyMutex);
-    int syncCount = 0;
-    
-    // Process offline data
-    for (const auto &tagName : m_hyOfflineData.keys()) {
-        const auto &dataPoints = m_hyOfflineData[tagName];
-        syncCount += dataPoints.size();
-        
-        // Here you would typically send data to the server
-        // For now, we'll just clear the offline data
+    // Move the in-memory chunks to disk so the whole backlog replays, and resumes, from one place
+    for (int i = 0; i < shardCount(); ++i) {
+        Shard &shard = m_hyShards[i];
+        QMutexLocker locker(&shard.mutex);
+        if (!shard.offline.isEmpty()) {
+            m_hyOfflineBuffer.spill(shard.offline);
+            shard.offline.clear();
+            shard.offlineDefined.clear();
+        }
     }
-    
-    // Clear offline data after sync
-    m_hyOfflineData.clear();
-    
-    emit syncCompleted(true, syncCount);
+    m_hyOfflineBuffer.seal();
+
+    m_hyOfflineReplayer->start();
+}
+
+void HYTagManager::setHistorian(HYTimeSeriesDatabase *database)
+{
+    m_hyOfflineReplayer->setDatabase(database);
+}
+
+void HYTagManager::setOfflineReplayLimits(int batchSize, int maxRate)
+{
+    m_hyOfflineReplayer->setBatchSize(batchSize);
+    m_hyOfflineReplayer->setMaxRate(maxRate);
+}
+
+qint64 HYTagManager::offlineBacklogBytes() const
+{
+    return m_hyOfflineBuffer.backlogBytes();
+}
+
+double HYTagManager::offlineReplayRate() const
+{
+    return m_hyOfflineReplayer->replayRate();
+}
+
+void HYTagManager::setOfflineBufferLimits(qint64 memoryBytes, qint64 diskBytes)
+{
+    m_hyOfflineMemoryBytes = memoryBytes;
+    m_hyOfflineBuffer.setDiskLimit(diskBytes);
+}
+
+void HYTagManager::setOfflineEvictionPolicy(HYOfflineBuffer::EvictionPolicy policy)
+{
+    m_hyOfflineBuffer.setEvictionPolicy(policy);
+}
+
+void HYTagManager::setOfflineBufferDirectory(const QString &directory)
+{
+    m_hyOfflineBuffer.setDirectory(directory);
+}
+
+qint64 HYTagManager::offlineDiskSize() const
+{
+    return m_hyOfflineBuffer.diskSize();
 }
 
 void HYTagManager::setSyncInterval(int interval)
@@ -817,27 +3187,9 @@ void HYTagManager::onSyncOfflineData()
     }
 }
 
-// Override setTagValue to handle offline mode
+// Name-based setter is a thin wrapper over the handle API
 bool HYTagManager::setTagValue(const QString &name, const QVariant &value)
 {
-    HYTag *tag = nullptr;
-    {
-        QMutexLocker locker(&m_hyMutex);
-        if (!m_hyTags.contains(name)) {
-            return false;
-        }
-        tag = m_hyTags[name];
-    }
-    
-    if (tag) {
-        tag->setValue(value);
-        
-        // Store in offline data if in offline mode
-        if (m_hyOfflineMode) {
-            QMutexLocker locker(&m_hyMutex);
-            m_hyOfflineData[name].append(qMakePair(QDateTime::currentDateTime(), value));
-        }
-    }
-    return true;
+    return setValue(resolveTag(name), value);
 }
 
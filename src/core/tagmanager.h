@@ -7,6 +7,7 @@
 #include <QVariant>
 #include <QVector>
 #include <QMutex>
+#include <QReadWriteLock>
 #include <QTimer>
 #include <QSet>
 #include <QDateTime>
@@ -14,6 +15,31 @@
 #include <QSqlQuery>
 #include <QSqlError>
 #include <QDir>
+#include <QHash>
+#include <QPointer>
+#include <QMetaProperty>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QWaitCondition>
+#include <QRecursiveMutex>
+#include <functional>
+#include <memory>
+#include <set>
+
+#include "tagvaluestore.h"
+#include "tagbitset.h"
+#include "tagtrie.h"
+#include "tagjournal.h"
+#include "tagsnapshot.h"
+#include "tagsharedtable.h"
+#include "taghistory.h"
+#include "tagexpression.h"
+#include "offlinebuffer.h"
+
+class HYTagManager;
+class HYTimeSeriesDatabase;
+class HYOfflineReplayer;
 
 /**
  * @file tagmanager.h
@@ -38,6 +64,9 @@ class HYTag : public QObject
     Q_PROPERTY(QVariant value READ value NOTIFY valueChanged)
     Q_PROPERTY(QString description READ description CONSTANT)
     Q_PROPERTY(QString source READ source CONSTANT)
+    Q_PROPERTY(qint64 timestamp READ timestamp NOTIFY valueChanged)
+    Q_PROPERTY(qint64 serverTimestamp READ serverTimestamp NOTIFY valueChanged)
+    Q_PROPERTY(int quality READ quality NOTIFY valueChanged)
 
 public:
     /**
@@ -89,6 +118,24 @@ public:
      */
     QString source() const;
 
+    /**
+     * @brief 获取源时间戳
+     * @return 数据源采样时间（毫秒），未加入点位管理器时为0
+     */
+    qint64 timestamp() const;
+
+    /**
+     * @brief 获取服务器时间戳
+     * @return 写入点位表的时间（毫秒），未加入点位管理器时为0
+     */
+    qint64 serverTimestamp() const;
+
+    /**
+     * @brief 获取质量码
+     * @return 质量码，见HYTagValueStore::Quality；未加入点位管理器时为好值
+     */
+    int quality() const;
+
     // Setter
     /**
      * @brief 设置点位值
@@ -108,6 +155,12 @@ public:
      */
     void setSignalEnabled(bool enabled);
 
+    /**
+     * @brief 获取点位句柄
+     * @return 点位句柄，未加入点位管理器时为HYInvalidTagId
+     */
+    HYTagId tagId() const;
+
 signals:
     /**
      * @brief 点位值变化信号
@@ -122,6 +175,91 @@ private:
     QString m_hyDescription; ///< 点位描述
     QString m_hySource; ///< 数据来源
     bool m_hySignalEnabled; ///< 是否启用信号发射
+    HYTagManager *m_hyManager; ///< 所属点位管理器，值由其存储统一保存
+    HYTagId m_hyTagId; ///< 点位句柄
+
+    friend class HYTagManager;
+};
+
+/**
+ * @struct HYTagFilter
+ * @brief 点位值过滤配置
+ * 
+ * 死区过滤丢弃相对上次接受值变化过小的更新，限频过滤把过于频繁的通知推迟到间隔结束后合并发出
+ * 过滤在值写入存储和发出任何信号之前执行
+ */
+struct HYTagFilter
+{
+    /**
+     * @enum DeadbandType
+     * @brief 死区类型
+     */
+    enum DeadbandType {
+        DeadbandNone,     ///< 不使用死区
+        DeadbandAbsolute, ///< 绝对值死区
+        DeadbandPercent   ///< 百分比死区
+    };
+
+    DeadbandType deadbandType = DeadbandNone; ///< 死区类型
+    double deadband = 0.0; ///< 死区大小：绝对值，或百分比（0~100）
+    double rangeLow = 0.0; ///< 量程下限，百分比死区按量程计算
+    double rangeHigh = 0.0; ///< 量程上限，量程为空时按上次接受值的百分比计算
+    int minInterval = 0; ///< 最小通知间隔（毫秒），0表示不限频
+};
+
+/**
+ * @struct HYTagUpdate
+ * @brief 按句柄的单个点位更新
+ * 
+ * 平凡类型，可以在采集线程和应用线程之间按值传递
+ */
+struct HYTagUpdate
+{
+    HYTagId id = HYInvalidTagId; ///< 点位句柄
+    qint64 timestamp = 0; ///< 源时间戳（毫秒）
+    HYTagValue value; ///< 新值
+    quint8 quality = HYTagValueStore::QualityGood; ///< 质量码
+};
+Q_DECLARE_TYPEINFO(HYTagUpdate, Q_PRIMITIVE_TYPE);
+
+/**
+ * @struct HYTagDefinition
+ * @brief 点位定义，批量导入的单位
+ */
+struct HYTagDefinition
+{
+    QString name; ///< 点位名称
+    QString group; ///< 点位组
+    QVariant value; ///< 初始值
+    QString description; ///< 点位描述
+    QString source; ///< 数据来源
+};
+
+/**
+ * @struct HYNotificationMetrics
+ * @brief 通知调度统计
+ * 
+ * 延迟为订阅者首个未通知的变化到该批次送达之间的时间
+ */
+struct HYNotificationMetrics
+{
+    quint64 flushes = 0; ///< 已送达的批次数
+    quint64 notifications = 0; ///< 已送达的点位数（合并后）
+    int lastBatchSize = 0; ///< 最近一批的点位数
+    int maxBatchSize = 0; ///< 最大一批的点位数
+    qint64 lastLatency = 0; ///< 最近一批的延迟（毫秒）
+    qint64 maxLatency = 0; ///< 最大延迟（毫秒）
+};
+
+/**
+ * @struct HYSubscribeOptions
+ * @brief 模式订阅选项
+ */
+struct HYSubscribeOptions
+{
+    QObject *context = nullptr; ///< 上下文对象，回调在其所在线程执行；对象销毁后订阅自动取消
+    int maxLatency = 50; ///< 最大通知延迟（毫秒）
+    bool initialValues = false; ///< 是否先送达订阅时已匹配点位的当前值
 };
 
 /**
@@ -137,11 +275,37 @@ class HYTagManager : public QObject
     Q_OBJECT
 
 public:
+    typedef HYTagId TagId; ///< 点位句柄类型
+    static constexpr TagId InvalidTagId = HYInvalidTagId; ///< 无效点位句柄
+
+    static constexpr int DefaultShardCount = 16; ///< 默认分片数
+    static constexpr int DefaultHistoryHeartbeat = 600000; ///< 默认历史归档心跳间隔（毫秒）
+
+    typedef std::function<void(const QVector<HYTagUpdate> &)> NotifyCallback; ///< 订阅回调，参数为合并后的点位更新
+    static constexpr int DelayedSubscriber = 0; ///< 延迟通知模式使用的内置订阅者
+    static constexpr int MaxSubscribers = 64; ///< 最多订阅者数（含内置订阅者）
+
+    /**
+     * @enum TagFileFormat
+     * @brief 点位定义文件格式
+     */
+    enum TagFileFormat {
+        TagFileCsv,    ///< CSV文本，便于人工编辑
+        TagFileBinary  ///< 二进制，保留值类型，加载最快
+    };
+
     /**
      * @brief 构造函数
      * @param parent 父对象
      */
     explicit HYTagManager(QObject *parent = nullptr);
+
+    /**
+     * @brief 构造函数
+     * @param shardCount 分片数，向上取整为2的幂，最大为HYTagValueStore::MaxShards
+     * @param parent 父对象
+     */
+    explicit HYTagManager(int shardCount, QObject *parent = nullptr);
     
     /**
      * @brief 析构函数
@@ -194,6 +358,12 @@ public:
      */
     QVector<QString> getGroups() const;
 
+    /**
+     * @brief 获取分片数
+     * @return 分片数
+     */
+    int shardCount() const;
+
     // 点位值操作
     /**
      * @brief 设置点位值
@@ -217,9 +387,153 @@ public:
      */
     QVariant getTagValue(const QString &name) const;
 
+    // 点位句柄操作
+    /**
+     * @brief 解析点位句柄
+     *
+     * 调用方应在初始化时解析一次并缓存句柄，之后按句柄读写以避免名称查找
+     * @param name 点位名称
+     * @return 点位句柄，不存在时为InvalidTagId
+     */
+    TagId resolveTag(const QString &name) const;
+
+    /**
+     * @brief 获取点位名称
+     * @param id 点位句柄
+     * @return 点位名称，句柄无效时为空
+     */
+    QString tagName(TagId id) const;
+
+    /**
+     * @brief 按句柄设置点位值
+     * @param id 点位句柄
+     * @param value 新的点位值
+     * @return 设置是否成功
+     */
+    bool setValue(TagId id, const QVariant &value);
+
+    /**
+     * @brief 按句柄设置类型化点位值
+     *
+     * 数据源的热路径接口，存储和比较均不经过QVariant；写入的值质量码为Good
+     * @param id 点位句柄
+     * @param value 新的点位值
+     * @return 设置是否成功
+     */
+    bool setValue(TagId id, const HYTagValue &value);
+
+    /**
+     * @brief 按句柄批量设置类型化点位值
+     *
+     * 采集队列的应用线程使用此接口，涉及的分片按升序一次性锁定，值按各自的采集时间戳写入
+     * 同一点位在批次中出现多次时按顺序依次应用
+     * @param updates 点位更新列表
+     * @return 成功应用的更新数，不存在的点位被跳过
+     */
+    int setValues(const QVector<HYTagUpdate> &updates);
+
+    /**
+     * @brief 按句柄获取点位值
+     *
+     * 数值、布尔和字符串类型无锁读取，不会阻塞数据源的写入
+     * @param id 点位句柄
+     * @return 点位值
+     */
+    QVariant value(TagId id) const;
+
+    /**
+     * @brief 按句柄获取类型化点位值
+     *
+     * 无锁读取，不构造QVariant
+     * @param id 点位句柄
+     * @return 点位值，无法表示为HYTagValue的值返回空值
+     */
+    HYTagValue typedValue(TagId id) const;
+
+    /**
+     * @brief 读取同一代的一组点位值
+     *
+     * 返回的所有值来自同一次写入之后的状态，不会出现一部分点位新、一部分点位旧的情况
+     * @param ids 点位句柄列表
+     * @param generation 输出读取时的代数，可为空
+     * @return 与ids一一对应的点位值，无效句柄对应空值
+     */
+    QVector<QVariant> snapshot(const QVector<TagId> &ids, quint64 *generation = nullptr) const;
+
+    /**
+     * @brief 获取点位值存储的当前代数
+     * @return 已完成的写入批次数
+     */
+    quint64 generation() const;
+
+    /**
+     * @brief 按句柄获取点位源时间戳
+     * @param id 点位句柄
+     * @return 数据源采样时间（毫秒）
+     */
+    qint64 timestamp(TagId id) const;
+
+    /**
+     * @brief 按句柄获取点位服务器时间戳
+     * @param id 点位句柄
+     * @return 写入点位表的时间（毫秒）
+     */
+    qint64 serverTimestamp(TagId id) const;
+
+    /**
+     * @brief 无锁读取点位的值、时间戳和质量码
+     * @param id 点位句柄
+     * @return 记录，句柄无效时质量码为坏值；值无法表示为类型化值时为空值
+     */
+    HYTagRecord record(TagId id) const;
+
+    /**
+     * @brief 按句柄写入数据源提供的值、源时间戳和质量码
+     * 
+     * 服务器时间戳取写入时间；质量码变化时即使值相同或在死区内也会写入并通知
+     * @param id 点位句柄
+     * @param value 新值
+     * @param sourceTimestamp 源时间戳（毫秒）
+     * @param quality 质量码
+     * @return 点位是否存在
+     */
+    bool setValue(TagId id, const HYTagValue &value, qint64 sourceTimestamp, quint8 quality);
+
+    /**
+     * @brief 按句柄写入数据源提供的任意类型值、源时间戳和质量码
+     *
+     * 可表示为HYTagValue的值按类型化接口写入；其他值连同时间戳和质量码一次写入，只通知一次
+     * @param id 点位句柄
+     * @param value 新值
+     * @param sourceTimestamp 源时间戳（毫秒）
+     * @param quality 质量码
+     * @return 点位是否存在
+     */
+    bool setValue(TagId id, const QVariant &value, qint64 sourceTimestamp, quint8 quality);
+
+    /**
+     * @brief 按句柄设置质量码，值不变
+     * 
+     * 供数据源在通信中断等情况下标记点位，质量码变化时按值变化通知
+     * @param id 点位句柄
+     * @param quality 质量码
+     * @return 点位是否存在
+     */
+    bool setQuality(TagId id, quint8 quality);
+
+    /**
+     * @brief 按句柄获取点位质量码
+     * @param id 点位句柄
+     * @return 质量码，见HYTagValueStore::Quality
+     */
+    quint8 quality(TagId id) const;
+
     // 点位绑定
     /**
      * @brief 将点位绑定到对象属性
+     * 
+     * 属性在绑定时解析一次，更新时直接按QMetaProperty写入并按属性类型转换值
+     * 对象销毁后绑定自动移除；对象上不存在的属性按动态属性写入
      * @param tagName 点位名称
      * @param object 对象指针
      * @param propertyName 属性名称
@@ -248,6 +562,82 @@ public:
      */
     void setTagImportant(const QString &tagName, bool important);
 
+    // 通知订阅
+    /**
+     * @brief 订阅点位值变化
+     * 
+     * 每个订阅者有独立的脏点位集合，通知调度器按固定周期合并发出：
+     * 同一点位在一批内多次变化只通知最新值，每个变化在maxLatency（加上定时器抖动）内送达，
+     * 持续变化的点位也不会被无限推迟
+     * @param ids 点位句柄列表，为空时订阅所有点位
+     * @param context 上下文对象，回调在其所在线程执行；对象销毁后订阅自动取消；为空时在点位管理器线程执行
+     * @param callback 回调函数，无法表示为类型化值的点位值为空，可按句柄调用value()读取
+     * @param maxLatency 最大通知延迟（毫秒）
+     * @return 订阅者编号，订阅者数已满时为-1
+     */
+    int subscribe(const QVector<TagId> &ids, QObject *context, const NotifyCallback &callback, int maxLatency = 50);
+
+    /**
+     * @brief 按名称模式订阅点位值变化
+     * 
+     * 点位名称按'.'分级，"*"匹配一级，"**"匹配任意多级，例如plant.bf1.*.temperature
+     * 订阅时和之后添加的匹配点位都会被通知，批次合并规则与按句柄订阅相同
+     * 写入方只访问关注该点位的订阅者，通知开销与订阅者总数无关
+     * @param pattern 名称模式
+     * @param callback 回调函数
+     * @param options 订阅选项
+     * @return 订阅者编号，模式无效或订阅者数已满时为-1
+     */
+    int subscribe(const QString &pattern, const NotifyCallback &callback,
+                  const HYSubscribeOptions &options = HYSubscribeOptions());
+
+    /**
+     * @brief 取消订阅，尚未送达的变化被丢弃
+     * @param subscriber 订阅者编号
+     */
+    void unsubscribe(int subscriber);
+
+    /**
+     * @brief 获取通知调度统计
+     * @param subscriber 订阅者编号，默认为延迟通知模式的内置订阅者
+     * @return 统计信息
+     */
+    HYNotificationMetrics notificationMetrics(int subscriber = DelayedSubscriber) const;
+
+    // 点位值过滤
+    /**
+     * @brief 设置点位过滤配置，覆盖所在组的配置
+     * @param tagName 点位名称
+     * @param filter 过滤配置
+     */
+    void setTagFilter(const QString &tagName, const HYTagFilter &filter);
+
+    /**
+     * @brief 清除点位过滤配置，恢复使用所在组的配置
+     * @param tagName 点位名称
+     */
+    void clearTagFilter(const QString &tagName);
+
+    /**
+     * @brief 设置组过滤配置，作用于组内未单独配置的点位（包括之后加入的点位）
+     * @param group 点位组
+     * @param filter 过滤配置
+     */
+    void setGroupFilter(const QString &group, const HYTagFilter &filter);
+
+    /**
+     * @brief 清除组过滤配置
+     * @param group 点位组
+     */
+    void clearGroupFilter(const QString &group);
+
+    /**
+     * @brief 获取点位当前生效的过滤配置
+     * @param tagName 点位名称
+     * @return 过滤配置，未配置时为默认值
+     */
+    HYTagFilter tagFilter(const QString &tagName) const;
+
     // 性能优化方法
     /**
      * @brief 批量添加点位
@@ -255,6 +645,35 @@ public:
      * @return 添加是否成功
      */
     bool addTags(const QVector<QMap<QString, QVariant>> &tags);
+
+    /**
+     * @brief 批量添加点位定义
+     * 
+     * 一次加锁完成全部插入，不逐个发出tagAdded，结束时发出一次tagsAdded
+     * @param definitions 点位定义列表，已存在的点位被跳过
+     * @return 新添加的点位数
+     */
+    int addTagDefinitions(const QVector<HYTagDefinition> &definitions);
+
+    /**
+     * @brief 从点位定义文件批量导入点位
+     * 
+     * 按文件头自动识别格式：二进制文件以"HYTG"开头，否则按CSV解析
+     * CSV首行为列名，识别name、group、value、description、source列（不区分大小写），name列必需；
+     * 字段可用双引号包围，值列依次按空、true/false、整数、浮点数、字符串解析
+     * @param filePath 文件路径
+     * @param error 输出错误信息，可为空
+     * @return 新添加的点位数，文件无法读取或格式错误时为-1
+     */
+    int importTags(const QString &filePath, QString *error = nullptr);
+
+    /**
+     * @brief 把当前所有点位的定义和值导出为点位定义文件
+     * @param filePath 文件路径
+     * @param format 文件格式
+     * @return 是否成功
+     */
+    bool exportTags(const QString &filePath, TagFileFormat format = TagFileBinary) const;
     
     /**
      * @brief 启用批量更新模式
@@ -276,26 +695,120 @@ public:
      */
     bool setTagValuesOptimized(const QMap<QString, QVariant> &values, bool immediate = false);
 
+    // 计算点位
+    /**
+     * @brief 添加由表达式计算的点位
+     * 
+     * 表达式编译为字节码（语法见HYTagExpression），引用的点位必须已经存在，可以是其他计算点位
+     * 计算点位按依赖关系组成有向无环图；源点位变化时写入方只做标记，在点位管理器所在线程合并重算一次，
+     * 只按拓扑顺序重算受影响的计算点位，结果未变的点位不再向下传播
+     * 结果为浮点值，质量码取输入中最差的，时间戳取输入中最新的；结果不是有限值时质量码为QualityBad
+     * 计算点位的值由引擎维护，直接写入的值会在下次重算时被覆盖
+     * @param name 点位名称
+     * @param group 点位组
+     * @param expression 表达式
+     * @param description 点位描述
+     * @param error 输出错误信息，可为空
+     * @return 是否成功
+     */
+    bool addCalculatedTag(const QString &name, const QString &group, const QString &expression,
+                          const QString &description = "", QString *error = nullptr);
+
+    /**
+     * @brief 检查点位是否为计算点位
+     * @param name 点位名称
+     * @return 是否为计算点位
+     */
+    bool isCalculatedTag(const QString &name) const;
+
+    /**
+     * @brief 获取计算点位的表达式
+     * @param name 点位名称
+     * @return 表达式，不是计算点位时为空
+     */
+    QString calculatedExpression(const QString &name) const;
+
+    /**
+     * @brief 立即重算所有输入已变化的计算点位
+     * @return 值或质量码变化的计算点位数
+     */
+    int recomputeCalculatedTags();
+
     // 历史数据存储
     /**
      * @brief 启用历史数据存储
+     * 
+     * 按例外归档：每个周期只写入自上次归档以来变化超过死区的点位，以及超过心跳间隔未写入的点位
+     * 质量码变化的点位总是写入；启用时已有的点位各写入一次当前值
+     * 过期数据由历史库的后台线程按整个分区删除，不在归档周期中清理
      * @param enabled 是否启用
-     * @param interval 存储间隔（毫秒）
+     * @param interval 归档周期（毫秒）
      * @param retentionDays 保留天数
      */
     void enableHistoryStorage(bool enabled, int interval = 1000, int retentionDays = 365);
+
+    /**
+     * @brief 设置历史库文件
+     * @param path 数据库文件路径，默认为~/.huayan/data/history.db
+     * @return 是否打开成功
+     */
+    bool setHistoryDatabasePath(const QString &path);
+
+    /**
+     * @brief 获取历史库文件路径
+     * @return 文件路径
+     */
+    QString historyDatabasePath() const;
+
+    /**
+     * @brief 设置历史库的分区粒度，只影响之后新建的分区
+     * @param partitioning 分区粒度，默认每天一个分区
+     */
+    void setHistoryPartitioning(HYTagHistory::Partitioning partitioning);
+
+    /**
+     * @brief 设置历史归档的默认死区
+     * 
+     * 数值点位与上次归档值之差的绝对值超过死区时才写入；0表示任何变化都写入
+     * @param deadband 死区（工程单位）
+     */
+    void setHistoryDeadband(double deadband);
+
+    /**
+     * @brief 设置单个点位的历史归档死区，可在点位添加前设置
+     * @param tagName 点位名称
+     * @param deadband 死区（工程单位），负数表示改用默认死区
+     */
+    void setHistoryDeadband(const QString &tagName, double deadband);
+
+    /**
+     * @brief 设置历史归档的心跳间隔
+     * 
+     * 未变化的点位距上次写入超过心跳间隔后，以当前时间再写入一次当前值，表明数据仍然有效
+     * 巡检每个心跳间隔覆盖全部点位一次，因此两次写入之间最长约为两个心跳间隔
+     * @param interval 心跳间隔（毫秒），0表示不写心跳
+     */
+    void setHistoryHeartbeat(int interval);
+
+    /**
+     * @brief 立即执行一次历史归档，不清理过期数据
+     * @return 写入的样本数
+     */
+    int archiveHistory();
     
     /**
      * @brief 获取历史数据
      * @param tagName 点位名称
      * @param startTime 开始时间
      * @param endTime 结束时间
-     * @return 历史数据列表
+     * @param qualities 输出与历史数据逐条对应的质量码，可为空
+     * @return 历史数据列表，时间为数据源采样时间
      */
-    QVector<QPair<QDateTime, QVariant>> getHistoricalData(const QString &tagName, const QDateTime &startTime, const QDateTime &endTime);
+    QVector<QPair<QDateTime, QVariant>> getHistoricalData(const QString &tagName, const QDateTime &startTime, const QDateTime &endTime,
+                                                          QVector<quint8> *qualities = nullptr);
     
     /**
-     * @brief 清理历史数据
+     * @brief 立即清理历史数据，删除全部早于保留期的分区
      * @param days 保留天数
      */
     void cleanHistoricalData(int days = 365);
@@ -303,21 +816,56 @@ public:
     // 断点续传
     /**
      * @brief 启用断点续传
-     * @param enabled 是否启用
-     * @param persistFilePath 续传文件路径
+     * 
+     * 点位状态保存为检查点加追加写入的日志，见HYTagJournal
+     * 日志在首次调用loadState或saveState后开始记录，之后的点位增删和值变化每SyncInterval毫秒合并落盘一次
+     * 同时打开内存映射的值快照（persistFilePath.values.N，见HYTagSnapshot）：启用后新增或已有的点位立即取回
+     * 上次运行中最后的值，质量码为QualityLastUsable，不必等待loadState回放日志
+     * @param enabled 是否启用，关闭时先把未落盘的记录写入日志
+     * @param persistFilePath 检查点文件路径，日志文件与其同目录；旧版本的JSON状态文件时检查点为该路径加.state
      */
     void enablePersistence(bool enabled, const QString &persistFilePath = "");
     
     /**
      * @brief 保存点位状态
+     * 
+     * 写入新的检查点并清理已被覆盖的日志；日志增长到CheckpointBytes时也会自动执行
      */
     void saveState();
     
     /**
      * @brief 加载点位状态
+     * 
+     * 回放最新的检查点和其后的日志：已有点位更新值，其余点位一次性添加并发出一次tagsAdded，不逐个发出tagAdded
+     * 回放后立即写入新的检查点，此后的日志按当前句柄记录
+     * 还没有检查点时导入旧版本的JSON状态文件，检查点写在它旁边，JSON文件不被覆盖
      */
     void loadState();
 
+    // 共享内存发布
+    /**
+     * @brief 把点位值发布到共享内存
+     * 
+     * 其他进程通过HYTagSharedReader按名称查找、按下标无锁读取当前值，见HYTagSharedTable
+     * 已有的点位立即发布，之后新增、删除的点位和值变化随写入同步更新
+     * @param name 共享内存名称
+     * @param capacity 记录数，句柄不小于该值的点位不发布
+     * @return 是否成功
+     */
+    bool publishSharedMemory(const QString &name = QStringLiteral("huayan.tags"),
+                             int capacity = HYTagSharedTable::DefaultCapacity);
+
+    /**
+     * @brief 停止发布，删除共享内存名称
+     */
+    void unpublishSharedMemory();
+
+    /**
+     * @brief 获取正在发布的共享内存名称
+     * @return 名称，未发布时为空
+     */
+    QString sharedMemoryName() const;
+
     // 离线能力
     /**
      * @brief 设置离线模式
@@ -333,8 +881,63 @@ public:
     
     /**
      * @brief 同步离线数据
+     * 
+     * 把各分片内存中的记录写入磁盘，再由回放器按时间顺序成批写入历史库，完成后发出syncCompleted
+     * 回放在事件循环中分批进行，受速率限制并让出实时写入；未设置历史库时数据留在磁盘上
      */
     void syncOfflineData();
+
+    /**
+     * @brief 设置离线数据回放的目标历史库
+     * @param database 时间序列数据库，为空时不回放
+     */
+    void setHistorian(HYTimeSeriesDatabase *database);
+
+    /**
+     * @brief 设置离线数据回放的批大小和速率上限
+     * @param batchSize 每批最多条数
+     * @param maxRate 每秒最多回放条数
+     */
+    void setOfflineReplayLimits(int batchSize, int maxRate);
+
+    /**
+     * @brief 获取尚未回放的离线数据大小
+     * @return 字节数
+     */
+    qint64 offlineBacklogBytes() const;
+
+    /**
+     * @brief 获取当前回放的平均速率
+     * @return 每秒条数
+     */
+    double offlineReplayRate() const;
+
+    /**
+     * @brief 设置离线数据缓冲区的大小
+     * 
+     * 离线期间的值变化按分片在内存中编码，每个分片的记录超过memoryBytes/分片数时整块写入磁盘
+     * @param memoryBytes 内存缓冲区总字节数
+     * @param diskBytes 磁盘段文件总字节数上限，超过时按淘汰策略释放
+     */
+    void setOfflineBufferLimits(qint64 memoryBytes, qint64 diskBytes);
+
+    /**
+     * @brief 设置离线数据超过磁盘上限时的淘汰策略
+     * @param policy 丢弃最旧的数据或降采样
+     */
+    void setOfflineEvictionPolicy(HYOfflineBuffer::EvictionPolicy policy);
+
+    /**
+     * @brief 设置离线数据段文件目录
+     * @param directory 目录，默认为~/.huayan/offline
+     */
+    void setOfflineBufferDirectory(const QString &directory);
+
+    /**
+     * @brief 获取磁盘上尚未同步的离线数据大小
+     * @return 字节数
+     */
+    qint64 offlineDiskSize() const;
     
     /**
      * @brief 设置同步间隔
@@ -348,6 +951,12 @@ signals:
      * @param name 点位名称
      */
     void tagAdded(const QString &name);
+
+    /**
+     * @brief 点位批量添加信号，由批量导入在结束时发出一次
+     * @param names 新添加的点位名称
+     */
+    void tagsAdded(const QStringList &names);
     
     /**
      * @brief 点位移除信号
@@ -381,17 +990,19 @@ signals:
      */
     void syncCompleted(bool success, int count);
 
-private slots:
     /**
-     * @brief 点位值变化槽函数
-     * @param newValue 新的点位值
+     * @brief 离线数据回放进度信号
+     * @param replayed 已回放的数据条数
+     * @param rate 平均回放速率（条/秒）
+     * @param backlogBytes 尚未回放的字节数
      */
-    void onTagValueChanged(const QVariant &newValue);
-    
+    void offlineReplayProgress(qint64 replayed, double rate, qint64 backlogBytes);
+
+private slots:
     /**
-     * @brief 延迟通知槽函数
+     * @brief 通知周期槽函数，送达到期的订阅者批次
      */
-    void onDelayedNotification();
+    void onNotificationTick();
     
     /**
      * @brief 历史数据存储槽函数
@@ -403,39 +1014,440 @@ private slots:
      */
     void onSyncOfflineData();
 
+    /**
+     * @brief 限频过滤推迟通知的补发槽函数
+     */
+    void onFilterFlush();
+
 private:
-    QMap<QString, HYTag *> m_hyTags; ///< 点位映射表
-    QMap<QString, QVector<HYTag *>> m_hyTagsByGroup; ///< 按组分类的点位映射表
-    QMutex m_hyMutex; ///< 互斥锁
+    /**
+     * @enum FilterResult
+     * @brief 过滤结果
+     */
+    enum FilterResult {
+        FilterPass,   ///< 写入并通知
+        FilterReject, ///< 在死区内，丢弃
+        FilterDefer   ///< 写入，通知推迟到限频间隔结束
+    };
+
+    /**
+     * @struct FilterState
+     * @brief 单个点位的过滤状态
+     */
+    struct FilterState {
+        HYTagFilter filter; ///< 生效的过滤配置
+        bool explicitFilter = false; ///< 是否为点位级配置
+        HYTagValue lastValue; ///< 上次接受的值
+        qint64 lastReported = 0; ///< 上次通知时间（毫秒）
+    };
 
     // 绑定管理
+    /**
+     * @enum BindingWriter
+     * @brief 绑定属性的写入方式，绑定时按属性类型选定
+     */
+    enum BindingWriter {
+        WriteVariant,  ///< 原样写入，由QMetaProperty转换
+        WriteDouble,   ///< 写入double属性
+        WriteInt,      ///< 写入int属性
+        WriteLongLong, ///< 写入qlonglong属性
+        WriteBool,     ///< 写入bool属性
+        WriteString,   ///< 写入QString属性
+        WriteDynamic   ///< 按名称写入动态属性
+    };
+
     struct Binding {
-        QObject *object; ///< 对象指针
-        const char *propertyName; ///< 属性名称
+        QPointer<QObject> object; ///< 对象指针，对象销毁后自动置空
+        QMetaProperty property; ///< 绑定时解析的属性
+        QByteArray propertyName; ///< 属性名称
+        BindingWriter writer = WriteVariant; ///< 写入方式
+        QMetaObject::Connection destroyedConnection; ///< 对象销毁时移除绑定的连接
+    };
+
+    /**
+     * @struct Shard
+     * @brief 点位分片
+     * 
+     * 点位按句柄低位轮流分配到各分片，分片内点位的写入、待通知值、绑定、过滤状态和离线数据
+     * 都由分片锁保护，不同分片的数据源可以并行写入
+     */
+    struct alignas(64) Shard {
+        QMutex mutex; ///< 分片锁
+        QVector<HYTag *> tags; ///< 按分片内下标索引的点位对象
+        QMap<QString, QVector<Binding>> bindings; ///< 点位绑定映射表
+        QSet<TagId> importantTags; ///< 重要点位
+        QHash<TagId, FilterState> filterStates; ///< 已配置过滤的点位状态，为空时过滤零开销
+        QSet<TagId> filterPending; ///< 被限频推迟、等待补发通知的点位
+        QByteArray offline; ///< 尚未写入磁盘的离线记录，HYTagJournal格式
+        QSet<TagId> offlineDefined; ///< 已在offline中写入定义记录的点位
+        QByteArray journal; ///< 尚未写入日志的记录，由日志线程定期取走
     };
-    QMap<QString, QVector<Binding>> m_hyBindings; ///< 点位绑定映射表
+
+    /**
+     * @struct Subscriber
+     * @brief 通知订阅者
+     * 
+     * 写入方只访问原子成员和脏点位集，无需加锁；其余配置和统计受m_hySubscriberMutex保护
+     * 订阅者关注的点位记录在m_hyTagSubscribers中，不在订阅者内部
+     * 订阅者对象在点位管理器析构前不会释放，取消订阅后槽位可被复用
+     */
+    struct Subscriber {
+        std::atomic<bool> active{false}; ///< 是否有效
+        bool allTags = false; ///< 是否订阅所有点位，在active发布前设置
+        HYTagBitset dirty; ///< 尚未通知的点位
+        std::atomic<qint64> firstDirty{0}; ///< 首个未通知变化的时刻（通知时钟毫秒数加一），0表示没有
+        std::atomic<int> maxLatency{0}; ///< 最大通知延迟（毫秒）
+        QPointer<QObject> context; ///< 上下文对象
+        bool hasContext = false; ///< 是否指定了上下文对象
+        NotifyCallback callback; ///< 回调函数
+        QString pattern; ///< 名称模式，按句柄订阅时为空
+        HYNotificationMetrics metrics; ///< 通知统计
+    };
+
+    /**
+     * @struct ArchiveState
+     * @brief 点位的历史归档状态，只由归档周期访问
+     */
+    struct ArchiveState {
+        qint64 series = 0; ///< 历史库中的序列号，0表示尚未分配
+        HYTagValue value; ///< 上次归档的值
+        quint8 quality = 0; ///< 上次归档的质量码
+        qint64 writtenAt = 0; ///< 上次写入的时间（毫秒），0表示从未写入
+        double deadband = -1.0; ///< 点位的死区，负数表示使用默认死区
+    };
+
+    /**
+     * @struct CalculatedTag
+     * @brief 计算点位，结果同时缓存在这里，供依赖它的计算点位读取
+     */
+    struct CalculatedTag {
+        HYTagExpression expression; ///< 编译后的表达式
+        QVector<TagId> inputs; ///< 与表达式变量逐个对应的输入点位
+        double value = 0.0; ///< 上次计算的结果
+        quint8 quality = HYTagValueStore::QualityBad; ///< 上次计算的质量码
+        qint64 timestamp = 0; ///< 上次计算的时间戳（毫秒）
+        bool evaluated = false; ///< 是否已计算过
+    };
+
+    /**
+     * @struct BatchEntry
+     * @brief 批量写入中的单个点位
+     */
+    struct BatchEntry {
+        TagId id; ///< 点位句柄
+        QString name; ///< 点位名称
+        QVariant value; ///< 新值
+    };
+
+    /**
+     * @brief 获取句柄所在分片
+     * @param id 点位句柄
+     * @return 分片
+     */
+    Shard &shardOf(TagId id) const;
+
+    /**
+     * @brief 在持有分片锁或目录读锁的情况下获取点位对象
+     * @param id 点位句柄
+     * @return 点位对象，句柄无效时为nullptr
+     */
+    HYTag *tagObject(TagId id) const;
+
+    /**
+     * @brief 在已持有m_hyMutex的情况下添加点位
+     * @return 点位句柄，点位已存在时为InvalidTagId
+     */
+    TagId addTagLocked(const QString &name, const QString &group, const QVariant &value,
+                       const QString &description, const QString &source);
+
+    /**
+     * @brief 插入点位
+     * 
+     * 调用方须持有m_hyMutex、点位目录写锁和下一个句柄所在分片的锁
+     * @param timestamp 初始值时间戳（毫秒）
+     * @return 点位句柄，点位已存在或存储已满时为InvalidTagId
+     */
+    TagId insertTagLocked(const QString &name, const QString &group, const QVariant &value,
+                          const QString &description, const QString &source, qint64 timestamp);
+
+    /**
+     * @brief 分发单个点位的值变化通知
+     * @param tag 点位对象
+     * @param newValue 新的点位值
+     * @param typedValue 新值的类型化形式，非空时绑定属性直接由其转换写入
+     */
+    void notifyValueChanged(HYTag *tag, const QVariant &newValue, const HYTagValue *typedValue = nullptr);
+
+    /**
+     * @brief 在已持有分片锁的情况下对新值执行过滤
+     * @param shard 点位所在分片
+     * @param id 点位句柄
+     * @param value 新值
+     * @param now 当前时间（毫秒）
+     * @return 过滤结果
+     */
+    FilterResult filterValueLocked(Shard &shard, TagId id, const HYTagValue &value, qint64 now);
+
+    /**
+     * @brief 在已持有分片锁的情况下为点位安装过滤配置
+     * @param shard 点位所在分片
+     * @param id 点位句柄
+     * @param filter 过滤配置
+     * @param explicitFilter 是否为点位级配置
+     */
+    void installFilterLocked(Shard &shard, TagId id, const HYTagFilter &filter, bool explicitFilter);
+
+    /**
+     * @brief 在已持有分片锁的情况下过滤并写入类型化值
+     * @param shard 点位所在分片
+     * @param tag 点位对象
+     * @param value 新值
+     * @param timestamp 源时间戳（毫秒）
+     * @param now 当前时间（毫秒），作为服务器时间戳并用于限频判断
+     * @param quality 质量码，HYTagValueStore::KeepQuality表示保留原质量码
+     * @return 值已写入且需要立即通知时为true
+     */
+    bool writeTypedLocked(Shard &shard, HYTag *tag, const HYTagValue &value, qint64 timestamp, qint64 now,
+                          int quality);
+
+    /**
+     * @brief 在已持有分片锁的情况下把点位的当前值记入分片的日志缓冲区和值快照，并发布到共享内存
+     * 
+     * 启用历史数据存储时同时标记点位待归档；未启用日志、值快照和共享内存发布时不读取当前值
+     * @param shard 点位所在分片
+     * @param id 点位句柄
+     */
+    void persistValueLocked(Shard &shard, TagId id);
+
+    /**
+     * @brief 标记全部点位待归档
+     */
+    void markHistoryDirty();
+
+    /**
+     * @brief 按句柄升序重算待处理的计算点位，值变化的点位把依赖它的计算点位加入待处理集合
+     * 
+     * 计算点位的句柄总是大于其输入的句柄，因此升序即拓扑顺序；调用方持有m_hyCalcMutex
+     * @param pending 待重算的计算点位，返回时为空
+     * @param updates 输出值或质量码变化的计算点位
+     */
+    void recomputeLocked(std::set<TagId> *pending, QVector<HYTagUpdate> *updates);
+
+    /**
+     * @brief 点位删除后更新计算点位的依赖关系，并重算依赖它的计算点位
+     * @param id 已删除点位的句柄
+     */
+    void detachCalculatedTag(TagId id);
+
+    /**
+     * @brief 在已持有分片锁的情况下取回点位在上次运行中最后的值，并在值快照中为点位分配记录
+     * 
+     * 取回的值以QualityLastUsable质量码写入，直到数据源给出新值
+     * @param id 点位句柄
+     * @param name 点位名称
+     */
+    void restoreLastKnownLocked(TagId id, const QString &name);
+
+    /**
+     * @brief 在已持有分片锁的情况下把点位的当前值记入分片的离线缓冲区
+     * 
+     * 缓冲区超过分片的份额时整块写入磁盘
+     * @param shard 点位所在分片
+     * @param id 点位句柄
+     * @param name 点位名称
+     */
+    void bufferOfflineLocked(Shard &shard, TagId id, const QString &name);
+
+    /**
+     * @brief 取走各分片的日志缓冲区，追加到日志并落盘
+     * 
+     * 调用方持有m_hyJournalMutex
+     */
+    void flushJournalLocked();
+
+    /**
+     * @brief 查找旧版本保存的JSON状态文件
+     *
+     * 持久化路径本身是JSON文件，或同目录下有同名的.json文件（旧的默认路径persist.json）时返回其路径
+     * @return JSON状态文件路径，没有时为空
+     */
+    QString legacyStatePath() const;
+
+    /**
+     * @brief 写入检查点并切换到新一代日志
+     * 
+     * 调用方持有m_hyJournalMutex；返回后日志处于记录状态
+     * @return 是否成功
+     */
+    bool checkpointLocked();
+
+    /**
+     * @brief 启动日志线程
+     */
+    void startJournal();
+
+    /**
+     * @brief 停止日志线程，并把未落盘的记录写入日志
+     */
+    void stopJournal();
+
+    /**
+     * @brief 日志线程主循环
+     */
+    void runJournal();
+
+    /**
+     * @brief 批量写入点位值
+     * 
+     * 按升序依次锁定涉及的分片，写入完成后统一释放，不同批次之间不会死锁
+     * @param values 点位名称和值的映射
+     * @param queuePending 是否把通过过滤的值加入延迟通知
+     * @param reported 输出通过过滤、需要通知的点位值
+     * @param bindings 输出需要更新的绑定属性
+     * @return 是否所有点位都存在
+     */
+    bool writeValues(const QMap<QString, QVariant> &values, bool queuePending,
+                     QMap<QString, QVariant> *reported, QVector<QPair<Binding, QVariant>> *bindings);
+
+    /**
+     * @brief 标记点位已变化，由订阅者在下一个到期周期合并通知
+     * 
+     * 无锁，可在持有分片锁时调用
+     * @param id 点位句柄
+     * @param delayed 是否同时交给延迟通知模式的内置订阅者
+     */
+    void markChanged(TagId id, bool delayed);
+
+    /**
+     * @brief 把点位加入订阅者的脏点位集，必要时开始计算延迟
+     * @param subscriber 订阅者
+     * @param id 点位句柄
+     * @param now 输入输出通知时钟，为0时按需读取
+     */
+    void markDirty(Subscriber *subscriber, TagId id, qint64 *now);
+
+    /**
+     * @brief 分配并配置订阅者槽位
+     * @param ids 订阅的点位句柄
+     * @param allTags 是否订阅所有点位
+     * @param pattern 名称模式，按句柄订阅时为空
+     * @param context 上下文对象
+     * @param callback 回调函数
+     * @param maxLatency 最大通知延迟（毫秒）
+     * @return 订阅者编号，订阅者数已满时为-1
+     */
+    int createSubscriber(const QVector<TagId> &ids, bool allTags, const QString &pattern, QObject *context,
+                         const NotifyCallback &callback, int maxLatency);
+
+    /**
+     * @brief 送达到期的订阅者批次
+     * @param force 是否忽略延迟期限，送达所有未通知的变化
+     */
+    void flushNotifications(bool force);
+
+    /**
+     * @brief 按当前订阅者的最大延迟重新计算通知周期
+     */
+    void updateNotificationCadence();
+
+    /**
+     * @brief 更新绑定属性，调用时不得持有任何分片锁
+     * @param bindings 绑定和值
+     */
+    static void applyBindings(const QVector<QPair<Binding, QVariant>> &bindings);
+
+    /**
+     * @brief 写入单个绑定属性，对象已销毁时忽略
+     * @param binding 绑定
+     * @param value 点位值
+     */
+    static void writeBinding(const Binding &binding, const QVariant &value);
+
+    /**
+     * @brief 把类型化值按属性类型直接转换后写入单个绑定属性，对象已销毁时忽略
+     * @param binding 绑定
+     * @param value 点位值
+     */
+    static void writeBinding(const Binding &binding, const HYTagValue &value);
+
+    /**
+     * @brief 移除点位上目标对象已销毁的绑定
+     * @param tagName 点位名称
+     * @param object 被销毁的对象
+     */
+    void pruneBindings(const QString &tagName, QObject *object);
+
+    // 锁顺序：m_hyMutex -> m_hyIndexLock -> 分片锁（多个分片按下标升序）
+    // 点位目录只在同时持有m_hyMutex和m_hyIndexLock写锁时修改，持有任一把锁即可读取
+    // 分片内的点位对象表修改时还需持有分片锁，因此值写入方只持有分片锁即可访问
+    QHash<QString, TagId> m_hyTagIds; ///< 点位名称到句柄的索引
+    HYTagTrie m_hyTagTrie; ///< 点位命名空间前缀树，与m_hyTagIds同步修改
+    HYTagValueStore m_hyValueStore; ///< 点位值存储，写入由分片锁串行化，读取无锁
+    QMap<QString, QVector<HYTag *>> m_hyTagsByGroup; ///< 按组分类的点位映射表
+    QMutex m_hyMutex; ///< 配置互斥锁，串行化点位增删和组配置
+    QReadWriteLock m_hyIndexLock; ///< 点位目录读写锁，读者不与值写入竞争
+    int m_hyShardBits; ///< 分片数的位数
+    std::unique_ptr<Shard[]> m_hyShards; ///< 点位分片
     
     // 延迟通知管理
     bool m_hyDelayedNotification; ///< 是否启用延迟通知
     int m_hyNotificationInterval; ///< 延迟通知间隔
-    QTimer *m_hyNotificationTimer; ///< 延迟通知定时器
-    QMap<QString, QVariant> m_hyPendingValues; ///< 待通知的点位值
-    QSet<QString> m_hyImportantTags; ///< 重要点位集合
+    QTimer *m_hyNotificationTimer; ///< 固定周期的通知定时器，写入方从不重启它
+    int m_hyNotificationTick; ///< 当前通知周期（毫秒），0表示没有需要调度的订阅者
+    QElapsedTimer m_hyNotificationClock; ///< 通知时钟，单调递增
+    std::atomic<Subscriber *> m_hySubscribers[MaxSubscribers]; ///< 订阅者槽位
+    std::atomic<int> m_hySubscriberCount; ///< 已创建的订阅者槽位数
+    QMutex m_hySubscriberMutex; ///< 订阅者配置和统计互斥锁
+    HYTagMaskTable m_hyTagSubscribers; ///< 每个点位的关注订阅者掩码，不含订阅所有点位的订阅者
+    std::atomic<quint64> m_hyAllTagsSubscribers; ///< 订阅所有点位的订阅者掩码，不含内置订阅者
+    HYTagTrie m_hyPatternTrie; ///< 订阅模式前缀树，新点位据此找到匹配的订阅者（受m_hyMutex保护）
+    QSet<QString> m_hyImportantTags; ///< 重要点位名称集合，可在点位添加前设置（受m_hyMutex保护）
+
+    // 点位值过滤
+    QHash<QString, HYTagFilter> m_hyGroupFilters; ///< 组过滤配置（受m_hyMutex保护）
+    QTimer *m_hyFilterTimer; ///< 限频补发定时器
 
     // 历史数据存储
-    QSqlDatabase m_hyDatabase; ///< 数据库连接
-    bool m_hyHistoryEnabled; ///< 是否启用历史数据存储
+    // 写入方只在m_hyHistoryDirty中标记变化的点位，其余成员只由所在线程的归档周期访问
+    HYTagHistory m_hyHistory; ///< 历史库
+    std::atomic<bool> m_hyHistoryEnabled; ///< 是否启用历史数据存储
     int m_hyHistoryInterval; ///< 历史数据存储间隔（毫秒）
     QTimer *m_hyHistoryTimer; ///< 历史数据存储定时器
     int m_hyHistoryRetentionDays; ///< 历史数据保留天数
+    HYTagBitset m_hyHistoryDirty; ///< 上次归档以来值或质量码变化的点位
+    QVector<ArchiveState> m_hyArchiveStates; ///< 按句柄索引的归档状态
+    QHash<QString, double> m_hyHistoryDeadbands; ///< 按点位名称设置的死区
+    double m_hyHistoryDeadband; ///< 默认死区
+    int m_hyHistoryHeartbeat; ///< 心跳间隔（毫秒）
+    TagId m_hyHistoryCursor; ///< 心跳巡检的下一个句柄
+
+    // 计算点位
+    // 锁顺序：m_hyCalcMutex在m_hyMutex和分片锁之前；写入方只在位图中标记，不获取m_hyCalcMutex
+    QRecursiveMutex m_hyCalcMutex; ///< 计算点位互斥锁，重算期间一直持有，保证结果按计算顺序写入
+    QHash<TagId, CalculatedTag> m_hyCalcTags; ///< 计算点位（受m_hyCalcMutex保护）
+    QHash<TagId, QVector<TagId>> m_hyCalcDependents; ///< 点位到直接依赖它的计算点位（受m_hyCalcMutex保护）
+    HYTagBitset m_hyCalcSources; ///< 被计算点位引用的非计算点位
+    HYTagBitset m_hyCalcDirty; ///< 上次重算以来变化的源点位
+    std::atomic<bool> m_hyCalcScheduled; ///< 是否已安排重算
 
     // 断点续传
+    // 锁顺序：m_hyJournalMutex在m_hyMutex之前，值写入方只向分片缓冲区追加，不获取m_hyJournalMutex
     bool m_hyPersistEnabled; ///< 是否启用断点续传
     QString m_hyPersistFilePath; ///< 断点续传文件路径
+    std::unique_ptr<HYTagJournal> m_hyJournal; ///< 点位状态日志（受m_hyJournalMutex保护）
+    HYTagSnapshot m_hySnapshot; ///< 内存映射的点位值快照（打开和关闭时持有全部分片锁）
+    HYTagSharedTable m_hySharedTable; ///< 共享内存点位表（打开和关闭时持有全部分片锁）
+    std::atomic<bool> m_hyJournalActive; ///< 是否记录日志，写入方据此决定是否追加记录
+    QMutex m_hyJournalMutex; ///< 日志互斥锁，串行化落盘和检查点
+    QWaitCondition m_hyJournalCondition; ///< 日志线程的等待条件
+    QThread *m_hyJournalThread; ///< 日志线程
+    bool m_hyJournalStopping; ///< 是否请求日志线程退出（受m_hyJournalMutex保护）
 
     // 离线能力
     bool m_hyOfflineMode; ///< 是否处于离线模式
-    QMap<QString, QVector<QPair<QDateTime, QVariant>>> m_hyOfflineData; ///< 离线数据缓存
+    HYOfflineBuffer m_hyOfflineBuffer; ///< 离线数据的磁盘缓冲区
+    qint64 m_hyOfflineMemoryBytes; ///< 离线数据内存缓冲区总字节数
+    HYOfflineReplayer *m_hyOfflineReplayer; ///< 离线数据回放器
     QTimer *m_hySyncTimer; ///< 同步定时器
     int m_hySyncInterval; ///< 同步间隔（毫秒）
 };
@@ -0,0 +1,128 @@
+#ifndef HYTAGSHAREDLAYOUT_H
+#define HYTAGSHAREDLAYOUT_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @file tagsharedlayout.h
+ * @brief 共享内存点位表的内存布局
+ *
+ * 发布端（HYTagSharedTable）和读取库（HYTagSharedReader）共用，只依赖标准库，外部进程无需链接Qt
+ *
+ * 布局：HeaderBytes字节的表头，随后依次是记录区、目录区和名称区，各区的偏移和大小记录在表头中
+ * - 记录区：capacity条64字节的定长记录，下标即点位句柄，每条记录自带顺序号
+ * - 目录区：开放寻址的散列表，按名称的键查找记录下标；目录整体由表头中的顺序号保护
+ * - 名称区：只追加的名称池，每个名称为2字节长度加UTF-8编码
+ *
+ * 所有数据按本机字节序保存，读取端与发布端须运行在同一台机器上
+ */
+
+namespace HYTagSharedLayout {
+
+constexpr uint32_t Magic = 0x54535948; ///< 表标识"HYST"，发布端初始化完成后最后写入
+constexpr uint32_t Version = 1; ///< 布局版本，不兼容的改动时递增
+constexpr uint32_t HeaderBytes = 4096; ///< 表头字节数
+constexpr int InlineText = 24; ///< 记录内可保存的字符串字节数，更长的字符串不保存
+constexpr uint32_t EmptyEntry = 0xFFFFFFFF; ///< 从未使用的目录项
+constexpr uint32_t RemovedEntry = 0xFFFFFFFE; ///< 点位已删除的目录项，查找时跳过但不终止探测
+
+/**
+ * @enum State
+ * @brief 表的状态
+ */
+enum State : uint32_t {
+    StateOpen = 1,  ///< 发布端正在更新
+    StateClosed = 2 ///< 发布端已关闭，内容不再更新
+};
+
+/**
+ * @enum ValueType
+ * @brief 记录中的值类型，前五种与HYTagValue::Type一致
+ */
+enum ValueType : uint8_t {
+    TypeNull = 0,         ///< 空值
+    TypeBool = 1,         ///< 布尔
+    TypeInt64 = 2,        ///< 64位整数
+    TypeDouble = 3,       ///< 双精度浮点
+    TypeString = 4,       ///< 字符串
+    TypeUnavailable = 0xFF ///< 值无法在记录中表示（复杂值或过长的字符串），质量码和时间戳仍有效
+};
+
+/**
+ * @struct Header
+ * @brief 表头
+ */
+struct Header {
+    std::atomic<uint32_t> magic; ///< 表标识
+    uint32_t version; ///< 布局版本
+    uint32_t headerBytes; ///< 表头字节数
+    uint32_t recordSize; ///< 记录字节数
+    uint32_t capacity; ///< 记录数
+    uint32_t directorySize; ///< 目录项数，2的幂
+    uint32_t nameBytes; ///< 名称区字节数
+    int32_t publisherPid; ///< 发布进程号
+    uint64_t recordsOffset; ///< 记录区偏移
+    uint64_t directoryOffset; ///< 目录区偏移
+    uint64_t namesOffset; ///< 名称区偏移
+    uint64_t totalBytes; ///< 共享内存总字节数
+    std::atomic<uint32_t> state; ///< 表的状态
+    std::atomic<uint32_t> tagCount; ///< 已发布的点位数
+    std::atomic<uint32_t> namesUsed; ///< 名称区已使用的字节数
+    uint32_t reserved; ///< 保留
+    std::atomic<uint64_t> directorySequence; ///< 目录顺序号，奇数表示目录正在修改
+};
+
+/**
+ * @struct Record
+ * @brief 点位记录
+ */
+struct Record {
+    std::atomic<uint32_t> sequence; ///< 顺序号，奇数表示正在写入
+    uint8_t type; ///< 值类型
+    uint8_t quality; ///< 质量码（OPC DA编码）
+    uint16_t textSize; ///< 字符串字节数
+    uint32_t nameOffset; ///< 名称在名称区中的偏移加1，0表示记录未使用或点位已删除
+    uint32_t reserved; ///< 保留
+    uint64_t payload; ///< 值的二进制表示，与HYTagValue的负载一致
+    int64_t sourceTimestamp; ///< 源时间戳（毫秒）
+    int64_t serverTimestamp; ///< 服务器时间戳（毫秒）
+    char text[InlineText]; ///< 字符串值的UTF-8编码
+};
+
+/**
+ * @struct Entry
+ * @brief 目录项
+ */
+struct Entry {
+    uint64_t key; ///< 名称的键
+    uint32_t index; ///< 记录下标，或EmptyEntry/RemovedEntry
+    uint32_t nameOffset; ///< 名称在名称区中的偏移
+};
+
+static_assert(sizeof(Header) <= HeaderBytes, "shared table header must fit its reserved space");
+static_assert(sizeof(Record) == 64, "shared table records must stay one cache line");
+static_assert(sizeof(Entry) == 16, "shared table directory entries must stay packed");
+static_assert(std::atomic<uint32_t>::is_always_lock_free && std::atomic<uint64_t>::is_always_lock_free,
+              "atomics shared between processes must be lock-free");
+
+/**
+ * @brief 计算点位名称的键
+ * @param utf8 名称的UTF-8编码
+ * @param size 字节数
+ * @return 64位FNV-1a散列，跨进程和跨版本稳定
+ */
+inline uint64_t nameKey(const char *utf8, size_t size)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= uint8_t(utf8[i]);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+} // namespace HYTagSharedLayout
+
+#endif // HYTAGSHAREDLAYOUT_H
@@ -0,0 +1,286 @@
+#include "tagsharedreader.h"
+#include <cstring>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define HY_SHARED_POSIX 1
+#endif
+
+/**
+ * @file tagsharedreader.cpp
+ * @brief 共享内存点位表读取库实现
+ */
+
+using namespace HYTagSharedLayout;
+
+namespace {
+
+constexpr int MaxRetries = 1 << 20; ///< 读取的最大重试次数，发布端在写入中途退出时不会无限等待
+
+} // namespace
+
+double HYTagSharedReader::Value::toDouble() const
+{
+    switch (type) {
+    case TypeBool:
+        return boolValue ? 1.0 : 0.0;
+    case TypeInt64:
+        return double(intValue);
+    case TypeDouble:
+        return doubleValue;
+    default:
+        return 0.0;
+    }
+}
+
+HYTagSharedReader::HYTagSharedReader() :
+    m_base(nullptr),
+    m_size(0),
+    m_header(nullptr),
+    m_records(nullptr),
+    m_directory(nullptr),
+    m_names(nullptr)
+{
+}
+
+HYTagSharedReader::~HYTagSharedReader()
+{
+    close();
+}
+
+bool HYTagSharedReader::open(const std::string &name)
+{
+    close();
+
+#ifdef HY_SHARED_POSIX
+    const std::string shmName = (!name.empty() && name[0] == '/') ? name : '/' + name;
+    const int fd = ::shm_open(shmName.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    if (::fstat(fd, &info) != 0 || size_t(info.st_size) < HeaderBytes) {
+        ::close(fd);
+        return false;
+    }
+    const size_t size = size_t(info.st_size);
+    void *mapped = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        return false;
+    }
+
+    // The magic is written last, so a table still being set up is rejected rather than half read
+    const unsigned char *base = static_cast<const unsigned char *>(mapped);
+    const Header *header = reinterpret_cast<const Header *>(base);
+    const bool valid = header->magic.load(std::memory_order_acquire) == Magic && header->version == Version
+        && header->recordSize == sizeof(Record) && header->totalBytes <= size
+        && header->recordsOffset + uint64_t(header->capacity) * sizeof(Record) <= header->directoryOffset
+        && header->directoryOffset + uint64_t(header->directorySize) * sizeof(Entry) <= header->namesOffset
+        && header->namesOffset + header->nameBytes <= header->totalBytes
+        && header->directorySize && (header->directorySize & (header->directorySize - 1)) == 0;
+    if (!valid) {
+        ::munmap(mapped, size);
+        return false;
+    }
+
+    m_base = base;
+    m_size = size;
+    m_header = header;
+    m_records = reinterpret_cast<const Record *>(base + header->recordsOffset);
+    m_directory = reinterpret_cast<const Entry *>(base + header->directoryOffset);
+    m_names = reinterpret_cast<const char *>(base + header->namesOffset);
+    return true;
+#else
+    (void)name;
+    return false;
+#endif
+}
+
+void HYTagSharedReader::close()
+{
+    if (!m_base) {
+        return;
+    }
+#ifdef HY_SHARED_POSIX
+    ::munmap(const_cast<unsigned char *>(m_base), m_size);
+#endif
+    m_base = nullptr;
+    m_size = 0;
+    m_header = nullptr;
+    m_records = nullptr;
+    m_directory = nullptr;
+    m_names = nullptr;
+}
+
+bool HYTagSharedReader::isOpen() const
+{
+    return m_base != nullptr;
+}
+
+bool HYTagSharedReader::isLive() const
+{
+    if (!m_base || m_header->state.load(std::memory_order_acquire) != StateOpen) {
+        return false;
+    }
+#ifdef HY_SHARED_POSIX
+    // A publisher that crashed never marks the table closed
+    return ::kill(pid_t(m_header->publisherPid), 0) == 0 || errno == EPERM;
+#else
+    return true;
+#endif
+}
+
+uint32_t HYTagSharedReader::capacity() const
+{
+    return m_header ? m_header->capacity : 0;
+}
+
+uint32_t HYTagSharedReader::tagCount() const
+{
+    return m_header ? m_header->tagCount.load(std::memory_order_relaxed) : 0;
+}
+
+int32_t HYTagSharedReader::find(const std::string &name) const
+{
+    if (!m_base) {
+        return -1;
+    }
+
+    const uint64_t key = nameKey(name.data(), name.size());
+    const uint32_t mask = m_header->directorySize - 1;
+    for (int retry = 0; retry < MaxRetries; ++retry) {
+        // Wait out a directory change in progress, then probe and check nothing moved meanwhile
+        const uint64_t before = m_header->directorySequence.load(std::memory_order_acquire);
+        if (before & 1) {
+            continue;
+        }
+
+        int32_t found = -1;
+        for (uint32_t slot = uint32_t(key) & mask, probes = 0; probes <= mask; slot = (slot + 1) & mask, ++probes) {
+            const Entry &entry = m_directory[slot];
+            const uint32_t index = entry.index;
+            if (index == EmptyEntry) {
+                break;
+            }
+            if (index == RemovedEntry || entry.key != key) {
+                continue;
+            }
+
+            // Equal keys are confirmed against the stored name
+            uint16_t size = 0;
+            const char *data = nameData(entry.nameOffset, &size);
+            if (data && size == name.size() && std::memcmp(data, name.data(), size) == 0) {
+                found = int32_t(index);
+                break;
+            }
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (m_header->directorySequence.load(std::memory_order_relaxed) == before) {
+            return found < int32_t(m_header->capacity) ? found : -1;
+        }
+    }
+    return -1;
+}
+
+std::string HYTagSharedReader::nameAt(int32_t index) const
+{
+    if (!m_base || index < 0 || uint32_t(index) >= m_header->capacity) {
+        return std::string();
+    }
+
+    // Names are only appended, so the offset alone is enough to read one safely
+    const uint32_t offset = m_records[index].nameOffset;
+    uint16_t size = 0;
+    const char *data = offset ? nameData(offset - 1, &size) : nullptr;
+    return data ? std::string(data, size) : std::string();
+}
+
+bool HYTagSharedReader::read(int32_t index, Value *value) const
+{
+    if (!m_base || index < 0 || uint32_t(index) >= m_header->capacity) {
+        return false;
+    }
+
+    const Record &record = m_records[index];
+    for (int retry = 0; retry < MaxRetries; ++retry) {
+        const uint32_t before = record.sequence.load(std::memory_order_acquire);
+        if (before & 1) {
+            continue;
+        }
+
+        const uint32_t nameOffset = record.nameOffset;
+        const uint8_t type = record.type;
+        const uint8_t quality = record.quality;
+        const uint16_t textSize = record.textSize;
+        const uint64_t payload = record.payload;
+        const int64_t sourceTimestamp = record.sourceTimestamp;
+        const int64_t serverTimestamp = record.serverTimestamp;
+        char text[InlineText];
+        if (type == TypeString) {
+            std::memcpy(text, record.text, sizeof(text));
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (record.sequence.load(std::memory_order_relaxed) != before) {
+            continue;
+        }
+        if (!nameOffset) {
+            return false;
+        }
+
+        value->type = ValueType(type);
+        value->quality = quality;
+        value->sourceTimestamp = sourceTimestamp;
+        value->serverTimestamp = serverTimestamp;
+        value->boolValue = false;
+        value->intValue = 0;
+        value->doubleValue = 0.0;
+        value->text.clear();
+        switch (type) {
+        case TypeBool:
+            value->boolValue = payload != 0;
+            break;
+        case TypeInt64:
+            value->intValue = int64_t(payload);
+            break;
+        case TypeDouble:
+            std::memcpy(&value->doubleValue, &payload, sizeof(payload));
+            break;
+        case TypeString:
+            value->text.assign(text, textSize < InlineText ? textSize : InlineText);
+            break;
+        case TypeNull:
+            break;
+        default:
+            value->type = TypeUnavailable;
+            break;
+        }
+        return true;
+    }
+    return false;
+}
+
+bool HYTagSharedReader::read(const std::string &name, Value *value) const
+{
+    const int32_t index = find(name);
+    return index >= 0 && read(index, value);
+}
+
+const char *HYTagSharedReader::nameData(uint32_t offset, uint16_t *size) const
+{
+    if (uint64_t(offset) + sizeof(uint16_t) > m_header->nameBytes) {
+        return nullptr;
+    }
+    std::memcpy(size, m_names + offset, sizeof(uint16_t));
+    if (uint64_t(offset) + sizeof(uint16_t) + *size > m_header->nameBytes) {
+        return nullptr;
+    }
+    return m_names + offset + sizeof(uint16_t);
+}
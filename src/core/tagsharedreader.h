@@ -0,0 +1,152 @@
+#ifndef HYTAGSHAREDREADER_H
+#define HYTAGSHAREDREADER_H
+
+#include <cstdint>
+#include <string>
+#include "tagsharedlayout.h"
+
+/**
+ * @file tagsharedreader.h
+ * @brief 共享内存点位表读取库头文件
+ *
+ * 只依赖标准库和POSIX接口，供运行时之外的进程链接（HYTagReader静态库）
+ */
+
+/**
+ * @class HYTagSharedReader
+ * @brief 共享内存点位表的读取端
+ *
+ * 以只读方式映射HYTagSharedTable发布的共享内存段，按名称查找记录下标后按下标无锁读取
+ * 读取从不阻塞发布端；读到正在写入的记录时重试，返回的值、时间戳和质量码总是来自同一次写入
+ * 下标在点位生命周期内不变，建议查找一次后缓存下标
+ * 同一个读取端对象可以被多个线程同时读取，open()和close()需要调用方串行化
+ */
+class HYTagSharedReader
+{
+public:
+    /**
+     * @struct Value
+     * @brief 读出的点位值
+     */
+    struct Value {
+        HYTagSharedLayout::ValueType type = HYTagSharedLayout::TypeNull; ///< 值类型
+        bool boolValue = false; ///< 布尔值
+        int64_t intValue = 0; ///< 整数值
+        double doubleValue = 0.0; ///< 浮点值
+        std::string text; ///< 字符串值（UTF-8）
+        int64_t sourceTimestamp = 0; ///< 源时间戳（毫秒）
+        int64_t serverTimestamp = 0; ///< 服务器时间戳（毫秒）
+        uint8_t quality = 0; ///< 质量码（OPC DA编码）
+
+        /**
+         * @brief 检查质量码是否为好值
+         * @return 是否为好值
+         */
+        bool isGood() const { return (quality & 0xC0) == 0xC0; }
+
+        /**
+         * @brief 转换为浮点数
+         * @return 浮点值，字符串和不可用的值为0
+         */
+        double toDouble() const;
+    };
+
+    /**
+     * @brief 构造函数
+     */
+    HYTagSharedReader();
+
+    /**
+     * @brief 析构函数，解除映射
+     */
+    ~HYTagSharedReader();
+
+    HYTagSharedReader(const HYTagSharedReader &) = delete;
+    HYTagSharedReader &operator=(const HYTagSharedReader &) = delete;
+
+    /**
+     * @brief 映射共享内存段
+     * @param name 共享内存名称，不以'/'开头时自动补上
+     * @return 是否成功；段不存在、尚未初始化完成或布局版本不兼容时失败
+     */
+    bool open(const std::string &name);
+
+    /**
+     * @brief 解除映射
+     */
+    void close();
+
+    /**
+     * @brief 检查是否已映射
+     * @return 是否已映射
+     */
+    bool isOpen() const;
+
+    /**
+     * @brief 检查发布端是否仍在更新
+     *
+     * 发布端关闭表或进程退出后返回false，此时读出的是最后的值，应重新open()
+     * @return 是否仍在更新
+     */
+    bool isLive() const;
+
+    /**
+     * @brief 获取记录数
+     * @return 记录数
+     */
+    uint32_t capacity() const;
+
+    /**
+     * @brief 获取已发布的点位数
+     * @return 点位数
+     */
+    uint32_t tagCount() const;
+
+    /**
+     * @brief 按名称查找记录下标
+     * @param name 点位名称（UTF-8）
+     * @return 记录下标，点位不存在时为-1
+     */
+    int32_t find(const std::string &name) const;
+
+    /**
+     * @brief 获取记录的点位名称
+     * @param index 记录下标
+     * @return 点位名称，记录未使用时为空
+     */
+    std::string nameAt(int32_t index) const;
+
+    /**
+     * @brief 按下标读取点位
+     * @param index 记录下标
+     * @param value 输出点位值
+     * @return 是否成功；下标无效或点位已删除时失败
+     */
+    bool read(int32_t index, Value *value) const;
+
+    /**
+     * @brief 按名称读取点位
+     * @param name 点位名称（UTF-8）
+     * @param value 输出点位值
+     * @return 是否成功
+     */
+    bool read(const std::string &name, Value *value) const;
+
+private:
+    /**
+     * @brief 读取名称区中的名称
+     * @param offset 名称在名称区中的偏移
+     * @param size 输出名称字节数
+     * @return 名称的起始地址，偏移无效时为空
+     */
+    const char *nameData(uint32_t offset, uint16_t *size) const;
+
+    const unsigned char *m_base; ///< 映射的起始地址
+    size_t m_size; ///< 映射的字节数
+    const HYTagSharedLayout::Header *m_header; ///< 表头
+    const HYTagSharedLayout::Record *m_records; ///< 记录区
+    const HYTagSharedLayout::Entry *m_directory; ///< 目录区
+    const char *m_names; ///< 名称区
+};
+
+#endif // HYTAGSHAREDREADER_H
@@ -0,0 +1,286 @@
+#include "tagsharedtable.h"
+#include <QByteArray>
+#include <cstring>
+
+#ifdef Q_OS_UNIX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @file tagsharedtable.cpp
+ * @brief 共享内存点位表实现
+ */
+
+using namespace HYTagSharedLayout;
+
+HYTagSharedTable::HYTagSharedTable() :
+    m_base(nullptr),
+    m_size(0),
+    m_header(nullptr),
+    m_records(nullptr),
+    m_directory(nullptr),
+    m_names(nullptr),
+    m_dropped(0)
+{
+}
+
+HYTagSharedTable::~HYTagSharedTable()
+{
+    close();
+}
+
+bool HYTagSharedTable::open(const QString &name, int capacity)
+{
+    close();
+    if (capacity <= 0) {
+        return false;
+    }
+
+#ifdef Q_OS_UNIX
+    const QString shmName = name.startsWith(QLatin1Char('/')) ? name : QLatin1Char('/') + name;
+    const QByteArray encodedName = shmName.toUtf8();
+
+    // The directory stays at most half full, so probe chains stay short
+    quint32 directorySize = 16;
+    while (directorySize < quint32(capacity) * 2) {
+        directorySize <<= 1;
+    }
+    const quint64 recordsOffset = HeaderBytes;
+    const quint64 directoryOffset = recordsOffset + quint64(capacity) * sizeof(Record);
+    const quint64 namesOffset = directoryOffset + quint64(directorySize) * sizeof(Entry);
+    const quint64 nameBytes = quint64(capacity) * NameBytesPerTag;
+    const quint64 totalBytes = namesOffset + nameBytes;
+    if (nameBytes > 0xFFFFFFF0ull) {
+        return false;
+    }
+
+    // A segment left by a crashed run is replaced; readers still mapping it keep their copy
+    ::shm_unlink(encodedName.constData());
+    const int fd = ::shm_open(encodedName.constData(), O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    if (::ftruncate(fd, off_t(totalBytes)) != 0) {
+        ::close(fd);
+        ::shm_unlink(encodedName.constData());
+        return false;
+    }
+    void *mapped = ::mmap(nullptr, size_t(totalBytes), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) {
+        ::shm_unlink(encodedName.constData());
+        return false;
+    }
+
+    // The new segment reads back as zero: every record unused, every directory entry filled in below
+    m_name = shmName;
+    m_base = static_cast<uchar *>(mapped);
+    m_size = qint64(totalBytes);
+    m_header = reinterpret_cast<Header *>(m_base);
+    m_records = reinterpret_cast<Record *>(m_base + recordsOffset);
+    m_directory = reinterpret_cast<Entry *>(m_base + directoryOffset);
+    m_names = reinterpret_cast<char *>(m_base + namesOffset);
+    for (quint32 i = 0; i < directorySize; ++i) {
+        m_directory[i].index = EmptyEntry;
+    }
+
+    m_header->version = Version;
+    m_header->headerBytes = HeaderBytes;
+    m_header->recordSize = sizeof(Record);
+    m_header->capacity = quint32(capacity);
+    m_header->directorySize = directorySize;
+    m_header->nameBytes = quint32(nameBytes);
+    m_header->publisherPid = qint32(::getpid());
+    m_header->recordsOffset = recordsOffset;
+    m_header->directoryOffset = directoryOffset;
+    m_header->namesOffset = namesOffset;
+    m_header->totalBytes = totalBytes;
+    m_header->state.store(StateOpen, std::memory_order_relaxed);
+
+    // Readers accept the table only once the magic is visible, which is after everything above
+    m_header->magic.store(Magic, std::memory_order_release);
+    return true;
+#else
+    Q_UNUSED(name);
+    return false;
+#endif
+}
+
+void HYTagSharedTable::close()
+{
+    if (!m_base) {
+        return;
+    }
+
+#ifdef Q_OS_UNIX
+    m_header->state.store(StateClosed, std::memory_order_release);
+    ::munmap(m_base, size_t(m_size));
+    ::shm_unlink(m_name.toUtf8().constData());
+#endif
+    m_name.clear();
+    m_base = nullptr;
+    m_size = 0;
+    m_header = nullptr;
+    m_records = nullptr;
+    m_directory = nullptr;
+    m_names = nullptr;
+}
+
+bool HYTagSharedTable::isOpen() const
+{
+    return m_base != nullptr;
+}
+
+QString HYTagSharedTable::name() const
+{
+    return m_name;
+}
+
+int HYTagSharedTable::capacity() const
+{
+    return m_header ? int(m_header->capacity) : 0;
+}
+
+bool HYTagSharedTable::publish(HYTagId id, const QString &name)
+{
+    if (!m_base) {
+        return false;
+    }
+    Record *record = recordAt(id);
+    const QByteArray utf8 = name.toUtf8();
+    const quint32 used = m_header->namesUsed.load(std::memory_order_relaxed);
+    const quint64 needed = sizeof(quint16) + quint64(utf8.size());
+    if (!record || utf8.size() > 0xFFFF || used + needed > m_header->nameBytes) {
+        ++m_dropped;
+        return false;
+    }
+
+    // Names are only appended, so an offset handed to a reader never goes stale
+    const quint16 length = quint16(utf8.size());
+    std::memcpy(m_names + used, &length, sizeof(length));
+    std::memcpy(m_names + used + sizeof(length), utf8.constData(), size_t(utf8.size()));
+    m_header->namesUsed.store(used + quint32(needed), std::memory_order_relaxed);
+
+    const quint64 key = nameKey(utf8.constData(), size_t(utf8.size()));
+    const quint32 mask = m_header->directorySize - 1;
+    quint32 slot = quint32(key) & mask;
+    while (m_directory[slot].index != EmptyEntry && m_directory[slot].index != RemovedEntry) {
+        slot = (slot + 1) & mask;
+    }
+
+    // Readers probing the directory retry while its sequence number is odd or has moved
+    const quint64 sequence = m_header->directorySequence.load(std::memory_order_relaxed);
+    m_header->directorySequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    m_directory[slot].key = key;
+    m_directory[slot].nameOffset = used;
+    m_directory[slot].index = quint32(id);
+    m_header->directorySequence.store(sequence + 2, std::memory_order_release);
+
+    // The record starts empty until write() fills in the value
+    const quint32 recordSequence = record->sequence.load(std::memory_order_relaxed);
+    record->sequence.store(recordSequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    record->type = TypeNull;
+    record->quality = 0;
+    record->nameOffset = used + 1;
+    record->sourceTimestamp = 0;
+    record->serverTimestamp = 0;
+    record->sequence.store(recordSequence + 2, std::memory_order_release);
+
+    m_header->tagCount.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void HYTagSharedTable::unpublish(HYTagId id)
+{
+    Record *record = recordAt(id);
+    if (!record || !record->nameOffset) {
+        return;
+    }
+
+    quint16 length = 0;
+    const char *name = m_names + record->nameOffset - 1;
+    std::memcpy(&length, name, sizeof(length));
+    Entry *entry = findEntry(nameKey(name + sizeof(length), length), id);
+
+    const quint64 sequence = m_header->directorySequence.load(std::memory_order_relaxed);
+    m_header->directorySequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    if (entry) {
+        // The entry keeps its place so probe chains running through it stay intact
+        entry->index = RemovedEntry;
+    }
+    m_header->directorySequence.store(sequence + 2, std::memory_order_release);
+
+    // Readers holding the index see the record as removed from now on
+    const quint32 recordSequence = record->sequence.load(std::memory_order_relaxed);
+    record->sequence.store(recordSequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    record->nameOffset = 0;
+    record->sequence.store(recordSequence + 2, std::memory_order_release);
+
+    m_header->tagCount.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void HYTagSharedTable::write(HYTagId id, const HYTagRecord &record, bool complex)
+{
+    Record *slot = recordAt(id);
+    if (!slot || !slot->nameOffset) {
+        return;
+    }
+
+    // Strings that do not fit and complex values publish only their quality and timestamps
+    quint8 type = complex ? quint8(TypeUnavailable) : quint8(record.value.type());
+    QByteArray text;
+    if (type == TypeString) {
+        text = record.value.toString().toUtf8();
+        if (text.size() > InlineText) {
+            type = TypeUnavailable;
+        }
+    }
+
+    const quint32 sequence = slot->sequence.load(std::memory_order_relaxed);
+    slot->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot->type = type;
+    slot->quality = record.quality;
+    slot->payload = record.value.bits();
+    slot->sourceTimestamp = record.sourceTimestamp;
+    slot->serverTimestamp = record.serverTimestamp;
+    if (type == TypeString) {
+        slot->textSize = quint16(text.size());
+        std::memcpy(slot->text, text.constData(), size_t(text.size()));
+    }
+    slot->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+int HYTagSharedTable::droppedCount() const
+{
+    return m_dropped;
+}
+
+Record *HYTagSharedTable::recordAt(HYTagId id) const
+{
+    if (!m_base || id < 0 || quint32(id) >= m_header->capacity) {
+        return nullptr;
+    }
+    return m_records + id;
+}
+
+Entry *HYTagSharedTable::findEntry(quint64 key, HYTagId id) const
+{
+    const quint32 mask = m_header->directorySize - 1;
+    for (quint32 slot = quint32(key) & mask, probes = 0; probes <= mask; slot = (slot + 1) & mask, ++probes) {
+        if (m_directory[slot].index == EmptyEntry) {
+            break;
+        }
+        if (m_directory[slot].index == quint32(id)) {
+            return &m_directory[slot];
+        }
+    }
+    return nullptr;
+}
@@ -0,0 +1,134 @@
+#ifndef HYTAGSHAREDTABLE_H
+#define HYTAGSHAREDTABLE_H
+
+#include <QString>
+#include <QtGlobal>
+#include "tagsharedlayout.h"
+#include "tagvaluestore.h"
+
+/**
+ * @file tagsharedtable.h
+ * @brief 共享内存点位表头文件
+ */
+
+/**
+ * @class HYTagSharedTable
+ * @brief 共享内存点位表的发布端
+ *
+ * 把点位值存储发布到POSIX共享内存段，运行时之外的进程（设计器预览、报表工具等）
+ * 通过HYTagSharedReader直接读取当前值，不经过进程间通信，也不需要自己的驱动连接
+ * 记录下标即点位句柄，句柄不小于容量的点位不发布；句柄不复用，读取端缓存的下标始终有效
+ * 读取端按顺序号无锁读取，从不阻塞发布端
+ *
+ * 线程安全约定与HYTagSnapshot一致：写某条记录的调用方持有该点位所在分片的锁，
+ * 打开、关闭、发布和撤销点位由调用方串行化
+ */
+class HYTagSharedTable
+{
+public:
+    static constexpr int DefaultCapacity = 65536; ///< 默认记录数
+    static constexpr int NameBytesPerTag = 48; ///< 每个点位预留的名称区字节数
+
+    /**
+     * @brief 构造函数
+     */
+    HYTagSharedTable();
+
+    /**
+     * @brief 析构函数，关闭共享内存
+     */
+    ~HYTagSharedTable();
+
+    HYTagSharedTable(const HYTagSharedTable &) = delete;
+    HYTagSharedTable &operator=(const HYTagSharedTable &) = delete;
+
+    /**
+     * @brief 创建并映射共享内存段
+     *
+     * 同名的旧段（例如上次运行崩溃后遗留的）先被删除，仍映射着它的读取端会看到发布进程已退出
+     * @param name 共享内存名称，不以'/'开头时自动补上
+     * @param capacity 记录数，即可发布的最大点位句柄加1
+     * @return 是否成功，非POSIX平台总是失败
+     */
+    bool open(const QString &name, int capacity = DefaultCapacity);
+
+    /**
+     * @brief 标记表已关闭，解除映射并删除共享内存名称
+     *
+     * 已映射的读取端仍可读出最后的值
+     */
+    void close();
+
+    /**
+     * @brief 检查表是否已打开
+     * @return 是否已打开
+     */
+    bool isOpen() const;
+
+    /**
+     * @brief 获取共享内存名称
+     * @return 名称，未打开时为空
+     */
+    QString name() const;
+
+    /**
+     * @brief 获取记录数
+     * @return 记录数
+     */
+    int capacity() const;
+
+    /**
+     * @brief 发布点位，加入目录
+     * @param id 点位句柄
+     * @param name 点位名称
+     * @return 是否成功；句柄超出容量或名称区已满时失败
+     */
+    bool publish(HYTagId id, const QString &name);
+
+    /**
+     * @brief 撤销点位，从目录中移除
+     * @param id 点位句柄
+     */
+    void unpublish(HYTagId id);
+
+    /**
+     * @brief 写入点位的当前记录
+     * @param id 点位句柄
+     * @param record 点位记录
+     * @param complex 值是否为无法在记录中表示的其他值
+     */
+    void write(HYTagId id, const HYTagRecord &record, bool complex);
+
+    /**
+     * @brief 获取因超出容量或名称区已满而未发布的点位数
+     * @return 累计点位数
+     */
+    int droppedCount() const;
+
+private:
+    /**
+     * @brief 获取记录
+     * @param id 点位句柄
+     * @return 记录，句柄超出容量或表未打开时为空
+     */
+    HYTagSharedLayout::Record *recordAt(HYTagId id) const;
+
+    /**
+     * @brief 在目录中查找点位的目录项
+     * @param key 名称的键
+     * @param id 点位句柄
+     * @return 目录项，不存在时为空
+     */
+    HYTagSharedLayout::Entry *findEntry(quint64 key, HYTagId id) const;
+
+    QString m_name; ///< 共享内存名称
+    uchar *m_base; ///< 映射的起始地址
+    qint64 m_size; ///< 映射的字节数
+    HYTagSharedLayout::Header *m_header; ///< 表头
+    HYTagSharedLayout::Record *m_records; ///< 记录区
+    HYTagSharedLayout::Entry *m_directory; ///< 目录区
+    char *m_names; ///< 名称区
+    int m_dropped; ///< 未发布的点位数
+};
+
+#endif // HYTAGSHAREDTABLE_H
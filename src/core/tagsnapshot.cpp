@@ -0,0 +1,232 @@
+#include "tagsnapshot.h"
+#include <atomic>
+#include <cstring>
+
+/**
+ * @file tagsnapshot.cpp
+ * @brief 内存映射的点位值快照实现
+ *
+ * 段文件：4096字节的文件头（标识、版本、记录大小、段下标），随后是SegmentSize条记录
+ * 文件头之后的区域按页对齐，可整体映射
+ */
+
+namespace {
+
+const char SnapshotMagic[] = "HYVS"; ///< 段文件标识
+constexpr quint32 SnapshotVersion = 1; ///< 文件格式版本
+constexpr qint64 HeaderBytes = 4096; ///< 文件头字节数
+
+/**
+ * @struct SegmentHeader
+ * @brief 段文件头
+ */
+struct SegmentHeader {
+    char magic[4]; ///< 文件标识
+    quint32 version; ///< 文件格式版本
+    quint32 recordSize; ///< 记录字节数
+    quint32 segment; ///< 段下标
+};
+
+} // namespace
+
+HYTagSnapshot::HYTagSnapshot() :
+    m_segments(new Record *[MaxSegments]()),
+    m_open(false)
+{
+}
+
+HYTagSnapshot::~HYTagSnapshot()
+{
+    close();
+}
+
+bool HYTagSnapshot::open(const QString &path)
+{
+    close();
+    m_path = path;
+    m_files.resize(MaxSegments);
+    m_open = true;
+
+    // Map every segment left by the previous run and keep the complete records as last-known values
+    for (int segment = 0; segment < MaxSegments && QFile::exists(QStringLiteral("%1.%2").arg(m_path).arg(segment));
+         ++segment) {
+        if (!mapSegment(segment)) {
+            continue;
+        }
+        const Record *records = m_segments[segment];
+        for (int i = 0; i < SegmentSize; ++i) {
+            const Record &record = records[i];
+
+            // A record caught mid-write by a crash has an odd sequence number
+            if (!record.key || (record.sequence & 1) || record.type == Unsaved) {
+                continue;
+            }
+            HYTagRecord lastKnown;
+            if (record.type == HYTagValue::String) {
+                const int size = qMin(int(record.textSize), InlineText);
+                lastKnown.value = HYTagValue::fromString(QString::fromUtf8(record.text, size));
+            } else if (record.type <= HYTagValue::Double) {
+                lastKnown.value = HYTagValue::fromRaw(HYTagValue::Type(record.type), record.payload);
+            } else {
+                continue;
+            }
+            lastKnown.sourceTimestamp = record.sourceTimestamp;
+            lastKnown.serverTimestamp = record.serverTimestamp;
+            lastKnown.quality = record.quality;
+            m_lastKnown.insert(record.key, lastKnown);
+        }
+    }
+    return true;
+}
+
+void HYTagSnapshot::close()
+{
+    // Destroying the file objects removes their mappings; the mapped contents stay in the files
+    for (QFile *file : std::as_const(m_files)) {
+        delete file;
+    }
+    m_files.clear();
+    for (int i = 0; i < MaxSegments; ++i) {
+        m_segments[i] = nullptr;
+    }
+    m_lastKnown.clear();
+    m_open = false;
+}
+
+bool HYTagSnapshot::isOpen() const
+{
+    return m_open;
+}
+
+quint64 HYTagSnapshot::nameKey(const QString &name)
+{
+    quint64 hash = 14695981039346656037ull;
+    for (QChar c : name) {
+        hash ^= c.unicode();
+        hash *= 1099511628211ull;
+    }
+
+    // 0 marks an empty record
+    return hash ? hash : 1;
+}
+
+bool HYTagSnapshot::assign(HYTagId id, quint64 key)
+{
+    if (!m_open || id < 0) {
+        return false;
+    }
+    const int segment = id >> SegmentShift;
+    if (segment >= MaxSegments || (!m_segments[segment] && !mapSegment(segment))) {
+        return false;
+    }
+
+    Record *record = recordAt(id);
+    record->sequence += 1;
+    std::atomic_thread_fence(std::memory_order_release);
+    record->type = Unsaved;
+    record->key = key;
+    std::atomic_thread_fence(std::memory_order_release);
+    record->sequence += 1;
+    return true;
+}
+
+void HYTagSnapshot::erase(HYTagId id)
+{
+    if (Record *record = recordAt(id)) {
+        record->key = 0;
+    }
+}
+
+void HYTagSnapshot::write(HYTagId id, const HYTagRecord &record, bool complex)
+{
+    Record *slot = recordAt(id);
+    if (!slot || !slot->key) {
+        return;
+    }
+
+    // Strings that do not fit and complex values keep only their quality and timestamps
+    quint8 type = complex ? Unsaved : quint8(record.value.type());
+    QByteArray text;
+    if (type == HYTagValue::String) {
+        text = record.value.toString().toUtf8();
+        if (text.size() > InlineText) {
+            type = Unsaved;
+        }
+    }
+
+    // Odd while the fields change, so a reader after a crash can tell a torn record
+    slot->sequence += 1;
+    std::atomic_thread_fence(std::memory_order_release);
+    slot->type = type;
+    slot->quality = record.quality;
+    slot->payload = record.value.bits();
+    slot->sourceTimestamp = record.sourceTimestamp;
+    slot->serverTimestamp = record.serverTimestamp;
+    if (type == HYTagValue::String) {
+        slot->textSize = quint16(text.size());
+        std::memcpy(slot->text, text.constData(), size_t(text.size()));
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+    slot->sequence += 1;
+}
+
+bool HYTagSnapshot::takeLastKnown(quint64 key, HYTagRecord *record)
+{
+    auto it = m_lastKnown.find(key);
+    if (it == m_lastKnown.end()) {
+        return false;
+    }
+    *record = it.value();
+    m_lastKnown.erase(it);
+    return true;
+}
+
+int HYTagSnapshot::lastKnownCount() const
+{
+    return int(m_lastKnown.size());
+}
+
+HYTagSnapshot::Record *HYTagSnapshot::recordAt(HYTagId id) const
+{
+    if (!m_open || id < 0 || (id >> SegmentShift) >= MaxSegments) {
+        return nullptr;
+    }
+    Record *records = m_segments[id >> SegmentShift];
+    return records ? records + (id & (SegmentSize - 1)) : nullptr;
+}
+
+bool HYTagSnapshot::mapSegment(int segment)
+{
+    const qint64 fileSize = HeaderBytes + qint64(SegmentSize) * qint64(sizeof(Record));
+    auto file = std::make_unique<QFile>(QStringLiteral("%1.%2").arg(m_path).arg(segment));
+    if (!file->open(QIODevice::ReadWrite)) {
+        return false;
+    }
+
+    // A segment with a foreign or damaged header is started over
+    SegmentHeader header = {};
+    const bool valid = file->size() == fileSize
+        && file->read(reinterpret_cast<char *>(&header), sizeof(header)) == qint64(sizeof(header))
+        && std::memcmp(header.magic, SnapshotMagic, 4) == 0 && header.version == SnapshotVersion
+        && header.recordSize == sizeof(Record) && header.segment == quint32(segment);
+    if (!valid) {
+        // The file is extended sparsely; untouched records read back as zero, which is an empty record
+        std::memcpy(header.magic, SnapshotMagic, 4);
+        header.version = SnapshotVersion;
+        header.recordSize = sizeof(Record);
+        header.segment = quint32(segment);
+        if (!file->resize(0) || !file->resize(fileSize) || !file->seek(0)
+            || file->write(reinterpret_cast<const char *>(&header), sizeof(header)) != qint64(sizeof(header))
+            || !file->flush()) {
+            return false;
+        }
+    }
+
+    uchar *mapped = file->map(HeaderBytes, fileSize - HeaderBytes);
+    if (!mapped) {
+        return false;
+    }
+    m_segments[segment] = reinterpret_cast<Record *>(mapped);
+    m_files[segment] = file.release();
+    return true;
+}
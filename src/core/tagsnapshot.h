@@ -0,0 +1,160 @@
+#ifndef HYTAGSNAPSHOT_H
+#define HYTAGSNAPSHOT_H
+
+#include <QString>
+#include <QHash>
+#include <QVector>
+#include <QFile>
+#include <QtGlobal>
+#include <memory>
+#include "tagvaluestore.h"
+
+/**
+ * @file tagsnapshot.h
+ * @brief 内存映射的点位值快照头文件
+ */
+
+/**
+ * @class HYTagSnapshot
+ * @brief 内存映射的点位值快照
+ *
+ * 每个点位在文件中占一条64字节的定长记录，下标即点位句柄，值变化时就地更新，不经过系统调用
+ * 文件按段划分，每段容纳SegmentSize个点位、单独映射，新增段不会移动已有的映射
+ * 进程退出或崩溃后映射的内容仍在文件中；下次打开时按点位名称取回最后的值，供重启后立即显示
+ * 断电时的持久性由HYTagJournal负责，此处不做fsync
+ *
+ * 线程安全约定与点位值存储一致：写某条记录的调用方持有该点位所在分片的锁，
+ * 打开、关闭、映射新段和取回最后的值由调用方串行化
+ */
+class HYTagSnapshot
+{
+public:
+    static constexpr int SegmentShift = 16; ///< 每段点位数的位数
+    static constexpr int SegmentSize = 1 << SegmentShift; ///< 每段点位数
+    static constexpr int MaxSegments = 256; ///< 最大段数，与点位值存储的容量一致
+    static constexpr int InlineText = 24; ///< 记录内可保存的字符串字节数，更长的字符串不保存
+
+    /**
+     * @brief 构造函数
+     */
+    HYTagSnapshot();
+
+    /**
+     * @brief 析构函数
+     */
+    ~HYTagSnapshot();
+
+    HYTagSnapshot(const HYTagSnapshot &) = delete;
+    HYTagSnapshot &operator=(const HYTagSnapshot &) = delete;
+
+    /**
+     * @brief 打开快照
+     *
+     * 映射已有的段，并把其中完整的记录读出作为最后的值
+     * @param path 文件路径前缀，第N段为path.N
+     * @return 是否成功
+     */
+    bool open(const QString &path);
+
+    /**
+     * @brief 关闭快照，解除映射
+     */
+    void close();
+
+    /**
+     * @brief 检查快照是否已打开
+     * @return 是否已打开
+     */
+    bool isOpen() const;
+
+    /**
+     * @brief 计算点位名称的键
+     * @param name 点位名称
+     * @return 64位FNV-1a散列，跨进程和跨版本稳定
+     */
+    static quint64 nameKey(const QString &name);
+
+    /**
+     * @brief 为点位分配记录
+     *
+     * 必要时创建并映射新段；记录的值清空，之后由write()写入
+     * @param id 点位句柄
+     * @param key 点位名称的键
+     * @return 是否成功
+     */
+    bool assign(HYTagId id, quint64 key);
+
+    /**
+     * @brief 清除点位的记录
+     * @param id 点位句柄
+     */
+    void erase(HYTagId id);
+
+    /**
+     * @brief 写入点位的当前记录
+     * @param id 点位句柄
+     * @param record 点位记录
+     * @param complex 值是否为无法就地保存的其他值
+     */
+    void write(HYTagId id, const HYTagRecord &record, bool complex);
+
+    /**
+     * @brief 取回点位在上次运行中最后的值
+     *
+     * 每个点位只能取回一次
+     * @param key 点位名称的键
+     * @param record 输出记录
+     * @return 是否有可用的值
+     */
+    bool takeLastKnown(quint64 key, HYTagRecord *record);
+
+    /**
+     * @brief 获取尚未取回的最后的值的数量
+     * @return 数量
+     */
+    int lastKnownCount() const;
+
+private:
+    /**
+     * @struct Record
+     * @brief 定长记录
+     */
+    struct Record {
+        quint32 sequence; ///< 序号，奇数表示正在写入
+        quint8 type; ///< 值类型，Unsaved表示值未保存
+        quint8 quality; ///< 质量码
+        quint16 textSize; ///< 字符串字节数
+        quint64 key; ///< 点位名称的键，0表示空记录
+        quint64 payload; ///< 值的二进制表示
+        qint64 sourceTimestamp; ///< 源时间戳（毫秒）
+        qint64 serverTimestamp; ///< 服务器时间戳（毫秒）
+        char text[InlineText]; ///< 字符串值的UTF-8编码
+    };
+    static_assert(sizeof(Record) == 64, "snapshot records must stay one cache line");
+
+    static constexpr quint8 Unsaved = 0xFF; ///< 值未保存的类型标记
+
+    /**
+     * @brief 获取记录
+     * @param id 点位句柄
+     * @return 记录，所在段未映射时为空
+     */
+    Record *recordAt(HYTagId id) const;
+
+    /**
+     * @brief 打开或创建一段并映射
+     *
+     * 文件头无效的段被清空重建
+     * @param segment 段下标
+     * @return 是否成功
+     */
+    bool mapSegment(int segment);
+
+    QString m_path; ///< 文件路径前缀
+    std::unique_ptr<Record *[]> m_segments; ///< 各段映射的起始记录
+    QVector<QFile *> m_files; ///< 各段文件，映射在文件对象销毁时解除
+    QHash<quint64, HYTagRecord> m_lastKnown; ///< 上次运行中最后的值
+    bool m_open; ///< 是否已打开
+};
+
+#endif // HYTAGSNAPSHOT_H
@@ -0,0 +1,193 @@
+#include "tagtrie.h"
+#include <algorithm>
+
+/**
+ * @file tagtrie.cpp
+ * @brief 点位命名空间前缀树实现
+ */
+
+namespace {
+
+const QString SingleLevel = QStringLiteral("*"); ///< 匹配一级的通配符
+const QString MultiLevel = QStringLiteral("**"); ///< 匹配零级或多级的通配符
+
+} // namespace
+
+HYTagTrie::HYTagTrie()
+{
+}
+
+HYTagTrie::~HYTagTrie()
+{
+    destroy(&m_root);
+}
+
+bool HYTagTrie::isValidPattern(const QString &pattern)
+{
+    if (pattern.isEmpty()) {
+        return false;
+    }
+    const QStringList path = pattern.split(Separator);
+    for (const QString &segment : path) {
+        if (segment.isEmpty()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void HYTagTrie::insert(const QString &name, HYTagId id)
+{
+    findOrCreate(name.split(Separator))->id = id;
+}
+
+void HYTagTrie::remove(const QString &name)
+{
+    const QStringList path = name.split(Separator);
+    Node *node = &m_root;
+    for (const QString &segment : path) {
+        node = node->children.value(segment, nullptr);
+        if (!node) {
+            return;
+        }
+    }
+    node->id = HYInvalidTagId;
+    prune(path);
+}
+
+int HYTagTrie::match(const QString &pattern, QVector<HYTagId> *ids) const
+{
+    ids->resize(0);
+    collect(&m_root, pattern.split(Separator), 0, ids);
+
+    // Consecutive multi-level wildcards can reach the same node along several paths
+    std::sort(ids->begin(), ids->end());
+    ids->erase(std::unique(ids->begin(), ids->end()), ids->end());
+    return int(ids->size());
+}
+
+void HYTagTrie::insertPattern(const QString &pattern, quint64 bits)
+{
+    findOrCreate(pattern.split(Separator))->bits |= bits;
+}
+
+void HYTagTrie::removePattern(const QString &pattern, quint64 bits)
+{
+    const QStringList path = pattern.split(Separator);
+    Node *node = &m_root;
+    for (const QString &segment : path) {
+        node = node->children.value(segment, nullptr);
+        if (!node) {
+            return;
+        }
+    }
+    node->bits &= ~bits;
+    prune(path);
+}
+
+quint64 HYTagTrie::matchPatterns(const QString &name) const
+{
+    return collectBits(&m_root, name.split(Separator), 0);
+}
+
+void HYTagTrie::clear()
+{
+    destroy(&m_root);
+    m_root.id = HYInvalidTagId;
+    m_root.bits = 0;
+}
+
+HYTagTrie::Node *HYTagTrie::findOrCreate(const QStringList &path)
+{
+    Node *node = &m_root;
+    for (const QString &segment : path) {
+        Node *&child = node->children[segment];
+        if (!child) {
+            child = new Node;
+        }
+        node = child;
+    }
+    return node;
+}
+
+void HYTagTrie::prune(const QStringList &path)
+{
+    // Walk down recording the chain, then drop empty nodes from the leaf upwards
+    QVector<Node *> chain;
+    chain.reserve(path.size() + 1);
+    chain.append(&m_root);
+    for (const QString &segment : path) {
+        Node *child = chain.last()->children.value(segment, nullptr);
+        if (!child) {
+            return;
+        }
+        chain.append(child);
+    }
+
+    for (int i = int(path.size()); i > 0; --i) {
+        Node *node = chain[i];
+        if (!node->children.isEmpty() || node->id != HYInvalidTagId || node->bits) {
+            break;
+        }
+        chain[i - 1]->children.remove(path[i - 1]);
+        delete node;
+    }
+}
+
+void HYTagTrie::collect(const Node *node, const QStringList &pattern, int index, QVector<HYTagId> *ids)
+{
+    if (index == pattern.size()) {
+        if (node->id != HYInvalidTagId) {
+            ids->append(node->id);
+        }
+        return;
+    }
+
+    const QString &segment = pattern[index];
+    if (segment == MultiLevel) {
+        // Match zero levels here, or consume one level and stay on the wildcard
+        collect(node, pattern, index + 1, ids);
+        for (auto it = node->children.constBegin(); it != node->children.constEnd(); ++it) {
+            collect(it.value(), pattern, index, ids);
+        }
+    } else if (segment == SingleLevel) {
+        for (auto it = node->children.constBegin(); it != node->children.constEnd(); ++it) {
+            collect(it.value(), pattern, index + 1, ids);
+        }
+    } else if (const Node *child = node->children.value(segment, nullptr)) {
+        collect(child, pattern, index + 1, ids);
+    }
+}
+
+quint64 HYTagTrie::collectBits(const Node *node, const QStringList &name, int index)
+{
+    quint64 bits = 0;
+
+    // A multi-level wildcard may swallow any number of the remaining levels, including none
+    if (const Node *multi = node->children.value(MultiLevel, nullptr)) {
+        for (int i = index; i <= name.size(); ++i) {
+            bits |= collectBits(multi, name, i);
+        }
+    }
+
+    if (index == name.size()) {
+        return bits | node->bits;
+    }
+
+    if (const Node *single = node->children.value(SingleLevel, nullptr)) {
+        bits |= collectBits(single, name, index + 1);
+    }
+    if (const Node *literal = node->children.value(name[index], nullptr)) {
+        bits |= collectBits(literal, name, index + 1);
+    }
+    return bits;
+}
+
+void HYTagTrie::destroy(Node *node)
+{
+    for (Node *child : std::as_const(node->children)) {
+        destroy(child);
+        delete child;
+    }
+    node->children.clear();
+}
@@ -0,0 +1,151 @@
+#ifndef HYTAGTRIE_H
+#define HYTAGTRIE_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QHash>
+#include <QtGlobal>
+#include "tagvaluestore.h"
+
+/**
+ * @file tagtrie.h
+ * @brief 点位命名空间前缀树头文件
+ *
+ * 点位名称按'.'分为层级，例如plant.bf1.zone1.temperature
+ * 模式中的"*"匹配恰好一级，"**"匹配零级或多级，其余段按字面匹配
+ */
+
+/**
+ * @class HYTagTrie
+ * @brief 点位命名空间前缀树
+ *
+ * 同一结构有两种用法：按点位名称存放句柄，用模式查找匹配的点位；
+ * 按订阅模式存放订阅者位掩码，用点位名称查找匹配的订阅者
+ * 查找代价取决于命中的分支，与树中的条目总数无关
+ * 非线程安全，由调用方加锁
+ */
+class HYTagTrie
+{
+public:
+    static constexpr QChar Separator = QLatin1Char('.'); ///< 层级分隔符
+
+    /**
+     * @brief 构造函数
+     */
+    HYTagTrie();
+
+    /**
+     * @brief 析构函数
+     */
+    ~HYTagTrie();
+
+    HYTagTrie(const HYTagTrie &) = delete;
+    HYTagTrie &operator=(const HYTagTrie &) = delete;
+
+    /**
+     * @brief 检查模式是否有效
+     * @param pattern 模式
+     * @return 非空且不含空层级时为true
+     */
+    static bool isValidPattern(const QString &pattern);
+
+    /**
+     * @brief 插入点位名称
+     * @param name 点位名称
+     * @param id 点位句柄
+     */
+    void insert(const QString &name, HYTagId id);
+
+    /**
+     * @brief 移除点位名称
+     * @param name 点位名称
+     */
+    void remove(const QString &name);
+
+    /**
+     * @brief 查找与模式匹配的点位
+     * @param pattern 模式
+     * @param ids 输出按升序排列的点位句柄，原有内容被清空
+     * @return 匹配的点位数
+     */
+    int match(const QString &pattern, QVector<HYTagId> *ids) const;
+
+    /**
+     * @brief 插入订阅模式
+     * @param pattern 模式
+     * @param bits 订阅者位掩码，与该模式已有的位合并
+     */
+    void insertPattern(const QString &pattern, quint64 bits);
+
+    /**
+     * @brief 移除订阅模式上的订阅者
+     * @param pattern 模式
+     * @param bits 订阅者位掩码
+     */
+    void removePattern(const QString &pattern, quint64 bits);
+
+    /**
+     * @brief 查找与点位名称匹配的订阅者
+     * @param name 点位名称
+     * @return 所有匹配模式的订阅者位掩码之并
+     */
+    quint64 matchPatterns(const QString &name) const;
+
+    /**
+     * @brief 清空
+     */
+    void clear();
+
+private:
+    /**
+     * @struct Node
+     * @brief 前缀树节点，对应一级名称
+     */
+    struct Node {
+        QHash<QString, Node *> children; ///< 下一级节点
+        HYTagId id = HYInvalidTagId; ///< 以此节点结尾的点位句柄
+        quint64 bits = 0; ///< 以此节点结尾的模式的订阅者位掩码
+    };
+
+    /**
+     * @brief 按层级查找节点，必要时创建
+     * @param path 层级列表
+     * @return 节点
+     */
+    Node *findOrCreate(const QStringList &path);
+
+    /**
+     * @brief 删除不再承载条目的节点
+     * @param path 层级列表
+     */
+    void prune(const QStringList &path);
+
+    /**
+     * @brief 递归收集与模式匹配的点位
+     * @param node 当前节点
+     * @param pattern 模式层级列表
+     * @param index 当前层级
+     * @param ids 输出点位句柄
+     */
+    static void collect(const Node *node, const QStringList &pattern, int index, QVector<HYTagId> *ids);
+
+    /**
+     * @brief 递归收集与名称匹配的订阅者
+     * @param node 当前节点
+     * @param name 名称层级列表
+     * @param index 当前层级
+     * @return 订阅者位掩码
+     */
+    static quint64 collectBits(const Node *node, const QStringList &name, int index);
+
+    /**
+     * @brief 递归释放子节点
+     * @param node 节点
+     */
+    static void destroy(Node *node);
+
+    Node m_root; ///< 根节点
+};
+
+#endif // HYTAGTRIE_H
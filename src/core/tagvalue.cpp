@@ -0,0 +1,230 @@
+#include "tagvalue.h"
+#include <QLocale>
+#include <limits>
+
+/**
+ * @file tagvalue.cpp
+ * @brief 点位类型化值实现
+ *
+ * 字符串池按块分配，块一经分配不会移动，因此已发布的字符串可以无锁读取
+ */
+
+HYStringPool *HYStringPool::instance()
+{
+    static HYStringPool pool;
+    return &pool;
+}
+
+HYStringPool::HYStringPool() :
+    m_chunks(new std::atomic<QString *>[MaxChunks]),
+    m_size(0)
+{
+    for (int i = 0; i < MaxChunks; ++i) {
+        m_chunks[i].store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+HYStringPool::~HYStringPool()
+{
+    for (int i = 0; i < MaxChunks; ++i) {
+        delete[] m_chunks[i].load(std::memory_order_relaxed);
+    }
+}
+
+bool HYStringPool::intern(const QString &text, quint32 *id)
+{
+    // Free text would grow the pool without bound; the caller keeps it as a complex value
+    if (text.size() > MaxLength) {
+        return false;
+    }
+
+    {
+        QReadLocker locker(&m_lock);
+        auto it = m_ids.constFind(text);
+        if (it != m_ids.constEnd()) {
+            *id = it.value();
+            return true;
+        }
+    }
+
+    QWriteLocker locker(&m_lock);
+    auto it = m_ids.constFind(text);
+    if (it != m_ids.constEnd()) {
+        *id = it.value();
+        return true;
+    }
+
+    const quint32 next = m_size.load(std::memory_order_relaxed);
+    const quint32 chunkIndex = next >> ChunkShift;
+    if (chunkIndex >= quint32(MaxChunks)) {
+        return false;
+    }
+
+    QString *chunk = m_chunks[chunkIndex].load(std::memory_order_relaxed);
+    if (!chunk) {
+        chunk = new QString[ChunkSize];
+        m_chunks[chunkIndex].store(chunk, std::memory_order_release);
+    }
+    chunk[next & (ChunkSize - 1)] = text;
+    m_ids.insert(text, next);
+
+    // Publish the entry only after the string has been written
+    m_size.store(next + 1, std::memory_order_release);
+    *id = next;
+    return true;
+}
+
+QString HYStringPool::string(quint32 id) const
+{
+    if (id >= m_size.load(std::memory_order_acquire)) {
+        return QString();
+    }
+    return m_chunks[id >> ChunkShift].load(std::memory_order_acquire)[id & (ChunkSize - 1)];
+}
+
+int HYStringPool::size() const
+{
+    return int(m_size.load(std::memory_order_acquire));
+}
+
+HYTagValue HYTagValue::fromString(const QString &value)
+{
+    quint32 id;
+    if (!HYStringPool::instance()->intern(value, &id)) {
+        return HYTagValue();
+    }
+    return HYTagValue(String, id);
+}
+
+bool HYTagValue::fromVariant(const QVariant &variant, HYTagValue *value)
+{
+    switch (variant.typeId()) {
+    case QMetaType::UnknownType:
+        *value = HYTagValue();
+        return true;
+    case QMetaType::Bool:
+        *value = fromBool(variant.toBool());
+        return true;
+    case QMetaType::Int:
+    case QMetaType::Short:
+    case QMetaType::Long:
+    case QMetaType::LongLong:
+    case QMetaType::Char:
+    case QMetaType::SChar:
+    case QMetaType::UInt:
+    case QMetaType::UShort:
+    case QMetaType::ULong:
+    case QMetaType::UChar:
+        *value = fromInt64(variant.toLongLong());
+        return true;
+    case QMetaType::ULongLong: {
+        const qulonglong u = variant.toULongLong();
+        if (u > qulonglong(std::numeric_limits<qint64>::max())) {
+            *value = fromDouble(double(u));
+        } else {
+            *value = fromInt64(qint64(u));
+        }
+        return true;
+    }
+    case QMetaType::Double:
+    case QMetaType::Float:
+        *value = fromDouble(variant.toDouble());
+        return true;
+    case QMetaType::QString: {
+        quint32 id;
+        if (!HYStringPool::instance()->intern(variant.toString(), &id)) {
+            return false;
+        }
+        *value = HYTagValue(String, id);
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+bool HYTagValue::toBool() const
+{
+    switch (m_type) {
+    case Bool:
+    case Int64:
+        return m_bits != 0;
+    case Double:
+        return toDouble() != 0.0;
+    case String:
+        return QVariant(toString()).toBool();
+    default:
+        return false;
+    }
+}
+
+qint64 HYTagValue::toInt64() const
+{
+    switch (m_type) {
+    case Bool:
+    case Int64:
+        return qint64(m_bits);
+    case Double:
+        return qint64(toDouble());
+    case String:
+        return toString().toLongLong();
+    default:
+        return 0;
+    }
+}
+
+double HYTagValue::toDouble() const
+{
+    switch (m_type) {
+    case Bool:
+    case Int64:
+        return double(qint64(m_bits));
+    case Double: {
+        double d;
+        std::memcpy(&d, &m_bits, sizeof(d));
+        return d;
+    }
+    case String:
+        return toString().toDouble();
+    default:
+        return 0.0;
+    }
+}
+
+QString HYTagValue::toString() const
+{
+    switch (m_type) {
+    case Bool:
+        return m_bits ? QStringLiteral("true") : QStringLiteral("false");
+    case Int64:
+        return QString::number(qint64(m_bits));
+    case Double:
+        // Shortest form that reads back to the same double, not the 6-digit default
+        return QString::number(toDouble(), 'g', QLocale::FloatingPointShortest);
+    case String:
+        return HYStringPool::instance()->string(quint32(m_bits));
+    default:
+        return QString();
+    }
+}
+
+QVariant HYTagValue::toVariant() const
+{
+    switch (m_type) {
+    case Bool:
+        return QVariant(m_bits != 0);
+    case Int64: {
+        const qint64 i = qint64(m_bits);
+        if (i >= std::numeric_limits<int>::min() && i <= std::numeric_limits<int>::max()) {
+            return QVariant(int(i));
+        }
+        return QVariant(qlonglong(i));
+    }
+    case Double:
+        return QVariant(toDouble());
+    case String:
+        return QVariant(toString());
+    default:
+        return QVariant();
+    }
+}
@@ -0,0 +1,230 @@
+#ifndef HYTAGVALUE_H
+#define HYTAGVALUE_H
+
+#include <QString>
+#include <QVariant>
+#include <QHash>
+#include <QReadWriteLock>
+#include <QtGlobal>
+#include <atomic>
+#include <cstring>
+#include <memory>
+
+/**
+ * @file tagvalue.h
+ * @brief 点位类型化值头文件
+ *
+ * 定义了紧凑的带标签联合体HYTagValue，用于替代热路径上的QVariant
+ * 字符串值通过HYStringPool驻留为整数编号，使点位值始终是16字节的平凡类型
+ * 只有在数据交给QML或信号时才转换为QVariant
+ */
+
+/**
+ * @class HYStringPool
+ * @brief 字符串驻留池
+ *
+ * 相同内容的字符串只保存一份并分配固定编号，编号一经分配不会失效
+ * 查找已驻留的字符串加读锁，新增时加写锁，按编号取字符串无锁
+ * 驻留的字符串不会释放，因此只接受不超过MaxLength个字符的字符串，总数不超过MaxChunks * ChunkSize；
+ * 其余字符串（自由文本）由调用者按复杂值保存在各点位自己的旁路表中，随点位值覆盖而释放
+ */
+class HYStringPool
+{
+public:
+    /**
+     * @brief 获取全局字符串池
+     * @return 字符串池实例
+     */
+    static HYStringPool *instance();
+
+    /**
+     * @brief 构造函数
+     */
+    HYStringPool();
+
+    /**
+     * @brief 析构函数
+     */
+    ~HYStringPool();
+
+    /**
+     * @brief 驻留字符串
+     * @param text 字符串
+     * @param id 输出字符串编号
+     * @return 是否成功，字符串过长或池已满时返回false
+     */
+    bool intern(const QString &text, quint32 *id);
+
+    /**
+     * @brief 按编号获取字符串
+     * @param id 字符串编号
+     * @return 字符串，编号无效时为空
+     */
+    QString string(quint32 id) const;
+
+    /**
+     * @brief 获取已驻留的字符串数量
+     * @return 字符串数量
+     */
+    int size() const;
+
+    static constexpr int MaxLength = 64; ///< 可驻留字符串的最大字符数
+
+private:
+    Q_DISABLE_COPY(HYStringPool)
+
+    static constexpr int ChunkShift = 12; ///< 每块字符串数的位数
+    static constexpr int ChunkSize = 1 << ChunkShift; ///< 每块字符串数
+    static constexpr int MaxChunks = 16; ///< 最大块数
+
+    std::unique_ptr<std::atomic<QString *>[]> m_chunks; ///< 块目录，大小固定
+    std::atomic<quint32> m_size; ///< 已驻留的字符串数量
+    QReadWriteLock m_lock; ///< 驻留读写锁
+    QHash<QString, quint32> m_ids; ///< 字符串到编号的索引
+};
+
+/**
+ * @class HYTagValue
+ * @brief 点位类型化值
+ *
+ * 支持空值、布尔、64位整数、双精度浮点和驻留字符串五种类型
+ * 平凡可复制，比较只需比较类型和64位负载
+ */
+class HYTagValue
+{
+public:
+    /**
+     * @enum Type
+     * @brief 值类型
+     */
+    enum Type : quint8 {
+        Null = 0, ///< 空值
+        Bool,     ///< 布尔
+        Int64,    ///< 64位整数
+        Double,   ///< 双精度浮点
+        String    ///< 驻留字符串
+    };
+
+    /**
+     * @brief 构造空值
+     */
+    HYTagValue() : m_type(Null), m_bits(0) {}
+
+    /**
+     * @brief 构造布尔值
+     * @param value 值
+     * @return 点位值
+     */
+    static HYTagValue fromBool(bool value) { return HYTagValue(Bool, value ? 1 : 0); }
+
+    /**
+     * @brief 构造整数值
+     * @param value 值
+     * @return 点位值
+     */
+    static HYTagValue fromInt64(qint64 value) { return HYTagValue(Int64, quint64(value)); }
+
+    /**
+     * @brief 构造浮点值
+     * @param value 值
+     * @return 点位值
+     */
+    static HYTagValue fromDouble(double value)
+    {
+        quint64 bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return HYTagValue(Double, bits);
+    }
+
+    /**
+     * @brief 构造字符串值，字符串会被驻留
+     * @param value 值
+     * @return 点位值，字符串过长或字符串池已满时为空值
+     */
+    static HYTagValue fromString(const QString &value);
+
+    /**
+     * @brief 由类型和负载直接构造，用于反序列化
+     * @param type 值类型
+     * @param bits 64位负载
+     * @return 点位值
+     */
+    static HYTagValue fromRaw(Type type, quint64 bits) { return HYTagValue(type, bits); }
+
+    /**
+     * @brief 由QVariant转换
+     * @param variant 源值
+     * @param value 输出点位值
+     * @return 是否可以表示为类型化值，不能驻留的字符串返回false
+     */
+    static bool fromVariant(const QVariant &variant, HYTagValue *value);
+
+    /**
+     * @brief 获取值类型
+     * @return 值类型
+     */
+    Type type() const { return m_type; }
+
+    /**
+     * @brief 获取64位负载
+     * @return 负载
+     */
+    quint64 bits() const { return m_bits; }
+
+    /**
+     * @brief 是否为空值
+     * @return 是否为空值
+     */
+    bool isNull() const { return m_type == Null; }
+
+    /**
+     * @brief 是否为数值（布尔、整数或浮点）
+     * @return 是否为数值
+     */
+    bool isNumeric() const { return m_type == Bool || m_type == Int64 || m_type == Double; }
+
+    /**
+     * @brief 转换为布尔
+     * @return 布尔值
+     */
+    bool toBool() const;
+
+    /**
+     * @brief 转换为整数
+     * @return 整数值
+     */
+    qint64 toInt64() const;
+
+    /**
+     * @brief 转换为浮点
+     * @return 浮点值
+     */
+    double toDouble() const;
+
+    /**
+     * @brief 转换为字符串
+     * @return 字符串
+     */
+    QString toString() const;
+
+    /**
+     * @brief 转换为QVariant，仅在数据交给QML或信号时调用
+     *
+     * 整数在int范围内时转换为int，否则为qlonglong
+     * @return QVariant值
+     */
+    QVariant toVariant() const;
+
+    bool operator==(const HYTagValue &other) const { return m_type == other.m_type && m_bits == other.m_bits; }
+    bool operator!=(const HYTagValue &other) const { return !(*this == other); }
+
+private:
+    HYTagValue(Type type, quint64 bits) : m_type(type), m_bits(bits) {}
+
+    Type m_type; ///< 值类型
+    quint64 m_bits; ///< 负载：布尔、整数、浮点的二进制表示或字符串编号
+};
+
+Q_DECLARE_TYPEINFO(HYTagValue, Q_PRIMITIVE_TYPE);
+
+#endif // HYTAGVALUE_H
@@ -0,0 +1,500 @@
+#include "tagvaluestore.h"
+#include <QThread>
+
+/**
+ * @file tagvaluestore.cpp
+ * @brief 点位值存储类实现
+ *
+ * 各列按句柄下标对齐存放，新增点位只在列尾追加
+ * 写者按顺序锁协议更新槽位：先将顺序号置为奇数，写入数据，再置为偶数
+ * 读者在前后两次读取顺序号相同且为偶数时才认为读到的数据完整
+ * 跨分片读取时，所涉及分片的代数在读取前后都未变化才认为读到的是同一代
+ */
+
+namespace {
+
+/**
+ * @brief 读者自旋等待
+ * @param spins 已自旋次数
+ */
+inline void backoff(int &spins)
+{
+    if (++spins > 64) {
+        QThread::yieldCurrentThread();
+        spins = 0;
+    }
+}
+
+} // namespace
+
+HYTagValueStore::HYTagValueStore(int shardCount) :
+    m_pages(new std::atomic<Page *>[MaxPages]),
+    m_size(0),
+    m_shardMask(shardCount - 1),
+    m_shards(new Shard[shardCount])
+{
+    Q_ASSERT(shardCount > 0 && shardCount <= MaxShards && (shardCount & (shardCount - 1)) == 0);
+
+    for (int i = 0; i < MaxPages; ++i) {
+        m_pages[i].store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+HYTagValueStore::~HYTagValueStore()
+{
+    for (int i = 0; i < MaxPages; ++i) {
+        delete m_pages[i].load(std::memory_order_relaxed);
+    }
+}
+
+HYTagId HYTagValueStore::allocate(const QVariant &value, qint64 timestamp)
+{
+    HYTagValue typed;
+    if (HYTagValue::fromVariant(value, &typed)) {
+        return allocate(typed, timestamp);
+    }
+
+    Slot slot;
+    slot.type = ComplexType;
+    slot.payload = 0;
+    slot.timestamp = timestamp;
+    slot.serverTimestamp = timestamp;
+    slot.quality = QualityGood;
+
+    const HYTagId id = allocateSlot(slot);
+    if (id != HYInvalidTagId) {
+        m_shards[shardOf(id)].complexValues.insert(id, value);
+    }
+    return id;
+}
+
+HYTagId HYTagValueStore::allocate(const HYTagValue &value, qint64 timestamp)
+{
+    Slot slot;
+    slot.type = qint8(value.type());
+    slot.payload = value.bits();
+    slot.timestamp = timestamp;
+    slot.serverTimestamp = timestamp;
+    slot.quality = QualityGood;
+    return allocateSlot(slot);
+}
+
+void HYTagValueStore::release(HYTagId id)
+{
+    if (!contains(id)) {
+        return;
+    }
+
+    // Slots are never reused so that stale handles cannot alias a new tag
+    Slot slot;
+    slot.type = ReleasedType;
+    slot.payload = 0;
+    slot.timestamp = 0;
+    slot.serverTimestamp = 0;
+    slot.quality = QualityBad;
+
+    beginWrite(shardOf(id));
+    writeSlot(id, slot);
+    endWrite(shardOf(id));
+    m_shards[shardOf(id)].complexValues.remove(id);
+}
+
+bool HYTagValueStore::contains(HYTagId id) const
+{
+    if (id < 0 || id >= m_size.load(std::memory_order_acquire)) {
+        return false;
+    }
+    return page(id)->types[id & PageMask].load(std::memory_order_acquire) != ReleasedType;
+}
+
+int HYTagValueStore::size() const
+{
+    return m_size.load(std::memory_order_acquire);
+}
+
+void HYTagValueStore::reserve(int capacity)
+{
+    const int pageCount = qMin((capacity + PageSize - 1) >> PageShift, MaxPages);
+    for (int i = 0; i < pageCount; ++i) {
+        if (!m_pages[i].load(std::memory_order_relaxed)) {
+            m_pages[i].store(new Page(), std::memory_order_release);
+        }
+    }
+}
+
+void HYTagValueStore::beginWrite(int shard)
+{
+    Shard &state = m_shards[shard];
+    if (state.writeDepth++ == 0) {
+        state.generation.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+}
+
+void HYTagValueStore::endWrite(int shard)
+{
+    Shard &state = m_shards[shard];
+    if (--state.writeDepth == 0) {
+        state.generation.fetch_add(1, std::memory_order_release);
+    }
+}
+
+bool HYTagValueStore::setValue(HYTagId id, const QVariant &value, qint64 timestamp)
+{
+    return setValue(id, value, timestamp, timestamp, KeepQuality);
+}
+
+bool HYTagValueStore::setValue(HYTagId id, const QVariant &value, qint64 sourceTimestamp, qint64 serverTimestamp,
+                               int quality)
+{
+    HYTagValue typed;
+    if (HYTagValue::fromVariant(value, &typed)) {
+        return setValue(id, typed, sourceTimestamp, serverTimestamp, quality);
+    }
+
+    if (!contains(id)) {
+        return false;
+    }
+
+    QHash<HYTagId, QVariant> &complexValues = m_shards[shardOf(id)].complexValues;
+    auto it = complexValues.find(id);
+    const bool changed = it == complexValues.end() || it.value() != value;
+    if (changed) {
+        complexValues.insert(id, value);
+    }
+
+    // The slot reports every complex write as a change, so only a quality transition is taken from it
+    const bool qualityChanged = quality != KeepQuality && quint8(quality) != this->quality(id);
+    updateSlot(id, ComplexType, 0, sourceTimestamp, serverTimestamp, quality);
+    return changed || qualityChanged;
+}
+
+bool HYTagValueStore::setValue(HYTagId id, const HYTagValue &value, qint64 timestamp)
+{
+    return setValue(id, value, timestamp, timestamp, KeepQuality);
+}
+
+bool HYTagValueStore::setValue(HYTagId id, const HYTagValue &value, qint64 sourceTimestamp, qint64 serverTimestamp,
+                               int quality)
+{
+    const bool changed = updateSlot(id, qint8(value.type()), value.bits(), sourceTimestamp, serverTimestamp, quality);
+    if (changed) {
+        QHash<HYTagId, QVariant> &complexValues = m_shards[shardOf(id)].complexValues;
+        if (!complexValues.isEmpty()) {
+            complexValues.remove(id);
+        }
+    }
+    return changed;
+}
+
+QVariant HYTagValueStore::value(HYTagId id) const
+{
+    Slot slot;
+    if (!readSlot(id, &slot)) {
+        return QVariant();
+    }
+    if (slot.type == ComplexType) {
+        return m_shards[shardOf(id)].complexValues.value(id);
+    }
+    return HYTagValue::fromRaw(HYTagValue::Type(slot.type), slot.payload).toVariant();
+}
+
+HYTagValue HYTagValueStore::typedValue(HYTagId id) const
+{
+    Slot slot;
+    if (!readSlot(id, &slot) || slot.type == ComplexType) {
+        return HYTagValue();
+    }
+    return HYTagValue::fromRaw(HYTagValue::Type(slot.type), slot.payload);
+}
+
+HYTagValueStore::ReadStatus HYTagValueStore::read(HYTagId id, HYTagValue *value, qint64 *timestamp, quint8 *quality) const
+{
+    Slot slot;
+    if (!readSlot(id, &slot)) {
+        return ReadInvalid;
+    }
+
+    if (timestamp) {
+        *timestamp = slot.timestamp;
+    }
+    if (quality) {
+        *quality = slot.quality;
+    }
+    if (slot.type == ComplexType) {
+        return ReadComplex;
+    }
+    if (value) {
+        *value = HYTagValue::fromRaw(HYTagValue::Type(slot.type), slot.payload);
+    }
+    return ReadOk;
+}
+
+HYTagValueStore::ReadStatus HYTagValueStore::readRecord(HYTagId id, HYTagRecord *record) const
+{
+    Slot slot;
+    if (!readSlot(id, &slot)) {
+        return ReadInvalid;
+    }
+
+    record->sourceTimestamp = slot.timestamp;
+    record->serverTimestamp = slot.serverTimestamp;
+    record->quality = slot.quality;
+    if (slot.type == ComplexType) {
+        record->value = HYTagValue();
+        return ReadComplex;
+    }
+    record->value = HYTagValue::fromRaw(HYTagValue::Type(slot.type), slot.payload);
+    return ReadOk;
+}
+
+bool HYTagValueStore::readConsistent(const QVector<HYTagId> &ids, QVector<HYTagValue> *values, quint64 *generation) const
+{
+    QVector<Slot> slots(ids.size());
+    QVector<bool> valid(ids.size());
+    const int shards = shardCount();
+    quint64 before[MaxShards];
+    int spins = 0;
+
+    // Only shards that own one of the requested slots have to stay quiet during the read
+    quint64 involved = 0;
+    for (HYTagId id : ids) {
+        if (id >= 0) {
+            involved |= quint64(1) << shardOf(id);
+        }
+    }
+
+    for (;;) {
+        bool writing = false;
+        for (int shard = 0; shard < shards; ++shard) {
+            before[shard] = m_shards[shard].generation.load(std::memory_order_acquire);
+            writing |= ((involved >> shard) & 1) && (before[shard] & 1);
+        }
+        if (writing) {
+            backoff(spins);
+            continue;
+        }
+
+        for (int i = 0; i < ids.size(); ++i) {
+            valid[i] = readSlot(ids[i], &slots[i]);
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        bool stable = true;
+        for (int shard = 0; shard < shards && stable; ++shard) {
+            if ((involved >> shard) & 1) {
+                stable = m_shards[shard].generation.load(std::memory_order_relaxed) == before[shard];
+            }
+        }
+        if (stable) {
+            break;
+        }
+        backoff(spins);
+    }
+
+    bool complete = true;
+    values->resize(ids.size());
+    for (int i = 0; i < ids.size(); ++i) {
+        if (!valid[i]) {
+            (*values)[i] = HYTagValue();
+        } else if (slots[i].type == ComplexType) {
+            complete = false;
+        } else {
+            (*values)[i] = HYTagValue::fromRaw(HYTagValue::Type(slots[i].type), slots[i].payload);
+        }
+    }
+
+    if (generation) {
+        *generation = 0;
+        for (int shard = 0; shard < shards; ++shard) {
+            *generation += before[shard] >> 1;
+        }
+    }
+    return complete;
+}
+
+quint64 HYTagValueStore::generation() const
+{
+    quint64 total = 0;
+    for (int shard = 0; shard < shardCount(); ++shard) {
+        total += m_shards[shard].generation.load(std::memory_order_acquire) >> 1;
+    }
+    return total;
+}
+
+qint64 HYTagValueStore::timestamp(HYTagId id) const
+{
+    Slot slot;
+    return readSlot(id, &slot) ? slot.timestamp : 0;
+}
+
+qint64 HYTagValueStore::serverTimestamp(HYTagId id) const
+{
+    Slot slot;
+    return readSlot(id, &slot) ? slot.serverTimestamp : 0;
+}
+
+quint8 HYTagValueStore::quality(HYTagId id) const
+{
+    Slot slot;
+    return readSlot(id, &slot) ? slot.quality : quint8(QualityBad);
+}
+
+bool HYTagValueStore::setQuality(HYTagId id, quint8 quality, qint64 serverTimestamp)
+{
+    Slot slot;
+    if (!readSlot(id, &slot)) {
+        return false;
+    }
+
+    const bool changed = slot.quality != quality;
+    slot.quality = quality;
+    if (serverTimestamp) {
+        slot.serverTimestamp = serverTimestamp;
+    }
+    beginWrite(shardOf(id));
+    writeSlot(id, slot);
+    endWrite(shardOf(id));
+    return changed;
+}
+
+quint8 HYTagValueStore::qualityFromStatusCode(quint32 statusCode)
+{
+    // Specific codes keep their meaning as a substatus; anything else falls back to the severity bits
+    switch (statusCode & 0xFFFF0000u) {
+    case 0x80890000u: // BadConfigurationError
+        return QualityConfigError;
+    case 0x808A0000u: // BadNotConnected
+        return QualityNotConnected;
+    case 0x808B0000u: // BadDeviceFailure
+        return QualityDeviceFailure;
+    case 0x808C0000u: // BadSensorFailure
+        return QualitySensorFailure;
+    case 0x80050000u: // BadCommunicationError
+        return QualityCommFailure;
+    case 0x808D0000u: // BadOutOfService
+        return QualityOutOfService;
+    case 0x40900000u: // UncertainLastUsableValue
+        return QualityLastUsable;
+    case 0x40930000u: // UncertainSensorNotAccurate
+        return QualitySensorNotAccurate;
+    case 0x40940000u: // UncertainEngineeringUnitsExceeded
+        return QualityEngineeringUnitsExceeded;
+    case 0x40950000u: // UncertainSubNormal
+        return QualitySubNormal;
+    case 0x00960000u: // GoodLocalOverride
+        return QualityLocalOverride;
+    default:
+        break;
+    }
+
+    switch (statusCode >> 30) {
+    case 0:
+        return QualityGood;
+    case 1:
+        return QualityUncertain;
+    default:
+        return QualityBad;
+    }
+}
+
+HYTagId HYTagValueStore::allocateSlot(const Slot &slot)
+{
+    const HYTagId id = m_size.load(std::memory_order_relaxed);
+    if (id >= MaxPages * PageSize) {
+        return HYInvalidTagId;
+    }
+
+    const int pageIndex = id >> PageShift;
+    if (!m_pages[pageIndex].load(std::memory_order_relaxed)) {
+        m_pages[pageIndex].store(new Page(), std::memory_order_release);
+    }
+
+    beginWrite(shardOf(id));
+    writeSlot(id, slot);
+    endWrite(shardOf(id));
+
+    // Publish the slot only after it has been fully initialised
+    m_size.store(id + 1, std::memory_order_release);
+    return id;
+}
+
+bool HYTagValueStore::updateSlot(HYTagId id, qint8 type, quint64 payload, qint64 sourceTimestamp,
+                                 qint64 serverTimestamp, int quality)
+{
+    Slot slot;
+    if (!readSlot(id, &slot)) {
+        return false;
+    }
+
+    // Typed values compare by kind and payload; interned strings compare by id
+    // A quality transition counts as a change so that consumers see a value turn bad or recover
+    bool changed = type == ComplexType || slot.type != type || slot.payload != payload;
+    if (quality != KeepQuality) {
+        changed = changed || slot.quality != quint8(quality);
+        slot.quality = quint8(quality);
+    }
+    slot.type = type;
+    slot.payload = payload;
+    slot.timestamp = sourceTimestamp;
+    slot.serverTimestamp = serverTimestamp;
+
+    beginWrite(shardOf(id));
+    writeSlot(id, slot);
+    endWrite(shardOf(id));
+    return changed;
+}
+
+HYTagValueStore::Page *HYTagValueStore::page(HYTagId id) const
+{
+    return m_pages[id >> PageShift].load(std::memory_order_acquire);
+}
+
+bool HYTagValueStore::readSlot(HYTagId id, Slot *slot) const
+{
+    if (id < 0 || id >= m_size.load(std::memory_order_acquire)) {
+        return false;
+    }
+
+    const Page *p = page(id);
+    const int index = id & PageMask;
+    int spins = 0;
+
+    for (;;) {
+        const quint32 before = p->sequences[index].load(std::memory_order_acquire);
+        if (before & 1) {
+            backoff(spins);
+            continue;
+        }
+
+        slot->type = p->types[index].load(std::memory_order_relaxed);
+        slot->payload = p->payloads[index].load(std::memory_order_relaxed);
+        slot->timestamp = p->timestamps[index].load(std::memory_order_relaxed);
+        slot->serverTimestamp = p->serverTimestamps[index].load(std::memory_order_relaxed);
+        slot->quality = p->qualities[index].load(std::memory_order_relaxed);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (p->sequences[index].load(std::memory_order_relaxed) == before) {
+            return slot->type != ReleasedType;
+        }
+        backoff(spins);
+    }
+}
+
+void HYTagValueStore::writeSlot(HYTagId id, const Slot &slot)
+{
+    Page *p = page(id);
+    const int index = id & PageMask;
+    const quint32 sequence = p->sequences[index].load(std::memory_order_relaxed);
+
+    p->sequences[index].store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    p->types[index].store(slot.type, std::memory_order_relaxed);
+    p->payloads[index].store(slot.payload, std::memory_order_relaxed);
+    p->timestamps[index].store(slot.timestamp, std::memory_order_relaxed);
+    p->serverTimestamps[index].store(slot.serverTimestamp, std::memory_order_relaxed);
+    p->qualities[index].store(slot.quality, std::memory_order_relaxed);
+
+    p->sequences[index].store(sequence + 2, std::memory_order_release);
+}
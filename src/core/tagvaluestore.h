@@ -0,0 +1,389 @@
+#ifndef HYTAGVALUESTORE_H
+#define HYTAGVALUESTORE_H
+
+#include <QVector>
+#include <QVariant>
+#include <QHash>
+#include <QtGlobal>
+#include <atomic>
+#include <memory>
+#include "tagvalue.h"
+
+/**
+ * @file tagvaluestore.h
+ * @brief 点位值存储类头文件
+ *
+ * 以结构数组（SoA）的方式连续存放点位的值、源时间戳、服务器时间戳和质量码
+ * 通过整数句柄直接寻址，避免按名称查找和经由堆对象的间接访问
+ * 读取端基于顺序锁（seqlock）实现，读者从不阻塞写者
+ */
+
+/**
+ * @brief 点位句柄类型
+ *
+ * 点位添加时分配，在点位生命周期内保持不变，删除后不会被复用
+ */
+typedef qint32 HYTagId;
+
+/**
+ * @brief 无效点位句柄
+ */
+constexpr HYTagId HYInvalidTagId = -1;
+
+struct HYTagRecord;
+
+/**
+ * @class HYTagValueStore
+ * @brief 点位值存储类
+ *
+ * 数据按固定大小的页分配，页一经分配地址不再变化，因此读者无需加锁即可访问
+ * 每个槽位带有顺序号，全局另有一个代数计数器，用于读取同一代的多个点位
+ *
+ * 槽位按句柄低位轮流划分到若干分片，每个分片有独立的代数计数器和旁路表
+ * 同一分片的写操作（释放、设置值）必须由调用方串行化，不同分片可以并发写入
+ * 分配操作之间也必须串行化，且分配时调用方需持有新句柄所在分片的写锁
+ * 槽位直接保存HYTagValue的类型和负载，可表示为HYTagValue的值读取完全无锁
+ * 其他QVariant类型保存在旁路表中，读取时需要持有写锁
+ */
+class HYTagValueStore
+{
+public:
+    /**
+     * @enum Quality
+     * @brief 点位质量码
+     *
+     * 采用OPC DA的单字节编码：高2位为状态（坏/不确定/好），中间4位为子状态，低2位为限值标志
+     */
+    enum Quality : quint8 {
+        QualityBad = 0x00,                   ///< 坏值
+        QualityConfigError = 0x04,           ///< 坏值：配置错误
+        QualityNotConnected = 0x08,          ///< 坏值：未连接
+        QualityDeviceFailure = 0x0C,         ///< 坏值：设备故障
+        QualitySensorFailure = 0x10,         ///< 坏值：传感器故障
+        QualityLastKnown = 0x14,             ///< 坏值：通信中断，保留最后已知值
+        QualityCommFailure = 0x18,           ///< 坏值：通信故障
+        QualityOutOfService = 0x1C,          ///< 坏值：停用
+        QualityUncertain = 0x40,             ///< 不确定
+        QualityLastUsable = 0x44,            ///< 不确定：最后可用值
+        QualitySensorNotAccurate = 0x50,     ///< 不确定：传感器不准确
+        QualityEngineeringUnitsExceeded = 0x54, ///< 不确定：超出工程量程
+        QualitySubNormal = 0x58,             ///< 不确定：低于正常
+        QualityGood = 0xC0,                  ///< 好值
+        QualityLocalOverride = 0xD8          ///< 好值：本地强制
+    };
+
+    static constexpr quint8 QualityStatusMask = 0xC0; ///< 质量码状态位
+    static constexpr quint8 QualitySubstatusMask = 0x3C; ///< 质量码子状态位
+    static constexpr quint8 QualityLimitMask = 0x03; ///< 质量码限值标志位
+    static constexpr int KeepQuality = -1; ///< 写入值时保留原质量码
+
+    /**
+     * @enum ReadStatus
+     * @brief 无锁读取结果
+     */
+    enum ReadStatus {
+        ReadInvalid, ///< 句柄无效
+        ReadOk,      ///< 读取成功
+        ReadComplex  ///< 值无法表示为HYTagValue，需要在写锁保护下读取
+    };
+
+    static constexpr int MaxShards = 64; ///< 最大分片数
+
+    /**
+     * @brief 检查质量码是否为好值
+     * @param quality 质量码
+     * @return 是否为好值
+     */
+    static bool isGood(quint8 quality) { return (quality & QualityStatusMask) == QualityGood; }
+
+    /**
+     * @brief 检查质量码是否为坏值
+     * @param quality 质量码
+     * @return 是否为坏值
+     */
+    static bool isBad(quint8 quality) { return (quality & QualityStatusMask) == QualityBad; }
+
+    /**
+     * @brief 把OPC UA状态码转换为质量码
+     *
+     * 按状态码的严重性确定状态，已知的状态码映射到对应的子状态
+     * @param statusCode OPC UA状态码
+     * @return 质量码
+     */
+    static quint8 qualityFromStatusCode(quint32 statusCode);
+
+    /**
+     * @brief 构造函数
+     * @param shardCount 分片数，必须是不超过MaxShards的2的幂
+     */
+    explicit HYTagValueStore(int shardCount = 1);
+
+    /**
+     * @brief 析构函数
+     */
+    ~HYTagValueStore();
+
+    /**
+     * @brief 分配新的点位槽位
+     * @param value 初始值
+     * @param timestamp 初始时间戳（毫秒）
+     * @return 点位句柄，容量耗尽时为HYInvalidTagId
+     */
+    HYTagId allocate(const QVariant &value, qint64 timestamp);
+
+    /**
+     * @brief 分配新的点位槽位
+     * @param value 初始值
+     * @param timestamp 初始时间戳（毫秒）
+     * @return 点位句柄，容量耗尽时为HYInvalidTagId
+     */
+    HYTagId allocate(const HYTagValue &value, qint64 timestamp);
+
+    /**
+     * @brief 释放点位槽位
+     * @param id 点位句柄
+     */
+    void release(HYTagId id);
+
+    /**
+     * @brief 检查句柄是否有效
+     * @param id 点位句柄
+     * @return 是否有效
+     */
+    bool contains(HYTagId id) const;
+
+    /**
+     * @brief 获取槽位总数（包含已释放的槽位）
+     * @return 槽位总数
+     */
+    int size() const;
+
+    /**
+     * @brief 预先分配能容纳指定数量槽位的页
+     * @param capacity 槽位数量
+     */
+    void reserve(int capacity);
+
+    /**
+     * @brief 获取分片数
+     * @return 分片数
+     */
+    int shardCount() const { return m_shardMask + 1; }
+
+    /**
+     * @brief 获取句柄所在分片
+     * @param id 点位句柄
+     * @return 分片下标
+     */
+    int shardOf(HYTagId id) const { return id & m_shardMask; }
+
+    /**
+     * @brief 开始一次写入批次
+     *
+     * 批次内对该分片的所有写入属于同一代，批次可以嵌套
+     * @param shard 分片下标
+     */
+    void beginWrite(int shard = 0);
+
+    /**
+     * @brief 结束写入批次
+     * @param shard 分片下标
+     */
+    void endWrite(int shard = 0);
+
+    /**
+     * @brief 设置点位值
+     * @param id 点位句柄
+     * @param value 新值
+     * @param timestamp 时间戳（毫秒）
+     * @return 值是否发生变化
+     */
+    bool setValue(HYTagId id, const QVariant &value, qint64 timestamp);
+
+    /**
+     * @brief 设置任意类型的点位值、时间戳和质量码
+     * @param id 点位句柄
+     * @param value 新值，无法表示为HYTagValue时保存在分片的复杂值表中
+     * @param sourceTimestamp 源时间戳（毫秒），数据源采样的时间
+     * @param serverTimestamp 服务器时间戳（毫秒），写入点位表的时间
+     * @param quality 质量码，KeepQuality表示保留原质量码
+     * @return 值或质量码是否发生变化
+     */
+    bool setValue(HYTagId id, const QVariant &value, qint64 sourceTimestamp, qint64 serverTimestamp, int quality);
+
+    /**
+     * @brief 设置点位值
+     * @param id 点位句柄
+     * @param value 新值
+     * @param timestamp 时间戳（毫秒），同时作为源时间戳和服务器时间戳
+     * @return 值是否发生变化
+     */
+    bool setValue(HYTagId id, const HYTagValue &value, qint64 timestamp);
+
+    /**
+     * @brief 设置点位值、时间戳和质量码
+     * @param id 点位句柄
+     * @param value 新值
+     * @param sourceTimestamp 源时间戳（毫秒），数据源采样的时间
+     * @param serverTimestamp 服务器时间戳（毫秒），写入点位表的时间
+     * @param quality 质量码，KeepQuality表示保留原质量码
+     * @return 值或质量码是否发生变化
+     */
+    bool setValue(HYTagId id, const HYTagValue &value, qint64 sourceTimestamp, qint64 serverTimestamp, int quality);
+
+    /**
+     * @brief 获取点位值
+     *
+     * 类型化值无锁读取；旁路表中的值需要调用方持有写锁
+     * @param id 点位句柄
+     * @return 点位值
+     */
+    QVariant value(HYTagId id) const;
+
+    /**
+     * @brief 无锁获取类型化点位值
+     * @param id 点位句柄
+     * @return 点位值，句柄无效或值在旁路表中时为空值
+     */
+    HYTagValue typedValue(HYTagId id) const;
+
+    /**
+     * @brief 无锁读取点位
+     * @param id 点位句柄
+     * @param value 输出点位值，结果为ReadComplex时不填充
+     * @param timestamp 输出时间戳，可为空
+     * @param quality 输出质量码，可为空
+     * @return 读取结果
+     */
+    ReadStatus read(HYTagId id, HYTagValue *value, qint64 *timestamp = nullptr, quint8 *quality = nullptr) const;
+
+    /**
+     * @brief 无锁读取点位的完整记录
+     * @param id 点位句柄
+     * @param record 输出记录，结果为ReadComplex时值为空值，时间戳和质量码仍有效
+     * @return 读取结果
+     */
+    ReadStatus readRecord(HYTagId id, HYTagRecord *record) const;
+
+    /**
+     * @brief 无锁读取同一代的多个点位值
+     *
+     * 若涉及的任一分片期间有写入则自动重试，保证返回的值来自同一代
+     * @param ids 点位句柄列表
+     * @param values 输出点位值，无效句柄对应空值
+     * @param generation 输出读取时的代数，可为空
+     * @return 是否全部读取成功；含旁路表中的值时返回false，调用方需在写锁下重读
+     */
+    bool readConsistent(const QVector<HYTagId> &ids, QVector<HYTagValue> *values, quint64 *generation = nullptr) const;
+
+    /**
+     * @brief 获取当前代数
+     * @return 各分片已完成的写入批次数之和
+     */
+    quint64 generation() const;
+
+    /**
+     * @brief 获取源时间戳
+     * @param id 点位句柄
+     * @return 时间戳（毫秒）
+     */
+    qint64 timestamp(HYTagId id) const;
+
+    /**
+     * @brief 获取服务器时间戳
+     * @param id 点位句柄
+     * @return 时间戳（毫秒）
+     */
+    qint64 serverTimestamp(HYTagId id) const;
+
+    /**
+     * @brief 获取质量码
+     * @param id 点位句柄
+     * @return 质量码
+     */
+    quint8 quality(HYTagId id) const;
+
+    /**
+     * @brief 设置质量码，值和源时间戳不变
+     * @param id 点位句柄
+     * @param quality 质量码
+     * @param serverTimestamp 服务器时间戳（毫秒），0表示不更新
+     * @return 质量码是否发生变化
+     */
+    bool setQuality(HYTagId id, quint8 quality, qint64 serverTimestamp = 0);
+
+private:
+    Q_DISABLE_COPY(HYTagValueStore)
+
+    static constexpr int PageShift = 10; ///< 每页槽位数的位数
+    static constexpr int PageSize = 1 << PageShift; ///< 每页槽位数
+    static constexpr int PageMask = PageSize - 1; ///< 页内下标掩码
+    static constexpr int MaxPages = 16384; ///< 最大页数
+    static constexpr qint8 ReleasedType = -2; ///< 已释放槽位的类型标记
+    static constexpr qint8 ComplexType = -1; ///< 旁路表中的值的类型标记
+
+    /**
+     * @struct Page
+     * @brief 一页槽位，各列独立连续存放
+     */
+    struct Page {
+        std::atomic<quint32> sequences[PageSize]; ///< 顺序号，奇数表示正在写入
+        std::atomic<qint8> types[PageSize]; ///< HYTagValue::Type或类型标记
+        std::atomic<quint64> payloads[PageSize]; ///< HYTagValue的负载
+        std::atomic<qint64> timestamps[PageSize]; ///< 源时间戳（毫秒）
+        std::atomic<qint64> serverTimestamps[PageSize]; ///< 服务器时间戳（毫秒）
+        std::atomic<quint8> qualities[PageSize]; ///< 质量码
+    };
+
+    /**
+     * @struct Shard
+     * @brief 分片的写入状态，按缓存行对齐以避免分片之间的伪共享
+     */
+    struct alignas(64) Shard {
+        std::atomic<quint64> generation{0}; ///< 写入代计数，奇数表示正在写入
+        int writeDepth = 0; ///< 写入批次嵌套深度（仅持有分片写锁的写者访问）
+        QHash<HYTagId, QVariant> complexValues; ///< 无法表示为HYTagValue的值（需分片写锁）
+    };
+
+    /**
+     * @struct Slot
+     * @brief 一个槽位的读取结果
+     */
+    struct Slot {
+        qint8 type;
+        quint64 payload;
+        qint64 timestamp;
+        qint64 serverTimestamp;
+        quint8 quality;
+    };
+
+    Page *page(HYTagId id) const;
+    bool readSlot(HYTagId id, Slot *slot) const;
+    void writeSlot(HYTagId id, const Slot &slot);
+
+    HYTagId allocateSlot(const Slot &slot);
+    bool updateSlot(HYTagId id, qint8 type, quint64 payload, qint64 sourceTimestamp, qint64 serverTimestamp,
+                    int quality);
+
+    std::unique_ptr<std::atomic<Page *>[]> m_pages; ///< 页目录，大小固定
+    std::atomic<int> m_size; ///< 已分配的槽位数
+    int m_shardMask; ///< 分片掩码
+    std::unique_ptr<Shard[]> m_shards; ///< 分片写入状态
+};
+
+/**
+ * @struct HYTagRecord
+ * @brief 点位的值、时间戳和质量码
+ *
+ * 固定大小的平凡类型，读取和传递都不分配内存
+ */
+struct HYTagRecord
+{
+    HYTagValue value; ///< 点位值
+    qint64 sourceTimestamp = 0; ///< 源时间戳（毫秒）
+    qint64 serverTimestamp = 0; ///< 服务器时间戳（毫秒）
+    quint8 quality = HYTagValueStore::QualityBad; ///< 质量码
+};
+Q_DECLARE_TYPEINFO(HYTagRecord, Q_PRIMITIVE_TYPE);
+
+#endif // HYTAGVALUESTORE_H
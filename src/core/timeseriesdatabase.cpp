@@ -1,21 +1,191 @@
 #include "timeseriesdatabase.h"
+#include "columnstore.h"
+#include "jsonstreamreader.h"
 #include <QNetworkAccessManager>
 #include <QNetworkRequest>
 #include <QNetworkReply>
 #include <QUrl>
 #include <QUrlQuery>
-#include <QJsonDocument>
-#include <QJsonObject>
-#include <QJsonArray>
 #include <QSqlDatabase>
 #include <QSqlQuery>
 #include <QSqlError>
 #include <QFile>
 #include <QDebug>
 #include <QEventLoop>
+#include <QHash>
+#include <QPair>
+#include <QSet>
+#include <QtEndian>
+#include <algorithm>
+#include <array>
+#include <iterator>
+#include <limits>
+
+namespace {
+
+/**
+ * @brief 判断值是否按数值存储
+ * @param value 标签值
+ * @return 是否为数值
+ */
+bool isNumeric(const QVariant &value)
+{
+    switch (value.typeId()) {
+    case QMetaType::Double:
+    case QMetaType::Float:
+    case QMetaType::Int:
+    case QMetaType::UInt:
+    case QMetaType::LongLong:
+    case QMetaType::ULongLong:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief 计算CRC-32（gzip使用的多项式）
+ * @param data 数据
+ * @return 校验值
+ */
+quint32 crc32(const QByteArray &data)
+{
+    static const std::array<quint32, 256> table = [] {
+        std::array<quint32, 256> entries{};
+        for (quint32 i = 0; i < 256; ++i) {
+            quint32 c = i;
+            for (int bit = 0; bit < 8; ++bit) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            entries[i] = c;
+        }
+        return entries;
+    }();
+
+    quint32 crc = 0xFFFFFFFFu;
+    for (char byte : data) {
+        crc = table[(crc ^ quint8(byte)) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+/**
+ * @brief 用gzip格式压缩数据
+ * @param data 数据
+ * @return gzip数据
+ */
+QByteArray gzipCompress(const QByteArray &data)
+{
+    // qCompress emits a 4-byte size, a 2-byte zlib header, the deflate stream and an Adler-32;
+    // gzip wraps the same deflate stream in its own header and CRC-32/size trailer
+    const QByteArray zlib = qCompress(data);
+    static const char header[10] = {'\x1f', '\x8b', 8, 0, 0, 0, 0, 0, 0, '\xff'};
+    char trailer[8];
+    qToLittleEndian<quint32>(crc32(data), trailer);
+    qToLittleEndian<quint32>(quint32(data.size()), trailer + 4);
+
+    QByteArray gzip;
+    gzip.reserve(zlib.size() + 12);
+    gzip.append(header, sizeof(header));
+    gzip.append(zlib.constData() + 6, zlib.size() - 10);
+    gzip.append(trailer, sizeof(trailer));
+    return gzip;
+}
+
+/**
+ * @brief 汇总中的统计项，内置列式存储中每项一个序列
+ */
+enum RollupField {
+    MinField,
+    MaxField,
+    SumField,
+    CountField,
+    FirstField,
+    LastField,
+    RollupFieldCount
+};
+
+const char *const RollupFieldNames[RollupFieldCount] = {"min", "max", "sum", "count", "first", "last"};
+
+/**
+ * @brief 向下取整到区间开始
+ * @param timestamp 时间戳（毫秒）
+ * @param interval 区间（毫秒）
+ * @return 区间开始时间
+ */
+qint64 floorTo(qint64 timestamp, qint64 interval)
+{
+    return timestamp - ((timestamp % interval) + interval) % interval;
+}
+
+/**
+ * @brief 查找比给定汇总区间细一级的区间
+ * @param interval 汇总区间（毫秒）
+ * @return 细一级的区间，最细一级返回0
+ */
+qint64 finerInterval(qint64 interval)
+{
+    const auto &intervals = HYTimeSeriesDatabase::RollupIntervals;
+    const auto it = std::find(std::begin(intervals), std::end(intervals), interval);
+    return it == std::begin(intervals) || it == std::end(intervals) ? 0 : *(it - 1);
+}
+
+/**
+ * @brief 生成内置列式存储中汇总统计项的序列名称
+ * @param tagName 标签名称
+ * @param interval 汇总区间（毫秒）
+ * @param field 统计项
+ * @return 序列名称
+ */
+QString rollupSeries(const QString &tagName, qint64 interval, int field)
+{
+    return QString("%1#%2s.%3").arg(tagName).arg(interval / 1000).arg(QLatin1String(RollupFieldNames[field]));
+}
+
+/**
+ * @brief 把毫秒时间转换为SQL绑定值
+ * @param timestamp 时间戳（毫秒）
+ * @param seconds 是否按秒保存（SQLite）
+ * @return 绑定值
+ */
+QVariant sqlTime(qint64 timestamp, bool seconds)
+{
+    // Seconds are rounded up so that inclusive starts and exclusive ends keep their meaning
+    if (seconds) {
+        return timestamp / 1000 + (timestamp % 1000 > 0 ? 1 : 0);
+    }
+    return QDateTime::fromMSecsSinceEpoch(timestamp);
+}
+
+/**
+ * @brief 把SQL时间列转换为毫秒时间
+ * @param value 列值
+ * @param seconds 是否按秒保存（SQLite）
+ * @return 时间戳（毫秒）
+ */
+qint64 fromSqlTime(const QVariant &value, bool seconds)
+{
+    return seconds ? value.toLongLong() * 1000 : value.toDateTime().toMSecsSinceEpoch();
+}
+
+/**
+ * @brief 把InfluxDB应答中的时间列转换为毫秒时间
+ * @param value 列值，毫秒整数或RFC 3339文本
+ * @return 时间戳（毫秒）
+ */
+qint64 influxTime(const QVariant &value)
+{
+    if (value.typeId() == QMetaType::QString) {
+        return QDateTime::fromString(value.toString(), Qt::ISODate).toMSecsSinceEpoch();
+    }
+    return value.toLongLong();
+}
+
+} // namespace
 
 HYTimeSeriesDatabase::HYTimeSeriesDatabase(QObject *parent) : QObject(parent),
     m_connected(false),
+    m_liveWrites(0),
     m_dbHandle(nullptr)
 {
 }
@@ -42,6 +212,9 @@ bool HYTimeSeriesDatabase::initialize(const DatabaseConfig &config)
     case SQLITE:
         m_connected = connectToSQLite();
         break;
+    case EMBEDDED:
+        m_connected = connectToEmbedded();
+        break;
     default:
         m_status = "Unsupported database type";
         return false;
@@ -68,7 +241,9 @@ void HYTimeSeriesDatabase::shutdown()
         // Clean up database-specific resources
         switch (m_config.type) {
         case INFLUXDB:
-            // InfluxDB uses HTTP, no persistent connection to close
+            // Deleting the manager closes its kept-alive connections
+            delete static_cast<QNetworkAccessManager *>(m_dbHandle);
+            m_dbHandle = nullptr;
             break;
         case TIMESCALEDB:
             // TimescaleDB uses PostgreSQL, close connection
@@ -77,6 +252,7 @@ void HYTimeSeriesDatabase::shutdown()
                 db->close();
                 delete db;
                 m_dbHandle = nullptr;
+                QSqlDatabase::removeDatabase(m_connectionName);
             }
             break;
         case SQLITE:
@@ -86,8 +262,15 @@ void HYTimeSeriesDatabase::shutdown()
                 db->close();
                 delete db;
                 m_dbHandle = nullptr;
+                QSqlDatabase::removeDatabase(m_connectionName);
             }
             break;
+        case EMBEDDED:
+            // Closing seals the open chunks into the file, after the rollup buckets still in memory
+            flushEmbeddedRollups();
+            delete static_cast<HYColumnStore *>(m_dbHandle);
+            m_dbHandle = nullptr;
+            break;
         }
 
         emit disconnected();
@@ -117,14 +300,17 @@ bool HYTimeSeriesDatabase::storeTagValue(const QString &tagName, const QVariant
         success = storeInInfluxDB(tagName, value, timestamp);
         break;
     case TIMESCALEDB:
-        success = storeInTimescaleDB(tagName, value, timestamp);
-        break;
     case SQLITE:
-        success = storeInSQLite(tagName, value, timestamp);
+        // A single value takes the batch path so that its rollups commit in the same transaction
+        success = storeSamplesInSql({TagSample{tagName, value, timestamp.toMSecsSinceEpoch()}});
+        break;
+    case EMBEDDED:
+        success = storeSamplesInEmbedded({TagSample{tagName, value, timestamp.toMSecsSinceEpoch()}});
         break;
     }
 
     if (success) {
+        ++m_liveWrites;
         emit dataStored(tagName, value);
     }
 
@@ -137,15 +323,59 @@ bool HYTimeSeriesDatabase::storeTagValues(const QMap<QString, QVariant> &tagValu
         return false;
     }
 
-    bool allSuccess = true;
+    if (tagValues.isEmpty()) {
+        return true;
+    }
 
+    const qint64 time = timestamp.toMSecsSinceEpoch();
+    QVector<TagSample> samples;
+    samples.reserve(tagValues.size());
     for (auto it = tagValues.constBegin(); it != tagValues.constEnd(); ++it) {
-        if (!storeTagValue(it.key(), it.value(), timestamp)) {
-            allSuccess = false;
-        }
+        samples.append({it.key(), it.value(), time});
+    }
+
+    if (!storeSamples(samples)) {
+        return false;
     }
 
-    return allSuccess;
+    m_liveWrites += samples.size();
+    for (const TagSample &sample : std::as_const(samples)) {
+        emit dataStored(sample.tagName, sample.value);
+    }
+
+    return true;
+}
+
+bool HYTimeSeriesDatabase::storeTagSamples(const QVector<TagSample> &samples)
+{
+    if (!m_connected) {
+        return false;
+    }
+    if (samples.isEmpty()) {
+        return true;
+    }
+
+    return storeSamples(samples);
+}
+
+bool HYTimeSeriesDatabase::storeSamples(const QVector<TagSample> &samples)
+{
+    switch (m_config.type) {
+    case INFLUXDB:
+        return storeSamplesInInfluxDB(samples);
+    case TIMESCALEDB:
+    case SQLITE:
+        return storeSamplesInSql(samples);
+    case EMBEDDED:
+        return storeSamplesInEmbedded(samples);
+    default:
+        return false;
+    }
+}
+
+quint64 HYTimeSeriesDatabase::liveWriteCount() const
+{
+    return m_liveWrites;
 }
 
 QMap<QDateTime, QVariant> HYTimeSeriesDatabase::queryTagHistory(const QString &tagName, const QDateTime &startTime, const QDateTime &endTime, int limit)
@@ -166,6 +396,9 @@ QMap<QDateTime, QVariant> HYTimeSeriesDatabase::queryTagHistory(const QString &t
     case SQLITE:
         result = queryFromSQLite(tagName, startTime, endTime, limit);
         break;
+    case EMBEDDED:
+        result = queryFromEmbedded(tagName, startTime, endTime, limit);
+        break;
     }
 
     emit dataRetrieved(tagName, result.size());
@@ -183,6 +416,67 @@ QMap<QString, QMap<QDateTime, QVariant>> HYTimeSeriesDatabase::queryMultipleTags
     return result;
 }
 
+QVector<HYTimeSeriesDatabase::TrendPoint> HYTimeSeriesDatabase::queryTagTrend(const QString &tagName, const QDateTime &startTime, const QDateTime &endTime, int points)
+{
+    QVector<TrendPoint> result;
+    if (!m_connected || startTime > endTime) {
+        return result;
+    }
+
+    const qint64 start = startTime.toMSecsSinceEpoch();
+    const qint64 end = endTime.toMSecsSinceEpoch();
+    const qint64 interval = trendInterval(end - start, points);
+    auto rawPoint = [](qint64 timestamp, double value) {
+        return TrendPoint{timestamp, value, value, value, 1, value, value};
+    };
+
+    bool ok = true;
+    if (m_config.type == INFLUXDB) {
+        if (interval > 0) {
+            result = queryTrendFromInfluxDB(tagName, startTime, endTime, interval);
+        } else {
+            const QMap<QDateTime, QVariant> history = queryFromInfluxDB(tagName, startTime, endTime, std::numeric_limits<int>::max());
+            for (auto it = history.constBegin(); it != history.constEnd(); ++it) {
+                if (isNumeric(it.value())) {
+                    result.append(rawPoint(it.key().toMSecsSinceEpoch(), it.value().toDouble()));
+                }
+            }
+        }
+    } else if (interval > 0) {
+        // The bucket holding the start is included, so the first point covers the start of the range
+        const QVector<Rollup> rollups = readRollups(tagName, interval, floorTo(start, interval), end + 1, &ok);
+        result.reserve(rollups.size());
+        for (const Rollup &rollup : rollups) {
+            result.append(TrendPoint{rollup.bucket, rollup.min, rollup.max, rollup.sum / rollup.count,
+                                     rollup.count, rollup.first, rollup.last});
+        }
+    } else {
+        const QVector<QPair<qint64, double>> samples = readNumericSamples(tagName, start, end + 1, &ok);
+        result.reserve(samples.size());
+        for (const auto &sample : samples) {
+            result.append(rawPoint(sample.first, sample.second));
+        }
+    }
+    if (!ok) {
+        result.clear();
+    }
+
+    emit dataRetrieved(tagName, result.size());
+    return result;
+}
+
+qint64 HYTimeSeriesDatabase::trendInterval(qint64 range, int points)
+{
+    // The coarsest interval that still yields the requested number of points
+    const qint64 required = qMax(points, 1);
+    for (int i = int(std::size(RollupIntervals)) - 1; i >= 0; --i) {
+        if (range / RollupIntervals[i] >= required) {
+            return RollupIntervals[i];
+        }
+    }
+    return 0;
+}
+
 bool HYTimeSeriesDatabase::createDatabase()
 {
     if (!m_connected) {
@@ -206,6 +500,9 @@ bool HYTimeSeriesDatabase::createDatabase()
     case SQLITE:
         // SQLite creates databases automatically
         return true;
+    case EMBEDDED:
+        // The store file is created when it is opened
+        return true;
     default:
         return false;
     }
@@ -240,6 +537,33 @@ bool HYTimeSeriesDatabase::createTable()
                 qDebug() << "Failed to create table:" << query.lastError().text();
                 return false;
             }
+
+            // Rebuilding a rollup bucket reads one tag's rows for a time range
+            sql = QString("CREATE INDEX IF NOT EXISTS %1_tag_time ON %1 (tag_name, timestamp)").arg(m_config.tableName);
+            if (!query.exec(sql)) {
+                qDebug() << "Failed to create index:" << query.lastError().text();
+                return false;
+            }
+
+            // Rollups are small, so they stay a regular table
+            sql = QString(
+                "CREATE TABLE IF NOT EXISTS %1 ("
+                "resolution INTEGER NOT NULL, "
+                "tag_name TEXT NOT NULL, "
+                "bucket TIMESTAMP NOT NULL, "
+                "min_value DOUBLE PRECISION, "
+                "max_value DOUBLE PRECISION, "
+                "sum_value DOUBLE PRECISION, "
+                "sample_count BIGINT NOT NULL, "
+                "first_value DOUBLE PRECISION, "
+                "last_value DOUBLE PRECISION, "
+                "PRIMARY KEY (resolution, tag_name, bucket)"
+                ")").arg(rollupTable());
+
+            if (!query.exec(sql)) {
+                qDebug() << "Failed to create rollup table:" << query.lastError().text();
+                return false;
+            }
             
             // Convert to hypertable for TimescaleDB
             sql = QString("SELECT create_hypertable('%1', 'timestamp')").arg(m_config.tableName);
@@ -260,9 +584,36 @@ bool HYTimeSeriesDatabase::createTable()
                 "PRIMARY KEY (timestamp, tag_name)" 
                 ")").arg(m_config.tableName);
             
+            if (!query.exec(sql)) {
+                return false;
+            }
+
+            // Rebuilding a rollup bucket reads one tag's rows for a time range
+            sql = QString("CREATE INDEX IF NOT EXISTS %1_tag_time ON %1 (tag_name, timestamp)").arg(m_config.tableName);
+            if (!query.exec(sql)) {
+                return false;
+            }
+
+            sql = QString(
+                "CREATE TABLE IF NOT EXISTS %1 ("
+                "resolution INTEGER NOT NULL, "
+                "tag_name TEXT NOT NULL, "
+                "bucket INTEGER NOT NULL, "
+                "min_value REAL, "
+                "max_value REAL, "
+                "sum_value REAL, "
+                "sample_count INTEGER NOT NULL, "
+                "first_value REAL, "
+                "last_value REAL, "
+                "PRIMARY KEY (resolution, tag_name, bucket)"
+                ")").arg(rollupTable());
+
             return query.exec(sql);
         }
         return false;
+    case EMBEDDED:
+        // Chunks are self-describing; there is no schema to create
+        return m_dbHandle != nullptr;
     default:
         return false;
     }
@@ -291,6 +642,16 @@ bool HYTimeSeriesDatabase::clearData(const QString &tagName)
                 sql = QString("DELETE FROM %1 WHERE tag_name = '%2'").arg(m_config.tableName).arg(tagName);
             }
             
+            if (!query.exec(sql)) {
+                return false;
+            }
+
+            if (tagName.isEmpty()) {
+                sql = QString("DELETE FROM %1").arg(rollupTable());
+            } else {
+                sql = QString("DELETE FROM %1 WHERE tag_name = '%2'").arg(rollupTable()).arg(tagName);
+            }
+
             return query.exec(sql);
         }
         return false;
@@ -306,23 +667,80 @@ bool HYTimeSeriesDatabase::clearData(const QString &tagName)
                 sql = QString("DELETE FROM %1 WHERE tag_name = '%2'").arg(m_config.tableName).arg(tagName);
             }
             
+            if (!query.exec(sql)) {
+                return false;
+            }
+
+            if (tagName.isEmpty()) {
+                sql = QString("DELETE FROM %1").arg(rollupTable());
+            } else {
+                sql = QString("DELETE FROM %1 WHERE tag_name = '%2'").arg(rollupTable()).arg(tagName);
+            }
+
             return query.exec(sql);
         }
         return false;
+    case EMBEDDED:
+        if (m_dbHandle) {
+            HYColumnStore *store = static_cast<HYColumnStore *>(m_dbHandle);
+            if (!store->clear(tagName)) {
+                return false;
+            }
+            if (tagName.isEmpty()) {
+                m_openRollups.clear();
+                return true;
+            }
+            // A tag's rollups live in their own series next to it
+            bool success = true;
+            for (qint64 interval : RollupIntervals) {
+                m_openRollups.remove(qMakePair(tagName, interval));
+                for (int field = 0; field < RollupFieldCount; ++field) {
+                    success = store->clear(rollupSeries(tagName, interval, field)) && success;
+                }
+            }
+            return success;
+        }
+        return false;
     default:
         return false;
     }
 }
 
+QString HYTimeSeriesDatabase::connectionName()
+{
+    // Each instance has its own connection, so a writer thread can hold one next to the GUI thread's
+    m_connectionName = QStringLiteral("huayan.timeseries.%1").arg(quintptr(this), 0, 16);
+    return m_connectionName;
+}
+
 bool HYTimeSeriesDatabase::connectToInfluxDB()
 {
-    // InfluxDB uses HTTP API, no persistent connection
-    // Just validate configuration
+    // InfluxDB uses HTTP API; one manager per instance keeps its connections alive between requests
     if (m_config.host.isEmpty() || m_config.port <= 0) {
         m_status = "Invalid InfluxDB configuration";
         return false;
     }
 
+    QNetworkAccessManager *manager = new QNetworkAccessManager();
+    m_dbHandle = manager;
+
+    // The ping checks the server and opens the connection that later requests reuse
+    QNetworkReply *reply = manager->get(influxRequest("/ping", QByteArray()));
+    QEventLoop loop;
+    connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
+    loop.exec();
+
+    const bool reachable = reply->error() == QNetworkReply::NoError;
+    if (!reachable) {
+        m_status = "Failed to connect to InfluxDB: " + reply->errorString();
+    }
+    delete reply;
+    if (!reachable) {
+        delete manager;
+        m_dbHandle = nullptr;
+        return false;
+    }
+
     m_status = "Connected to InfluxDB";
     return true;
 }
@@ -330,7 +748,7 @@ bool HYTimeSeriesDatabase::connectToInfluxDB()
 bool HYTimeSeriesDatabase::connectToTimescaleDB()
 {
     // TimescaleDB uses PostgreSQL
-    QSqlDatabase *db = new QSqlDatabase(QSqlDatabase::addDatabase("QPSQL"));
+    QSqlDatabase *db = new QSqlDatabase(QSqlDatabase::addDatabase("QPSQL", connectionName()));
     db->setHostName(m_config.host);
     db->setPort(m_config.port);
     db->setDatabaseName(m_config.database);
@@ -340,6 +758,7 @@ bool HYTimeSeriesDatabase::connectToTimescaleDB()
     if (!db->open()) {
         m_status = "Failed to connect to TimescaleDB: " + db->lastError().text();
         delete db;
+        QSqlDatabase::removeDatabase(m_connectionName);
         return false;
     }
 
@@ -352,12 +771,13 @@ bool HYTimeSeriesDatabase::connectToSQLite()
 {
     // SQLite uses local file
     QString dbPath = m_config.host.isEmpty() ? m_config.database : m_config.host;
-    QSqlDatabase *db = new QSqlDatabase(QSqlDatabase::addDatabase("QSQLITE"));
+    QSqlDatabase *db = new QSqlDatabase(QSqlDatabase::addDatabase("QSQLITE", connectionName()));
     db->setDatabaseName(dbPath);
 
     if (!db->open()) {
         m_status = "Failed to connect to SQLite: " + db->lastError().text();
         delete db;
+        QSqlDatabase::removeDatabase(m_connectionName);
         return false;
     }
 
@@ -366,177 +786,363 @@ bool HYTimeSeriesDatabase::connectToSQLite()
     return true;
 }
 
+bool HYTimeSeriesDatabase::connectToEmbedded()
+{
+    // The embedded store is a single local file, like SQLite
+    QString storePath = m_config.host.isEmpty() ? m_config.database : m_config.host;
+    HYColumnStore *store = new HYColumnStore();
+    QString error;
+
+    if (!store->open(storePath, &error)) {
+        m_status = "Failed to open embedded store: " + error;
+        delete store;
+        return false;
+    }
+
+    m_dbHandle = store;
+    m_status = "Connected to embedded store";
+    return true;
+}
+
 bool HYTimeSeriesDatabase::storeInInfluxDB(const QString &tagName, const QVariant &value, const QDateTime &timestamp)
 {
-    // Use HTTP API to write data to InfluxDB
-    QNetworkAccessManager *manager = new QNetworkAccessManager(this);
-    QUrl url(QString("http://%1:%2/write?db=%3&u=%4&p=%5")
-             .arg(m_config.host)
-             .arg(m_config.port)
-             .arg(m_config.database)
-             .arg(m_config.username)
-             .arg(m_config.password));
+    return postToInfluxDB({influxLine(tagName, value, timestamp.toMSecsSinceEpoch()).toUtf8()});
+}
+
+QString HYTimeSeriesDatabase::influxLine(const QString &tagName, const QVariant &value, qint64 timestamp) const
+{
+    // Format data in InfluxDB line protocol
+    if (isNumeric(value)) {
+        return QString("%1,tag=%2 value=%3 %4")
+               .arg(m_config.tableName)
+               .arg(tagName)
+               .arg(value.toString())
+               .arg(timestamp * 1000000); // Nanoseconds
+    }
+    return QString("%1,tag=%2 value=\"%3\" %4")
+           .arg(m_config.tableName)
+           .arg(tagName)
+           .arg(value.toString().replace('"', QString("\\\"")))
+           .arg(timestamp * 1000000);
+}
 
+QNetworkRequest HYTimeSeriesDatabase::influxRequest(const QString &path, const QByteArray &query) const
+{
+    QUrl url;
+    url.setScheme("http");
+    url.setHost(m_config.host);
+    url.setPort(m_config.port);
+    url.setPath(path);
+    const QByteArray database = "db=" + QUrl::toPercentEncoding(m_config.database);
+    url.setQuery(QString::fromLatin1(query.isEmpty() ? database : database + '&' + query), QUrl::TolerantMode);
+
+    // Credentials go in a header so they never appear in URLs, proxies or server logs
     QNetworkRequest request(url);
-    request.setHeader(QNetworkRequest::ContentTypeHeader, "text/plain");
+    if (!m_config.username.isEmpty()) {
+        request.setRawHeader("Authorization",
+                             "Basic " + (m_config.username + ':' + m_config.password).toUtf8().toBase64());
+    }
+    request.setAttribute(QNetworkRequest::HttpPipeliningAllowedAttribute, true);
+    return request;
+}
 
-    // Format data in InfluxDB line protocol
-    QString lineProtocol;
-    if (value.typeId() == QMetaType::Double || value.typeId() == QMetaType::Int) {
-        lineProtocol = QString("%1,tag=%2 value=%3 %4")
-                       .arg(m_config.tableName)
-                       .arg(tagName)
-                       .arg(value.toString())
-                       .arg(timestamp.toMSecsSinceEpoch() * 1000000); // Nanoseconds
-    } else {
-        lineProtocol = QString("%1,tag=%2 value=\"%3\" %4")
-                       .arg(m_config.tableName)
-                       .arg(tagName)
-                       .arg(value.toString().replace('"', QString("\\\"")))
-                       .arg(timestamp.toMSecsSinceEpoch() * 1000000);
+bool HYTimeSeriesDatabase::postToInfluxDB(const QVector<QByteArray> &bodies)
+{
+    QNetworkAccessManager *manager = static_cast<QNetworkAccessManager *>(m_dbHandle);
+    if (!manager) {
+        return false;
     }
 
-    QNetworkReply *reply = manager->post(request, lineProtocol.toUtf8());
+    // All requests are in flight together; the manager spreads them over its kept-alive connections
+    QList<QNetworkReply *> replies;
+    for (const QByteArray &body : bodies) {
+        QNetworkRequest request = influxRequest("/write", QByteArray());
+        request.setHeader(QNetworkRequest::ContentTypeHeader, "text/plain; charset=utf-8");
+        if (m_config.compression && body.size() >= GzipMinBytes) {
+            request.setRawHeader("Content-Encoding", "gzip");
+            replies.append(manager->post(request, gzipCompress(body)));
+        } else {
+            replies.append(manager->post(request, body));
+        }
+    }
 
-    // Wait for reply (synchronous for simplicity)
+    // Wait for replies (synchronous for simplicity)
     QEventLoop loop;
-    connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
-    loop.exec();
-
-    bool success = (reply->error() == QNetworkReply::NoError);
-    reply->deleteLater();
-    manager->deleteLater();
+    int pending = int(replies.size());
+    for (QNetworkReply *reply : replies) {
+        connect(reply, &QNetworkReply::finished, &loop, [&loop, &pending] {
+            if (--pending == 0) {
+                loop.quit();
+            }
+        });
+    }
+    if (pending > 0) {
+        loop.exec();
+    }
 
+    bool success = true;
+    for (QNetworkReply *reply : replies) {
+        success = success && reply->error() == QNetworkReply::NoError;
+        reply->deleteLater();
+    }
     return success;
 }
 
-bool HYTimeSeriesDatabase::storeInTimescaleDB(const QString &tagName, const QVariant &value, const QDateTime &timestamp)
+bool HYTimeSeriesDatabase::storeSamplesInInfluxDB(const QVector<TagSample> &samples)
+{
+    // Each request carries up to batchSize lines; points with the same series and time overwrite each other
+    const int linesPerRequest = m_config.batchSize > 0 ? m_config.batchSize : int(samples.size());
+    QVector<QByteArray> bodies;
+    QByteArray lines;
+    int pending = 0;
+
+    for (const TagSample &sample : samples) {
+        lines.append(influxLine(sample.tagName, sample.value, sample.timestamp).toUtf8());
+        lines.append('\n');
+        if (++pending == linesPerRequest) {
+            bodies.append(lines);
+            lines.clear();
+            pending = 0;
+        }
+    }
+    if (pending > 0) {
+        bodies.append(lines);
+    }
+
+    return bodies.isEmpty() || postToInfluxDB(bodies);
+}
+
+bool HYTimeSeriesDatabase::storeSamplesInSql(const QVector<TagSample> &samples)
 {
     if (!m_dbHandle) {
         return false;
     }
 
     QSqlDatabase *db = static_cast<QSqlDatabase *>(m_dbHandle);
-    QSqlQuery query(*db);
+    const bool sqlite = m_config.type == SQLITE;
+
+    // PostgreSQL rejects a statement that upserts the same row twice, so only the last value per row is kept
+    QVector<const TagSample *> rows;
+    rows.reserve(samples.size());
+    if (sqlite) {
+        for (const TagSample &sample : samples) {
+            rows.append(&sample);
+        }
+    } else {
+        QHash<QPair<QString, qint64>, qsizetype> positions;
+        for (const TagSample &sample : samples) {
+            const auto key = qMakePair(sample.tagName, sample.timestamp);
+            const auto it = positions.constFind(key);
+            if (it != positions.cend()) {
+                rows[*it] = &sample;
+            } else {
+                positions.insert(key, rows.size());
+                rows.append(&sample);
+            }
+        }
+    }
 
-    QString sql = QString(
-        "INSERT INTO %1 (timestamp, tag_name, value, value_text) "
-        "VALUES (:timestamp, :tag_name, :value, :value_text) "
-        "ON CONFLICT (timestamp, tag_name) DO UPDATE SET "
-        "value = :value, value_text = :value_text"
-    ).arg(m_config.tableName);
+    // Bound parameters per statement are limited to 32766 by SQLite and 65535 by PostgreSQL
+    const int maxRows = (sqlite ? 32766 : 65535) / 4;
+    const int rowsPerStatement = m_config.batchSize > 0 ? qMin(m_config.batchSize, maxRows) : maxRows;
+    auto insertStatement = [this](int count) {
+        QString sql = QString("INSERT INTO %1 (timestamp, tag_name, value, value_text) VALUES ").arg(m_config.tableName);
+        sql.reserve(sql.size() + count * 15 + 100);
+        for (int i = 0; i < count; ++i) {
+            sql += i ? QStringLiteral(", (?, ?, ?, ?)") : QStringLiteral("(?, ?, ?, ?)");
+        }
+        // A repeated batch overwrites the rows it already wrote
+        sql += " ON CONFLICT (timestamp, tag_name) DO UPDATE SET "
+               "value = excluded.value, value_text = excluded.value_text";
+        return sql;
+    };
 
-    query.prepare(sql);
-    query.bindValue(":timestamp", timestamp);
-    query.bindValue(":tag_name", tagName);
+    if (!db->transaction()) {
+        return false;
+    }
 
-    if (value.typeId() == QMetaType::Double || value.typeId() == QMetaType::Int) {
-        query.bindValue(":value", value.toDouble());
-        query.bindValue(":value_text", QVariant(QString()));
-    } else {
-        query.bindValue(":value", QVariant(0.0));
-        query.bindValue(":value_text", value.toString());
+    // Full statements share one prepared query; the remainder gets its own
+    QSqlQuery query(*db);
+    int preparedRows = 0;
+    for (qsizetype offset = 0; offset < rows.size(); offset += rowsPerStatement) {
+        const int count = int(qMin<qsizetype>(rowsPerStatement, rows.size() - offset));
+        if (count != preparedRows) {
+            query.prepare(insertStatement(count));
+            preparedRows = count;
+        }
+        for (int i = 0; i < count; ++i) {
+            const TagSample &sample = *rows[offset + i];
+            const int column = i * 4;
+            if (sqlite) {
+                query.bindValue(column, sample.timestamp / 1000); // Unix timestamp in seconds
+            } else {
+                query.bindValue(column, QDateTime::fromMSecsSinceEpoch(sample.timestamp));
+            }
+            query.bindValue(column + 1, sample.tagName);
+            if (isNumeric(sample.value)) {
+                query.bindValue(column + 2, sample.value.toDouble());
+                query.bindValue(column + 3, QVariant(QString()));
+            } else {
+                query.bindValue(column + 2, QVariant(0.0));
+                query.bindValue(column + 3, sample.value.toString());
+            }
+        }
+        if (!query.exec()) {
+            qDebug() << "Failed to store samples:" << query.lastError().text();
+            db->rollback();
+            return false;
+        }
+    }
+
+    // Rollups are updated in the same transaction, so they never disagree with the raw rows
+    if (!updateRollups(samples)) {
+        db->rollback();
+        return false;
     }
 
-    return query.exec();
+    return db->commit();
 }
 
-bool HYTimeSeriesDatabase::storeInSQLite(const QString &tagName, const QVariant &value, const QDateTime &timestamp)
+bool HYTimeSeriesDatabase::storeSamplesInEmbedded(const QVector<TagSample> &samples)
 {
     if (!m_dbHandle) {
         return false;
     }
 
-    QSqlDatabase *db = static_cast<QSqlDatabase *>(m_dbHandle);
-    QSqlQuery query(*db);
-
-    QString sql = QString(
-        "INSERT INTO %1 (timestamp, tag_name, value, value_text) "
-        "VALUES (:timestamp, :tag_name, :value, :value_text) "
-        "ON CONFLICT (timestamp, tag_name) DO UPDATE SET "
-        "value = :value, value_text = :value_text"
-    ).arg(m_config.tableName);
-
-    query.prepare(sql);
-    query.bindValue(":timestamp", timestamp.toMSecsSinceEpoch() / 1000); // Unix timestamp in seconds
-    query.bindValue(":tag_name", tagName);
-
-    if (value.typeId() == QMetaType::Double || value.typeId() == QMetaType::Int) {
-        query.bindValue(":value", value.toDouble());
-        query.bindValue(":value_text", QVariant(QString()));
-    } else {
-        query.bindValue(":value", QVariant(0.0));
-        query.bindValue(":value_text", value.toString());
+    // Columns are per tag, so the batch is split by tag keeping each tag's order
+    QHash<QString, QVector<HYColumnStore::Sample>> columns;
+    for (const TagSample &sample : samples) {
+        columns[sample.tagName].append(HYColumnStore::Sample{sample.timestamp, sample.value});
     }
 
-    return query.exec();
+    HYColumnStore *store = static_cast<HYColumnStore *>(m_dbHandle);
+    bool success = true;
+    for (auto it = columns.cbegin(); it != columns.cend(); ++it) {
+        success = store->append(it.key(), it.value()) && success;
+    }
+    return success && updateRollups(samples);
 }
 
 QMap<QDateTime, QVariant> HYTimeSeriesDatabase::queryFromInfluxDB(const QString &tagName, const QDateTime &startTime, const QDateTime &endTime, int limit)
 {
     QMap<QDateTime, QVariant> result;
 
-    // Use HTTP API to query data from InfluxDB
-    QNetworkAccessManager *manager = new QNetworkAccessManager(this);
-    QUrl url(QString("http://%1:%2/query?db=%3&u=%4&p=%5&q=%6")
-             .arg(m_config.host)
-             .arg(m_config.port)
-             .arg(m_config.database)
-             .arg(m_config.username)
-             .arg(m_config.password)
-             .arg(QUrl::toPercentEncoding(QString(
-                 "SELECT value FROM %1 WHERE tag='%2' AND time >= '%3' AND time <= '%4' ORDER BY time DESC LIMIT %5"
-                 ).arg(m_config.tableName)
-                 .arg(tagName)
-                 .arg(startTime.toString(Qt::ISODate))
-                 .arg(endTime.toString(Qt::ISODate))
-                 .arg(limit))));
+    const QString statement = QString(
+        "SELECT value FROM %1 WHERE tag='%2' AND time >= '%3' AND time <= '%4' ORDER BY time DESC LIMIT %5"
+        ).arg(m_config.tableName)
+        .arg(tagName)
+        .arg(startTime.toString(Qt::ISODate))
+        .arg(endTime.toString(Qt::ISODate))
+        .arg(limit);
+    const bool ok = queryInfluxRows(statement, [&result](const QVariantList &row) {
+        if (row.size() < 2) {
+            return;
+        }
+        const QDateTime time = QDateTime::fromMSecsSinceEpoch(influxTime(row.at(0)));
+        switch (row.at(1).typeId()) {
+        case QMetaType::LongLong:
+        case QMetaType::Double:
+            result[time] = row.at(1).toDouble();
+            break;
+        case QMetaType::QString:
+            result[time] = row.at(1);
+            break;
+        default:
+            break;
+        }
+    });
 
-    QNetworkRequest request(url);
-    QNetworkReply *reply = manager->get(request);
+    // A truncated or malformed body yields nothing rather than a partial history
+    if (!ok) {
+        result.clear();
+    }
+    return result;
+}
+
+bool HYTimeSeriesDatabase::queryInfluxRows(const QString &statement, const std::function<void(const QVariantList &)> &row)
+{
+    QNetworkAccessManager *manager = static_cast<QNetworkAccessManager *>(m_dbHandle);
+    if (!manager) {
+        return false;
+    }
+
+    // Use HTTP API to query data from InfluxDB; epoch=ms returns times as integers instead of RFC 3339 text
+    QNetworkReply *reply = manager->get(influxRequest("/query", "epoch=ms&q=" + QUrl::toPercentEncoding(statement)));
+
+    // Rows are decoded as the body arrives, so the whole response is never held in memory
+    HYJsonStreamReader reader;
+    bool valuesNext = false;
+    int valuesDepth = -1;
+    QVariantList values;
+    auto consume = [&] {
+        reader.addData(reply->readAll());
+        for (;;) {
+            const HYJsonStreamReader::TokenType token = reader.readNext();
+            if (token == HYJsonStreamReader::Incomplete || token == HYJsonStreamReader::Invalid) {
+                return;
+            }
+            if (valuesDepth < 0) {
+                // Each series carries its rows as "values": [[time, value], ...]
+                if (token == HYJsonStreamReader::StartArray && valuesNext) {
+                    valuesDepth = reader.depth();
+                }
+                valuesNext = token == HYJsonStreamReader::Name && reader.text() == "values";
+                continue;
+            }
+
+            const int depth = reader.depth();
+            if (depth < valuesDepth) {
+                valuesDepth = -1;
+            } else if (token == HYJsonStreamReader::StartArray && depth == valuesDepth + 1) {
+                values.clear();
+            } else if (token == HYJsonStreamReader::EndArray && depth == valuesDepth) {
+                row(values);
+            } else if (depth == valuesDepth + 1 && token != HYJsonStreamReader::EndArray
+                       && token != HYJsonStreamReader::StartObject && token != HYJsonStreamReader::EndObject) {
+                values.append(reader.value());
+            }
+        }
+    };
+    connect(reply, &QNetworkReply::readyRead, reply, consume);
 
     // Wait for reply (synchronous for simplicity)
     QEventLoop loop;
     connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
     loop.exec();
 
-    if (reply->error() == QNetworkReply::NoError) {
-        QJsonDocument doc = QJsonDocument::fromJson(reply->readAll());
-        if (doc.isObject()) {
-            QJsonObject root = doc.object();
-            if (root.contains("results")) {
-                QJsonArray results = root["results"].toArray();
-                if (!results.isEmpty()) {
-                    QJsonObject resultObj = results[0].toObject();
-                    if (resultObj.contains("series")) {
-                        QJsonArray series = resultObj["series"].toArray();
-                        if (!series.isEmpty()) {
-                            QJsonObject seriesObj = series[0].toObject();
-                            if (seriesObj.contains("values")) {
-                                QJsonArray values = seriesObj["values"].toArray();
-                                for (const QJsonValue &value : values) {
-                                    QJsonArray valueArray = value.toArray();
-                                    if (valueArray.size() >= 2) {
-                                        QString timeStr = valueArray[0].toString();
-                                        QDateTime time = QDateTime::fromString(timeStr, Qt::ISODate);
-                                        QJsonValue val = valueArray[1];
-                                        if (val.isDouble()) {
-                                            result[time] = val.toDouble();
-                                        } else if (val.isString()) {
-                                            result[time] = val.toString();
-                                        }
-                                    }
-                                }
-                            }
-                        }
-                    }
-                }
-            }
-        }
-    }
+    consume();
+    reader.finish();
+    const bool success = reply->error() == QNetworkReply::NoError && reader.atEnd();
 
     reply->deleteLater();
-    manager->deleteLater();
+    return success;
+}
+
+QVector<HYTimeSeriesDatabase::TrendPoint> HYTimeSeriesDatabase::queryTrendFromInfluxDB(const QString &tagName, const QDateTime &startTime, const QDateTime &endTime, qint64 interval)
+{
+    QVector<TrendPoint> result;
+
+    // InfluxDB aggregates on the server, so only one row per interval crosses the network
+    const QString statement = QString(
+        "SELECT min(value), max(value), mean(value), count(value), first(value), last(value) FROM %1 "
+        "WHERE tag='%2' AND time >= '%3' AND time <= '%4' GROUP BY time(%5s) fill(none)"
+        ).arg(m_config.tableName)
+        .arg(tagName)
+        .arg(startTime.toString(Qt::ISODate))
+        .arg(endTime.toString(Qt::ISODate))
+        .arg(interval / 1000);
+    const bool ok = queryInfluxRows(statement, [&result](const QVariantList &row) {
+        if (row.size() < 7 || row.at(4).toLongLong() <= 0) {
+            return;
+        }
+        result.append(TrendPoint{influxTime(row.at(0)), row.at(1).toDouble(), row.at(2).toDouble(),
+                                 row.at(3).toDouble(), row.at(4).toLongLong(), row.at(5).toDouble(),
+                                 row.at(6).toDouble()});
+    });
+
+    if (!ok) {
+        result.clear();
+    }
     return result;
 }
 
@@ -622,3 +1228,385 @@ QMap<QDateTime, QVariant> HYTimeSeriesDatabase::queryFromSQLite(const QString &t
 
     return result;
 }
+
+QMap<QDateTime, QVariant> HYTimeSeriesDatabase::queryFromEmbedded(const QString &tagName, const QDateTime &startTime, const QDateTime &endTime, int limit)
+{
+    QMap<QDateTime, QVariant> result;
+
+    if (!m_dbHandle) {
+        return result;
+    }
+
+    HYColumnStore *store = static_cast<HYColumnStore *>(m_dbHandle);
+    const QVector<HYColumnStore::Sample> samples = store->query(tagName, startTime.toMSecsSinceEpoch(),
+                                                                endTime.toMSecsSinceEpoch(), limit);
+    for (const HYColumnStore::Sample &sample : samples) {
+        result.insert(QDateTime::fromMSecsSinceEpoch(sample.timestamp), sample.value);
+    }
+
+    return result;
+}
+
+bool HYTimeSeriesDatabase::updateRollups(const QVector<TagSample> &samples)
+{
+    // Touched buckets are rebuilt from the stored data, so writing the same batch again leaves them unchanged;
+    // finer levels go first because each coarser level is rebuilt from the one below
+    for (qint64 interval : RollupIntervals) {
+        const QVector<QPair<QString, qint64>> buckets = touchedBuckets(samples, interval);
+        if (buckets.isEmpty()) {
+            return true;
+        }
+        const bool success = m_config.type == EMBEDDED ? rebuildEmbeddedRollups(interval, buckets)
+                                                       : rebuildSqlRollups(interval, buckets);
+        if (!success) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool HYTimeSeriesDatabase::rebuildSqlRollups(qint64 interval, const QVector<QPair<QString, qint64>> &buckets)
+{
+    if (!m_dbHandle) {
+        return false;
+    }
+
+    QSqlDatabase *db = static_cast<QSqlDatabase *>(m_dbHandle);
+    const bool sqlite = m_config.type == SQLITE;
+    const QString table = rollupTable();
+    const QString bucketType = sqlite ? "INTEGER" : "TIMESTAMP";
+    const qint64 finer = finerInterval(interval);
+
+    // The finest level is computed from the raw rows, coarser levels from the level below
+    QString source;
+    QString select;
+    if (!finer) {
+        source = QString("FROM %1 WHERE tag_name = ? AND timestamp >= ? AND timestamp < ? "
+                         "AND (value_text IS NULL OR value_text = '')").arg(m_config.tableName);
+        select = QString("MIN(value), MAX(value), SUM(value), COUNT(*), "
+                         "(SELECT value %1 ORDER BY timestamp ASC LIMIT 1), "
+                         "(SELECT value %1 ORDER BY timestamp DESC LIMIT 1) ").arg(source);
+    } else {
+        source = QString("FROM %1 WHERE resolution = ? AND tag_name = ? AND bucket >= ? AND bucket < ?").arg(table);
+        select = QString("MIN(min_value), MAX(max_value), SUM(sum_value), SUM(sample_count), "
+                         "(SELECT first_value %1 ORDER BY bucket ASC LIMIT 1), "
+                         "(SELECT last_value %1 ORDER BY bucket DESC LIMIT 1) ").arg(source);
+    }
+
+    // A bucket left without numeric values has no row, so the old row is deleted rather than updated
+    QSqlQuery remove(*db);
+    remove.prepare(QString("DELETE FROM %1 WHERE resolution = ? AND tag_name = ? AND bucket = ?").arg(table));
+    QSqlQuery insert(*db);
+    insert.prepare(QString(
+        "INSERT INTO %1 (resolution, tag_name, bucket, min_value, max_value, sum_value, "
+        "sample_count, first_value, last_value) "
+        "SELECT CAST(? AS INTEGER), tag_name, CAST(? AS %2), %3%4 GROUP BY tag_name"
+    ).arg(table, bucketType, select, source));
+
+    for (const auto &bucket : buckets) {
+        const QVariant start = sqlTime(bucket.second, sqlite);
+        const QVariant end = sqlTime(bucket.second + interval, sqlite);
+
+        remove.bindValue(0, interval / 1000);
+        remove.bindValue(1, bucket.first);
+        remove.bindValue(2, start);
+
+        // The range is bound once for each of the two subqueries and once for the aggregate
+        int column = 0;
+        insert.bindValue(column++, interval / 1000);
+        insert.bindValue(column++, start);
+        for (int i = 0; i < 3; ++i) {
+            if (finer) {
+                insert.bindValue(column++, finer / 1000);
+            }
+            insert.bindValue(column++, bucket.first);
+            insert.bindValue(column++, start);
+            insert.bindValue(column++, end);
+        }
+
+        if (!remove.exec() || !insert.exec()) {
+            qDebug() << "Failed to rebuild rollups:" << remove.lastError().text() << insert.lastError().text();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool HYTimeSeriesDatabase::rebuildEmbeddedRollups(qint64 interval, const QVector<QPair<QString, qint64>> &buckets)
+{
+    if (!m_dbHandle) {
+        return false;
+    }
+
+    // The bucket being filled stays in memory and is appended once when a later bucket starts,
+    // so in-order data never rewrites a stored time
+    bool success = true;
+    for (const auto &bucket : buckets) {
+        bool ok = true;
+        Rollup rollup;
+        if (!finerInterval(interval)) {
+            rollup = aggregateSamples(readNumericSamples(bucket.first, bucket.second, bucket.second + interval, &ok));
+        } else {
+            rollup = mergeRollups(readRollups(bucket.first, finerInterval(interval), bucket.second,
+                                              bucket.second + interval, &ok));
+        }
+        if (!ok) {
+            success = false;
+            continue;
+        }
+        rollup.tagName = bucket.first;
+        rollup.bucket = bucket.second;
+
+        Rollup &open = m_openRollups[qMakePair(bucket.first, interval)];
+        if (open.count > 0 && bucket.second > open.bucket) {
+            success = writeEmbeddedRollup(interval, open) && success;
+            open = Rollup();
+        }
+        if (rollup.count == 0) {
+            // A bucket left without numbers is dropped, and written as zero count if the store already has it
+            if (open.count > 0 && open.bucket == bucket.second) {
+                open = Rollup();
+            }
+            if (!readStoredRollups(bucket.first, interval, bucket.second, bucket.second + 1).isEmpty()) {
+                success = writeEmbeddedRollup(interval, rollup) && success;
+            }
+        } else if (open.count > 0 && bucket.second < open.bucket) {
+            // Late data for a bucket already written goes straight back to the store
+            success = writeEmbeddedRollup(interval, rollup) && success;
+        } else {
+            open = rollup;
+        }
+    }
+    return success;
+}
+
+bool HYTimeSeriesDatabase::writeEmbeddedRollup(qint64 interval, const Rollup &rollup)
+{
+    HYColumnStore *store = static_cast<HYColumnStore *>(m_dbHandle);
+    if (!store) {
+        return false;
+    }
+
+    const double values[RollupFieldCount] = {rollup.min, rollup.max, rollup.sum, double(rollup.count), rollup.first,
+                                             rollup.last};
+    bool success = true;
+    for (int field = 0; field < RollupFieldCount; ++field) {
+        success = store->append(rollupSeries(rollup.tagName, interval, field),
+                                {HYColumnStore::Sample{rollup.bucket, values[field]}}) && success;
+    }
+    return success;
+}
+
+bool HYTimeSeriesDatabase::flushEmbeddedRollups()
+{
+    bool success = true;
+    for (auto it = m_openRollups.cbegin(); it != m_openRollups.cend(); ++it) {
+        if (it->count > 0) {
+            success = writeEmbeddedRollup(it.key().second, *it) && success;
+        }
+    }
+    m_openRollups.clear();
+    return success;
+}
+
+QVector<QPair<qint64, double>> HYTimeSeriesDatabase::readNumericSamples(const QString &tagName, qint64 start, qint64 end, bool *ok)
+{
+    QVector<QPair<qint64, double>> samples;
+    *ok = m_dbHandle != nullptr;
+    if (!*ok) {
+        return samples;
+    }
+
+    if (m_config.type == EMBEDDED) {
+        // Numbers read back as double; text values are left out of the statistics
+        HYColumnStore *store = static_cast<HYColumnStore *>(m_dbHandle);
+        const QVector<HYColumnStore::Sample> stored = store->query(tagName, start, end - 1);
+        samples.reserve(stored.size());
+        for (const HYColumnStore::Sample &sample : stored) {
+            if (sample.value.typeId() == QMetaType::Double) {
+                samples.append(qMakePair(sample.timestamp, sample.value.toDouble()));
+            }
+        }
+        return samples;
+    }
+
+    const bool sqlite = m_config.type == SQLITE;
+    QSqlQuery query(*static_cast<QSqlDatabase *>(m_dbHandle));
+    query.prepare(QString(
+        "SELECT timestamp, value FROM %1 "
+        "WHERE tag_name = ? AND timestamp >= ? AND timestamp < ? AND (value_text IS NULL OR value_text = '') "
+        "ORDER BY timestamp ASC"
+    ).arg(m_config.tableName));
+    query.bindValue(0, tagName);
+    query.bindValue(1, sqlTime(start, sqlite));
+    query.bindValue(2, sqlTime(end, sqlite));
+
+    if (!query.exec()) {
+        qDebug() << "Failed to read samples:" << query.lastError().text();
+        *ok = false;
+        return samples;
+    }
+    while (query.next()) {
+        samples.append(qMakePair(fromSqlTime(query.value(0), sqlite), query.value(1).toDouble()));
+    }
+    return samples;
+}
+
+QVector<HYTimeSeriesDatabase::Rollup> HYTimeSeriesDatabase::readRollups(const QString &tagName, qint64 interval, qint64 start, qint64 end, bool *ok)
+{
+    QVector<Rollup> rollups;
+    *ok = m_dbHandle != nullptr;
+    if (!*ok) {
+        return rollups;
+    }
+
+    if (m_config.type == EMBEDDED) {
+        // The bucket still in memory is newer than what the store holds for it
+        rollups = readStoredRollups(tagName, interval, start, end);
+        const auto open = m_openRollups.constFind(qMakePair(tagName, interval));
+        if (open != m_openRollups.cend() && open->count > 0 && open->bucket >= start && open->bucket < end) {
+            auto it = std::lower_bound(rollups.begin(), rollups.end(), open->bucket,
+                                       [](const Rollup &rollup, qint64 bucket) { return rollup.bucket < bucket; });
+            if (it != rollups.end() && it->bucket == open->bucket) {
+                *it = *open;
+            } else {
+                rollups.insert(it, *open);
+            }
+        }
+        return rollups;
+    }
+
+    const bool sqlite = m_config.type == SQLITE;
+    QSqlQuery query(*static_cast<QSqlDatabase *>(m_dbHandle));
+    query.prepare(QString(
+        "SELECT bucket, min_value, max_value, sum_value, sample_count, first_value, last_value FROM %1 "
+        "WHERE resolution = ? AND tag_name = ? AND bucket >= ? AND bucket < ? "
+        "ORDER BY bucket ASC"
+    ).arg(rollupTable()));
+    query.bindValue(0, interval / 1000);
+    query.bindValue(1, tagName);
+    query.bindValue(2, sqlTime(start, sqlite));
+    query.bindValue(3, sqlTime(end, sqlite));
+
+    if (!query.exec()) {
+        qDebug() << "Failed to read rollups:" << query.lastError().text();
+        *ok = false;
+        return rollups;
+    }
+    while (query.next()) {
+        Rollup rollup;
+        rollup.tagName = tagName;
+        rollup.bucket = fromSqlTime(query.value(0), sqlite);
+        rollup.min = query.value(1).toDouble();
+        rollup.max = query.value(2).toDouble();
+        rollup.sum = query.value(3).toDouble();
+        rollup.count = query.value(4).toLongLong();
+        rollup.first = query.value(5).toDouble();
+        rollup.last = query.value(6).toDouble();
+        rollups.append(rollup);
+    }
+    return rollups;
+}
+
+QVector<HYTimeSeriesDatabase::Rollup> HYTimeSeriesDatabase::readStoredRollups(const QString &tagName, qint64 interval, qint64 start, qint64 end)
+{
+    // Each statistic is its own series; a bucket's values share its start time
+    HYColumnStore *store = static_cast<HYColumnStore *>(m_dbHandle);
+    QMap<qint64, Rollup> buckets;
+    for (int field = 0; field < RollupFieldCount; ++field) {
+        const QVector<HYColumnStore::Sample> stored = store->query(rollupSeries(tagName, interval, field), start, end - 1);
+        for (const HYColumnStore::Sample &sample : stored) {
+            Rollup &rollup = buckets[sample.timestamp];
+            rollup.tagName = tagName;
+            rollup.bucket = sample.timestamp;
+            const double value = sample.value.toDouble();
+            switch (field) {
+            case MinField:
+                rollup.min = value;
+                break;
+            case MaxField:
+                rollup.max = value;
+                break;
+            case SumField:
+                rollup.sum = value;
+                break;
+            case CountField:
+                rollup.count = qint64(value);
+                break;
+            case FirstField:
+                rollup.first = value;
+                break;
+            case LastField:
+                rollup.last = value;
+                break;
+            }
+        }
+    }
+
+    QVector<Rollup> rollups;
+    for (const Rollup &rollup : std::as_const(buckets)) {
+        if (rollup.count > 0) {
+            rollups.append(rollup);
+        }
+    }
+    return rollups;
+}
+
+QString HYTimeSeriesDatabase::rollupTable() const
+{
+    return m_config.tableName + "_rollup";
+}
+
+QVector<QPair<QString, qint64>> HYTimeSeriesDatabase::touchedBuckets(const QVector<TagSample> &samples, qint64 interval)
+{
+    // Text values count too, since one may have replaced a number at the same time
+    QSet<QPair<QString, qint64>> seen;
+    QVector<QPair<QString, qint64>> buckets;
+    for (const TagSample &sample : samples) {
+        const auto bucket = qMakePair(sample.tagName, floorTo(sample.timestamp, interval));
+        if (!seen.contains(bucket)) {
+            seen.insert(bucket);
+            buckets.append(bucket);
+        }
+    }
+
+    // Tags in bucket order, so the embedded store sees each tag's buckets oldest first
+    std::sort(buckets.begin(), buckets.end());
+    return buckets;
+}
+
+HYTimeSeriesDatabase::Rollup HYTimeSeriesDatabase::aggregateSamples(const QVector<QPair<qint64, double>> &samples)
+{
+    Rollup rollup;
+    if (samples.isEmpty()) {
+        return rollup;
+    }
+    rollup.min = rollup.max = rollup.first = samples.first().second;
+    rollup.last = samples.last().second;
+    for (const auto &sample : samples) {
+        rollup.min = qMin(rollup.min, sample.second);
+        rollup.max = qMax(rollup.max, sample.second);
+        rollup.sum += sample.second;
+    }
+    rollup.count = samples.size();
+    return rollup;
+}
+
+HYTimeSeriesDatabase::Rollup HYTimeSeriesDatabase::mergeRollups(const QVector<Rollup> &rollups)
+{
+    Rollup merged;
+    if (rollups.isEmpty()) {
+        return merged;
+    }
+    merged.min = rollups.first().min;
+    merged.max = rollups.first().max;
+    merged.first = rollups.first().first;
+    merged.last = rollups.last().last;
+    for (const Rollup &rollup : rollups) {
+        merged.min = qMin(merged.min, rollup.min);
+        merged.max = qMax(merged.max, rollup.max);
+        merged.sum += rollup.sum;
+        merged.count += rollup.count;
+    }
+    return merged;
+}
@@ -6,7 +6,13 @@
 #include <QVariant>
 #include <QDateTime>
 #include <QMap>
+#include <QHash>
+#include <QVector>
 #include <QMutex>
+#include <QPair>
+#include <functional>
+
+class QNetworkRequest;
 
 /**
  * @file timeseriesdatabase.h
@@ -19,13 +25,17 @@
  * @class HYTimeSeriesDatabase
  * @brief 时间序列数据库类
  * 
- * 负责与时间序列数据库的交互，支持InfluxDB、TimescaleDB和SQLite等数据库
+ * 负责与时间序列数据库的交互，支持InfluxDB、TimescaleDB、SQLite和内置列式存储
  */
 class HYTimeSeriesDatabase : public QObject
 {
     Q_OBJECT
 
 public:
+    static constexpr int DefaultBatchSize = 500; ///< 默认批量大小
+    static constexpr int GzipMinBytes = 1024; ///< InfluxDB写入请求体达到该字节数时才压缩
+    static constexpr qint64 RollupIntervals[] = {60000, 900000, 3600000}; ///< 汇总区间（毫秒），从细到粗：1分钟、15分钟、1小时
+
     /**
      * @enum DatabaseType
      * @brief 数据库类型枚举
@@ -33,7 +43,8 @@ public:
     enum DatabaseType {
         INFLUXDB,   ///< InfluxDB数据库
         TIMESCALEDB, ///< TimescaleDB数据库
-        SQLITE      ///< SQLite数据库
+        SQLITE,     ///< SQLite数据库
+        EMBEDDED    ///< 内置列式存储，database为文件路径
     };
 
     /**
@@ -48,6 +59,32 @@ public:
         QString username; ///< 用户名
         QString password; ///< 密码
         QString tableName; ///< 表名
+        int batchSize = DefaultBatchSize; ///< 批量写入时每条SQL语句或每个InfluxDB请求的最多值数，不大于0表示不限
+        bool compression = true; ///< InfluxDB写入请求体是否用gzip压缩
+    };
+
+    /**
+     * @struct TagSample
+     * @brief 带时间戳的标签值
+     */
+    struct TagSample {
+        QString tagName; ///< 标签名称
+        QVariant value; ///< 标签值
+        qint64 timestamp = 0; ///< 时间戳（毫秒）
+    };
+
+    /**
+     * @struct TrendPoint
+     * @brief 趋势点，一个汇总区间内数值样本的统计
+     */
+    struct TrendPoint {
+        qint64 timestamp = 0; ///< 区间开始时间（毫秒），原始数据为样本时间
+        double min = 0.0; ///< 最小值
+        double max = 0.0; ///< 最大值
+        double avg = 0.0; ///< 平均值
+        qint64 count = 0; ///< 样本数
+        double first = 0.0; ///< 区间内第一个值
+        double last = 0.0; ///< 区间内最后一个值
     };
 
     /**
@@ -99,12 +136,33 @@ public:
     
     /**
      * @brief 批量存储标签值
+     * 
+     * SQL数据库在一个事务中按batchSize个值一条多行INSERT写入，InfluxDB按batchSize行一个请求同时发出；
+     * 成功后每个值发出一次dataStored信号并计入liveWriteCount
      * @param tagValues 标签值映射
      * @param timestamp 时间戳
-     * @return 存储是否成功
+     * @return 整批是否成功，失败时SQL数据库的事务回滚，InfluxDB其他请求可能已写入
      */
     bool storeTagValues(const QMap<QString, QVariant> &tagValues, const QDateTime &timestamp = QDateTime::currentDateTime());
 
+    /**
+     * @brief 批量存储一批带各自时间戳的标签值
+     * 
+     * 与storeTagValues同样按batchSize分批写入；同一标签同一时间戳的值覆盖已有的值，
+     * 重复写入同一批数据不会产生重复记录。不发出dataStored信号，不计入liveWriteCount
+     * @param samples 标签值
+     * @return 整批是否成功，失败时SQL数据库的事务回滚
+     */
+    bool storeTagSamples(const QVector<TagSample> &samples);
+
+    /**
+     * @brief 获取实时写入次数
+     * 
+     * storeTagValue和storeTagValues每成功写入一个值加一，回放积压数据的一方据此让出写入带宽
+     * @return 累计次数
+     */
+    quint64 liveWriteCount() const;
+
     // 数据查询
     /**
      * @brief 查询标签历史数据
@@ -126,6 +184,28 @@ public:
      */
     QMap<QString, QMap<QDateTime, QVariant>> queryMultipleTagsHistory(const QStringList &tagNames, const QDateTime &startTime, const QDateTime &endTime, int limit = 1000);
 
+    /**
+     * @brief 查询标签趋势
+     * 
+     * 按trendInterval()选取汇总区间，从写入时维护的汇总中读取，不读取原始样本；
+     * 时间范围太短、没有满足点数的汇总区间时返回原始数值样本，每个样本一个趋势点。
+     * 只统计数值样本，InfluxDB由服务端按区间聚合
+     * @param tagName 标签名称
+     * @param startTime 开始时间
+     * @param endTime 结束时间
+     * @param points 需要的最少点数
+     * @return 按时间升序排列的趋势点，跳过没有样本的区间
+     */
+    QVector<TrendPoint> queryTagTrend(const QString &tagName, const QDateTime &startTime, const QDateTime &endTime, int points);
+
+    /**
+     * @brief 选取趋势查询的汇总区间
+     * @param range 时间范围（毫秒）
+     * @param points 需要的最少点数
+     * @return 区间数不少于points的最粗汇总区间（毫秒），没有时为0，表示使用原始样本
+     */
+    static qint64 trendInterval(qint64 range, int points);
+
     // 数据库操作
     /**
      * @brief 创建数据库
@@ -172,7 +252,28 @@ signals:
     void dataRetrieved(const QString &tagName, int count);
 
 private:
+    /**
+     * @struct Rollup
+     * @brief 一个汇总区间的统计，按和保存，以便合并成更粗一级
+     */
+    struct Rollup {
+        QString tagName; ///< 标签名称
+        qint64 bucket = 0; ///< 区间开始时间（毫秒）
+        double min = 0.0; ///< 最小值
+        double max = 0.0; ///< 最大值
+        double sum = 0.0; ///< 和
+        qint64 count = 0; ///< 样本数
+        double first = 0.0; ///< 第一个值
+        double last = 0.0; ///< 最后一个值
+    };
+
     // 数据库特定实现
+    /**
+     * @brief 生成本实例的SQL连接名称
+     * @return 连接名称
+     */
+    QString connectionName();
+
     /**
      * @brief 连接到InfluxDB
      * @return 连接是否成功
@@ -191,6 +292,12 @@ private:
      */
     bool connectToSQLite();
 
+    /**
+     * @brief 打开内置列式存储
+     * @return 打开是否成功
+     */
+    bool connectToEmbedded();
+
     /**
      * @brief 存储数据到InfluxDB
      * @param tagName 标签名称
@@ -201,22 +308,59 @@ private:
     bool storeInInfluxDB(const QString &tagName, const QVariant &value, const QDateTime &timestamp);
     
     /**
-     * @brief 存储数据到TimescaleDB
+     * @brief 生成InfluxDB行协议的一行
      * @param tagName 标签名称
      * @param value 标签值
-     * @param timestamp 时间戳
-     * @return 存储是否成功
+     * @param timestamp 时间戳（毫秒）
+     * @return 行协议文本
      */
-    bool storeInTimescaleDB(const QString &tagName, const QVariant &value, const QDateTime &timestamp);
-    
+    QString influxLine(const QString &tagName, const QVariant &value, qint64 timestamp) const;
+
     /**
-     * @brief 存储数据到SQLite
-     * @param tagName 标签名称
-     * @param value 标签值
-     * @param timestamp 时间戳
-     * @return 存储是否成功
+     * @brief 构造发往InfluxDB的请求，用户名和密码放在Authorization头中
+     * @param path 接口路径
+     * @param query 已百分号编码的查询参数，不含db
+     * @return 请求
      */
-    bool storeInSQLite(const QString &tagName, const QVariant &value, const QDateTime &timestamp);
+    QNetworkRequest influxRequest(const QString &path, const QByteArray &query) const;
+
+    /**
+     * @brief 向InfluxDB写入行协议数据
+     *
+     * 所有请求同时发出，由长连接上的网络管理器复用连接并流水线发送，全部完成后返回；
+     * 请求体达到GzipMinBytes字节时按配置用gzip压缩
+     * @param bodies 每个请求的行协议文本，每行一个点
+     * @return 所有请求是否成功
+     */
+    bool postToInfluxDB(const QVector<QByteArray> &bodies);
+
+    /**
+     * @brief 按数据库类型分批写入一批标签值
+     * @param samples 标签值
+     * @return 整批是否成功
+     */
+    bool storeSamples(const QVector<TagSample> &samples);
+
+    /**
+     * @brief 按batchSize行一个请求同时向InfluxDB写入一批标签值
+     * @param samples 标签值
+     * @return 所有请求是否成功
+     */
+    bool storeSamplesInInfluxDB(const QVector<TagSample> &samples);
+
+    /**
+     * @brief 在一个事务中用多行INSERT向SQL数据库存储一批标签值
+     * @param samples 标签值
+     * @return 写入是否成功
+     */
+    bool storeSamplesInSql(const QVector<TagSample> &samples);
+
+    /**
+     * @brief 按标签分列向内置列式存储写入一批标签值
+     * @param samples 标签值
+     * @return 写入是否成功
+     */
+    bool storeSamplesInEmbedded(const QVector<TagSample> &samples);
 
     /**
      * @brief 从InfluxDB查询数据
@@ -248,11 +392,144 @@ private:
      */
     QMap<QDateTime, QVariant> queryFromSQLite(const QString &tagName, const QDateTime &startTime, const QDateTime &endTime, int limit);
 
+    /**
+     * @brief 从内置列式存储查询数据
+     * @param tagName 标签名称
+     * @param startTime 开始时间
+     * @param endTime 结束时间
+     * @param limit 限制数量
+     * @return 查询结果
+     */
+    QMap<QDateTime, QVariant> queryFromEmbedded(const QString &tagName, const QDateTime &startTime, const QDateTime &endTime, int limit);
+
+    /**
+     * @brief 执行InfluxDB查询，边接收边解析，逐行回调
+     * @param statement InfluxQL语句
+     * @param row 每行的回调，参数为各列的值，时间列为毫秒时间戳
+     * @return 应答是否成功且完整，失败时之前的回调结果应丢弃
+     */
+    bool queryInfluxRows(const QString &statement, const std::function<void(const QVariantList &)> &row);
+
+    /**
+     * @brief 由InfluxDB按区间聚合查询趋势
+     * @param tagName 标签名称
+     * @param startTime 开始时间
+     * @param endTime 结束时间
+     * @param interval 区间（毫秒）
+     * @return 趋势点
+     */
+    QVector<TrendPoint> queryTrendFromInfluxDB(const QString &tagName, const QDateTime &startTime, const QDateTime &endTime, qint64 interval);
+
+    /**
+     * @brief 重建一批样本涉及的各级汇总区间
+     *
+     * 每个涉及的区间都由已存储的数据重新统计后整体替换，最细一级读原始数据，较粗一级读细一级汇总；
+     * 重复写入同一批数据，汇总保持不变
+     * @param samples 刚写入的标签值
+     * @return 是否成功
+     */
+    bool updateRollups(const QVector<TagSample> &samples);
+
+    /**
+     * @brief 用INSERT ... SELECT重建SQL汇总表中的区间，在调用者的事务中执行
+     * @param interval 汇总区间（毫秒）
+     * @param buckets 标签和区间开始时间
+     * @return 是否成功
+     */
+    bool rebuildSqlRollups(qint64 interval, const QVector<QPair<QString, qint64>> &buckets);
+
+    /**
+     * @brief 重建内置存储中的汇总区间
+     *
+     * 每个标签最新的区间留在内存中，开始下一个区间时才按时间顺序追加写入一次；
+     * 迟到样本所在的已写入区间重新统计后写回
+     * @param interval 汇总区间（毫秒）
+     * @param buckets 标签和区间开始时间，按标签和时间排序
+     * @return 是否成功
+     */
+    bool rebuildEmbeddedRollups(qint64 interval, const QVector<QPair<QString, qint64>> &buckets);
+
+    /**
+     * @brief 向内置存储写入一个汇总区间
+     * @param interval 汇总区间（毫秒）
+     * @param rollup 区间统计
+     * @return 是否成功
+     */
+    bool writeEmbeddedRollup(qint64 interval, const Rollup &rollup);
+
+    /**
+     * @brief 把内存中累计的汇总区间全部写入内置存储
+     * @return 是否成功
+     */
+    bool flushEmbeddedRollups();
+
+    /**
+     * @brief 读取原始数值样本
+     * @param tagName 标签名称
+     * @param start 开始时间（毫秒，含）
+     * @param end 结束时间（毫秒，不含）
+     * @param ok 是否成功
+     * @return 按时间升序排列的时间戳和值
+     */
+    QVector<QPair<qint64, double>> readNumericSamples(const QString &tagName, qint64 start, qint64 end, bool *ok);
+
+    /**
+     * @brief 读取汇总
+     * @param tagName 标签名称
+     * @param interval 汇总区间（毫秒）
+     * @param start 开始时间（毫秒，含）
+     * @param end 结束时间（毫秒，不含）
+     * @param ok 是否成功
+     * @return 按时间升序排列的非空区间
+     */
+    QVector<Rollup> readRollups(const QString &tagName, qint64 interval, qint64 start, qint64 end, bool *ok);
+
+    /**
+     * @brief 读取内置存储中已写入的汇总，不含内存中的区间
+     * @param tagName 标签名称
+     * @param interval 汇总区间（毫秒）
+     * @param start 开始时间（毫秒，含）
+     * @param end 结束时间（毫秒，不含）
+     * @return 按时间升序排列的非空区间
+     */
+    QVector<Rollup> readStoredRollups(const QString &tagName, qint64 interval, qint64 start, qint64 end);
+
+    /**
+     * @brief 获取SQL汇总表名
+     * @return 表名
+     */
+    QString rollupTable() const;
+
+    /**
+     * @brief 找出一批样本涉及的区间
+     * @param samples 标签值，顺序不限
+     * @param interval 区间（毫秒）
+     * @return 去重后按标签、区间开始时间排序的区间
+     */
+    static QVector<QPair<QString, qint64>> touchedBuckets(const QVector<TagSample> &samples, qint64 interval);
+
+    /**
+     * @brief 统计一个区间内的数值样本
+     * @param samples 按时间升序排列的时间戳和值
+     * @return 区间统计，没有样本时count为0
+     */
+    static Rollup aggregateSamples(const QVector<QPair<qint64, double>> &samples);
+
+    /**
+     * @brief 把细一级的区间合并成一个较粗的区间
+     * @param rollups 按时间升序排列的非空区间
+     * @return 合并后的统计，没有区间时count为0
+     */
+    static Rollup mergeRollups(const QVector<Rollup> &rollups);
+
     // 私有成员
     DatabaseConfig m_config; ///< 数据库配置
     bool m_connected; ///< 是否连接
     QString m_status; ///< 连接状态
     QMutex m_mutex; ///< 互斥锁
+    quint64 m_liveWrites; ///< 实时写入次数
+    QString m_connectionName; ///< SQL连接名称，每个实例一个连接
+    QHash<QPair<QString, qint64>, Rollup> m_openRollups; ///< 内置存储中按标签和汇总区间尚未写入的最新区间
 
     // 数据库特定句柄（在实现中定义）
     void *m_dbHandle; ///< 通用数据库句柄指针，需要转换为特定数据库句柄
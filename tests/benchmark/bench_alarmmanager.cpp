@@ -0,0 +1,121 @@
+#include <QTest>
+#include <QElapsedTimer>
+#include "alarmmanager.h"
+
+/**
+ * @brief 告警判断开销基准测试
+ *
+ * 每个点位定义高、高高、低、低低和变化率五个告警，比较按事件判断（每批只判断变化的点位）
+ * 与定时轮询（每个周期读取全部点位并判断全部告警）的每批耗时，告警定义最多50000个
+ */
+class BenchAlarmManager : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    /**
+     * @brief 判断开销测试数据
+     */
+    void evaluate_data() {
+        QTest::addColumn<int>("alarms");
+        QTest::addColumn<int>("changed");
+
+        for (int alarms : {5000, 50000}) {
+            for (int changed : {10, 100, 1000}) {
+                QTest::newRow(qPrintable(QString("alarms=%1/changed=%2").arg(alarms).arg(changed))) << alarms << changed;
+            }
+        }
+    }
+
+    /**
+     * @brief 判断开销测试
+     */
+    void evaluate() {
+        QFETCH(int, alarms);
+        QFETCH(int, changed);
+
+        const int tags = alarms / AlarmsPerTag;
+        QVector<HYTagDefinition> definitions;
+        definitions.reserve(tags);
+        for (int i = 0; i < tags; ++i) {
+            definitions.append(HYTagDefinition{QString("Bench_Tag_%1").arg(i), "Bench", 50.0, QString(), QString()});
+        }
+        HYTagManager manager;
+        QCOMPARE(manager.addTagDefinitions(definitions), tags);
+        HYAlarmManager alarmManager(&manager);
+
+        QElapsedTimer timer;
+        timer.start();
+        for (int i = 0; i < tags; ++i) {
+            const QString tagName = definitions[i].name;
+            QVERIFY(alarmManager.addAlarm(definition(tagName + ".HI", tagName, HYAlarmDefinition::High, 80)));
+            QVERIFY(alarmManager.addAlarm(definition(tagName + ".HIHI", tagName, HYAlarmDefinition::HighHigh, 90)));
+            QVERIFY(alarmManager.addAlarm(definition(tagName + ".LO", tagName, HYAlarmDefinition::Low, 20)));
+            QVERIFY(alarmManager.addAlarm(definition(tagName + ".LOLO", tagName, HYAlarmDefinition::LowLow, 10)));
+            QVERIFY(alarmManager.addAlarm(definition(tagName + ".ROC", tagName, HYAlarmDefinition::RateOfChange, 1000)));
+        }
+        const qint64 defineMs = timer.elapsed();
+        QCOMPARE(alarmManager.alarmCount(), alarms);
+
+        // 按事件判断：每批只传入变化的点位，一半越过高限，一半回到正常范围
+        qint64 now = QDateTime::currentMSecsSinceEpoch();
+        QVector<HYTagUpdate> updates(changed);
+        qint64 eventNs = 0;
+        int transitions = 0;
+        for (int round = 0; round < Rounds; ++round) {
+            now += 1000;
+            for (int i = 0; i < changed; ++i) {
+                HYTagUpdate &update = updates[i];
+                update.id = HYTagManager::TagId((qint64(round) * changed + i) % tags);
+                update.timestamp = now;
+                update.value = HYTagValue::fromDouble(round % 2 ? 50.0 : 95.0);
+            }
+            timer.start();
+            transitions += alarmManager.evaluate(updates);
+            eventNs += timer.nsecsElapsed();
+        }
+
+        // 定时轮询：每个周期读取全部点位并判断全部告警
+        QVector<HYTagUpdate> all(tags);
+        qint64 pollNs = 0;
+        for (int round = 0; round < Rounds; ++round) {
+            now += 1000;
+            timer.start();
+            for (int i = 0; i < tags; ++i) {
+                const HYTagRecord current = manager.record(HYTagManager::TagId(i));
+                all[i].id = HYTagManager::TagId(i);
+                all[i].timestamp = now;
+                all[i].value = current.value;
+                all[i].quality = current.quality;
+            }
+            alarmManager.evaluate(all);
+            pollNs += timer.nsecsElapsed();
+        }
+
+        qInfo("alarms=%6d  changed=%5d  define: ms=%6lld  by-event: us/batch=%9.1f ns/change=%7.1f transitions=%7d  "
+              "polled: us/tick=%9.1f",
+              alarms, changed, defineMs, eventNs / 1000.0 / Rounds, double(eventNs) / Rounds / changed, transitions,
+              pollNs / 1000.0 / Rounds);
+    }
+
+private:
+    static constexpr int AlarmsPerTag = 5; ///< 每个点位的告警数
+    static constexpr int Rounds = 50; ///< 批次数
+
+    /**
+     * @brief 构造告警定义
+     */
+    static HYAlarmDefinition definition(const QString &name, const QString &tagName, HYAlarmDefinition::Type type,
+                                        double limit) {
+        HYAlarmDefinition result;
+        result.name = name;
+        result.tagName = tagName;
+        result.type = type;
+        result.limit = limit;
+        result.deadband = 1.0;
+        return result;
+    }
+};
+
+QTEST_MAIN(BenchAlarmManager)
+#include "bench_alarmmanager.moc"
@@ -0,0 +1,111 @@
+#include <QTest>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+#include <QFileInfo>
+#include <QRandomGenerator>
+#include <cmath>
+#include "timeseriesdatabase.h"
+
+/**
+ * @brief 历史存储后端基准测试
+ *
+ * 通过HYTimeSeriesDatabase向SQLite和内置列式存储写入相同的数据：20个点位、每10秒一个样本、共7天，
+ * 值为保留两位小数的随机游走，每批写入全部点位一小时的样本；比较写入速率、每个样本占用的字节数，
+ * 以及查询一个点位7天和1小时数据的延迟
+ */
+class BenchColumnStore : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    /**
+     * @brief 后端对比测试数据
+     */
+    void backend_data() {
+        QTest::addColumn<int>("type");
+
+        QTest::newRow("sqlite") << int(HYTimeSeriesDatabase::SQLITE);
+        QTest::newRow("embedded") << int(HYTimeSeriesDatabase::EMBEDDED);
+    }
+
+    /**
+     * @brief 后端对比测试
+     */
+    void backend() {
+        QFETCH(int, type);
+
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        HYTimeSeriesDatabase::DatabaseConfig config;
+        config.type = HYTimeSeriesDatabase::DatabaseType(type);
+        config.port = 0;
+        config.database = dir.filePath(type == HYTimeSeriesDatabase::SQLITE ? "history.db" : "history.hycs");
+        config.tableName = "history";
+
+        HYTimeSeriesDatabase database;
+        QVERIFY(database.initialize(config));
+
+        // 每批写入全部点位一小时的样本
+        QRandomGenerator random(42);
+        QVector<double> values(Tags, 50.0);
+        const int samplesPerHour = 3600000 / IntervalMs;
+        QVector<HYTimeSeriesDatabase::TagSample> batch;
+        batch.reserve(Tags * samplesPerHour);
+        qint64 samples = 0;
+        qint64 ingestNs = 0;
+        QElapsedTimer timer;
+        for (int hour = 0; hour < Days * 24; ++hour) {
+            batch.clear();
+            for (int i = 0; i < samplesPerHour; ++i) {
+                const qint64 timestamp = Start + (qint64(hour) * samplesPerHour + i) * IntervalMs;
+                for (int tag = 0; tag < Tags; ++tag) {
+                    values[tag] = std::round((values[tag] + random.bounded(2.0) - 1.0) * 100.0) / 100.0;
+                    batch.append({QString("Bench_Tag_%1").arg(tag), values[tag], timestamp});
+                }
+            }
+            timer.start();
+            QVERIFY(database.storeTagSamples(batch));
+            ingestNs += timer.nsecsElapsed();
+            samples += batch.size();
+        }
+
+        // 关闭后统计文件大小，内置存储在关闭时写入开放块
+        database.shutdown();
+        const qint64 bytes = QFileInfo(config.database).size() + QFileInfo(config.database + "-wal").size();
+        QVERIFY(database.initialize(config));
+
+        const QDateTime start = QDateTime::fromMSecsSinceEpoch(Start);
+        const QDateTime end = QDateTime::fromMSecsSinceEpoch(Start + qint64(Days) * 86400000 - 1);
+        const int expected = Days * 24 * samplesPerHour;
+        qint64 weekNs = 0;
+        qint64 hourNs = 0;
+        for (int tag = 0; tag < Tags; ++tag) {
+            const QString tagName = QString("Bench_Tag_%1").arg(tag);
+            timer.start();
+            const QMap<QDateTime, QVariant> week = database.queryTagHistory(tagName, start, end, expected);
+            weekNs += timer.nsecsElapsed();
+            QCOMPARE(week.size(), expected);
+
+            const QDateTime from = start.addSecs(qint64(tag) * 6 * 3600);
+            timer.start();
+            const QMap<QDateTime, QVariant> hour = database.queryTagHistory(tagName, from, from.addSecs(3599), expected);
+            hourNs += timer.nsecsElapsed();
+            QCOMPARE(hour.size(), samplesPerHour);
+        }
+        database.shutdown();
+
+        qInfo("%-8s samples=%8lld  ingest: samples/s=%10.0f  bytes=%10lld bytes/sample=%6.2f  "
+              "query 7d: ms=%8.2f  query 1h: ms=%6.3f",
+              QTest::currentDataTag(), samples, samples * 1e9 / ingestNs, bytes, double(bytes) / samples,
+              weekNs / 1e6 / Tags, hourNs / 1e6 / Tags);
+    }
+
+private:
+    static constexpr int Tags = 20; ///< 点位数
+    static constexpr int Days = 7; ///< 天数
+    static constexpr int IntervalMs = 10000; ///< 采样间隔（毫秒），SQLite后端按秒保存时间戳
+    static constexpr qint64 Start = 1767225600000; ///< 2026-01-01T00:00:00Z
+};
+
+QTEST_MAIN(BenchColumnStore)
+#include "bench_columnstore.moc"
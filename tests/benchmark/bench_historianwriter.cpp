@@ -0,0 +1,116 @@
+#include <QTest>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+#include "historianwriter.h"
+
+/**
+ * @brief 异步历史写入器基准测试
+ *
+ * 模拟采集定时器：每个周期写入1000个点位各一个值，比较调用方每个周期被占用的时间——
+ * 原来的写法在调用线程中逐个调用storeTagValue，异步写入只调用enqueue；
+ * 同时给出全部值写入SQLite文件的总耗时和写入器的批次指标
+ */
+class BenchHistorianWriter : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    /**
+     * @brief 同步写入
+     */
+    void synchronous() {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        HYTimeSeriesDatabase database;
+        QVERIFY(database.initialize(config(dir)));
+
+        QElapsedTimer total;
+        total.start();
+        qint64 maxCycleNs = 0;
+        for (int cycle = 0; cycle < Cycles; ++cycle) {
+            const QDateTime timestamp = QDateTime::fromMSecsSinceEpoch(Start + cycle * 1000);
+            QElapsedTimer timer;
+            timer.start();
+            for (int tag = 0; tag < Tags; ++tag) {
+                QVERIFY(database.storeTagValue(QString("Bench_Tag_%1").arg(tag), double(cycle + tag), timestamp));
+            }
+            maxCycleNs = qMax(maxCycleNs, timer.nsecsElapsed());
+        }
+        const qint64 totalNs = total.nsecsElapsed();
+        database.shutdown();
+
+        qInfo("synchronous  caller per cycle: avg ms=%8.3f max ms=%8.3f  all written: values/s=%10.0f",
+              totalNs / 1e6 / Cycles, maxCycleNs / 1e6, double(Tags) * Cycles * 1e9 / totalNs);
+    }
+
+    /**
+     * @brief 异步写入测试数据
+     */
+    void asynchronous_data() {
+        QTest::addColumn<int>("batchSize");
+
+        for (int batchSize : {500, 5000}) {
+            QTest::newRow(qPrintable(QString("batch=%1").arg(batchSize))) << batchSize;
+        }
+    }
+
+    /**
+     * @brief 异步写入
+     */
+    void asynchronous() {
+        QFETCH(int, batchSize);
+
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        HYHistorianWriter writer;
+        writer.setBatchSize(batchSize);
+        QVERIFY(writer.start(config(dir)));
+
+        QElapsedTimer total;
+        total.start();
+        qint64 callerNs = 0;
+        qint64 maxCycleNs = 0;
+        for (int cycle = 0; cycle < Cycles; ++cycle) {
+            const qint64 timestamp = Start + cycle * 1000;
+            QElapsedTimer timer;
+            timer.start();
+            for (int tag = 0; tag < Tags; ++tag) {
+                QVERIFY(writer.enqueue(QString("Bench_Tag_%1").arg(tag), double(cycle + tag), timestamp));
+            }
+            const qint64 cycleNs = timer.nsecsElapsed();
+            callerNs += cycleNs;
+            maxCycleNs = qMax(maxCycleNs, cycleNs);
+        }
+        QVERIFY(writer.flush());
+        const qint64 totalNs = total.nsecsElapsed();
+        const HYHistorianWriter::Metrics metrics = writer.metrics();
+        writer.stop();
+        QCOMPARE(metrics.written, quint64(Tags) * Cycles);
+
+        qInfo("%-11s  caller per cycle: avg ms=%8.3f max ms=%8.3f  all written: values/s=%10.0f  "
+              "flushes=%4llu avg flush ms=%7.2f max flush ms=%7.2f",
+              QTest::currentDataTag(), callerNs / 1e6 / Cycles, maxCycleNs / 1e6,
+              double(Tags) * Cycles * 1e9 / totalNs, metrics.flushes, metrics.averageFlushUs / 1e3,
+              metrics.maxFlushUs / 1e3);
+    }
+
+private:
+    static constexpr int Tags = 1000; ///< 每个周期写入的点位数
+    static constexpr int Cycles = 20; ///< 周期数
+    static constexpr qint64 Start = 1767225600000; ///< 2026-01-01T00:00:00Z
+
+    /**
+     * @brief 临时SQLite文件的配置
+     */
+    static HYTimeSeriesDatabase::DatabaseConfig config(const QTemporaryDir &dir) {
+        HYTimeSeriesDatabase::DatabaseConfig config;
+        config.type = HYTimeSeriesDatabase::SQLITE;
+        config.port = 0;
+        config.database = dir.filePath("history.db");
+        config.tableName = "bench_writer";
+        return config;
+    }
+};
+
+QTEST_MAIN(BenchHistorianWriter)
+#include "bench_historianwriter.moc"
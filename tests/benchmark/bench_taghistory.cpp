@@ -0,0 +1,133 @@
+#include <QTest>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+#include <QFileInfo>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include "tagmanager.h"
+
+/**
+ * @brief 历史归档基准测试
+ *
+ * 每个周期更新一部分点位，比较原来的全量写入（每周期每个点位一行，文本值和ISO 8601时间字符串）
+ * 与按例外归档（只写变化的点位，类型化列和毫秒时间戳）的写入行数、数据库文件大小和每周期耗时
+ */
+class BenchTagHistory : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    /**
+     * @brief 归档测试数据
+     */
+    void archive_data() {
+        QTest::addColumn<int>("tags");
+        QTest::addColumn<int>("changePercent");
+
+        for (int tags : {10000, 100000}) {
+            for (int changePercent : {1, 10, 100}) {
+                QTest::newRow(qPrintable(QString("tags=%1/changes=%2%").arg(tags).arg(changePercent)))
+                    << tags << changePercent;
+            }
+        }
+    }
+
+    /**
+     * @brief 归档测试
+     */
+    void archive() {
+        QFETCH(int, tags);
+        QFETCH(int, changePercent);
+
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        const int changed = qMax(1, tags * changePercent / 100);
+
+        QVector<HYTagDefinition> definitions;
+        definitions.reserve(tags);
+        for (int i = 0; i < tags; ++i) {
+            definitions.append(HYTagDefinition{QString("Bench_Tag_%1").arg(i), "Bench", double(i), QString(),
+                                               QString()});
+        }
+        HYTagManager manager;
+        QCOMPARE(manager.addTagDefinitions(definitions), tags);
+
+        // 原来的全量写入：每个周期在一个事务中逐行插入全部点位
+        const QString legacyPath = dir.filePath("legacy.db");
+        qint64 legacyRows = 0;
+        qint64 legacyMs = 0;
+        {
+            QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", "bench.legacy");
+            database.setDatabaseName(legacyPath);
+            QVERIFY(database.open());
+            QSqlQuery query(database);
+            query.exec("CREATE TABLE history (id INTEGER PRIMARY KEY AUTOINCREMENT, tag_name TEXT, value TEXT, "
+                       "timestamp TEXT, quality INTEGER DEFAULT 192)");
+            query.exec("CREATE INDEX idx_tag_name_timestamp ON history (tag_name, timestamp)");
+
+            QElapsedTimer timer;
+            for (int tick = 0; tick < Ticks; ++tick) {
+                update(&manager, tags, tick, changed);
+                timer.start();
+                database.transaction();
+                query.prepare("INSERT INTO history (tag_name, value, timestamp, quality) VALUES (?, ?, ?, ?)");
+                for (HYTagManager::TagId id = 0; id < tags; ++id) {
+                    const HYTagRecord current = manager.record(id);
+                    query.bindValue(0, manager.tagName(id));
+                    query.bindValue(1, manager.value(id).toString());
+                    query.bindValue(2, QDateTime::fromMSecsSinceEpoch(current.sourceTimestamp).toString(Qt::ISODate));
+                    query.bindValue(3, int(current.quality));
+                    query.exec();
+                }
+                database.commit();
+                legacyMs += timer.elapsed();
+                legacyRows += tags;
+            }
+            database.close();
+        }
+        QSqlDatabase::removeDatabase("bench.legacy");
+
+        // 按例外归档：第一个周期写入全部点位，之后只写变化的点位
+        const QString archivePath = dir.filePath("history.db");
+        QVERIFY(manager.setHistoryDatabasePath(archivePath));
+        manager.enableHistoryStorage(true, 3600000);
+        qint64 archiveRows = manager.archiveHistory();
+        qint64 archiveMs = 0;
+        QElapsedTimer timer;
+        for (int tick = 0; tick < Ticks; ++tick) {
+            update(&manager, tags, tick, changed);
+            timer.start();
+            archiveRows += manager.archiveHistory();
+            archiveMs += timer.elapsed();
+        }
+        manager.enableHistoryStorage(false);
+
+        qInfo("tags=%7d  changes=%3d%%  full: rows=%9lld bytes=%11lld ms/tick=%8.2f  "
+              "by-exception: rows=%8lld bytes=%10lld ms/tick=%7.2f",
+              tags, changePercent, legacyRows, fileSize(legacyPath), double(legacyMs) / Ticks, archiveRows,
+              fileSize(archivePath), double(archiveMs) / Ticks);
+    }
+
+private:
+    static constexpr int Ticks = 20; ///< 归档周期数
+
+    /**
+     * @brief 按周期轮换更新一部分点位，每次变化都超过默认死区
+     */
+    static void update(HYTagManager *manager, int tags, int tick, int changed) {
+        for (int i = 0; i < changed; ++i) {
+            const HYTagManager::TagId id = HYTagManager::TagId((qint64(tick) * changed + i) % tags);
+            manager->setValue(id, HYTagValue::fromDouble(double(tick * tags + id)));
+        }
+    }
+
+    /**
+     * @brief 获取数据库文件和预写日志的总大小
+     */
+    static qint64 fileSize(const QString &path) {
+        return QFileInfo(path).size() + QFileInfo(path + "-wal").size();
+    }
+};
+
+QTEST_MAIN(BenchTagHistory)
+#include "bench_taghistory.moc"
@@ -0,0 +1,93 @@
+#include <QTest>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+#include "tagmanager.h"
+
+/**
+ * @brief 点位批量导入冷启动基准测试
+ *
+ * 分别用逐个addTags、CSV导入和二进制导入建立10k、100k和1M点位的点位表，
+ * 统计从构造点位管理器到点位表可用的耗时；定义文件在计时前生成
+ */
+class BenchTagImport : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    /**
+     * @brief 冷启动测试数据
+     */
+    void coldStart_data() {
+        QTest::addColumn<QString>("mode");
+        QTest::addColumn<int>("tags");
+
+        for (int tags : {10000, 100000, 1000000}) {
+            for (const QString &mode : {QString("addTags"), QString("csv"), QString("binary")}) {
+                QTest::newRow(qPrintable(QString("%1/tags=%2").arg(mode).arg(tags))) << mode << tags;
+            }
+        }
+    }
+
+    /**
+     * @brief 冷启动测试
+     */
+    void coldStart() {
+        QFETCH(QString, mode);
+        QFETCH(int, tags);
+
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        const QString path = dir.filePath(mode == "csv" ? "tags.csv" : "tags.bin");
+
+        // 准备输入：addTags使用点位信息列表，导入模式使用由点位管理器导出的定义文件
+        QVector<QMap<QString, QVariant>> tagInfos;
+        {
+            QVector<HYTagDefinition> definitions;
+            definitions.reserve(tags);
+            for (int i = 0; i < tags; ++i) {
+                definitions.append(HYTagDefinition{
+                    QString("plant.bf%1.zone%2.tag%3").arg(i % 4).arg((i / 4) % 64).arg(i),
+                    QString("Group_%1").arg(i % 64), double(i), QString("Bench tag %1").arg(i),
+                    QString("PLC%1").arg(i % 8)});
+            }
+
+            if (mode == "addTags") {
+                tagInfos.reserve(tags);
+                for (const HYTagDefinition &definition : definitions) {
+                    QMap<QString, QVariant> info;
+                    info["name"] = definition.name;
+                    info["group"] = definition.group;
+                    info["value"] = definition.value;
+                    info["description"] = definition.description;
+                    info["source"] = definition.source;
+                    tagInfos.append(info);
+                }
+            } else {
+                HYTagManager source;
+                QCOMPARE(source.addTagDefinitions(definitions), tags);
+                QVERIFY(source.exportTags(path, mode == "csv" ? HYTagManager::TagFileCsv
+                                                              : HYTagManager::TagFileBinary));
+            }
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+        HYTagManager manager;
+        int notifications = 0;
+        connect(&manager, &HYTagManager::tagAdded, this, [&notifications]() { ++notifications; });
+        connect(&manager, &HYTagManager::tagsAdded, this, [&notifications]() { ++notifications; });
+        if (mode == "addTags") {
+            QVERIFY(manager.addTags(tagInfos));
+        } else {
+            QCOMPARE(manager.importTags(path), tags);
+        }
+        const qint64 elapsed = timer.elapsed();
+
+        QCOMPARE(manager.getAllTags().size(), tags);
+        qInfo("%-8s tags=%8d  cold start=%8lldms  tags/s=%11.0f  notifications=%d",
+              qPrintable(mode), tags, elapsed, tags / qMax(0.001, elapsed / 1000.0), notifications);
+    }
+};
+
+QTEST_MAIN(BenchTagImport)
+#include "bench_tagimport.moc"
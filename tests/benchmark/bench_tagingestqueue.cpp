@@ -0,0 +1,126 @@
+#include <QTest>
+#include <QThread>
+#include <QElapsedTimer>
+#include <atomic>
+#include "tagingestqueue.h"
+
+/**
+ * @brief 点位采集队列基准测试
+ *
+ * N个线程模拟N个数据源回调，比较直接调用setValue与推入采集队列时回调本身的耗时
+ * direct模式下回调等待分片锁，queue模式下回调只做一次无锁入队，写入由应用线程完成
+ * 0号数据源不做任何节流，模拟突发的PLC，观察其余数据源是否受影响
+ */
+class BenchTagIngestQueue : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    /**
+     * @brief 采集测试数据
+     */
+    void ingest_data() {
+        QTest::addColumn<QString>("mode");
+        QTest::addColumn<int>("sources");
+
+        const int cores = qMax(2, QThread::idealThreadCount());
+        for (const QString &mode : {QString("direct"), QString("queue")}) {
+            for (int sources : {2, 4, cores}) {
+                QTest::newRow(qPrintable(QString("%1/sources=%2").arg(mode).arg(sources))) << mode << sources;
+            }
+        }
+    }
+
+    /**
+     * @brief 采集测试
+     */
+    void ingest() {
+        QFETCH(QString, mode);
+        QFETCH(int, sources);
+
+        HYTagManager manager;
+        QVector<HYTagManager::TagId> ids;
+        for (int i = 0; i < TagCount; ++i) {
+            manager.addTag(QString("Bench_Tag_%1").arg(i), "Bench", 0.0);
+            ids.append(manager.resolveTag(QString("Bench_Tag_%1").arg(i)));
+        }
+
+        HYTagIngestQueue queue(&manager);
+        QVector<int> sourceIds;
+        for (int s = 0; s < sources; ++s) {
+            sourceIds.append(queue.registerSource(QString("PLC%1").arg(s), queue.capacity() / sources));
+        }
+        if (mode == "queue") {
+            queue.start();
+        }
+
+        std::atomic<bool> stop(false);
+        QVector<qint64> calls(sources, 0);
+        QVector<qint64> worstNs(sources, 0);
+        const int perSource = TagCount / sources;
+
+        QVector<QThread *> threads;
+        for (int s = 0; s < sources; ++s) {
+            threads.append(QThread::create([&, s]() {
+                const int first = s * perSource;
+                QElapsedTimer timer;
+                qint64 count = 0;
+                qint64 worst = 0;
+                int index = 0;
+                while (!stop.load(std::memory_order_relaxed)) {
+                    const HYTagValue value = HYTagValue::fromDouble(double(count));
+                    timer.start();
+                    if (mode == "direct") {
+                        manager.setValue(ids[first + index], value);
+                    } else {
+                        queue.tryPush(sourceIds[s], ids[first + index], value, count);
+                    }
+                    worst = qMax(worst, timer.nsecsElapsed());
+                    index = (index + 1) % perSource;
+                    ++count;
+
+                    // Sources other than the first poll at a realistic pace
+                    if (s != 0 && (count & 63) == 0) {
+                        QThread::usleep(100);
+                    }
+                }
+                calls[s] = count;
+                worstNs[s] = worst;
+            }));
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+        for (QThread *thread : threads) {
+            thread->start();
+        }
+
+        QThread::msleep(DurationMs);
+        stop.store(true);
+
+        for (QThread *thread : threads) {
+            thread->wait();
+            delete thread;
+        }
+        queue.stop();
+
+        const double seconds = timer.elapsed() / 1000.0;
+        qint64 others = 0;
+        qint64 othersWorst = 0;
+        for (int s = 1; s < sources; ++s) {
+            others += calls[s];
+            othersWorst = qMax(othersWorst, worstNs[s]);
+        }
+        qInfo("%-6s sources=%2d  burst calls/s=%11.0f worst=%8lldns  others calls/s=%9.0f worst=%8lldns  "
+              "burst dropped=%lld others dropped=%lld",
+              qPrintable(mode), sources, calls[0] / seconds, worstNs[0], others / seconds, othersWorst,
+              queue.sourceStats(sourceIds[0]).dropped, queue.droppedCount() - queue.sourceStats(sourceIds[0]).dropped);
+    }
+
+private:
+    static constexpr int TagCount = 16384; ///< 点位数量
+    static constexpr int DurationMs = 1000; ///< 每组测试时长（毫秒）
+};
+
+QTEST_MAIN(BenchTagIngestQueue)
+#include "bench_tagingestqueue.moc"
@@ -0,0 +1,86 @@
+#include <QTest>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+#include "tagmanager.h"
+
+/**
+ * @brief 点位状态日志重启基准测试
+ *
+ * 建立10k、100k和1M点位的点位表并写入检查点，再在日志中留下每个点位若干次值变化，
+ * 统计写检查点的耗时，以及新的点位管理器回放检查点和日志、恢复到可用状态的耗时
+ */
+class BenchTagJournal : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    /**
+     * @brief 重启测试数据
+     */
+    void restart_data() {
+        QTest::addColumn<int>("tags");
+        QTest::addColumn<int>("changesPerTag");
+
+        for (int tags : {10000, 100000, 1000000}) {
+            for (int changesPerTag : {0, 4}) {
+                QTest::newRow(qPrintable(QString("tags=%1/changes=%2").arg(tags).arg(changesPerTag)))
+                    << tags << changesPerTag;
+            }
+        }
+    }
+
+    /**
+     * @brief 重启测试
+     */
+    void restart() {
+        QFETCH(int, tags);
+        QFETCH(int, changesPerTag);
+
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        const QString path = dir.filePath("persist.state");
+
+        qint64 checkpointMs = 0;
+        {
+            QVector<HYTagDefinition> definitions;
+            definitions.reserve(tags);
+            for (int i = 0; i < tags; ++i) {
+                definitions.append(HYTagDefinition{
+                    QString("plant.bf%1.zone%2.tag%3").arg(i % 4).arg((i / 4) % 64).arg(i),
+                    QString("Group_%1").arg(i % 64), double(i), QString("Bench tag %1").arg(i),
+                    QString("PLC%1").arg(i % 8)});
+            }
+
+            HYTagManager source;
+            QCOMPARE(source.addTagDefinitions(definitions), tags);
+            source.enablePersistence(true, path);
+
+            QElapsedTimer timer;
+            timer.start();
+            source.saveState();
+            checkpointMs = timer.elapsed();
+
+            // Changes after the checkpoint only reach the journal; the destructor writes out the tail
+            for (int round = 1; round <= changesPerTag; ++round) {
+                for (HYTagManager::TagId id = 0; id < tags; ++id) {
+                    source.setValue(id, HYTagValue::fromDouble(double(id) + round));
+                }
+            }
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+        HYTagManager manager;
+        manager.enablePersistence(true, path);
+        manager.loadState();
+        const qint64 elapsed = timer.elapsed();
+
+        QCOMPARE(manager.getAllTags().size(), tags);
+        QCOMPARE(manager.getTagValue("plant.bf1.zone0.tag1"), QVariant(1.0 + changesPerTag));
+        qInfo("tags=%8d  changes/tag=%d  checkpoint=%6lldms  restart=%6lldms  tags/s=%11.0f",
+              tags, changesPerTag, checkpointMs, elapsed, tags / qMax(0.001, elapsed / 1000.0));
+    }
+};
+
+QTEST_MAIN(BenchTagJournal)
+#include "bench_tagjournal.moc"
@@ -0,0 +1,142 @@
+#include <QTest>
+#include <QThread>
+#include <QMutex>
+#include <QElapsedTimer>
+#include <atomic>
+#include "tagmanager.h"
+
+/**
+ * @brief 点位读取竞争基准测试
+ *
+ * 一个写线程持续更新点位，N个读线程同时读取，比较互斥锁路径与无锁快照路径的吞吐量
+ * 互斥锁路径复刻了改造前HYTagManager的加锁方式：QMutex保护的按名称查找的映射表
+ */
+class BenchTagReadContention : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    /**
+     * @brief 初始化测试数据
+     */
+    void initTestCase() {
+        for (int i = 0; i < TagCount; ++i) {
+            m_names.append(QString("Bench_Tag_%1").arg(i));
+        }
+    }
+
+    /**
+     * @brief 读取竞争测试数据
+     */
+    void readContention_data() {
+        QTest::addColumn<QString>("mode");
+        QTest::addColumn<int>("readers");
+
+        const QStringList modes = {"mutex", "lockfree-name", "lockfree-id", "snapshot-8"};
+        for (const QString &mode : modes) {
+            for (int readers : {1, 4, 16}) {
+                QTest::newRow(qPrintable(QString("%1/%2").arg(mode).arg(readers))) << mode << readers;
+            }
+        }
+    }
+
+    /**
+     * @brief 读取竞争测试
+     */
+    void readContention() {
+        QFETCH(QString, mode);
+        QFETCH(int, readers);
+
+        std::atomic<bool> stop(false);
+        std::atomic<qint64> reads(0);
+        std::atomic<qint64> writes(0);
+
+        // 改造前的加锁路径
+        QMutex mutex;
+        QMap<QString, QVariant> lockedValues;
+
+        HYTagManager manager;
+        QVector<HYTagManager::TagId> ids;
+        for (const QString &name : m_names) {
+            manager.addTag(name, "Bench", 0.0);
+            ids.append(manager.resolveTag(name));
+            lockedValues.insert(name, 0.0);
+        }
+
+        QThread *writer = QThread::create([&]() {
+            qint64 count = 0;
+            double value = 0.0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                const int index = count % TagCount;
+                value += 1.0;
+                if (mode == "mutex") {
+                    QMutexLocker locker(&mutex);
+                    lockedValues[m_names[index]] = value;
+                } else {
+                    manager.setValue(ids[index], value);
+                }
+                ++count;
+            }
+            writes.store(count);
+        });
+
+        QVector<QThread *> readerThreads;
+        for (int r = 0; r < readers; ++r) {
+            readerThreads.append(QThread::create([&, r]() {
+                qint64 count = 0;
+                double sum = 0.0;
+                int index = r;
+                QVector<HYTagManager::TagId> group(8);
+                while (!stop.load(std::memory_order_relaxed)) {
+                    index = (index + 7) % TagCount;
+                    if (mode == "mutex") {
+                        QMutexLocker locker(&mutex);
+                        sum += lockedValues.value(m_names[index]).toDouble();
+                    } else if (mode == "lockfree-name") {
+                        sum += manager.getTagValue(m_names[index]).toDouble();
+                    } else if (mode == "lockfree-id") {
+                        sum += manager.value(ids[index]).toDouble();
+                    } else {
+                        for (int i = 0; i < group.size(); ++i) {
+                            group[i] = ids[(index + i) % TagCount];
+                        }
+                        sum += manager.snapshot(group).first().toDouble();
+                    }
+                    ++count;
+                }
+                reads.fetch_add(count);
+                Q_UNUSED(sum);
+            }));
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+        writer->start();
+        for (QThread *thread : readerThreads) {
+            thread->start();
+        }
+
+        QThread::msleep(DurationMs);
+        stop.store(true);
+
+        writer->wait();
+        for (QThread *thread : readerThreads) {
+            thread->wait();
+            delete thread;
+        }
+        delete writer;
+
+        const double seconds = timer.elapsed() / 1000.0;
+        qInfo("%-14s readers=%2d  reads/s=%12.0f  writes/s=%12.0f",
+              qPrintable(mode), readers, reads.load() / seconds, writes.load() / seconds);
+    }
+
+private:
+    static constexpr int TagCount = 10000; ///< 点位数量
+    static constexpr int DurationMs = 1000; ///< 每组测试时长（毫秒）
+
+    QStringList m_names; ///< 点位名称
+};
+
+QTEST_MAIN(BenchTagReadContention)
+#include "bench_tagreadcontention.moc"
@@ -0,0 +1,118 @@
+#include <QTest>
+#include <QThread>
+#include <QElapsedTimer>
+#include <atomic>
+#include "tagmanager.h"
+
+/**
+ * @brief 分片写入扩展性基准测试
+ *
+ * N个写线程模拟N个数据源，各自更新互不重叠的一组点位，统计总写入吞吐量随线程数的变化
+ * 分片数为1时等价于改造前的单锁结构，作为对照
+ */
+class BenchTagShardScaling : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    /**
+     * @brief 扩展性测试数据
+     */
+    void writeScaling_data() {
+        QTest::addColumn<QString>("mode");
+        QTest::addColumn<int>("shards");
+        QTest::addColumn<int>("writers");
+
+        // 线程数按2的幂递增直到核数
+        QVector<int> writerCounts;
+        const int cores = qMax(1, QThread::idealThreadCount());
+        for (int n = 1; n < cores; n *= 2) {
+            writerCounts.append(n);
+        }
+        writerCounts.append(cores);
+
+        for (const QString &mode : {QString("single"), QString("batch-32")}) {
+            for (int shards : {1, HYTagManager::DefaultShardCount}) {
+                for (int writers : writerCounts) {
+                    QTest::newRow(qPrintable(QString("%1/shards=%2/writers=%3").arg(mode).arg(shards).arg(writers)))
+                        << mode << shards << writers;
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief 扩展性测试
+     */
+    void writeScaling() {
+        QFETCH(QString, mode);
+        QFETCH(int, shards);
+        QFETCH(int, writers);
+
+        HYTagManager manager(shards);
+        QStringList names;
+        QVector<HYTagManager::TagId> ids;
+        for (int i = 0; i < TagCount; ++i) {
+            names.append(QString("Bench_Tag_%1").arg(i));
+            manager.addTag(names.last(), "Bench", 0.0);
+            ids.append(manager.resolveTag(names.last()));
+        }
+
+        std::atomic<bool> stop(false);
+        std::atomic<qint64> updates(0);
+        const int perWriter = TagCount / writers;
+
+        QVector<QThread *> threads;
+        for (int w = 0; w < writers; ++w) {
+            threads.append(QThread::create([&, w]() {
+                const int first = w * perWriter;
+                qint64 count = 0;
+                double value = 0.0;
+                int index = 0;
+                QMap<QString, QVariant> batch;
+                while (!stop.load(std::memory_order_relaxed)) {
+                    value += 1.0;
+                    if (mode == "single") {
+                        manager.setValue(ids[first + index], HYTagValue::fromDouble(value));
+                        index = (index + 1) % perWriter;
+                        ++count;
+                    } else {
+                        batch.clear();
+                        for (int i = 0; i < 32; ++i) {
+                            batch.insert(names[first + index], value);
+                            index = (index + 1) % perWriter;
+                        }
+                        manager.setTagValues(batch);
+                        count += batch.size();
+                    }
+                }
+                updates.fetch_add(count);
+            }));
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+        for (QThread *thread : threads) {
+            thread->start();
+        }
+
+        QThread::msleep(DurationMs);
+        stop.store(true);
+
+        for (QThread *thread : threads) {
+            thread->wait();
+            delete thread;
+        }
+
+        const double seconds = timer.elapsed() / 1000.0;
+        qInfo("%-8s shards=%2d  writers=%2d  updates/s=%12.0f",
+              qPrintable(mode), shards, writers, updates.load() / seconds);
+    }
+
+private:
+    static constexpr int TagCount = 16384; ///< 点位数量
+    static constexpr int DurationMs = 1000; ///< 每组测试时长（毫秒）
+};
+
+QTEST_MAIN(BenchTagShardScaling)
+#include "bench_tagshardscaling.moc"
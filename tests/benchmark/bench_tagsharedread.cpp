@@ -0,0 +1,90 @@
+#include <QTest>
+#include <QThread>
+#include <QProcess>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <atomic>
+#include "tagmanager.h"
+
+/**
+ * @brief 共享内存点位表跨进程读取基准测试
+ *
+ * 点位管理器把点位表发布到共享内存，另一个进程（bench_tagsharedread_reader）只链接读取库，
+ * 按名称查找全部点位后按下标循环读取，统计单次读取延迟的分位数和读取吞吐量
+ * 分别在发布端空闲和一个写线程持续更新点位时测量
+ */
+class BenchTagSharedRead : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    /**
+     * @brief 读取延迟测试数据
+     */
+    void readLatency_data() {
+        QTest::addColumn<int>("tags");
+        QTest::addColumn<bool>("writing");
+
+        for (int tags : {10000, 100000}) {
+            for (bool writing : {false, true}) {
+                QTest::newRow(qPrintable(QString("tags=%1/%2").arg(tags).arg(writing ? "writing" : "idle")))
+                    << tags << writing;
+            }
+        }
+    }
+
+    /**
+     * @brief 读取延迟测试
+     */
+    void readLatency() {
+        QFETCH(int, tags);
+        QFETCH(bool, writing);
+
+        QVector<HYTagDefinition> definitions;
+        definitions.reserve(tags);
+        for (int i = 0; i < tags; ++i) {
+            definitions.append(HYTagDefinition{QString("Bench_Tag_%1").arg(i), "Bench", double(i), QString(),
+                                               QString()});
+        }
+
+        HYTagManager manager;
+        QCOMPARE(manager.addTagDefinitions(definitions), tags);
+        const QString name = QString("huayan.bench.%1").arg(QCoreApplication::applicationPid());
+        QVERIFY(manager.publishSharedMemory(name, tags));
+
+        std::atomic<bool> stop(false);
+        std::atomic<qint64> writes(0);
+        QThread *writer = QThread::create([&]() {
+            qint64 count = 0;
+            while (writing && !stop.load(std::memory_order_relaxed)) {
+                manager.setValue(HYTagManager::TagId(count % tags), HYTagValue::fromDouble(double(count)));
+                ++count;
+            }
+            writes.store(count);
+        });
+        QElapsedTimer timer;
+        timer.start();
+        writer->start();
+
+        QProcess reader;
+        reader.start(QCoreApplication::applicationDirPath() + "/bench_tagsharedread_reader",
+                     {name, QString::number(tags), QString::number(DurationMs)});
+        const bool finished = reader.waitForFinished(DurationMs + 60000);
+        stop.store(true);
+        writer->wait();
+        delete writer;
+        const double seconds = timer.elapsed() / 1000.0;
+
+        QVERIFY(finished);
+        QCOMPARE(reader.exitCode(), 0);
+        const QString result = QString::fromUtf8(reader.readAllStandardOutput()).trimmed();
+        qInfo("tags=%7d  %-7s  writes/s=%11.0f  %s", tags, writing ? "writing" : "idle",
+              writes.load() / seconds, qPrintable(result));
+    }
+
+private:
+    static constexpr int DurationMs = 2000; ///< 每组读取时长（毫秒）
+};
+
+QTEST_MAIN(BenchTagSharedRead)
+#include "bench_tagsharedread.moc"
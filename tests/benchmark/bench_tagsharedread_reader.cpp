@@ -0,0 +1,75 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "tagsharedreader.h"
+
+/**
+ * @brief 共享内存点位表读取进程
+ *
+ * 由bench_tagsharedread启动，只使用读取库，不依赖Qt
+ * 参数：共享内存名称、点位数、测试时长（毫秒）
+ * 先按名称查找全部点位，再按下标循环读取；每64次读取计时一次，输出一行统计结果
+ */
+int main(int argc, char *argv[])
+{
+    if (argc < 4) {
+        std::fprintf(stderr, "usage: %s <name> <tags> <duration-ms>\n", argv[0]);
+        return 2;
+    }
+    const std::string name = argv[1];
+    const int tagCount = std::atoi(argv[2]);
+    const int durationMs = std::atoi(argv[3]);
+    constexpr int Batch = 64;
+
+    HYTagSharedReader reader;
+    if (!reader.open(name)) {
+        std::fprintf(stderr, "cannot open shared table %s\n", name.c_str());
+        return 1;
+    }
+
+    using Clock = std::chrono::steady_clock;
+    std::vector<int32_t> indexes;
+    indexes.reserve(size_t(tagCount));
+    const Clock::time_point lookupStart = Clock::now();
+    for (int i = 0; i < tagCount; ++i) {
+        indexes.push_back(reader.find("Bench_Tag_" + std::to_string(i)));
+    }
+    const double lookupNs = std::chrono::duration<double, std::nano>(Clock::now() - lookupStart).count() / tagCount;
+    if (std::count(indexes.begin(), indexes.end(), -1) > 0) {
+        std::fprintf(stderr, "missing tags in shared table\n");
+        return 1;
+    }
+
+    std::vector<double> batchNs;
+    batchNs.reserve(1 << 20);
+    HYTagSharedReader::Value value;
+    double sum = 0.0;
+    long long reads = 0;
+    size_t next = 0;
+    const Clock::time_point start = Clock::now();
+    const Clock::time_point end = start + std::chrono::milliseconds(durationMs);
+    while (Clock::now() < end) {
+        const Clock::time_point batchStart = Clock::now();
+        for (int i = 0; i < Batch; ++i) {
+            next = (next + 7) % indexes.size();
+            if (reader.read(indexes[next], &value)) {
+                sum += value.toDouble();
+            }
+        }
+        batchNs.push_back(std::chrono::duration<double, std::nano>(Clock::now() - batchStart).count() / Batch);
+        reads += Batch;
+    }
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::sort(batchNs.begin(), batchNs.end());
+    auto percentile = [&batchNs](double p) {
+        return batchNs.empty() ? 0.0 : batchNs[std::min(batchNs.size() - 1, size_t(p * batchNs.size()))];
+    };
+    std::printf("lookup_ns=%.1f read_p50_ns=%.1f read_p99_ns=%.1f read_p999_ns=%.1f reads_per_s=%.0f live=%d checksum=%g\n",
+                lookupNs, percentile(0.5), percentile(0.99), percentile(0.999), reads / seconds,
+                reader.isLive() ? 1 : 0, sum);
+    return 0;
+}
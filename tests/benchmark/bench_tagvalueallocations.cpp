@@ -0,0 +1,168 @@
+#include <QTest>
+#include <QElapsedTimer>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include "tagmanager.h"
+
+/**
+ * @brief 堆分配计数
+ *
+ * glibc下替换malloc、calloc和realloc，Qt容器直接用malloc分配的数据块也计入；
+ * 其他平台只统计经由operator new的分配，Qt容器的数据块不在统计范围内，输出中会注明
+ */
+static std::atomic<qint64> g_allocations(0);
+
+#if defined(__GLIBC__)
+static constexpr bool CountsMalloc = true;
+
+extern "C" void *__libc_malloc(std::size_t size);
+extern "C" void *__libc_calloc(std::size_t count, std::size_t size);
+extern "C" void *__libc_realloc(void *p, std::size_t size);
+
+extern "C" void *malloc(std::size_t size)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+extern "C" void *calloc(std::size_t count, std::size_t size)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+
+extern "C" void *realloc(void *p, std::size_t size)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(p, size);
+}
+#else
+static constexpr bool CountsMalloc = false;
+#endif
+
+void *operator new(std::size_t size)
+{
+    // With malloc replaced the allocation is counted there
+    if (!CountsMalloc) {
+        g_allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (void *p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+/**
+ * @brief 点位值更新分配次数基准测试
+ *
+ * 比较每次点位更新的堆分配次数和耗时：
+ * qvariant-tag复刻改造前的路径，值以QVariant保存在HYTag对象中并逐次比较
+ * manager-variant为经QVariant接口写入类型化存储，manager-typed为数据源使用的类型化接口
+ */
+class BenchTagValueAllocations : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    /**
+     * @brief 分配次数测试数据
+     */
+    void allocations_data() {
+        QTest::addColumn<QString>("mode");
+        QTest::addColumn<QString>("kind");
+
+        const QStringList modes = {"qvariant-tag", "manager-variant", "manager-typed"};
+        const QStringList kinds = {"double", "int", "bool", "string"};
+        for (const QString &mode : modes) {
+            for (const QString &kind : kinds) {
+                QTest::newRow(qPrintable(QString("%1/%2").arg(mode, kind))) << mode << kind;
+            }
+        }
+    }
+
+    /**
+     * @brief 分配次数测试
+     */
+    void allocations() {
+        QFETCH(QString, mode);
+        QFETCH(QString, kind);
+
+        HYTagManager manager;
+        manager.addTag("Bench_Tag", "Bench", QVariant());
+        const HYTagManager::TagId id = manager.resolveTag("Bench_Tag");
+        HYTag tag("Bench_Tag", "Bench", QVariant(), QString(), QString());
+
+        // Pre-built strings so that only the update path itself is measured
+        const QString states[2] = {QStringLiteral("Running"), QStringLiteral("Stopped")};
+        const HYTagValue typedStates[2] = {HYTagValue::fromString(states[0]), HYTagValue::fromString(states[1])};
+
+        auto update = [&](int i) {
+            if (mode == "manager-typed") {
+                HYTagValue value;
+                if (kind == "double") {
+                    value = HYTagValue::fromDouble(i * 0.5);
+                } else if (kind == "int") {
+                    value = HYTagValue::fromInt64(i);
+                } else if (kind == "bool") {
+                    value = HYTagValue::fromBool(i & 1);
+                } else {
+                    value = typedStates[i & 1];
+                }
+                manager.setValue(id, value);
+                return;
+            }
+
+            QVariant value;
+            if (kind == "double") {
+                value = i * 0.5;
+            } else if (kind == "int") {
+                value = i;
+            } else if (kind == "bool") {
+                value = bool(i & 1);
+            } else {
+                value = states[i & 1];
+            }
+            if (mode == "qvariant-tag") {
+                tag.setValue(value);
+            } else {
+                manager.setValue(id, value);
+            }
+        };
+
+        // Warm up interned strings and lazily created internals
+        for (int i = 0; i < 16; ++i) {
+            update(i);
+        }
+
+        QElapsedTimer timer;
+        const qint64 before = g_allocations.load();
+        timer.start();
+        for (int i = 0; i < Updates; ++i) {
+            update(i);
+        }
+        const qint64 elapsed = timer.nsecsElapsed();
+        const qint64 allocations = g_allocations.load() - before;
+
+        qInfo("%-16s %-7s allocs/update=%6.3f  ns/update=%8.1f%s",
+              qPrintable(mode), qPrintable(kind),
+              double(allocations) / Updates, double(elapsed) / Updates,
+              CountsMalloc ? "" : "  (operator new only)");
+    }
+
+private:
+    static constexpr int Updates = 1000000; ///< 每组更新次数
+};
+
+QTEST_MAIN(BenchTagValueAllocations)
+#include "bench_tagvalueallocations.moc"
@@ -0,0 +1,181 @@
+#include <QTest>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QHash>
+#include "timeseriesdatabase.h"
+
+/**
+ * @class InfluxStub
+ * @brief 只应答写入请求的本地InfluxDB替身，统计请求数
+ */
+class InfluxStub : public QObject
+{
+public:
+    explicit InfluxStub(QObject *parent = nullptr) : QObject(parent), m_requests(0) {
+        connect(&m_server, &QTcpServer::newConnection, this, &InfluxStub::accept);
+        m_server.listen(QHostAddress::LocalHost);
+    }
+
+    quint16 port() const { return m_server.serverPort(); }
+    qint64 requests() const { return m_requests; }
+
+private:
+    void accept() {
+        while (QTcpSocket *socket = m_server.nextPendingConnection()) {
+            connect(socket, &QTcpSocket::readyRead, this, [this, socket] { read(socket); });
+            connect(socket, &QTcpSocket::disconnected, this, [this, socket] {
+                m_buffers.remove(socket);
+                socket->deleteLater();
+            });
+        }
+    }
+
+    void read(QTcpSocket *socket) {
+        QByteArray &buffer = m_buffers[socket];
+        buffer.append(socket->readAll());
+        for (;;) {
+            const qsizetype headerEnd = buffer.indexOf("\r\n\r\n");
+            if (headerEnd < 0) {
+                return;
+            }
+            qsizetype length = 0;
+            for (const QByteArray &line : buffer.left(headerEnd).split('\n')) {
+                if (line.toLower().startsWith("content-length:")) {
+                    length = line.mid(15).trimmed().toLongLong();
+                }
+            }
+            if (buffer.size() < headerEnd + 4 + length) {
+                return;
+            }
+            buffer.remove(0, headerEnd + 4 + length);
+            ++m_requests;
+            socket->write("HTTP/1.1 204 No Content\r\nContent-Length: 0\r\n\r\n");
+        }
+    }
+
+    QTcpServer m_server; ///< 监听端口
+    QHash<QTcpSocket *, QByteArray> m_buffers; ///< 每个连接未处理的数据
+    qint64 m_requests; ///< 已应答的请求数
+};
+
+/**
+ * @brief 批量写入吞吐量基准测试
+ *
+ * 每轮调用一次storeTagValues写入1000个点位，比较原来逐个调用storeTagValue（每个值一条语句或一个请求）
+ * 与不同batchSize的批量写入的每秒写入值数；InfluxDB写入本地替身，只计请求开销，
+ * TimescaleDB在设置HY_BENCH_TIMESCALEDB（host;port;database;user;password）时测试
+ */
+class BenchTimeSeriesBatch : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    /**
+     * @brief 吞吐量测试数据
+     */
+    void throughput_data() {
+        QTest::addColumn<int>("type");
+        QTest::addColumn<int>("batchSize");
+
+        const QList<QPair<const char *, int>> backends = {{"sqlite", HYTimeSeriesDatabase::SQLITE},
+                                                          {"timescaledb", HYTimeSeriesDatabase::TIMESCALEDB},
+                                                          {"influxdb", HYTimeSeriesDatabase::INFLUXDB},
+                                                          {"embedded", HYTimeSeriesDatabase::EMBEDDED}};
+        for (const auto &backend : backends) {
+            for (int batchSize : {1, 100, 1000}) {
+                QTest::newRow(qPrintable(QString("%1/batch=%2").arg(backend.first).arg(batchSize)))
+                    << backend.second << batchSize;
+            }
+        }
+    }
+
+    /**
+     * @brief 吞吐量测试
+     */
+    void throughput() {
+        QFETCH(int, type);
+        QFETCH(int, batchSize);
+
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        InfluxStub stub;
+        HYTimeSeriesDatabase::DatabaseConfig config;
+        config.type = HYTimeSeriesDatabase::DatabaseType(type);
+        config.port = 0;
+        config.tableName = "bench_batch";
+        config.batchSize = batchSize;
+        switch (config.type) {
+        case HYTimeSeriesDatabase::SQLITE:
+            config.database = dir.filePath("history.db");
+            break;
+        case HYTimeSeriesDatabase::EMBEDDED:
+            config.database = dir.filePath("history.hycs");
+            break;
+        case HYTimeSeriesDatabase::INFLUXDB:
+            config.host = "127.0.0.1";
+            config.port = stub.port();
+            config.database = "bench";
+            break;
+        case HYTimeSeriesDatabase::TIMESCALEDB: {
+            const QStringList parts = qEnvironmentVariable("HY_BENCH_TIMESCALEDB").split(';');
+            if (parts.size() != 5) {
+                QSKIP("HY_BENCH_TIMESCALEDB is not set");
+            }
+            config.host = parts[0];
+            config.port = parts[1].toInt();
+            config.database = parts[2];
+            config.username = parts[3];
+            config.password = parts[4];
+            break;
+        }
+        }
+
+        HYTimeSeriesDatabase database;
+        QVERIFY(database.initialize(config));
+        database.clearData();
+
+        QMap<QString, QVariant> tagValues;
+        for (int i = 0; i < Tags; ++i) {
+            tagValues.insert(QString("Bench_Tag_%1").arg(i), double(i));
+        }
+
+        // 原来的写法：每个值单独一条语句或一个请求
+        QDateTime timestamp = QDateTime::fromMSecsSinceEpoch(Start);
+        QElapsedTimer timer;
+        timer.start();
+        for (int round = 0; round < Rounds; ++round) {
+            timestamp = timestamp.addSecs(1);
+            for (auto it = tagValues.cbegin(); it != tagValues.cend(); ++it) {
+                QVERIFY(database.storeTagValue(it.key(), it.value(), timestamp));
+            }
+        }
+        const qint64 singleNs = timer.nsecsElapsed();
+        const qint64 singleRequests = stub.requests();
+
+        timer.start();
+        for (int round = 0; round < Rounds; ++round) {
+            timestamp = timestamp.addSecs(1);
+            QVERIFY(database.storeTagValues(tagValues, timestamp));
+        }
+        const qint64 batchNs = timer.nsecsElapsed();
+        const qint64 batchRequests = stub.requests() - singleRequests;
+
+        database.clearData();
+        database.shutdown();
+
+        const double values = double(Tags) * Rounds;
+        qInfo("%-24s  per value: values/s=%10.0f  batched: values/s=%10.0f speedup=%6.1fx  http requests=%lld",
+              QTest::currentDataTag(), values * 1e9 / singleNs, values * 1e9 / batchNs, double(singleNs) / batchNs,
+              batchRequests);
+    }
+
+private:
+    static constexpr int Tags = 1000; ///< 每轮写入的点位数
+    static constexpr int Rounds = 5; ///< 轮数
+    static constexpr qint64 Start = 1767225600000; ///< 2026-01-01T00:00:00Z
+};
+
+QTEST_MAIN(BenchTimeSeriesBatch)
+#include "bench_timeseriesbatch.moc"
@@ -0,0 +1,92 @@
+#include <QTest>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+#include <limits>
+#include "timeseriesdatabase.h"
+
+/**
+ * @brief 长时间范围趋势加载基准测试
+ *
+ * 一个点位按1秒间隔写入7天数据（写入时维护汇总），比较读取全部原始样本的queryTagHistory
+ * 与按点数选取汇总的queryTagTrend加载整个范围的耗时
+ */
+class BenchTimeSeriesTrend : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    /**
+     * @brief 加载测试数据
+     */
+    void load_data() {
+        QTest::addColumn<int>("type");
+        QTest::addColumn<int>("points");
+
+        const QList<QPair<const char *, int>> backends = {{"sqlite", HYTimeSeriesDatabase::SQLITE},
+                                                          {"embedded", HYTimeSeriesDatabase::EMBEDDED}};
+        for (const auto &backend : backends) {
+            for (int points : {100, 500, 1000}) {
+                QTest::newRow(qPrintable(QString("%1/points=%2").arg(backend.first).arg(points)))
+                    << backend.second << points;
+            }
+        }
+    }
+
+    /**
+     * @brief 加载测试
+     */
+    void load() {
+        QFETCH(int, type);
+        QFETCH(int, points);
+
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        HYTimeSeriesDatabase::DatabaseConfig config;
+        config.type = HYTimeSeriesDatabase::DatabaseType(type);
+        config.port = 0;
+        config.tableName = "bench_trend";
+        config.database = dir.filePath(config.type == HYTimeSeriesDatabase::SQLITE ? "history.db" : "history.hycs");
+
+        HYTimeSeriesDatabase database;
+        QVERIFY(database.initialize(config));
+
+        // 每批一小时的数据
+        QElapsedTimer timer;
+        timer.start();
+        QVector<HYTimeSeriesDatabase::TagSample> samples(3600);
+        for (int hour = 0; hour < Days * 24; ++hour) {
+            for (int second = 0; second < 3600; ++second) {
+                const qint64 index = qint64(hour) * 3600 + second;
+                samples[second] = {"Bench_Trend", 50.0 + double(index % 600) / 10.0, Start + index * 1000};
+            }
+            QVERIFY(database.storeTagSamples(samples));
+        }
+        const qint64 ingestNs = timer.nsecsElapsed();
+
+        const QDateTime start = QDateTime::fromMSecsSinceEpoch(Start);
+        const QDateTime end = start.addDays(Days);
+        timer.start();
+        const QMap<QDateTime, QVariant> history =
+            database.queryTagHistory("Bench_Trend", start, end, std::numeric_limits<int>::max());
+        const qint64 rawNs = timer.nsecsElapsed();
+
+        timer.start();
+        const QVector<HYTimeSeriesDatabase::TrendPoint> trend = database.queryTagTrend("Bench_Trend", start, end, points);
+        const qint64 trendNs = timer.nsecsElapsed();
+        QVERIFY(trend.size() >= points);
+
+        database.shutdown();
+
+        qInfo("%-20s  ingest: values/s=%9.0f  raw: rows=%7lld ms=%8.1f  trend: interval=%5llds rows=%6lld ms=%7.2f  speedup=%7.1fx",
+              QTest::currentDataTag(), double(Days) * 86400 * 1e9 / ingestNs, qint64(history.size()), rawNs / 1e6,
+              HYTimeSeriesDatabase::trendInterval(end.toMSecsSinceEpoch() - Start, points) / 1000,
+              qint64(trend.size()), trendNs / 1e6, double(rawNs) / trendNs);
+    }
+
+private:
+    static constexpr int Days = 7; ///< 数据天数
+    static constexpr qint64 Start = 1767225600000; ///< 2026-01-01T00:00:00Z
+};
+
+QTEST_MAIN(BenchTimeSeriesTrend)
+#include "bench_timeseriestrend.moc"
@@ -0,0 +1,334 @@
+#include <QTest>
+#include <QSignalSpy>
+#include <QDateTime>
+#include "alarmmanager.h"
+
+/**
+ * @brief 告警管理器单元测试
+ *
+ * 测试告警定义的校验、限值/偏差/变化率/开关量告警的死区判断、触发和恢复延时、
+ * 告警表的确认和搁置，以及通过点位订阅按事件判断
+ */
+class TestAlarmManager : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    /**
+     * @brief 测试告警定义
+     */
+    void testDefinitions() {
+        HYTagManager manager;
+        QVERIFY(manager.addTag("Alarm_Level", "Test", 90.0));
+        HYAlarmManager alarms(&manager);
+
+        QString error;
+        QVERIFY(!alarms.addAlarm(definition("Missing.HI", "Missing", HYAlarmDefinition::High, 80), &error));
+        QVERIFY(error.contains("Missing"));
+        HYAlarmDefinition negative = definition("Level.HI", "Alarm_Level", HYAlarmDefinition::High, 80);
+        negative.deadband = -1.0;
+        QVERIFY(!alarms.addAlarm(negative));
+
+        // 添加时按点位的当前值判断
+        QVERIFY(alarms.addAlarm(definition("Level.HI", "Alarm_Level", HYAlarmDefinition::High, 80)));
+        QVERIFY(!alarms.addAlarm(definition("Level.HI", "Alarm_Level", HYAlarmDefinition::Low, 10), &error));
+        QCOMPARE(alarms.alarmCount(), 1);
+        QVERIFY(alarms.alarmState("Level.HI").active);
+        QCOMPARE(alarms.activeAlarms().size(), 1);
+
+        QVERIFY(alarms.removeAlarm("Level.HI"));
+        QVERIFY(!alarms.removeAlarm("Level.HI"));
+        QCOMPARE(alarms.alarmCount(), 0);
+        QVERIFY(alarms.activeAlarms().isEmpty());
+        QVERIFY(alarms.alarmState("Level.HI").name.isEmpty());
+
+        // 删除点位时其上的告警一并删除
+        QVERIFY(alarms.addAlarm(definition("Level.HI", "Alarm_Level", HYAlarmDefinition::High, 80)));
+        QVERIFY(alarms.addAlarm(definition("Level.LO", "Alarm_Level", HYAlarmDefinition::Low, 10)));
+        QVERIFY(manager.removeTag("Alarm_Level"));
+        QCOMPARE(alarms.alarmCount(), 0);
+        QVERIFY(alarms.activeAlarms().isEmpty());
+    }
+
+    /**
+     * @brief 测试高低限告警和死区
+     */
+    void testLimitAlarms() {
+        HYTagManager manager;
+        QVERIFY(manager.addTag("Alarm_Temp", "Test", 20.0));
+        const HYTagManager::TagId id = manager.resolveTag("Alarm_Temp");
+        HYAlarmManager alarms(&manager);
+
+        HYAlarmDefinition high = definition("Temp.HI", "Alarm_Temp", HYAlarmDefinition::High, 80);
+        high.deadband = 5.0;
+        HYAlarmDefinition low = definition("Temp.LO", "Alarm_Temp", HYAlarmDefinition::Low, 10);
+        low.deadband = 2.0;
+        QVERIFY(alarms.addAlarm(high));
+        QVERIFY(alarms.addAlarm(definition("Temp.HIHI", "Alarm_Temp", HYAlarmDefinition::HighHigh, 90)));
+        QVERIFY(alarms.addAlarm(low));
+        QVERIFY(alarms.addAlarm(definition("Temp.LOLO", "Alarm_Temp", HYAlarmDefinition::LowLow, 0)));
+        QVERIFY(alarms.activeAlarms().isEmpty());
+
+        QSignalSpy activated(&alarms, &HYAlarmManager::alarmActivated);
+        QSignalSpy cleared(&alarms, &HYAlarmManager::alarmCleared);
+
+        QCOMPARE(alarms.evaluate({update(id, 85.0)}), 1);
+        QVERIFY(alarms.alarmState("Temp.HI").active);
+        QVERIFY(!alarms.alarmState("Temp.HIHI").active);
+        QCOMPARE(alarms.evaluate({update(id, 92.0)}), 1);
+        QVERIFY(alarms.alarmState("Temp.HIHI").active);
+
+        // 高高限没有死区立即恢复，高限在死区内保持
+        QCOMPARE(alarms.evaluate({update(id, 78.0)}), 1);
+        QVERIFY(!alarms.alarmState("Temp.HIHI").active);
+        QVERIFY(alarms.alarmState("Temp.HI").active);
+        QCOMPARE(alarms.alarmState("Temp.HI").value, 78.0);
+        QCOMPARE(alarms.evaluate({update(id, 74.0)}), 1);
+        QVERIFY(!alarms.alarmState("Temp.HI").active);
+
+        QCOMPARE(alarms.evaluate({update(id, 5.0)}), 1);
+        QCOMPARE(alarms.evaluate({update(id, 11.0)}), 0);
+        QVERIFY(alarms.alarmState("Temp.LO").active);
+        QCOMPARE(alarms.evaluate({update(id, 13.0)}), 1);
+        QCOMPARE(alarms.evaluate({update(id, -1.0)}), 2);
+
+        QCOMPARE(activated.count(), 5);
+        QCOMPARE(cleared.count(), 3);
+        QCOMPARE(activated.first().at(0).toString(), QString("Temp.HI"));
+        QCOMPARE(cleared.first().at(0).toString(), QString("Temp.HIHI"));
+
+        // 坏值和非数值不改变告警状态
+        HYTagUpdate bad = update(id, 50.0);
+        bad.quality = HYTagValueStore::QualityCommFailure;
+        QCOMPARE(alarms.evaluate({bad}), 0);
+        HYTagUpdate text;
+        text.id = id;
+        text.value = HYTagValue::fromString("offline");
+        QCOMPARE(alarms.evaluate({text}), 0);
+        QVERIFY(alarms.alarmState("Temp.LOLO").active);
+    }
+
+    /**
+     * @brief 测试偏差和开关量告警
+     */
+    void testDeviationAndDiscrete() {
+        HYTagManager manager;
+        QVERIFY(manager.addTag("Alarm_Flow", "Test", 50.0));
+        QVERIFY(manager.addTag("Alarm_Pump", "Test", false));
+        const HYTagManager::TagId flow = manager.resolveTag("Alarm_Flow");
+        const HYTagManager::TagId pump = manager.resolveTag("Alarm_Pump");
+        HYAlarmManager alarms(&manager);
+
+        HYAlarmDefinition deviation = definition("Flow.DEV", "Alarm_Flow", HYAlarmDefinition::Deviation, 10);
+        deviation.setpoint = 50.0;
+        deviation.deadband = 1.0;
+        QVERIFY(alarms.addAlarm(deviation));
+        QVERIFY(alarms.addAlarm(definition("Pump.TRIP", "Alarm_Pump", HYAlarmDefinition::Discrete, 1)));
+
+        QCOMPARE(alarms.evaluate({update(flow, 39.0)}), 1);
+        QCOMPARE(alarms.evaluate({update(flow, 59.5)}), 0);
+        QVERIFY(alarms.alarmState("Flow.DEV").active);
+        QCOMPARE(alarms.evaluate({update(flow, 58.0)}), 1);
+        QVERIFY(!alarms.alarmState("Flow.DEV").active);
+
+        HYTagUpdate trip;
+        trip.id = pump;
+        trip.value = HYTagValue::fromBool(true);
+        QCOMPARE(alarms.evaluate({trip}), 1);
+        QVERIFY(alarms.alarmState("Pump.TRIP").active);
+        trip.value = HYTagValue::fromBool(false);
+        QCOMPARE(alarms.evaluate({trip}), 1);
+        QVERIFY(!alarms.alarmState("Pump.TRIP").active);
+    }
+
+    /**
+     * @brief 测试变化率告警
+     */
+    void testRateOfChange() {
+        HYTagManager manager;
+        QVERIFY(manager.addTag("Alarm_Pressure", "Test", 0.0));
+        const HYTagManager::TagId id = manager.resolveTag("Alarm_Pressure");
+        HYAlarmManager alarms(&manager);
+        QVERIFY(alarms.addAlarm(definition("Pressure.ROC", "Alarm_Pressure", HYAlarmDefinition::RateOfChange, 5)));
+
+        // 变化率按源时间戳计算，单位为每秒
+        const qint64 base = QDateTime::currentMSecsSinceEpoch() + 1000;
+        QCOMPARE(alarms.evaluate({update(id, 1.0, base)}), 0);
+        QCOMPARE(alarms.evaluate({update(id, 2.0, base + 1000)}), 0);
+        QCOMPARE(alarms.evaluate({update(id, 12.0, base + 2000)}), 1);
+        QVERIFY(alarms.alarmState("Pressure.ROC").active);
+        QCOMPARE(alarms.evaluate({update(id, 12.0, base + 2000)}), 0);
+        QCOMPARE(alarms.evaluate({update(id, 13.0, base + 3000)}), 1);
+        QVERIFY(!alarms.alarmState("Pressure.ROC").active);
+
+        // 不再有新值时回落
+        QCOMPARE(alarms.evaluate({update(id, 23.0, base + 4000)}), 1);
+        QTRY_VERIFY(!alarms.alarmState("Pressure.ROC").active);
+    }
+
+    /**
+     * @brief 测试触发和恢复延时
+     */
+    void testDelays() {
+        HYTagManager manager;
+        QVERIFY(manager.addTag("Alarm_Delay", "Test", 0.0));
+        const HYTagManager::TagId id = manager.resolveTag("Alarm_Delay");
+        HYAlarmManager alarms(&manager);
+
+        HYAlarmDefinition high = definition("Delay.HI", "Alarm_Delay", HYAlarmDefinition::High, 50);
+        high.onDelay = 100;
+        high.offDelay = 100;
+        QVERIFY(alarms.addAlarm(high));
+        QSignalSpy activated(&alarms, &HYAlarmManager::alarmActivated);
+        QSignalSpy cleared(&alarms, &HYAlarmManager::alarmCleared);
+
+        // 短暂越限不触发
+        QCOMPARE(alarms.evaluate({update(id, 60.0)}), 0);
+        QCOMPARE(alarms.evaluate({update(id, 40.0)}), 0);
+        QTest::qWait(250);
+        QCOMPARE(activated.count(), 0);
+
+        // 持续越限在延时后触发
+        QCOMPARE(alarms.evaluate({update(id, 60.0)}), 0);
+        QVERIFY(!alarms.alarmState("Delay.HI").active);
+        QTRY_VERIFY(alarms.alarmState("Delay.HI").active);
+        QCOMPARE(activated.count(), 1);
+
+        // 短暂回落不恢复，持续回落在延时后恢复
+        QCOMPARE(alarms.evaluate({update(id, 40.0)}), 0);
+        QCOMPARE(alarms.evaluate({update(id, 60.0)}), 0);
+        QTest::qWait(250);
+        QCOMPARE(cleared.count(), 0);
+        QCOMPARE(alarms.evaluate({update(id, 40.0)}), 0);
+        QTRY_VERIFY(!alarms.alarmState("Delay.HI").active);
+        QCOMPARE(cleared.count(), 1);
+    }
+
+    /**
+     * @brief 测试告警表的确认和搁置
+     */
+    void testAcknowledgeAndShelve() {
+        HYTagManager manager;
+        QVERIFY(manager.addTag("Alarm_A", "Test", 0.0));
+        QVERIFY(manager.addTag("Alarm_B", "Test", 0.0));
+        const HYTagManager::TagId a = manager.resolveTag("Alarm_A");
+        const HYTagManager::TagId b = manager.resolveTag("Alarm_B");
+        HYAlarmManager alarms(&manager);
+
+        HYAlarmDefinition major = definition("A.HI", "Alarm_A", HYAlarmDefinition::High, 10);
+        major.severity = 800;
+        major.message = "A high";
+        HYAlarmDefinition minor = definition("B.HI", "Alarm_B", HYAlarmDefinition::High, 10);
+        minor.severity = 300;
+        QVERIFY(alarms.addAlarm(minor));
+        QVERIFY(alarms.addAlarm(major));
+
+        QCOMPARE(alarms.evaluate({update(b, 20.0), update(a, 20.0)}), 2);
+        QVector<HYAlarmState> table = alarms.activeAlarms();
+        QCOMPARE(table.size(), 2);
+        QCOMPARE(table[0].name, QString("A.HI"));
+        QCOMPARE(table[0].message, QString("A high"));
+        QVERIFY(!table[0].acknowledged);
+        QVERIFY(table[0].activeTime > 0);
+
+        // 已确认的告警恢复后移出告警表
+        QSignalSpy acknowledged(&alarms, &HYAlarmManager::alarmAcknowledged);
+        QVERIFY(alarms.acknowledge("A.HI"));
+        QVERIFY(!alarms.acknowledge("A.HI"));
+        QCOMPARE(acknowledged.count(), 1);
+        QCOMPARE(alarms.activeAlarms().size(), 2);
+        QCOMPARE(alarms.evaluate({update(a, 0.0)}), 1);
+        QCOMPARE(alarms.activeAlarms().size(), 1);
+
+        // 未确认的告警恢复后留在告警表中
+        QCOMPARE(alarms.evaluate({update(b, 0.0)}), 1);
+        table = alarms.activeAlarms();
+        QCOMPARE(table.size(), 1);
+        QVERIFY(!table[0].active);
+        QVERIFY(!table[0].acknowledged);
+        QVERIFY(table[0].clearTime >= table[0].activeTime);
+        QCOMPARE(alarms.acknowledgeAll(), 1);
+        QVERIFY(alarms.activeAlarms().isEmpty());
+
+        // 搁置的告警照常判断但不通知，也不在告警表中
+        QSignalSpy activated(&alarms, &HYAlarmManager::alarmActivated);
+        QSignalSpy shelved(&alarms, &HYAlarmManager::alarmShelved);
+        QVERIFY(alarms.shelve("A.HI"));
+        QCOMPARE(alarms.evaluate({update(a, 20.0)}), 1);
+        QCOMPARE(activated.count(), 0);
+        QVERIFY(alarms.activeAlarms().isEmpty());
+        QVERIFY(alarms.alarmState("A.HI").active);
+        QVERIFY(alarms.alarmState("A.HI").shelved);
+        QCOMPARE(alarms.acknowledgeAll(), 0);
+
+        // 取消搁置后重新通知仍在告警的告警
+        QVERIFY(alarms.unshelve("A.HI"));
+        QVERIFY(!alarms.unshelve("A.HI"));
+        QCOMPARE(activated.count(), 1);
+        QCOMPARE(alarms.activeAlarms().size(), 1);
+
+        // 定时搁置到期后自动取消
+        QVERIFY(alarms.shelve("B.HI", 100));
+        QVERIFY(alarms.alarmState("B.HI").shelved);
+        QTRY_VERIFY(!alarms.alarmState("B.HI").shelved);
+        QCOMPARE(shelved.count(), 4);
+        QVERIFY(!shelved.last().at(1).toBool());
+    }
+
+    /**
+     * @brief 测试通过点位订阅按事件判断
+     */
+    void testTagSubscription() {
+        HYTagManager manager;
+        QVERIFY(manager.addTag("Alarm_Live", "Test", 0.0));
+        QVERIFY(manager.addTag("Alarm_Other", "Test", 0.0));
+        const HYTagManager::TagId id = manager.resolveTag("Alarm_Live");
+        HYAlarmManager alarms(&manager);
+        QVERIFY(alarms.addAlarm(definition("Live.HI", "Alarm_Live", HYAlarmDefinition::High, 80)));
+
+        QSignalSpy activated(&alarms, &HYAlarmManager::alarmActivated);
+        QVERIFY(manager.setTagValue("Alarm_Other", 100.0));
+        QVERIFY(manager.setValue(id, HYTagValue::fromDouble(95.0)));
+        QTRY_VERIFY(alarms.alarmState("Live.HI").active);
+        QCOMPARE(activated.count(), 1);
+        QCOMPARE(activated.first().at(0).toString(), QString("Live.HI"));
+
+        // 通信中断的点位保持告警状态
+        QVERIFY(manager.setValue(id, HYTagValue::fromDouble(0.0), QDateTime::currentMSecsSinceEpoch(),
+                                 HYTagValueStore::QualityCommFailure));
+        QTest::qWait(100);
+        QVERIFY(alarms.alarmState("Live.HI").active);
+
+        QVERIFY(manager.setValue(id, HYTagValue::fromDouble(10.0), QDateTime::currentMSecsSinceEpoch(),
+                                 HYTagValueStore::QualityGood));
+        QTRY_VERIFY(!alarms.alarmState("Live.HI").active);
+    }
+
+private:
+    /**
+     * @brief 构造告警定义
+     */
+    static HYAlarmDefinition definition(const QString &name, const QString &tagName, HYAlarmDefinition::Type type,
+                                        double limit) {
+        HYAlarmDefinition result;
+        result.name = name;
+        result.tagName = tagName;
+        result.type = type;
+        result.limit = limit;
+        return result;
+    }
+
+    /**
+     * @brief 构造好值更新
+     */
+    static HYTagUpdate update(HYTagManager::TagId id, double value, qint64 timestamp = 0) {
+        HYTagUpdate result;
+        result.id = id;
+        result.timestamp = timestamp ? timestamp : QDateTime::currentMSecsSinceEpoch();
+        result.value = HYTagValue::fromDouble(value);
+        return result;
+    }
+};
+
+QTEST_MAIN(TestAlarmManager)
+#include "test_alarmmanager.moc"
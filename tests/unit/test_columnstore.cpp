@@ -0,0 +1,284 @@
+#include <QTest>
+#include <QTemporaryDir>
+#include <QFile>
+#include <cmath>
+#include "columnstore.h"
+
+/**
+ * @brief 内置列式存储单元测试
+ *
+ * 测试压缩编码的往返、只解码重叠块的范围查询、乱序和重复写入的覆盖、字符串和编码切换、
+ * 末尾不完整记录的丢弃、清空，以及等间隔采样的压缩率
+ */
+class TestColumnStore : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    /**
+     * @brief 测试初始化
+     */
+    void init() {
+        QVERIFY(m_dir.isValid());
+        m_path = m_dir.filePath(QString("store_%1.hycs").arg(m_count++));
+    }
+
+    /**
+     * @brief 测试编码往返
+     *
+     * 时间戳覆盖差值的差值的每一档，值覆盖不变、小幅变化、符号变化和整数，重新打开后一致
+     */
+    void testRoundTrip() {
+        QVector<HYColumnStore::Sample> samples;
+        qint64 timestamp = Day0;
+        double value = 20.0;
+        static constexpr qint64 Jitters[] = {0, 0, 0, 5, -40, 0, 200, -250, 1500, -900, 0, 5000000, 1};
+        for (int i = 0; i < 3000; ++i) {
+            timestamp += 1000 + Jitters[i % 13];
+            switch (i % 5) {
+            case 0:
+                break;
+            case 1:
+                value += 0.25;
+                break;
+            case 2:
+                value = -value * 1.5;
+                break;
+            case 3:
+                value = std::sin(i) * 1e6;
+                break;
+            default:
+                value = double(i);
+                break;
+            }
+            samples.append(HYColumnStore::Sample{timestamp, value});
+        }
+
+        HYColumnStore store;
+        QVERIFY(store.open(m_path));
+        QVERIFY(store.append("Flow", samples));
+        QCOMPARE(store.chunkCount(), 2);
+        verify(store.query("Flow", samples.first().timestamp, samples.last().timestamp), samples);
+
+        store.close();
+        QVERIFY(store.open(m_path));
+        QCOMPARE(store.chunkCount(), 3);
+        QCOMPARE(store.seriesNames(), QStringList({"Flow"}));
+        verify(store.query("Flow", samples.first().timestamp, samples.last().timestamp), samples);
+        QVERIFY(store.query("Missing", 0, Day0 * 2).isEmpty());
+    }
+
+    /**
+     * @brief 测试范围查询只解码重叠的块
+     */
+    void testRangeScan() {
+        HYColumnStore store;
+        QVERIFY(store.open(m_path));
+        const int chunks = 10;
+        QVERIFY(store.append("Level", regular(Day0, chunks * HYColumnStore::ChunkSamples + 100)));
+        QCOMPARE(store.chunkCount(), chunks);
+
+        // 落在第4块内
+        const qint64 chunkMs = qint64(HYColumnStore::ChunkSamples) * 1000;
+        quint64 decoded = store.decodedChunks();
+        QVector<HYColumnStore::Sample> result = store.query("Level", Day0 + 3 * chunkMs + 10000, Day0 + 3 * chunkMs + 19000);
+        QCOMPARE(result.size(), 10);
+        QCOMPARE(result.first().timestamp, Day0 + 3 * chunkMs + 10000);
+        QCOMPARE(store.decodedChunks() - decoded, quint64(1));
+
+        // 跨第4和第5块
+        decoded = store.decodedChunks();
+        result = store.query("Level", Day0 + 4 * chunkMs - 5000, Day0 + 4 * chunkMs + 4000);
+        QCOMPARE(result.size(), 10);
+        QCOMPARE(store.decodedChunks() - decoded, quint64(2));
+
+        // 只落在开放块内
+        decoded = store.decodedChunks();
+        result = store.query("Level", Day0 + chunks * chunkMs, Day0 + chunks * chunkMs + 1000000);
+        QCOMPARE(result.size(), 100);
+        QCOMPARE(store.decodedChunks(), decoded);
+
+        // 超出限制时返回最新的样本
+        result = store.query("Level", Day0, Day0 + chunks * chunkMs * 2, 5);
+        QCOMPARE(result.size(), 5);
+        QCOMPARE(result.last().timestamp, Day0 + (chunks * HYColumnStore::ChunkSamples + 99) * 1000);
+    }
+
+    /**
+     * @brief 测试乱序和重复写入
+     *
+     * 同一时间戳以最后写入的为准，包括覆盖已落盘块中的样本
+     */
+    void testOverwrite() {
+        HYColumnStore store;
+        QVERIFY(store.open(m_path));
+        const int count = HYColumnStore::ChunkSamples + 100;
+        QVERIFY(store.append("Level", regular(Day0, count)));
+        QCOMPARE(store.chunkCount(), 1);
+
+        // 一批中的乱序样本：覆盖已落盘块和开放块，插入新时间戳，同一时间戳以后面的为准
+        QVERIFY(store.append("Level", {HYColumnStore::Sample{Day0 + 5000, -1.0},
+                                       HYColumnStore::Sample{Day0 + (count - 10) * 1000, -2.0},
+                                       HYColumnStore::Sample{Day0 + 500, -3.0},
+                                       HYColumnStore::Sample{Day0 + 500, -4.0}}));
+
+        for (int pass = 0; pass < 2; ++pass) {
+            const QVector<HYColumnStore::Sample> result = store.query("Level", Day0, Day0 + count * 1000);
+            QCOMPARE(result.size(), count + 1);
+            for (int i = 1; i < result.size(); ++i) {
+                QVERIFY(result[i - 1].timestamp < result[i].timestamp);
+            }
+            QCOMPARE(result[1].timestamp, Day0 + 500);
+            QCOMPARE(result[1].value.toDouble(), -4.0);
+            QCOMPARE(result[6].value.toDouble(), -1.0);
+            QCOMPARE(result[count - 9].value.toDouble(), -2.0);
+            QCOMPARE(result.last().value.toDouble(), double(count - 1));
+
+            store.close();
+            QVERIFY(store.open(m_path));
+        }
+    }
+
+    /**
+     * @brief 测试字符串值和编码切换
+     */
+    void testTextValues() {
+        HYColumnStore store;
+        QVERIFY(store.open(m_path));
+        QVERIFY(store.append("State", {HYColumnStore::Sample{Day0, 1.5},
+                                       HYColumnStore::Sample{Day0 + 1000, QString("运行")},
+                                       HYColumnStore::Sample{Day0 + 2000, QString()},
+                                       HYColumnStore::Sample{Day0 + 3000, true},
+                                       HYColumnStore::Sample{Day0 + 4000, qint64(42)}}));
+        // 数值块和字符串块交替时各自落盘
+        QCOMPARE(store.chunkCount(), 2);
+        QVERIFY(store.flush());
+
+        QVERIFY(store.open(m_path));
+        const QVector<HYColumnStore::Sample> result = store.query("State", Day0, Day0 + 4000);
+        QCOMPARE(result.size(), 5);
+        QCOMPARE(result[0].value.toDouble(), 1.5);
+        QCOMPARE(result[1].value.typeId(), int(QMetaType::QString));
+        QCOMPARE(result[1].value.toString(), QString("运行"));
+        QCOMPARE(result[2].value.toString(), QString());
+        QCOMPARE(result[3].value.typeId(), int(QMetaType::Double));
+        QCOMPARE(result[3].value.toDouble(), 1.0);
+        QCOMPARE(result[4].value.toDouble(), 42.0);
+    }
+
+    /**
+     * @brief 测试丢弃末尾不完整的记录
+     */
+    void testTruncatedTail() {
+        HYColumnStore store;
+        QVERIFY(store.open(m_path));
+        QVERIFY(store.append("Level", regular(Day0, 2 * HYColumnStore::ChunkSamples)));
+        const qint64 complete = store.fileSize();
+        QVERIFY(store.append("Level", regular(Day0 + 2 * HYColumnStore::ChunkSamples * 1000, 10)));
+        store.close();
+
+        // 截掉最后一块的末尾，模拟写入时崩溃
+        QFile file(m_path);
+        QVERIFY(file.open(QIODevice::ReadWrite));
+        QVERIFY(file.size() > complete);
+        QVERIFY(file.resize(file.size() - 3));
+        file.close();
+
+        QVERIFY(store.open(m_path));
+        QCOMPARE(store.fileSize(), complete);
+        QCOMPARE(store.chunkCount(), 2);
+        QCOMPARE(store.query("Level", Day0, Day0 * 2).size(), 2 * HYColumnStore::ChunkSamples);
+
+        // 截断后可以继续追加
+        QVERIFY(store.append("Level", regular(Day0 - 10000, 5)));
+        store.close();
+        QVERIFY(store.open(m_path));
+        QCOMPARE(store.query("Level", Day0 - 10000, Day0 * 2).size(), 2 * HYColumnStore::ChunkSamples + 5);
+    }
+
+    /**
+     * @brief 测试清空
+     */
+    void testClear() {
+        HYColumnStore store;
+        QVERIFY(store.open(m_path));
+        QVERIFY(store.append("Level", regular(Day0, 2000)));
+        QVERIFY(store.append("Flow", regular(Day0, 2000)));
+        QVERIFY(store.clear("Level"));
+        QVERIFY(store.clear("Missing"));
+        QVERIFY(store.query("Level", Day0, Day0 * 2).isEmpty());
+        QCOMPARE(store.seriesNames(), QStringList({"Flow"}));
+
+        // 清空后写入的数据重新打开后仍在，清空前的数据不恢复
+        QVERIFY(store.append("Level", regular(Day0 + 500, 3)));
+        store.close();
+        QVERIFY(store.open(m_path));
+        QCOMPARE(store.query("Level", Day0, Day0 * 2).size(), 3);
+        QCOMPARE(store.query("Flow", Day0, Day0 * 2).size(), 2000);
+
+        QVERIFY(store.clear());
+        QCOMPARE(store.fileSize(), qint64(0));
+        QVERIFY(store.seriesNames().isEmpty());
+        QVERIFY(store.append("Flow", regular(Day0, 3)));
+        QCOMPARE(store.query("Flow", Day0, Day0 * 2).size(), 3);
+    }
+
+    /**
+     * @brief 测试等间隔采样的压缩率
+     *
+     * 不变的值每个样本约2位，按整数步进的值不超过2字节，原始样本为16字节
+     */
+    void testCompression() {
+        const int count = 10 * HYColumnStore::ChunkSamples;
+        QVector<HYColumnStore::Sample> constant;
+        QVector<HYColumnStore::Sample> stepped;
+        for (int i = 0; i < count; ++i) {
+            constant.append(HYColumnStore::Sample{Day0 + i * 1000, 50.0});
+            stepped.append(HYColumnStore::Sample{Day0 + i * 1000, 500.0 + (i / 10) % 7});
+        }
+
+        HYColumnStore store;
+        QVERIFY(store.open(m_path));
+        QVERIFY(store.append("Constant", constant));
+        const qint64 constantBytes = store.fileSize();
+        QVERIFY(store.append("Stepped", stepped));
+        const qint64 steppedBytes = store.fileSize() - constantBytes;
+
+        QVERIFY2(constantBytes < count / 2, qPrintable(QString::number(constantBytes)));
+        QVERIFY2(steppedBytes < count * 2, qPrintable(QString::number(steppedBytes)));
+        verify(store.query("Stepped", Day0, Day0 + count * 1000), stepped);
+    }
+
+private:
+    static constexpr qint64 Day0 = 1767225600000; ///< 2026-01-01T00:00:00Z
+
+    /**
+     * @brief 构造每秒一个的样本，值为序号
+     */
+    static QVector<HYColumnStore::Sample> regular(qint64 start, int count) {
+        QVector<HYColumnStore::Sample> samples;
+        samples.reserve(count);
+        for (int i = 0; i < count; ++i) {
+            samples.append(HYColumnStore::Sample{start + i * 1000, double(i)});
+        }
+        return samples;
+    }
+
+    /**
+     * @brief 逐个比较样本
+     */
+    static void verify(const QVector<HYColumnStore::Sample> &actual, const QVector<HYColumnStore::Sample> &expected) {
+        QCOMPARE(actual.size(), expected.size());
+        for (int i = 0; i < actual.size(); ++i) {
+            QCOMPARE(actual[i].timestamp, expected[i].timestamp);
+            QCOMPARE(actual[i].value.toDouble(), expected[i].value.toDouble());
+        }
+    }
+
+    QTemporaryDir m_dir; ///< 测试数据目录
+    QString m_path; ///< 当前测试的存储文件
+    int m_count = 0; ///< 已创建的存储文件数
+};
+
+QTEST_MAIN(TestColumnStore)
+#include "test_columnstore.moc"
@@ -1,9 +1,12 @@
 #include <QTest>
 #include <QSignalSpy>
 #include <QTimer>
+#include <QTemporaryDir>
 #include "dataprocessor.h"
 #include "tagmanager.h"
 #include "hymodbustcpdriver.h"
+#include "timeseriesdatabase.h"
+#include "historianwriter.h"
 
 // 模拟Modbus TCP驱动类
 class MockModbusTcpDriver : public HYModbusTcpDriver
@@ -216,6 +219,50 @@ private slots:
         QCOMPARE(stopSpy.count(), 1);
     }
 
+    /**
+     * @brief 测试异步历史写入
+     * 
+     * 设置写入器后采集到的值进入写入器的队列，不直接写入数据库，flush()之后才能查到
+     */
+    void testHistorianWriter() {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        HYTimeSeriesDatabase::DatabaseConfig config;
+        config.type = HYTimeSeriesDatabase::SQLITE;
+        config.port = 0;
+        config.database = dir.filePath("history.db");
+        config.tableName = "history";
+
+        HYTimeSeriesDatabase database;
+        QVERIFY(database.initialize(config));
+        HYHistorianWriter writer;
+        writer.setFlushInterval(60000);
+        QVERIFY(writer.start(config));
+
+        HYDataProcessor processor;
+        processor.initialize(modbusDriver, tagManager);
+        processor.setTimeSeriesDatabase(&database);
+        processor.setHistorianWriter(&writer);
+        tagManager->addTag("Historian_Test", "Test_Group", 0);
+        QVERIFY(processor.mapTagToDeviceRegister("Historian_Test", 120));
+        modbusDriver->registers[120] = 42;
+
+        // 采集一次
+        QVERIFY(QMetaObject::invokeMethod(&processor, "collectData"));
+
+        const HYHistorianWriter::Metrics metrics = writer.metrics();
+        QCOMPARE(metrics.enqueued, quint64(1));
+        QCOMPARE(metrics.queueDepth, 1);
+        const QDateTime now = QDateTime::currentDateTime();
+        QVERIFY(database.queryTagHistory("Historian_Test", now.addSecs(-3600), now.addSecs(3600)).isEmpty());
+
+        QVERIFY(writer.flush(5000));
+        const QMap<QDateTime, QVariant> history = database.queryTagHistory("Historian_Test", now.addSecs(-3600), now.addSecs(3600));
+        QCOMPARE(history.size(), 1);
+        QCOMPARE(history.first().toDouble(), 42.0);
+        writer.stop();
+    }
+
 private:
     HYDataProcessor *dataProcessor; ///< 数据处理器实例
     HYTagManager *tagManager; ///< 标签管理器实例
@@ -0,0 +1,229 @@
+#include <QTest>
+#include <QTemporaryDir>
+#include <QDateTime>
+#include "historianwriter.h"
+
+/**
+ * @brief 异步历史写入器单元测试
+ *
+ * 写入线程写入临时SQLite文件，另一个连接读回；测试按批大小和等待时间成批写入、三种溢出策略、
+ * 停止时写入剩余的值，以及运行指标
+ */
+class TestHistorianWriter : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    /**
+     * @brief 测试初始化
+     */
+    void init() {
+        QVERIFY(m_dir.isValid());
+        m_config.type = HYTimeSeriesDatabase::SQLITE;
+        m_config.port = 0;
+        m_config.database = m_dir.filePath(QString("history_%1.db").arg(m_count++));
+        m_config.tableName = "history";
+    }
+
+    /**
+     * @brief 测试启动失败
+     */
+    void testStartFailure() {
+        HYHistorianWriter writer;
+        QVERIFY(!writer.enqueue("Level", 1.0, Day0));
+
+        QString error;
+        writer.setOverflowPolicy(HYHistorianWriter::OverflowSpill);
+        QVERIFY(!writer.start(m_config, &error));
+        QCOMPARE(error, QString("spill directory is not set"));
+
+        writer.setOverflowPolicy(HYHistorianWriter::OverflowBlock);
+        HYTimeSeriesDatabase::DatabaseConfig config = m_config;
+        config.database = m_dir.filePath("missing/history.db");
+        QVERIFY(!writer.start(config, &error));
+        QVERIFY(!error.isEmpty());
+        QVERIFY(!writer.isRunning());
+    }
+
+    /**
+     * @brief 测试按批大小写入
+     *
+     * 满一批立即写入，不满一批的值等到flush()
+     */
+    void testBatchBySize() {
+        HYHistorianWriter writer;
+        writer.setBatchSize(10);
+        writer.setFlushInterval(60000);
+        QVERIFY(writer.start(m_config));
+
+        QVERIFY(writer.enqueue(samples("Level", 0, 25)));
+        QTRY_COMPARE(writer.metrics().written, quint64(20));
+        QTest::qWait(50);
+        HYHistorianWriter::Metrics metrics = writer.metrics();
+        QCOMPARE(metrics.written, quint64(20));
+        QCOMPARE(metrics.queueDepth, 5);
+        QCOMPARE(metrics.flushes, quint64(2));
+        QVERIFY(metrics.oldestAge >= 50);
+
+        QVERIFY(writer.flush(5000));
+        metrics = writer.metrics();
+        QCOMPARE(metrics.written, quint64(25));
+        QCOMPARE(metrics.queueDepth, 0);
+        QCOMPARE(metrics.oldestAge, qint64(0));
+        QCOMPARE(metrics.flushes, quint64(3));
+        QVERIFY(metrics.maxFlushUs >= metrics.averageFlushUs);
+        QCOMPARE(count("Level"), 25);
+    }
+
+    /**
+     * @brief 测试按等待时间写入
+     */
+    void testBatchByInterval() {
+        HYHistorianWriter writer;
+        writer.setBatchSize(1000);
+        writer.setFlushInterval(50);
+        QVERIFY(writer.start(m_config));
+
+        QVERIFY(writer.enqueue(samples("Flow", 0, 3)));
+        QTest::qWait(10);
+        QCOMPARE(writer.metrics().written, quint64(0));
+        QTRY_COMPARE(writer.metrics().written, quint64(3));
+        QCOMPARE(writer.metrics().flushes, quint64(1));
+        QCOMPARE(count("Flow"), 3);
+    }
+
+    /**
+     * @brief 测试阻塞策略
+     *
+     * 队列远小于写入量时调用方等待写入线程，不丢失任何值
+     */
+    void testBlock() {
+        HYHistorianWriter writer;
+        writer.setCapacity(8);
+        writer.setBatchSize(8);
+        writer.setFlushInterval(0);
+        QVERIFY(writer.start(m_config));
+
+        for (int i = 0; i < 200; ++i) {
+            QVERIFY(writer.enqueue("Level", double(i), Day0 + i * 1000));
+        }
+        QVERIFY(writer.flush(5000));
+        const HYHistorianWriter::Metrics metrics = writer.metrics();
+        QCOMPARE(metrics.enqueued, quint64(200));
+        QCOMPARE(metrics.written, quint64(200));
+        QCOMPARE(metrics.dropped, quint64(0));
+        QCOMPARE(count("Level"), 200);
+    }
+
+    /**
+     * @brief 测试丢弃最旧的值
+     */
+    void testDropOldest() {
+        HYHistorianWriter writer;
+        writer.setCapacity(10);
+        writer.setBatchSize(100);
+        writer.setFlushInterval(60000);
+        writer.setOverflowPolicy(HYHistorianWriter::OverflowDropOldest);
+        QVERIFY(writer.start(m_config));
+
+        QVERIFY(writer.enqueue(samples("Level", 0, 25)));
+        QCOMPARE(writer.metrics().dropped, quint64(15));
+        QVERIFY(writer.flush(5000));
+        QCOMPARE(writer.metrics().written, quint64(10));
+
+        // 保留的是最新的10个值
+        const QMap<QDateTime, QVariant> history = query("Level");
+        QCOMPARE(history.size(), 10);
+        QCOMPARE(history.firstKey(), QDateTime::fromMSecsSinceEpoch(Day0 + 15 * 1000));
+        QCOMPARE(history.first().toDouble(), 15.0);
+    }
+
+    /**
+     * @brief 测试写入磁盘和写回
+     *
+     * 队列满时较旧的一半写入磁盘，队列写空后按顺序写回数据库
+     */
+    void testSpill() {
+        HYHistorianWriter writer;
+        writer.setCapacity(10);
+        writer.setBatchSize(100);
+        writer.setFlushInterval(60000);
+        writer.setOverflowPolicy(HYHistorianWriter::OverflowSpill);
+        writer.setSpillDirectory(m_dir.filePath("spill"));
+        QVERIFY(writer.start(m_config));
+
+        QVERIFY(writer.enqueue(samples("Level", 0, 30)));
+        QVERIFY(writer.enqueue("State", QString("运行"), Day0));
+        HYHistorianWriter::Metrics metrics = writer.metrics();
+        QVERIFY(metrics.spilled >= 20);
+        QCOMPARE(metrics.dropped, quint64(0));
+        QVERIFY(metrics.spillBacklogBytes > 0);
+        QCOMPARE(quint64(metrics.queueDepth) + metrics.spilled, quint64(31));
+
+        QVERIFY(writer.flush(5000));
+        QTRY_COMPARE(writer.metrics().restored, metrics.spilled);
+        metrics = writer.metrics();
+        QCOMPARE(metrics.written, quint64(31));
+        QCOMPARE(metrics.spillBacklogBytes, qint64(0));
+        QCOMPARE(count("Level"), 30);
+        QCOMPARE(count("State"), 1);
+    }
+
+    /**
+     * @brief 测试停止时写入剩余的值
+     */
+    void testStopWritesRemaining() {
+        HYHistorianWriter writer;
+        writer.setBatchSize(1000);
+        writer.setFlushInterval(60000);
+        QVERIFY(writer.start(m_config));
+        QVERIFY(writer.enqueue(samples("Level", 0, 7)));
+        QVERIFY(writer.isRunning());
+
+        writer.stop();
+        QVERIFY(!writer.isRunning());
+        QVERIFY(!writer.enqueue("Level", 1.0, Day0));
+        QCOMPARE(writer.metrics().written, quint64(7));
+        QCOMPARE(count("Level"), 7);
+    }
+
+private:
+    static constexpr qint64 Day0 = 1767225600000; ///< 2026-01-01T00:00:00Z
+
+    /**
+     * @brief 构造每秒一个的样本，值为序号
+     */
+    static QVector<HYTimeSeriesDatabase::TagSample> samples(const QString &tagName, int first, int count) {
+        QVector<HYTimeSeriesDatabase::TagSample> result;
+        for (int i = first; i < first + count; ++i) {
+            result.append({tagName, double(i), Day0 + i * 1000});
+        }
+        return result;
+    }
+
+    /**
+     * @brief 用另一个连接读回一天内的历史
+     */
+    QMap<QDateTime, QVariant> query(const QString &tagName) {
+        HYTimeSeriesDatabase database;
+        if (!database.initialize(m_config)) {
+            return {};
+        }
+        return database.queryTagHistory(tagName, QDateTime::fromMSecsSinceEpoch(Day0),
+                                        QDateTime::fromMSecsSinceEpoch(Day0 + 86400000), 100000);
+    }
+
+    /**
+     * @brief 读回的值数
+     */
+    int count(const QString &tagName) {
+        return int(query(tagName).size());
+    }
+
+    QTemporaryDir m_dir; ///< 测试数据目录
+    HYTimeSeriesDatabase::DatabaseConfig m_config; ///< 当前测试的数据库配置
+    int m_count = 0; ///< 已创建的数据库文件数
+};
+
+QTEST_MAIN(TestHistorianWriter)
+#include "test_historianwriter.moc"
@@ -0,0 +1,167 @@
+#include <QTest>
+#include "jsonstreamreader.h"
+
+/**
+ * @brief 流式JSON读取器单元测试
+ *
+ * 测试记号序列和值、在任意字节处分块追加时结果不变、转义和多字节字符，以及格式错误
+ */
+class TestJsonStreamReader : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    /**
+     * @brief 测试记号序列和值
+     */
+    void testTokens() {
+        HYJsonStreamReader reader;
+        reader.addData(Document);
+        reader.finish();
+        const QStringList tokens = readAll(&reader);
+        QVERIFY2(!reader.hasError(), qPrintable(reader.errorString()));
+        QVERIFY(reader.atEnd());
+        QCOMPARE(tokens, Expected);
+    }
+
+    /**
+     * @brief 测试分块追加
+     *
+     * 在每个字节处切成两块，以及逐字节追加，记号序列都与一次追加相同
+     */
+    void testChunked() {
+        for (int split = 1; split < Document.size(); ++split) {
+            HYJsonStreamReader reader;
+            reader.addData(Document.left(split));
+            QStringList tokens = readAll(&reader);
+            QVERIFY(!reader.atEnd());
+            reader.addData(Document.mid(split));
+            reader.finish();
+            tokens += readAll(&reader);
+            QVERIFY2(tokens == Expected, qPrintable(QString("split at %1").arg(split)));
+        }
+
+        HYJsonStreamReader reader;
+        QStringList tokens;
+        for (char byte : Document) {
+            reader.addData(QByteArray(1, byte));
+            tokens += readAll(&reader);
+        }
+        reader.finish();
+        tokens += readAll(&reader);
+        QCOMPARE(tokens, Expected);
+        QVERIFY(reader.atEnd());
+    }
+
+    /**
+     * @brief 测试顶层数值
+     *
+     * 数值可能在下一块继续，只有finish()之后才返回
+     */
+    void testTopLevelNumber() {
+        HYJsonStreamReader reader;
+        reader.addData("12");
+        QCOMPARE(reader.readNext(), HYJsonStreamReader::Incomplete);
+        reader.addData("34 ");
+        QCOMPARE(reader.readNext(), HYJsonStreamReader::Number);
+        QCOMPARE(reader.value(), QVariant(qint64(1234)));
+        QVERIFY(reader.atEnd());
+
+        reader.clear();
+        reader.addData("-2.5e3");
+        QCOMPARE(reader.readNext(), HYJsonStreamReader::Incomplete);
+        reader.finish();
+        QCOMPARE(reader.readNext(), HYJsonStreamReader::Number);
+        QCOMPARE(reader.value().toDouble(), -2500.0);
+    }
+
+    /**
+     * @brief 测试格式错误
+     */
+    void testErrors() {
+        const QList<QByteArray> documents = {"[1, 2}", "{\"a\": tru}", "[1] 2", "[@]", "[\"\\uZZZZ\"]", "[-]"};
+        for (const QByteArray &document : documents) {
+            HYJsonStreamReader reader;
+            reader.addData(document);
+            reader.finish();
+            readAll(&reader);
+            QVERIFY2(reader.hasError(), document.constData());
+            QVERIFY(!reader.errorString().isEmpty());
+            QCOMPARE(reader.readNext(), HYJsonStreamReader::Invalid);
+        }
+
+        // 数据不完整不是错误
+        HYJsonStreamReader reader;
+        reader.addData("{\"results\": [{\"se");
+        readAll(&reader);
+        QVERIFY(!reader.hasError());
+        QVERIFY(!reader.atEnd());
+        QCOMPARE(reader.depth(), 3);
+    }
+
+private:
+    static inline const QByteArray Document =
+        "{\"results\":[{\"statement_id\":0,\"series\":[{\"name\":\"history\",\"columns\":[\"time\",\"value\"],"
+        "\"values\":[[1767225600000,1.5],[1767225601000,\"a\\\"b\\\\c\\n\\u00e9\\ud83d\\ude00\"],"
+        "[1767225602000, -12 ],[1767225603000,true],[1767225604000,null],[1767225605000,2.5e-3]]}]}],"
+        "\"meta\":{},\"empty\":[],\"text\":\"运行\"}";
+
+    static inline const QStringList Expected = {
+        "{", "N:results", "[", "{", "N:statement_id", "0", "N:series", "[", "{", "N:name", "S:history",
+        "N:columns", "[", "S:time", "S:value", "]", "N:values", "[",
+        "[", "1767225600000", "1.5", "]",
+        "[", "1767225601000", QString::fromUtf8("S:a\"b\\c\n\u00e9\U0001F600"), "]",
+        "[", "1767225602000", "-12", "]",
+        "[", "1767225603000", "B:true", "]",
+        "[", "1767225604000", "null", "]",
+        "[", "1767225605000", "0.0025", "]",
+        "]", "}", "]", "}", "]",
+        "N:meta", "{", "}", "N:empty", "[", "]", "N:text", QString::fromUtf8("S:运行"), "}"};
+
+    /**
+     * @brief 读出缓冲区中的全部记号，整数以外的数值按double格式化
+     */
+    static QStringList readAll(HYJsonStreamReader *reader) {
+        QStringList tokens;
+        for (;;) {
+            switch (reader->readNext()) {
+            case HYJsonStreamReader::Incomplete:
+            case HYJsonStreamReader::Invalid:
+                return tokens;
+            case HYJsonStreamReader::StartObject:
+                tokens << "{";
+                break;
+            case HYJsonStreamReader::EndObject:
+                tokens << "}";
+                break;
+            case HYJsonStreamReader::StartArray:
+                tokens << "[";
+                break;
+            case HYJsonStreamReader::EndArray:
+                tokens << "]";
+                break;
+            case HYJsonStreamReader::Name:
+                tokens << "N:" + reader->text();
+                break;
+            case HYJsonStreamReader::String:
+                tokens << "S:" + reader->value().toString();
+                break;
+            case HYJsonStreamReader::Number: {
+                const QVariant value = reader->value();
+                tokens << (value.typeId() == QMetaType::LongLong ? QString::number(value.toLongLong())
+                                                                 : QString::number(value.toDouble()));
+                break;
+            }
+            case HYJsonStreamReader::Bool:
+                tokens << (reader->value().toBool() ? "B:true" : "B:false");
+                break;
+            case HYJsonStreamReader::Null:
+                tokens << "null";
+                break;
+            }
+        }
+    }
+};
+
+QTEST_MAIN(TestJsonStreamReader)
+#include "test_jsonstreamreader.moc"
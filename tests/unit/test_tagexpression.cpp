@@ -0,0 +1,107 @@
+#include <QTest>
+#include <cmath>
+#include "tagexpression.h"
+
+/**
+ * @brief 计算点位表达式单元测试
+ *
+ * 测试运算符优先级和结合性、函数、点位名称的两种写法、变量去重，以及语法错误的报告
+ */
+class TestTagExpression : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    /**
+     * @brief 常量表达式测试数据
+     */
+    void testConstant_data() {
+        QTest::addColumn<QString>("source");
+        QTest::addColumn<double>("expected");
+
+        QTest::newRow("precedence") << "1 + 2 * 3" << 7.0;
+        QTest::newRow("parentheses") << "(1 + 2) * 3" << 9.0;
+        QTest::newRow("left-associative") << "10 - 4 - 3" << 3.0;
+        QTest::newRow("power-right") << "2 ^ 3 ^ 2" << 512.0;
+        QTest::newRow("unary-power") << "-2 ^ 2" << -4.0;
+        QTest::newRow("negative-exponent") << "2 ^ -1" << 0.5;
+        QTest::newRow("modulo") << "7 % 4" << 3.0;
+        QTest::newRow("comparison") << "1 + 1 == 2" << 1.0;
+        QTest::newRow("not-equal") << "3 != 3" << 0.0;
+        QTest::newRow("logic") << "1 < 2 && !(2 <= 1) || false" << 1.0;
+        QTest::newRow("ternary") << "0 ? 1 : 2 > 1 ? 3 : 4" << 3.0;
+        QTest::newRow("functions") << "max(1, 5, 3) + min(4, 2) + abs(-1) + clamp(12, 0, 10)" << 18.0;
+        QTest::newRow("rounding") << "floor(1.7) + ceil(1.2) + round(2.5)" << 6.0;
+        QTest::newRow("pow-sqrt") << "pow(3, 2) + sqrt(16)" << 13.0;
+        QTest::newRow("scientific") << "1.5e3 + .5" << 1500.5;
+        QTest::newRow("pi") << "round(pi * 100)" << 314.0;
+    }
+
+    /**
+     * @brief 测试常量表达式
+     */
+    void testConstant() {
+        QFETCH(QString, source);
+        QFETCH(double, expected);
+
+        HYTagExpression expression;
+        QString error;
+        QVERIFY2(expression.compile(source, &error), qPrintable(error));
+        QVERIFY(expression.isValid());
+        QVERIFY(expression.variables().isEmpty());
+        QCOMPARE(expression.evaluate(nullptr), expected);
+    }
+
+    /**
+     * @brief 测试点位变量
+     */
+    void testVariables() {
+        HYTagExpression expression;
+        QVERIFY(expression.compile("plant.bf1.out / plant.bf1.in * 100 + {BF-1 offset} - plant.bf1.in * 0"));
+        QCOMPARE(expression.variables(), QStringList({"plant.bf1.out", "plant.bf1.in", "BF-1 offset"}));
+
+        const double inputs[] = {45.0, 50.0, 1.0};
+        QCOMPARE(expression.evaluate(inputs), 91.0);
+        QCOMPARE(expression.source(), QString("plant.bf1.out / plant.bf1.in * 100 + {BF-1 offset} - plant.bf1.in * 0"));
+
+        // 除以0得到无穷大，由调用方判断
+        const double zero[] = {45.0, 0.0, 1.0};
+        QVERIFY(std::isinf(expression.evaluate(zero)));
+    }
+
+    /**
+     * @brief 语法错误测试数据
+     */
+    void testErrors_data() {
+        QTest::addColumn<QString>("source");
+
+        QTest::newRow("empty") << "";
+        QTest::newRow("dangling-operator") << "1 +";
+        QTest::newRow("unbalanced") << "(1 + 2";
+        QTest::newRow("trailing") << "1 2";
+        QTest::newRow("unknown-function") << "foo(1)";
+        QTest::newRow("arity") << "pow(1)";
+        QTest::newRow("min-arity") << "max(1)";
+        QTest::newRow("ternary") << "1 ? 2";
+        QTest::newRow("brace") << "{Tag";
+        QTest::newRow("assignment") << "a = 1";
+    }
+
+    /**
+     * @brief 测试语法错误
+     */
+    void testErrors() {
+        QFETCH(QString, source);
+
+        HYTagExpression expression;
+        QString error;
+        QVERIFY(!expression.compile(source, &error));
+        QVERIFY(!error.isEmpty());
+        QVERIFY(!expression.isValid());
+        QVERIFY(expression.variables().isEmpty());
+        QVERIFY(std::isnan(expression.evaluate(nullptr)));
+    }
+};
+
+QTEST_MAIN(TestTagExpression)
+#include "test_tagexpression.moc"
@@ -0,0 +1,218 @@
+#include <QTest>
+#include <QTemporaryDir>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include "taghistory.h"
+
+/**
+ * @brief 点位历史库单元测试
+ *
+ * 测试按时间分区写入、只访问重叠分区的查询、切换分区粒度、整表删除过期分区、后台清理线程，以及旧版本history表的读取和清理
+ */
+class TestTagHistory : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    /**
+     * @brief 测试初始化
+     */
+    void init() {
+        QVERIFY(m_dir.isValid());
+        m_path = m_dir.filePath(QString("history_%1.db").arg(m_count++));
+    }
+
+    /**
+     * @brief 测试按天分区写入和查询
+     */
+    void testPartitionedWrite() {
+        HYTagHistory history;
+        QVERIFY(history.open(m_path));
+        const QVector<qint64> series = history.seriesIds({"Level", "State"});
+        QCOMPARE(series.size(), 2);
+        QVERIFY(series[0] && series[1] && series[0] != series[1]);
+
+        // 跨三天写入，一批样本分到三个分区
+        QVector<HYTagHistory::Sample> samples;
+        for (int day = 0; day < 3; ++day) {
+            samples.append(sample(series[0], Day0 + day * DayMs + 1000, HYTagValue::fromDouble(day + 0.5)));
+            samples.append(sample(series[1], Day0 + day * DayMs + 2000, HYTagValue::fromString("run")));
+        }
+        QVERIFY(history.write(samples));
+        QCOMPARE(history.writtenCount(), qint64(6));
+        QCOMPARE(history.partitions(),
+                 QStringList({"history_20260101000000", "history_20260102000000", "history_20260103000000"}));
+
+        // 跨分区的查询按时间排序
+        QVector<quint8> qualities;
+        QVector<QPair<QDateTime, QVariant>> data = history.query("Level", Day0, Day0 + 3 * DayMs, &qualities);
+        QCOMPARE(data.size(), 3);
+        QCOMPARE(qualities.size(), 3);
+        for (int day = 0; day < 3; ++day) {
+            QCOMPARE(data[day].first.toMSecsSinceEpoch(), Day0 + day * DayMs + 1000);
+            QCOMPARE(data[day].second.toDouble(), day + 0.5);
+        }
+
+        // 只落在一个分区内的查询
+        data = history.query("State", Day0 + DayMs, Day0 + 2 * DayMs - 1);
+        QCOMPARE(data.size(), 1);
+        QCOMPARE(data.first().second.toString(), QString("run"));
+        QCOMPARE(history.query("Missing", Day0, Day0 + 3 * DayMs).size(), 0);
+
+        // 重新打开后从分区目录恢复
+        history.close();
+        QVERIFY(history.open(m_path));
+        QCOMPARE(history.partitions().size(), 3);
+        QCOMPARE(history.query("Level", Day0, Day0 + 3 * DayMs).size(), 3);
+    }
+
+    /**
+     * @brief 测试切换分区粒度
+     *
+     * 已有分区覆盖的样本仍写入原分区，新分区截断到不与已有分区重叠
+     */
+    void testPartitionSwitch() {
+        HYTagHistory history;
+        QVERIFY(history.open(m_path));
+        const qint64 series = history.seriesIds({"Level"}).first();
+        QVERIFY(history.write({sample(series, Day0 + 1000, HYTagValue::fromInt64(1))}));
+
+        history.setPartitioning(HYTagHistory::PartitionByHour);
+        QCOMPARE(history.partitioning(), HYTagHistory::PartitionByHour);
+        QVERIFY(history.write({sample(series, Day0 + 5 * HourMs, HYTagValue::fromInt64(2)),
+                               sample(series, Day0 + DayMs + 5 * HourMs, HYTagValue::fromInt64(3))}));
+        QCOMPARE(history.partitions(), QStringList({"history_20260101000000", "history_20260102050000"}));
+
+        // 按天分区改回后，新分区从前一个分区的结束处开始
+        history.setPartitioning(HYTagHistory::PartitionByDay);
+        QVERIFY(history.write({sample(series, Day0 + DayMs + 7 * HourMs, HYTagValue::fromInt64(4))}));
+        QCOMPARE(history.partitions().size(), 3);
+        QCOMPARE(history.partitions().last(), QString("history_20260102060000"));
+
+        const QVector<QPair<QDateTime, QVariant>> data = history.query("Level", Day0, Day0 + 2 * DayMs);
+        QCOMPARE(data.size(), 4);
+        for (int i = 0; i < data.size(); ++i) {
+            QCOMPARE(data[i].second.toLongLong(), qint64(i + 1));
+        }
+    }
+
+    /**
+     * @brief 测试整表删除过期分区
+     */
+    void testPurge() {
+        HYTagHistory history;
+        QVERIFY(history.open(m_path));
+        const qint64 series = history.seriesIds({"Level"}).first();
+        QVERIFY(history.write({sample(series, Day0 + 1000, HYTagValue::fromInt64(1)),
+                               sample(series, Day0 + DayMs + 1000, HYTagValue::fromInt64(2))}));
+
+        // 结束时间晚于截止时间的分区整体保留
+        QCOMPARE(history.purge(Day0 + DayMs + 2000), 1);
+        QCOMPARE(history.partitions(), QStringList({"history_20260102000000"}));
+        QCOMPARE(history.query("Level", Day0, Day0 + 2 * DayMs).size(), 1);
+        QCOMPARE(history.purge(Day0 + DayMs + 2000), 0);
+
+        QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", "test.purge");
+        database.setDatabaseName(m_path);
+        QVERIFY(database.open());
+        QVERIFY(!database.tables().contains("history_20260101000000"));
+        QVERIFY(database.tables().contains("history_20260102000000"));
+        database.close();
+        database = QSqlDatabase();
+        QSqlDatabase::removeDatabase("test.purge");
+    }
+
+    /**
+     * @brief 测试后台清理线程
+     */
+    void testBackgroundRetention() {
+        HYTagHistory history;
+        history.setRetention(DayMs, 50);
+        QVERIFY(history.open(m_path));
+        const qint64 series = history.seriesIds({"Level"}).first();
+        const qint64 now = QDateTime::currentMSecsSinceEpoch();
+        QVERIFY(history.write({sample(series, Day0 + 1000, HYTagValue::fromInt64(1)),
+                               sample(series, now, HYTagValue::fromInt64(2))}));
+        QCOMPARE(history.partitions().size(), 2);
+
+        QTRY_COMPARE(history.partitions().size(), 1);
+        QCOMPARE(history.query("Level", Day0, now).size(), 1);
+
+        // 停止清理后过期分区保留
+        history.setRetention(0);
+        QVERIFY(history.write({sample(series, Day0 + 1000, HYTagValue::fromInt64(1))}));
+        QTest::qWait(200);
+        QCOMPARE(history.partitions().size(), 2);
+    }
+
+    /**
+     * @brief 测试旧版本history表
+     */
+    void testLegacyTable() {
+        {
+            QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", "test.legacy");
+            database.setDatabaseName(m_path);
+            QVERIFY(database.open());
+            QSqlQuery query(database);
+            QVERIFY(query.exec("CREATE TABLE history (id INTEGER PRIMARY KEY AUTOINCREMENT, tag_name TEXT, value TEXT, "
+                               "timestamp TEXT)"));
+            query.prepare("INSERT INTO history (tag_name, value, timestamp) VALUES (?, ?, ?)");
+            query.addBindValue("Level");
+            query.addBindValue("1.5");
+            query.addBindValue(QDateTime::fromMSecsSinceEpoch(Day0 + 1000).toString(Qt::ISODate));
+            QVERIFY(query.exec());
+            database.close();
+        }
+        QSqlDatabase::removeDatabase("test.legacy");
+
+        HYTagHistory history;
+        QVERIFY(history.open(m_path));
+        const qint64 series = history.seriesIds({"Level"}).first();
+        QVERIFY(history.write({sample(series, Day0 + DayMs, HYTagValue::fromDouble(2.5))}));
+
+        // 旧行在前，缺少的质量码按好值读出
+        QVector<quint8> qualities;
+        QVector<QPair<QDateTime, QVariant>> data = history.query("Level", Day0, Day0 + 2 * DayMs, &qualities);
+        QCOMPARE(data.size(), 2);
+        QCOMPARE(data[0].second.toString(), QString("1.5"));
+        QCOMPARE(qualities[0], quint8(192));
+        QCOMPARE(data[1].second.toDouble(), 2.5);
+
+        // 旧表清空后删除
+        history.purge(Day0 + 2000);
+        data = history.query("Level", Day0, Day0 + 2 * DayMs);
+        QCOMPARE(data.size(), 1);
+        history.close();
+        QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", "test.legacy");
+        database.setDatabaseName(m_path);
+        QVERIFY(database.open());
+        QVERIFY(!database.tables().contains("history"));
+        database.close();
+        database = QSqlDatabase();
+        QSqlDatabase::removeDatabase("test.legacy");
+    }
+
+private:
+    static constexpr qint64 Day0 = 1767225600000; ///< 2026-01-01T00:00:00Z
+    static constexpr qint64 DayMs = 86400000; ///< 一天的毫秒数
+    static constexpr qint64 HourMs = 3600000; ///< 一小时的毫秒数
+
+    /**
+     * @brief 构造好值样本
+     */
+    static HYTagHistory::Sample sample(qint64 series, qint64 timestamp, const HYTagValue &value) {
+        HYTagHistory::Sample result;
+        result.series = series;
+        result.timestamp = timestamp;
+        result.value = value;
+        result.quality = 192;
+        return result;
+    }
+
+    QTemporaryDir m_dir; ///< 测试数据目录
+    QString m_path; ///< 当前测试的数据库文件
+    int m_count = 0; ///< 已创建的数据库文件数
+};
+
+QTEST_MAIN(TestTagHistory)
+#include "test_taghistory.moc"
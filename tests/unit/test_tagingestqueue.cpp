@@ -0,0 +1,184 @@
+#include <QTest>
+#include <QSignalSpy>
+#include <QThread>
+#include "tagingestqueue.h"
+
+/**
+ * @brief 点位采集队列单元测试
+ *
+ * 测试HYTagIngestQueue类的功能，包括入队出队、数据源配额、队列满时的丢弃计数，
+ * 以及应用线程把多个数据源的更新写入点位管理器
+ */
+class TestTagIngestQueue : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    /**
+     * @brief 测试入队和出队
+     *
+     * 取出的更新保持入队顺序，值和采集时间戳原样写入点位管理器
+     */
+    void testPushDrain() {
+        HYTagManager manager;
+        manager.addTag("Ingest_A", "Ingest", 0);
+        manager.addTag("Ingest_B", "Ingest", 0);
+        const HYTagManager::TagId a = manager.resolveTag("Ingest_A");
+        const HYTagManager::TagId b = manager.resolveTag("Ingest_B");
+
+        HYTagIngestQueue queue(&manager, 100);
+        QCOMPARE(queue.capacity(), 128);
+        const int source = queue.registerSource("PLC1");
+        QCOMPARE(source, 0);
+
+        QVERIFY(queue.tryPush(source, a, HYTagValue::fromDouble(1.5), 1000));
+        QVERIFY(queue.tryPush(source, b, HYTagValue::fromInt64(7), 2000));
+        QVERIFY(queue.tryPush(source, a, HYTagValue::fromDouble(2.5), 3000));
+        QCOMPARE(queue.sourceStats(source).pending, 3);
+
+        // 队列只缓存更新，取出并应用之前点位值不变
+        QCOMPARE(manager.value(a), QVariant(0));
+
+        QVector<HYTagUpdate> updates;
+        QCOMPARE(queue.drain(&updates), 3);
+        QCOMPARE(updates[0].id, a);
+        QCOMPARE(updates[1].value, HYTagValue::fromInt64(7));
+        QCOMPARE(updates[2].timestamp, qint64(3000));
+        QCOMPARE(queue.drain(&updates), 0);
+        QCOMPARE(queue.sourceStats(source).pending, 0);
+
+        QSignalSpy spy(&manager, &HYTagManager::tagValueChanged);
+        QCOMPARE(manager.setValues({{a, 1000, HYTagValue::fromDouble(1.5)},
+                                    {b, 2000, HYTagValue::fromInt64(7)},
+                                    {a, 3000, HYTagValue::fromDouble(2.5)},
+                                    {HYTagManager::InvalidTagId, 0, HYTagValue()}}), 3);
+        QCOMPARE(spy.count(), 3);
+        QCOMPARE(manager.value(a), QVariant(2.5));
+        QCOMPARE(manager.timestamp(a), qint64(3000));
+        QCOMPARE(manager.value(b), QVariant(7));
+    }
+
+    /**
+     * @brief 测试数据源配额和丢弃计数
+     *
+     * 超出配额的数据源只丢弃自己的更新，其他数据源仍可入队；队列满时所有数据源都计入丢弃
+     */
+    void testSourceQuota() {
+        HYTagManager manager;
+        manager.addTag("Quota_Tag", "Ingest", 0);
+        const HYTagManager::TagId id = manager.resolveTag("Quota_Tag");
+
+        HYTagIngestQueue queue(&manager, 16);
+        const int burst = queue.registerSource("PLC1", 4);
+        const int other = queue.registerSource("PLC2");
+        QCOMPARE(queue.sourceStats(other).quota, 4);
+
+        for (int i = 0; i < 10; ++i) {
+            queue.tryPush(burst, id, HYTagValue::fromInt64(i), i);
+        }
+        HYTagIngestQueue::SourceStats stats = queue.sourceStats(burst);
+        QCOMPARE(stats.name, QString("PLC1"));
+        QCOMPARE(stats.accepted, qint64(4));
+        QCOMPARE(stats.dropped, qint64(6));
+        QCOMPARE(stats.pending, 4);
+
+        QVERIFY(queue.tryPush(other, id, HYTagValue::fromInt64(100), 100));
+        QCOMPARE(queue.sourceStats(other).dropped, qint64(0));
+
+        // 取出后配额释放
+        QVector<HYTagUpdate> updates;
+        QCOMPARE(queue.drain(&updates), 5);
+        QVERIFY(queue.tryPush(burst, id, HYTagValue::fromInt64(10), 10));
+
+        // 配额之和超过容量时，环形缓冲区本身满了也会丢弃
+        HYTagIngestQueue small(&manager, 4);
+        const int first = small.registerSource("PLC1", 4);
+        const int second = small.registerSource("PLC2", 4);
+        for (int i = 0; i < 3; ++i) {
+            QVERIFY(small.tryPush(first, id, HYTagValue::fromInt64(i), i));
+        }
+        QVERIFY(small.tryPush(second, id, HYTagValue::fromInt64(3), 3));
+        QVERIFY(!small.tryPush(second, id, HYTagValue::fromInt64(4), 4));
+        QCOMPARE(small.sourceStats(second).dropped, qint64(1));
+        QCOMPARE(small.droppedCount(), qint64(1));
+
+        // 未注册的数据源不能入队
+        QVERIFY(!small.tryPush(5, id, HYTagValue::fromInt64(5), 5));
+    }
+
+    /**
+     * @brief 测试应用线程
+     *
+     * 多个数据源线程并发发布，应用线程把全部更新写入点位管理器，停止时队列中的剩余更新也被应用
+     */
+    void testApplier() {
+        HYTagManager manager;
+        QVector<HYTagManager::TagId> ids;
+        for (int i = 0; i < 4; ++i) {
+            manager.addTag(QString("Applier_%1").arg(i), "Ingest", 0);
+            ids.append(manager.resolveTag(QString("Applier_%1").arg(i)));
+        }
+
+        HYTagIngestQueue queue(&manager, 1024);
+        QVector<int> sources;
+        for (int i = 0; i < 4; ++i) {
+            sources.append(queue.registerSource(QString("PLC%1").arg(i), 256));
+        }
+        queue.start();
+        QVERIFY(queue.isRunning());
+
+        QVector<QThread *> threads;
+        for (int t = 0; t < 4; ++t) {
+            threads.append(QThread::create([&queue, &ids, &sources, t]() {
+                for (int i = 0; i < 2000; ++i) {
+                    // 配额用尽时让出CPU再重试，模拟数据源在反压下降频
+                    while (!queue.publish(sources[t], ids[t], QVariant(i))) {
+                        QThread::yieldCurrentThread();
+                    }
+                }
+            }));
+            threads.last()->start();
+        }
+        for (QThread *thread : threads) {
+            thread->wait();
+            delete thread;
+        }
+
+        queue.stop();
+        QVERIFY(!queue.isRunning());
+        qint64 accepted = 0;
+        for (int t = 0; t < 4; ++t) {
+            QCOMPARE(manager.value(ids[t]), QVariant(1999));
+            accepted += queue.sourceStats(sources[t]).accepted;
+        }
+        QCOMPARE(accepted, qint64(8000));
+        QCOMPARE(queue.appliedCount(), qint64(8000));
+
+        // 无法表示为类型化值的更新保存在旁路表中，与前后的类型化更新保持发布顺序，时间戳和质量码一并写入
+        QVERIFY(queue.publish(sources[0], ids[0], QVariant(1.5), HYTagValueStore::QualityGood, 1000));
+        QVERIFY(queue.publish(sources[0], ids[0], QVariant(QStringList{"A", "B"}), HYTagValueStore::QualityUncertain,
+                              2000));
+        QVERIFY(queue.publish(sources[1], ids[1], QVariant(7), HYTagValueStore::QualityGood, 3000));
+        QCOMPARE(manager.value(ids[0]), QVariant(1999));
+        QVector<HYTagUpdate> updates;
+        QCOMPARE(queue.drain(&updates), 1);
+        QCOMPARE(updates[0].timestamp, qint64(1000));
+
+        QSignalSpy spy(&manager, &HYTagManager::tagValueChanged);
+        queue.stop();
+        QCOMPARE(spy.count(), 2);
+        QCOMPARE(manager.value(ids[0]), QVariant(QStringList{"A", "B"}));
+        QCOMPARE(manager.timestamp(ids[0]), qint64(2000));
+        QCOMPARE(manager.record(ids[0]).quality, quint8(HYTagValueStore::QualityUncertain));
+        QCOMPARE(manager.value(ids[1]), QVariant(7));
+        QCOMPARE(queue.sourceStats(sources[0]).pending, 0);
+
+        // 尚未定义的点位没有句柄，其更新计入丢弃数
+        const qint64 dropped = queue.droppedCount();
+        QVERIFY(!queue.publish(sources[0], HYTagManager::InvalidTagId, QVariant(1)));
+        QCOMPARE(queue.droppedCount(), dropped + 1);
+    }
+};
+
+QTEST_MAIN(TestTagIngestQueue)
+#include "test_tagingestqueue.moc"
@@ -1,6 +1,30 @@
 #include <QTest>
 #include <QSignalSpy>
+#include <QThread>
+#include <QTemporaryDir>
+#include <QFile>
+#include <algorithm>
 #include "tagmanager.h"
+#include "timeseriesdatabase.h"
+#include "tagsharedreader.h"
+
+/**
+ * @brief 属性绑定测试目标对象
+ */
+class BindingTarget : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(double level MEMBER m_level)
+    Q_PROPERTY(int count MEMBER m_count)
+    Q_PROPERTY(QString text MEMBER m_text)
+    Q_PROPERTY(QVariant raw MEMBER m_raw)
+
+public:
+    double m_level = 0.0; ///< 浮点属性
+    int m_count = 0; ///< 整数属性
+    QString m_text; ///< 字符串属性
+    QVariant m_raw; ///< QVariant属性
+};
 
 /**
  * @brief 标签管理器单元测试
@@ -249,6 +273,1107 @@ private slots:
         QCOMPARE(arguments.at(0).toString(), QString("Removed_Signal_Test"));
     }
 
+    /**
+     * @brief 测试点位句柄读写
+     * 
+     * 测试解析句柄后按句柄读写点位值，以及名称接口与句柄接口的一致性
+     */
+    void testTagIdAccess() {
+        tagManager->addTag("Handle_Test", "Test_Group", 10);
+
+        // 解析句柄
+        HYTagManager::TagId id = tagManager->resolveTag("Handle_Test");
+        QVERIFY(id != HYTagManager::InvalidTagId);
+        QCOMPARE(tagManager->tagName(id), QString("Handle_Test"));
+        QCOMPARE(tagManager->getTag("Handle_Test")->tagId(), id);
+
+        // 按句柄写入，按名称读取
+        QSignalSpy spy(tagManager, &HYTagManager::tagValueChanged);
+        QVERIFY(tagManager->setValue(id, 42));
+        QCOMPARE(tagManager->getTagValue("Handle_Test"), QVariant(42));
+        QCOMPARE(tagManager->value(id), QVariant(42));
+        QCOMPARE(spy.count(), 1);
+
+        // 写入相同的值不应发出信号
+        QVERIFY(tagManager->setValue(id, 42));
+        QCOMPARE(spy.count(), 1);
+
+        // 点位对象读取的是存储中的值
+        QCOMPARE(tagManager->getTag("Handle_Test")->value(), QVariant(42));
+
+        // 不存在的点位和无效句柄
+        QCOMPARE(tagManager->resolveTag("Non_Existent_Tag"), HYTagManager::InvalidTagId);
+        QVERIFY(!tagManager->setValue(HYTagManager::InvalidTagId, 1));
+        QVERIFY(tagManager->value(HYTagManager::InvalidTagId).isNull());
+
+        // 删除后句柄失效且不会被新点位复用
+        tagManager->removeTag("Handle_Test");
+        QVERIFY(!tagManager->setValue(id, 1));
+        tagManager->addTag("Handle_Test", "Test_Group", 10);
+        QVERIFY(tagManager->resolveTag("Handle_Test") != id);
+    }
+
+    /**
+     * @brief 测试同代快照读取
+     * 
+     * 测试批量写入后一次读取多个点位得到同一代的值，以及旁路表中的值的回退路径
+     */
+    void testSnapshot() {
+        tagManager->addTag("Snapshot_A", "Snapshot_Group", 1);
+        tagManager->addTag("Snapshot_B", "Snapshot_Group", 2.5);
+        tagManager->addTag("Snapshot_C", "Snapshot_Group", QStringList() << "a" << "b");
+
+        QVector<HYTagManager::TagId> ids;
+        ids << tagManager->resolveTag("Snapshot_A")
+            << tagManager->resolveTag("Snapshot_B")
+            << HYTagManager::InvalidTagId;
+
+        quint64 before = 0;
+        QVector<QVariant> values = tagManager->snapshot(ids, &before);
+        QCOMPARE(values.size(), 3);
+        QCOMPARE(values[0], QVariant(1));
+        QCOMPARE(values[1], QVariant(2.5));
+        QVERIFY(values[2].isNull());
+
+        // 一次批量写入在每个涉及的分片内只推进一代
+        QMap<QString, QVariant> batch;
+        batch["Snapshot_A"] = 10;
+        batch["Snapshot_B"] = 20.5;
+        tagManager->setTagValues(batch);
+
+        // 两个点位句柄相邻，位于不同分片，每个涉及的分片推进一代
+        quint64 after = 0;
+        values = tagManager->snapshot(ids, &after);
+        QCOMPARE(after, before + 2);
+        QCOMPARE(values[0], QVariant(10));
+        QCOMPARE(values[1], QVariant(20.5));
+
+        // 无法表示为类型化值的类型走加锁回退路径
+        ids[2] = tagManager->resolveTag("Snapshot_C");
+        values = tagManager->snapshot(ids);
+        QCOMPARE(values[2], QVariant(QStringList() << "a" << "b"));
+        QCOMPARE(tagManager->getTagValue("Snapshot_C"), QVariant(QStringList() << "a" << "b"));
+    }
+
+    /**
+     * @brief 测试类型化值读写
+     * 
+     * 测试类型化接口与QVariant接口读写同一点位的结果一致
+     */
+    void testTypedValue() {
+        tagManager->addTag("Typed_Test", "Test_Group", 1.5);
+        HYTagManager::TagId id = tagManager->resolveTag("Typed_Test");
+        QCOMPARE(tagManager->typedValue(id), HYTagValue::fromDouble(1.5));
+
+        QSignalSpy spy(tagManager, &HYTagManager::tagValueChanged);
+        QVERIFY(tagManager->setValue(id, HYTagValue::fromString("Running")));
+        QCOMPARE(tagManager->getTagValue("Typed_Test"), QVariant(QString("Running")));
+        QCOMPARE(spy.count(), 1);
+        QCOMPARE(spy.takeFirst().at(1), QVariant(QString("Running")));
+
+        // 相同的字符串驻留为同一编号，不视为变化
+        QVERIFY(tagManager->setValue(id, QVariant(QString("Running"))));
+        QCOMPARE(spy.count(), 0);
+
+        QVERIFY(tagManager->setValue(id, HYTagValue::fromInt64(7)));
+        QCOMPARE(tagManager->value(id), QVariant(7));
+        QCOMPARE(tagManager->typedValue(id).toDouble(), 7.0);
+        QVERIFY(!tagManager->setValue(HYTagManager::InvalidTagId, HYTagValue::fromBool(true)));
+    }
+
+    /**
+     * @brief 测试死区过滤
+     * 
+     * 测试绝对值死区和按组配置的百分比死区，死区内的更新既不写入也不发出信号
+     */
+    void testDeadbandFilter() {
+        tagManager->addTag("Deadband_Test", "Test_Group", 10.0);
+        HYTagFilter filter;
+        filter.deadbandType = HYTagFilter::DeadbandAbsolute;
+        filter.deadband = 1.0;
+        tagManager->setTagFilter("Deadband_Test", filter);
+
+        QSignalSpy spy(tagManager, &HYTagManager::tagValueChanged);
+        QVERIFY(tagManager->setTagValue("Deadband_Test", 10.5));
+        QCOMPARE(tagManager->getTagValue("Deadband_Test"), QVariant(10.0));
+        QCOMPARE(spy.count(), 0);
+
+        // 变化量相对上次接受的值计算
+        QVERIFY(tagManager->setTagValue("Deadband_Test", 11.5));
+        QCOMPARE(tagManager->getTagValue("Deadband_Test"), QVariant(11.5));
+        QCOMPARE(spy.count(), 1);
+
+        // 组配置对之后加入的点位同样生效，百分比按量程计算
+        HYTagFilter percent;
+        percent.deadbandType = HYTagFilter::DeadbandPercent;
+        percent.deadband = 5.0;
+        percent.rangeLow = 0.0;
+        percent.rangeHigh = 200.0;
+        tagManager->setGroupFilter("Furnace_Group", percent);
+        tagManager->addTag("Furnace_Temp", "Furnace_Group", 100.0);
+        QCOMPARE(tagManager->tagFilter("Furnace_Temp").deadbandType, HYTagFilter::DeadbandPercent);
+
+        QSignalSpy batchSpy(tagManager, &HYTagManager::tagValuesChanged);
+        QMap<QString, QVariant> batch;
+        batch["Furnace_Temp"] = 109.0;
+        batch["Deadband_Test"] = 20.0;
+        QVERIFY(tagManager->setTagValues(batch));
+        QCOMPARE(batchSpy.count(), 1);
+        QMap<QString, QVariant> reported = batchSpy.takeFirst().at(0).value<QMap<QString, QVariant>>();
+        QVERIFY(!reported.contains("Furnace_Temp"));
+        QCOMPARE(reported.value("Deadband_Test"), QVariant(20.0));
+        QCOMPARE(tagManager->getTagValue("Furnace_Temp"), QVariant(100.0));
+
+        // 清除后不再过滤
+        tagManager->clearGroupFilter("Furnace_Group");
+        QVERIFY(tagManager->setTagValue("Furnace_Temp", 100.5));
+        QCOMPARE(tagManager->getTagValue("Furnace_Temp"), QVariant(100.5));
+    }
+
+    /**
+     * @brief 测试质量码和源时间戳
+     * 
+     * 质量码变化绕过死区并发出信号，普通写入和批量写入恢复为Good
+     */
+    void testTagQuality() {
+        tagManager->addTag("Quality_Test", "Test_Group", 10.0);
+        HYTagManager::TagId id = tagManager->resolveTag("Quality_Test");
+        HYTagFilter filter;
+        filter.deadbandType = HYTagFilter::DeadbandAbsolute;
+        filter.deadband = 1.0;
+        tagManager->setTagFilter("Quality_Test", filter);
+        QCOMPARE(tagManager->quality(id), quint8(HYTagValueStore::QualityGood));
+
+        QSignalSpy spy(tagManager, &HYTagManager::tagValueChanged);
+        QVERIFY(tagManager->setValue(id, HYTagValue::fromDouble(10.2), 1000, HYTagValueStore::QualityLastUsable));
+        QCOMPARE(spy.count(), 1);
+        HYTagRecord record = tagManager->record(id);
+        QCOMPARE(record.value, HYTagValue::fromDouble(10.2));
+        QCOMPARE(record.sourceTimestamp, qint64(1000));
+        QVERIFY(record.serverTimestamp >= record.sourceTimestamp);
+        QCOMPARE(record.quality, quint8(HYTagValueStore::QualityLastUsable));
+
+        QVERIFY(tagManager->setQuality(id, HYTagValueStore::QualityNotConnected));
+        QCOMPARE(spy.count(), 2);
+        QCOMPARE(tagManager->getTag("Quality_Test")->quality(), int(HYTagValueStore::QualityNotConnected));
+
+        // 普通写入视为好值，质量码恢复时即使在死区内也写入
+        QVERIFY(tagManager->setTagValue("Quality_Test", 10.3));
+        QCOMPARE(spy.count(), 3);
+        QCOMPARE(tagManager->quality(id), quint8(HYTagValueStore::QualityGood));
+        QCOMPARE(tagManager->getTagValue("Quality_Test"), QVariant(10.3));
+
+        // 批量写入同样视为好值，并刷新源时间戳和服务器时间戳
+        QVERIFY(tagManager->setQuality(id, HYTagValueStore::QualityCommFailure));
+        QMap<QString, QVariant> batch;
+        batch["Quality_Test"] = 10.4;
+        QVERIFY(tagManager->setTagValues(batch));
+        record = tagManager->record(id);
+        QCOMPARE(record.quality, quint8(HYTagValueStore::QualityGood));
+        QCOMPARE(record.value, HYTagValue::fromDouble(10.4));
+        QVERIFY(record.sourceTimestamp > 1000);
+        QCOMPARE(record.serverTimestamp, record.sourceTimestamp);
+    }
+
+    /**
+     * @brief 测试限频过滤
+     * 
+     * 测试间隔内的更新立即写入但推迟通知，间隔结束后只补发最新值
+     */
+    void testRateLimitFilter() {
+        tagManager->addTag("RateLimit_Test", "Test_Group", 0);
+        HYTagFilter filter;
+        filter.minInterval = 100;
+        tagManager->setTagFilter("RateLimit_Test", filter);
+
+        QSignalSpy spy(tagManager, &HYTagManager::tagValueChanged);
+        QVERIFY(tagManager->setTagValue("RateLimit_Test", 1));
+        QCOMPARE(spy.count(), 1);
+
+        QVERIFY(tagManager->setTagValue("RateLimit_Test", 2));
+        QVERIFY(tagManager->setTagValue("RateLimit_Test", 3));
+        QCOMPARE(tagManager->getTagValue("RateLimit_Test"), QVariant(3));
+        QCOMPARE(spy.count(), 1);
+
+        QTRY_COMPARE(spy.count(), 2);
+        QCOMPARE(spy.at(1).at(1), QVariant(3));
+    }
+
+    /**
+     * @brief 测试分片并发写入
+     * 
+     * 测试多个线程同时进行跨分片批量写入和单点写入时不会死锁，且最终值正确
+     */
+    void testShardedWrites() {
+        QCOMPARE(HYTagManager(3).shardCount(), 4);
+
+        HYTagManager manager(4);
+        QStringList names;
+        for (int i = 0; i < 64; ++i) {
+            names.append(QString("Shard_Tag_%1").arg(i));
+            manager.addTag(names.last(), "Shard_Group", 0);
+        }
+
+        QVector<QThread *> threads;
+        for (int t = 0; t < 4; ++t) {
+            threads.append(QThread::create([&manager, &names, t]() {
+                for (int round = 0; round < 200; ++round) {
+                    QMap<QString, QVariant> batch;
+                    for (const QString &name : names) {
+                        batch[name] = round;
+                    }
+                    manager.setTagValues(batch);
+                    manager.setTagValue(names[(round * 7 + t) % names.size()], round);
+                }
+            }));
+        }
+        for (QThread *thread : threads) {
+            thread->start();
+        }
+        for (QThread *thread : threads) {
+            QVERIFY(thread->wait(30000));
+            delete thread;
+        }
+
+        // 每个线程最后一轮写入的都是199
+        for (const QString &name : names) {
+            QCOMPARE(manager.getTagValue(name), QVariant(199));
+        }
+    }
+
+    /**
+     * @brief 测试延迟通知的固定周期
+     * 
+     * 测试点位持续变化时批量通知仍按周期发出，不会因为不断有新变化而被一直推迟
+     */
+    void testNotificationCadence() {
+        HYTagManager manager;
+        manager.addTag("Cadence_Tag", "Cadence_Group", 0);
+        manager.setDelayedNotification(true, 30);
+        QSignalSpy batchSpy(&manager, &HYTagManager::tagValuesChanged);
+
+        // 写入间隔远小于通知周期
+        int written = 0;
+        QTimer writer;
+        connect(&writer, &QTimer::timeout, [&manager, &written]() {
+            manager.setTagValue("Cadence_Tag", ++written);
+        });
+        writer.start(5);
+
+        QTRY_VERIFY_WITH_TIMEOUT(batchSpy.count() >= 3, 2000);
+        writer.stop();
+
+        // 多次变化合并为一批，批内只有最新值
+        QVERIFY(batchSpy.count() < written);
+        const HYNotificationMetrics metrics = manager.notificationMetrics();
+        QVERIFY(metrics.flushes >= 3);
+        QCOMPARE(metrics.maxBatchSize, 1);
+
+        // 关闭延迟通知时立即补发尚未通知的值
+        manager.setTagValue("Cadence_Tag", -1);
+        manager.setDelayedNotification(false);
+        QCOMPARE(batchSpy.last().at(0).value<QMap<QString, QVariant>>().value("Cadence_Tag"), QVariant(-1));
+    }
+
+    /**
+     * @brief 测试通知订阅
+     * 
+     * 测试订阅者只收到所订阅点位的合并后最新值，上下文对象销毁或取消订阅后不再回调
+     */
+    void testSubscribe() {
+        HYTagManager manager;
+        manager.addTag("Subscribe_A", "Subscribe_Group", 0);
+        manager.addTag("Subscribe_B", "Subscribe_Group", 0);
+        manager.addTag("Subscribe_C", "Subscribe_Group", 0);
+        const HYTagManager::TagId a = manager.resolveTag("Subscribe_A");
+        const HYTagManager::TagId b = manager.resolveTag("Subscribe_B");
+        const HYTagManager::TagId c = manager.resolveTag("Subscribe_C");
+
+        QObject context;
+        int batches = 0;
+        QVector<HYTagUpdate> received;
+        const int subscriber = manager.subscribe({a, b}, &context, [&](const QVector<HYTagUpdate> &updates) {
+            ++batches;
+            received = updates;
+        }, 20);
+        QVERIFY(subscriber > HYTagManager::DelayedSubscriber);
+
+        for (int i = 1; i <= 100; ++i) {
+            manager.setValue(a, HYTagValue::fromInt64(i));
+            manager.setValue(b, HYTagValue::fromInt64(-i));
+            manager.setValue(c, HYTagValue::fromInt64(i));
+        }
+
+        QTRY_COMPARE(batches, 1);
+        QCOMPARE(received.size(), 2);
+        QCOMPARE(received[0].id, a);
+        QCOMPARE(received[0].value, HYTagValue::fromInt64(100));
+        QCOMPARE(received[1].id, b);
+        QCOMPARE(received[1].value, HYTagValue::fromInt64(-100));
+
+        const HYNotificationMetrics metrics = manager.notificationMetrics(subscriber);
+        QCOMPARE(metrics.flushes, quint64(1));
+        QCOMPARE(metrics.notifications, quint64(2));
+        QCOMPARE(metrics.lastBatchSize, 2);
+
+        // 上下文对象销毁后订阅自动失效
+        int orphanCalls = 0;
+        QObject *orphan = new QObject;
+        manager.subscribe({c}, orphan, [&orphanCalls](const QVector<HYTagUpdate> &) { ++orphanCalls; }, 10);
+        delete orphan;
+        manager.setValue(c, HYTagValue::fromInt64(1000));
+
+        manager.unsubscribe(subscriber);
+        manager.setValue(a, HYTagValue::fromInt64(1000));
+        QTest::qWait(100);
+        QCOMPARE(orphanCalls, 0);
+        QCOMPARE(batches, 1);
+    }
+
+    /**
+     * @brief 测试点位定义文件批量导入
+     * 
+     * 测试CSV解析（引号、列顺序、值类型）、只发出一次tagsAdded、跳过已存在的点位，
+     * 以及二进制格式的导出和导入往返
+     */
+    void testImportTags() {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+
+        const QString csvPath = dir.filePath("tags.csv");
+        QFile csv(csvPath);
+        QVERIFY(csv.open(QIODevice::WriteOnly));
+        csv.write("Source,Name,Value,Group,Description\n"
+                  "PLC1,Import_Double,1.5,Import_Group,\"Furnace, zone 1\"\n"
+                  "\n"
+                  "PLC1,Import_Int,42,Import_Group,\"Said \"\"hi\"\"\"\n"
+                  "PLC2,Import_Bool,true,Import_Group,\n"
+                  "PLC2,Import_Text,open,Other_Group,\n"
+                  "PLC2,Import_Empty,,Other_Group,\n");
+        csv.close();
+
+        HYTagManager manager;
+        manager.addTag("Import_Int", "Existing_Group", 0);
+        QSignalSpy addedSpy(&manager, &HYTagManager::tagAdded);
+        QSignalSpy batchSpy(&manager, &HYTagManager::tagsAdded);
+
+        QCOMPARE(manager.importTags(csvPath), 4);
+        QCOMPARE(addedSpy.count(), 0);
+        QCOMPARE(batchSpy.count(), 1);
+        QCOMPARE(batchSpy.at(0).at(0).toStringList(),
+                 QStringList({"Import_Double", "Import_Bool", "Import_Text", "Import_Empty"}));
+
+        QCOMPARE(manager.getTagValue("Import_Double"), QVariant(1.5));
+        QCOMPARE(manager.getTagValue("Import_Int"), QVariant(0));
+        QCOMPARE(manager.getTagValue("Import_Bool"), QVariant(true));
+        QCOMPARE(manager.getTagValue("Import_Text"), QVariant(QString("open")));
+        QVERIFY(!manager.getTagValue("Import_Empty").isValid());
+        QCOMPARE(manager.getTag("Import_Double")->description(), QString("Furnace, zone 1"));
+        QCOMPARE(manager.getTag("Import_Double")->source(), QString("PLC1"));
+        QCOMPARE(manager.getTagsByGroup("Other_Group").size(), 2);
+
+        // 导入的点位与逐个添加的点位一样可按句柄访问
+        const HYTagManager::TagId id = manager.resolveTag("Import_Double");
+        QVERIFY(id != HYTagManager::InvalidTagId);
+        QVERIFY(manager.setValue(id, HYTagValue::fromDouble(2.5)));
+
+        // 二进制格式保留值类型
+        const QString binaryPath = dir.filePath("tags.bin");
+        QVERIFY(manager.exportTags(binaryPath, HYTagManager::TagFileBinary));
+        HYTagManager restored;
+        QCOMPARE(restored.importTags(binaryPath), 5);
+        QCOMPARE(restored.getTagValue("Import_Double"), QVariant(2.5));
+        QCOMPARE(restored.getTagValue("Import_Text"), QVariant(QString("open")));
+        QCOMPARE(restored.getTag("Import_Int")->group(), QString("Existing_Group"));
+
+        const QString exportedCsv = dir.filePath("exported.csv");
+        QVERIFY(manager.exportTags(exportedCsv, HYTagManager::TagFileCsv));
+        HYTagManager fromCsv;
+        QCOMPARE(fromCsv.importTags(exportedCsv), 5);
+        QCOMPARE(fromCsv.getTag("Import_Int")->description(), QString());
+        QCOMPARE(fromCsv.getTag("Import_Double")->description(), QString("Furnace, zone 1"));
+
+        // 缺少name列或文件不存在时报告错误
+        QFile invalid(dir.filePath("invalid.csv"));
+        QVERIFY(invalid.open(QIODevice::WriteOnly));
+        invalid.write("group,value\nA,1\n");
+        invalid.close();
+        QString error;
+        QCOMPARE(fromCsv.importTags(invalid.fileName(), &error), -1);
+        QVERIFY(!error.isEmpty());
+        QCOMPARE(fromCsv.importTags(dir.filePath("missing.csv")), -1);
+    }
+
+    /**
+     * @brief 测试状态日志
+     * 
+     * 测试检查点加日志回放、点位增删、质量码，以及日志末尾写了一半的块被丢弃
+     */
+    void testPersistence() {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        const QString statePath = dir.filePath("state/persist.state");
+
+        {
+            HYTagManager manager;
+            manager.addTag("Persist_Double", "Persist_Group", 1.5, "Kept", "PLC1");
+            manager.addTag("Persist_Removed", "Persist_Group", 0);
+            manager.enablePersistence(true, statePath);
+            manager.saveState();
+            QVERIFY(QFile::exists(statePath));
+
+            // 检查点之后的变化只进入日志，析构时落盘
+            manager.setTagValue("Persist_Double", 2.5);
+            manager.addTag("Persist_Text", "Other_Group", QString("open"));
+            manager.setTagValue("Persist_Text", QString("closed"));
+            manager.setQuality(manager.resolveTag("Persist_Text"), HYTagValueStore::QualityCommFailure);
+            QVERIFY(manager.removeTag("Persist_Removed"));
+        }
+
+        {
+            HYTagManager restored;
+            restored.addTag("Persist_Double", "Persist_Group", 0.0);
+            QSignalSpy batchSpy(&restored, &HYTagManager::tagsAdded);
+            restored.enablePersistence(true, statePath);
+            restored.loadState();
+
+            QCOMPARE(batchSpy.count(), 1);
+            QCOMPARE(batchSpy.at(0).at(0).toStringList(), QStringList({"Persist_Text"}));
+            QCOMPARE(restored.getTagValue("Persist_Double"), QVariant(2.5));
+            QCOMPARE(restored.getTagValue("Persist_Text"), QVariant(QString("closed")));
+            QCOMPARE(restored.quality(restored.resolveTag("Persist_Text")), quint8(HYTagValueStore::QualityCommFailure));
+            QCOMPARE(restored.getTag("Persist_Text")->group(), QString("Other_Group"));
+            QVERIFY(!restored.getTag("Persist_Removed"));
+
+            // 回放后写入了新的检查点，此后的变化按新的句柄记录
+            restored.setTagValue("Persist_Double", 3.5);
+        }
+
+        // 模拟崩溃时写了一半的日志块
+        const QStringList journals = QDir(dir.filePath("state")).entryList(QStringList() << "*.wal", QDir::Files);
+        QCOMPARE(journals.size(), 1);
+        QFile journal(dir.filePath("state/" + journals.first()));
+        QVERIFY(journal.open(QIODevice::Append));
+        journal.write(QByteArray("\x40\x00\x00\x00\x12\x34\x56\x78torn", 12));
+        journal.close();
+
+        HYTagManager recovered;
+        recovered.enablePersistence(true, statePath);
+        recovered.loadState();
+        QCOMPARE(recovered.getTagValue("Persist_Double"), QVariant(3.5));
+        QCOMPARE(recovered.getTagValue("Persist_Text"), QVariant(QString("closed")));
+        QCOMPARE(recovered.getAllTags().size(), 2);
+    }
+
+    /**
+     * @brief 测试从旧版本的JSON状态文件升级
+     * 
+     * 测试还没有检查点时导入JSON文件，检查点写在它旁边，JSON文件保留原样，之后的加载读取检查点
+     */
+    void testLegacyStateImport() {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        const QString jsonPath = dir.filePath("persist.json");
+        const QByteArray json = "{\n    \"tags\": [\n"
+                                "        {\"name\": \"Legacy_Double\", \"group\": \"Legacy_Group\", \"value\": 4.5,"
+                                " \"description\": \"Old\", \"source\": \"PLC1\"},\n"
+                                "        {\"name\": \"Legacy_Text\", \"group\": \"Legacy_Group\", \"value\": \"idle\"}\n"
+                                "    ]\n}\n";
+        QFile file(jsonPath);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write(json);
+        file.close();
+
+        {
+            HYTagManager manager;
+            QSignalSpy batchSpy(&manager, &HYTagManager::tagsAdded);
+            manager.enablePersistence(true, jsonPath);
+            manager.loadState();
+
+            QCOMPARE(batchSpy.count(), 1);
+            QCOMPARE(manager.getTagValue("Legacy_Double"), QVariant(4.5));
+            QCOMPARE(manager.getTagValue("Legacy_Text"), QVariant(QString("idle")));
+            QCOMPARE(manager.getTag("Legacy_Double")->source(), QString("PLC1"));
+            QVERIFY(QFile::exists(jsonPath + ".state"));
+            manager.setTagValue("Legacy_Double", 5.5);
+        }
+
+        // JSON文件不被覆盖，之后的加载读取检查点和日志
+        QVERIFY(file.open(QIODevice::ReadOnly));
+        QCOMPARE(file.readAll(), json);
+        file.close();
+
+        HYTagManager restored;
+        restored.enablePersistence(true, jsonPath);
+        restored.loadState();
+        QCOMPARE(restored.getTagValue("Legacy_Double"), QVariant(5.5));
+        QCOMPARE(restored.getAllTags().size(), 2);
+
+        // 旧的默认文件persist.json在新的默认路径persist.state旁边时同样导入
+        HYTagManager defaults;
+        defaults.enablePersistence(true, dir.filePath("persist.state"));
+        defaults.loadState();
+        QCOMPARE(defaults.getTagValue("Legacy_Text"), QVariant(QString("idle")));
+        QVERIFY(QFile::exists(dir.filePath("persist.state")));
+    }
+
+    /**
+     * @brief 测试值快照的热重启
+     * 
+     * 测试启用持久化后新增和已有的点位立即取回上次运行中最后的值，质量码为最后可用值，源时间戳保留
+     */
+    void testWarmRestart() {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        const QString statePath = dir.filePath("persist.state");
+        const qint64 sourceTimestamp = QDateTime::currentMSecsSinceEpoch() - 60000;
+
+        {
+            HYTagManager manager;
+            manager.enablePersistence(true, statePath);
+            manager.addTag("Warm_Double", "Warm_Group", 0.0);
+            manager.addTag("Warm_Text", "Warm_Group", QString());
+            manager.addTag("Warm_Removed", "Warm_Group", 7);
+            manager.setValue(manager.resolveTag("Warm_Double"), HYTagValue::fromDouble(42.5), sourceTimestamp,
+                             HYTagValueStore::QualityGood);
+            manager.setTagValue("Warm_Text", QString("running"));
+            QVERIFY(manager.removeTag("Warm_Removed"));
+        }
+
+        // 未调用loadState，值直接来自快照
+        HYTagManager restarted;
+        restarted.addTag("Warm_Text", "Warm_Group", QString("unknown"));
+        restarted.enablePersistence(true, statePath);
+        restarted.addTag("Warm_Double", "Warm_Group", -1.0);
+        restarted.addTag("Warm_Removed", "Warm_Group", 0);
+
+        const HYTagRecord warm = restarted.record(restarted.resolveTag("Warm_Double"));
+        QCOMPARE(warm.value.toDouble(), 42.5);
+        QCOMPARE(warm.sourceTimestamp, sourceTimestamp);
+        QCOMPARE(warm.quality, quint8(HYTagValueStore::QualityLastUsable));
+        QCOMPARE(restarted.getTagValue("Warm_Text"), QVariant(QString("running")));
+        QCOMPARE(restarted.quality(restarted.resolveTag("Warm_Text")), quint8(HYTagValueStore::QualityLastUsable));
+        QCOMPARE(restarted.getTagValue("Warm_Removed"), QVariant(0));
+
+        // 新值到来后质量码恢复为好值
+        restarted.setValue(restarted.resolveTag("Warm_Double"), HYTagValue::fromDouble(43.0));
+        QCOMPARE(restarted.quality(restarted.resolveTag("Warm_Double")), quint8(HYTagValueStore::QualityGood));
+    }
+
+    /**
+     * @brief 测试离线数据缓冲区和回放
+     * 
+     * 测试离线期间内存占用有界、超出的数据写入磁盘且总大小不超过上限，
+     * 重新上线后积压数据按源时间戳成批写入历史库并清空，回放进度报告速率和剩余积压
+     */
+    void testOfflineBuffer() {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+
+        // 点位管理器占用默认的数据库连接，历史库在其后初始化
+        HYTagManager manager;
+        HYTimeSeriesDatabase historian;
+        HYTimeSeriesDatabase::DatabaseConfig config;
+        config.type = HYTimeSeriesDatabase::SQLITE;
+        config.port = 0;
+        config.database = dir.filePath("history.db");
+        config.tableName = "offline_history";
+        QVERIFY(historian.initialize(config));
+
+        manager.setOfflineBufferDirectory(dir.filePath("offline"));
+        manager.setOfflineBufferLimits(4096, 256 * 1024);
+        manager.setOfflineReplayLimits(2000, 1000000);
+        manager.setHistorian(&historian);
+        manager.addTag("Offline_Double", "Offline_Group", 0.0);
+        const HYTagManager::TagId id = manager.resolveTag("Offline_Double");
+
+        QSignalSpy syncSpy(&manager, &HYTagManager::syncCompleted);
+        QSignalSpy progressSpy(&manager, &HYTagManager::offlineReplayProgress);
+        manager.setOfflineMode(true);
+
+        // 每个值一秒，历史库按秒存储时间戳
+        const qint64 start = QDateTime::currentMSecsSinceEpoch() - 86400000;
+        const int writes = 20000;
+        for (int i = 1; i <= writes; ++i) {
+            manager.setValue(id, HYTagValue::fromDouble(i), start + i * 1000, HYTagValueStore::QualityGood);
+        }
+        QVERIFY(manager.offlineDiskSize() > 0);
+        QVERIFY(manager.offlineDiskSize() <= 256 * 1024);
+
+        // 最旧的数据被丢弃，其余数据在上线后回放
+        manager.setOfflineMode(false);
+        QTRY_COMPARE_WITH_TIMEOUT(syncSpy.count(), 1, 30000);
+        QVERIFY(syncSpy.at(0).at(0).toBool());
+        const int synced = syncSpy.at(0).at(1).toInt();
+        QVERIFY(synced > 0);
+        QVERIFY(synced < writes);
+        QVERIFY(progressSpy.count() > 1);
+        QCOMPARE(progressSpy.last().at(2).toLongLong(), qint64(0));
+        QCOMPARE(manager.offlineBacklogBytes(), qint64(0));
+
+        const QMap<QDateTime, QVariant> history = historian.queryTagHistory(
+            "Offline_Double", QDateTime::fromMSecsSinceEpoch(start), QDateTime::currentDateTime(), writes);
+        QCOMPARE(history.size(), synced);
+        QCOMPARE(history.last().toDouble(), double(writes));
+    }
+
+    /**
+     * @brief 测试离线时的批量写入
+     * 
+     * setTagValues写入的值与逐个写入一样进入离线缓冲，上线后回放到历史库
+     */
+    void testOfflineBatchWrites() {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+
+        HYTagManager manager;
+        HYTimeSeriesDatabase historian;
+        HYTimeSeriesDatabase::DatabaseConfig config;
+        config.type = HYTimeSeriesDatabase::SQLITE;
+        config.port = 0;
+        config.database = dir.filePath("history.db");
+        config.tableName = "offline_batch_history";
+        QVERIFY(historian.initialize(config));
+
+        manager.setOfflineBufferDirectory(dir.filePath("offline"));
+        manager.setOfflineBufferLimits(4096, 1024 * 1024);
+        manager.setHistorian(&historian);
+        manager.addTag("Offline_Batch_A", "Offline_Group", 0.0);
+        manager.addTag("Offline_Batch_B", "Offline_Group", QString());
+
+        QSignalSpy syncSpy(&manager, &HYTagManager::syncCompleted);
+        const QDateTime start = QDateTime::currentDateTime();
+        manager.setOfflineMode(true);
+
+        // 缓冲超过内存份额后写入磁盘
+        const int writes = 2000;
+        for (int i = 1; i <= writes; ++i) {
+            QMap<QString, QVariant> batch;
+            batch["Offline_Batch_A"] = double(i);
+            batch["Offline_Batch_B"] = QString("State %1").arg(i);
+            QVERIFY(manager.setTagValues(batch));
+        }
+        QVERIFY(manager.offlineBacklogBytes() > 0);
+
+        manager.setOfflineMode(false);
+        QTRY_COMPARE_WITH_TIMEOUT(syncSpy.count(), 1, 30000);
+        QVERIFY(syncSpy.at(0).at(0).toBool());
+        QVERIFY(syncSpy.at(0).at(1).toInt() > 0);
+        QCOMPARE(manager.offlineBacklogBytes(), qint64(0));
+
+        const QDateTime end = QDateTime::currentDateTime().addSecs(1);
+        QMap<QDateTime, QVariant> history = historian.queryTagHistory("Offline_Batch_A", start.addSecs(-1), end, writes);
+        QVERIFY(!history.isEmpty());
+        QCOMPARE(history.last().toDouble(), double(writes));
+        history = historian.queryTagHistory("Offline_Batch_B", start.addSecs(-1), end, writes);
+        QVERIFY(!history.isEmpty());
+        QCOMPARE(history.last().toString(), QString("State %1").arg(writes));
+    }
+
+    /**
+     * @brief 测试离线数据回放的断点续传
+     * 
+     * 测试提交的读取位置在重新打开后生效，未提交的读取可以退回重读，已读完的段被删除
+     */
+    void testOfflineReplayResume() {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+
+        const auto chunk = [](qint64 first, int count) {
+            QByteArray entries;
+            HYTagJournal::appendDefine(&entries, 3, "Offline_Resume", QString(), QString(), QString());
+            for (int i = 0; i < count; ++i) {
+                HYTagJournal::appendValue(&entries, 3, HYTagValue::fromInt64(first + i), first + i,
+                                          HYTagValueStore::QualityGood);
+            }
+            return entries;
+        };
+
+        QVector<qint64> seen;
+        const auto collect = [&seen](const HYOfflineBuffer::Sample &sample) {
+            seen.append(sample.timestamp);
+        };
+        {
+            HYOfflineBuffer buffer(dir.path());
+            for (int i = 0; i < 4; ++i) {
+                QVERIFY(buffer.spill(chunk(i * 100, 100)));
+            }
+            buffer.seal();
+
+            // 未提交的读取被退回
+            QCOMPARE(buffer.read(100, collect), qint64(100));
+            buffer.rewind();
+            QCOMPARE(buffer.read(150, collect), qint64(200));
+            QVERIFY(buffer.commit());
+            QCOMPARE(seen.last(), qint64(199));
+        }
+
+        // 重新打开后从提交的位置继续
+        seen.clear();
+        HYOfflineBuffer reopened(dir.path());
+        QCOMPARE(reopened.drain(collect), qint64(200));
+        QCOMPARE(seen.first(), qint64(200));
+        QCOMPARE(seen.last(), qint64(399));
+        QCOMPARE(reopened.segmentCount(), 0);
+        QCOMPARE(reopened.backlogBytes(), qint64(0));
+    }
+
+    /**
+     * @brief 测试离线数据的降采样淘汰
+     * 
+     * 测试超过磁盘上限时最旧的段被降采样而不是丢弃，取出的数据保持时间顺序，最早和最新的数据都保留
+     */
+    void testOfflineDownsample() {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+
+        HYOfflineBuffer buffer(dir.path());
+        buffer.setDiskLimit(256 * 1024);
+        buffer.setEvictionPolicy(HYOfflineBuffer::EvictDownsample);
+
+        qint64 timestamp = 0;
+        for (int chunk = 0; chunk < 200; ++chunk) {
+            QByteArray entries;
+            HYTagJournal::appendDefine(&entries, 7, "Offline_Sampled", QString(), QString(), QString());
+            for (int i = 0; i < 170; ++i, ++timestamp) {
+                HYTagJournal::appendValue(&entries, 7, HYTagValue::fromInt64(timestamp), timestamp,
+                                          HYTagValueStore::QualityGood);
+            }
+            QVERIFY(buffer.spill(entries));
+        }
+        QVERIFY(buffer.diskSize() <= 256 * 1024);
+        QVERIFY(buffer.evictedBytes() > 0);
+
+        QVector<qint64> timestamps;
+        const qint64 drained = buffer.drain([&timestamps](const HYOfflineBuffer::Sample &sample) {
+            QCOMPARE(sample.name, QString("Offline_Sampled"));
+            QCOMPARE(sample.value.toLongLong(), sample.timestamp);
+            timestamps.append(sample.timestamp);
+        });
+        QCOMPARE(drained, qint64(timestamps.size()));
+        QVERIFY(drained < timestamp);
+        QCOMPARE(timestamps.first(), qint64(0));
+        QCOMPARE(timestamps.last(), timestamp - 1);
+        QVERIFY(std::is_sorted(timestamps.cbegin(), timestamps.cend()));
+        QCOMPARE(buffer.segmentCount(), 0);
+    }
+
+    /**
+     * @brief 测试共享内存点位表
+     *
+     * 测试读取端按名称查找发布前后添加的点位、读到最新的值和质量码，以及删除点位和停止发布后的状态
+     */
+    void testSharedMemoryTable() {
+        HYTagManager manager;
+        manager.addTag("Shared_Level", "Shared", 1.5);
+        const QString name = QString("huayan.test.%1").arg(QCoreApplication::applicationPid());
+        QVERIFY(manager.publishSharedMemory(name, 1024));
+        QCOMPARE(manager.sharedMemoryName(), "/" + name);
+        manager.addTag("Shared_Label", "Shared", QString("idle"));
+
+        HYTagSharedReader reader;
+        QVERIFY(reader.open(name.toStdString()));
+        QVERIFY(reader.isLive());
+        QCOMPARE(reader.tagCount(), quint32(2));
+
+        const int32_t level = reader.find("Shared_Level");
+        const int32_t label = reader.find("Shared_Label");
+        QCOMPARE(level, manager.resolveTag("Shared_Level"));
+        QCOMPARE(label, manager.resolveTag("Shared_Label"));
+        QCOMPARE(reader.find("Shared_Missing"), -1);
+        QCOMPARE(QString::fromStdString(reader.nameAt(level)), QString("Shared_Level"));
+
+        HYTagSharedReader::Value value;
+        QVERIFY(reader.read(level, &value));
+        QCOMPARE(int(value.type), int(HYTagSharedLayout::TypeDouble));
+        QCOMPARE(value.doubleValue, 1.5);
+        QVERIFY(reader.read("Shared_Label", &value));
+        QCOMPARE(int(value.type), int(HYTagSharedLayout::TypeString));
+        QCOMPARE(QString::fromStdString(value.text), QString("idle"));
+
+        // 值和质量码随写入更新
+        QVERIFY(manager.setValue(manager.resolveTag("Shared_Level"), HYTagValue::fromDouble(42.0), 1000,
+                                 HYTagValueStore::QualitySensorNotAccurate));
+        QVERIFY(reader.read(level, &value));
+        QCOMPARE(value.doubleValue, 42.0);
+        QCOMPARE(value.sourceTimestamp, qint64(1000));
+        QCOMPARE(value.quality, quint8(HYTagValueStore::QualitySensorNotAccurate));
+        QVERIFY(!value.isGood());
+
+        // 删除的点位不再可读，缓存的下标也失效
+        QVERIFY(manager.removeTag("Shared_Label"));
+        QVERIFY(!reader.read(label, &value));
+        QCOMPARE(reader.find("Shared_Label"), -1);
+        QCOMPARE(reader.tagCount(), quint32(1));
+
+        // 停止发布后已映射的读取端仍可读出最后的值，但不再是实时的
+        manager.unpublishSharedMemory();
+        QVERIFY(!reader.isLive());
+        QVERIFY(reader.read(level, &value));
+        QCOMPARE(value.doubleValue, 42.0);
+        HYTagSharedReader reopened;
+        QVERIFY(!reopened.open(name.toStdString()));
+    }
+
+    /**
+     * @brief 测试按例外归档历史数据
+     *
+     * 测试启用时写入当前值、死区内的变化不写入、质量码变化总是写入、单点死区、心跳不重复写入，以及按类型和毫秒时间戳读回
+     */
+    void testHistoryArchiving() {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+
+        HYTagManager manager;
+        QVERIFY(manager.setHistoryDatabasePath(dir.filePath("history.db")));
+        QCOMPARE(manager.historyDatabasePath(), dir.filePath("history.db"));
+        manager.setHistoryDeadband(0.5);
+        manager.setHistoryDeadband("History_Count", 10.0);
+        manager.addTag("History_Level", "History", 1.0);
+        manager.addTag("History_Count", "History", 0);
+        manager.addTag("History_State", "History", QString("idle"));
+        const HYTagManager::TagId level = manager.resolveTag("History_Level");
+        const HYTagManager::TagId count = manager.resolveTag("History_Count");
+        const HYTagManager::TagId state = manager.resolveTag("History_State");
+
+        // 启用时每个点位写入一次当前值，之后无变化时不再写入
+        manager.enableHistoryStorage(true, 3600000);
+        QCOMPARE(manager.archiveHistory(), 3);
+        QCOMPARE(manager.archiveHistory(), 0);
+
+        // 死区内的变化不写入，超过死区和质量码变化写入
+        QVERIFY(manager.setValue(level, HYTagValue::fromDouble(1.3), 1000, HYTagValueStore::QualityGood));
+        QVERIFY(manager.setValue(count, HYTagValue::fromInt64(8), 1000, HYTagValueStore::QualityGood));
+        QCOMPARE(manager.archiveHistory(), 0);
+        QVERIFY(manager.setValue(level, HYTagValue::fromDouble(2.0), 2001, HYTagValueStore::QualityGood));
+        QVERIFY(manager.setValue(count, HYTagValue::fromInt64(8), 2002, HYTagValueStore::QualityLastUsable));
+        QVERIFY(manager.setValue(state, HYTagValue::fromString("run"), 2003, HYTagValueStore::QualityGood));
+        QCOMPARE(manager.archiveHistory(), 3);
+
+        const QDateTime start = QDateTime::fromMSecsSinceEpoch(2000);
+        const QDateTime end = QDateTime::fromMSecsSinceEpoch(3000);
+        QVector<quint8> qualities;
+        QVector<QPair<QDateTime, QVariant>> data = manager.getHistoricalData("History_Level", start, end, &qualities);
+        QCOMPARE(data.size(), 1);
+        QCOMPARE(data.first().first.toMSecsSinceEpoch(), qint64(2001));
+        QCOMPARE(data.first().second.metaType().id(), QMetaType::Double);
+        QCOMPARE(data.first().second.toDouble(), 2.0);
+        QCOMPARE(qualities, QVector<quint8>{quint8(HYTagValueStore::QualityGood)});
+
+        data = manager.getHistoricalData("History_Count", start, end, &qualities);
+        QCOMPARE(data.size(), 1);
+        QCOMPARE(data.first().second.toLongLong(), qint64(8));
+        QCOMPARE(qualities, QVector<quint8>{quint8(HYTagValueStore::QualityLastUsable)});
+
+        data = manager.getHistoricalData("History_State", start, end);
+        QCOMPARE(data.size(), 1);
+        QCOMPARE(data.first().second.toString(), QString("run"));
+
+        // 启用时写入的样本带当前时间，不在查询范围内
+        QCOMPARE(manager.getHistoricalData("History_Level", QDateTime::fromMSecsSinceEpoch(0), end).size(), 1);
+        QCOMPARE(manager.getHistoricalData("History_Missing", start, end).size(), 0);
+
+        // 心跳补写未变化的点位，同一轮已按变化写入的点位不重复写入
+        manager.setHistoryHeartbeat(1);
+        QTest::qWait(5);
+        QVERIFY(manager.setValue(level, HYTagValue::fromDouble(3.0), 2600, HYTagValueStore::QualityGood));
+        QCOMPARE(manager.archiveHistory(), 3);
+        QCOMPARE(manager.getHistoricalData("History_Level", start, end).size(), 2);
+
+        manager.enableHistoryStorage(false);
+        QVERIFY(manager.setValue(level, HYTagValue::fromDouble(5.0), 2500, HYTagValueStore::QualityGood));
+        QCOMPARE(manager.archiveHistory(), 0);
+    }
+
+    /**
+     * @brief 测试计算点位
+     *
+     * 测试定义时的检查、链式依赖、只重算受影响的点位、事件循环中的合并重算、质量码传递，以及删除输入点位
+     */
+    void testCalculatedTags() {
+        HYTagManager manager;
+        manager.addTag("Calc_In", "Calc", 50.0);
+        manager.addTag("Calc_Out", "Calc", 45.0);
+        manager.addTag("Calc_Offset", "Calc", 1);
+        manager.addTag("Calc_Other", "Calc", 0);
+        const HYTagManager::TagId in = manager.resolveTag("Calc_In");
+        const HYTagManager::TagId out = manager.resolveTag("Calc_Out");
+
+        QString error;
+        QVERIFY2(manager.addCalculatedTag("Calc_Eff", "Calc", "Calc_Out / Calc_In * 100", "", &error), qPrintable(error));
+        QVERIFY(manager.addCalculatedTag("Calc_Total", "Calc", "Calc_Eff + Calc_Offset"));
+        QVERIFY(manager.addCalculatedTag("Calc_Unrelated", "Calc", "Calc_Other * 2"));
+        QCOMPARE(manager.getTagValue("Calc_Eff").toDouble(), 90.0);
+        QCOMPARE(manager.getTagValue("Calc_Total").toDouble(), 91.0);
+        QVERIFY(manager.isCalculatedTag("Calc_Total"));
+        QVERIFY(!manager.isCalculatedTag("Calc_In"));
+        QCOMPARE(manager.calculatedExpression("Calc_Eff"), QString("Calc_Out / Calc_In * 100"));
+
+        // 引用不存在的点位、语法错误和重名都不会留下点位
+        QVERIFY(!manager.addCalculatedTag("Calc_Bad", "Calc", "Calc_Missing + 1", "", &error));
+        QVERIFY(error.contains("Calc_Missing"));
+        QVERIFY(!manager.addCalculatedTag("Calc_Bad", "Calc", "Calc_In +", "", &error));
+        QVERIFY(manager.getTag("Calc_Bad") == nullptr);
+        QVERIFY(!manager.addCalculatedTag("Calc_Eff", "Calc", "1"));
+        QCOMPARE(manager.calculatedExpression("Calc_Eff"), QString("Calc_Out / Calc_In * 100"));
+
+        // 只重算依赖变化点位的计算点位
+        QVERIFY(manager.setValue(in, HYTagValue::fromDouble(60.0), 1000, HYTagValueStore::QualityGood));
+        QCOMPARE(manager.recomputeCalculatedTags(), 2);
+        QCOMPARE(manager.getTagValue("Calc_Eff").toDouble(), 75.0);
+        QCOMPARE(manager.getTagValue("Calc_Total").toDouble(), 76.0);
+        QVERIFY(manager.record(manager.resolveTag("Calc_Eff")).sourceTimestamp >= 1000);
+        QVERIFY(manager.setTagValue("Calc_Other", 4));
+        QCOMPARE(manager.recomputeCalculatedTags(), 1);
+        QCOMPARE(manager.getTagValue("Calc_Unrelated").toDouble(), 8.0);
+        QCOMPARE(manager.recomputeCalculatedTags(), 0);
+
+        // 写入方只做标记，事件循环中合并重算一次
+        QVERIFY(manager.setValue(out, 36.0));
+        QVERIFY(manager.setValue(in, 40.0));
+        QTRY_COMPARE(manager.getTagValue("Calc_Total").toDouble(), 91.0);
+        QCOMPARE(manager.getTagValue("Calc_Eff").toDouble(), 90.0);
+
+        // 质量码取输入中最差的，非有限结果为坏值
+        QVERIFY(manager.setQuality(manager.resolveTag("Calc_Offset"), HYTagValueStore::QualityNotConnected));
+        manager.recomputeCalculatedTags();
+        QCOMPARE(manager.quality(manager.resolveTag("Calc_Total")), quint8(HYTagValueStore::QualityNotConnected));
+        QCOMPARE(manager.quality(manager.resolveTag("Calc_Eff")), quint8(HYTagValueStore::QualityGood));
+        QVERIFY(manager.setValue(in, 0.0));
+        manager.recomputeCalculatedTags();
+        QCOMPARE(manager.quality(manager.resolveTag("Calc_Eff")), quint8(HYTagValueStore::QualityBad));
+
+        // 删除输入点位后依赖它的计算点位标记为配置错误
+        QVERIFY(manager.setValue(in, 40.0));
+        manager.recomputeCalculatedTags();
+        QVERIFY(manager.removeTag("Calc_Offset"));
+        QCOMPARE(manager.quality(manager.resolveTag("Calc_Total")), quint8(HYTagValueStore::QualityConfigError));
+        QVERIFY(manager.removeTag("Calc_Eff"));
+        QVERIFY(!manager.isCalculatedTag("Calc_Eff"));
+        QCOMPARE(manager.recomputeCalculatedTags(), 0);
+    }
+
+    /**
+     * @brief 测试按名称模式订阅
+     * 
+     * 测试"*"和"**"通配符、订阅后新增的匹配点位、初始值送达，以及取消订阅后新点位不再被关注
+     */
+    void testPatternSubscribe() {
+        HYTagManager manager;
+        manager.addTag("plant.bf1.zone1.temperature", "Pattern_Group", 0);
+        manager.addTag("plant.bf1.zone2.temperature", "Pattern_Group", 0);
+        manager.addTag("plant.bf1.zone1.pressure", "Pattern_Group", 0);
+        manager.addTag("plant.bf2.zone1.temperature", "Pattern_Group", 0);
+        const HYTagManager::TagId t1 = manager.resolveTag("plant.bf1.zone1.temperature");
+        const HYTagManager::TagId t2 = manager.resolveTag("plant.bf1.zone2.temperature");
+        const HYTagManager::TagId p1 = manager.resolveTag("plant.bf1.zone1.pressure");
+        const HYTagManager::TagId other = manager.resolveTag("plant.bf2.zone1.temperature");
+
+        QVERIFY(manager.subscribe("plant..temperature", nullptr) < 0);
+        QVERIFY(manager.subscribe("", nullptr) < 0);
+
+        QObject context;
+        HYSubscribeOptions options;
+        options.context = &context;
+        options.maxLatency = 20;
+        QVector<HYTagUpdate> single;
+        const int singleSubscriber = manager.subscribe("plant.bf1.*.temperature", [&](const QVector<HYTagUpdate> &updates) {
+            single += updates;
+        }, options);
+        QVERIFY(singleSubscriber > HYTagManager::DelayedSubscriber);
+
+        options.initialValues = true;
+        QVector<HYTagUpdate> multi;
+        const int multiSubscriber = manager.subscribe("plant.bf1.**", [&](const QVector<HYTagUpdate> &updates) {
+            multi += updates;
+        }, options);
+
+        // 初始值批次包含订阅时已匹配的全部点位
+        QTRY_COMPARE(multi.size(), 3);
+        QCOMPARE(single.size(), 0);
+        multi.clear();
+
+        manager.setValue(t1, HYTagValue::fromInt64(1));
+        manager.setValue(t2, HYTagValue::fromInt64(2));
+        manager.setValue(p1, HYTagValue::fromInt64(3));
+        manager.setValue(other, HYTagValue::fromInt64(4));
+        QTRY_COMPARE(single.size(), 2);
+        QTRY_COMPARE(multi.size(), 3);
+        QCOMPARE(single[0].id, t1);
+        QCOMPARE(single[1].value, HYTagValue::fromInt64(2));
+        single.clear();
+        multi.clear();
+
+        // 订阅之后添加的匹配点位同样被通知
+        manager.addTag("plant.bf1.zone3.temperature", "Pattern_Group", 0);
+        manager.addTag("plant.bf1.temperature", "Pattern_Group", 0);
+        const HYTagManager::TagId t3 = manager.resolveTag("plant.bf1.zone3.temperature");
+        const HYTagManager::TagId shallow = manager.resolveTag("plant.bf1.temperature");
+        manager.setValue(t3, HYTagValue::fromInt64(5));
+        manager.setValue(shallow, HYTagValue::fromInt64(6));
+        QTRY_COMPARE(multi.size(), 2);
+        QTRY_COMPARE(single.size(), 1);
+        QCOMPARE(single[0].id, t3);
+
+        // 取消订阅后模式不再匹配新点位，另一个订阅不受影响
+        manager.unsubscribe(singleSubscriber);
+        single.clear();
+        multi.clear();
+        manager.addTag("plant.bf1.zone4.temperature", "Pattern_Group", 0);
+        manager.setValue(manager.resolveTag("plant.bf1.zone4.temperature"), HYTagValue::fromInt64(7));
+        QTRY_COMPARE(multi.size(), 1);
+        QTest::qWait(50);
+        QCOMPARE(single.size(), 0);
+
+        manager.unsubscribe(multiSubscriber);
+    }
+
+    /**
+     * @brief 测试属性绑定
+     * 
+     * 测试值按属性类型转换后写入，动态属性按名称写入，目标对象销毁后绑定自动移除
+     */
+    void testPropertyBinding() {
+        HYTagManager manager;
+        manager.addTag("Binding_Tag", "Binding_Group", 1.25);
+        const HYTagManager::TagId id = manager.resolveTag("Binding_Tag");
+
+        BindingTarget *target = new BindingTarget;
+        manager.bindTagToProperty("Binding_Tag", target, "level");
+        manager.bindTagToProperty("Binding_Tag", target, "count");
+        manager.bindTagToProperty("Binding_Tag", target, "text");
+        manager.bindTagToProperty("Binding_Tag", target, "raw");
+        manager.bindTagToProperty("Binding_Tag", target, "dynamicLevel");
+
+        // 绑定时写入初始值
+        QCOMPARE(target->m_level, 1.25);
+        QCOMPARE(target->m_count, 1);
+
+        manager.setValue(id, HYTagValue::fromDouble(42.25));
+        QCOMPARE(target->m_level, 42.25);
+        QCOMPARE(target->m_count, 42);
+        QCOMPARE(target->m_text, QString("42.25"));
+        QCOMPARE(target->m_raw, QVariant(42.25));
+        QCOMPARE(target->property("dynamicLevel"), QVariant(42.25));
+
+        QVERIFY(manager.setTagValue("Binding_Tag", 7));
+        QCOMPARE(target->m_level, 7.0);
+        QCOMPARE(target->m_text, QString("7"));
+
+        manager.unbindTagFromProperty("Binding_Tag", target, "count");
+        QVERIFY(manager.setTagValue("Binding_Tag", 8));
+        QCOMPARE(target->m_count, 7);
+        QCOMPARE(target->m_level, 8.0);
+
+        // 目标对象销毁后继续更新不会访问悬空指针
+        delete target;
+        QVERIFY(manager.setTagValue("Binding_Tag", 9));
+        QMap<QString, QVariant> batch;
+        batch["Binding_Tag"] = 10;
+        QVERIFY(manager.setTagValues(batch));
+        QCOMPARE(manager.getTagValue("Binding_Tag"), QVariant(10));
+    }
+
 private:
     HYTagManager *tagManager; ///< 标签管理器实例
 };
@@ -0,0 +1,225 @@
+#include <QTest>
+#include <QDateTime>
+#include "tagvaluestore.h"
+
+/**
+ * @brief 点位值存储单元测试
+ *
+ * 测试HYTagValueStore类的功能，包括槽位分配、释放以及值、时间戳和质量码的读写
+ * 同时测试HYTagValue类型化值和字符串驻留池
+ */
+class TestTagValueStore : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    /**
+     * @brief 测试类型化值转换
+     *
+     * QVariant标量应无损往返，不支持的类型转换失败
+     */
+    void testTagValue() {
+        HYTagValue value;
+        QVERIFY(HYTagValue::fromVariant(QVariant(42), &value));
+        QCOMPARE(value.type(), HYTagValue::Int64);
+        QCOMPARE(value.toVariant(), QVariant(42));
+
+        QVERIFY(HYTagValue::fromVariant(QVariant(qlonglong(1) << 40), &value));
+        QCOMPARE(value.toVariant().typeId(), int(QMetaType::LongLong));
+
+        QVERIFY(HYTagValue::fromVariant(QVariant(2.5), &value));
+        QCOMPARE(value, HYTagValue::fromDouble(2.5));
+        QCOMPARE(value.toInt64(), qint64(2));
+
+        QVERIFY(HYTagValue::fromVariant(QVariant(false), &value));
+        QCOMPARE(value.toVariant(), QVariant(false));
+
+        QVERIFY(HYTagValue::fromVariant(QVariant(), &value));
+        QVERIFY(value.isNull());
+        QVERIFY(!HYTagValue::fromVariant(QVariant(QDateTime::currentDateTime()), &value));
+
+        QVERIFY(HYTagValue::fromInt64(1) != HYTagValue::fromDouble(1.0));
+    }
+
+    /**
+     * @brief 测试字符串驻留
+     *
+     * 相同内容的字符串应得到相同编号；超过MaxLength的自由文本不驻留，由存储按复杂值保存
+     */
+    void testStringPool() {
+        HYStringPool pool;
+        quint32 a, b, c;
+        QVERIFY(pool.intern("Running", &a));
+        QVERIFY(pool.intern("Stopped", &b));
+        QVERIFY(pool.intern(QString("Run") + "ning", &c));
+        QCOMPARE(a, c);
+        QVERIFY(a != b);
+        QCOMPARE(pool.string(b), QString("Stopped"));
+        QCOMPARE(pool.size(), 2);
+        QVERIFY(pool.string(100).isNull());
+
+        QCOMPARE(HYTagValue::fromString("Alarm"), HYTagValue::fromString(QString("Alarm")));
+        QCOMPARE(HYTagValue::fromString("Alarm").toVariant(), QVariant(QString("Alarm")));
+
+        const QString text(HYStringPool::MaxLength + 1, QChar('x'));
+        QVERIFY(!pool.intern(text, &a));
+        QCOMPARE(pool.size(), 2);
+        HYTagValue typed;
+        QVERIFY(!HYTagValue::fromVariant(text, &typed));
+
+        HYTagValueStore store;
+        const HYTagId id = store.allocate(QVariant(QString("Running")), 100);
+        QVERIFY(store.setValue(id, QVariant(text), 200));
+        QCOMPARE(store.value(id), QVariant(text));
+        QVERIFY(store.setValue(id, QVariant(QString("Stopped")), 300));
+        QCOMPARE(store.typedValue(id), HYTagValue::fromString("Stopped"));
+    }
+
+    /**
+     * @brief 测试槽位分配
+     *
+     * 句柄应从0开始连续分配
+     */
+    void testAllocate() {
+        HYTagValueStore store;
+        QCOMPARE(store.allocate(1, 100), HYTagId(0));
+        QCOMPARE(store.allocate(2, 100), HYTagId(1));
+        QCOMPARE(store.size(), 2);
+        QCOMPARE(store.value(1), QVariant(2));
+        QCOMPARE(store.quality(0), quint8(HYTagValueStore::QualityGood));
+    }
+
+    /**
+     * @brief 测试设置值
+     *
+     * 值变化时返回true，值不变时只更新时间戳
+     */
+    void testSetValue() {
+        HYTagValueStore store;
+        HYTagId id = store.allocate(1.5, 100);
+
+        QVERIFY(store.setValue(id, 2.5, 200));
+        QCOMPARE(store.value(id), QVariant(2.5));
+        QCOMPARE(store.timestamp(id), qint64(200));
+
+        QVERIFY(!store.setValue(id, 2.5, 300));
+        QCOMPARE(store.timestamp(id), qint64(300));
+    }
+
+    /**
+     * @brief 测试释放槽位
+     *
+     * 释放后句柄失效，且新分配不会复用旧句柄
+     */
+    void testRelease() {
+        HYTagValueStore store;
+        HYTagId id = store.allocate(1, 100);
+        store.release(id);
+
+        QVERIFY(!store.contains(id));
+        QVERIFY(!store.setValue(id, 2, 200));
+        QVERIFY(store.value(id).isNull());
+        QVERIFY(store.allocate(3, 100) != id);
+        QVERIFY(!store.contains(HYInvalidTagId));
+    }
+
+    /**
+     * @brief 测试值类型
+     *
+     * 数值、布尔和字符串无锁读取，其他类型通过旁路表保存
+     */
+    void testValueTypes() {
+        HYTagValueStore store;
+        HYTagId intId = store.allocate(7, 0);
+        HYTagId boolId = store.allocate(true, 0);
+        HYTagId floatId = store.allocate(1.25f, 0);
+        HYTagId textId = store.allocate(QString("abc"), 0);
+        HYTagId listId = store.allocate(QStringList() << "a" << "b", 0);
+
+        HYTagValue value;
+        QCOMPARE(store.read(intId, &value), HYTagValueStore::ReadOk);
+        QCOMPARE(value, HYTagValue::fromInt64(7));
+        QCOMPARE(store.value(intId).typeId(), int(QMetaType::Int));
+        QCOMPARE(store.read(boolId, &value), HYTagValueStore::ReadOk);
+        QCOMPARE(value, HYTagValue::fromBool(true));
+        QCOMPARE(store.read(floatId, &value), HYTagValueStore::ReadOk);
+        QCOMPARE(value.toDouble(), 1.25);
+        QCOMPARE(HYTagValue::fromDouble(3.14159265358979).toString(), QString("3.14159265358979"));
+        QCOMPARE(store.read(textId, &value), HYTagValueStore::ReadOk);
+        QCOMPARE(value.toString(), QString("abc"));
+        QVERIFY(!store.setValue(textId, QString("abc"), 1));
+
+        QCOMPARE(store.read(listId, &value), HYTagValueStore::ReadComplex);
+        QCOMPARE(store.value(listId), QVariant(QStringList() << "a" << "b"));
+        QVERIFY(!store.setValue(listId, QStringList() << "a" << "b", 1));
+        QVERIFY(store.setValue(listId, 3.5, 1));
+        QCOMPARE(store.read(listId, &value), HYTagValueStore::ReadOk);
+        QCOMPARE(value, HYTagValue::fromDouble(3.5));
+    }
+
+    /**
+     * @brief 测试同代读取
+     *
+     * 每个写入批次推进一代，批次内的写入不单独推进
+     */
+    void testReadConsistent() {
+        HYTagValueStore store;
+        HYTagId a = store.allocate(1, 0);
+        HYTagId b = store.allocate(2, 0);
+
+        quint64 generation = store.generation();
+        store.beginWrite();
+        store.setValue(a, 10, 1);
+        store.setValue(b, 20, 1);
+        store.endWrite();
+        QCOMPARE(store.generation(), generation + 1);
+
+        QVector<HYTagValue> values;
+        quint64 readGeneration = 0;
+        QVERIFY(store.readConsistent(QVector<HYTagId>() << a << b, &values, &readGeneration));
+        QCOMPARE(readGeneration, generation + 1);
+        QCOMPARE(values[0], HYTagValue::fromInt64(10));
+        QCOMPARE(values[1], HYTagValue::fromInt64(20));
+    }
+
+    /**
+     * @brief 测试时间戳和质量码
+     *
+     * 源时间戳与服务器时间戳分别保存，质量码变化视为值变化
+     */
+    void testQuality() {
+        HYTagValueStore store;
+        HYTagId id = store.allocate(1.0, 100);
+
+        HYTagRecord record;
+        QCOMPARE(store.readRecord(id, &record), HYTagValueStore::ReadOk);
+        QCOMPARE(record.quality, quint8(HYTagValueStore::QualityGood));
+
+        QVERIFY(store.setValue(id, HYTagValue::fromDouble(2.0), 200, 250, HYTagValueStore::QualityGood));
+        QCOMPARE(store.timestamp(id), qint64(200));
+        QCOMPARE(store.serverTimestamp(id), qint64(250));
+
+        // Same value, new quality
+        QVERIFY(store.setValue(id, HYTagValue::fromDouble(2.0), 300, 350, HYTagValueStore::QualityLastUsable));
+        QVERIFY(!store.setValue(id, HYTagValue::fromDouble(2.0), 400, 450, HYTagValueStore::KeepQuality));
+        QCOMPARE(store.readRecord(id, &record), HYTagValueStore::ReadOk);
+        QCOMPARE(record.value, HYTagValue::fromDouble(2.0));
+        QCOMPARE(record.sourceTimestamp, qint64(400));
+        QCOMPARE(record.serverTimestamp, qint64(450));
+        QCOMPARE(record.quality, quint8(HYTagValueStore::QualityLastUsable));
+        QVERIFY(!HYTagValueStore::isGood(record.quality));
+        QVERIFY(!HYTagValueStore::isBad(record.quality));
+
+        QVERIFY(store.setQuality(id, HYTagValueStore::QualityNotConnected));
+        QVERIFY(!store.setQuality(id, HYTagValueStore::QualityNotConnected));
+        QVERIFY(HYTagValueStore::isBad(store.quality(id)));
+
+        QCOMPARE(HYTagValueStore::qualityFromStatusCode(0), quint8(HYTagValueStore::QualityGood));
+        QCOMPARE(HYTagValueStore::qualityFromStatusCode(0x808A0000u), quint8(HYTagValueStore::QualityNotConnected));
+        QCOMPARE(HYTagValueStore::qualityFromStatusCode(0x40000000u), quint8(HYTagValueStore::QualityUncertain));
+        QCOMPARE(HYTagValueStore::qualityFromStatusCode(0x80010000u), quint8(HYTagValueStore::QualityBad));
+    }
+};
+
+QTEST_MAIN(TestTagValueStore)
+#include "test_tagvaluestore.moc"
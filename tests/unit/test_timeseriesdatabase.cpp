@@ -1,8 +1,97 @@
 #include <QTest>
 #include <QSignalSpy>
 #include <QDateTime>
+#include <QTemporaryDir>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QHash>
+#include <QUrl>
+#include <QtEndian>
 #include "timeseriesdatabase.h"
 
+/**
+ * @class InfluxStub
+ * @brief 本地InfluxDB替身，记录收到的请求和连接数；/query返回设定的JSON，其他请求返回204
+ */
+class InfluxStub : public QObject
+{
+public:
+    /**
+     * @struct Request
+     * @brief 收到的请求
+     */
+    struct Request {
+        QByteArray method; ///< 方法
+        QByteArray target; ///< 路径和查询参数
+        QHash<QByteArray, QByteArray> headers; ///< 请求头，键为小写
+        QByteArray body; ///< 请求体
+    };
+
+    explicit InfluxStub(QObject *parent = nullptr) : QObject(parent), m_connections(0) {
+        connect(&m_server, &QTcpServer::newConnection, this, &InfluxStub::accept);
+        m_server.listen(QHostAddress::LocalHost);
+    }
+
+    quint16 port() const { return m_server.serverPort(); }
+    int connections() const { return m_connections; }
+    const QVector<Request> &requests() const { return m_requests; }
+    void setQueryResponse(const QByteArray &body) { m_queryResponse = body; }
+
+private:
+    void accept() {
+        while (QTcpSocket *socket = m_server.nextPendingConnection()) {
+            ++m_connections;
+            connect(socket, &QTcpSocket::readyRead, this, [this, socket] { read(socket); });
+            connect(socket, &QTcpSocket::disconnected, this, [this, socket] {
+                m_buffers.remove(socket);
+                socket->deleteLater();
+            });
+        }
+    }
+
+    void read(QTcpSocket *socket) {
+        QByteArray &buffer = m_buffers[socket];
+        buffer.append(socket->readAll());
+        for (;;) {
+            const qsizetype headerEnd = buffer.indexOf("\r\n\r\n");
+            if (headerEnd < 0) {
+                return;
+            }
+            Request request;
+            const QList<QByteArray> lines = buffer.left(headerEnd).split('\n');
+            const QList<QByteArray> requestLine = lines.first().trimmed().split(' ');
+            request.method = requestLine.value(0);
+            request.target = requestLine.value(1);
+            for (qsizetype i = 1; i < lines.size(); ++i) {
+                const qsizetype colon = lines[i].indexOf(':');
+                if (colon > 0) {
+                    request.headers.insert(lines[i].left(colon).trimmed().toLower(), lines[i].mid(colon + 1).trimmed());
+                }
+            }
+            const qsizetype length = request.headers.value("content-length").toLongLong();
+            if (buffer.size() < headerEnd + 4 + length) {
+                return;
+            }
+            request.body = buffer.mid(headerEnd + 4, length);
+            buffer.remove(0, headerEnd + 4 + length);
+
+            if (request.target.startsWith("/query")) {
+                socket->write("HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: "
+                              + QByteArray::number(m_queryResponse.size()) + "\r\n\r\n" + m_queryResponse);
+            } else {
+                socket->write("HTTP/1.1 204 No Content\r\nContent-Length: 0\r\n\r\n");
+            }
+            m_requests.append(request);
+        }
+    }
+
+    QTcpServer m_server; ///< 监听端口
+    QHash<QTcpSocket *, QByteArray> m_buffers; ///< 每个连接未处理的数据
+    QVector<Request> m_requests; ///< 收到的请求
+    QByteArray m_queryResponse; ///< /query的应答
+    int m_connections; ///< 接受的连接数
+};
+
 /**
  * @brief 时间序列数据库单元测试
  * 
@@ -216,6 +305,386 @@ private slots:
         QVERIFY(tag3Data.size() > 0);
     }
 
+    /**
+     * @brief 测试按各自时间戳批量存储
+     *
+     * 同一批数据写入两次，按标签和时间戳覆盖，不产生重复记录
+     */
+    void testStoreTagSamples() {
+        HYTimeSeriesDatabase::DatabaseConfig config;
+        config.type = HYTimeSeriesDatabase::SQLITE;
+        config.host = "localhost";
+        config.port = 0;
+        config.database = ":memory:";
+        config.username = "";
+        config.password = "";
+        config.tableName = "test_samples";
+
+        db->initialize(config);
+
+        // 准备带各自时间戳的数据
+        QDateTime start = QDateTime::currentDateTime().addSecs(-100);
+        QVector<HYTimeSeriesDatabase::TagSample> samples;
+        for (int i = 0; i < 10; i++) {
+            samples.append({"Sample_Tag", 10.0 * i, start.addSecs(i).toMSecsSinceEpoch()});
+        }
+
+        QVERIFY(db->storeTagSamples(samples));
+        QVERIFY(db->storeTagSamples(samples));
+        QCOMPARE(db->liveWriteCount(), quint64(0));
+
+        QMap<QDateTime, QVariant> history = db->queryTagHistory("Sample_Tag", start.addSecs(-1), start.addSecs(20), 100);
+        QCOMPARE(history.size(), 10);
+        QCOMPARE(history.last().toDouble(), 90.0);
+    }
+
+    /**
+     * @brief 测试分批写入
+     *
+     * 一批值按batchSize拆成多条多行INSERT，整批成功后逐个发出信号；一批中同一标签同一时间戳的值以后面的为准
+     */
+    void testBatchedWrites() {
+        HYTimeSeriesDatabase::DatabaseConfig config;
+        config.type = HYTimeSeriesDatabase::SQLITE;
+        config.port = 0;
+        config.database = ":memory:";
+        config.tableName = "test_batches";
+        config.batchSize = 7;
+
+        db->shutdown();
+        QVERIFY(db->initialize(config));
+
+        QMap<QString, QVariant> tagValues;
+        for (int i = 0; i < 50; i++) {
+            tagValues[QString("Batch_%1").arg(i)] = 0.5 * i;
+        }
+        QSignalSpy spy(db, SIGNAL(dataStored(QString, QVariant)));
+        const quint64 liveWrites = db->liveWriteCount();
+        QDateTime timestamp = QDateTime::fromSecsSinceEpoch(1767225600);
+        QVERIFY(db->storeTagValues(tagValues, timestamp));
+        QCOMPARE(spy.count(), 50);
+        QCOMPARE(db->liveWriteCount(), liveWrites + 50);
+
+        for (int i = 0; i < 50; i++) {
+            QMap<QDateTime, QVariant> history = db->queryTagHistory(QString("Batch_%1").arg(i), timestamp, timestamp, 10);
+            QCOMPARE(history.size(), 1);
+            QCOMPARE(history.first().toDouble(), 0.5 * i);
+        }
+
+        QVector<HYTimeSeriesDatabase::TagSample> samples;
+        for (int i = 0; i < 20; i++) {
+            samples.append({"Batch_Repeat", double(i), timestamp.addSecs(i % 4).toMSecsSinceEpoch()});
+        }
+        QVERIFY(db->storeTagSamples(samples));
+        QMap<QDateTime, QVariant> history = db->queryTagHistory("Batch_Repeat", timestamp, timestamp.addSecs(10), 10);
+        QCOMPARE(history.size(), 4);
+        QCOMPARE(history.first().toDouble(), 16.0);
+        QCOMPARE(history.last().toDouble(), 19.0);
+        db->shutdown();
+    }
+
+    /**
+     * @brief 测试InfluxDB写入
+     *
+     * 所有请求复用连接时建立的长连接，用户名和密码只出现在Authorization头中，
+     * 达到GzipMinBytes的请求体用gzip压缩，批量写入按batchSize行一个请求
+     */
+    void testInfluxDBWrites() {
+        InfluxStub stub;
+        db->shutdown();
+        QVERIFY(db->initialize(influxConfig(stub)));
+        QCOMPARE(stub.connections(), 1);
+
+        const qint64 start = 1767225600000;
+        QVector<QByteArray> expected;
+        for (int i = 0; i < 3; i++) {
+            QVERIFY(db->storeTagValue("Level", double(i), QDateTime::fromMSecsSinceEpoch(start + i * 1000)));
+            expected.append(QString("history,tag=Level value=%1 %2").arg(i).arg((start + i * 1000) * 1000000).toUtf8());
+        }
+        QCOMPARE(stub.connections(), 1);
+
+        QVector<HYTimeSeriesDatabase::TagSample> samples;
+        QVector<QByteArray> chunks(3);
+        for (int i = 0; i < 250; i++) {
+            samples.append({QString("Flow_%1").arg(i % 10), 0.5 * i, start + i * 1000});
+            chunks[i / 100] += QString("history,tag=Flow_%1 value=%2 %3\n")
+                               .arg(i % 10).arg(QVariant(0.5 * i).toString()).arg((start + i * 1000) * 1000000).toUtf8();
+        }
+        QVERIFY(db->storeTagSamples(samples));
+
+        const QVector<InfluxStub::Request> &requests = stub.requests();
+        QCOMPARE(requests.size(), 1 + 3 + 3);
+        QCOMPARE(requests[0].method, QByteArray("GET"));
+        QVERIFY(requests[0].target.startsWith("/ping"));
+        for (const InfluxStub::Request &request : requests) {
+            QCOMPARE(request.headers.value("authorization"), "Basic " + QByteArray("admin:p@ss:word").toBase64());
+            QVERIFY(request.target.contains("db=plant%20data"));
+            QVERIFY(!request.target.contains("u=") && !request.target.contains("p@ss"));
+        }
+
+        // 单个点的请求体小于GzipMinBytes，不压缩
+        for (int i = 0; i < 3; i++) {
+            QCOMPARE(requests[1 + i].method, QByteArray("POST"));
+            QVERIFY(requests[1 + i].target.startsWith("/write"));
+            QVERIFY(!requests[1 + i].headers.contains("content-encoding"));
+            QCOMPARE(requests[1 + i].body, expected[i]);
+        }
+
+        // 批量请求同时发出，到达顺序不定
+        QVector<bool> matched(chunks.size(), false);
+        for (int i = 4; i < requests.size(); i++) {
+            QCOMPARE(requests[i].headers.value("content-encoding"), QByteArray("gzip"));
+            QVERIFY(requests[i].body.size() < chunks[2].size());
+            for (int chunk = 0; chunk < chunks.size(); chunk++) {
+                if (gzipMatches(requests[i].body, chunks[chunk])) {
+                    matched[chunk] = true;
+                }
+            }
+        }
+        QCOMPARE(matched, QVector<bool>(chunks.size(), true));
+        db->shutdown();
+    }
+
+    /**
+     * @brief 测试InfluxDB查询
+     *
+     * 应答按流式读取，时间以毫秒整数返回；不完整的应答不返回部分结果
+     */
+    void testInfluxDBQuery() {
+        InfluxStub stub;
+        stub.setQueryResponse("{\"results\":[{\"statement_id\":0,\"series\":[{\"name\":\"history\","
+                              "\"columns\":[\"time\",\"value\"],\"values\":[[1767225602000,2.5],"
+                              "[1767225601000,\"running\"],[1767225600000,1]]}]}]}");
+        db->shutdown();
+        QVERIFY(db->initialize(influxConfig(stub)));
+
+        const QDateTime start = QDateTime::fromMSecsSinceEpoch(1767225600000);
+        QMap<QDateTime, QVariant> history = db->queryTagHistory("Level", start, start.addSecs(10), 10);
+        QCOMPARE(history.size(), 3);
+        QCOMPARE(history.value(start).toDouble(), 1.0);
+        QCOMPARE(history.value(start.addSecs(1)).toString(), QString("running"));
+        QCOMPARE(history.value(start.addSecs(2)).toDouble(), 2.5);
+
+        const InfluxStub::Request &request = stub.requests().last();
+        QCOMPARE(request.method, QByteArray("GET"));
+        QVERIFY(request.target.startsWith("/query"));
+        QVERIFY(request.target.contains("epoch=ms"));
+        QVERIFY(QUrl::fromPercentEncoding(request.target).contains("tag='Level'"));
+        QCOMPARE(stub.connections(), 1);
+
+        stub.setQueryResponse("{\"results\":[{\"series\":[{\"values\":[[1767225600000,1]");
+        QVERIFY(db->queryTagHistory("Level", start, start.addSecs(10), 10).isEmpty());
+        db->shutdown();
+    }
+
+    /**
+     * @brief 测试内置列式存储
+     *
+     * 毫秒时间戳原样保存，批量写入按时间戳覆盖，关闭后重新打开数据仍在
+     */
+    void testEmbeddedBackend() {
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        db->shutdown();
+
+        HYTimeSeriesDatabase::DatabaseConfig config;
+        config.type = HYTimeSeriesDatabase::EMBEDDED;
+        config.port = 0;
+        config.database = dir.filePath("history.hycs");
+        config.tableName = "test_data";
+        QVERIFY(db->initialize(config));
+        QVERIFY(db->createDatabase());
+        QVERIFY(db->createTable());
+
+        QDateTime start = QDateTime::fromMSecsSinceEpoch(1767225600123);
+        QVector<HYTimeSeriesDatabase::TagSample> samples;
+        for (int i = 0; i < 10; i++) {
+            samples.append({"Embedded_Tag", 10.0 * i, start.addMSecs(i * 250).toMSecsSinceEpoch()});
+            samples.append({"Embedded_State", QString("step %1").arg(i), start.addMSecs(i * 250).toMSecsSinceEpoch()});
+        }
+        QVERIFY(db->storeTagSamples(samples));
+        QVERIFY(db->storeTagSamples(samples));
+        QVERIFY(db->storeTagValue("Embedded_Tag", 1000.0, start.addSecs(10)));
+
+        QMap<QDateTime, QVariant> history = db->queryTagHistory("Embedded_Tag", start, start.addSecs(20), 100);
+        QCOMPARE(history.size(), 11);
+        QCOMPARE(history.firstKey(), start);
+        QCOMPARE(history.value(start.addMSecs(250)).toDouble(), 10.0);
+        QCOMPARE(history.last().toDouble(), 1000.0);
+
+        // 超出限制时返回最新的数据
+        history = db->queryTagHistory("Embedded_Tag", start, start.addSecs(20), 3);
+        QCOMPARE(history.size(), 3);
+        QCOMPARE(history.last().toDouble(), 1000.0);
+
+        db->shutdown();
+        QVERIFY(db->initialize(config));
+        history = db->queryTagHistory("Embedded_State", start, start.addSecs(20), 100);
+        QCOMPARE(history.size(), 10);
+        QCOMPARE(history.last().toString(), QString("step 9"));
+
+        QVERIFY(db->clearData("Embedded_State"));
+        QVERIFY(db->queryTagHistory("Embedded_State", start, start.addSecs(20), 100).isEmpty());
+        QCOMPARE(db->queryTagHistory("Embedded_Tag", start, start.addSecs(20), 100).size(), 11);
+        db->shutdown();
+    }
+
+    /**
+     * @brief 测试趋势汇总区间的选取
+     *
+     * 选取区间数不少于点数的最粗汇总，没有满足的汇总时使用原始样本
+     */
+    void testTrendInterval() {
+        const qint64 week = 7 * 24 * 3600000LL;
+        QCOMPARE(HYTimeSeriesDatabase::trendInterval(week, 100), qint64(3600000));
+        QCOMPARE(HYTimeSeriesDatabase::trendInterval(week, 500), qint64(900000));
+        QCOMPARE(HYTimeSeriesDatabase::trendInterval(week, 1000), qint64(60000));
+        QCOMPARE(HYTimeSeriesDatabase::trendInterval(week, 20000), qint64(0));
+        QCOMPARE(HYTimeSeriesDatabase::trendInterval(3600000, 60), qint64(60000));
+        QCOMPARE(HYTimeSeriesDatabase::trendInterval(3600000, 61), qint64(0));
+    }
+
+    /**
+     * @brief 趋势汇总测试数据
+     */
+    void testTagTrend_data() {
+        QTest::addColumn<int>("type");
+        QTest::newRow("sqlite") << int(HYTimeSeriesDatabase::SQLITE);
+        QTest::newRow("embedded") << int(HYTimeSeriesDatabase::EMBEDDED);
+    }
+
+    /**
+     * @brief 测试趋势汇总
+     *
+     * SQLite和内置列式存储在写入时把新样本合并进1分钟、15分钟和1小时汇总；迟到的样本并入已写入的区间，
+     * 重新打开后继续累计，清除点位时汇总一并清除
+     */
+    void testTagTrend() {
+        QFETCH(int, type);
+
+        QTemporaryDir dir;
+        QVERIFY(dir.isValid());
+        db->shutdown();
+
+        HYTimeSeriesDatabase::DatabaseConfig config;
+        config.type = HYTimeSeriesDatabase::DatabaseType(type);
+        config.port = 0;
+        config.database = dir.filePath(type == HYTimeSeriesDatabase::SQLITE ? "trend.db" : "trend.hycs");
+        config.tableName = "trend_data";
+        QVERIFY(db->initialize(config));
+
+        // 两小时，每10秒一个值，值为序号；每批10分钟，每批写两次，像断线重放那样
+        const qint64 start = 1767225600000;
+        QVector<HYTimeSeriesDatabase::TagSample> samples;
+        for (int i = 0; i < 720; i++) {
+            samples.append({"Trend_Tag", double(i), start + i * 10000LL});
+            if (samples.size() == 60) {
+                QVERIFY(db->storeTagSamples(samples));
+                QVERIFY(db->storeTagSamples(samples));
+                samples.clear();
+            }
+        }
+
+        const QDateTime from = QDateTime::fromMSecsSinceEpoch(start);
+        const QDateTime to = from.addSecs(7200);
+        QVector<HYTimeSeriesDatabase::TrendPoint> trend = db->queryTagTrend("Trend_Tag", from, to, 2);
+        QCOMPARE(trend.size(), 2);
+        QCOMPARE(trend[0].timestamp, start);
+        QCOMPARE(trend[0].count, qint64(360));
+        QCOMPARE(trend[0].min, 0.0);
+        QCOMPARE(trend[0].max, 359.0);
+        QCOMPARE(trend[0].avg, 179.5);
+        QCOMPARE(trend[0].first, 0.0);
+        QCOMPARE(trend[0].last, 359.0);
+        QCOMPARE(trend[1].timestamp, start + 3600000);
+        QCOMPARE(trend[1].avg, 539.5);
+        QCOMPARE(trend[1].last, 719.0);
+
+        trend = db->queryTagTrend("Trend_Tag", from, to, 8);
+        QCOMPARE(trend.size(), 8);
+        QCOMPARE(trend[1].timestamp, start + 900000);
+        QCOMPARE(trend[1].count, qint64(90));
+        QCOMPARE(trend[1].first, 90.0);
+
+        trend = db->queryTagTrend("Trend_Tag", from, to, 120);
+        QCOMPARE(trend.size(), 120);
+        QCOMPARE(trend[1].count, qint64(6));
+        QCOMPARE(trend[1].min, 6.0);
+        QCOMPARE(trend[1].max, 11.0);
+
+        // 没有满足点数的汇总时返回原始样本
+        trend = db->queryTagTrend("Trend_Tag", from, from.addSecs(600), 100);
+        QCOMPARE(trend.size(), 61);
+        QCOMPARE(trend[6].timestamp, start + 60000);
+        QCOMPARE(trend[6].count, qint64(1));
+        QCOMPARE(trend[6].avg, 6.0);
+
+        // 迟到的样本并入已写入的各级区间，首值仍按时间取；再写一次不重复计入
+        QVERIFY(db->storeTagValue("Trend_Tag", -1.0, QDateTime::fromMSecsSinceEpoch(start + 5000)));
+        QVERIFY(db->storeTagSamples({{"Trend_Tag", -1.0, start + 5000}}));
+        trend = db->queryTagTrend("Trend_Tag", from, to, 120);
+        QCOMPARE(trend[0].count, qint64(7));
+        QCOMPARE(trend[0].min, -1.0);
+        QCOMPARE(trend[0].first, 0.0);
+        QCOMPARE(trend[0].last, 5.0);
+        trend = db->queryTagTrend("Trend_Tag", from, to, 2);
+        QCOMPARE(trend[0].count, qint64(361));
+        QCOMPARE(trend[0].min, -1.0);
+        QCOMPARE(trend[0].avg, (179.5 * 360 - 1) / 361);
+
+        // 重新打开后汇总完整，新样本继续并入最后一个区间
+        db->shutdown();
+        QVERIFY(db->initialize(config));
+        trend = db->queryTagTrend("Trend_Tag", from, to, 2);
+        QCOMPARE(trend.size(), 2);
+        QCOMPARE(trend[0].count, qint64(361));
+        QCOMPARE(trend[1].count, qint64(360));
+        QCOMPARE(trend[1].last, 719.0);
+        QVERIFY(db->storeTagValue("Trend_Tag", 1000.0, QDateTime::fromMSecsSinceEpoch(start + 7195000)));
+        QVERIFY(db->storeTagValue("Trend_Tag", 1000.0, QDateTime::fromMSecsSinceEpoch(start + 7195000)));
+        trend = db->queryTagTrend("Trend_Tag", from, to, 2);
+        QCOMPARE(trend[1].count, qint64(361));
+        QCOMPARE(trend[1].min, 360.0);
+        QCOMPARE(trend[1].max, 1000.0);
+        QCOMPARE(trend[1].first, 360.0);
+        QCOMPARE(trend[1].last, 1000.0);
+        trend = db->queryTagTrend("Trend_Tag", from, to, 120);
+        QCOMPARE(trend[119].count, qint64(7));
+
+        QVERIFY(db->clearData("Trend_Tag"));
+        QVERIFY(db->queryTagTrend("Trend_Tag", from, to, 2).isEmpty());
+        db->shutdown();
+    }
+
+    /**
+     * @brief 测试InfluxDB趋势查询
+     *
+     * 由服务端按选取的区间聚合
+     */
+    void testInfluxDBTrend() {
+        InfluxStub stub;
+        stub.setQueryResponse("{\"results\":[{\"statement_id\":0,\"series\":[{\"name\":\"history\","
+                              "\"columns\":[\"time\",\"min\",\"max\",\"mean\",\"count\",\"first\",\"last\"],"
+                              "\"values\":[[1767225600000,0,359,179.5,360,0,359],"
+                              "[1767229200000,360,719,539.5,360,360,719]]}]}]}");
+        db->shutdown();
+        QVERIFY(db->initialize(influxConfig(stub)));
+
+        const QDateTime start = QDateTime::fromMSecsSinceEpoch(1767225600000);
+        const QVector<HYTimeSeriesDatabase::TrendPoint> trend = db->queryTagTrend("Level", start, start.addSecs(7200), 2);
+        QCOMPARE(trend.size(), 2);
+        QCOMPARE(trend[0].timestamp, qint64(1767225600000));
+        QCOMPARE(trend[0].max, 359.0);
+        QCOMPARE(trend[0].avg, 179.5);
+        QCOMPARE(trend[1].count, qint64(360));
+        QCOMPARE(trend[1].first, 360.0);
+
+        const QString statement = QUrl::fromPercentEncoding(stub.requests().last().target);
+        QVERIFY(statement.contains("GROUP BY time(3600s)"));
+        QVERIFY(statement.contains("tag='Level'"));
+        db->shutdown();
+    }
+
     /**
      * @brief 测试批量查询标签历史数据
      * 
@@ -410,6 +879,48 @@ private slots:
     }
 
 private:
+    /**
+     * @brief 指向替身的InfluxDB配置，密码包含冒号，数据库名包含空格
+     */
+    static HYTimeSeriesDatabase::DatabaseConfig influxConfig(const InfluxStub &stub) {
+        HYTimeSeriesDatabase::DatabaseConfig config;
+        config.type = HYTimeSeriesDatabase::INFLUXDB;
+        config.host = "127.0.0.1";
+        config.port = stub.port();
+        config.database = "plant data";
+        config.username = "admin";
+        config.password = "p@ss:word";
+        config.tableName = "history";
+        config.batchSize = 100;
+        return config;
+    }
+
+    /**
+     * @brief 检查gzip数据解压后是否等于expected
+     *
+     * gzip中的deflate数据换上zlib的头和Adler-32后交给qUncompress解压
+     */
+    static bool gzipMatches(const QByteArray &gzip, const QByteArray &expected) {
+        if (gzip.size() < 18 || quint8(gzip[0]) != 0x1f || quint8(gzip[1]) != 0x8b || gzip[2] != 8
+            || qFromLittleEndian<quint32>(gzip.constData() + gzip.size() - 4) != quint32(expected.size())) {
+            return false;
+        }
+        quint32 a = 1;
+        quint32 b = 0;
+        for (char byte : expected) {
+            a = (a + quint8(byte)) % 65521;
+            b = (b + a) % 65521;
+        }
+        QByteArray zlib(4, 0);
+        qToBigEndian<quint32>(quint32(expected.size()), zlib.data());
+        zlib.append("\x78\x9c", 2);
+        zlib.append(gzip.mid(10, gzip.size() - 18));
+        char adler[4];
+        qToBigEndian<quint32>((b << 16) | a, adler);
+        zlib.append(adler, 4);
+        return qUncompress(zlib) == expected;
+    }
+
     HYTimeSeriesDatabase *db; ///< 时间序列数据库实例
 };
 